@@ -35,6 +35,9 @@
 #define USE_LOBSTER             1
 #define USE_SUBSENSE            0
 ////////////////////////////////
+#define USE_PYRAMID_MODE        0 // runs the algorithm on downscaled frames (see BackgroundSubtractorPyramid)
+#define PYRAMID_LEVELS          1
+////////////////////////////////
 #define USE_GLSL_IMPL           0
 #define USE_CUDA_SYNC_IMPL      0
 #define USE_CUDA_ASYNC_IMPL     0
@@ -53,6 +56,8 @@
 #error "Must specify a single impl."
 #elif (USE_LOBSTER+USE_SUBSENSE+USE_PAWCS+USE_GMM)!=1
 #error "Must specify a single algorithm."
+#elif USE_PYRAMID_MODE && (USE_GPU_IMPL || !USE_LITIV_IMPL)
+#error "Pyramid mode is only available for cpu-based litiv algorithms."
 #endif //USE_...
 #ifndef DATASET_ID
 #define DATASET_ID Dataset_Custom
@@ -167,8 +172,6 @@ int main(int, char**) {
 
 #if (HAVE_GLSL && USE_GLSL_IMPL)
 void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
-    srand(0); // for now, assures that two consecutive runs on the same data return the same results
-    //srand((unsigned int)time(NULL));
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         lvAssert(oBatch.getInputPacketType()==lv::ImagePacket && oBatch.getOutputPacketType()==lv::ImagePacket);
@@ -180,6 +183,7 @@ void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
         const size_t nTotPacketCount = oBatch.getFrameCount();
         lv::gl::Context oContext(oBatch.getFrameSize(),oBatch.getName()+" [GPU]",DISPLAY_OUTPUT==0);
         std::shared_ptr<IBackgroundSubtractor_<lv::GLSL>> pAlgo = std::make_shared<BackgroundSubtractorType>();
+        pAlgo->setSeed(0); // assures that two consecutive runs on the same data return the same results
     #if DISPLAY_OUTPUT>1
         lv::DisplayHelperPtr pDisplayHelper = lv::DisplayHelper::create(oBatch.getName(),oBatch.getOutputPath()+"../");
     #if USE_LITIV_IMPL
@@ -235,8 +239,6 @@ void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
 }
 #elif (HAVE_CUDA && USE_CUDA_IMPL)
 void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
-    srand(0); // for now, assures that two consecutive runs on the same data return the same results
-    //srand((unsigned int)time(NULL));
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         lvAssert(oBatch.getInputPacketType()==lv::ImagePacket && oBatch.getOutputPacketType()==lv::ImagePacket);
@@ -257,6 +259,7 @@ void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
     #endif //DISPLAY_OUTPUT>0
     #if USE_LITIV_IMPL
         std::shared_ptr<IBackgroundSubtractor_<lv::CUDA>> pAlgo = std::make_shared<BackgroundSubtractorType>();
+        pAlgo->setSeed(0); // assures that two consecutive runs on the same data return the same results
     #if DISPLAY_OUTPUT>0
         pAlgo->m_pDisplayHelper = pDisplayHelper;
     #endif //DISPLAY_OUTPUT>0
@@ -344,8 +347,6 @@ void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
 }
 #else //!USE_GPU_IMPL
 void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
-    srand(0); // for now, assures that two consecutive runs on the same data return the same results
-    //srand((unsigned int)time(NULL));
     try {
         DatasetType::WorkBatch& oBatch = dynamic_cast<DatasetType::WorkBatch&>(*pBatch);
         lvAssert(oBatch.getInputPacketType()==lv::ImagePacket && oBatch.getOutputPacketType()==lv::ImagePacket);
@@ -366,7 +367,12 @@ void Analyze(std::string sWorkerName, lv::IDataHandlerPtr pBatch) {
         cv::Mat oCurrFGMask(oBatch.getFrameSize(),CV_8UC1,cv::Scalar_<uchar>(0));
         lvAssert(oCurrFGMask.size()==oROI.size());
     #if USE_LITIV_IMPL
+    #if USE_PYRAMID_MODE
+        std::shared_ptr<IBackgroundSubtractor> pAlgo = std::make_shared<BackgroundSubtractorPyramid>(std::make_shared<BackgroundSubtractorType>(),PYRAMID_LEVELS);
+    #else //!USE_PYRAMID_MODE
         std::shared_ptr<IBackgroundSubtractor> pAlgo = std::make_shared<BackgroundSubtractorType>();
+    #endif //!USE_PYRAMID_MODE
+        pAlgo->setSeed(0); // assures that two consecutive runs on the same data return the same results
         const double dDefaultLearningRate = pAlgo->getDefaultLearningRate();
         pAlgo->initialize(oCurrInput,oROI);
     #else //!USE_LITIV_IMPL
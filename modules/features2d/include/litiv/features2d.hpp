@@ -18,6 +18,9 @@
 #pragma once
 
 #include "litiv/utils/opencv.hpp"
+#if USING_OPENMP
+#include <omp.h>
+#endif //USING_OPENMP
 
 // feature descriptor impls headers are included below
 
@@ -199,10 +202,207 @@ namespace lv {
         return dMutualInfoScore;
     }
 
+    /// returns the total number of threads 'lv::processBatch' may use on the calling thread (i.e. its omp team size setting)
+    inline size_t getBatchThreadBudget() {
+#if USING_OPENMP
+        return size_t(std::max(omp_get_max_threads(),1));
+#else //!USING_OPENMP
+        return size_t(1);
+#endif //!USING_OPENMP
+    }
+
+    /// returns the number of items processed concurrently by 'lv::processBatch' for a given item count & max worker count (0 = no limit);
+    /// when items are too few to occupy half of the thread budget, they are processed one at a time, each with the full budget available
+    /// to its own parallel loops (an outer team of e.g. 2 workers would otherwise leave all other cores idle)
+    inline size_t getBatchWorkerCount(size_t nItems, size_t nWorkerCount) {
+        const size_t nThreads = getBatchThreadBudget();
+        if(nItems*2<nThreads)
+            return size_t(1);
+        return std::max(std::min(std::min(nItems,nThreads),nWorkerCount?nWorkerCount:nThreads),size_t(1));
+    }
+
+    /// calls 'lItemProcessor(nWorkerIdx,nItemIdx)' for all items in [0,nItems) using up to 'nWorkerCount' workers (0 = no limit, see
+    /// 'lv::getBatchWorkerCount'); each worker index is only used by one thread, items are handed out dynamically, and the first exception
+    /// thrown is rethrown at the end; the thread budget is split among workers, so workers x inner team size never exceeds it
+    /// note: nested parallelism is enabled while workers have more than one inner thread (the omp max active levels setting is global)
+    template<typename TItemProcessor>
+    inline void processBatch(size_t nItems, size_t nWorkerCount, TItemProcessor&& lItemProcessor) {
+        const size_t nWorkers = getBatchWorkerCount(nItems,nWorkerCount);
+        std::atomic_size_t nNextItemIdx(0);
+        std::exception_ptr pException;
+        std::mutex oExceptionMutex;
+#if USING_OPENMP
+        const int nInnerThreads = int(std::max(getBatchThreadBudget()/nWorkers,size_t(1)));
+#ifndef _MSC_VER // msvc only supports openmp 2.0
+        const int nPrevMaxActiveLevels = omp_get_max_active_levels();
+        if(nWorkers>1 && nInnerThreads>1)
+            omp_set_max_active_levels(std::max(nPrevMaxActiveLevels,omp_get_active_level()+2));
+#endif //ndef(_MSC_VER)
+        #pragma omp parallel for schedule(static,1) num_threads(int(nWorkers)) if(nWorkers>1)
+#endif //USING_OPENMP
+        for(int nWorkerIdx=0; nWorkerIdx<int(nWorkers); ++nWorkerIdx) {
+            try {
+#if USING_OPENMP
+                if(nWorkers>1)
+                    omp_set_num_threads(nInnerThreads); // only affects the regions opened by this worker
+#endif //USING_OPENMP
+                for(size_t nItemIdx=nNextItemIdx++; nItemIdx<nItems; nItemIdx=nNextItemIdx++)
+                    lItemProcessor(size_t(nWorkerIdx),nItemIdx);
+            }
+            catch(...) {
+                nNextItemIdx = nItems; // stops all workers after their current item
+                std::lock_guard<std::mutex> oLock(oExceptionMutex);
+                if(!pException)
+                    pException = std::current_exception();
+            }
+        }
+#if USING_OPENMP && !defined(_MSC_VER)
+        if(omp_get_max_active_levels()!=nPrevMaxActiveLevels)
+            omp_set_max_active_levels(nPrevMaxActiveLevels);
+#endif //USING_OPENMP && !defined(_MSC_VER)
+        if(pException)
+            std::rethrow_exception(pException);
+    }
+
+    /// helper used by feature extractors with per-instance scratch buffers to process image collections concurrently; each extra
+    /// worker is a separate extractor instance (built on demand via a factory, then kept for later calls), so buffers are never shared
+    template<typename TExtractor>
+    struct BatchWorkerPool {
+        /// default constructor (0 workers = no limit, see 'lv::getBatchWorkerCount')
+        explicit BatchWorkerPool(size_t nWorkerCount=0) : m_nWorkerCount(nWorkerCount) {}
+        /// copy constructor; worker instances are not copied (they will be recreated on demand)
+        BatchWorkerPool(const BatchWorkerPool<TExtractor>& oPool) : m_nWorkerCount(oPool.m_nWorkerCount) {}
+        /// sets the max number of items processed concurrently (0 = no limit); extra cached workers are released
+        inline void setWorkerCount(size_t nWorkerCount) {
+            m_nWorkerCount = nWorkerCount;
+            if(nWorkerCount>0 && m_vpWorkers.size()>=nWorkerCount)
+                m_vpWorkers.resize(nWorkerCount-1);
+        }
+        /// returns the max number of items processed concurrently (0 = no limit)
+        inline size_t getWorkerCount() const {return m_nWorkerCount;}
+        /// returns the number of extra worker instances currently kept alive (the owner always acts as the first worker)
+        inline size_t getCachedWorkerCount() const {return m_vpWorkers.size();}
+        /// calls 'lItemProcessor(oWorker,nItemIdx)' for all items in [0,nItems), with the owner acting as the first worker
+        template<typename TWorkerFactory, typename TItemProcessor>
+        void process(size_t nItems, TExtractor& oOwner, TWorkerFactory&& lWorkerFactory, TItemProcessor&& lItemProcessor) {
+            const size_t nWorkers = getBatchWorkerCount(nItems,m_nWorkerCount);
+            while(m_vpWorkers.size()+1<nWorkers)
+                m_vpWorkers.push_back(lWorkerFactory());
+            processBatch(nItems,nWorkers,[&](size_t nWorkerIdx, size_t nItemIdx) {
+                lItemProcessor((nWorkerIdx==0)?oOwner:*m_vpWorkers[nWorkerIdx-1],nItemIdx);
+            });
+        }
+    protected:
+        /// max number of items processed concurrently (0 = no limit)
+        size_t m_nWorkerCount;
+        /// extra worker instances (the owner is always the first worker)
+        std::vector<std::unique_ptr<TExtractor>> m_vpWorkers;
+    };
+
+    /// returns the regions of a dense descriptor map that must be updated after the pixels flagged in a change mask were modified,
+    /// i.e. all (nTileSize x nTileSize) grid tiles with a changed pixel within 'nSupportRadius' of their area; dirty tiles are merged
+    /// into horizontal runs (or into full-width bands, if 'bFullRowBands' is set), and identical runs of successive tile rows are fused
+    inline std::vector<cv::Rect> getDescMapUpdateRegions(const cv::Mat& oChangeMask, int nSupportRadius, int nTileSize, bool bFullRowBands=false) {
+        lvAssert_(!oChangeMask.empty() && oChangeMask.dims==2 && oChangeMask.type()==CV_8UC1,"change mask must be non-empty, 2d, and of type 8UC1");
+        lvAssert_(nSupportRadius>=0 && nTileSize>0,"bad support radius or tile size");
+        cv::Mat oBinaryMask; cv::Mat_<int> oIntegralMask;
+        cv::threshold(oChangeMask,oBinaryMask,0,1,cv::THRESH_BINARY); // 0/1 values, so integral sums cannot overflow
+        cv::integral(oBinaryMask,oIntegralMask,CV_32S);
+        const int nRows = oChangeMask.rows, nCols = oChangeMask.cols;
+        std::vector<cv::Rect> voRegions;
+        for(int nTileRowIdx=0; nTileRowIdx<nRows; nTileRowIdx+=nTileSize) {
+            const int nTileRows = std::min(nTileSize,nRows-nTileRowIdx);
+            const int nSupportRowBegin = std::max(nTileRowIdx-nSupportRadius,0), nSupportRowEnd = std::min(nTileRowIdx+nTileRows+nSupportRadius,nRows);
+            std::vector<cv::Rect> voTileRowRegions;
+            int nRunColIdx = -1;
+            for(int nTileColIdx=0; nTileColIdx<nCols; nTileColIdx+=nTileSize) {
+                const int nTileCols = std::min(nTileSize,nCols-nTileColIdx);
+                const int nSupportColBegin = std::max(nTileColIdx-nSupportRadius,0), nSupportColEnd = std::min(nTileColIdx+nTileCols+nSupportRadius,nCols);
+                const bool bDirty = (oIntegralMask(nSupportRowEnd,nSupportColEnd)-oIntegralMask(nSupportRowBegin,nSupportColEnd)-
+                                     oIntegralMask(nSupportRowEnd,nSupportColBegin)+oIntegralMask(nSupportRowBegin,nSupportColBegin))>0;
+                if(bDirty && nRunColIdx<0)
+                    nRunColIdx = nTileColIdx;
+                else if(!bDirty && nRunColIdx>=0) {
+                    voTileRowRegions.emplace_back(nRunColIdx,nTileRowIdx,nTileColIdx-nRunColIdx,nTileRows);
+                    nRunColIdx = -1;
+                }
+            }
+            if(nRunColIdx>=0)
+                voTileRowRegions.emplace_back(nRunColIdx,nTileRowIdx,nCols-nRunColIdx,nTileRows);
+            if(bFullRowBands && !voTileRowRegions.empty())
+                voTileRowRegions = std::vector<cv::Rect>{cv::Rect(0,nTileRowIdx,nCols,nTileRows)};
+            for(const cv::Rect& oRegion : voTileRowRegions) {
+                auto pPrevRegion = std::find_if(voRegions.rbegin(),voRegions.rend(),[&](const cv::Rect& oPrevRegion) {
+                    return oPrevRegion.x==oRegion.x && oPrevRegion.width==oRegion.width && oPrevRegion.br().y==oRegion.y;
+                });
+                if(pPrevRegion!=voRegions.rend())
+                    pPrevRegion->height += oRegion.height;
+                else
+                    voRegions.push_back(oRegion);
+            }
+        }
+        return voRegions;
+    }
+
+    /// temporal (streaming) dense descriptor map update helper: only the descriptors whose support (of radius 'nSupportRadius') overlaps
+    /// changed pixels in 'oChangeMask' are recomputed, by calling 'lDenseImpl(oROI,oROIDescMap)' on image crops (that include the support
+    /// margin) and copying back the valid part of their maps; the full map is recomputed via 'lDenseImpl(full image ROI,oDescMap)' instead
+    /// if the cached map size does not match the image, if the mask is empty, or if the changed regions cover most of the image; crops are
+    /// described concurrently by up to 'nWorkerCount' workers (see 'lv::processBatch'), so 'lDenseImpl' must be thread-safe unless it is 1
+    template<typename TDescMap, typename TDenseImpl>
+    inline void computeTemporalDescMap(const cv::Mat& oImage, const cv::Mat& oChangeMask, int nSupportRadius, TDescMap& oDescMap, TDenseImpl&& lDenseImpl, bool bFullRowBands=false, size_t nWorkerCount=0) {
+        lvAssert_(!oImage.empty() && oImage.dims==2,"input image must be non-empty and 2d");
+        lvAssert_(oChangeMask.empty() || (oChangeMask.type()==CV_8UC1 && oChangeMask.size()==oImage.size()),"change mask must be empty, or 8UC1 and of the same size as the input image");
+        lvAssert_(nSupportRadius>=0,"bad descriptor support radius");
+        const cv::Rect oImageROI(cv::Point(0,0),oImage.size());
+        if(oChangeMask.empty() || oDescMap.empty() || (oDescMap.dims!=2 && oDescMap.dims!=3) || oDescMap.size[0]!=oImage.rows || oDescMap.size[1]!=oImage.cols) {
+            lDenseImpl(oImageROI,oDescMap);
+            return;
+        }
+        const int nTileSize = std::max(32,nSupportRadius*2);
+        const std::vector<cv::Rect> voRegions = getDescMapUpdateRegions(oChangeMask,nSupportRadius,nTileSize,bFullRowBands);
+        if(voRegions.empty())
+            return;
+        const int nMinCropWidth = std::min(nSupportRadius*2+1,oImage.cols), nMinCropHeight = std::min(nSupportRadius*2+1,oImage.rows);
+        std::vector<cv::Rect> voCropROIs(voRegions.size());
+        size_t nTotCropArea = 0;
+        for(size_t nRegionIdx=0; nRegionIdx<voRegions.size(); ++nRegionIdx) {
+            const cv::Rect& oRegion = voRegions[nRegionIdx];
+            cv::Rect& oCropROI = voCropROIs[nRegionIdx];
+            oCropROI = cv::Rect(oRegion.x-nSupportRadius,oRegion.y-nSupportRadius,oRegion.width+nSupportRadius*2,oRegion.height+nSupportRadius*2)&oImageROI;
+            if(oCropROI.width<nMinCropWidth)
+                oCropROI.x = std::max(std::min(oCropROI.x,oImage.cols-nMinCropWidth),0), oCropROI.width = nMinCropWidth;
+            if(oCropROI.height<nMinCropHeight)
+                oCropROI.y = std::max(std::min(oCropROI.y,oImage.rows-nMinCropHeight),0), oCropROI.height = nMinCropHeight;
+            lvDbgAssert((oCropROI&oImageROI)==oCropROI && (oCropROI&oRegion)==oRegion);
+            nTotCropArea += size_t(oCropROI.area());
+        }
+        if(nTotCropArea*4>=oImage.total()*3) { // crop overhead would cancel out the gains
+            lDenseImpl(oImageROI,oDescMap);
+            return;
+        }
+        const size_t nPixelBytes = (oDescMap.dims==2)?oDescMap.elemSize():oDescMap.step[1];
+        processBatch(voRegions.size(),nWorkerCount,[&](size_t /*nWorkerIdx*/, size_t nRegionIdx) {
+            const cv::Rect& oRegion = voRegions[nRegionIdx];
+            const cv::Rect& oCropROI = voCropROIs[nRegionIdx];
+            TDescMap oCropDescMap;
+            lDenseImpl(oCropROI,oCropDescMap);
+            lvAssert_(oCropDescMap.dims==oDescMap.dims && oCropDescMap.type()==oDescMap.type() && oCropDescMap.size[0]==oCropROI.height && oCropDescMap.size[1]==oCropROI.width,"bad cropped descriptor map");
+            lvAssert_((oDescMap.dims==2 || oCropDescMap.step[1]==nPixelBytes),"cropped descriptor map pixel size mismatch");
+            const size_t nRowBytes = nPixelBytes*size_t(oRegion.width);
+            for(int nRowIdx=oRegion.y; nRowIdx<oRegion.br().y; ++nRowIdx)
+                std::copy_n(oCropDescMap.data+oCropDescMap.step[0]*size_t(nRowIdx-oCropROI.y)+nPixelBytes*size_t(oRegion.x-oCropROI.x),nRowBytes,
+                            oDescMap.data+oDescMap.step[0]*size_t(nRowIdx)+nPixelBytes*size_t(oRegion.x));
+        });
+    }
+
 } // namespace lv
 
 #include "litiv/features2d/DASC.hpp"
+#include "litiv/features2d/DescMatcher.hpp"
+#include "litiv/features2d/EMD.hpp"
 #include "litiv/features2d/LBSP.hpp"
 #include "litiv/features2d/LSS.hpp"
 #include "litiv/features2d/MI.hpp"
+#include "litiv/features2d/QuantizedDescMap.hpp"
 #include "litiv/features2d/SC.hpp"
\ No newline at end of file
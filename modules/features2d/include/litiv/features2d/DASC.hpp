@@ -17,7 +17,9 @@
 
 #pragma once
 
-#include "litiv/utils/opencv.hpp"
+#include "litiv/features2d.hpp"
+#include "litiv/features2d/DescMatcher.hpp"
+#include "litiv/features2d/QuantizedDescMap.hpp"
 #include "litiv/utils/math.hpp"
 #include <opencv2/features2d.hpp>
 
@@ -34,6 +36,11 @@
 
     For more details on the different parameters, see S. Kim et al., "DASC: Robust Dense
     Descriptor for Multi-modal and Multi-spectral Correspondence Estimation", in TPAMI2016.
+
+    Note: the pattern LUT entries are filtered independently (and in parallel, when OpenMP is
+    available), and the recursive filter sweeps whole rows for its vertical pass instead of
+    transposing images. Per-element arithmetic is unchanged, so descriptors match the original
+    sequential implementation to within 1e-4 (absolute difference on normalized bins).
 */
 class DASC : public cv::DescriptorExtractor {
 public:
@@ -77,10 +84,21 @@ public:
     void compute2(const cv::Mat& oImage, cv::Mat_<float>& oDescMap);
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix
     void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat_<float>& oDescMap);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// similar to compute2(const cv::Mat& image, cv::Mat_<float>&), but the dense descriptor map is stored in compact 8-bit form (see lv::QuantizedDescMap)
+    void compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap);
+    /// batch version of DASC::compute2(const cv::Mat& image, ...); images are described concurrently (see DASC::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of DASC::compute2(const cv::Mat& image, ...); images are described concurrently (see DASC::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
+    /// temporal version of DASC::compute2(const cv::Mat& image, cv::Mat_<float>&) for video streams; with non-subsampled guided filters, only the row bands
+    /// whose support overlaps changed pixels are recomputed (see lv::computeTemporalDescMap; results match a full compute up to float rounding); recursive
+    /// filters span whole rows/cols and subsampled guided filters depend on the full image grid, so the given (previous frame) map is then only reused as-is
+    /// if no pixel is flagged in the change mask, and fully recomputed otherwise (or if the mask is empty, or the map size mismatches)
+    void compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat_<float>& oDescMap);
+    /// sets the max number of images described concurrently by batch 'compute2' calls (0 = all available threads; each extra worker owns a full set of scratch buffers)
+    inline void setBatchWorkerCount(size_t nWorkerCount) {m_oBatchWorkers.setWorkerCount(nWorkerCount);}
+    /// returns the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline size_t getBatchWorkerCount() const {return m_oBatchWorkers.getWorkerCount();}
 
     /// utility function, used to reshape a descriptors matrix to its input image size (assumes fully-dense keypoints over input)
     static void reshapeDesc(cv::Size oSize, cv::Mat& oDescriptors);
@@ -104,6 +122,10 @@ public:
     }
     /// utility function, used to calculate per-desc L2 distance between two descriptor sets/maps
     void calcDistances(const cv::Mat_<float>& oDescriptors1, const cv::Mat_<float>& oDescriptors2, cv::Mat_<float>& oDistances);
+    /// utility function, used to calculate per-desc L2 distance between two quantized descriptor sets/maps (without dequantizing them)
+    void calcDistances(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const;
+    /// utility function, used to find the k nearest (L2) train descriptors of each query descriptor in two descriptor sets/maps (see DescMatcher)
+    void knnMatch(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const;
 
 protected:
     /// hides default keypoint detection impl (this class is a descriptor extractor only)
@@ -130,24 +152,33 @@ protected:
     const size_t m_nLUTSize;
 
 private:
+    /// per-worker scratch data used to filter lookup images (allows LUT entries to be processed in parallel)
+    struct LookupTempData {
+        cv::Mat_<float> oLookupImage,oLookupImage_Sqr,oLookupImage_Mix;
+        cv::Mat_<float> oLookupImage_AdaptiveMean,oLookupImage_AdaptiveMeanSqr,oLookupImage_AdaptiveMeanMix;
+        cv::Mat_<float> oRef_SubSampl,oRef_SubSamplCross,oRef_SubSamplBlur,oRef_SubSamplCrossBlur;
+        cv::Mat_<float> oNormVarDiff,oNormVarDiff_SubSampl,oNormVarDiff_SubSamplBlur;
+        cv::Mat_<float> oNormVar,oNormVar_SubSampl,oNormVar_SubSamplBlur;
+    };
     /// helper/util function for recursive filtering
-    void recursFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef_V_dHdx, const cv::Mat_<float>& oRef_V_dVdy_t, cv::Mat_<float>& oOutput);
+    void recursFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef_V_dHdx, const cv::Mat_<float>& oRef_V_dVdy, cv::Mat_<float>& oOutput) const;
     /// dense recursive filtering description approach impl
     void dasc_rf_impl(const cv::Mat& oImage, cv::Mat_<float>& oDescriptors);
     /// helper/util function for dense guided filtering
-    void guidedFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef, cv::Mat_<float>& oOutput);
+    void guidedFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef, LookupTempData& oTempData, cv::Mat_<float>& oOutput) const;
     /// dense guided filtering description approach impl
     void dasc_gf_impl(const cv::Mat& oImage, cv::Mat_<float>& oDescriptors);
+    /// computes all descriptor bins via (parallel) LUT entry lookup & filtering, using the current approach's precomputed data
+    void dasc_lut_impl(const cv::Mat_<float>& oImage, cv::Mat_<float>& oDescriptors) const;
+    /// creates a new extractor instance with the same parameters, used as a batch worker
+    std::unique_ptr<DASC> dasc_create_worker() const;
 
     // helper variables for internal impl (helps avoid continuous mem realloc)
-    cv::Mat_<float> m_oTempTransp,m_oImageLocalDiff_Y,m_oImageLocalDiff_X;
-    cv::Mat_<float> m_oRef_dVdy,m_oRef_dHdx,m_oRef_V_dHdx,m_oRef_V_dVdy_t;
+    cv::Mat_<float> m_oImageLocalDiff_Y,m_oImageLocalDiff_X;
+    cv::Mat_<float> m_oRef_dVdy,m_oRef_dHdx,m_oRef_V_dHdx,m_oRef_V_dVdy;
     cv::Mat_<float> m_oImage_AdaptiveMean,m_oImage_AdaptiveMeanSqr;
-    cv::Mat_<float> m_oLookupImage,m_oLookupImage_Sqr,m_oLookupImage_Mix;
-    cv::Mat_<float> m_oLookupImage_AdaptiveMean,m_oLookupImage_AdaptiveMeanSqr,m_oLookupImage_AdaptiveMeanMix;
     cv::Mat_<float> m_oImage_SubSampl,m_oImage_SubSamplBlur,m_oImage_SubSamplVar,m_oImage_SubSamplBlurSqr;
-    cv::Mat_<float> m_oRef_SubSampl,m_oRef_SubSamplCross,m_oRef_SubSamplBlur,m_oRef_SubSamplCrossBlur;
-    cv::Mat_<float> m_oNormVarDiff,m_oNormVarDiff_SubSampl,m_oNormVarDiff_SubSamplBlur;
-    cv::Mat_<float> m_oNormVar,m_oNormVar_SubSampl,m_oNormVar_SubSamplBlur;
     cv::Size m_oImageSize,m_oSubSamplSize,m_oBlurKernelSize;
+    /// extra extractor instances used to describe image collections concurrently (each with its own helper variables)
+    lv::BatchWorkerPool<DASC> m_oBatchWorkers;
 };
\ No newline at end of file
@@ -0,0 +1,63 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/features2d.hpp"
+#include "litiv/utils/platform.hpp"
+
+/**
+    Many-to-many descriptor distance engine & brute-force k-nearest-neighbour matcher.
+
+    Descriptor sets are given as (NxD) matrices (one descriptor per row) or as (RxCxD) dense maps (flattened to R*C
+    descriptors in row-major order). L1 and L2 distances expect CV_32F descriptors; Hamming distances work on the
+    raw bytes of each row, whatever their type (e.g. LBSP maps can be passed with one element per row, see
+    LBSP::knnMatch). Query descriptors are processed in small tiles against cache-sized blocks of train descriptors,
+    so that each train descriptor load is reused across the whole tile; tiles are spread over all threads, and the
+    best k matches of each query are kept via insertion in a small sorted list (ties favor lower train indices).
+*/
+class DescMatcher {
+public:
+    /// list of distance types supported by the matcher
+    enum DistType {
+        Dist_L1,
+        Dist_L2,
+        Dist_Hamming,
+    };
+    /// default constructor
+    explicit DescMatcher(DistType eDist);
+    /// computes distances between corresponding descriptors of two sets/maps of identical size (Nx1 or RxC output, L1/L2 sums accumulated in double)
+    void calcDistances(const cv::Mat& oDescriptors1, const cv::Mat& oDescriptors2, cv::Mat_<float>& oDistances) const;
+    /// computes the (NxM) distance matrix between all query and train descriptors
+    void calcDistanceMatrix(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, cv::Mat_<float>& oDistances) const;
+    /// finds the k nearest train descriptors of each query descriptor (NxK outputs sorted by distance; missing matches have idx=-1 & dist=+inf)
+    void knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, cv::Mat_<int>& oIndices, cv::Mat_<float>& oDistances) const;
+    /// finds the k nearest train descriptors of each query descriptor (opencv-style output, sorted by distance)
+    void knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const;
+    /// returns the distance type used by this matcher
+    inline DistType getDistType() const {return m_eDist;}
+    /// sets the instruction set used for distance kernels (capped to what the host supports; SIMD_None = scalar impl)
+    void setInstrSet(lv::SIMDInstrSet eInstrSet);
+    /// returns the instruction set actually used for distance kernels (SIMD_None or SIMD_AVX2)
+    inline lv::SIMDInstrSet getInstrSet() const {return m_eInstrSet;}
+
+protected:
+    /// distance type used by this matcher
+    const DistType m_eDist;
+    /// instruction set used for distance kernels
+    lv::SIMDInstrSet m_eInstrSet;
+};
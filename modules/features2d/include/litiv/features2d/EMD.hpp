@@ -0,0 +1,88 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/features2d.hpp"
+#include "litiv/utils/platform.hpp"
+
+/// defines the default entropic regularization strength for SinkhornEMD, as a fraction of the largest ground cost
+#define SINKHORNEMD_DEFAULT_REG_RATIO (0.01)
+/// defines the default L1 marginal violation (relative to the largest histogram mass) at which SinkhornEMD stops iterating
+#define SINKHORNEMD_DEFAULT_TOLERANCE (1e-3)
+/// defines the default maximum number of Sinkhorn iterations for SinkhornEMD
+#define SINKHORNEMD_DEFAULT_MAX_ITERS (1000)
+
+/**
+    Approximate Earth Mover's Distance (EMD) solver based on entropy-regularized optimal transport (Sinkhorn).
+
+    Results follow the semantics of cv::EMD with a user-provided cost map (i.e. the total transport cost divided by
+    the largest histogram mass, with partial matching when masses differ); mass differences are handled via a dummy
+    bin with zero transport cost. The Gibbs kernel exp(-C/eps) is precomputed once for the ground cost map,
+    so each Sinkhorn iteration only costs two small matrix-vector products. Pairs are solved in blocks with the pair
+    index innermost (so products vectorize across pairs), and the final plan is rounded onto the exact marginals
+    (Altschuler et al., 2017), so every returned distance is the cost of a feasible plan, i.e. an upper bound:
+
+        EMD <= approx <= EMD + eps*log(N+1) + 3*delta*max(C)
+
+    where eps is the regularization strength, N the bin count, and delta the L1 row marginal violation reached at
+    exit (<= tolerance if converged, with masses normalized by the largest one). The bound of each pair can be
+    returned along with its distance. For shape context cost maps, the default parameters typically give errors
+    around 6% of the exact distance, several times faster than cv::EMD (more with AVX2 and multiple threads).
+*/
+class SinkhornEMD {
+public:
+    /// default constructor; the ground cost map must be square, non-negative, and not null
+    SinkhornEMD(const cv::Mat_<float>& oCostMap, double dRegRatio=SINKHORNEMD_DEFAULT_REG_RATIO,
+                double dTolerance=SINKHORNEMD_DEFAULT_TOLERANCE, int nMaxIters=SINKHORNEMD_DEFAULT_MAX_ITERS);
+    /// returns the approximate EMD between two non-negative histograms of the cost map size (with optional per-pair error bound)
+    double compute(const float* aHist1, const float* aHist2, double* pdErrorBound=nullptr) const;
+    /// returns the approximate EMD between two non-negative histograms of the cost map size (with optional per-pair error bound)
+    double compute(const cv::Mat_<float>& oHist1, const cv::Mat_<float>& oHist2, double* pdErrorBound=nullptr) const;
+    /// computes the approximate EMDs between all given histogram pairs (batched version, with optional per-pair error bounds)
+    void compute(const float* const* apHists1, const float* const* apHists2, size_t nPairs, double* adDists, double* adErrorBounds=nullptr) const;
+    /// computes the approximate EMDs between all row-wise histogram pairs of the given (NxD) matrices (batched version)
+    void compute(const cv::Mat_<float>& oHists1, const cv::Mat_<float>& oHists2, std::vector<double>& vdDists) const;
+    /// returns the worst-case error of pairs that converged before reaching the max iteration count
+    double getMaxError() const;
+    /// returns the number of histogram bins expected by this solver
+    inline int getBinCount() const {return m_nBins;}
+    /// returns the entropic regularization strength (in ground cost units)
+    inline double getRegularization() const {return m_dReg;}
+    /// sets the instruction set used for kernel products (capped to what the host supports; SIMD_None = scalar impl)
+    void setInstrSet(lv::SIMDInstrSet eInstrSet);
+    /// returns the instruction set actually used for kernel products (SIMD_None or SIMD_AVX2)
+    inline lv::SIMDInstrSet getInstrSet() const {return m_eInstrSet;}
+
+protected:
+    /// number of histogram bins (without the dummy bin)
+    const int m_nBins;
+    /// number of bins used in transport problems (with the dummy bin)
+    const int m_nPaddedBins;
+    /// L1 row marginal violation at which iterations stop
+    const double m_dTolerance;
+    /// maximum number of Sinkhorn iterations per pair
+    const int m_nMaxIters;
+    /// largest ground cost, and entropic regularization strength
+    double m_dMaxCost, m_dReg;
+    /// padded ground cost map, Gibbs kernel, its transpose, and their element-wise product (all (N+1)x(N+1), row-major)
+    std::vector<double> m_vdCosts, m_vdKernel, m_vdKernelT, m_vdCostKernel;
+    /// instruction set used for kernel products
+    lv::SIMDInstrSet m_eInstrSet;
+    /// solves a block of up to 's_nBlockPairs' pairs (internal impl, see source file)
+    void computeBlock(const float* const* apHists1, const float* const* apHists2, size_t nPairs, double* adDists, double* adErrorBounds) const;
+};
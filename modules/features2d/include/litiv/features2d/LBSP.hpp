@@ -17,8 +17,10 @@
 
 #pragma once
 
-#include "litiv/utils/opencv.hpp"
+#include "litiv/features2d.hpp"
+#include "litiv/features2d/DescMatcher.hpp"
 #include "litiv/utils/math.hpp"
+#include "litiv/utils/platform.hpp"
 #if HAVE_GLSL
 #include "litiv/utils/opengl-imgproc.hpp"
 #endif //HAVE_GLSL
@@ -29,6 +31,8 @@
 
     Note 1: both grayscale and RGB/BGR images may be used with this extractor.
     Note 2: using LBSP::compute2(...) is logically equivalent to using LBSP::compute(...) followed by LBSP::reshapeDesc(...).
+    Note 3: dense LBSP::compute2(...) calls describe whole rows at once using the best SIMD instruction set available at
+    runtime (see LBSP::setInstrSet), and process row bands in parallel; their output does not depend on these choices.
 
     For more details on the different parameters, see G.-A. Bilodeau et al, "Change Detection in Feature Space Using Local
     Binary Similarity Patterns", in CRV 2013.
@@ -66,15 +70,27 @@ public:
     float getRelThreshold() const;
     /// returns the current absolute threshold used for comparisons (-1 = invalid/not used)
     size_t getAbsThreshold() const;
+    /// sets the instruction set used by dense 'compute2' calls (capped to what the host supports; SIMD_None = scalar impl)
+    void setInstrSet(lv::SIMDInstrSet eInstrSet);
+    /// returns the instruction set actually used by dense 'compute2' calls (SIMD_None, SIMD_SSE2 or SIMD_AVX2)
+    inline lv::SIMDInstrSet getInstrSet() const {return m_eInstrSet;}
 
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix, and all image points are described (note: descriptors close to borders will be invalid)
     void compute2(const cv::Mat& oImage, cv::Mat& oDescMap) const;
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix
     void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescMap) const;
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of LBSP::compute2(const cv::Mat& image, ...); images are described concurrently (see LBSP::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat>& voDescMapCollection) const;
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of LBSP::compute2(const cv::Mat& image, ...); images are described concurrently (see LBSP::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat>& voDescMapCollection) const;
+    /// temporal version of LBSP::compute2(const cv::Mat& image, ...) for video streams: the given (previous frame) map is only updated around pixels flagged in the
+    /// change mask (e.g. a thresholded lv::computeTemporalAbsDiff output), and fully recomputed if the mask is empty or the map size mismatches (note: if a reference
+    /// image is set, its changes must also be flagged in the mask); valid descriptors are identical to the ones of a full compute2(...) call on the same image
+    void compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat& oDescMap) const;
+    /// sets the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline void setBatchWorkerCount(size_t nWorkerCount) {m_nBatchWorkerCount = nWorkerCount;}
+    /// returns the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline size_t getBatchWorkerCount() const {return m_nBatchWorkerCount;}
 
     /// utility function, used to reshape a descriptors matrix to its input image size via their keypoint locations
     static void reshapeDesc(cv::Size oSize, const std::vector<cv::KeyPoint>& voKeypoints, const cv::Mat& oDescriptors, cv::Mat& oOutput);
@@ -86,6 +102,8 @@ public:
     static void validateROI(cv::Mat& oROI);
     /// utility function, used to calculate per-desc Hamming distance between two descriptor sets/maps
     static void calcDistances(const cv::Mat& oDescriptors1, const cv::Mat& oDescriptors2, cv::Mat_<uchar>& oDistances);
+    /// utility function, used to find the k nearest (Hamming) train descriptors of each query descriptor in two descriptor sets/maps (flattened row-major)
+    static void knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches);
 #if HAVE_GLSL
     /// utility function, returns the glsl source code required to describe an LBSP descriptor based on the image load store
     static std::string getShaderFunctionSource(size_t nChannels, bool bUseSharedDataPreload, const glm::uvec2& vWorkGroupSize);
@@ -268,6 +286,10 @@ protected:
     const size_t m_nThreshold;
     /// internal reference image for inter-LBSP computation
     cv::Mat m_oRefImage;
+    /// instruction set used by dense 'compute2' calls
+    lv::SIMDInstrSet m_eInstrSet;
+    /// max number of images described concurrently by batch 'compute2' calls (scratch buffers are thread-local, so workers share this instance)
+    size_t m_nBatchWorkerCount;
 
     // arrays below do not rely on std::array to avoid multi-dim init problems w/ static constexpr in header files
 
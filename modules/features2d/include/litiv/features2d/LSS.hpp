@@ -17,7 +17,9 @@
 
 #pragma once
 
-#include "litiv/utils/opencv.hpp"
+#include "litiv/features2d.hpp"
+#include "litiv/features2d/DescMatcher.hpp"
+#include "litiv/features2d/QuantizedDescMap.hpp"
 #include "litiv/utils/math.hpp"
 #include <opencv2/features2d.hpp>
 
@@ -84,10 +86,20 @@ public:
     void compute2(const cv::Mat& oImage, cv::Mat_<float>& oDescMap);
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix
     void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat_<float>& oDescMap);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// similar to compute2(const cv::Mat& image, cv::Mat_<float>&), but the dense descriptor map is stored in compact 8-bit form (see lv::QuantizedDescMap)
+    void compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap);
+    /// batch version of LSS::compute2(const cv::Mat& image, ...); images are described concurrently (see LSS::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of LSS::compute2(const cv::Mat& image, ...); images are described concurrently (see LSS::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
+    /// temporal version of LSS::compute2(const cv::Mat& image, cv::Mat_<float>&) for video streams: the given (previous frame) map is only updated around pixels flagged
+    /// in the change mask (e.g. a thresholded lv::computeTemporalAbsDiff output), and fully recomputed if the mask is empty or the map size mismatches; the output is
+    /// identical to the one of a full compute2(...) call on the same image
+    void compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat_<float>& oDescMap);
+    /// sets the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline void setBatchWorkerCount(size_t nWorkerCount) {m_nBatchWorkerCount = nWorkerCount;}
+    /// returns the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline size_t getBatchWorkerCount() const {return m_nBatchWorkerCount;}
 
     /// utility function, used to reshape a descriptors matrix to its input image size (assumes fully-dense keypoints over input)
     void reshapeDesc(cv::Size oSize, cv::Mat& oDescriptors) const;
@@ -111,6 +123,10 @@ public:
     }
     /// utility function, used to calculate per-desc L2 distance between two descriptor sets/maps
     void calcDistances(const cv::Mat_<float>& oDescriptors1, const cv::Mat_<float>& oDescriptors2, cv::Mat_<float>& oDistances) const;
+    /// utility function, used to calculate per-desc L2 distance between two quantized descriptor sets/maps (without dequantizing them)
+    void calcDistances(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const;
+    /// utility function, used to find the k nearest (L2) train descriptors of each query descriptor in two descriptor sets/maps (see DescMatcher)
+    void knnMatch(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const;
 
 protected:
     /// hides default keypoint detection impl (this class is a descriptor extractor only)
@@ -151,4 +167,6 @@ private:
     cv::Mat_<int> m_oDescLUMap;
     /// indices of first/last non-null map lookups
     int m_nFirstMaskIdx,m_nLastMaskIdx;
+    /// max number of images described concurrently by batch 'compute2' calls (scratch buffers are thread-local, so workers share this instance)
+    size_t m_nBatchWorkerCount;
 };
\ No newline at end of file
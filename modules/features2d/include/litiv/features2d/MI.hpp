@@ -19,7 +19,14 @@
 
 #include "litiv/features2d.hpp"
 
-/// Mutual Information (MI) calculation helper (interface is similar to feature extractors, works only for 8U images)
+/**
+    Mutual Information (MI) calculation helper (interface is similar to feature extractors, works only for 8U images)
+
+    Note: the dense 'compute2' version slides its window along each row, updating joint/marginal count histograms
+    by adding the entering column and removing the leaving one; the entropy terms are updated along with them via a
+    precomputed n*log2(n) table, so each step costs O(window height) instead of O(window area). It only supports
+    8UC1 image pairs, and its scores match the keypoint-based version up to floating point precision.
+*/
 class MutualInfo : public cv::Algorithm {
 public:
     /// default constructor
@@ -38,6 +45,8 @@ public:
     void compute(const cv::Mat& oImage1, const cv::Mat& oImage2, const std::vector<cv::KeyPoint>& voKeypoints, std::vector<double>& vdScores);
     /// returns the mutual information scores for the given keypoints located in the image pair using subwindows of the size passed in constructor (inline version)
     std::vector<double> compute(const cv::Mat& oImage1, const cv::Mat& oImage2, const std::vector<cv::KeyPoint>& voKeypoints);
+    /// returns the mutual information scores for all windows in the 8UC1 image pair (dense version, using sliding histograms; image borders are zeroed)
+    void compute2(const cv::Mat& oImage1, const cv::Mat& oImage2, cv::Mat_<double>& oScoreMap);
     /// utility function, used to filter out bad keypoints that would trigger out of bounds error because they're too close to the image border
     void validateKeyPoints(std::vector<cv::KeyPoint>& voKeypoints, cv::Size oImgSize) const;
     /// utility function, used to filter out bad pixels in a ROI that would trigger out of bounds error because they're too close to the image border
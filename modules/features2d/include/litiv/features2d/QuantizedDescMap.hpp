@@ -0,0 +1,75 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/features2d.hpp"
+
+namespace lv {
+
+    /**
+        Compact storage for dense (non-negative) float descriptor maps, such as the ones of DASC, LSS and ShapeContext.
+
+        Each descriptor is kept as 8-bit bins along with one float scale (bin ~= scale*q, where scale = max bin/255), so
+        a D-bin descriptor takes D+4 bytes instead of 4*D (i.e. 3.3x to 3.8x less memory for 36 to 128 bins). The absolute
+        error on each bin is at most scale/2, i.e. 0.2% of the descriptor's largest bin. L2 distances are computed on the
+        compact form directly using integer dot products, with a single float rescaling per descriptor pair.
+    */
+    struct QuantizedDescMap {
+        /// quantized descriptor bins, with the same dims as the original map (i.e. NxD or RxCxD)
+        cv::Mat_<uchar> oBins;
+        /// per-descriptor dequantization scales, with the original map dims minus the last one (i.e. Nx1 or RxC)
+        cv::Mat_<float> oScales;
+
+        /// default constructor (empty map)
+        QuantizedDescMap() = default;
+        /// quantizes the given descriptor map (see 'quantize')
+        explicit QuantizedDescMap(const cv::Mat_<float>& oDescMap) {quantize(oDescMap);}
+        /// quantizes a (NxD) or (RxCxD) float descriptor map with non-negative bins (preallocated storage is reused)
+        void quantize(const cv::Mat_<float>& oDescMap);
+        /// converts the quantized map back to a float descriptor map of the original size
+        void dequantize(cv::Mat_<float>& oDescMap) const;
+        /// returns whether the map is empty or not
+        inline bool empty() const {return oBins.empty();}
+        /// returns the number of bins in each descriptor
+        inline int descSize() const {return oBins.size[oBins.dims-1];}
+        /// returns the total number of descriptors stored in the map
+        inline int descCount() const {return int(oScales.total());}
+        /// returns the number of bytes used to store the map
+        inline size_t byteCount() const {return oBins.total()*sizeof(uchar)+oScales.total()*sizeof(float);}
+        /// returns the quantized bins of a descriptor, given its (flattened) index
+        inline const uchar* bins(int nDescIdx) const {lvDbgAssert(nDescIdx>=0 && nDescIdx<descCount()); return oBins.data+size_t(nDescIdx)*size_t(descSize());}
+        /// returns the quantized bins of a descriptor, given its map position (for RxCxD maps)
+        inline const uchar* bins(int nRowIdx, int nColIdx) const {return bins(nRowIdx*oScales.cols+nColIdx);}
+        /// returns the dequantization scale of a descriptor, given its (flattened) index
+        inline float scale(int nDescIdx) const {lvDbgAssert(nDescIdx>=0 && nDescIdx<descCount()); return ((const float*)oScales.data)[nDescIdx];}
+        /// returns the dequantization scale of a descriptor, given its map position (for RxCxD maps)
+        inline float scale(int nRowIdx, int nColIdx) const {return scale(nRowIdx*oScales.cols+nColIdx);}
+        /// decodes a single descriptor (given its flattened index) into the provided float array
+        void decode(int nDescIdx, float* aDescriptor) const;
+        /// returns the L2 distance between two quantized descriptors
+        static double calcDistance_L2(const uchar* aBins1, float fScale1, const uchar* aBins2, float fScale2, int nDescSize);
+        /// returns the L2 distance between two descriptors of (possibly different) quantized maps, given their flattened indices
+        inline double calcDistance_L2(int nDescIdx, const QuantizedDescMap& oOther, int nOtherDescIdx) const {
+            lvDbgAssert(descSize()==oOther.descSize());
+            return calcDistance_L2(bins(nDescIdx),scale(nDescIdx),oOther.bins(nOtherDescIdx),oOther.scale(nOtherDescIdx),descSize());
+        }
+        /// computes per-desc L2 distances between two quantized descriptor sets/maps of identical size (Nx1 or RxC output)
+        static void calcDistances_L2(const QuantizedDescMap& oDescMap1, const QuantizedDescMap& oDescMap2, cv::Mat_<float>& oDistances);
+    };
+
+} // namespace lv
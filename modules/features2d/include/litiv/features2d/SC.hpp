@@ -18,6 +18,10 @@
 #pragma once
 
 #include "litiv/utils/algo.hpp"
+#include "litiv/utils/platform.hpp"
+#include "litiv/features2d/DescMatcher.hpp"
+#include "litiv/features2d/EMD.hpp"
+#include "litiv/features2d/QuantizedDescMap.hpp"
 #include <opencv2/features2d.hpp>
 
 #define SHAPECONTEXT_DEFAULT_ANG_BINS    (12)
@@ -36,6 +40,11 @@
     For more details on the different parameters, see S. Belongie, J. Malik and J. Puzicha, "Shape
     Matching and Object Recognition Using Shape Contexts", in IEEE TPAMI2002.
 
+    Note: on CPU, dense absolute-space maps (w/o rotation invariance) are filled by scattering each contour point
+    into the descriptors of its neighborhood using the cached bins of the log-polar lookup mask (row bands of the
+    map are processed in parallel). Relative-space/rotation-invariant descriptors are binned on the fly in parallel
+    for each keypoint (without keypoint-contour distance/angle maps), with radial bins assigned via AVX2 when
+    available (see ShapeContext::setInstrSet); the output does not depend on the instruction set used.
 */
 class ShapeContext :
 #if HAVE_CUDA
@@ -92,6 +101,10 @@ public:
     bool isNonZeroInitBins() const;
     /// returns the cv::ContourApproximationModes detection strategy to use when finding contours in binary images
     int chainDetectMethod() const;
+    /// sets the instruction set used for CPU bin assignment (capped to what the host supports; SIMD_None = scalar impl)
+    void setInstrSet(lv::SIMDInstrSet eInstrSet);
+    /// returns the instruction set actually used for CPU bin assignment (SIMD_None or SIMD_AVX2)
+    inline lv::SIMDInstrSet getInstrSet() const {return m_eInstrSet;}
 
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix, and all image points are described (note: descriptors close to borders will be invalid)
     void compute2(const cv::Mat& oImage, cv::Mat& oDescMap);
@@ -99,10 +112,16 @@ public:
     void compute2(const cv::Mat& oImage, cv::Mat_<float>& oDescMap);
     /// similar to DescriptorExtractor::compute(const cv::Mat& image, ...), but in this case, the descriptors matrix has the same shape as the input matrix
     void compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat_<float>& oDescMap);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// similar to compute2(const cv::Mat& image, cv::Mat_<float>&), but the dense descriptor map is stored in compact 8-bit form (see lv::QuantizedDescMap)
+    void compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap);
+    /// batch version of ShapeContext::compute2(const cv::Mat& image, ...); images are described concurrently on CPU (see ShapeContext::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
-    /// batch version of LBSP::compute2(const cv::Mat& image, ...)
+    /// batch version of ShapeContext::compute2(const cv::Mat& image, ...); images are described concurrently on CPU (see ShapeContext::setBatchWorkerCount), and preallocated output maps are reused
     void compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection);
+    /// sets the max number of images described concurrently by batch 'compute2' calls (0 = all available threads; each extra worker owns a full set of scratch buffers; ignored when using CUDA)
+    inline void setBatchWorkerCount(size_t nWorkerCount) {m_oBatchWorkers.setWorkerCount(nWorkerCount);}
+    /// returns the max number of images described concurrently by batch 'compute2' calls (0 = all available threads)
+    inline size_t getBatchWorkerCount() const {return m_oBatchWorkers.getWorkerCount();}
 
     /// utility function, used to reshape a descriptors matrix to its input image size (assumes fully-dense keypoints over input)
     void reshapeDesc(cv::Size oSize, cv::Mat& oDescriptors) const;
@@ -134,6 +153,16 @@ public:
         lvAssert_(oDescriptor1.dims!=3 || (oDescriptor1.size[0]==1 && oDescriptor1.size[1]==1 && oDescriptor1.size[2]==m_nRadialBins*m_nAngularBins),"unexpected descriptor size");
         return calcDistance_EMD(oDescriptor1.ptr<float>(0),oDescriptor2.ptr<float>(0));
     }
+    /// utility function, returns the approximate (Sinkhorn) EMD solver built on the internal EMD cost map
+    inline const SinkhornEMD& getApproxEMD() const {return *m_pApproxEMD;}
+    /// utility function, used to calculate the approximate EMD distance (upper bound, see SinkhornEMD) between two individual descriptors
+    inline double calcDistance_EMDApprox(const float* aDescriptor1, const float* aDescriptor2) const {
+        return m_pApproxEMD->compute(aDescriptor1,aDescriptor2);
+    }
+    /// utility function, used to calculate the approximate EMD distances between all row-wise descriptor pairs of two (NxD) matrices (batched version)
+    inline void calcDistances_EMDApprox(const cv::Mat_<float>& oDescriptors1, const cv::Mat_<float>& oDescriptors2, std::vector<double>& vdDists) const {
+        m_pApproxEMD->compute(oDescriptors1,oDescriptors2,vdDists);
+    }
     /// utility function, used to calculate the L2 distance between two individual descriptors
     inline double calcDistance_L2(const float* aDescriptor1, const float* aDescriptor2) const {
         const cv::Mat_<float> oDesc1(1,m_nRadialBins*m_nAngularBins,const_cast<float*>(aDescriptor1));
@@ -148,6 +177,10 @@ public:
         lvAssert_(oDescriptor1.dims!=3 || (oDescriptor1.size[0]==1 && oDescriptor1.size[1]==1 && oDescriptor1.size[2]==m_nRadialBins*m_nAngularBins),"unexpected descriptor size");
         return calcDistance_L2(oDescriptor1.ptr<float>(0),oDescriptor2.ptr<float>(0));
     }
+    /// utility function, used to calculate per-desc L2 distance between two quantized descriptor sets/maps (without dequantizing them; for EMD, see lv::QuantizedDescMap::decode)
+    void calcDistances_L2(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const;
+    /// utility function, used to find the k nearest (L2) train descriptors of each query descriptor in two descriptor sets/maps (see DescMatcher)
+    void knnMatch_L2(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const;
 
 protected:
     /// hides default keypoint detection impl (this class is a descriptor extractor only)
@@ -176,6 +209,8 @@ protected:
     const bool m_bNormalizeBins;
     /// defines whether descriptor bins should be initialized with (small) nonzero values or not
     const bool m_bNonZeroInitBins;
+    /// instruction set used for CPU bin assignment
+    lv::SIMDInstrSet m_eInstrSet;
 
 private:
 
@@ -187,20 +222,30 @@ private:
     void scdesc_generate_emdmask();
     /// fills contour point map using provided binary image
     void scdesc_fill_contours(const cv::Mat& oImage);
-    /// fills mean-normalized dist map & angle map using internal contour/key points
-    void scdesc_fill_maps(double dMeanDist=-1.0);
-    /// fills descriptor using internal maps
+    /// fills descriptor by binning keypoint-contour distances/angles on the fly (handles relative dist space/rot inv)
     void scdesc_fill_desc(cv::Mat_<float>& oDescriptors, bool bGenDescMap);
-    /// fills descriptor without using internal maps (only for absolute descs w/o rot inv)
+    /// fills descriptor using the absolute lookup mask (only for absolute descs w/o rot inv)
     void scdesc_fill_desc_direct(cv::Mat_<float>& oDescriptors, bool bGenDescMap);
     /// descriptor normalisation approach impl
     void scdesc_norm(cv::Mat_<float>& oDescriptors) const;
+    /// creates a new (CPU-only) extractor instance with the same parameters, used as a batch worker
+    std::unique_ptr<ShapeContext> scdesc_create_worker() const;
+    /// describes all images of a collection via 'lDescribe(oExtractor,nImageIdx)', using batch workers when possible
+    template<typename TDescribeFunc>
+    void scdesc_batch_impl(size_t nImages, TDescribeFunc&& lDescribe);
 
     // helper variables for internal impl (helps avoid continuous mem realloc)
     std::vector<double> m_vAngularLimits,m_vRadialLimits;
-    cv::Mat_<double> m_oDistMap,m_oAngMap;
     cv::Mat_<float> m_oEMDCostMap;
+    /// approximate EMD solver built on the cost map above (regenerated along with it)
+    std::shared_ptr<const SinkhornEMD> m_pApproxEMD;
     cv::Mat_<int> m_oAbsDescLUMap;
+    /// valid (lookup col, desc bin) pairs of each absolute lookup mask row, used to scatter contour points into dense maps
+    std::vector<std::vector<std::pair<int,int>>> m_vvAbsDescLUMapRowBins;
+    /// contour point column indices bucketed by image row (CSR-style, with row offsets), used to skip distant contour points
+    std::vector<int> m_vContourRowOffsets,m_vContourColIdxs;
+    /// extra extractor instances used to describe image collections concurrently (each with its own helper variables)
+    lv::BatchWorkerPool<ShapeContext> m_oBatchWorkers;
 #if HAVE_CUDA
     cv::cuda::GpuMat m_oDescriptors_dev;
     cv::cuda::GpuMat m_oKeyPts_dev,m_oContourPts_dev;
@@ -163,17 +163,51 @@ void DASC::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoint
         dasc_gf_impl(oImage,oDescMap);
 }
 
+void DASC::compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat_<float>& oDescMap) {
+    lvAssert_(!oImage.empty(),"input image must be non-empty");
+    lvAssert_(oChangeMask.empty() || (oChangeMask.type()==CV_8UC1 && oChangeMask.size()==oImage.size()),"change mask must be empty, or 8UC1 and of the same size as the input image");
+    if(m_bUsingRF || m_nSubSamplFrac>1) {
+        // recursive filters span whole rows/cols, and the subsampling grid of guided filters depends on the full image size
+        if(!oChangeMask.empty() && oDescMap.dims==3 && oDescMap.size[0]==oImage.rows && oDescMap.size[1]==oImage.cols && cv::countNonZero(oChangeMask)==0)
+            return;
+        compute2(oImage,oDescMap);
+        return;
+    }
+    // guided filters are built from two successive box filters, so the support of each descriptor is the pattern radius plus twice the
+    // filter radius (and the pre-processing blur); the inner border row is also needed, as descriptors with offset points on the first
+    // row/col of their (cropped) map are zeroed; updated regions span full rows, as box filter running sums start at each crop's first col
+    // note: crops are described one at a time (with inner parallelism), as the gf impl caches intermediate maps in the extractor itself
+    const int nSupportRadius = pretrained::nRPAbsMax+1+int(m_nRadius)*2+(m_bPreProcess?3:0);
+    lv::computeTemporalDescMap(oImage,oChangeMask,nSupportRadius,oDescMap,[&](const cv::Rect& oROI, cv::Mat_<float>& oROIDescMap) {
+        dasc_gf_impl((oROI.size()==oImage.size())?oImage:oImage(oROI).clone(),oROIDescMap);
+    },true,1);
+}
+
+void DASC::compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap) {
+    cv::Mat_<float> oFloatDescMap; // float map is only kept until quantized (released on return)
+    compute2(oImage,oFloatDescMap);
+    oDescMap.quantize(oFloatDescMap);
+}
+
 void DASC::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],voDescMapCollection[i]);
+    m_oBatchWorkers.process(voImageCollection.size(),*this,[&](){return dasc_create_worker();},[&](DASC& oWorker, size_t nImageIdx){
+        oWorker.compute2(voImageCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
 }
 
 void DASC::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     lvAssert_(voImageCollection.size()==vvoPointCollection.size(),"number of images must match number of keypoint lists");
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],vvoPointCollection[i],voDescMapCollection[i]);
+    m_oBatchWorkers.process(voImageCollection.size(),*this,[&](){return dasc_create_worker();},[&](DASC& oWorker, size_t nImageIdx){
+        oWorker.compute2(voImageCollection[nImageIdx],vvoPointCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
+}
+
+std::unique_ptr<DASC> DASC::dasc_create_worker() const {
+    if(m_bUsingRF)
+        return std::make_unique<DASC>(m_fSigma_s,m_fSigma_r,m_nIters,m_bPreProcess);
+    return std::make_unique<DASC>(m_nRadius,m_fEpsilon,m_nSubSamplFrac,m_bPreProcess);
 }
 
 void DASC::detectAndCompute(cv::InputArray _oImage, cv::InputArray _oMask, std::vector<cv::KeyPoint>& voKeypoints, cv::OutputArray _oDescriptors, bool bUseProvidedKeypoints) {
@@ -236,48 +270,71 @@ void DASC::validateROI(cv::Mat& oROI) {
 void DASC::calcDistances(const cv::Mat_<float>& oDescriptors1, const cv::Mat_<float>& oDescriptors2, cv::Mat_<float>& oDistances) {
     lvAssert_(oDescriptors1.dims==oDescriptors2.dims && oDescriptors1.size==oDescriptors2.size,"descriptor mat sizes mismatch");
     lvAssert_(oDescriptors1.dims==2 || oDescriptors1.dims==3,"unexpected descriptor matrix dim count");
-    if(oDescriptors1.dims==2) {
-        lvAssert_(oDescriptors1.cols==int(pretrained::nLUTSize),"unexpected descriptor size");
-        oDistances.create(oDescriptors1.rows,1);
-        for(int nDescIdx=0; nDescIdx<oDescriptors1.rows; ++nDescIdx) {
-            const cv::Mat_<float> oDesc1(1,int(pretrained::nLUTSize),const_cast<float*>(oDescriptors1.ptr<float>(nDescIdx)));
-            const cv::Mat_<float> oDesc2(1,int(pretrained::nLUTSize),const_cast<float*>(oDescriptors2.ptr<float>(nDescIdx)));
-            oDistances(nDescIdx) = (float)cv::norm(oDesc1,oDesc2,cv::NORM_L2);
-        }
-    }
-    else { //oDescriptors1.dims==3
-        lvAssert_(oDescriptors1.size[2]==int(pretrained::nLUTSize),"unexpected descriptor size");
-        oDistances.create(oDescriptors1.size[0],oDescriptors1.size[1]);
-        for(int nDescRowIdx=0; nDescRowIdx<oDescriptors1.size[0]; ++nDescRowIdx) {
-            for(int nDescColIdx=0; nDescColIdx<oDescriptors1.size[1]; ++nDescColIdx) {
-                const cv::Mat_<float> oDesc1(1,int(pretrained::nLUTSize),const_cast<float*>(oDescriptors1.ptr<float>(nDescRowIdx,nDescColIdx)));
-                const cv::Mat_<float> oDesc2(1,int(pretrained::nLUTSize),const_cast<float*>(oDescriptors2.ptr<float>(nDescRowIdx,nDescColIdx)));
-                oDistances(nDescRowIdx,nDescColIdx) = (float)cv::norm(oDesc1,oDesc2,cv::NORM_L2);
-            }
-        }
-    }
+    lvAssert_(oDescriptors1.size[oDescriptors1.dims-1]==int(pretrained::nLUTSize),"unexpected descriptor size");
+    DescMatcher(DescMatcher::Dist_L2).calcDistances(oDescriptors1,oDescriptors2,oDistances);
+}
+
+void DASC::calcDistances(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const {
+    lvAssert_(!oDescriptors1.empty() && oDescriptors1.descSize()==int(pretrained::nLUTSize),"unexpected descriptor size");
+    lv::QuantizedDescMap::calcDistances_L2(oDescriptors1,oDescriptors2,oDistances);
 }
 
-void DASC::recursFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef_V_dHdx, const cv::Mat_<float>& oRef_V_dVdy_t, cv::Mat_<float>& oOutput) {
-    lvDbgAssert(!oImage.empty() && !oRef_V_dHdx.empty() && !oRef_V_dHdx.empty() && m_nIters>0 && oImage.dims==2 && oRef_V_dHdx.dims==3 && oRef_V_dVdy_t.dims==3);
-    lvDbgAssert(oImage.rows==oRef_V_dHdx.size[1] && oImage.rows==oRef_V_dVdy_t.size[2] && oImage.cols==oRef_V_dHdx.size[2] && oImage.cols==oRef_V_dVdy_t.size[1]);
-    lvDbgAssert(oRef_V_dHdx.size[0]==(int)m_nIters && oRef_V_dVdy_t.size[0]==(int)m_nIters);
+void DASC::knnMatch(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const {
+    lvAssert_((oQueryDescs.dims==2 || oQueryDescs.dims==3) && oQueryDescs.size[oQueryDescs.dims-1]==int(pretrained::nLUTSize),"unexpected query descriptor size");
+    lvAssert_((oTrainDescs.dims==2 || oTrainDescs.dims==3) && oTrainDescs.size[oTrainDescs.dims-1]==int(pretrained::nLUTSize),"unexpected train descriptor size");
+    DescMatcher(DescMatcher::Dist_L2).knnMatch(oQueryDescs,oTrainDescs,nK,vvMatches);
+}
+
+void DASC::recursFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef_V_dHdx, const cv::Mat_<float>& oRef_V_dVdy, cv::Mat_<float>& oOutput) const {
+    lvDbgAssert(!oImage.empty() && !oRef_V_dHdx.empty() && !oRef_V_dVdy.empty() && m_nIters>0 && oImage.dims==2 && oRef_V_dHdx.dims==3 && oRef_V_dVdy.dims==3);
+    lvDbgAssert(oImage.rows==oRef_V_dHdx.size[1] && oImage.rows==oRef_V_dVdy.size[1] && oImage.cols==oRef_V_dHdx.size[2] && oImage.cols==oRef_V_dVdy.size[2]);
+    lvDbgAssert(oRef_V_dHdx.size[0]==(int)m_nIters && oRef_V_dVdy.size[0]==(int)m_nIters);
     oImage.copyTo(oOutput);
-    const auto lTransfDomRecursFilter_H = [](cv::Mat_<float>& _oImage, const cv::Mat_<float>& oRef, int nIterIdx) {
-        lvDbgAssert(!_oImage.empty() && _oImage.dims==2 && !oRef.empty() && oRef.dims==3);
-        lvDbgAssert(_oImage.rows==oRef.size[1] && _oImage.cols==oRef.size[2]);
-        for(int nRowIdx=0; nRowIdx<_oImage.rows; ++nRowIdx) {
-            for(int nColIdx=1; nColIdx<_oImage.cols; ++nColIdx)
-                _oImage(nRowIdx,nColIdx) += oRef(nIterIdx,nRowIdx,nColIdx)*(_oImage(nRowIdx,nColIdx-1)-_oImage(nRowIdx,nColIdx));
-            for(int nColIdx=_oImage.cols-2; nColIdx>=0; --nColIdx)
-                _oImage(nRowIdx,nColIdx) += oRef(nIterIdx,nRowIdx,nColIdx+1)*(_oImage(nRowIdx,nColIdx+1)-_oImage(nRowIdx,nColIdx));
-        }
-    };
+    const int nRows = oOutput.rows;
+    const int nCols = oOutput.cols;
+    // rows are filtered in interleaved groups so that their (serial) recurrences overlap in the pipeline
+    constexpr int nRowGroupSize = 4;
     for(int nIterIdx=0; nIterIdx<(int)m_nIters; ++nIterIdx) {
-        lTransfDomRecursFilter_H(oOutput,oRef_V_dHdx,nIterIdx);
-        cv::transpose(oOutput,m_oTempTransp);
-        lTransfDomRecursFilter_H(m_oTempTransp,oRef_V_dVdy_t,nIterIdx);
-        cv::transpose(m_oTempTransp,oOutput);
+        int nRowIdx = 0;
+        for(; nRowIdx+nRowGroupSize<=nRows; nRowIdx+=nRowGroupSize) {
+            std::array<float*,nRowGroupSize> aafRows;
+            std::array<const float*,nRowGroupSize> aafCoeffs;
+            lv::unroll<nRowGroupSize>([&](int nOffset) {
+                aafRows[nOffset] = oOutput.ptr<float>(nRowIdx+nOffset);
+                aafCoeffs[nOffset] = oRef_V_dHdx.ptr<float>(nIterIdx,nRowIdx+nOffset);
+            });
+            for(int nColIdx=1; nColIdx<nCols; ++nColIdx)
+                lv::unroll<nRowGroupSize>([&](int nOffset) {
+                    aafRows[nOffset][nColIdx] += aafCoeffs[nOffset][nColIdx]*(aafRows[nOffset][nColIdx-1]-aafRows[nOffset][nColIdx]);
+                });
+            for(int nColIdx=nCols-2; nColIdx>=0; --nColIdx)
+                lv::unroll<nRowGroupSize>([&](int nOffset) {
+                    aafRows[nOffset][nColIdx] += aafCoeffs[nOffset][nColIdx+1]*(aafRows[nOffset][nColIdx+1]-aafRows[nOffset][nColIdx]);
+                });
+        }
+        for(; nRowIdx<nRows; ++nRowIdx) {
+            float* const afRow = oOutput.ptr<float>(nRowIdx);
+            const float* const afCoeffs = oRef_V_dHdx.ptr<float>(nIterIdx,nRowIdx);
+            for(int nColIdx=1; nColIdx<nCols; ++nColIdx)
+                afRow[nColIdx] += afCoeffs[nColIdx]*(afRow[nColIdx-1]-afRow[nColIdx]);
+            for(int nColIdx=nCols-2; nColIdx>=0; --nColIdx)
+                afRow[nColIdx] += afCoeffs[nColIdx+1]*(afRow[nColIdx+1]-afRow[nColIdx]);
+        }
+        // vertical pass sweeps whole rows at once (all columns are independent, so inner loops are contiguous & vectorizable)
+        for(nRowIdx=1; nRowIdx<nRows; ++nRowIdx) {
+            float* const afRow = oOutput.ptr<float>(nRowIdx);
+            const float* const afPrevRow = oOutput.ptr<float>(nRowIdx-1);
+            const float* const afCoeffs = oRef_V_dVdy.ptr<float>(nIterIdx,nRowIdx);
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx)
+                afRow[nColIdx] += afCoeffs[nColIdx]*(afPrevRow[nColIdx]-afRow[nColIdx]);
+        }
+        for(nRowIdx=nRows-2; nRowIdx>=0; --nRowIdx) {
+            float* const afRow = oOutput.ptr<float>(nRowIdx);
+            const float* const afNextRow = oOutput.ptr<float>(nRowIdx+1);
+            const float* const afCoeffs = oRef_V_dVdy.ptr<float>(nIterIdx,nRowIdx+1);
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx)
+                afRow[nColIdx] += afCoeffs[nColIdx]*(afNextRow[nColIdx]-afRow[nColIdx]);
+        }
     }
 }
 
@@ -304,80 +361,37 @@ void DASC::dasc_rf_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
     m_oRef_dHdx = 1.0f + m_fSigma_s/m_fSigma_r*cv::abs(m_oImageLocalDiff_X);
     const std::array<int,3> anRefDims = {(int)m_nIters,nRows,nCols};
     m_oRef_V_dHdx.create(3,anRefDims.data());
-    const std::array<int,3> anRefDims_t = {(int)m_nIters,nCols,nRows};
-    m_oRef_V_dVdy_t.create(3,anRefDims_t.data());
+    m_oRef_V_dVdy.create(3,anRefDims.data());
     for(int nIterIdx=0; nIterIdx<(int)m_nIters; ++nIterIdx) {
         const float fBase = std::exp(-std::sqrt(2.0f)/(m_fSigma_s*std::sqrt(3.0f)*(float)std::pow(2.0f,(int)m_nIters-(nIterIdx+1))/std::sqrt((float)std::pow(4.0f,(int)m_nIters)-1)));
+#if USING_OPENMP
+        #pragma omp parallel for
+#endif //USING_OPENMP
         for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
             for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
                 m_oRef_V_dHdx(nIterIdx,nRowIdx,nColIdx) = std::pow(fBase,m_oRef_dHdx(nRowIdx,nColIdx));
-                m_oRef_V_dVdy_t(nIterIdx,nColIdx,nRowIdx) = std::pow(fBase,m_oRef_dVdy(nRowIdx,nColIdx));
+                m_oRef_V_dVdy(nIterIdx,nRowIdx,nColIdx) = std::pow(fBase,m_oRef_dVdy(nRowIdx,nColIdx));
             }
         }
     }
-    recursFilter(oImage,m_oRef_V_dHdx,m_oRef_V_dVdy_t,m_oImage_AdaptiveMean);
-    recursFilter(oImage.mul(oImage),m_oRef_V_dHdx,m_oRef_V_dVdy_t,m_oImage_AdaptiveMeanSqr);
-    m_oLookupImage.create(m_oImageSize);
-    m_oLookupImage_Sqr.create(m_oImageSize);
-    m_oLookupImage_Mix.create(m_oImageSize);
-    const std::array<int,3> anDescDims = {nRows,nCols,(int)pretrained::nLUTSize};
-    oDescriptors.create(3,anDescDims.data());
-    for(int nLUTIdx=0; nLUTIdx<(int)pretrained::nLUTSize; nLUTIdx++) {
-        const int nRowOffset = pretrained::anRPDiff[nLUTIdx*2];
-        const int nColOffset = pretrained::anRPDiff[nLUTIdx*2+1];
-        for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
-            for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
-                if(nRowIdx+nRowOffset>=0 && nRowIdx+nRowOffset<nRows && nColIdx+nColOffset>=0 && nColIdx+nColOffset<nCols) {
-                    m_oLookupImage(nRowIdx,nColIdx) = oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
-                    m_oLookupImage_Sqr(nRowIdx,nColIdx) = oImage(nRowIdx+nRowOffset,nColIdx+nColOffset)*oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
-                    m_oLookupImage_Mix(nRowIdx,nColIdx) = oImage(nRowIdx,nColIdx)*oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
-                }
-                else
-                    m_oLookupImage(nRowIdx,nColIdx) = m_oLookupImage_Sqr(nRowIdx,nColIdx) = m_oLookupImage_Mix(nRowIdx,nColIdx) = 0.0f;
-            }
-        }
-        recursFilter(m_oLookupImage,m_oRef_V_dHdx,m_oRef_V_dVdy_t,m_oLookupImage_AdaptiveMean);
-        recursFilter(m_oLookupImage_Sqr,m_oRef_V_dHdx,m_oRef_V_dVdy_t,m_oLookupImage_AdaptiveMeanSqr);
-        recursFilter(m_oLookupImage_Mix,m_oRef_V_dHdx,m_oRef_V_dVdy_t,m_oLookupImage_AdaptiveMeanMix);
-        for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
-            for(int nColIdx = 0; nColIdx<nCols; ++nColIdx) {
-                const int nOffsetRowIdx = nRowIdx+pretrained::anRP1[nLUTIdx*2];
-                const int nOffsetColIdx = nColIdx+pretrained::anRP1[nLUTIdx*2+1];
-                if(nOffsetRowIdx>0 && nOffsetRowIdx<nRows && nOffsetColIdx>0 && nOffsetColIdx<nCols) {
-                    const float fCorrSurfDenom = std::sqrt((m_oImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)) * (m_oLookupImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)));
-                    const float fVisDiff = m_oLookupImage_AdaptiveMeanMix(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx);
-                    oDescriptors(nRowIdx,nColIdx,nLUTIdx) = fCorrSurfDenom>LOCAL_EPS?std::min(std::exp(-(1-(fVisDiff)/fCorrSurfDenom)*2),1.0f):1.0f;
-                }
-                else
-                    oDescriptors(nRowIdx,nColIdx,nLUTIdx) = 0.0f;
-            }
-        }
-    }
-    for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
-        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
-            cv::Mat_<float> oCurrDesc(1,(int)pretrained::nLUTSize,oDescriptors.ptr<float>(nRowIdx,nColIdx));
-            const double dNorm = cv::norm(oCurrDesc,cv::NORM_L2);
-            if(dNorm>LOCAL_EPS)
-                oCurrDesc /= dNorm;
-            else
-                oCurrDesc = std::sqrt(1.0f/pretrained::nLUTSize);
-        }
-    }
+    recursFilter(oImage,m_oRef_V_dHdx,m_oRef_V_dVdy,m_oImage_AdaptiveMean);
+    recursFilter(oImage.mul(oImage),m_oRef_V_dHdx,m_oRef_V_dVdy,m_oImage_AdaptiveMeanSqr);
+    dasc_lut_impl(oImage,oDescriptors);
 }
 
-void DASC::guidedFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef, cv::Mat_<float>& oOutput) {
+void DASC::guidedFilter(const cv::Mat_<float>& oImage, const cv::Mat_<float>& oRef, LookupTempData& oTempData, cv::Mat_<float>& oOutput) const {
     lvDbgAssert(!oImage.empty() && !oRef.empty());
-    cv::resize(oRef,m_oRef_SubSampl,m_oSubSamplSize,0.0,0.0,cv::INTER_NEAREST);
-    m_oRef_SubSamplCross = m_oImage_SubSampl.mul(m_oRef_SubSampl);
-    cv::blur(m_oRef_SubSampl,m_oRef_SubSamplBlur,m_oBlurKernelSize);
-    cv::blur(m_oRef_SubSamplCross,m_oRef_SubSamplCrossBlur,m_oBlurKernelSize);
-    m_oNormVar_SubSampl = (m_oRef_SubSamplCrossBlur-m_oImage_SubSamplBlur.mul(m_oRef_SubSamplBlur))/m_oImage_SubSamplVar;
-    m_oNormVarDiff_SubSampl = m_oRef_SubSamplBlur - m_oNormVar_SubSampl.mul(m_oImage_SubSamplBlur);
-    cv::blur(m_oNormVar_SubSampl,m_oNormVar_SubSamplBlur,m_oBlurKernelSize);
-    cv::blur(m_oNormVarDiff_SubSampl,m_oNormVarDiff_SubSamplBlur,m_oBlurKernelSize);
-    cv::resize(m_oNormVar_SubSamplBlur,m_oNormVar,m_oImageSize,0,0,cv::INTER_LINEAR);
-    cv::resize(m_oNormVarDiff_SubSamplBlur,m_oNormVarDiff,m_oImageSize,0,0,cv::INTER_LINEAR);
-    oOutput = m_oNormVar.mul(oImage)+m_oNormVarDiff;
+    cv::resize(oRef,oTempData.oRef_SubSampl,m_oSubSamplSize,0.0,0.0,cv::INTER_NEAREST);
+    oTempData.oRef_SubSamplCross = m_oImage_SubSampl.mul(oTempData.oRef_SubSampl);
+    cv::blur(oTempData.oRef_SubSampl,oTempData.oRef_SubSamplBlur,m_oBlurKernelSize);
+    cv::blur(oTempData.oRef_SubSamplCross,oTempData.oRef_SubSamplCrossBlur,m_oBlurKernelSize);
+    oTempData.oNormVar_SubSampl = (oTempData.oRef_SubSamplCrossBlur-m_oImage_SubSamplBlur.mul(oTempData.oRef_SubSamplBlur))/m_oImage_SubSamplVar;
+    oTempData.oNormVarDiff_SubSampl = oTempData.oRef_SubSamplBlur - oTempData.oNormVar_SubSampl.mul(m_oImage_SubSamplBlur);
+    cv::blur(oTempData.oNormVar_SubSampl,oTempData.oNormVar_SubSamplBlur,m_oBlurKernelSize);
+    cv::blur(oTempData.oNormVarDiff_SubSampl,oTempData.oNormVarDiff_SubSamplBlur,m_oBlurKernelSize);
+    cv::resize(oTempData.oNormVar_SubSamplBlur,oTempData.oNormVar,m_oImageSize,0,0,cv::INTER_LINEAR);
+    cv::resize(oTempData.oNormVarDiff_SubSamplBlur,oTempData.oNormVarDiff,m_oImageSize,0,0,cv::INTER_LINEAR);
+    oOutput = oTempData.oNormVar.mul(oImage)+oTempData.oNormVarDiff;
 }
 
 void DASC::dasc_gf_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
@@ -401,43 +415,73 @@ void DASC::dasc_gf_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
     const int nKernelRadius = (int)(m_nRadius/m_nSubSamplFrac);
     lvAssert(nKernelRadius>0);
     m_oBlurKernelSize = cv::Size(2*nKernelRadius+1,2*nKernelRadius+1);
-    const int nRows = m_oImageSize.height;
-    const int nCols = m_oImageSize.width;
     cv::resize(oImage,m_oImage_SubSampl,m_oSubSamplSize,0.0,0.0,cv::INTER_NEAREST);
     cv::blur(m_oImage_SubSampl,m_oImage_SubSamplBlur,m_oBlurKernelSize);
     cv::blur(m_oImage_SubSampl.mul(m_oImage_SubSampl),m_oImage_SubSamplBlurSqr,m_oBlurKernelSize);
     m_oImage_SubSamplVar = m_oImage_SubSamplBlurSqr-m_oImage_SubSamplBlur.mul(m_oImage_SubSamplBlur)+m_fEpsilon;
-    guidedFilter(oImage,oImage,m_oImage_AdaptiveMean);
-    guidedFilter(oImage,oImage.mul(oImage),m_oImage_AdaptiveMeanSqr);
-    m_oLookupImage.create(m_oImageSize);
-    m_oLookupImage_Sqr.create(m_oImageSize);
-    m_oLookupImage_Mix.create(m_oImageSize);
+    static thread_local LookupTempData s_oTempData;
+    guidedFilter(oImage,oImage,s_oTempData,m_oImage_AdaptiveMean);
+    guidedFilter(oImage,oImage.mul(oImage),s_oTempData,m_oImage_AdaptiveMeanSqr);
+    dasc_lut_impl(oImage,oDescriptors);
+}
+
+void DASC::dasc_lut_impl(const cv::Mat_<float>& oImage, cv::Mat_<float>& oDescriptors) const {
+    lvDbgAssert(!oImage.empty() && oImage.size()==m_oImageSize);
+    lvDbgAssert(m_oImage_AdaptiveMean.size()==m_oImageSize && m_oImage_AdaptiveMeanSqr.size()==m_oImageSize);
+    const int nRows = m_oImageSize.height;
+    const int nCols = m_oImageSize.width;
     const std::array<int,3> anDescDims = {nRows,nCols,(int)pretrained::nLUTSize};
     oDescriptors.create(3,anDescDims.data());
+    // each LUT entry only writes its own bin in all descriptors; workers get blocks of 16 consecutive entries (one
+    // cache line of bins per descriptor) to avoid sharing cache lines while writing
+#if USING_OPENMP
+    #pragma omp parallel for schedule(static,16)
+#endif //USING_OPENMP
     for(int nLUTIdx=0; nLUTIdx<(int)pretrained::nLUTSize; nLUTIdx++) {
+        static thread_local LookupTempData s_oTempData;
+        s_oTempData.oLookupImage.create(m_oImageSize);
+        s_oTempData.oLookupImage_Sqr.create(m_oImageSize);
+        s_oTempData.oLookupImage_Mix.create(m_oImageSize);
         const int nRowOffset = pretrained::anRPDiff[nLUTIdx*2];
         const int nColOffset = pretrained::anRPDiff[nLUTIdx*2+1];
         for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+            const float* const afImageRow = oImage.ptr<float>(nRowIdx);
+            const bool bValidOffsetRow = (nRowIdx+nRowOffset>=0 && nRowIdx+nRowOffset<nRows);
+            const float* const afOffsetImageRow = bValidOffsetRow?oImage.ptr<float>(nRowIdx+nRowOffset):nullptr;
+            float* const afLookupRow = s_oTempData.oLookupImage.ptr<float>(nRowIdx);
+            float* const afLookupRow_Sqr = s_oTempData.oLookupImage_Sqr.ptr<float>(nRowIdx);
+            float* const afLookupRow_Mix = s_oTempData.oLookupImage_Mix.ptr<float>(nRowIdx);
             for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
-                if(nRowIdx+nRowOffset>=0 && nRowIdx+nRowOffset<nRows && nColIdx+nColOffset>=0 && nColIdx+nColOffset<nCols) {
-                    m_oLookupImage(nRowIdx,nColIdx) = oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
-                    m_oLookupImage_Sqr(nRowIdx,nColIdx) = oImage(nRowIdx+nRowOffset,nColIdx+nColOffset)*oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
-                    m_oLookupImage_Mix(nRowIdx,nColIdx) = oImage(nRowIdx,nColIdx)*oImage(nRowIdx+nRowOffset,nColIdx+nColOffset);
+                if(bValidOffsetRow && nColIdx+nColOffset>=0 && nColIdx+nColOffset<nCols) {
+                    const float fOffsetVal = afOffsetImageRow[nColIdx+nColOffset];
+                    afLookupRow[nColIdx] = fOffsetVal;
+                    afLookupRow_Sqr[nColIdx] = fOffsetVal*fOffsetVal;
+                    afLookupRow_Mix[nColIdx] = afImageRow[nColIdx]*fOffsetVal;
                 }
                 else
-                    m_oLookupImage(nRowIdx,nColIdx) = m_oLookupImage_Sqr(nRowIdx,nColIdx) = m_oLookupImage_Mix(nRowIdx,nColIdx) = 0.0f;
+                    afLookupRow[nColIdx] = afLookupRow_Sqr[nColIdx] = afLookupRow_Mix[nColIdx] = 0.0f;
             }
         }
-        guidedFilter(oImage,m_oLookupImage,m_oLookupImage_AdaptiveMean);
-        guidedFilter(oImage,m_oLookupImage_Sqr,m_oLookupImage_AdaptiveMeanSqr);
-        guidedFilter(oImage,m_oLookupImage_Mix,m_oLookupImage_AdaptiveMeanMix);
+        if(m_bUsingRF) {
+            recursFilter(s_oTempData.oLookupImage,m_oRef_V_dHdx,m_oRef_V_dVdy,s_oTempData.oLookupImage_AdaptiveMean);
+            recursFilter(s_oTempData.oLookupImage_Sqr,m_oRef_V_dHdx,m_oRef_V_dVdy,s_oTempData.oLookupImage_AdaptiveMeanSqr);
+            recursFilter(s_oTempData.oLookupImage_Mix,m_oRef_V_dHdx,m_oRef_V_dVdy,s_oTempData.oLookupImage_AdaptiveMeanMix);
+        }
+        else {
+            guidedFilter(oImage,s_oTempData.oLookupImage,s_oTempData,s_oTempData.oLookupImage_AdaptiveMean);
+            guidedFilter(oImage,s_oTempData.oLookupImage_Sqr,s_oTempData,s_oTempData.oLookupImage_AdaptiveMeanSqr);
+            guidedFilter(oImage,s_oTempData.oLookupImage_Mix,s_oTempData,s_oTempData.oLookupImage_AdaptiveMeanMix);
+        }
+        const cv::Mat_<float>& oLookupImage_AdaptiveMean = s_oTempData.oLookupImage_AdaptiveMean;
+        const cv::Mat_<float>& oLookupImage_AdaptiveMeanSqr = s_oTempData.oLookupImage_AdaptiveMeanSqr;
+        const cv::Mat_<float>& oLookupImage_AdaptiveMeanMix = s_oTempData.oLookupImage_AdaptiveMeanMix;
         for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
             for(int nColIdx = 0; nColIdx<nCols; ++nColIdx) {
                 const int nOffsetRowIdx = nRowIdx+pretrained::anRP1[nLUTIdx*2];
                 const int nOffsetColIdx = nColIdx+pretrained::anRP1[nLUTIdx*2+1];
                 if(nOffsetRowIdx>0 && nOffsetRowIdx<nRows && nOffsetColIdx>0 && nOffsetColIdx<nCols) {
-                    const float fCorrSurfDenom = std::sqrt((m_oImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)) * (m_oLookupImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)));
-                    const float fVisDiff = m_oLookupImage_AdaptiveMeanMix(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx);
+                    const float fCorrSurfDenom = std::sqrt((m_oImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)) * (oLookupImage_AdaptiveMeanSqr(nOffsetRowIdx,nOffsetColIdx)-oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)));
+                    const float fVisDiff = oLookupImage_AdaptiveMeanMix(nOffsetRowIdx,nOffsetColIdx)-m_oImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx)*oLookupImage_AdaptiveMean(nOffsetRowIdx,nOffsetColIdx);
                     oDescriptors(nRowIdx,nColIdx,nLUTIdx) = fCorrSurfDenom>LOCAL_EPS?std::min(std::exp(-(1-(fVisDiff)/fCorrSurfDenom)*2),1.0f):1.0f;
                 }
                 else
@@ -445,6 +489,9 @@ void DASC::dasc_gf_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
             }
         }
     }
+#if USING_OPENMP
+    #pragma omp parallel for
+#endif //USING_OPENMP
     for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
         for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
             cv::Mat_<float> oCurrDesc(1,(int)pretrained::nLUTSize,oDescriptors.ptr<float>(nRowIdx,nColIdx));
@@ -455,4 +502,4 @@ void DASC::dasc_gf_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
                 oCurrDesc = std::sqrt(1.0f/pretrained::nLUTSize);
         }
     }
-}
\ No newline at end of file
+}
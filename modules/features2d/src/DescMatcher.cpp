@@ -0,0 +1,327 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d/DescMatcher.hpp"
+
+namespace {
+
+    /// number of query descriptors compared together against each train descriptor (register blocking)
+    constexpr int s_nQueryTile = 4;
+    /// number of query descriptors in each parallel work item
+    constexpr int s_nQueryBlock = 64;
+    /// approximate size (in bytes) of the train descriptor blocks kept in cache while a query block is processed
+    constexpr size_t s_nTrainBlockBytes = size_t(128*1024);
+
+    /// raw view on a descriptor set (one descriptor per row, 'nDescSize' in elements for float sets, or in bytes for binary sets)
+    struct DescSet {
+        const uchar* pData;
+        size_t nStep;
+        int nDescCount;
+        int nDescSize;
+        inline const uchar* desc(int nDescIdx) const {return pData+size_t(nDescIdx)*nStep;}
+    };
+
+    /// returns a raw view on a descriptor set/map, validating its layout for the given distance type
+    DescSet getDescSet(const cv::Mat& oDescs, DescMatcher::DistType eDist) {
+        lvAssert_(oDescs.dims==2 || oDescs.dims==3,"unexpected descriptor matrix dim count");
+        lvAssert_(eDist==DescMatcher::Dist_Hamming || oDescs.type()==CV_32FC1,"L1/L2 distances require single-channel float descriptors");
+        DescSet oSet;
+        oSet.pData = oDescs.data;
+        if(oDescs.dims==2) {
+            oSet.nStep = oDescs.step[0];
+            oSet.nDescCount = oDescs.rows;
+            oSet.nDescSize = (eDist==DescMatcher::Dist_Hamming)?int(oDescs.cols*oDescs.elemSize()):oDescs.cols;
+        }
+        else {
+            lvAssert_(oDescs.isContinuous(),"descriptor maps must be continuous");
+            oSet.nStep = oDescs.step[1];
+            oSet.nDescCount = oDescs.size[0]*oDescs.size[1];
+            oSet.nDescSize = (eDist==DescMatcher::Dist_Hamming)?int(oDescs.size[2]*oDescs.elemSize()):oDescs.size[2];
+        }
+        return oSet;
+    }
+
+    /// distance kernel type; computes the distances between 'nQueries' query descriptors and a single train descriptor
+    template<int nQueries>
+    using KernelFunc = void(*)(const uchar* const* apQueries, const uchar* pTrain, int nDescSize, float* afDists);
+
+    /// computes the L1 or L2 distances between a few float query descriptors and a single train descriptor
+    template<bool bL2, int nQueries>
+    void calcDists_float(const uchar* const* apQueries, const uchar* pTrain, int nDescSize, float* afDists) {
+        const float* aTrain = (const float*)pTrain;
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+            const float* aQuery = (const float*)apQueries[nQueryIdx];
+            float fAccum = 0.0f;
+        #if USING_OPENMP
+            #pragma omp simd reduction(+:fAccum)
+        #endif //USING_OPENMP
+            for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+                const float fDiff = aQuery[nBinIdx]-aTrain[nBinIdx];
+                fAccum += bL2?fDiff*fDiff:std::abs(fDiff);
+            }
+            afDists[nQueryIdx] = bL2?std::sqrt(fAccum):fAccum;
+        }
+    }
+
+    /// computes the L1 or L2 distance between two float descriptors with double accumulation (same precision as cv::norm, for one-to-one distances)
+    template<bool bL2>
+    float calcDist_float_double(const float* aDesc1, const float* aDesc2, int nDescSize) {
+        double dAccum = 0.0;
+    #if USING_OPENMP
+        #pragma omp simd reduction(+:dAccum)
+    #endif //USING_OPENMP
+        for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+            const double dDiff = double(aDesc1[nBinIdx])-double(aDesc2[nBinIdx]);
+            dAccum += bL2?dDiff*dDiff:std::abs(dDiff);
+        }
+        return float(bL2?std::sqrt(dAccum):dAccum);
+    }
+
+    /// computes the Hamming distances between a few binary query descriptors and a single train descriptor
+    template<int nQueries>
+    void calcDists_hamming(const uchar* const* apQueries, const uchar* pTrain, int nDescSize, float* afDists) {
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+            const uchar* aQuery = apQueries[nQueryIdx];
+            int nDist = 0, nByteIdx = 0;
+            for(; nByteIdx+4<=nDescSize; nByteIdx+=4) {
+                uint32_t nWord1, nWord2;
+                std::memcpy(&nWord1,aQuery+nByteIdx,4);
+                std::memcpy(&nWord2,pTrain+nByteIdx,4);
+                nDist += lv::hdist<uint32_t,int>(nWord1,nWord2);
+            }
+            for(; nByteIdx<nDescSize; ++nByteIdx)
+                nDist += lv::hdist<uchar,int>(aQuery[nByteIdx],pTrain[nByteIdx]);
+            afDists[nQueryIdx] = float(nDist);
+        }
+    }
+
+#if HAVE_AVX2
+
+    /// returns the sum of all lanes of an 8-float register
+    inline float hsum_avx2(__m256 vVal) {
+        const __m128 vSum4 = _mm_add_ps(_mm256_castps256_ps128(vVal),_mm256_extractf128_ps(vVal,1));
+        const __m128 vSum2 = _mm_add_ps(vSum4,_mm_movehl_ps(vSum4,vSum4));
+        return _mm_cvtss_f32(_mm_add_ss(vSum2,_mm_shuffle_ps(vSum2,vSum2,1)));
+    }
+
+    /// computes the L1 or L2 distances between a few float query descriptors and a single train descriptor (avx2 version)
+    template<bool bL2, int nQueries>
+    void calcDists_float_avx2(const uchar* const* apQueries, const uchar* pTrain, int nDescSize, float* afDists) {
+        const float* aTrain = (const float*)pTrain;
+        const __m256 vAbsMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        __m256 avAccum[nQueries];
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx)
+            avAccum[nQueryIdx] = _mm256_setzero_ps();
+        int nBinIdx = 0;
+        for(; nBinIdx+8<=nDescSize; nBinIdx+=8) {
+            const __m256 vTrain = _mm256_loadu_ps(aTrain+nBinIdx); // loaded once for the whole query tile
+            for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+                const __m256 vDiff = _mm256_sub_ps(_mm256_loadu_ps(((const float*)apQueries[nQueryIdx])+nBinIdx),vTrain);
+                avAccum[nQueryIdx] = bL2?_mm256_fmadd_ps(vDiff,vDiff,avAccum[nQueryIdx]):_mm256_add_ps(avAccum[nQueryIdx],_mm256_and_ps(vDiff,vAbsMask));
+            }
+        }
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+            const float* aQuery = (const float*)apQueries[nQueryIdx];
+            float fAccum = hsum_avx2(avAccum[nQueryIdx]);
+            for(int nTailIdx=nBinIdx; nTailIdx<nDescSize; ++nTailIdx) {
+                const float fDiff = aQuery[nTailIdx]-aTrain[nTailIdx];
+                fAccum += bL2?fDiff*fDiff:std::abs(fDiff);
+            }
+            afDists[nQueryIdx] = bL2?std::sqrt(fAccum):fAccum;
+        }
+    }
+
+    /// computes the Hamming distances between a few binary query descriptors and a single train descriptor (avx2 version, via nibble LUT popcount)
+    template<int nQueries>
+    void calcDists_hamming_avx2(const uchar* const* apQueries, const uchar* pTrain, int nDescSize, float* afDists) {
+        const __m256i vPopcntLUT = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m256i vLowMask = _mm256_set1_epi8(0x0F);
+        __m256i avAccum[nQueries];
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx)
+            avAccum[nQueryIdx] = _mm256_setzero_si256();
+        int nByteIdx = 0;
+        for(; nByteIdx+32<=nDescSize; nByteIdx+=32) {
+            const __m256i vTrain = _mm256_loadu_si256((const __m256i*)(pTrain+nByteIdx));
+            for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+                const __m256i vXor = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(apQueries[nQueryIdx]+nByteIdx)),vTrain);
+                const __m256i vPopcnt = _mm256_add_epi8(_mm256_shuffle_epi8(vPopcntLUT,_mm256_and_si256(vXor,vLowMask)),
+                                                        _mm256_shuffle_epi8(vPopcntLUT,_mm256_and_si256(_mm256_srli_epi16(vXor,4),vLowMask)));
+                avAccum[nQueryIdx] = _mm256_add_epi64(avAccum[nQueryIdx],_mm256_sad_epu8(vPopcnt,_mm256_setzero_si256()));
+            }
+        }
+        for(int nQueryIdx=0; nQueryIdx<nQueries; ++nQueryIdx) {
+            alignas(32) std::array<int64_t,4> anSums;
+            _mm256_store_si256((__m256i*)anSums.data(),avAccum[nQueryIdx]);
+            int nDist = int(anSums[0]+anSums[1]+anSums[2]+anSums[3]);
+            if(nByteIdx<nDescSize) {
+                const uchar* apTailQuery[1] = {apQueries[nQueryIdx]+nByteIdx};
+                float fTailDist;
+                calcDists_hamming<1>(apTailQuery,pTrain+nByteIdx,nDescSize-nByteIdx,&fTailDist);
+                nDist += int(fTailDist);
+            }
+            afDists[nQueryIdx] = float(nDist);
+        }
+    }
+
+#endif //HAVE_AVX2
+
+    /// returns the single-query and full-tile distance kernels to use for the given distance type & instruction set
+    std::pair<KernelFunc<1>,KernelFunc<s_nQueryTile>> getKernels(DescMatcher::DistType eDist, lv::SIMDInstrSet eInstrSet) {
+    #if HAVE_AVX2
+        if(eInstrSet==lv::SIMD_AVX2) {
+            if(eDist==DescMatcher::Dist_L1)
+                return {&calcDists_float_avx2<false,1>,&calcDists_float_avx2<false,s_nQueryTile>};
+            else if(eDist==DescMatcher::Dist_L2)
+                return {&calcDists_float_avx2<true,1>,&calcDists_float_avx2<true,s_nQueryTile>};
+            return {&calcDists_hamming_avx2<1>,&calcDists_hamming_avx2<s_nQueryTile>};
+        }
+    #else //!HAVE_AVX2
+        lvIgnore(eInstrSet);
+    #endif //!HAVE_AVX2
+        if(eDist==DescMatcher::Dist_L1)
+            return {&calcDists_float<false,1>,&calcDists_float<false,s_nQueryTile>};
+        else if(eDist==DescMatcher::Dist_L2)
+            return {&calcDists_float<true,1>,&calcDists_float<true,s_nQueryTile>};
+        return {&calcDists_hamming<1>,&calcDists_hamming<s_nQueryTile>};
+    }
+
+    /// computes all query-train descriptor distances in cache-friendly tiles, forwarding each one to 'lDistHandler(nQueryIdx,nTrainIdx,fDist)'
+    /// (each query is handled by a single thread, and its train descriptors are always visited in increasing index order)
+    template<typename TDistHandler>
+    void calcAllDists(const DescSet& oQuerySet, const DescSet& oTrainSet, DescMatcher::DistType eDist, lv::SIMDInstrSet eInstrSet, TDistHandler&& lDistHandler) {
+        const auto lKernels = getKernels(eDist,eInstrSet);
+        const int nDescSize = oQuerySet.nDescSize;
+        const size_t nDescBytes = (eDist==DescMatcher::Dist_Hamming)?size_t(nDescSize):size_t(nDescSize)*sizeof(float);
+        const int nTrainBlockSize = std::max(int(s_nTrainBlockBytes/std::max(nDescBytes,size_t(1))),16);
+        const int nQueryBlocks = (oQuerySet.nDescCount+s_nQueryBlock-1)/s_nQueryBlock;
+    #if USING_OPENMP
+        #pragma omp parallel for schedule(dynamic) if(nQueryBlocks>1)
+    #endif //USING_OPENMP
+        for(int nQueryBlockIdx=0; nQueryBlockIdx<nQueryBlocks; ++nQueryBlockIdx) {
+            const int nQueryBlockBegin = nQueryBlockIdx*s_nQueryBlock;
+            const int nQueryBlockEnd = std::min(nQueryBlockBegin+s_nQueryBlock,oQuerySet.nDescCount);
+            for(int nTrainBlockBegin=0; nTrainBlockBegin<oTrainSet.nDescCount; nTrainBlockBegin+=nTrainBlockSize) {
+                const int nTrainBlockEnd = std::min(nTrainBlockBegin+nTrainBlockSize,oTrainSet.nDescCount);
+                for(int nQueryTileBegin=nQueryBlockBegin; nQueryTileBegin<nQueryBlockEnd; nQueryTileBegin+=s_nQueryTile) {
+                    const int nTileQueries = std::min(s_nQueryTile,nQueryBlockEnd-nQueryTileBegin);
+                    std::array<const uchar*,s_nQueryTile> apQueries;
+                    for(int nQueryIdx=0; nQueryIdx<nTileQueries; ++nQueryIdx)
+                        apQueries[nQueryIdx] = oQuerySet.desc(nQueryTileBegin+nQueryIdx);
+                    std::array<float,s_nQueryTile> afDists;
+                    for(int nTrainIdx=nTrainBlockBegin; nTrainIdx<nTrainBlockEnd; ++nTrainIdx) {
+                        const uchar* pTrain = oTrainSet.desc(nTrainIdx);
+                        if(nTileQueries==s_nQueryTile)
+                            lKernels.second(apQueries.data(),pTrain,nDescSize,afDists.data());
+                        else
+                            for(int nQueryIdx=0; nQueryIdx<nTileQueries; ++nQueryIdx)
+                                lKernels.first(apQueries.data()+nQueryIdx,pTrain,nDescSize,afDists.data()+nQueryIdx);
+                        for(int nQueryIdx=0; nQueryIdx<nTileQueries; ++nQueryIdx)
+                            lDistHandler(nQueryTileBegin+nQueryIdx,nTrainIdx,afDists[nQueryIdx]);
+                    }
+                }
+            }
+        }
+    }
+
+} // anonymous namespace
+
+DescMatcher::DescMatcher(DistType eDist) :
+        m_eDist(eDist),
+        m_eInstrSet(lv::SIMD_None) {
+    lvAssert_(eDist==Dist_L1 || eDist==Dist_L2 || eDist==Dist_Hamming,"unknown distance type");
+    setInstrSet(lv::getBestSIMDInstrSet());
+}
+
+void DescMatcher::setInstrSet(lv::SIMDInstrSet eInstrSet) {
+    m_eInstrSet = (eInstrSet>=lv::SIMD_AVX2 && lv::isSIMDSupported(lv::SIMD_AVX2))?lv::SIMD_AVX2:lv::SIMD_None;
+}
+
+void DescMatcher::calcDistances(const cv::Mat& oDescriptors1, const cv::Mat& oDescriptors2, cv::Mat_<float>& oDistances) const {
+    lvAssert_(oDescriptors1.dims==oDescriptors2.dims && oDescriptors1.size==oDescriptors2.size && oDescriptors1.type()==oDescriptors2.type(),"descriptor mat sizes/types mismatch");
+    const DescSet oSet1 = getDescSet(oDescriptors1,m_eDist), oSet2 = getDescSet(oDescriptors2,m_eDist);
+    if(oDescriptors1.dims==2)
+        oDistances.create(oDescriptors1.rows,1);
+    else
+        oDistances.create(oDescriptors1.size[0],oDescriptors1.size[1]);
+    lvDbgAssert(oDistances.isContinuous() && int(oDistances.total())==oSet1.nDescCount);
+    const KernelFunc<1> pKernel = getKernels(m_eDist,m_eInstrSet).first;
+    const int nDescCount = oSet1.nDescCount;
+#if USING_OPENMP
+    #pragma omp parallel for if(nDescCount>1024)
+#endif //USING_OPENMP
+    for(int nDescIdx=0; nDescIdx<nDescCount; ++nDescIdx) {
+        float* pDist = ((float*)oDistances.data)+nDescIdx;
+        // each pair is only visited once here (memory-bound), so L1/L2 sums keep the double accumulation of cv::norm
+        if(m_eDist==Dist_L1)
+            *pDist = calcDist_float_double<false>((const float*)oSet1.desc(nDescIdx),(const float*)oSet2.desc(nDescIdx),oSet1.nDescSize);
+        else if(m_eDist==Dist_L2)
+            *pDist = calcDist_float_double<true>((const float*)oSet1.desc(nDescIdx),(const float*)oSet2.desc(nDescIdx),oSet1.nDescSize);
+        else {
+            const uchar* apDesc1[1] = {oSet1.desc(nDescIdx)};
+            pKernel(apDesc1,oSet2.desc(nDescIdx),oSet1.nDescSize,pDist);
+        }
+    }
+}
+
+void DescMatcher::calcDistanceMatrix(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, cv::Mat_<float>& oDistances) const {
+    lvAssert_(!oQueryDescs.empty() && !oTrainDescs.empty(),"descriptor sets must be non-empty");
+    lvAssert_(oQueryDescs.type()==oTrainDescs.type(),"descriptor mat types mismatch");
+    const DescSet oQuerySet = getDescSet(oQueryDescs,m_eDist), oTrainSet = getDescSet(oTrainDescs,m_eDist);
+    lvAssert_(oQuerySet.nDescSize==oTrainSet.nDescSize,"descriptor sizes mismatch");
+    oDistances.create(oQuerySet.nDescCount,oTrainSet.nDescCount);
+    calcAllDists(oQuerySet,oTrainSet,m_eDist,m_eInstrSet,[&](int nQueryIdx, int nTrainIdx, float fDist) {
+        oDistances(nQueryIdx,nTrainIdx) = fDist;
+    });
+}
+
+void DescMatcher::knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, cv::Mat_<int>& oIndices, cv::Mat_<float>& oDistances) const {
+    lvAssert_(nK>=1,"neighbour count must be positive");
+    lvAssert_(!oQueryDescs.empty() && !oTrainDescs.empty(),"descriptor sets must be non-empty");
+    lvAssert_(oQueryDescs.type()==oTrainDescs.type(),"descriptor mat types mismatch");
+    const DescSet oQuerySet = getDescSet(oQueryDescs,m_eDist), oTrainSet = getDescSet(oTrainDescs,m_eDist);
+    lvAssert_(oQuerySet.nDescSize==oTrainSet.nDescSize,"descriptor sizes mismatch");
+    oIndices.create(oQuerySet.nDescCount,nK);
+    oDistances.create(oQuerySet.nDescCount,nK);
+    oIndices = -1;
+    oDistances = std::numeric_limits<float>::infinity();
+    calcAllDists(oQuerySet,oTrainSet,m_eDist,m_eInstrSet,[&](int nQueryIdx, int nTrainIdx, float fDist) {
+        float* afBestDists = oDistances.ptr<float>(nQueryIdx);
+        if(!(fDist<afBestDists[nK-1]))
+            return; // most train descs are rejected here, without touching the sorted list
+        int* anBestIdxs = oIndices.ptr<int>(nQueryIdx);
+        int nInsertIdx = nK-1;
+        for(; nInsertIdx>0 && fDist<afBestDists[nInsertIdx-1]; --nInsertIdx) {
+            afBestDists[nInsertIdx] = afBestDists[nInsertIdx-1];
+            anBestIdxs[nInsertIdx] = anBestIdxs[nInsertIdx-1];
+        }
+        afBestDists[nInsertIdx] = fDist;
+        anBestIdxs[nInsertIdx] = nTrainIdx;
+    });
+}
+
+void DescMatcher::knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const {
+    static thread_local cv::Mat_<int> s_oIndices;
+    static thread_local cv::Mat_<float> s_oDistances;
+    knnMatch(oQueryDescs,oTrainDescs,nK,s_oIndices,s_oDistances);
+    vvMatches.resize(size_t(s_oIndices.rows));
+    for(int nQueryIdx=0; nQueryIdx<s_oIndices.rows; ++nQueryIdx) {
+        std::vector<cv::DMatch>& vMatches = vvMatches[nQueryIdx];
+        vMatches.clear();
+        for(int nNeighbIdx=0; nNeighbIdx<nK && s_oIndices(nQueryIdx,nNeighbIdx)>=0; ++nNeighbIdx)
+            vMatches.emplace_back(nQueryIdx,s_oIndices(nQueryIdx,nNeighbIdx),s_oDistances(nQueryIdx,nNeighbIdx));
+    }
+}
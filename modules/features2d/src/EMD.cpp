@@ -0,0 +1,282 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d/EMD.hpp"
+
+namespace {
+
+    /// number of histogram pairs solved together (interleaved in scratch buffers, so that products vectorize across pairs)
+    constexpr int s_nBlockPairs = 8;
+
+    /// computes M*X for a row-major NxN matrix M and a block of interleaved N-dim vectors X (one per pair)
+    inline void sinkhorn_matvec(const double* pMat, const double* pInput, double* pOutput, int nBins) {
+        for(int nRowIdx=0; nRowIdx<nBins; ++nRowIdx) {
+            const double* pMatRow = pMat+nRowIdx*nBins;
+            double* pOutputRow = pOutput+nRowIdx*s_nBlockPairs;
+            std::fill_n(pOutputRow,s_nBlockPairs,0.0);
+            for(int nColIdx=0; nColIdx<nBins; ++nColIdx) {
+                const double dVal = pMatRow[nColIdx];
+                const double* pInputRow = pInput+nColIdx*s_nBlockPairs;
+            #if USING_OPENMP
+                #pragma omp simd // otherwise, some compilers vectorize along matrix rows instead (much slower)
+            #endif //USING_OPENMP
+                for(int nPairIdx=0; nPairIdx<s_nBlockPairs; ++nPairIdx)
+                    pOutputRow[nPairIdx] += dVal*pInputRow[nPairIdx];
+            }
+        }
+    }
+
+#if HAVE_AVX2
+    /// computes M*X for a row-major NxN matrix M and a block of interleaved N-dim vectors X (one per pair, avx2 version)
+    void sinkhorn_matvec_avx2(const double* pMat, const double* pInput, double* pOutput, int nBins) {
+        static_assert(s_nBlockPairs==8,"avx2 impl expects two registers per interleaved bin");
+        constexpr int nRowStep = 4; // rows processed together, to break up the accumulation dependency chains
+        int nRowIdx = 0;
+        for(; nRowIdx+nRowStep<=nBins; nRowIdx+=nRowStep) {
+            const double* pMatRow = pMat+nRowIdx*nBins;
+            __m256d avAccum[nRowStep*2];
+            for(int nAccumIdx=0; nAccumIdx<nRowStep*2; ++nAccumIdx)
+                avAccum[nAccumIdx] = _mm256_setzero_pd();
+            for(int nColIdx=0; nColIdx<nBins; ++nColIdx) {
+                const __m256d vInputLo = _mm256_loadu_pd(pInput+nColIdx*s_nBlockPairs);
+                const __m256d vInputHi = _mm256_loadu_pd(pInput+nColIdx*s_nBlockPairs+4);
+                for(int nStepIdx=0; nStepIdx<nRowStep; ++nStepIdx) {
+                    const __m256d vVal = _mm256_broadcast_sd(pMatRow+nStepIdx*nBins+nColIdx);
+                    avAccum[nStepIdx*2] = _mm256_fmadd_pd(vVal,vInputLo,avAccum[nStepIdx*2]);
+                    avAccum[nStepIdx*2+1] = _mm256_fmadd_pd(vVal,vInputHi,avAccum[nStepIdx*2+1]);
+                }
+            }
+            for(int nStepIdx=0; nStepIdx<nRowStep; ++nStepIdx) {
+                _mm256_storeu_pd(pOutput+(nRowIdx+nStepIdx)*s_nBlockPairs,avAccum[nStepIdx*2]);
+                _mm256_storeu_pd(pOutput+(nRowIdx+nStepIdx)*s_nBlockPairs+4,avAccum[nStepIdx*2+1]);
+            }
+        }
+        for(; nRowIdx<nBins; ++nRowIdx) {
+            const double* pMatRow = pMat+nRowIdx*nBins;
+            __m256d vAccumLo = _mm256_setzero_pd(), vAccumHi = _mm256_setzero_pd();
+            for(int nColIdx=0; nColIdx<nBins; ++nColIdx) {
+                const __m256d vVal = _mm256_broadcast_sd(pMatRow+nColIdx);
+                vAccumLo = _mm256_fmadd_pd(vVal,_mm256_loadu_pd(pInput+nColIdx*s_nBlockPairs),vAccumLo);
+                vAccumHi = _mm256_fmadd_pd(vVal,_mm256_loadu_pd(pInput+nColIdx*s_nBlockPairs+4),vAccumHi);
+            }
+            _mm256_storeu_pd(pOutput+nRowIdx*s_nBlockPairs,vAccumLo);
+            _mm256_storeu_pd(pOutput+nRowIdx*s_nBlockPairs+4,vAccumHi);
+        }
+    }
+#endif //HAVE_AVX2
+
+} // anonymous namespace
+
+SinkhornEMD::SinkhornEMD(const cv::Mat_<float>& oCostMap, double dRegRatio, double dTolerance, int nMaxIters) :
+        m_nBins(oCostMap.rows),
+        m_nPaddedBins(oCostMap.rows+1),
+        m_dTolerance(dTolerance),
+        m_nMaxIters(nMaxIters),
+        m_eInstrSet(lv::SIMD_None) {
+    lvAssert_(!oCostMap.empty() && oCostMap.dims==2 && oCostMap.rows==oCostMap.cols,"bad emd cost map size");
+    lvAssert_(dRegRatio>=0.005 && dRegRatio<=1.0,"regularization ratio must be in [0.005,1] (smaller values underflow the kernel)");
+    lvAssert_(dTolerance>0.0 && dTolerance<1.0,"marginal violation tolerance must be in ]0,1[");
+    lvAssert_(nMaxIters>=1,"max iteration count must be positive");
+    double dMinCost;
+    cv::minMaxIdx(oCostMap,&dMinCost,&m_dMaxCost);
+    lvAssert_(dMinCost>=0.0 && m_dMaxCost>0.0,"emd cost map must be non-negative and non-null");
+    m_dReg = dRegRatio*m_dMaxCost;
+    const size_t nPaddedSize = size_t(m_nPaddedBins)*m_nPaddedBins;
+    m_vdCosts.assign(nPaddedSize,0.0); // dummy row/col (last) carries unmatched mass for free
+    for(int nRowIdx=0; nRowIdx<m_nBins; ++nRowIdx)
+        for(int nColIdx=0; nColIdx<m_nBins; ++nColIdx)
+            m_vdCosts[nRowIdx*m_nPaddedBins+nColIdx] = (double)oCostMap(nRowIdx,nColIdx);
+    m_vdKernel.resize(nPaddedSize);
+    m_vdKernelT.resize(nPaddedSize);
+    m_vdCostKernel.resize(nPaddedSize);
+    for(int nRowIdx=0; nRowIdx<m_nPaddedBins; ++nRowIdx) {
+        for(int nColIdx=0; nColIdx<m_nPaddedBins; ++nColIdx) {
+            const size_t nIdx = size_t(nRowIdx)*m_nPaddedBins+nColIdx;
+            m_vdKernel[nIdx] = std::exp(-m_vdCosts[nIdx]/m_dReg);
+            m_vdKernelT[size_t(nColIdx)*m_nPaddedBins+nRowIdx] = m_vdKernel[nIdx];
+            m_vdCostKernel[nIdx] = m_vdCosts[nIdx]*m_vdKernel[nIdx];
+        }
+    }
+    setInstrSet(lv::getBestSIMDInstrSet());
+}
+
+void SinkhornEMD::setInstrSet(lv::SIMDInstrSet eInstrSet) {
+    m_eInstrSet = (eInstrSet>=lv::SIMD_AVX2 && lv::isSIMDSupported(lv::SIMD_AVX2))?lv::SIMD_AVX2:lv::SIMD_None;
+}
+
+double SinkhornEMD::compute(const float* aHist1, const float* aHist2, double* pdErrorBound) const {
+    double dDist;
+    computeBlock(&aHist1,&aHist2,size_t(1),&dDist,pdErrorBound);
+    return dDist;
+}
+
+double SinkhornEMD::compute(const cv::Mat_<float>& oHist1, const cv::Mat_<float>& oHist2, double* pdErrorBound) const {
+    lvAssert_(oHist1.isContinuous() && oHist2.isContinuous() && oHist1.total()==size_t(m_nBins) && oHist2.total()==size_t(m_nBins),"bad histogram size");
+    return compute(oHist1.ptr<float>(0),oHist2.ptr<float>(0),pdErrorBound);
+}
+
+void SinkhornEMD::compute(const float* const* apHists1, const float* const* apHists2, size_t nPairs, double* adDists, double* adErrorBounds) const {
+    lvAssert_(nPairs==0 || (apHists1 && apHists2 && adDists),"bad input/output pointers");
+    const int nBlocks = int((nPairs+s_nBlockPairs-1)/s_nBlockPairs);
+#if USING_OPENMP
+    #pragma omp parallel for if(nBlocks>1)
+#endif //USING_OPENMP
+    for(int nBlockIdx=0; nBlockIdx<nBlocks; ++nBlockIdx) {
+        const size_t nOffset = size_t(nBlockIdx)*s_nBlockPairs;
+        computeBlock(apHists1+nOffset,apHists2+nOffset,std::min(nPairs-nOffset,size_t(s_nBlockPairs)),
+                     adDists+nOffset,adErrorBounds?adErrorBounds+nOffset:nullptr);
+    }
+}
+
+void SinkhornEMD::compute(const cv::Mat_<float>& oHists1, const cv::Mat_<float>& oHists2, std::vector<double>& vdDists) const {
+    lvAssert_(oHists1.dims==2 && oHists1.size==oHists2.size && oHists1.cols==m_nBins,"bad histogram matrix sizes");
+    std::vector<const float*> vpHists1(oHists1.rows), vpHists2(oHists2.rows);
+    for(int nRowIdx=0; nRowIdx<oHists1.rows; ++nRowIdx) {
+        vpHists1[nRowIdx] = oHists1.ptr<float>(nRowIdx);
+        vpHists2[nRowIdx] = oHists2.ptr<float>(nRowIdx);
+    }
+    vdDists.resize(oHists1.rows);
+    compute(vpHists1.data(),vpHists2.data(),vdDists.size(),vdDists.data());
+}
+
+double SinkhornEMD::getMaxError() const {
+    return m_dReg*std::log(double(m_nPaddedBins))+3*m_dTolerance*m_dMaxCost;
+}
+
+void SinkhornEMD::computeBlock(const float* const* apHists1, const float* const* apHists2, size_t nPairs, double* adDists, double* adErrorBounds) const {
+    lvDbgAssert(nPairs>=1 && nPairs<=size_t(s_nBlockPairs));
+    const int nBins = m_nPaddedBins;
+    const size_t nBlockSize = size_t(nBins)*s_nBlockPairs;
+    static thread_local lv::AutoBuffer<double> s_adBlockData;
+    s_adBlockData.resize(nBlockSize*8);
+    double* const adMarg1 = s_adBlockData.data(); // row marginals (normalized first histograms)
+    double* const adMarg2 = adMarg1+nBlockSize; // col marginals (normalized second histograms)
+    double* const adU = adMarg2+nBlockSize; // row scaling vectors
+    double* const adV = adU+nBlockSize; // col scaling vectors
+    double* const adKV = adV+nBlockSize; // kernel-col scaling products (also used to fetch row marginals of current plans)
+    double* const adKtU = adKV+nBlockSize; // kernel-row scaling products
+    double* const adTemp1 = adKtU+nBlockSize; // scratch vectors for plan rounding
+    double* const adTemp2 = adTemp1+nBlockSize;
+    const lv::SIMDInstrSet eInstrSet = m_eInstrSet;
+    const auto lMatVec = [&](const std::vector<double>& vdMat, const double* pInput, double* pOutput) {
+    #if HAVE_AVX2
+        if(eInstrSet==lv::SIMD_AVX2) {
+            sinkhorn_matvec_avx2(vdMat.data(),pInput,pOutput,nBins);
+            return;
+        }
+    #endif //HAVE_AVX2
+        sinkhorn_matvec(vdMat.data(),pInput,pOutput,nBins);
+    };
+    std::array<double,s_nBlockPairs> adViolation;
+    std::array<bool,s_nBlockPairs> abActive, abValid;
+    for(int nPairIdx=0; nPairIdx<s_nBlockPairs; ++nPairIdx) {
+        // padding pairs (past nPairs) only duplicate the first one, and are never iterated
+        const float* aHist1 = apHists1[(size_t(nPairIdx)<nPairs)?nPairIdx:0];
+        const float* aHist2 = apHists2[(size_t(nPairIdx)<nPairs)?nPairIdx:0];
+        double dMass1 = 0.0, dMass2 = 0.0;
+        for(int nBinIdx=0; nBinIdx<m_nBins; ++nBinIdx) {
+            lvDbgAssert(aHist1[nBinIdx]>=0.0f && aHist2[nBinIdx]>=0.0f);
+            dMass1 += aHist1[nBinIdx];
+            dMass2 += aHist2[nBinIdx];
+        }
+        lvDbgAssert_(dMass1>0.0 && dMass2>0.0,"emd cannot handle null histograms");
+        abValid[nPairIdx] = (dMass1>0.0 && dMass2>0.0);
+        abActive[nPairIdx] = abValid[nPairIdx] && size_t(nPairIdx)<nPairs;
+        adViolation[nPairIdx] = 0.0;
+        // like cv::EMD, costs are normalized by the largest mass (i.e. the total flow including the dummy bin)
+        const double dNormFactor = abValid[nPairIdx]?1.0/std::max(dMass1,dMass2):0.0;
+        for(int nBinIdx=0; nBinIdx<m_nBins; ++nBinIdx) {
+            adMarg1[nBinIdx*s_nBlockPairs+nPairIdx] = aHist1[nBinIdx]*dNormFactor;
+            adMarg2[nBinIdx*s_nBlockPairs+nPairIdx] = aHist2[nBinIdx]*dNormFactor;
+        }
+        adMarg1[m_nBins*s_nBlockPairs+nPairIdx] = std::max(dMass2-dMass1,0.0)*dNormFactor;
+        adMarg2[m_nBins*s_nBlockPairs+nPairIdx] = std::max(dMass1-dMass2,0.0)*dNormFactor;
+    }
+    std::fill_n(adU,nBlockSize,1.0);
+    std::fill_n(adV,nBlockSize,1.0);
+    for(int nIterIdx=0;; ++nIterIdx) {
+        // cols of the current plans always match their marginals; rows are checked via the upcoming u-update product
+        lMatVec(m_vdKernel,adV,adKV);
+        bool bAnyActive = false;
+        if(nIterIdx>0) {
+            for(int nPairIdx=0; nPairIdx<s_nBlockPairs; ++nPairIdx) {
+                if(!abActive[nPairIdx])
+                    continue;
+                double dViolation = 0.0;
+                for(int nBinIdx=0; nBinIdx<nBins; ++nBinIdx) {
+                    const size_t nIdx = size_t(nBinIdx)*s_nBlockPairs+nPairIdx;
+                    dViolation += std::abs(adU[nIdx]*adKV[nIdx]-adMarg1[nIdx]);
+                }
+                adViolation[nPairIdx] = dViolation;
+                abActive[nPairIdx] = (dViolation>m_dTolerance);
+                bAnyActive |= abActive[nPairIdx];
+            }
+        }
+        else
+            bAnyActive = std::any_of(abActive.begin(),abActive.end(),[](bool b){return b;});
+        if(!bAnyActive || nIterIdx==m_nMaxIters)
+            break;
+        // converged pairs keep their scaling vectors, so the results do not depend on how pairs are grouped
+        for(int nBinIdx=0; nBinIdx<nBins; ++nBinIdx)
+            for(int nPairIdx=0; nPairIdx<s_nBlockPairs; ++nPairIdx) {
+                const size_t nIdx = size_t(nBinIdx)*s_nBlockPairs+nPairIdx;
+                adU[nIdx] = abActive[nPairIdx]?adMarg1[nIdx]/std::max(adKV[nIdx],DBL_MIN):adU[nIdx];
+            }
+        lMatVec(m_vdKernelT,adU,adKtU);
+        for(int nBinIdx=0; nBinIdx<nBins; ++nBinIdx)
+            for(int nPairIdx=0; nPairIdx<s_nBlockPairs; ++nPairIdx) {
+                const size_t nIdx = size_t(nBinIdx)*s_nBlockPairs+nPairIdx;
+                adV[nIdx] = abActive[nPairIdx]?adMarg2[nIdx]/std::max(adKtU[nIdx],DBL_MIN):adV[nIdx];
+            }
+    }
+    // rounding step: scale rows then cols down to their marginals, and spread the leftover mass as a rank-1 plan
+    for(size_t nIdx=0; nIdx<nBlockSize; ++nIdx) {
+        const double dRowMass = adU[nIdx]*adKV[nIdx];
+        adTemp1[nIdx] = (dRowMass>0.0)?adU[nIdx]*std::min(adMarg1[nIdx]/dRowMass,1.0):0.0; // x*u
+    }
+    lMatVec(m_vdKernelT,adTemp1,adKtU);
+    for(size_t nIdx=0; nIdx<nBlockSize; ++nIdx) {
+        const double dColMass = adV[nIdx]*adKtU[nIdx];
+        const double dColScale = (dColMass>0.0)?std::min(adMarg2[nIdx]/dColMass,1.0):0.0;
+        adTemp2[nIdx] = adV[nIdx]*dColScale; // y*v
+        adKtU[nIdx] = std::max(adMarg2[nIdx]-dColMass*dColScale,0.0); // leftover col mass
+    }
+    lMatVec(m_vdKernel,adTemp2,adKV);
+    for(size_t nIdx=0; nIdx<nBlockSize; ++nIdx)
+        adKV[nIdx] = std::max(adMarg1[nIdx]-adTemp1[nIdx]*adKV[nIdx],0.0); // leftover row mass
+    lMatVec(m_vdCostKernel,adTemp2,adU);
+    lMatVec(m_vdCosts,adKtU,adV);
+    for(int nPairIdx=0; nPairIdx<int(nPairs); ++nPairIdx) {
+        if(!abValid[nPairIdx]) {
+            adDists[nPairIdx] = 0.0;
+            if(adErrorBounds)
+                adErrorBounds[nPairIdx] = 0.0;
+            continue;
+        }
+        double dScaledCost = 0.0, dLeftoverCost = 0.0, dLeftoverMass = 0.0;
+        for(int nBinIdx=0; nBinIdx<nBins; ++nBinIdx) {
+            const size_t nIdx = size_t(nBinIdx)*s_nBlockPairs+nPairIdx;
+            dScaledCost += adTemp1[nIdx]*adU[nIdx];
+            dLeftoverCost += adKV[nIdx]*adV[nIdx];
+            dLeftoverMass += adKV[nIdx];
+        }
+        const double dCost = dScaledCost+((dLeftoverMass>0.0)?dLeftoverCost/dLeftoverMass:0.0);
+        adDists[nPairIdx] = dCost;
+        if(adErrorBounds)
+            adErrorBounds[nPairIdx] = m_dReg*std::log(double(nBins))+3*adViolation[nPairIdx]*m_dMaxCost;
+    }
+}
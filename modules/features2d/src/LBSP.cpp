@@ -28,14 +28,21 @@ LBSP::LBSP(size_t nThreshold) :
         m_bOnlyUsingAbsThreshold(true),
         m_fRelThreshold(0), // unused
         m_nThreshold(nThreshold),
-        m_oRefImage() {}
+        m_oRefImage(),
+        m_eInstrSet(lv::SIMD_None),
+        m_nBatchWorkerCount(0) {
+    setInstrSet(lv::getBestSIMDInstrSet());
+}
 
 LBSP::LBSP(float fRelThreshold, size_t nThresholdOffset) :
         m_bOnlyUsingAbsThreshold(false),
         m_fRelThreshold(fRelThreshold),
         m_nThreshold(nThresholdOffset),
-        m_oRefImage() {
+        m_oRefImage(),
+        m_eInstrSet(lv::SIMD_None),
+        m_nBatchWorkerCount(0) {
     lvAssert_(m_fRelThreshold>=0,"relative LBSP threshold must be non-negative");
+    setInstrSet(lv::getBestSIMDInstrSet());
 }
 
 void LBSP::read(const cv::FileNode& /*fn*/) {
@@ -97,56 +104,139 @@ size_t LBSP::getAbsThreshold() const {
     return m_nThreshold;
 }
 
+void LBSP::setInstrSet(lv::SIMDInstrSet eInstrSet) {
+    // dense impls only rely on SSE2 intrinsics for their 128-bit path
+    m_eInstrSet = (eInstrSet>=lv::SIMD_AVX2 && lv::isSIMDSupported(lv::SIMD_AVX2))?lv::SIMD_AVX2:
+                  (eInstrSet>=lv::SIMD_SSE2 && lv::isSIMDSupported(lv::SIMD_SSE2))?lv::SIMD_SSE2:
+                  lv::SIMD_None;
+}
+
 namespace {
 
-void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, cv::Mat& oDesc, size_t nThreshold) {
-    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
-    lvAssert_(!oInputImg.empty() && oInputImg.isContinuous() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3),"input image must be non-empty, continuous, and of type 8UC1/8UC3");
-    lvAssert_(oRefImg.empty() || (oRefImg.size==oInputImg.size && oRefImg.type()==oInputImg.type()),"ref image must be empty, or of the same size/type as the input image");
-    const size_t nChannels = (size_t)oInputImg.channels();
-    const cv::Mat& oRefMat = oRefImg.empty()?oInputImg:oRefImg;
-    const uchar t = cv::saturate_cast<uchar>((int)nThreshold);
-    if(nChannels==1) {
-        oDesc.create(oInputImg.size(),CV_16UC1);
-        for(int y=int(LBSP::PATCH_SIZE)/2; y<oInputImg.rows-int(LBSP::PATCH_SIZE)/2; ++y)
-            for(int x=int(LBSP::PATCH_SIZE)/2; x<oInputImg.cols-int(LBSP::PATCH_SIZE)/2; ++x)
-                LBSP::computeDescriptor<1>(oInputImg,oRefMat.at<uchar>(y,x),x,y,0,t,oDesc.at<ushort>(y,x));
+/// number of image rows described at once by a worker in dense impls
+constexpr int s_nDenseBandRows = 16;
+
+/// fills the per-intensity threshold lookup table used by dense impls (absolute threshold version)
+void lbsp_fillThresholdLUT(std::array<uchar,UCHAR_MAX+1>& anThresholdLUT, size_t nThreshold) {
+    anThresholdLUT.fill(cv::saturate_cast<uchar>((int)nThreshold));
+}
+
+/// fills the per-intensity threshold lookup table used by dense impls (relative threshold version)
+void lbsp_fillThresholdLUT(std::array<uchar,UCHAR_MAX+1>& anThresholdLUT, float fThreshold, size_t nThresholdOffset) {
+    lvAssert_(fThreshold>=0,"lbsp internal relative threshold must be non-negative");
+    for(size_t nRef=0; nRef<=UCHAR_MAX; ++nRef)
+        anThresholdLUT[nRef] = cv::saturate_cast<uchar>(uchar(nRef)*fThreshold+nThresholdOffset);
+}
+
+/// describes row elements [nElemIdx,nElems) one at a time; returns the index of the first element left undescribed (i.e. nElems)
+size_t lbsp_computeRow_scalar(const uchar* anInput, const uchar* anRef, const uchar* anThresholds, const std::array<ptrdiff_t,16>& anOffsets,
+                              size_t nElemIdx, size_t nElems, ushort* anDesc) {
+    for(; nElemIdx<nElems; ++nElemIdx) {
+        const uchar nRef = anRef[nElemIdx];
+        const uchar nThreshold = anThresholds[nElemIdx];
+        const uchar* const anCurrInput = anInput+nElemIdx;
+        ushort nDesc = 0;
+        for(size_t n=0; n<16; ++n)
+            nDesc |= ushort((lv::L1dist(anCurrInput[anOffsets[n]],nRef)>nThreshold)<<n);
+        anDesc[nElemIdx] = nDesc;
     }
-    else { //nChannels==3
-        oDesc.create(oInputImg.size(),CV_16UC3);
-        alignas(16) const std::array<uchar,3> anThreshold = {t,t,t};
-        for(int y=int(LBSP::PATCH_SIZE)/2; y<oInputImg.rows-int(LBSP::PATCH_SIZE)/2; ++y)
-            for(int x=int(LBSP::PATCH_SIZE)/2; x<oInputImg.cols-int(LBSP::PATCH_SIZE)/2; ++x)
-                LBSP::computeDescriptor(oInputImg,oRefMat.ptr<uchar>(y,x),x,y,anThreshold,oDesc.ptr<ushort>(y,x));
+    return nElemIdx;
+}
+
+#if HAVE_SSE2
+
+/// describes row elements by blocks of 16 starting at nElemIdx; returns the index of the first element left undescribed
+size_t lbsp_computeRow_sse2(const uchar* anInput, const uchar* anRef, const uchar* anThresholds, const std::array<ptrdiff_t,16>& anOffsets,
+                            size_t nElemIdx, size_t nElems, ushort* anDesc) {
+    const __m128i anZeros = _mm_setzero_si128();
+    for(; nElemIdx+16<=nElems; nElemIdx+=16) {
+        const __m128i anRefs = _mm_loadu_si128((__m128i*)(anRef+nElemIdx));
+        const __m128i anThres = _mm_loadu_si128((__m128i*)(anThresholds+nElemIdx));
+        __m128i anDescBytes[2] = {anZeros,anZeros};
+        for(int n=0; n<16; ++n) {
+            const __m128i anVals = _mm_loadu_si128((__m128i*)(anInput+nElemIdx+anOffsets[n]));
+            const __m128i anDists = _mm_sub_epi8(_mm_max_epu8(anVals,anRefs),_mm_min_epu8(anVals,anRefs));
+            // dist>thres <=> saturated (dist-thres)!=0
+            const __m128i abUnderThres = _mm_cmpeq_epi8(_mm_subs_epu8(anDists,anThres),anZeros);
+            anDescBytes[n/8] = _mm_or_si128(anDescBytes[n/8],_mm_andnot_si128(abUnderThres,_mm_set1_epi8(char(1<<(n%8)))));
+        }
+        _mm_storeu_si128((__m128i*)(anDesc+nElemIdx),_mm_unpacklo_epi8(anDescBytes[0],anDescBytes[1]));
+        _mm_storeu_si128((__m128i*)(anDesc+nElemIdx+8),_mm_unpackhi_epi8(anDescBytes[0],anDescBytes[1]));
     }
+    return nElemIdx;
 }
 
-void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, cv::Mat& oDesc, float fThreshold, size_t nThresholdOffset) {
-    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
+#endif //HAVE_SSE2
+
+#if HAVE_AVX2
+
+/// describes row elements by blocks of 32 starting at nElemIdx; returns the index of the first element left undescribed
+size_t lbsp_computeRow_avx2(const uchar* anInput, const uchar* anRef, const uchar* anThresholds, const std::array<ptrdiff_t,16>& anOffsets,
+                            size_t nElemIdx, size_t nElems, ushort* anDesc) {
+    const __m256i anZeros = _mm256_setzero_si256();
+    for(; nElemIdx+32<=nElems; nElemIdx+=32) {
+        const __m256i anRefs = _mm256_loadu_si256((__m256i*)(anRef+nElemIdx));
+        const __m256i anThres = _mm256_loadu_si256((__m256i*)(anThresholds+nElemIdx));
+        __m256i anDescBytes[2] = {anZeros,anZeros};
+        for(int n=0; n<16; ++n) {
+            const __m256i anVals = _mm256_loadu_si256((__m256i*)(anInput+nElemIdx+anOffsets[n]));
+            const __m256i anDists = _mm256_sub_epi8(_mm256_max_epu8(anVals,anRefs),_mm256_min_epu8(anVals,anRefs));
+            const __m256i abUnderThres = _mm256_cmpeq_epi8(_mm256_subs_epu8(anDists,anThres),anZeros);
+            anDescBytes[n/8] = _mm256_or_si256(anDescBytes[n/8],_mm256_andnot_si256(abUnderThres,_mm256_set1_epi8(char(1<<(n%8)))));
+        }
+        // byte unpacking is done within 128-bit lanes, so the halves need to be reordered before storing
+        const __m256i anDescLo = _mm256_unpacklo_epi8(anDescBytes[0],anDescBytes[1]);
+        const __m256i anDescHi = _mm256_unpackhi_epi8(anDescBytes[0],anDescBytes[1]);
+        _mm256_storeu_si256((__m256i*)(anDesc+nElemIdx),_mm256_permute2x128_si256(anDescLo,anDescHi,0x20));
+        _mm256_storeu_si256((__m256i*)(anDesc+nElemIdx+16),_mm256_permute2x128_si256(anDescLo,anDescHi,0x31));
+    }
+    return nElemIdx;
+}
+
+#endif //HAVE_AVX2
+
+void lbsp_computeDenseImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, cv::Mat& oDesc, const std::array<uchar,UCHAR_MAX+1>& anThresholdLUT,
+                           const int* anIdxLUT_x, const int* anIdxLUT_y, lv::SIMDInstrSet eInstrSet) {
+    static_assert(LBSP::DESC_SIZE==2 && LBSP::DESC_SIZE_BITS==16,"bad assumptions in impl below");
     lvAssert_(!oInputImg.empty() && oInputImg.isContinuous() && (oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3),"input image must be non-empty, continuous, and of type 8UC1/8UC3");
     lvAssert_(oRefImg.empty() || (oRefImg.size==oInputImg.size && oRefImg.type()==oInputImg.type()),"ref image must be empty, or of the same size/type as the input image");
-    lvAssert_(fThreshold>=0,"lbsp internal relative threshold must be non-negative");
-    const size_t nChannels = (size_t)oInputImg.channels();
+    const int nChannels = oInputImg.channels();
     const cv::Mat& oRefMat = oRefImg.empty()?oInputImg:oRefImg;
-    if(nChannels==1) {
-        oDesc.create(oInputImg.size(),CV_16UC1);
-        for(int y=int(LBSP::PATCH_SIZE)/2; y<oInputImg.rows-int(LBSP::PATCH_SIZE)/2; ++y) {
-            for(int x=int(LBSP::PATCH_SIZE)/2; x<oInputImg.cols-int(LBSP::PATCH_SIZE)/2; ++x) {
-                const uchar nThreshold = cv::saturate_cast<uchar>(oRefMat.at<uchar>(y,x)*fThreshold+nThresholdOffset);
-                LBSP::computeDescriptor<1>(oInputImg,oRefMat.at<uchar>(y,x),x,y,0,nThreshold,oDesc.at<ushort>(y,x));
-            }
-        }
-    }
-    else { //nChannels==3
-        oDesc.create(oInputImg.size(),CV_16UC3);
-        for(int y=int(LBSP::PATCH_SIZE)/2; y<oInputImg.rows-int(LBSP::PATCH_SIZE)/2; ++y) {
-            for(int x=int(LBSP::PATCH_SIZE)/2; x<oInputImg.cols-int(LBSP::PATCH_SIZE)/2; ++x) {
-                const uchar* acRef = oRefMat.ptr<uchar>(y,x);
-                alignas(16) const std::array<uchar,3> anThreshold = {cv::saturate_cast<uchar>(acRef[0]*fThreshold+nThresholdOffset),
-                                                                     cv::saturate_cast<uchar>(acRef[1]*fThreshold+nThresholdOffset),
-                                                                     cv::saturate_cast<uchar>(acRef[2]*fThreshold+nThresholdOffset)};
-                LBSP::computeDescriptor(oInputImg,acRef,x,y,anThreshold,oDesc.ptr<ushort>(y,x));
-            }
+    oDesc.create(oInputImg.size(),CV_16UC(nChannels));
+    constexpr int nBorderSize = int(LBSP::PATCH_SIZE)/2;
+    if(oInputImg.rows<=nBorderSize*2 || oInputImg.cols<=nBorderSize*2)
+        return;
+    // rows are described as flat arrays of interleaved elements; channels never mix since all offsets are multiples of the channel count
+    const size_t nElems = size_t((oInputImg.cols-nBorderSize*2)*nChannels);
+    std::array<ptrdiff_t,16> anOffsets;
+    for(size_t n=0; n<16; ++n)
+        anOffsets[n] = ptrdiff_t(oInputImg.step.p[0])*anIdxLUT_y[n]+nChannels*anIdxLUT_x[n];
+    const int nRowBegin = nBorderSize, nRowEnd = oInputImg.rows-nBorderSize;
+    const int nBands = (nRowEnd-nRowBegin+s_nDenseBandRows-1)/s_nDenseBandRows;
+#if USING_OPENMP
+    #pragma omp parallel for
+#endif //USING_OPENMP
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        static thread_local lv::AutoBuffer<uchar> s_anThresholds;
+        s_anThresholds.resize(nElems);
+        uchar* const anThresholds = s_anThresholds.data();
+        const int nBandRowEnd = std::min(nRowBegin+(nBandIdx+1)*s_nDenseBandRows,nRowEnd);
+        for(int nRowIdx=nRowBegin+nBandIdx*s_nDenseBandRows; nRowIdx<nBandRowEnd; ++nRowIdx) {
+            const uchar* const anInput = oInputImg.ptr<uchar>(nRowIdx)+nBorderSize*nChannels;
+            const uchar* const anRef = oRefMat.ptr<uchar>(nRowIdx)+nBorderSize*nChannels;
+            ushort* const anDesc = oDesc.ptr<ushort>(nRowIdx)+nBorderSize*nChannels;
+            for(size_t nElemIdx=0; nElemIdx<nElems; ++nElemIdx)
+                anThresholds[nElemIdx] = anThresholdLUT[anRef[nElemIdx]];
+            size_t nElemIdx = 0;
+#if HAVE_AVX2
+            if(eInstrSet==lv::SIMD_AVX2)
+                nElemIdx = lbsp_computeRow_avx2(anInput,anRef,anThresholds,anOffsets,nElemIdx,nElems,anDesc);
+#endif //HAVE_AVX2
+#if HAVE_SSE2
+            if(eInstrSet>=lv::SIMD_SSE2)
+                nElemIdx = lbsp_computeRow_sse2(anInput,anRef,anThresholds,anOffsets,nElemIdx,nElems,anDesc);
+#endif //HAVE_SSE2
+            lbsp_computeRow_scalar(anInput,anRef,anThresholds,anOffsets,nElemIdx,nElems,anDesc);
         }
     }
 }
@@ -230,10 +320,30 @@ void lbsp_computeImpl(const cv::Mat& oInputImg, const cv::Mat& oRefImg, const st
 
 void LBSP::compute2(const cv::Mat& oImage, cv::Mat& oDescMap) const {
     lvAssert_(!oImage.empty(),"input image must be non-empty");
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
+    if(m_bOnlyUsingAbsThreshold)
+        lbsp_fillThresholdLUT(anThresholdLUT,m_nThreshold);
+    else
+        lbsp_fillThresholdLUT(anThresholdLUT,m_fRelThreshold,m_nThreshold);
+    lbsp_computeDenseImpl(oImage,m_oRefImage,oDescMap,anThresholdLUT,s_oIdxLUT_16bitdbcross_x.anOffsets,s_oIdxLUT_16bitdbcross_y.anOffsets,m_eInstrSet);
+}
+
+void LBSP::compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat& oDescMap) const {
+    lvAssert_(!oImage.empty(),"input image must be non-empty");
+    if(!oDescMap.empty() && oDescMap.type()!=CV_16UC(oImage.channels()))
+        oDescMap.release(); // cached map cannot be reused
+    std::array<uchar,UCHAR_MAX+1> anThresholdLUT;
     if(m_bOnlyUsingAbsThreshold)
-        lbsp_computeImpl(oImage,m_oRefImage,oDescMap,m_nThreshold);
+        lbsp_fillThresholdLUT(anThresholdLUT,m_nThreshold);
     else
-        lbsp_computeImpl(oImage,m_oRefImage,oDescMap,m_fRelThreshold,m_nThreshold);
+        lbsp_fillThresholdLUT(anThresholdLUT,m_fRelThreshold,m_nThreshold);
+    lv::computeTemporalDescMap(oImage,oChangeMask,borderSize(),oDescMap,[&](const cv::Rect& oROI, cv::Mat& oROIDescMap) {
+        // dense impl requires continuous inputs, so image crops are cloned
+        const bool bFullImage = (oROI.size()==oImage.size());
+        const cv::Mat oROIImage = bFullImage?oImage:oImage(oROI).clone();
+        const cv::Mat oROIRefImage = (bFullImage||m_oRefImage.empty())?m_oRefImage:m_oRefImage(oROI).clone();
+        lbsp_computeDenseImpl(oROIImage,oROIRefImage,oROIDescMap,anThresholdLUT,s_oIdxLUT_16bitdbcross_x.anOffsets,s_oIdxLUT_16bitdbcross_y.anOffsets,m_eInstrSet);
+    });
 }
 
 void LBSP::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat& oDescMap) const {
@@ -251,15 +361,17 @@ void LBSP::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoint
 
 void LBSP::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat>& voDescMapCollection) const {
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i], voDescMapCollection[i]);
+    lv::processBatch(voImageCollection.size(),m_nBatchWorkerCount,[&](size_t /*nWorkerIdx*/, size_t nImageIdx){
+        compute2(voImageCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
 }
 
 void LBSP::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint>>& vvoPointCollection, std::vector<cv::Mat>& voDescMapCollection) const {
     lvAssert_(voImageCollection.size()==vvoPointCollection.size(),"number of images must match number of keypoint lists");
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i], vvoPointCollection[i], voDescMapCollection[i]);
+    lv::processBatch(voImageCollection.size(),m_nBatchWorkerCount,[&](size_t /*nWorkerIdx*/, size_t nImageIdx){
+        compute2(voImageCollection[nImageIdx],vvoPointCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
 }
 
 void LBSP::detectAndCompute(cv::InputArray _oImage, cv::InputArray _oMask, std::vector<cv::KeyPoint>& voKeypoints, cv::OutputArray _oDescriptors, bool bUseProvidedKeypoints) {
@@ -377,6 +489,8 @@ void LBSP::calcDistances(const cv::Mat& oDescriptors1, const cv::Mat& oDescripto
     lvAssert_(oDescriptors1.depth()==CV_16U && oDescriptors2.depth()==CV_16U,"unexpected descriptor matrix type");
     lvAssert_(oDescriptors1.type()==oDescriptors2.type(),"descriptor mat types mismatch");
     oDistances.create(oDescriptors1.rows,oDescriptors1.cols);
+    // not routed through DescMatcher: each LBSP descriptor is a single 16-64 bit word, so the matcher's per-descriptor kernel calls and
+    // float outputs would cost more than the inlined popcounts below (and the uchar output would need an extra conversion pass)
     if(oDescriptors1.channels()==1)
         for(int nDescRowIdx=0; nDescRowIdx<oDescriptors1.rows; ++nDescRowIdx)
             for(int nDescColIdx=0; nDescColIdx<oDescriptors1.cols; ++nDescColIdx)
@@ -395,6 +509,15 @@ void LBSP::calcDistances(const cv::Mat& oDescriptors1, const cv::Mat& oDescripto
                 oDistances(nDescRowIdx,nDescColIdx) = lv::hdist<4,ushort,uchar>(oDescriptors1.ptr<ushort>(nDescRowIdx,nDescColIdx),oDescriptors2.ptr<ushort>(nDescRowIdx,nDescColIdx));
 }
 
+void LBSP::knnMatch(const cv::Mat& oQueryDescs, const cv::Mat& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) {
+    lvAssert_(oQueryDescs.dims==2 && oTrainDescs.dims==2 && oQueryDescs.isContinuous() && oTrainDescs.isContinuous(),"descriptor mats must be continuous and 2d");
+    lvAssert_(oQueryDescs.depth()==CV_16U && oQueryDescs.type()==oTrainDescs.type(),"unexpected descriptor matrix type");
+    // each element (with all its channels) is one descriptor; the matcher works on its raw bytes
+    const cv::Mat oQueryBytes(int(oQueryDescs.total()),int(oQueryDescs.elemSize()),CV_8UC1,oQueryDescs.data);
+    const cv::Mat oTrainBytes(int(oTrainDescs.total()),int(oTrainDescs.elemSize()),CV_8UC1,oTrainDescs.data);
+    DescMatcher(DescMatcher::Dist_Hamming).knnMatch(oQueryBytes,oTrainBytes,nK,vvMatches);
+}
+
 #if HAVE_GLSL
 
 std::string LBSP::getShaderFunctionSource(size_t nChannels, bool bUseSharedDataPreload, const glm::uvec2& vWorkGroupSize) {
@@ -38,7 +38,8 @@ LSS::LSS(int nInnerRadius, int nOuterRadius, int nDescPatchSize, int nAngularBin
         m_nCorrPatchSize(m_nCorrWinSize-m_nPatchSize+1),
         m_nRadialBins(nRadialBins),
         m_nAngularBins(nAngularBins),
-        m_fStaticNoiseVar(fStaticNoiseVar) {
+        m_fStaticNoiseVar(fStaticNoiseVar),
+        m_nBatchWorkerCount(0) {
     lvAssert_(m_nPatchSize>0 && (m_nPatchSize%2)==1,"invalid parameter");
     lvAssert_(m_nOuterRadius>0 && m_nOuterRadius>=m_nPatchSize,"invalid parameter");
     lvAssert_(m_nInnerRadius>=0 && m_nOuterRadius>m_nInnerRadius,"invalid parameter");
@@ -127,17 +128,35 @@ void LSS::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& voKeypoints
     ssdescs_impl(oImage,voKeypoints,oDescMap,true);
 }
 
+void LSS::compute2Temporal(const cv::Mat& oImage, const cv::Mat& oChangeMask, cv::Mat_<float>& oDescMap) {
+    lvAssert_(!oImage.empty(),"input image must be non-empty");
+    // pre-processing blur widens the support of each descriptor, and vectorized row-wise ops on descriptor bins (e.g. cv::exp)
+    // may round differently based on row length, so updated regions always span full rows to keep results bit-exact
+    const int nSupportRadius = borderSize()+(m_bPreProcess?3:0);
+    lv::computeTemporalDescMap(oImage,oChangeMask,nSupportRadius,oDescMap,[&](const cv::Rect& oROI, cv::Mat_<float>& oROIDescMap) {
+        ssdescs_impl((oROI.size()==oImage.size())?oImage:oImage(oROI).clone(),oROIDescMap);
+    },true);
+}
+
+void LSS::compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap) {
+    cv::Mat_<float> oFloatDescMap; // float map is only kept until quantized (released on return)
+    ssdescs_impl(oImage,oFloatDescMap);
+    oDescMap.quantize(oFloatDescMap);
+}
+
 void LSS::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],voDescMapCollection[i]);
+    lv::processBatch(voImageCollection.size(),m_nBatchWorkerCount,[&](size_t /*nWorkerIdx*/, size_t nImageIdx){
+        ssdescs_impl(voImageCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
 }
 
 void LSS::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     lvAssert_(voImageCollection.size()==vvoPointCollection.size(),"number of images must match number of keypoint lists");
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],vvoPointCollection[i],voDescMapCollection[i]);
+    lv::processBatch(voImageCollection.size(),m_nBatchWorkerCount,[&](size_t /*nWorkerIdx*/, size_t nImageIdx){
+        ssdescs_impl(voImageCollection[nImageIdx],vvoPointCollection[nImageIdx],voDescMapCollection[nImageIdx],true);
+    });
 }
 
 void LSS::detectAndCompute(cv::InputArray _oImage, cv::InputArray _oMask, std::vector<cv::KeyPoint>& voKeypoints, cv::OutputArray _oDescriptors, bool bUseProvidedKeypoints) {
@@ -188,27 +207,48 @@ void LSS::validateROI(cv::Mat& oROI) const {
 void LSS::calcDistances(const cv::Mat_<float>& oDescriptors1, const cv::Mat_<float>& oDescriptors2, cv::Mat_<float>& oDistances) const {
     lvAssert_(oDescriptors1.dims==oDescriptors2.dims && oDescriptors1.size==oDescriptors2.size,"descriptor mat sizes mismatch");
     lvAssert_(oDescriptors1.dims==2 || oDescriptors1.dims==3,"unexpected descriptor matrix dim count");
-    if(oDescriptors1.dims==2) {
-        lvAssert_(oDescriptors1.cols==m_nRadialBins*m_nAngularBins,"unexpected descriptor size");
-        oDistances.create(oDescriptors1.rows,1);
-        for(int nDescIdx=0; nDescIdx<oDescriptors1.rows; ++nDescIdx) {
-            const cv::Mat_<float> oDesc1(1,m_nRadialBins*m_nAngularBins,const_cast<float*>(oDescriptors1.ptr<float>(nDescIdx)));
-            const cv::Mat_<float> oDesc2(1,m_nRadialBins*m_nAngularBins,const_cast<float*>(oDescriptors2.ptr<float>(nDescIdx)));
-            oDistances(nDescIdx) = (float)cv::norm(oDesc1,oDesc2,cv::NORM_L2);
-        }
-    }
-    else { //oDescriptors1.dims==3
-        lvAssert_(oDescriptors1.size[2]==m_nRadialBins*m_nAngularBins,"unexpected descriptor size");
-        oDistances.create(oDescriptors1.size[0],oDescriptors1.size[1]);
-        for(int nDescRowIdx=0; nDescRowIdx<oDescriptors1.size[0]; ++nDescRowIdx) {
-            for(int nDescColIdx=0; nDescColIdx<oDescriptors1.size[1]; ++nDescColIdx) {
-                const cv::Mat_<float> oDesc1(1,m_nRadialBins*m_nAngularBins,const_cast<float*>(oDescriptors1.ptr<float>(nDescRowIdx,nDescColIdx)));
-                const cv::Mat_<float> oDesc2(1,m_nRadialBins*m_nAngularBins,const_cast<float*>(oDescriptors2.ptr<float>(nDescRowIdx,nDescColIdx)));
-                oDistances(nDescRowIdx,nDescColIdx) = (float)cv::norm(oDesc1,oDesc2,cv::NORM_L2);
+    lvAssert_(oDescriptors1.size[oDescriptors1.dims-1]==m_nRadialBins*m_nAngularBins,"unexpected descriptor size");
+    DescMatcher(DescMatcher::Dist_L2).calcDistances(oDescriptors1,oDescriptors2,oDistances);
+}
+
+void LSS::calcDistances(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const {
+    lvAssert_(!oDescriptors1.empty() && oDescriptors1.descSize()==m_nRadialBins*m_nAngularBins,"unexpected descriptor size");
+    lv::QuantizedDescMap::calcDistances_L2(oDescriptors1,oDescriptors2,oDistances);
+}
+
+void LSS::knnMatch(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const {
+    lvAssert_((oQueryDescs.dims==2 || oQueryDescs.dims==3) && oQueryDescs.size[oQueryDescs.dims-1]==m_nRadialBins*m_nAngularBins,"unexpected query descriptor size");
+    lvAssert_((oTrainDescs.dims==2 || oTrainDescs.dims==3) && oTrainDescs.size[oTrainDescs.dims-1]==m_nRadialBins*m_nAngularBins,"unexpected train descriptor size");
+    DescMatcher(DescMatcher::Dist_L2).knnMatch(oQueryDescs,oTrainDescs,nK,vvMatches);
+}
+
+namespace {
+
+    /// number of image rows described at once by a worker in the dense impl
+    constexpr int s_nDenseBandRows = 16;
+
+    /// fills the correlation map of a single pixel with the exact sum of squared differences between its patch and all displaced patches of its window
+    void lss_computeCorrMap(const cv::Mat& oImage, int nRowIdx, int nColIdx, int nPatchRadius, int nCorrPatchSize, float* afCorrMap) {
+        const int nCorrPatchRadius = nCorrPatchSize/2;
+        const int nChannels = oImage.channels();
+        const int nPatchRowElems = (nPatchRadius*2+1)*nChannels;
+        for(int nRowOffset=-nCorrPatchRadius; nRowOffset<=nCorrPatchRadius; ++nRowOffset) {
+            for(int nColOffset=-nCorrPatchRadius; nColOffset<=nCorrPatchRadius; ++nColOffset) {
+                int nSSD = 0;
+                for(int nPatchRowIdx=nRowIdx-nPatchRadius; nPatchRowIdx<=nRowIdx+nPatchRadius; ++nPatchRowIdx) {
+                    const uchar* const anRow = oImage.ptr<uchar>(nPatchRowIdx)+(nColIdx-nPatchRadius)*nChannels;
+                    const uchar* const anDispRow = oImage.ptr<uchar>(nPatchRowIdx+nRowOffset)+(nColIdx-nPatchRadius+nColOffset)*nChannels;
+                    for(int nElemIdx=0; nElemIdx<nPatchRowElems; ++nElemIdx) {
+                        const int nDiff = int(anRow[nElemIdx])-int(anDispRow[nElemIdx]);
+                        nSSD += nDiff*nDiff;
+                    }
+                }
+                afCorrMap[(nRowOffset+nCorrPatchRadius)*nCorrPatchSize+nColOffset+nCorrPatchRadius] = (float)nSSD;
             }
         }
     }
-}
+
+} // anonymous namespace
 
 void LSS::ssdescs_impl(const cv::Mat& _oImage, std::vector<cv::KeyPoint>& voKeypoints, cv::Mat_<float>& oDescriptors, bool bGenDescMap) {
     lvAssert_(!_oImage.empty() && ((_oImage.type()==CV_8UC1) || (_oImage.type()==CV_8UC3)),"invalid input image");
@@ -224,7 +264,6 @@ void LSS::ssdescs_impl(const cv::Mat& _oImage, std::vector<cv::KeyPoint>& voKeyp
         cv::GaussianBlur(_oImage,oImage,cv::Size(7,7),1.0);
     else
         oImage = _oImage;
-    const int nCorrWinRadius = m_nCorrWinSize/2;
     const int nPatchRadius = m_nPatchSize/2;
     const int nDescSize = m_nRadialBins*m_nAngularBins;
     static thread_local lv::AutoBuffer<float> s_aCorrData;
@@ -242,9 +281,7 @@ void LSS::ssdescs_impl(const cv::Mat& _oImage, std::vector<cv::KeyPoint>& voKeyp
         const int nRowIdx = int(oCurrKeyPt.pt.y);
         const int nColIdx = int(oCurrKeyPt.pt.x);
         lvDbgAssert(nRowIdx>=0 && nColIdx>=0);
-        const cv::Mat oWindow = oImage(cv::Rect(nColIdx-nCorrWinRadius,nRowIdx-nCorrWinRadius,m_nCorrWinSize,m_nCorrWinSize));
-        const cv::Mat oTempl = oImage(cv::Rect(nColIdx-nPatchRadius,nRowIdx-nPatchRadius,m_nPatchSize,m_nPatchSize));
-        cv::matchTemplate(oWindow,oTempl,oCorrMap,cv::TM_SQDIFF);
+        lss_computeCorrMap(oImage,nRowIdx,nColIdx,nPatchRadius,m_nCorrPatchSize,(float*)oCorrMap.data);
 #if USE_STATIC_VAR_NOISE
         const float fVarNormFact = -1.0f/m_fStaticNoiseVar;
 #else //!USE_STATIC_VAR_NOISE
@@ -276,44 +313,124 @@ void LSS::ssdescs_impl(const cv::Mat& _oImage, cv::Mat_<float>& oDescriptors) {
         oImage = _oImage;
     const int nRows = oImage.rows;
     const int nCols = oImage.cols;
+    const int nChannels = oImage.channels();
     const int nCorrWinRadius = m_nCorrWinSize/2;
+    const int nCorrPatchRadius = m_nCorrPatchSize/2;
     const int nPatchRadius = m_nPatchSize/2;
     const int nDescSize = m_nRadialBins*m_nAngularBins;
     const int anDescDims[3] = {nRows,nCols,nDescSize};
     oDescriptors.create(3,anDescDims);
     std::fill_n(oDescriptors.ptr<float>(0,0),nDescSize*nCorrWinRadius*nCols,0.0f);
     std::fill_n(oDescriptors.ptr<float>(nRows-nCorrWinRadius,0),nDescSize*nCorrWinRadius*nCols,0.0f);
+    // instead of matching each pixel's patch against its window, the patch SSD of every (used) displacement is computed once
+    // for all pixels using sliding sums over a squared difference plane; bin minima are then gathered via the lookup map
+    std::vector<std::array<int,3>> vanDisplacements; // row offset, col offset, descriptor bin index (or -1 if unbinned)
+    for(int nCorrMapIdx=0; nCorrMapIdx<m_nCorrPatchSize*m_nCorrPatchSize; ++nCorrMapIdx) {
+        const int nDescBinIdx = (nCorrMapIdx>=m_nFirstMaskIdx && nCorrMapIdx<=m_nLastMaskIdx)?m_oDescLUMap(nCorrMapIdx):-1;
+        const int nRowOffset = nCorrMapIdx/m_nCorrPatchSize-nCorrPatchRadius;
+        const int nColOffset = nCorrMapIdx%m_nCorrPatchSize-nCorrPatchRadius;
+#if USE_STATIC_VAR_NOISE
+        if(nDescBinIdx!=-1)
+#else //!USE_STATIC_VAR_NOISE
+        if(nDescBinIdx!=-1 || (std::abs(nRowOffset)<=1 && std::abs(nColOffset)<=1))
+#endif //!USE_STATIC_VAR_NOISE
+            vanDisplacements.push_back({nRowOffset,nColOffset,nDescBinIdx});
+    }
+    const int nValidCols = nCols-nCorrWinRadius*2;
+    const int nSumCols = nValidCols+nPatchRadius*2;
+    const int nBands = (nRows-nCorrWinRadius*2+s_nDenseBandRows-1)/s_nDenseBandRows;
 #if USING_OPENMP
     #pragma omp parallel for
 #endif //USING_OPENMP
-    for(int nRowIdx=nCorrWinRadius; nRowIdx<nRows-nCorrWinRadius; ++nRowIdx) {
-        static thread_local lv::AutoBuffer<float> s_aCorrData;
-        s_aCorrData.resize(size_t(m_nCorrPatchSize*m_nCorrPatchSize));
-        cv::Mat_<float> oCorrMap(m_nCorrPatchSize,m_nCorrPatchSize,s_aCorrData.data());
-        static thread_local lv::AutoBuffer<float> s_aTempDesc;
-        s_aTempDesc.resize(size_t(nDescSize));
-        cv::Mat_<float> oTempDesc(1,nDescSize,s_aTempDesc.data());
-        std::fill_n(oDescriptors.ptr<float>(nRowIdx,0),nDescSize*nCorrWinRadius,0.0f);
-        std::fill_n(oDescriptors.ptr<float>(nRowIdx,nCols-nCorrWinRadius),nDescSize*nCorrWinRadius,0.0f);
-        for(int nColIdx=nCorrWinRadius; nColIdx<nCols-nCorrWinRadius; ++nColIdx) {
-            const cv::Mat oWindow = oImage(cv::Rect(nColIdx-nCorrWinRadius,nRowIdx-nCorrWinRadius,m_nCorrWinSize,m_nCorrWinSize));
-            const cv::Mat oTempl = oImage(cv::Rect(nColIdx-nPatchRadius,nRowIdx-nPatchRadius,m_nPatchSize,m_nPatchSize));
-            cv::matchTemplate(oWindow,oTempl,oCorrMap,cv::TM_SQDIFF);
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        const int nBandRowBegin = nCorrWinRadius+nBandIdx*s_nDenseBandRows;
+        const int nBandRowEnd = std::min(nBandRowBegin+s_nDenseBandRows,nRows-nCorrWinRadius);
+        const int nDiffRows = nBandRowEnd-nBandRowBegin+nPatchRadius*2;
+        static thread_local lv::AutoBuffer<int> s_anDiffData;
+        s_anDiffData.resize(size_t(nDiffRows*nSumCols));
+        static thread_local lv::AutoBuffer<int> s_anColSums;
+        s_anColSums.resize(size_t(nSumCols));
+        int* const anColSums = s_anColSums.data();
+#if !USE_STATIC_VAR_NOISE
+        static thread_local lv::AutoBuffer<float> s_afMaxLocalVarNoise;
+        s_afMaxLocalVarNoise.resize(size_t((nBandRowEnd-nBandRowBegin)*nValidCols));
+        std::fill_n(s_afMaxLocalVarNoise.data(),(nBandRowEnd-nBandRowBegin)*nValidCols,1000.0f);
+#endif //!USE_STATIC_VAR_NOISE
+        for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+            std::fill_n(oDescriptors.ptr<float>(nRowIdx,0),nDescSize*nCorrWinRadius,0.0f);
+            std::fill_n(oDescriptors.ptr<float>(nRowIdx,nCorrWinRadius),nDescSize*nValidCols,std::numeric_limits<float>::max());
+            std::fill_n(oDescriptors.ptr<float>(nRowIdx,nCols-nCorrWinRadius),nDescSize*nCorrWinRadius,0.0f);
+        }
+        for(const std::array<int,3>& anDisplacement : vanDisplacements) {
+            const int nRowOffset = anDisplacement[0];
+            const int nColOffset = anDisplacement[1];
+            const int nDescBinIdx = anDisplacement[2];
+            for(int nDiffRowIdx=0; nDiffRowIdx<nDiffRows; ++nDiffRowIdx) {
+                const int nRowIdx = nBandRowBegin-nPatchRadius+nDiffRowIdx;
+                const uchar* const anRow = oImage.ptr<uchar>(nRowIdx)+(nCorrWinRadius-nPatchRadius)*nChannels;
+                const uchar* const anDispRow = oImage.ptr<uchar>(nRowIdx+nRowOffset)+(nCorrWinRadius-nPatchRadius+nColOffset)*nChannels;
+                int* const anDiffRow = s_anDiffData.data()+nDiffRowIdx*nSumCols;
+                if(nChannels==1) {
+                    for(int nColIdx=0; nColIdx<nSumCols; ++nColIdx) {
+                        const int nDiff = int(anRow[nColIdx])-int(anDispRow[nColIdx]);
+                        anDiffRow[nColIdx] = nDiff*nDiff;
+                    }
+                }
+                else { //nChannels==3
+                    for(int nColIdx=0; nColIdx<nSumCols; ++nColIdx) {
+                        const int nDiff0 = int(anRow[nColIdx*3])-int(anDispRow[nColIdx*3]);
+                        const int nDiff1 = int(anRow[nColIdx*3+1])-int(anDispRow[nColIdx*3+1]);
+                        const int nDiff2 = int(anRow[nColIdx*3+2])-int(anDispRow[nColIdx*3+2]);
+                        anDiffRow[nColIdx] = nDiff0*nDiff0+nDiff1*nDiff1+nDiff2*nDiff2;
+                    }
+                }
+            }
+            std::fill_n(anColSums,nSumCols,0);
+            for(int nDiffRowIdx=0; nDiffRowIdx<nPatchRadius*2; ++nDiffRowIdx) {
+                const int* const anDiffRow = s_anDiffData.data()+nDiffRowIdx*nSumCols;
+                for(int nColIdx=0; nColIdx<nSumCols; ++nColIdx)
+                    anColSums[nColIdx] += anDiffRow[nColIdx];
+            }
+            for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+                const int nLocalRowIdx = nRowIdx-nBandRowBegin;
+                const int* const anNewDiffRow = s_anDiffData.data()+(nLocalRowIdx+nPatchRadius*2)*nSumCols;
+                for(int nColIdx=0; nColIdx<nSumCols; ++nColIdx)
+                    anColSums[nColIdx] += anNewDiffRow[nColIdx];
+                float* const afDescRow = oDescriptors.ptr<float>(nRowIdx,nCorrWinRadius);
+                int nPatchSSD = 0;
+                for(int nColIdx=0; nColIdx<nPatchRadius*2; ++nColIdx)
+                    nPatchSSD += anColSums[nColIdx];
+                for(int nColIdx=0; nColIdx<nValidCols; ++nColIdx) {
+                    nPatchSSD += anColSums[nColIdx+nPatchRadius*2];
+                    if(nDescBinIdx!=-1) {
+                        float& fBin = afDescRow[nColIdx*nDescSize+nDescBinIdx];
+                        fBin = std::min(fBin,(float)nPatchSSD);
+                    }
+#if !USE_STATIC_VAR_NOISE
+                    if(std::abs(nRowOffset)<=1 && std::abs(nColOffset)<=1) {
+                        float& fMaxLocalVarNoise = s_afMaxLocalVarNoise[nLocalRowIdx*nValidCols+nColIdx];
+                        fMaxLocalVarNoise = std::max(fMaxLocalVarNoise,(float)nPatchSSD);
+                    }
+#endif //!USE_STATIC_VAR_NOISE
+                    nPatchSSD -= anColSums[nColIdx];
+                }
+                const int* const anOldDiffRow = s_anDiffData.data()+nLocalRowIdx*nSumCols;
+                for(int nColIdx=0; nColIdx<nSumCols; ++nColIdx)
+                    anColSums[nColIdx] -= anOldDiffRow[nColIdx];
+            }
+        }
+        for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
 #if USE_STATIC_VAR_NOISE
-            const float fVarNormFact = -1.0f/m_fStaticNoiseVar;
+            cv::Mat_<float> oDescRow(1,nDescSize*nValidCols,oDescriptors.ptr<float>(nRowIdx,nCorrWinRadius));
+            oDescRow *= -1.0f/m_fStaticNoiseVar;
+            cv::exp(oDescRow,oDescRow);
 #else //!USE_STATIC_VAR_NOISE
-            float fMaxLocalVarNoise = 1000.0f;
-            for(int nRowOffset=-1; nRowOffset<=1 ; ++nRowOffset)
-                for(int nColOffset=-1; nColOffset<=1; ++nColOffset)
-                    fMaxLocalVarNoise = std::max(fMaxLocalVarNoise,oCorrMap(m_nCorrPatchSize/2+nRowOffset,m_nCorrPatchSize/2+nColOffset));
-            const float fVarNormFact = -1.0f/fMaxLocalVarNoise;
+            for(int nColIdx=nCorrWinRadius; nColIdx<nCols-nCorrWinRadius; ++nColIdx) {
+                cv::Mat_<float> oDesc(1,nDescSize,oDescriptors.ptr<float>(nRowIdx,nColIdx));
+                oDesc *= -1.0f/s_afMaxLocalVarNoise[(nRowIdx-nBandRowBegin)*nValidCols+nColIdx-nCorrWinRadius];
+                cv::exp(oDesc,oDesc);
+            }
 #endif //!USE_STATIC_VAR_NOISE
-            oTempDesc = std::numeric_limits<float>::max();
-            for(int nDescBinIdx=m_nFirstMaskIdx; nDescBinIdx<=m_nLastMaskIdx; ++nDescBinIdx)
-                if(m_oDescLUMap(nDescBinIdx)!=-1)
-                    s_aTempDesc[m_oDescLUMap(nDescBinIdx)] = std::min(s_aTempDesc[m_oDescLUMap(nDescBinIdx)],((float*)oCorrMap.data)[nDescBinIdx]);
-            oTempDesc *= fVarNormFact;
-            cv::exp(oTempDesc,cv::Mat_<float>(1,nDescSize,oDescriptors.ptr<float>(nRowIdx,nColIdx)));
         }
     }
     if(m_bNormalizeBins)
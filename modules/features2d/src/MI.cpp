@@ -27,6 +27,22 @@ namespace {
     thread_local lv::JointSparseHistData<ushort,uchar> g_oSparse24BitHistData;
     thread_local lv::JointDenseHistData<uchar,uchar> g_oDenseHistData;
     thread_local lv::JointDenseHistData<ushort,uchar> g_oDense24BitHistData;
+
+    /// number of states in 8-bit marginal histograms used in dense (sliding) impl
+    constexpr int s_nDenseHistStates = 256;
+
+    /// updates a histogram bin count along with the n*log2(n) sum of all bins of its histogram
+    template<int nIncr>
+    inline void mi_updateHistBin(int& nCount, double& dNLogNSum, int& nNonZeroBins, const double* adNLogNLUT) {
+        static_assert(nIncr==1 || nIncr==-1,"bin counts must be updated one by one");
+        lvDbgAssert(nCount+nIncr>=0);
+        dNLogNSum += adNLogNLUT[nCount+nIncr]-adNLogNLUT[nCount];
+        if(nIncr>0 && nCount==0)
+            ++nNonZeroBins;
+        else if(nIncr<0 && nCount==1)
+            --nNonZeroBins;
+        nCount += nIncr;
+    }
 }
 
 MutualInfo::MutualInfo(const cv::Size& oWinSize, bool bNormalize, bool bUseDenseHist, bool bUse24BitPair) :
@@ -149,6 +165,82 @@ std::vector<double> MutualInfo::compute(const cv::Mat& oImage1, const cv::Mat& o
     return vdScores;
 }
 
+void MutualInfo::compute2(const cv::Mat& _oImage1, const cv::Mat& _oImage2, cv::Mat_<double>& oScoreMap) {
+    lvAssert_(!_oImage1.empty() && _oImage1.dims==2 && _oImage1.size()==_oImage2.size(),"invalid input image(s) size");
+    lvAssert_(_oImage1.rows>=m_oWinSize.height && _oImage1.cols>=m_oWinSize.width,"input image(s) too small for window size");
+    lvAssert_(_oImage1.type()==CV_8UC1 && _oImage2.type()==CV_8UC1,"unsupported input matrices types (dense impl needs 8uc1 on both)");
+    const cv::Mat_<uchar> oImage1 = _oImage1;
+    const cv::Mat_<uchar> oImage2 = _oImage2;
+    const int nRows = oImage1.rows;
+    const int nCols = oImage1.cols;
+    const int nWinRadiusX = m_oWinSize.width/2;
+    const int nWinRadiusY = m_oWinSize.height/2;
+    const int nWinArea = m_oWinSize.area();
+    const double dLog2WinArea = std::log2(double(nWinArea));
+    oScoreMap.create(nRows,nCols);
+    oScoreMap = 0.0;
+    // mutual info is rebuilt from entropy sums as 'log2(N) + (sum_ij(n_ij*log2(n_ij)) - sum_i(n_i*log2(n_i)) - sum_j(n_j*log2(n_j)))/N'
+    static thread_local lv::AutoBuffer<double> s_adNLogNLUT;
+    s_adNLogNLUT.resize(size_t(nWinArea+1));
+    double* adNLogNLUT = s_adNLogNLUT.data();
+    adNLogNLUT[0] = 0.0;
+    for(int nCount=1; nCount<=nWinArea; ++nCount)
+        adNLogNLUT[nCount] = nCount*std::log2(double(nCount));
+    const bool bNormalize = m_bNormalize;
+    const int nWinWidth = m_oWinSize.width;
+#if USING_OPENMP
+    #pragma omp parallel for
+#endif //USING_OPENMP
+    for(int nRowIdx=nWinRadiusY; nRowIdx<nRows-nWinRadiusY; ++nRowIdx) {
+        constexpr size_t nCountBufferSize = size_t(s_nDenseHistStates*s_nDenseHistStates+s_nDenseHistStates*2);
+        static thread_local lv::AutoBuffer<int> s_anCounts;
+        if(s_anCounts.size()!=nCountBufferSize) {
+            // counts are only zeroed on allocation; each row removes all its window columns before returning
+            s_anCounts.resize(nCountBufferSize);
+            std::fill_n(s_anCounts.data(),nCountBufferSize,0);
+        }
+        int* anJointCounts = s_anCounts.data();
+        int* anMargCounts1 = anJointCounts+s_nDenseHistStates*s_nDenseHistStates;
+        int* anMargCounts2 = anMargCounts1+s_nDenseHistStates;
+        double dJointNLogNSum=0.0, dMargNLogNSum1=0.0, dMargNLogNSum2=0.0;
+        int nJointBins=0, nMargBins1=0, nMargBins2=0;
+        const auto lUpdateColumn = [&](int nColIdx, auto nIncr) {
+            constexpr int nCurrIncr = decltype(nIncr)::value;
+            for(int nWinRowIdx=nRowIdx-nWinRadiusY; nWinRowIdx<=nRowIdx+nWinRadiusY; ++nWinRowIdx) {
+                const int nVal1 = int(oImage1(nWinRowIdx,nColIdx)), nVal2 = int(oImage2(nWinRowIdx,nColIdx));
+                mi_updateHistBin<nCurrIncr>(anJointCounts[nVal1*s_nDenseHistStates+nVal2],dJointNLogNSum,nJointBins,adNLogNLUT);
+                mi_updateHistBin<nCurrIncr>(anMargCounts1[nVal1],dMargNLogNSum1,nMargBins1,adNLogNLUT);
+                mi_updateHistBin<nCurrIncr>(anMargCounts2[nVal2],dMargNLogNSum2,nMargBins2,adNLogNLUT);
+            }
+        };
+        const std::integral_constant<int,1> nAdd;
+        const std::integral_constant<int,-1> nRemove;
+        double* pdScores = oScoreMap.ptr<double>(nRowIdx);
+        for(int nColIdx=0; nColIdx<nWinWidth; ++nColIdx)
+            lUpdateColumn(nColIdx,nAdd);
+        for(int nColIdx=nWinRadiusX; nColIdx<nCols-nWinRadiusX; ++nColIdx) {
+            if(nColIdx>nWinRadiusX) {
+                lUpdateColumn(nColIdx-nWinRadiusX-1,nRemove);
+                lUpdateColumn(nColIdx+nWinRadiusX,nAdd);
+            }
+            // a window with a single state in either marginal histogram holds no mutual info (and has null entropy)
+            if(nMargBins1<=1 || nMargBins2<=1)
+                continue;
+            double dMutualInfoScore = dLog2WinArea+(dJointNLogNSum-dMargNLogNSum1-dMargNLogNSum2)/nWinArea;
+            if(bNormalize) {
+                const double dMargEntropy1 = dLog2WinArea-dMargNLogNSum1/nWinArea;
+                const double dMargEntropy2 = dLog2WinArea-dMargNLogNSum2/nWinArea;
+                if(dMargEntropy1>0.0 && dMargEntropy2>0.0)
+                    dMutualInfoScore /= std::sqrt(dMargEntropy1*dMargEntropy2);
+            }
+            pdScores[nColIdx] = std::max(dMutualInfoScore,0.0);
+        }
+        for(int nColIdx=nCols-nWinWidth; nColIdx<nCols; ++nColIdx)
+            lUpdateColumn(nColIdx,nRemove);
+        lvDbgAssert(nJointBins==0 && nMargBins1==0 && nMargBins2==0);
+    }
+}
+
 void MutualInfo::validateKeyPoints(std::vector<cv::KeyPoint>& voKeypoints, cv::Size oImgSize) const {
     cv::KeyPointsFilter::runByImageBorder(voKeypoints,oImgSize,std::max(m_oWinSize.width,m_oWinSize.height));
 }
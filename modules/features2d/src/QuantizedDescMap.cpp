@@ -0,0 +1,100 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2017 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/features2d/QuantizedDescMap.hpp"
+
+void lv::QuantizedDescMap::quantize(const cv::Mat_<float>& oDescMap) {
+    lvAssert_(!oDescMap.empty() && (oDescMap.dims==2 || oDescMap.dims==3) && oDescMap.isContinuous(),"descriptor map must be non-empty, continuous, and 2d/3d");
+    const int nDescSize = oDescMap.size[oDescMap.dims-1];
+    const int nDescCount = int(oDescMap.total()/size_t(nDescSize));
+    oBins.create(oDescMap.dims,oDescMap.size.p);
+    if(oDescMap.dims==2)
+        oScales.create(oDescMap.rows,1);
+    else
+        oScales.create(oDescMap.size[0],oDescMap.size[1]);
+    lvDbgAssert(oBins.isContinuous() && oScales.isContinuous() && descCount()==nDescCount);
+#if USING_OPENMP
+    #pragma omp parallel for if(nDescCount>1024)
+#endif //USING_OPENMP
+    for(int nDescIdx=0; nDescIdx<nDescCount; ++nDescIdx) {
+        const float* aDesc = ((const float*)oDescMap.data)+size_t(nDescIdx)*size_t(nDescSize);
+        uchar* aBins = oBins.data+size_t(nDescIdx)*size_t(nDescSize);
+        float fMaxVal = 0.0f;
+        for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+            lvDbgAssert(!(aDesc[nBinIdx]<0.0f));
+            fMaxVal = std::max(fMaxVal,aDesc[nBinIdx]);
+        }
+        const float fInvScale = (fMaxVal>0.0f)?float(UCHAR_MAX)/fMaxVal:0.0f;
+        for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx)
+            aBins[nBinIdx] = cv::saturate_cast<uchar>(aDesc[nBinIdx]*fInvScale);
+        ((float*)oScales.data)[nDescIdx] = fMaxVal/float(UCHAR_MAX);
+    }
+}
+
+void lv::QuantizedDescMap::dequantize(cv::Mat_<float>& oDescMap) const {
+    lvAssert_(!empty(),"quantized map must be non-empty");
+    oDescMap.create(oBins.dims,oBins.size.p);
+    lvDbgAssert(oDescMap.isContinuous());
+    const int nDescSize = descSize();
+    const int nDescCount = descCount();
+#if USING_OPENMP
+    #pragma omp parallel for if(nDescCount>1024)
+#endif //USING_OPENMP
+    for(int nDescIdx=0; nDescIdx<nDescCount; ++nDescIdx)
+        decode(nDescIdx,((float*)oDescMap.data)+size_t(nDescIdx)*size_t(nDescSize));
+}
+
+void lv::QuantizedDescMap::decode(int nDescIdx, float* aDescriptor) const {
+    lvDbgAssert(aDescriptor);
+    const uchar* aBins = bins(nDescIdx);
+    const float fScale = scale(nDescIdx);
+    const int nDescSize = descSize();
+    for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx)
+        aDescriptor[nBinIdx] = fScale*float(aBins[nBinIdx]);
+}
+
+double lv::QuantizedDescMap::calcDistance_L2(const uchar* aBins1, float fScale1, const uchar* aBins2, float fScale2, int nDescSize) {
+    lvDbgAssert(aBins1 && aBins2 && nDescSize>0 && nDescSize<=(std::numeric_limits<int>::max()/(UCHAR_MAX*UCHAR_MAX)));
+    // |s1*q1-s2*q2|^2 = s1^2*|q1|^2 + s2^2*|q2|^2 - 2*s1*s2*<q1,q2>, where all integer sums are exact (and vectorize well)
+    int nSqrNorm1 = 0, nSqrNorm2 = 0, nDotProd = 0;
+#if USING_OPENMP
+    #pragma omp simd reduction(+:nSqrNorm1,nSqrNorm2,nDotProd)
+#endif //USING_OPENMP
+    for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+        const int nBin1 = int(aBins1[nBinIdx]), nBin2 = int(aBins2[nBinIdx]);
+        nSqrNorm1 += nBin1*nBin1;
+        nSqrNorm2 += nBin2*nBin2;
+        nDotProd += nBin1*nBin2;
+    }
+    const double dScale1 = double(fScale1), dScale2 = double(fScale2);
+    const double dSqrDist = dScale1*dScale1*nSqrNorm1+dScale2*dScale2*nSqrNorm2-2.0*dScale1*dScale2*nDotProd;
+    return std::sqrt(std::max(dSqrDist,0.0));
+}
+
+void lv::QuantizedDescMap::calcDistances_L2(const QuantizedDescMap& oDescMap1, const QuantizedDescMap& oDescMap2, cv::Mat_<float>& oDistances) {
+    lvAssert_(!oDescMap1.empty() && oDescMap1.oBins.dims==oDescMap2.oBins.dims && oDescMap1.oBins.size==oDescMap2.oBins.size,"descriptor map sizes mismatch");
+    lvAssert_(oDescMap1.oScales.size==oDescMap2.oScales.size,"descriptor scale map sizes mismatch");
+    oDistances.create(oDescMap1.oScales.rows,oDescMap1.oScales.cols);
+    lvDbgAssert(oDistances.isContinuous());
+    const int nDescSize = oDescMap1.descSize();
+    const int nDescCount = oDescMap1.descCount();
+#if USING_OPENMP
+    #pragma omp parallel for if(nDescCount>1024)
+#endif //USING_OPENMP
+    for(int nDescIdx=0; nDescIdx<nDescCount; ++nDescIdx)
+        ((float*)oDistances.data)[nDescIdx] = (float)calcDistance_L2(oDescMap1.bins(nDescIdx),oDescMap1.scale(nDescIdx),oDescMap2.bins(nDescIdx),oDescMap2.scale(nDescIdx),nDescSize);
+}
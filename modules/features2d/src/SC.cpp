@@ -24,6 +24,85 @@
 
 #define USE_LIENHART_LOOKUP_MASK 1
 
+namespace {
+
+    /// number of dense descriptor map rows filled at once by a worker when scattering contour points
+    constexpr int s_nDenseBandRows = 16;
+
+    /// returns the radial bin index of a keypoint-contour point offset (or nRadialBins if none fit), using the first limit above the normalized distance
+    inline int sc_getRadialBin(float fDiffX, float fDiffY, double dDistNorm, const double* adRadialLimits, int nRadialBins) {
+        // squared distance is accumulated in double precision (products are exact, so fused ops give the same result)
+        const double dDist = std::sqrt(double(fDiffY)*fDiffY+double(fDiffX)*fDiffX)/dDistNorm;
+        int nRadialBinIdx = 0;
+        for(int nLimitIdx=0; nLimitIdx<nRadialBins; ++nLimitIdx)
+            nRadialBinIdx += int(adRadialLimits[nLimitIdx]<=dDist);
+        return nRadialBinIdx;
+    }
+
+    /// returns the sum of all distances between a keypoint and the given contour points (accumulated in 4 interleaved partial sums)
+    double sc_calcDistSum_scalar(float fKeyPtX, float fKeyPtY, const float* afContourPtX, const float* afContourPtY, int nContourPts) {
+        std::array<double,4> adPartialSums = {0.0,0.0,0.0,0.0};
+        int nContourPtIdx = 0;
+        for(; nContourPtIdx+4<=nContourPts; nContourPtIdx+=4) {
+            for(int nLaneIdx=0; nLaneIdx<4; ++nLaneIdx) {
+                const float fDiffX = fKeyPtX-afContourPtX[nContourPtIdx+nLaneIdx], fDiffY = fKeyPtY-afContourPtY[nContourPtIdx+nLaneIdx];
+                adPartialSums[nLaneIdx] += std::sqrt(double(fDiffY)*fDiffY+double(fDiffX)*fDiffX);
+            }
+        }
+        double dDistSum = ((adPartialSums[0]+adPartialSums[1])+adPartialSums[2])+adPartialSums[3];
+        for(; nContourPtIdx<nContourPts; ++nContourPtIdx) {
+            const float fDiffX = fKeyPtX-afContourPtX[nContourPtIdx], fDiffY = fKeyPtY-afContourPtY[nContourPtIdx];
+            dDistSum += std::sqrt(double(fDiffY)*fDiffY+double(fDiffX)*fDiffX);
+        }
+        return dDistSum;
+    }
+
+#if HAVE_AVX2
+
+    /// returns the sum of all distances between a keypoint and the given contour points (identical to the scalar version, lane-for-lane)
+    double sc_calcDistSum_avx2(float fKeyPtX, float fKeyPtY, const float* afContourPtX, const float* afContourPtY, int nContourPts) {
+        const __m128 afKeyPtX = _mm_set1_ps(fKeyPtX), afKeyPtY = _mm_set1_ps(fKeyPtY);
+        __m256d adPartialSums = _mm256_setzero_pd();
+        int nContourPtIdx = 0;
+        for(; nContourPtIdx+4<=nContourPts; nContourPtIdx+=4) {
+            const __m256d adDiffX = _mm256_cvtps_pd(_mm_sub_ps(afKeyPtX,_mm_loadu_ps(afContourPtX+nContourPtIdx)));
+            const __m256d adDiffY = _mm256_cvtps_pd(_mm_sub_ps(afKeyPtY,_mm_loadu_ps(afContourPtY+nContourPtIdx)));
+            adPartialSums = _mm256_add_pd(adPartialSums,_mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(adDiffY,adDiffY),_mm256_mul_pd(adDiffX,adDiffX))));
+        }
+        alignas(32) std::array<double,4> adPartialSumsArray;
+        _mm256_store_pd(adPartialSumsArray.data(),adPartialSums);
+        double dDistSum = ((adPartialSumsArray[0]+adPartialSumsArray[1])+adPartialSumsArray[2])+adPartialSumsArray[3];
+        for(; nContourPtIdx<nContourPts; ++nContourPtIdx) {
+            const float fDiffX = fKeyPtX-afContourPtX[nContourPtIdx], fDiffY = fKeyPtY-afContourPtY[nContourPtIdx];
+            dDistSum += std::sqrt(double(fDiffY)*fDiffY+double(fDiffX)*fDiffX);
+        }
+        return dDistSum;
+    }
+
+    /// assigns radial bins to a keypoint's contour points by blocks of 4; returns the index of the first contour point left unassigned
+    int sc_fillRadialBins_avx2(float fKeyPtX, float fKeyPtY, const float* afContourPtX, const float* afContourPtY, int nContourPts,
+                               double dDistNorm, const double* adRadialLimits, int nRadialBins, int* anRadialBins) {
+        const __m128 afKeyPtX = _mm_set1_ps(fKeyPtX), afKeyPtY = _mm_set1_ps(fKeyPtY);
+        const __m256d adDistNorm = _mm256_set1_pd(dDistNorm);
+        int nContourPtIdx = 0;
+        for(; nContourPtIdx+4<=nContourPts; nContourPtIdx+=4) {
+            const __m256d adDiffX = _mm256_cvtps_pd(_mm_sub_ps(afKeyPtX,_mm_loadu_ps(afContourPtX+nContourPtIdx)));
+            const __m256d adDiffY = _mm256_cvtps_pd(_mm_sub_ps(afKeyPtY,_mm_loadu_ps(afContourPtY+nContourPtIdx)));
+            const __m256d adDists = _mm256_div_pd(_mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(adDiffY,adDiffY),_mm256_mul_pd(adDiffX,adDiffX))),adDistNorm);
+            __m256i anBinIdxs = _mm256_setzero_si256();
+            for(int nLimitIdx=0; nLimitIdx<nRadialBins; ++nLimitIdx) // comparison masks are all-ones (i.e. -1) where limit<=dist
+                anBinIdxs = _mm256_sub_epi64(anBinIdxs,_mm256_castpd_si256(_mm256_cmp_pd(_mm256_set1_pd(adRadialLimits[nLimitIdx]),adDists,_CMP_LE_OQ)));
+            // gathers the low 32 bits of each 64-bit lane before storing
+            const __m256i anPackedBinIdxs = _mm256_permutevar8x32_epi32(anBinIdxs,_mm256_setr_epi32(0,2,4,6,1,3,5,7));
+            _mm_storeu_si128((__m128i*)(anRadialBins+nContourPtIdx),_mm256_castsi256_si128(anPackedBinIdxs));
+        }
+        return nContourPtIdx;
+    }
+
+#endif //HAVE_AVX2
+
+} // anonymous namespace
+
 ShapeContext::ShapeContext(size_t nInnerRadius, size_t nOuterRadius, size_t nAngularBins, size_t nRadialBins,
                            bool bRotationInvariant, bool bNormalizeBins, bool bUseNonZeroInit) :
 #if HAVE_CUDA
@@ -40,7 +119,9 @@ ShapeContext::ShapeContext(size_t nInnerRadius, size_t nOuterRadius, size_t nAng
         m_bRotationInvariant(bRotationInvariant),
         m_bNormalizeBins(bNormalizeBins),
         m_bNonZeroInitBins(bUseNonZeroInit),
+        m_eInstrSet(lv::SIMD_None),
         m_bUsingFullKeyPtMap(false) {
+    setInstrSet(lv::getBestSIMDInstrSet());
     lvAssert_(m_nAngularBins>0,"invalid parameter");
     lvAssert_(m_nRadialBins>0,"invalid parameter");
     lvAssert_(m_nInnerRadius>0,"invalid parameter");
@@ -58,6 +139,11 @@ ShapeContext::ShapeContext(size_t nInnerRadius, size_t nOuterRadius, size_t nAng
         const int nMaskSize = m_nOuterRadius*2+1;
         lv::getLogPolarMask(nMaskSize,m_nRadialBins,m_nAngularBins,m_oAbsDescLUMap,true,(float)m_nInnerRadius);
         lvDbgAssert(m_oAbsDescLUMap.cols==nMaskSize && m_oAbsDescLUMap.rows==nMaskSize);
+        m_vvAbsDescLUMapRowBins.resize((size_t)nMaskSize);
+        for(int nRowIdx=0; nRowIdx<nMaskSize; ++nRowIdx)
+            for(int nColIdx=0; nColIdx<nMaskSize; ++nColIdx)
+                if(m_oAbsDescLUMap(nRowIdx,nColIdx)!=-1)
+                    m_vvAbsDescLUMapRowBins[nRowIdx].emplace_back(nColIdx,m_oAbsDescLUMap(nRowIdx,nColIdx));
     #if HAVE_CUDA
         if(tryInitEnableCUDA()) {
             m_nBlockSize = size_t(0);
@@ -98,7 +184,9 @@ ShapeContext::ShapeContext(double dRelativeInnerRadius, double dRelativeOuterRad
         m_bRotationInvariant(bRotationInvariant),
         m_bNormalizeBins(bNormalizeBins),
         m_bNonZeroInitBins(bUseNonZeroInit),
+        m_eInstrSet(lv::SIMD_None),
         m_bUsingFullKeyPtMap(false) {
+    setInstrSet(lv::getBestSIMDInstrSet());
     lvAssert_(m_nAngularBins>0,"invalid parameter");
     lvAssert_(m_nRadialBins>0,"invalid parameter");
     lvAssert_(m_dInnerRadius>0.0,"invalid parameter");
@@ -209,6 +297,11 @@ int ShapeContext::chainDetectMethod() const {
     return cv::CHAIN_APPROX_NONE;
 }
 
+void ShapeContext::setInstrSet(lv::SIMDInstrSet eInstrSet) {
+    // cpu bin assignment only has an AVX2 path besides the scalar one
+    m_eInstrSet = (eInstrSet>=lv::SIMD_AVX2 && lv::isSIMDSupported(lv::SIMD_AVX2))?lv::SIMD_AVX2:lv::SIMD_None;
+}
+
 void ShapeContext::compute2(const cv::Mat& oImage, cv::Mat& oDescMap_) {
     lvAssert_(oDescMap_.empty() || oDescMap_.type()==CV_32FC1,"wrong output desc map type");
     cv::Mat_<float> oDescMap = oDescMap_;
@@ -263,17 +356,53 @@ void ShapeContext::compute2(const cv::Mat& oImage, std::vector<cv::KeyPoint>& vo
         scdesc_fill_desc(oDescMap,true);
 }
 
+void ShapeContext::compute2(const cv::Mat& oImage, lv::QuantizedDescMap& oDescMap) {
+    cv::Mat_<float> oFloatDescMap; // float map is only kept until quantized (released on return)
+    compute2(oImage,oFloatDescMap);
+    oDescMap.quantize(oFloatDescMap);
+}
+
+template<typename TDescribeFunc>
+void ShapeContext::scdesc_batch_impl(size_t nImages, TDescribeFunc&& lDescribe) {
+#if HAVE_CUDA
+    if(m_bUseCUDA) {
+        // device-side buffers belong to this instance; images are already processed in parallel on the gpu
+        for(size_t nImageIdx=0; nImageIdx<nImages; ++nImageIdx)
+            lDescribe(*this,nImageIdx);
+        return;
+    }
+#endif //HAVE_CUDA
+    m_oBatchWorkers.process(nImages,*this,[&](){return scdesc_create_worker();},[&](ShapeContext& oWorker, size_t nImageIdx){
+        if(oWorker.m_eInstrSet!=m_eInstrSet)
+            oWorker.m_eInstrSet = m_eInstrSet;
+        lDescribe(oWorker,nImageIdx);
+    });
+}
+
 void ShapeContext::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],voDescMapCollection[i]);
+    scdesc_batch_impl(voImageCollection.size(),[&](ShapeContext& oWorker, size_t nImageIdx){
+        oWorker.compute2(voImageCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
 }
 
 void ShapeContext::compute2(const std::vector<cv::Mat>& voImageCollection, std::vector<std::vector<cv::KeyPoint> >& vvoPointCollection, std::vector<cv::Mat_<float>>& voDescMapCollection) {
     lvAssert_(voImageCollection.size()==vvoPointCollection.size(),"number of images must match number of keypoint lists");
     voDescMapCollection.resize(voImageCollection.size());
-    for(size_t i=0; i<voImageCollection.size(); i++)
-        compute2(voImageCollection[i],vvoPointCollection[i],voDescMapCollection[i]);
+    scdesc_batch_impl(voImageCollection.size(),[&](ShapeContext& oWorker, size_t nImageIdx){
+        oWorker.compute2(voImageCollection[nImageIdx],vvoPointCollection[nImageIdx],voDescMapCollection[nImageIdx]);
+    });
+}
+
+std::unique_ptr<ShapeContext> ShapeContext::scdesc_create_worker() const {
+    std::unique_ptr<ShapeContext> pWorker = m_bUseRelativeSpace?
+        std::make_unique<ShapeContext>(m_dInnerRadius,m_dOuterRadius,size_t(m_nAngularBins),size_t(m_nRadialBins),m_bRotationInvariant,m_bNormalizeBins,m_bNonZeroInitBins):
+        std::make_unique<ShapeContext>(size_t(m_nInnerRadius),size_t(m_nOuterRadius),size_t(m_nAngularBins),size_t(m_nRadialBins),m_bRotationInvariant,m_bNormalizeBins,m_bNonZeroInitBins);
+#if HAVE_CUDA
+    pWorker->enableCUDA(false);
+#endif //HAVE_CUDA
+    pWorker->m_eInstrSet = m_eInstrSet;
+    return pWorker;
 }
 
 void ShapeContext::detectAndCompute(cv::InputArray _oImage, cv::InputArray _oMask, std::vector<cv::KeyPoint>& voKeypoints, cv::OutputArray _oDescriptors, bool bUseProvidedKeypoints) {
@@ -322,6 +451,17 @@ void ShapeContext::validateROI(cv::Mat& oROI) const {
     lvAssert_(!oROI.empty() && oROI.type()==CV_8UC1,"input ROI must be non-empty and of type 8UC1");
 }
 
+void ShapeContext::calcDistances_L2(const lv::QuantizedDescMap& oDescriptors1, const lv::QuantizedDescMap& oDescriptors2, cv::Mat_<float>& oDistances) const {
+    lvAssert_(!oDescriptors1.empty() && oDescriptors1.descSize()==m_nDescSize,"unexpected descriptor size");
+    lv::QuantizedDescMap::calcDistances_L2(oDescriptors1,oDescriptors2,oDistances);
+}
+
+void ShapeContext::knnMatch_L2(const cv::Mat_<float>& oQueryDescs, const cv::Mat_<float>& oTrainDescs, int nK, std::vector<std::vector<cv::DMatch>>& vvMatches) const {
+    lvAssert_((oQueryDescs.dims==2 || oQueryDescs.dims==3) && oQueryDescs.size[oQueryDescs.dims-1]==m_nRadialBins*m_nAngularBins,"unexpected query descriptor size");
+    lvAssert_((oTrainDescs.dims==2 || oTrainDescs.dims==3) && oTrainDescs.size[oTrainDescs.dims-1]==m_nRadialBins*m_nAngularBins,"unexpected train descriptor size");
+    DescMatcher(DescMatcher::Dist_L2).knnMatch(oQueryDescs,oTrainDescs,nK,vvMatches);
+}
+
 void ShapeContext::scdesc_generate_radmask() {
     m_vRadialLimits.resize((size_t)m_nRadialBins);
     const double dMin = m_bUseRelativeSpace?m_dInnerRadius:(double)m_nInnerRadius;
@@ -401,6 +541,7 @@ void ShapeContext::scdesc_generate_emdmask() {
         }
         m_oEMDCostMap /= m_vRadialLimits.back()/2; // normalize costs based on half desc radius
     }
+    m_pApproxEMD = std::make_shared<const SinkhornEMD>(m_oEMDCostMap);
 }
 
 void ShapeContext::scdesc_fill_contours(const cv::Mat& oImage) {
@@ -413,8 +554,18 @@ void ShapeContext::scdesc_fill_contours(const cv::Mat& oImage) {
         cv::dilate(m_oBinMask,m_oDistMask,m_oDilateKernel);
     cv::findContours(m_oBinMask,vvContours,cv::RETR_LIST,cv::CHAIN_APPROX_NONE);
     size_t nContourPtCount = size_t(0);
-    for(size_t nContourIdx=0; nContourIdx<vvContours.size(); ++nContourIdx)
+    m_vContourRowOffsets.assign(size_t(m_oCurrImageSize.height+1),0);
+    for(size_t nContourIdx=0; nContourIdx<vvContours.size(); ++nContourIdx) {
         nContourPtCount += vvContours[nContourIdx].size();
+        for(size_t nPointIdx=0; nPointIdx<vvContours[nContourIdx].size(); ++nPointIdx)
+            ++m_vContourRowOffsets[vvContours[nContourIdx][nPointIdx].y+1];
+    }
+    std::partial_sum(m_vContourRowOffsets.begin(),m_vContourRowOffsets.end(),m_vContourRowOffsets.begin());
+    m_vContourColIdxs.resize(nContourPtCount);
+    std::vector<int> vContourRowFillIdxs(m_vContourRowOffsets.begin(),m_vContourRowOffsets.end()-1);
+    for(size_t nContourIdx=0; nContourIdx<vvContours.size(); ++nContourIdx)
+        for(size_t nPointIdx=0; nPointIdx<vvContours[nContourIdx].size(); ++nPointIdx)
+            m_vContourColIdxs[vContourRowFillIdxs[vvContours[nContourIdx][nPointIdx].y]++] = vvContours[nContourIdx][nPointIdx].x;
     if(nContourPtCount>0) {
         m_oContourPts.create((int)nContourPtCount,1);
         int nContourPtIdx = 0;
@@ -432,83 +583,113 @@ void ShapeContext::scdesc_fill_contours(const cv::Mat& oImage) {
 #endif //HAVE_CUDA
 }
 
-void ShapeContext::scdesc_fill_maps(double dMeanDist) {
-    lvDbgAssert(m_oContourPts.type()==CV_32FC2 && (m_oContourPts.total()==(size_t)m_oContourPts.rows || m_oContourPts.total()==(size_t)m_oContourPts.cols));
-    lvDbgAssert(m_oKeyPts.type()==CV_32FC2 && (m_oKeyPts.total()==(size_t)m_oKeyPts.rows || m_oKeyPts.total()==(size_t)m_oKeyPts.cols));
-    lvDbgAssert(m_oKeyPts.total()>size_t(0));
-    if(m_oContourPts.empty())
-        return;
-    m_oDistMap.create((int)m_oKeyPts.total(),(int)m_oContourPts.total());
-    m_oAngMap.create((int)m_oKeyPts.total(),(int)m_oContourPts.total());
-    cv::Point2f vMassCenter(0,0);
-    if(m_bRotationInvariant) {
-        for(int nContourPtIdx=0; nContourPtIdx<(int)m_oContourPts.total(); ++nContourPtIdx)
-            vMassCenter += ((cv::Point2f*)m_oContourPts.data)[nContourPtIdx];
-        vMassCenter.x = vMassCenter.x/m_oContourPts.total();
-        vMassCenter.y = vMassCenter.y/m_oContourPts.total();
-    }
-    cv::Matx12f vPtDiff;
-    for(int nKeyPtIdx=0; nKeyPtIdx<(int)m_oKeyPts.total(); ++nKeyPtIdx) {
-        for(int nContourPtIdx=0; nContourPtIdx<(int)m_oContourPts.total(); ++nContourPtIdx) {
-            const cv::Point2f& vKeyPt = ((cv::Point2f*)m_oKeyPts.data)[nKeyPtIdx];
-            const cv::Point2f& vContourPt = ((cv::Point2f*)m_oContourPts.data)[nContourPtIdx];
-            vPtDiff(0) = vKeyPt.y-vContourPt.y;
-            vPtDiff(1) = vKeyPt.x-vContourPt.x;
-            m_oDistMap(nKeyPtIdx,nContourPtIdx) = cv::norm(vPtDiff,cv::NORM_L2);
-            if(m_oDistMap(nKeyPtIdx,nContourPtIdx)<0.01)
-                m_oAngMap(nKeyPtIdx,nContourPtIdx) = 0.0;
-            else {
-                m_oAngMap(nKeyPtIdx,nContourPtIdx) = std::atan2(vPtDiff(0),-vPtDiff(1));
-                if(m_bRotationInvariant) {
-                    const cv::Point2d vRefPt = vContourPt-vMassCenter;
-                    m_oAngMap(nKeyPtIdx,nContourPtIdx) -= std::atan2(-vRefPt.y,vRefPt.x);
-                }
-                m_oAngMap(nKeyPtIdx,nContourPtIdx) = std::fmod(m_oAngMap(nKeyPtIdx,nContourPtIdx)+2*CV_PI+FLT_EPSILON,2*CV_PI);
-            }
-        }
-    }
-    if(m_bUseRelativeSpace) {
-        if(dMeanDist<0)
-            dMeanDist = cv::mean(m_oDistMap)[0];
-        m_oDistMap /= (dMeanDist+FLT_EPSILON);
-    }
-}
-
 void ShapeContext::scdesc_fill_desc(cv::Mat_<float>& oDescriptors, bool bGenDescMap) {
     if(m_oKeyPts.empty()) {
         oDescriptors.release();
         return;
     }
+    lvDbgAssert(m_oContourPts.empty() || (m_oContourPts.type()==CV_32FC2 && (m_oContourPts.total()==(size_t)m_oContourPts.rows || m_oContourPts.total()==(size_t)m_oContourPts.cols)));
+    lvDbgAssert(m_oKeyPts.type()==CV_32FC2 && (m_oKeyPts.total()==(size_t)m_oKeyPts.rows || m_oKeyPts.total()==(size_t)m_oKeyPts.cols));
     if(bGenDescMap)
         oDescriptors.create(3,std::array<int,3>{m_oCurrImageSize.height,m_oCurrImageSize.width,m_nDescSize}.data());
     else
         oDescriptors.create((int)m_oKeyPts.total(),m_nDescSize);
     oDescriptors = m_bNonZeroInitBins?std::max(10.0f/m_nDescSize,0.5f):0.0f;
-    scdesc_fill_maps();
-    for(int nKeyPtIdx=0; nKeyPtIdx<(int)m_oKeyPts.total(); ++nKeyPtIdx) {
-        const cv::Point2f& vKeyPt = ((cv::Point2f*)m_oKeyPts.data)[nKeyPtIdx];
-        const int nKeyPtRowIdx = (int)std::round(vKeyPt.y);
-        const int nKeyPtColIdx = (int)std::round(vKeyPt.x);
-        float* aDesc = bGenDescMap?oDescriptors.ptr<float>(nKeyPtRowIdx,nKeyPtColIdx):oDescriptors.ptr<float>(nKeyPtIdx);
-        for(int nContourPtIdx=0; nContourPtIdx<(int)m_oContourPts.total(); ++nContourPtIdx) {
-            const cv::Point2f& vContourPt = ((cv::Point2f*)m_oContourPts.data)[nContourPtIdx];
-            if(std::abs(vKeyPt.x-vContourPt.x)<0.01f && std::abs(vKeyPt.y-vContourPt.y)<0.01f)
-                continue;
-            int nAngularBinMatch=-1,nRadialBinMatch=-1;
-            for(int nRadialBinIdx=0; nRadialBinIdx<m_nRadialBins; ++nRadialBinIdx) {
-                if(m_oDistMap(nKeyPtIdx,nContourPtIdx)<m_vRadialLimits[nRadialBinIdx]) {
-                    nRadialBinMatch = nRadialBinIdx;
-                    break;
+    const int nKeyPts = (int)m_oKeyPts.total();
+    const int nContourPts = (int)m_oContourPts.total();
+    if(nContourPts>0) {
+        const cv::Point2f* avKeyPts = (cv::Point2f*)m_oKeyPts.data;
+        const cv::Point2f* avContourPts = (cv::Point2f*)m_oContourPts.data;
+        // contour coords are split in separate arrays for vectorized distance computations
+        static thread_local lv::AutoBuffer<float> s_afContourPtCoords;
+        s_afContourPtCoords.resize(size_t(nContourPts*2));
+        float* afContourPtX = s_afContourPtCoords.data();
+        float* afContourPtY = afContourPtX+nContourPts;
+        for(int nContourPtIdx=0; nContourPtIdx<nContourPts; ++nContourPtIdx) {
+            afContourPtX[nContourPtIdx] = avContourPts[nContourPtIdx].x;
+            afContourPtY[nContourPtIdx] = avContourPts[nContourPtIdx].y;
+        }
+        static thread_local lv::AutoBuffer<double> s_adContourRefAngles;
+        if(m_bRotationInvariant) {
+            s_adContourRefAngles.resize(size_t(nContourPts));
+            cv::Point2f vMassCenter(0,0);
+            for(int nContourPtIdx=0; nContourPtIdx<nContourPts; ++nContourPtIdx)
+                vMassCenter += avContourPts[nContourPtIdx];
+            vMassCenter.x = vMassCenter.x/nContourPts;
+            vMassCenter.y = vMassCenter.y/nContourPts;
+            for(int nContourPtIdx=0; nContourPtIdx<nContourPts; ++nContourPtIdx) {
+                const cv::Point2d vRefPt = avContourPts[nContourPtIdx]-vMassCenter;
+                s_adContourRefAngles[nContourPtIdx] = std::atan2(-vRefPt.y,vRefPt.x);
+            }
+        }
+        const double* adContourRefAngles = s_adContourRefAngles.data();
+        const lv::SIMDInstrSet eInstrSet = m_eInstrSet;
+        lvIgnore(eInstrSet);
+        double dDistNorm = 1.0;
+        if(m_bUseRelativeSpace) {
+            // per-keypoint sums are kept apart so that the mean distance does not depend on thread scheduling
+            static thread_local lv::AutoBuffer<double> s_adKeyPtDistSums;
+            s_adKeyPtDistSums.resize(size_t(nKeyPts));
+            double* adKeyPtDistSums = s_adKeyPtDistSums.data();
+        #if USING_OPENMP
+            #pragma omp parallel for
+        #endif //USING_OPENMP
+            for(int nKeyPtIdx=0; nKeyPtIdx<nKeyPts; ++nKeyPtIdx) {
+            #if HAVE_AVX2
+                if(eInstrSet==lv::SIMD_AVX2) {
+                    adKeyPtDistSums[nKeyPtIdx] = sc_calcDistSum_avx2(avKeyPts[nKeyPtIdx].x,avKeyPts[nKeyPtIdx].y,afContourPtX,afContourPtY,nContourPts);
+                    continue;
                 }
+            #endif //HAVE_AVX2
+                adKeyPtDistSums[nKeyPtIdx] = sc_calcDistSum_scalar(avKeyPts[nKeyPtIdx].x,avKeyPts[nKeyPtIdx].y,afContourPtX,afContourPtY,nContourPts);
             }
-            for(int nAngularBinIdx=0; nAngularBinIdx<m_nAngularBins; ++nAngularBinIdx) {
-                if(m_oAngMap(nKeyPtIdx,nContourPtIdx)<m_vAngularLimits[nAngularBinIdx]) {
-                    nAngularBinMatch = nAngularBinIdx;
-                    break;
+            const double dMeanDist = std::accumulate(adKeyPtDistSums,adKeyPtDistSums+nKeyPts,0.0)/(double(nKeyPts)*nContourPts);
+            dDistNorm = dMeanDist+FLT_EPSILON;
+        }
+        const double* adRadialLimits = m_vRadialLimits.data();
+        const double* adAngularLimits = m_vAngularLimits.data();
+        const int nRadialBins = m_nRadialBins;
+        const int nAngularBins = m_nAngularBins;
+        const bool bRotationInvariant = m_bRotationInvariant;
+    #if USING_OPENMP
+        #pragma omp parallel for
+    #endif //USING_OPENMP
+        for(int nKeyPtIdx=0; nKeyPtIdx<nKeyPts; ++nKeyPtIdx) {
+            const cv::Point2f& vKeyPt = avKeyPts[nKeyPtIdx];
+            const int nKeyPtRowIdx = (int)std::round(vKeyPt.y);
+            const int nKeyPtColIdx = (int)std::round(vKeyPt.x);
+            float* aDesc = bGenDescMap?oDescriptors.ptr<float>(nKeyPtRowIdx,nKeyPtColIdx):oDescriptors.ptr<float>(nKeyPtIdx);
+            static thread_local lv::AutoBuffer<int> s_anRadialBins;
+            s_anRadialBins.resize(size_t(nContourPts));
+            int* anRadialBins = s_anRadialBins.data();
+            int nContourPtIdx = 0;
+        #if HAVE_AVX2
+            if(eInstrSet==lv::SIMD_AVX2)
+                nContourPtIdx = sc_fillRadialBins_avx2(vKeyPt.x,vKeyPt.y,afContourPtX,afContourPtY,nContourPts,dDistNorm,adRadialLimits,nRadialBins,anRadialBins);
+        #endif //HAVE_AVX2
+            for(; nContourPtIdx<nContourPts; ++nContourPtIdx)
+                anRadialBins[nContourPtIdx] = sc_getRadialBin(vKeyPt.x-afContourPtX[nContourPtIdx],vKeyPt.y-afContourPtY[nContourPtIdx],dDistNorm,adRadialLimits,nRadialBins);
+            for(nContourPtIdx=0; nContourPtIdx<nContourPts; ++nContourPtIdx) {
+                const int nRadialBinMatch = anRadialBins[nContourPtIdx];
+                if(nRadialBinMatch>=nRadialBins)
+                    continue;
+                const float fDiffX = vKeyPt.x-afContourPtX[nContourPtIdx], fDiffY = vKeyPt.y-afContourPtY[nContourPtIdx];
+                if(std::abs(fDiffX)<0.01f && std::abs(fDiffY)<0.01f)
+                    continue;
+                // angles are only computed for contour points that fall in a radial bin
+                double dAngle = 0.0;
+                if(std::sqrt(double(fDiffY)*fDiffY+double(fDiffX)*fDiffX)>=0.01) {
+                    dAngle = std::atan2(fDiffY,-fDiffX);
+                    if(bRotationInvariant)
+                        dAngle -= adContourRefAngles[nContourPtIdx];
+                    dAngle = std::fmod(dAngle+2*CV_PI+FLT_EPSILON,2*CV_PI);
                 }
+                int nAngularBinMatch = 0;
+                while(nAngularBinMatch<nAngularBins && adAngularLimits[nAngularBinMatch]<=dAngle)
+                    ++nAngularBinMatch;
+                if(nAngularBinMatch<nAngularBins)
+                    ++(aDesc[nAngularBinMatch+nRadialBinMatch*nAngularBins]);
             }
-            if(nAngularBinMatch!=-1 && nRadialBinMatch!=-1)
-                ++(aDesc[nAngularBinMatch+nRadialBinMatch*m_nAngularBins]);
         }
     }
     if(m_bNormalizeBins)
@@ -552,6 +733,40 @@ void ShapeContext::scdesc_fill_desc_direct(cv::Mat_<float>& oDescriptors, bool b
     else
         oDescriptors.create((int)m_oKeyPts.total(),m_nDescSize);
     oDescriptors = m_bNonZeroInitBins?std::max(10.0f/m_nDescSize,0.5f):0.0f;
+#if USE_LIENHART_LOOKUP_MASK
+    lvDbgAssert((int)m_vContourRowOffsets.size()==m_oCurrImageSize.height+1 && (int)m_vContourColIdxs.size()==(int)m_oContourPts.total());
+    if(bGenDescMap && m_bUsingFullKeyPtMap) {
+        // for full maps, each contour point is scattered into the descriptors of its neighborhood via the cached lookup mask bins
+        const int nRows = m_oCurrImageSize.height;
+        const int nCols = m_oCurrImageSize.width;
+    #if USING_OPENMP
+        #pragma omp parallel for schedule(dynamic)
+    #endif //USING_OPENMP
+        for(int nBandRowIdx=0; nBandRowIdx<nRows; nBandRowIdx+=s_nDenseBandRows) {
+            const int nBandEndRowIdx = std::min(nBandRowIdx+s_nDenseBandRows,nRows);
+            // contour points are visited by all bands they can reach, but only update the descriptors of the current band
+            const int nContourRowEndIdx = std::min(nBandEndRowIdx+m_nOuterRadius,nRows);
+            for(int nContourRowIdx=std::max(nBandRowIdx-m_nOuterRadius,0); nContourRowIdx<nContourRowEndIdx; ++nContourRowIdx) {
+                for(int nContourPtIdx=m_vContourRowOffsets[nContourRowIdx]; nContourPtIdx<m_vContourRowOffsets[nContourRowIdx+1]; ++nContourPtIdx) {
+                    const int nContourColIdx = m_vContourColIdxs[nContourPtIdx];
+                    const int nRowEndIdx = std::min(nBandEndRowIdx,nContourRowIdx+m_nOuterRadius+1);
+                    for(int nRowIdx=std::max(nBandRowIdx,nContourRowIdx-m_nOuterRadius); nRowIdx<nRowEndIdx; ++nRowIdx) {
+                        const uchar* abDistMask = m_oDistMask.ptr<uchar>(nRowIdx);
+                        float* aDescRow = oDescriptors.ptr<float>(nRowIdx,0);
+                        for(const std::pair<int,int>& oLookupBin : m_vvAbsDescLUMapRowBins[nContourRowIdx-nRowIdx+m_nOuterRadius]) {
+                            const int nColIdx = nContourColIdx-oLookupBin.first+m_nOuterRadius;
+                            if(nColIdx>=0 && nColIdx<nCols && abDistMask[nColIdx])
+                                ++(aDescRow[nColIdx*m_nDescSize+oLookupBin.second]);
+                        }
+                    }
+                }
+            }
+        }
+        if(m_bNormalizeBins)
+            scdesc_norm(oDescriptors);
+        return;
+    }
+#endif //USE_LIENHART_LOOKUP_MASK
 #if USING_OPENMP
     #pragma omp parallel for
 #endif //USING_OPENMP
@@ -562,15 +777,21 @@ void ShapeContext::scdesc_fill_desc_direct(cv::Mat_<float>& oDescriptors, bool b
         if(!m_oDistMask(nKeyPtRowIdx,nKeyPtColIdx))
             continue;
         float* aDesc = bGenDescMap?oDescriptors.ptr<float>(nKeyPtRowIdx,nKeyPtColIdx):oDescriptors.ptr<float>(nKeyPtIdx);
+    #if USE_LIENHART_LOOKUP_MASK
+        // only contour rows that can round into the lookup mask are visited
+        const int nContourRowEndIdx = std::min(nKeyPtRowIdx+m_nOuterRadius+2,m_oCurrImageSize.height);
+        for(int nContourRowIdx=std::max(nKeyPtRowIdx-m_nOuterRadius-1,0); nContourRowIdx<nContourRowEndIdx; ++nContourRowIdx) {
+            for(int nContourPtIdx=m_vContourRowOffsets[nContourRowIdx]; nContourPtIdx<m_vContourRowOffsets[nContourRowIdx+1]; ++nContourPtIdx) {
+                const int nLookupRow = (int)std::round(float(nContourRowIdx)-vKeyPt.y)+m_nOuterRadius;
+                const int nLookupCol = (int)std::round(float(m_vContourColIdxs[nContourPtIdx])-vKeyPt.x)+m_nOuterRadius;
+                if(nLookupRow<0 || nLookupRow>=m_oAbsDescLUMap.rows || nLookupCol<0 || nLookupCol>=m_oAbsDescLUMap.cols || m_oAbsDescLUMap(nLookupRow,nLookupCol)==-1)
+                    continue;
+                ++(aDesc[m_oAbsDescLUMap(nLookupRow,nLookupCol)]);
+            }
+        }
+    #else //!USE_LIENHART_LOOKUP_MASK
         for(int nContourPtIdx=0; nContourPtIdx<(int)m_oContourPts.total(); ++nContourPtIdx) {
             const cv::Point2f& vContourPt = ((cv::Point2f*)m_oContourPts.data)[nContourPtIdx];
-        #if USE_LIENHART_LOOKUP_MASK
-            const int nLookupRow = (int)std::round(vContourPt.y-vKeyPt.y)+m_nOuterRadius;
-            const int nLookupCol = (int)std::round(vContourPt.x-vKeyPt.x)+m_nOuterRadius;
-            if(nLookupRow<0 || nLookupRow>=m_oAbsDescLUMap.rows || nLookupCol<0 || nLookupCol>=m_oAbsDescLUMap.cols || m_oAbsDescLUMap(nLookupRow,nLookupCol)==-1)
-                continue;
-            ++(aDesc[m_oAbsDescLUMap(nLookupRow,nLookupCol)]);
-        #else //!USE_LIENHART_LOOKUP_MASK
             cv::Matx12f vPtDiff;
             vPtDiff(0) = vKeyPt.y-vContourPt.y;
             vPtDiff(1) = vKeyPt.x-vContourPt.x;
@@ -597,8 +818,8 @@ void ShapeContext::scdesc_fill_desc_direct(cv::Mat_<float>& oDescriptors, bool b
             if(nAngularBinMatch<0)
                 continue;
             ++(aDesc[nAngularBinMatch+nRadialBinMatch*m_nAngularBins]);
-        #endif //!USE_LIENHART_LOOKUP_MASK
         }
+    #endif //!USE_LIENHART_LOOKUP_MASK
     }
     if(m_bNormalizeBins)
         scdesc_norm(oDescriptors);
@@ -284,4 +284,164 @@ TEST(dasc_gf,regression_large_compute) {
     else
         lv::write(TEST_CURR_INPUT_DATA_ROOT "/test_dasc_gf_large.bin",oOutputDescs);
 #endif //ndef(_MSC_VER)
-}
\ No newline at end of file
+}
+
+TEST(dasc,regression_repeated_compute) {
+    // LUT entries are filtered by workers w/ persistent scratch data; make sure nothing leaks between calls
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    const cv::Mat oInputCrop1 = oInput(cv::Rect(300,100,96,64)).clone();
+    const cv::Mat oInputCrop2 = oInput(cv::Rect(20,200,128,48)).clone();
+    for(bool bUsingRF : {true,false}) {
+        std::unique_ptr<DASC> pDASC = bUsingRF?std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR):std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS);
+        cv::Mat_<float> oDescMap1, oDescMap2, oDescMap3;
+        pDASC->compute2(oInputCrop1,oDescMap1);
+        pDASC->compute2(oInputCrop2,oDescMap2);
+        pDASC->compute2(oInputCrop1,oDescMap3);
+        ASSERT_EQ(oDescMap2.size[0],oInputCrop2.rows);
+        ASSERT_EQ(oDescMap2.size[1],oInputCrop2.cols);
+        ASSERT_TRUE(lv::isEqual<float>(oDescMap1,oDescMap3)) << "bUsingRF=" << bUsingRF;
+        for(int nRowIdx=0; nRowIdx<oDescMap1.size[0]; ++nRowIdx) {
+            for(int nColIdx=0; nColIdx<oDescMap1.size[1]; ++nColIdx) {
+                const cv::Mat_<float> oDesc(1,oDescMap1.size[2],oDescMap1.ptr<float>(nRowIdx,nColIdx));
+                ASSERT_NEAR(cv::norm(oDesc,cv::NORM_L2),1.0,0.0001) << "bUsingRF=" << bUsingRF;
+            }
+        }
+    }
+}
+
+TEST(dasc,regression_temporal_compute) {
+    // recursive filters are not local, so their cached map is only reused for fully static frames; guided filters only update the
+    // row bands around changed pixels
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    const cv::Rect oFrameROI(300,100,96,160);
+    cv::Mat oFrame = oInput(oFrameROI).clone();
+    for(bool bUsingRF : {true,false}) {
+        std::unique_ptr<DASC> pDASC = bUsingRF?std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR):std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS);
+        cv::Mat_<float> oDescMap, oDescMap_ref;
+        cv::Mat oChangeMask(oFrame.size(),CV_8UC1,cv::Scalar_<uchar>(0));
+        pDASC->compute2Temporal(oFrame,oChangeMask,oDescMap); // no cached map = full compute
+        pDASC->compute2(oFrame,oDescMap_ref);
+        ASSERT_TRUE(lv::isEqual<float>(oDescMap,oDescMap_ref)) << "bUsingRF=" << bUsingRF;
+        oDescMap(10,10,0) = -1.0f; // tags the cached map to make sure it is kept as-is
+        pDASC->compute2Temporal(oFrame,oChangeMask,oDescMap);
+        ASSERT_EQ(oDescMap(10,10,0),-1.0f) << "bUsingRF=" << bUsingRF;
+        oDescMap(10,10,0) = oDescMap_ref(10,10,0);
+        oDescMap(150,10,0) = -1.0f; // far from the change below, only kept by partial updates
+        oFrame.at<cv::Vec3b>(20,30) = cv::Vec3b(255,0,255);
+        oChangeMask.at<uchar>(20,30) = 255;
+        pDASC->compute2Temporal(oFrame,oChangeMask,oDescMap);
+        pDASC->compute2(oFrame,oDescMap_ref);
+        if(bUsingRF)
+            ASSERT_TRUE(lv::isEqual<float>(oDescMap,oDescMap_ref));
+        else {
+            ASSERT_EQ(oDescMap(150,10,0),-1.0f);
+            oDescMap(150,10,0) = oDescMap_ref(150,10,0);
+            ASSERT_TRUE((lv::isNearlyEqual<float,float>(oDescMap,oDescMap_ref,1e-5f)));
+        }
+        oFrame = oInput(oFrameROI).clone();
+    }
+}
+
+TEST(dasc,regression_batch_compute) {
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    std::vector<cv::Mat> voImages;
+    for(int nImageIdx=0; nImageIdx<7; ++nImageIdx)
+        voImages.push_back(oInput(cv::Rect(20+nImageIdx*40,40+nImageIdx*10,64+(nImageIdx%3)*16,48+(nImageIdx%2)*16)).clone());
+    for(bool bUsingRF : {true,false}) {
+        std::unique_ptr<DASC> pDASC = bUsingRF?std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR):std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS);
+        std::vector<cv::Mat_<float>> voRefDescMaps(voImages.size());
+        for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx)
+            pDASC->compute2(voImages[nImageIdx],voRefDescMaps[nImageIdx]);
+        for(size_t nWorkers : {1,3,0}) {
+            pDASC->setBatchWorkerCount(nWorkers);
+            ASSERT_EQ(pDASC->getBatchWorkerCount(),nWorkers);
+            std::vector<cv::Mat_<float>> voDescMaps;
+            pDASC->compute2(voImages,voDescMaps);
+            ASSERT_EQ(voDescMaps.size(),voImages.size());
+            std::vector<const float*> vpDescMapData;
+            for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx) {
+                ASSERT_TRUE(lv::isEqual<float>(voDescMaps[nImageIdx],voRefDescMaps[nImageIdx])) << "bUsingRF=" << bUsingRF << ", nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+                vpDescMapData.push_back(voDescMaps[nImageIdx].ptr<float>(0));
+            }
+            pDASC->compute2(voImages,voDescMaps); // preallocated maps must be reused as-is
+            for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx) {
+                ASSERT_EQ(voDescMaps[nImageIdx].ptr<float>(0),vpDescMapData[nImageIdx]);
+                ASSERT_TRUE(lv::isEqual<float>(voDescMaps[nImageIdx],voRefDescMaps[nImageIdx])) << "bUsingRF=" << bUsingRF << ", nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+            }
+        }
+    }
+    DASC oDASC(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR);
+    std::vector<cv::Mat_<float>> voDescMaps;
+    voImages[3] = cv::Mat();
+    ASSERT_THROW_LV_QUIET(oDASC.compute2(voImages,voDescMaps));
+}
+
+TEST(dasc,regression_knn_match) {
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    DASC oDASC(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR);
+    cv::Mat_<float> oDescMap;
+    oDASC.compute2(oInput(cv::Rect(100,80,48,40)).clone(),oDescMap);
+    ASSERT_EQ(oDescMap.dims,3);
+    const int nDescSize = oDescMap.size[2];
+    const cv::Mat_<float> oTrainDescs(oDescMap.size[0]*oDescMap.size[1],nDescSize,(float*)oDescMap.data);
+    const cv::Mat_<float> oQueryDescs = oTrainDescs.rowRange(500,540).clone();
+    const int nK = 4;
+    std::vector<std::vector<cv::DMatch>> vvMatches;
+    oDASC.knnMatch(oQueryDescs,oDescMap,nK,vvMatches);
+    ASSERT_EQ(vvMatches.size(),size_t(oQueryDescs.rows));
+    for(int nQueryIdx=0; nQueryIdx<oQueryDescs.rows; ++nQueryIdx) {
+        ASSERT_EQ(vvMatches[nQueryIdx].size(),size_t(nK));
+        ASSERT_FLOAT_EQ(vvMatches[nQueryIdx][0].distance,0.0f); // the query itself is part of the train map
+        ASSERT_LE(vvMatches[nQueryIdx][0].trainIdx,500+nQueryIdx);
+        for(int nNeighbIdx=0; nNeighbIdx<nK; ++nNeighbIdx) {
+            const cv::DMatch& oMatch = vvMatches[nQueryIdx][nNeighbIdx];
+            ASSERT_NEAR(oMatch.distance,oDASC.calcDistance(oQueryDescs.ptr<float>(nQueryIdx),oTrainDescs.ptr<float>(oMatch.trainIdx)),1e-4);
+            if(nNeighbIdx>0)
+                ASSERT_GE(oMatch.distance,vvMatches[nQueryIdx][nNeighbIdx-1].distance);
+        }
+    }
+    ASSERT_THROW_LV_QUIET(oDASC.knnMatch(oQueryDescs.colRange(0,nDescSize-1).clone(),oDescMap,nK,vvMatches));
+}
+
+namespace {
+
+    void dasc_batch_perftest(benchmark::State& st) {
+        const size_t nWorkers = size_t(st.range(0));
+        const size_t nImages = size_t(st.range(1)); // small batches (e.g. stereo pairs) should be processed serially with inner parallelism
+        const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+        lvAssert(!oInput.empty());
+        cv::Mat oInputVGA;
+        cv::resize(oInput,oInputVGA,cv::Size(640,480));
+        const std::vector<cv::Mat> voImages(nImages,oInputVGA);
+        DASC oDASC(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR);
+        oDASC.setBatchWorkerCount(nWorkers);
+        std::vector<cv::Mat_<float>> voDescMaps;
+        while(st.KeepRunning()) {
+            oDASC.compute2(voImages,voDescMaps);
+            benchmark::DoNotOptimize(voDescMaps.back().data);
+        }
+    }
+
+    void dasc_vga_perftest(benchmark::State& st) {
+        const bool bUsingRF = st.range(0)!=0;
+        const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+        lvAssert(!oInput.empty());
+        cv::Mat oInputVGA;
+        cv::resize(oInput,oInputVGA,cv::Size(640,480));
+        std::unique_ptr<DASC> pDASC = bUsingRF?std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR):std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS);
+        cv::Mat_<float> oDescMap;
+        while(st.KeepRunning()) {
+            pDASC->compute2(oInputVGA,oDescMap);
+            benchmark::DoNotOptimize(oDescMap.data);
+        }
+        st.SetLabel(bUsingRF?"rf":"gf");
+    }
+
+}
+
+BENCHMARK(dasc_vga_perftest)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(dasc_batch_perftest)->Args({1,8})->Args({0,8})->Args({1,2})->Args({0,2})->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
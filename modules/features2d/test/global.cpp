@@ -110,4 +110,225 @@ TEST(calcJointProbHist,regression_2d3vnz_quant) {
     lTester(lv::calcJointProbHist<64,true,false,false>(std::make_tuple(test1,test2)),false,true);
     lTester(lv::calcJointProbHist<64,true,true,false>(std::make_tuple(test1,test2)),false,true);
     lTester(lv::calcJointProbHist<64,true,true,true>(std::make_tuple(test1,test2)),true,true);
-}
\ No newline at end of file
+}
+
+TEST(getDescMapUpdateRegions,regression) {
+    cv::RNG oRNG(42);
+    const cv::Size oSize(157,113);
+    for(int nSupportRadius : {0,2,23}) {
+        for(bool bFullRowBands : {false,true}) {
+            cv::Mat oChangeMask(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+            ASSERT_TRUE(lv::getDescMapUpdateRegions(oChangeMask,nSupportRadius,32,bFullRowBands).empty());
+            for(int nChangeIdx=0; nChangeIdx<5; ++nChangeIdx)
+                oChangeMask.at<uchar>(oRNG.uniform(0,oSize.height),oRNG.uniform(0,oSize.width)) = uchar(oRNG.uniform(1,256));
+            const std::vector<cv::Rect> voRegions = lv::getDescMapUpdateRegions(oChangeMask,nSupportRadius,32,bFullRowBands);
+            cv::Mat_<int> oCoverage(oSize,0);
+            for(const cv::Rect& oRegion : voRegions) {
+                ASSERT_EQ(oRegion&cv::Rect(cv::Point(0,0),oSize),oRegion);
+                if(bFullRowBands)
+                    ASSERT_EQ(oRegion.width,oSize.width);
+                oCoverage(oRegion) += 1;
+            }
+            // every pixel within the support radius of a change must be covered exactly once
+            cv::Mat oDilatedMask;
+            cv::dilate(oChangeMask,oDilatedMask,cv::getStructuringElement(cv::MORPH_RECT,cv::Size(nSupportRadius*2+1,nSupportRadius*2+1)));
+            double dMaxCoverage;
+            cv::minMaxIdx(oCoverage,nullptr,&dMaxCoverage);
+            ASSERT_EQ(dMaxCoverage,1.0);
+            for(int nRowIdx=0; nRowIdx<oSize.height; ++nRowIdx)
+                for(int nColIdx=0; nColIdx<oSize.width; ++nColIdx)
+                    if(oDilatedMask.at<uchar>(nRowIdx,nColIdx))
+                        ASSERT_EQ(oCoverage(nRowIdx,nColIdx),1) << "radius=" << nSupportRadius << ", bands=" << bFullRowBands;
+        }
+    }
+    ASSERT_THROW_LV_QUIET(lv::getDescMapUpdateRegions(cv::Mat(),2,32));
+    ASSERT_THROW_LV_QUIET(lv::getDescMapUpdateRegions(cv::Mat_<float>(10,10,0.0f),2,32));
+}
+
+TEST(QuantizedDescMap,regression) {
+    cv::RNG oRNG(42);
+    for(int nDescSize : {1,36,128}) {
+        cv::Mat_<float> oDescMap1(3,std::array<int,3>{23,31,nDescSize}.data()),oDescMap2(oDescMap1.dims,oDescMap1.size.p);
+        oRNG.fill(oDescMap1,cv::RNG::UNIFORM,0.0f,2.0f);
+        oRNG.fill(oDescMap2,cv::RNG::UNIFORM,0.0f,0.5f);
+        oDescMap1(std::array<int,3>{4,5,0}.data()) = 0.0f;
+        ((float*)oDescMap2.data)[0] = 37.0f; // single large outlier bin in first desc
+        std::fill_n(oDescMap2.ptr<float>(7,8),nDescSize,0.0f); // null desc
+        lv::QuantizedDescMap oQuantMap1(oDescMap1),oQuantMap2;
+        oQuantMap2.quantize(oDescMap2);
+        ASSERT_FALSE(oQuantMap1.empty());
+        ASSERT_EQ(oQuantMap1.descSize(),nDescSize);
+        ASSERT_EQ(oQuantMap1.descCount(),23*31);
+        ASSERT_EQ(oQuantMap1.oBins.dims,3);
+        ASSERT_EQ(oQuantMap1.oScales.rows,23);
+        ASSERT_EQ(oQuantMap1.oScales.cols,31);
+        ASSERT_EQ(oQuantMap1.byteCount(),size_t(23*31*(nDescSize+4)));
+        if(nDescSize>4)
+            ASSERT_LT(oQuantMap1.byteCount(),oDescMap1.total()*sizeof(float));
+        ASSERT_FLOAT_EQ(oQuantMap2.scale(7,8),0.0f);
+        cv::Mat_<float> oDecodedMap1,oDecodedMap2;
+        oQuantMap1.dequantize(oDecodedMap1);
+        oQuantMap2.dequantize(oDecodedMap2);
+        ASSERT_EQ(lv::MatInfo(oDecodedMap1),lv::MatInfo(oDescMap1));
+        for(int nDescIdx=0; nDescIdx<oQuantMap1.descCount(); ++nDescIdx) {
+            for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+                const size_t nOffset = size_t(nDescIdx)*size_t(nDescSize)+size_t(nBinIdx);
+                ASSERT_NEAR(((float*)oDecodedMap1.data)[nOffset],((float*)oDescMap1.data)[nOffset],oQuantMap1.scale(nDescIdx)*0.501f);
+                ASSERT_NEAR(((float*)oDecodedMap2.data)[nOffset],((float*)oDescMap2.data)[nOffset],oQuantMap2.scale(nDescIdx)*0.501f);
+            }
+        }
+        cv::Mat_<float> oDistances;
+        lv::QuantizedDescMap::calcDistances_L2(oQuantMap1,oQuantMap2,oDistances);
+        ASSERT_EQ(oDistances.rows,23);
+        ASSERT_EQ(oDistances.cols,31);
+        for(int nRowIdx=0; nRowIdx<23; ++nRowIdx) {
+            for(int nColIdx=0; nColIdx<31; ++nColIdx) {
+                const cv::Mat_<float> oDesc1(1,nDescSize,oDescMap1.ptr<float>(nRowIdx,nColIdx)),oDesc2(1,nDescSize,oDescMap2.ptr<float>(nRowIdx,nColIdx));
+                const cv::Mat_<float> oDecodedDesc1(1,nDescSize,oDecodedMap1.ptr<float>(nRowIdx,nColIdx)),oDecodedDesc2(1,nDescSize,oDecodedMap2.ptr<float>(nRowIdx,nColIdx));
+                const double dMaxError = std::sqrt(double(nDescSize))*0.501*(oQuantMap1.scale(nRowIdx,nColIdx)+oQuantMap2.scale(nRowIdx,nColIdx));
+                ASSERT_NEAR(oDistances(nRowIdx,nColIdx),cv::norm(oDecodedDesc1,oDecodedDesc2,cv::NORM_L2),1e-3*(1.0+cv::norm(oDecodedDesc1,oDecodedDesc2,cv::NORM_L2)));
+                ASSERT_NEAR(oDistances(nRowIdx,nColIdx),cv::norm(oDesc1,oDesc2,cv::NORM_L2),dMaxError+1e-4);
+                ASSERT_FLOAT_EQ(oDistances(nRowIdx,nColIdx),(float)oQuantMap1.calcDistance_L2(nRowIdx*31+nColIdx,oQuantMap2,nRowIdx*31+nColIdx));
+            }
+        }
+        const uchar* pBinsData = oQuantMap1.oBins.data;
+        oQuantMap1.quantize(oDescMap2); // preallocated storage must be reused as-is
+        ASSERT_EQ(oQuantMap1.oBins.data,pBinsData);
+        ASSERT_TRUE(lv::isEqual<uchar>(oQuantMap1.oBins,oQuantMap2.oBins));
+        ASSERT_TRUE(lv::isEqual<float>(oQuantMap1.oScales,oQuantMap2.oScales));
+        lv::QuantizedDescMap oQuantMap3(cv::Mat_<float>(23*31,nDescSize,(float*)oDescMap1.data));
+        ASSERT_EQ(oQuantMap3.oBins.dims,2);
+        ASSERT_EQ(oQuantMap3.oScales.rows,23*31);
+        ASSERT_EQ(oQuantMap3.oScales.cols,1);
+        ASSERT_THROW_LV_QUIET(lv::QuantizedDescMap::calcDistances_L2(oQuantMap2,oQuantMap3,oDistances));
+    }
+    lv::QuantizedDescMap oEmptyMap;
+    ASSERT_TRUE(oEmptyMap.empty());
+    ASSERT_THROW_LV_QUIET(oEmptyMap.quantize(cv::Mat_<float>()));
+}
+
+namespace {
+
+    /// brute-force reference for DescMatcher tests (double accumulation, scalar popcount)
+    double calcRefDistance(const cv::Mat& oDescs1, int nDescIdx1, const cv::Mat& oDescs2, int nDescIdx2, DescMatcher::DistType eDist) {
+        if(eDist==DescMatcher::Dist_Hamming) {
+            const size_t nDescBytes = oDescs1.cols*oDescs1.elemSize();
+            int nDist = 0;
+            for(size_t nByteIdx=0; nByteIdx<nDescBytes; ++nByteIdx)
+                nDist += lv::popcount<uchar,int>(oDescs1.ptr<uchar>(nDescIdx1)[nByteIdx]^oDescs2.ptr<uchar>(nDescIdx2)[nByteIdx]);
+            return double(nDist);
+        }
+        return cv::norm(oDescs1.row(nDescIdx1),oDescs2.row(nDescIdx2),(eDist==DescMatcher::Dist_L2)?cv::NORM_L2:cv::NORM_L1);
+    }
+
+}
+
+TEST(DescMatcher,regression) {
+    cv::RNG oRNG(13);
+    for(DescMatcher::DistType eDist : {DescMatcher::Dist_L1,DescMatcher::Dist_L2,DescMatcher::Dist_Hamming}) {
+        for(int nDescSize : {1,7,36,129}) {
+            cv::Mat oQueryDescs(151,nDescSize,(eDist==DescMatcher::Dist_Hamming)?CV_8UC1:CV_32FC1);
+            cv::Mat oTrainDescs(389,nDescSize,oQueryDescs.type());
+            if(eDist==DescMatcher::Dist_Hamming) {
+                oRNG.fill(oQueryDescs,cv::RNG::UNIFORM,0,256);
+                oRNG.fill(oTrainDescs,cv::RNG::UNIFORM,0,256);
+            }
+            else {
+                oRNG.fill(oQueryDescs,cv::RNG::UNIFORM,0.0f,1.0f);
+                oRNG.fill(oTrainDescs,cv::RNG::UNIFORM,0.0f,1.0f);
+            }
+            oTrainDescs.row(17).copyTo(oQueryDescs.row(3)); // exact match
+            oTrainDescs.row(211).copyTo(oTrainDescs.row(212)); // tie (lower train index must come first)
+            oTrainDescs.row(211).copyTo(oQueryDescs.row(150));
+            for(lv::SIMDInstrSet eInstrSet : {lv::SIMD_None,lv::SIMD_AVX2}) {
+                DescMatcher oMatcher(eDist);
+                oMatcher.setInstrSet(eInstrSet);
+                ASSERT_TRUE(oMatcher.getInstrSet()==lv::SIMD_None || oMatcher.getInstrSet()==lv::SIMD_AVX2);
+                ASSERT_EQ(oMatcher.getDistType(),eDist);
+                cv::Mat_<float> oDistMatrix;
+                oMatcher.calcDistanceMatrix(oQueryDescs,oTrainDescs,oDistMatrix);
+                ASSERT_EQ(oDistMatrix.rows,oQueryDescs.rows);
+                ASSERT_EQ(oDistMatrix.cols,oTrainDescs.rows);
+                for(int nQueryIdx=0; nQueryIdx<oQueryDescs.rows; ++nQueryIdx) {
+                    for(int nTrainIdx=0; nTrainIdx<oTrainDescs.rows; ++nTrainIdx) {
+                        const double dRefDist = calcRefDistance(oQueryDescs,nQueryIdx,oTrainDescs,nTrainIdx,eDist);
+                        ASSERT_NEAR(oDistMatrix(nQueryIdx,nTrainIdx),dRefDist,1e-4*(1.0+dRefDist)) << "eDist=" << eDist << ", nDescSize=" << nDescSize;
+                    }
+                }
+                const int nK = 5;
+                cv::Mat_<int> oIndices;
+                cv::Mat_<float> oDistances;
+                oMatcher.knnMatch(oQueryDescs,oTrainDescs,nK,oIndices,oDistances);
+                ASSERT_EQ(oIndices.rows,oQueryDescs.rows);
+                ASSERT_EQ(oIndices.cols,nK);
+                for(int nQueryIdx=0; nQueryIdx<oQueryDescs.rows; ++nQueryIdx) {
+                    std::vector<std::pair<float,int>> vSortedDists;
+                    for(int nTrainIdx=0; nTrainIdx<oTrainDescs.rows; ++nTrainIdx)
+                        vSortedDists.emplace_back(oDistMatrix(nQueryIdx,nTrainIdx),nTrainIdx);
+                    std::stable_sort(vSortedDists.begin(),vSortedDists.end(),[](const auto& a, const auto& b){return a.first<b.first;});
+                    for(int nNeighbIdx=0; nNeighbIdx<nK; ++nNeighbIdx) {
+                        ASSERT_EQ(oDistances(nQueryIdx,nNeighbIdx),vSortedDists[nNeighbIdx].first) << "eDist=" << eDist << ", nDescSize=" << nDescSize;
+                        ASSERT_EQ(oIndices(nQueryIdx,nNeighbIdx),vSortedDists[nNeighbIdx].second) << "eDist=" << eDist << ", nDescSize=" << nDescSize;
+                    }
+                }
+                ASSERT_EQ(oIndices(3,0),17);
+                ASSERT_FLOAT_EQ(oDistances(3,0),0.0f);
+                ASSERT_EQ(oIndices(150,0),211);
+                ASSERT_EQ(oIndices(150,1),212);
+                std::vector<std::vector<cv::DMatch>> vvMatches;
+                oMatcher.knnMatch(oQueryDescs,oTrainDescs,nK,vvMatches);
+                ASSERT_EQ(vvMatches.size(),size_t(oQueryDescs.rows));
+                for(int nQueryIdx=0; nQueryIdx<oQueryDescs.rows; ++nQueryIdx) {
+                    ASSERT_EQ(vvMatches[nQueryIdx].size(),size_t(nK));
+                    for(int nNeighbIdx=0; nNeighbIdx<nK; ++nNeighbIdx) {
+                        ASSERT_EQ(vvMatches[nQueryIdx][nNeighbIdx].queryIdx,nQueryIdx);
+                        ASSERT_EQ(vvMatches[nQueryIdx][nNeighbIdx].trainIdx,oIndices(nQueryIdx,nNeighbIdx));
+                        ASSERT_EQ(vvMatches[nQueryIdx][nNeighbIdx].distance,oDistances(nQueryIdx,nNeighbIdx));
+                    }
+                }
+                cv::Mat_<float> oPairDists;
+                oMatcher.calcDistances(oQueryDescs,oTrainDescs.rowRange(0,oQueryDescs.rows),oPairDists);
+                ASSERT_EQ(oPairDists.rows,oQueryDescs.rows);
+                ASSERT_EQ(oPairDists.cols,1);
+                for(int nDescIdx=0; nDescIdx<oQueryDescs.rows; ++nDescIdx) {
+                    // one-to-one distances keep double accumulation, so they match the reference up to the final float rounding
+                    ASSERT_FLOAT_EQ(oPairDists(nDescIdx),(float)calcRefDistance(oQueryDescs,nDescIdx,oTrainDescs,nDescIdx,eDist)) << "eDist=" << eDist << ", nDescSize=" << nDescSize;
+                    ASSERT_NEAR(oPairDists(nDescIdx),oDistMatrix(nDescIdx,nDescIdx),1e-4*(1.0+oPairDists(nDescIdx))) << "eDist=" << eDist << ", nDescSize=" << nDescSize;
+                }
+            }
+        }
+    }
+    DescMatcher oMatcher(DescMatcher::Dist_L2);
+    const cv::Mat_<float> oSmallTrainDescs(2,8,1.0f);
+    std::vector<std::vector<cv::DMatch>> vvMatches;
+    oMatcher.knnMatch(cv::Mat_<float>(3,8,0.0f),oSmallTrainDescs,4,vvMatches); // k larger than train set
+    ASSERT_EQ(vvMatches.size(),size_t(3));
+    ASSERT_EQ(vvMatches[0].size(),size_t(2));
+    cv::Mat_<float> oDistMatrix;
+    ASSERT_THROW_LV_QUIET(oMatcher.calcDistanceMatrix(cv::Mat_<float>(3,7,0.0f),oSmallTrainDescs,oDistMatrix));
+    ASSERT_THROW_LV_QUIET(oMatcher.calcDistanceMatrix(cv::Mat_<uchar>(3,8,uchar(0)),cv::Mat_<uchar>(2,8,uchar(0)),oDistMatrix));
+    ASSERT_THROW_LV_QUIET(oMatcher.knnMatch(cv::Mat_<float>(3,8,0.0f),oSmallTrainDescs,0,vvMatches));
+}
+
+namespace {
+
+    void descmatcher_knn_perftest(benchmark::State& st) {
+        const DescMatcher::DistType eDist = (DescMatcher::DistType)st.range(0);
+        const int nDescSize = (eDist==DescMatcher::Dist_Hamming)?32:128;
+        cv::Mat oQueryDescs(2000,nDescSize,(eDist==DescMatcher::Dist_Hamming)?CV_8UC1:CV_32FC1);
+        cv::Mat oTrainDescs(5000,nDescSize,oQueryDescs.type());
+        cv::randu(oQueryDescs,0,(eDist==DescMatcher::Dist_Hamming)?256:1);
+        cv::randu(oTrainDescs,0,(eDist==DescMatcher::Dist_Hamming)?256:1);
+        DescMatcher oMatcher(eDist);
+        if(st.range(1)==0)
+            oMatcher.setInstrSet(lv::SIMD_None);
+        std::vector<std::vector<cv::DMatch>> vvMatches;
+        while(st.KeepRunning()) {
+            oMatcher.knnMatch(oQueryDescs,oTrainDescs,2,vvMatches);
+            benchmark::DoNotOptimize(vvMatches.data());
+        }
+    }
+
+}
+
+BENCHMARK(descmatcher_knn_perftest)->Args({1,0})->Args({1,1})->Args({2,0})->Args({2,1})->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -77,4 +77,201 @@ TEST(lbsp,regression_compute) {
             ++nKeyPointIdx;
         }
     }
-}
\ No newline at end of file
+}
+
+namespace {
+
+    /// returns the dense LBSP descriptor map obtained via the keypoint-based (per-pixel) impl, used as reference
+    cv::Mat computeKeyPointDescMap(const LBSP& oLBSP, const cv::Mat& oInput) {
+        std::vector<cv::KeyPoint> vKeyPoints;
+        for(int nRowIdx=0; nRowIdx<oInput.rows; ++nRowIdx)
+            for(int nColIdx=0; nColIdx<oInput.cols; ++nColIdx)
+                vKeyPoints.emplace_back(cv::Point2f(float(nColIdx),float(nRowIdx)),float(LBSP::PATCH_SIZE));
+        cv::Mat oDescMap;
+        oLBSP.compute2(oInput,vKeyPoints,oDescMap);
+        return oDescMap;
+    }
+
+}
+
+TEST(lbsp,regression_compute_dense_simd) {
+    const int nBorderSize = int(LBSP::PATCH_SIZE)/2;
+    cv::RNG oRNG(42);
+    for(int nChannels : {1,3}) {
+        for(const cv::Size& oSize : {cv::Size(5,5),cv::Size(37,23),cv::Size(160,120)}) {
+            cv::Mat oInput(oSize,CV_8UC(nChannels)), oRef(oSize,CV_8UC(nChannels));
+            oRNG.fill(oInput,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+            oRNG.fill(oRef,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+            const cv::Rect oValidZone(nBorderSize,nBorderSize,oSize.width-nBorderSize*2,oSize.height-nBorderSize*2);
+            for(bool bUseRelThreshold : {false,true}) {
+                for(bool bUseRefImage : {false,true}) {
+                    std::unique_ptr<LBSP> pLBSP = bUseRelThreshold?std::make_unique<LBSP>(0.365f,size_t(3)):std::make_unique<LBSP>(size_t(30));
+                    if(bUseRefImage)
+                        pLBSP->setReference(oRef);
+                    const cv::Mat oDescMap_ref = computeKeyPointDescMap(*pLBSP,oInput)(oValidZone).clone();
+                    for(lv::SIMDInstrSet eInstrSet : {lv::SIMD_None,lv::SIMD_SSE2,lv::SIMD_AVX2}) {
+                        pLBSP->setInstrSet(eInstrSet);
+                        ASSERT_LE(pLBSP->getInstrSet(),eInstrSet);
+                        cv::Mat oDescMap;
+                        pLBSP->compute2(oInput,oDescMap);
+                        ASSERT_EQ(oDescMap.size(),oSize);
+                        ASSERT_EQ(oDescMap.type(),CV_16UC(nChannels));
+                        ASSERT_TRUE(lv::isEqual<ushort>(oDescMap(oValidZone).clone(),oDescMap_ref))
+                            << "nChannels=" << nChannels << ", size=" << oSize << ", rel=" << bUseRelThreshold << ", ref=" << bUseRefImage << ", isa=" << (int)eInstrSet;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(lbsp,regression_batch_compute) {
+    cv::RNG oRNG(42);
+    std::vector<cv::Mat> voImages;
+    for(int nImageIdx=0; nImageIdx<9; ++nImageIdx) {
+        voImages.emplace_back(cv::Size(37+nImageIdx*11,23+nImageIdx*5),CV_8UC3);
+        oRNG.fill(voImages.back(),cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+    }
+    LBSP oLBSP(0.365f);
+    std::vector<cv::Mat> voRefDescMaps(voImages.size());
+    for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx)
+        oLBSP.compute2(voImages[nImageIdx],voRefDescMaps[nImageIdx]);
+    for(size_t nWorkers : {1,4,0}) {
+        oLBSP.setBatchWorkerCount(nWorkers);
+        ASSERT_EQ(oLBSP.getBatchWorkerCount(),nWorkers);
+        std::vector<cv::Mat> voDescMaps;
+        oLBSP.compute2(voImages,voDescMaps);
+        ASSERT_EQ(voDescMaps.size(),voImages.size());
+        for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx)
+            ASSERT_TRUE(lv::isEqual<ushort>(voDescMaps[nImageIdx],voRefDescMaps[nImageIdx])) << "nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+    }
+}
+
+TEST(lbsp,regression_temporal_compute) {
+    const int nBorderSize = int(LBSP::PATCH_SIZE)/2;
+    cv::RNG oRNG(42);
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        const cv::Rect oValidZone(nBorderSize,nBorderSize,oSize.width-nBorderSize*2,oSize.height-nBorderSize*2);
+        cv::Mat oFrame(oSize,CV_8UC(nChannels));
+        oRNG.fill(oFrame,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+        LBSP oLBSP(0.365f);
+        cv::Mat oDescMap, oDescMap_ref;
+        oLBSP.compute2Temporal(oFrame,cv::Mat(),oDescMap); // no change mask = full compute
+        oLBSP.compute2(oFrame,oDescMap_ref);
+        ASSERT_TRUE(lv::isEqual<ushort>(oDescMap(oValidZone).clone(),oDescMap_ref(oValidZone).clone()));
+        for(int nFrameIdx=0; nFrameIdx<10; ++nFrameIdx) {
+            cv::Mat oChangeMask(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+            const int nChanges = (nFrameIdx==9)?60:oRNG.uniform(0,4); // last frame changes most of the image (full recompute)
+            for(int nChangeIdx=0; nChangeIdx<nChanges; ++nChangeIdx) {
+                const cv::Point oTopLeft(oRNG.uniform(0,oSize.width),oRNG.uniform(0,oSize.height));
+                const cv::Rect oChange = cv::Rect(oTopLeft,cv::Size(oRNG.uniform(1,40),oRNG.uniform(1,40)))&cv::Rect(cv::Point(0,0),oSize);
+                cv::Mat oChangedPatch = oFrame(oChange);
+                oRNG.fill(oChangedPatch,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+                oChangeMask(oChange).setTo(255);
+            }
+            const uchar* pPrevDescMapData = oDescMap.data;
+            oLBSP.compute2Temporal(oFrame,oChangeMask,oDescMap);
+            ASSERT_EQ(oDescMap.data,pPrevDescMapData); // cached map is updated in place
+            ASSERT_EQ(oDescMap.size(),oSize);
+            ASSERT_EQ(oDescMap.type(),CV_16UC(nChannels));
+            oLBSP.compute2(oFrame,oDescMap_ref);
+            ASSERT_TRUE(lv::isEqual<ushort>(oDescMap(oValidZone).clone(),oDescMap_ref(oValidZone).clone())) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+        const cv::Mat oSmallFrame = oFrame(cv::Rect(10,10,50,40)).clone();
+        oLBSP.compute2Temporal(oSmallFrame,cv::Mat(oSmallFrame.size(),CV_8UC1,cv::Scalar_<uchar>(255)),oDescMap); // size mismatch = full compute
+        oLBSP.compute2(oSmallFrame,oDescMap_ref);
+        const cv::Rect oSmallValidZone(nBorderSize,nBorderSize,oSmallFrame.cols-nBorderSize*2,oSmallFrame.rows-nBorderSize*2);
+        ASSERT_TRUE(lv::isEqual<ushort>(oDescMap(oSmallValidZone).clone(),oDescMap_ref(oSmallValidZone).clone()));
+        ASSERT_THROW_LV_QUIET(oLBSP.compute2Temporal(oFrame,cv::Mat(oSize,CV_32FC1),oDescMap));
+    }
+}
+
+TEST(lbsp,regression_knn_match) {
+    cv::RNG oRNG(42);
+    cv::Mat oInput(41,53,CV_8UC3);
+    oRNG.fill(oInput,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+    LBSP oLBSP(0.365f);
+    cv::Mat oDescMap;
+    oLBSP.compute2(oInput,oDescMap);
+    ASSERT_EQ(oDescMap.type(),CV_16UC3);
+    const cv::Mat oQueryDescs = oDescMap.rowRange(10,13).clone();
+    const int nK = 3;
+    std::vector<std::vector<cv::DMatch>> vvMatches;
+    LBSP::knnMatch(oQueryDescs,oDescMap,nK,vvMatches);
+    ASSERT_EQ(vvMatches.size(),oQueryDescs.total());
+    for(int nQueryIdx=0; nQueryIdx<int(oQueryDescs.total()); ++nQueryIdx) {
+        const ushort* anQueryDesc = oQueryDescs.ptr<ushort>(nQueryIdx/oQueryDescs.cols,nQueryIdx%oQueryDescs.cols);
+        std::vector<int> vnDists;
+        for(int nTrainIdx=0; nTrainIdx<int(oDescMap.total()); ++nTrainIdx)
+            vnDists.push_back(lv::hdist<3,ushort,int>(anQueryDesc,oDescMap.ptr<ushort>(nTrainIdx/oDescMap.cols,nTrainIdx%oDescMap.cols)));
+        ASSERT_EQ(vvMatches[nQueryIdx].size(),size_t(nK));
+        ASSERT_FLOAT_EQ(vvMatches[nQueryIdx][0].distance,0.0f); // the query itself is part of the train map
+        std::vector<int> vnSortedDists = vnDists;
+        std::sort(vnSortedDists.begin(),vnSortedDists.end());
+        for(int nNeighbIdx=0; nNeighbIdx<nK; ++nNeighbIdx) {
+            const cv::DMatch& oMatch = vvMatches[nQueryIdx][nNeighbIdx];
+            ASSERT_EQ(oMatch.queryIdx,nQueryIdx);
+            ASSERT_EQ(oMatch.distance,float(vnSortedDists[nNeighbIdx]));
+            ASSERT_EQ(oMatch.distance,float(vnDists[oMatch.trainIdx]));
+        }
+    }
+    ASSERT_THROW_LV_QUIET(LBSP::knnMatch(cv::Mat_<float>(3,3,0.0f),oDescMap,nK,vvMatches));
+}
+
+namespace {
+
+    /// frame sizes used in dense LBSP benchmarks (720p & 4K)
+    const std::array<cv::Size,2> s_aoPerfTestSizes = {cv::Size(1280,720),cv::Size(3840,2160)};
+
+    void lbsp_dense_perftest(benchmark::State& st) {
+        const cv::Size oSize = s_aoPerfTestSizes[st.range(0)];
+        const lv::SIMDInstrSet eInstrSet = (lv::SIMDInstrSet)st.range(1);
+        cv::Mat oInput(oSize,CV_8UC3);
+        cv::RNG oRNG(42);
+        oRNG.fill(oInput,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+        LBSP oLBSP(0.365f);
+        oLBSP.setInstrSet(eInstrSet);
+        cv::Mat oDescMap;
+        while(st.KeepRunning()) {
+            oLBSP.compute2(oInput,oDescMap);
+            benchmark::DoNotOptimize(oDescMap.data);
+        }
+        std::stringstream ssLabel;
+        ssLabel << oSize << ", isa=" << (int)oLBSP.getInstrSet();
+        st.SetLabel(ssLabel.str());
+    }
+
+    void lbsp_temporal_perftest(benchmark::State& st) {
+        // mostly static scene: one small moving object per frame, with the cached map updated around it
+        const cv::Size oSize = s_aoPerfTestSizes[0];
+        const bool bUseTemporal = st.range(0)!=0;
+        cv::Mat oFrame(oSize,CV_8UC3);
+        cv::RNG oRNG(42);
+        oRNG.fill(oFrame,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+        LBSP oLBSP(0.365f);
+        cv::Mat oDescMap;
+        oLBSP.compute2(oFrame,oDescMap);
+        cv::Mat oChangeMask(oSize,CV_8UC1);
+        int nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            const cv::Rect oChange(((nFrameIdx++)*8)%(oSize.width-64),oSize.height/2,64,96);
+            cv::Mat oChangedPatch = oFrame(oChange);
+            oRNG.fill(oChangedPatch,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+            if(bUseTemporal) {
+                oChangeMask.setTo(0);
+                oChangeMask(oChange).setTo(255);
+                oLBSP.compute2Temporal(oFrame,oChangeMask,oDescMap);
+            }
+            else
+                oLBSP.compute2(oFrame,oDescMap);
+            benchmark::DoNotOptimize(oDescMap.data);
+        }
+        st.SetLabel(bUseTemporal?"temporal":"full");
+    }
+
+}
+
+BENCHMARK(lbsp_dense_perftest)->Args({0,lv::SIMD_None})->Args({0,lv::SIMD_SSE2})->Args({0,lv::SIMD_AVX2})->Args({1,lv::SIMD_None})->Args({1,lv::SIMD_SSE2})->Args({1,lv::SIMD_AVX2})
+                              ->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(lbsp_temporal_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
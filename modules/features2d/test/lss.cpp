@@ -206,4 +206,139 @@ TEST(lss,regression_large_transl_invert_compute) {
     const cv::Mat_<float> oOutputKPDesc2(3,std::array<int,3>{1,1,oOutputDescMap2.size[2]}.data(),oOutputDescMap2.ptr<float>(oTargetPt_new.y,oTargetPt_new.x));
     ASSERT_FLOAT_EQ((float)cv::norm(oOutputKPDesc2,cv::NORM_L2),1.0f);
     ASSERT_NEAR(float(pLSS->calcDistance(oOutputKPDesc1,oOutputKPDesc2)),0.0f,(float)1e-5);
-}
\ No newline at end of file
+}
+
+TEST(lss,regression_dense_vs_keypoints) {
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    for(bool bUseGrayscale : {false,true}) {
+        for(bool bNormalizeBins : {false,true}) {
+            std::unique_ptr<LSS> pLSS = std::make_unique<LSS>(LSS_DEFAULT_INNER_RADIUS,10,LSS_DEFAULT_PATCH_SIZE,LSS_DEFAULT_ANGULAR_BINS,LSS_DEFAULT_RADIAL_BINS,LSS_DEFAULT_STATNOISE_VAR,bNormalizeBins);
+            cv::Mat oInputCrop = oInput(cv::Rect(300,100,64,48)).clone();
+            if(bUseGrayscale)
+                cv::cvtColor(oInputCrop,oInputCrop,cv::COLOR_BGR2GRAY);
+            const int nBorderSize = pLSS->borderSize();
+            std::vector<cv::KeyPoint> vKeyPoints;
+            for(int nRowIdx=nBorderSize; nRowIdx<oInputCrop.rows-nBorderSize; ++nRowIdx)
+                for(int nColIdx=nBorderSize; nColIdx<oInputCrop.cols-nBorderSize; ++nColIdx)
+                    vKeyPoints.emplace_back(cv::Point2f(float(nColIdx),float(nRowIdx)),float(pLSS->windowSize().width));
+            cv::Mat_<float> oDescMap_dense, oDescMap_keypts;
+            pLSS->compute2(oInputCrop,oDescMap_dense);
+            pLSS->compute2(oInputCrop,vKeyPoints,oDescMap_keypts);
+            ASSERT_EQ(oDescMap_dense.size,oDescMap_keypts.size);
+            for(int nRowIdx=nBorderSize; nRowIdx<oInputCrop.rows-nBorderSize; ++nRowIdx)
+                for(int nColIdx=nBorderSize; nColIdx<oInputCrop.cols-nBorderSize; ++nColIdx)
+                    for(int nDescIdx=0; nDescIdx<oDescMap_dense.size[2]; ++nDescIdx)
+                        ASSERT_FLOAT_EQ(oDescMap_dense(nRowIdx,nColIdx,nDescIdx),oDescMap_keypts(nRowIdx,nColIdx,nDescIdx))
+                            << "gray=" << bUseGrayscale << ", norm=" << bNormalizeBins << ", row=" << nRowIdx << ", col=" << nColIdx << ", bin=" << nDescIdx;
+        }
+    }
+}
+
+TEST(lss,regression_batch_compute) {
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    std::vector<cv::Mat> voImages;
+    for(int nImageIdx=0; nImageIdx<5; ++nImageIdx)
+        voImages.push_back(oInput(cv::Rect(30+nImageIdx*50,60,48+nImageIdx*8,64-nImageIdx*4)).clone());
+    LSS oLSS;
+    std::vector<cv::Mat_<float>> voRefDescMaps(voImages.size());
+    for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx)
+        oLSS.compute2(voImages[nImageIdx],voRefDescMaps[nImageIdx]);
+    for(size_t nWorkers : {1,2,0}) {
+        oLSS.setBatchWorkerCount(nWorkers);
+        ASSERT_EQ(oLSS.getBatchWorkerCount(),nWorkers);
+        std::vector<cv::Mat_<float>> voDescMaps;
+        oLSS.compute2(voImages,voDescMaps);
+        ASSERT_EQ(voDescMaps.size(),voImages.size());
+        for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx)
+            ASSERT_TRUE(lv::isEqual<float>(voDescMaps[nImageIdx],voRefDescMaps[nImageIdx])) << "nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+    }
+    std::vector<cv::Mat_<float>> voDescMaps;
+    voImages[2] = voImages[2](cv::Rect(0,0,10,10)).clone(); // too small for the correlation window
+    ASSERT_THROW_LV_QUIET(oLSS.compute2(voImages,voDescMaps));
+}
+
+TEST(lss,regression_temporal_compute) {
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty() && oInput.cols>=320 && oInput.rows>=240);
+    cv::RNG oRNG(42);
+    for(bool bPreProcess : {true,false}) {
+        cv::Mat oFrame = oInput(cv::Rect(0,0,320,240)).clone();
+        LSS oLSS(LSS_DEFAULT_INNER_RADIUS,LSS_DEFAULT_OUTER_RADIUS,LSS_DEFAULT_PATCH_SIZE,LSS_DEFAULT_ANGULAR_BINS,LSS_DEFAULT_RADIAL_BINS,
+                 LSS_DEFAULT_STATNOISE_VAR,LSS_DEFAULT_NORM_BINS,bPreProcess);
+        cv::Mat_<float> oDescMap, oDescMap_ref;
+        oLSS.compute2Temporal(oFrame,cv::Mat(),oDescMap); // no change mask = full compute
+        oLSS.compute2(oFrame,oDescMap_ref);
+        ASSERT_TRUE(lv::isEqual<float>(oDescMap,oDescMap_ref));
+        for(int nFrameIdx=0; nFrameIdx<6; ++nFrameIdx) {
+            cv::Mat oChangeMask(oFrame.size(),CV_8UC1,cv::Scalar_<uchar>(0));
+            const int nChanges = (nFrameIdx==5)?20:oRNG.uniform(0,3); // last frame changes most of the image (full recompute)
+            for(int nChangeIdx=0; nChangeIdx<nChanges; ++nChangeIdx) {
+                const cv::Point oTopLeft(oRNG.uniform(0,oFrame.cols),oRNG.uniform(0,oFrame.rows));
+                const cv::Rect oChange = cv::Rect(oTopLeft,cv::Size(oRNG.uniform(1,16),oRNG.uniform(1,16)))&cv::Rect(cv::Point(0,0),oFrame.size());
+                cv::Mat oChangedPatch = oFrame(oChange);
+                oRNG.fill(oChangedPatch,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+                oChangeMask(oChange).setTo(255);
+            }
+            const uchar* pPrevDescMapData = oDescMap.data;
+            oLSS.compute2Temporal(oFrame,oChangeMask,oDescMap);
+            ASSERT_EQ(oDescMap.data,pPrevDescMapData); // cached map is updated in place
+            oLSS.compute2(oFrame,oDescMap_ref);
+            ASSERT_TRUE(lv::isEqual<float>(oDescMap,oDescMap_ref)) << "bPreProcess=" << bPreProcess << ", nFrameIdx=" << nFrameIdx;
+        }
+    }
+}
+
+namespace {
+
+    void lss_dense_perftest(benchmark::State& st) {
+        const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+        lvAssert(!oInput.empty());
+        const cv::Size oSize = st.range(0)?cv::Size(640,480):cv::Size(320,240);
+        cv::Mat oInputResized;
+        cv::resize(oInput,oInputResized,oSize);
+        std::unique_ptr<LSS> pLSS = std::make_unique<LSS>();
+        cv::Mat_<float> oDescMap;
+        while(st.KeepRunning()) {
+            pLSS->compute2(oInputResized,oDescMap);
+            benchmark::DoNotOptimize(oDescMap.data);
+        }
+        std::stringstream ssLabel;
+        ssLabel << oSize;
+        st.SetLabel(ssLabel.str());
+    }
+
+    void lss_temporal_perftest(benchmark::State& st) {
+        // mostly static scene: one small moving object per frame, with the cached map updated around it
+        const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+        lvAssert(!oInput.empty());
+        const bool bUseTemporal = st.range(0)!=0;
+        cv::Mat oFrame;
+        cv::resize(oInput,oFrame,cv::Size(640,480));
+        cv::RNG oRNG(42);
+        std::unique_ptr<LSS> pLSS = std::make_unique<LSS>();
+        cv::Mat_<float> oDescMap;
+        pLSS->compute2(oFrame,oDescMap);
+        cv::Mat oChangeMask(oFrame.size(),CV_8UC1);
+        int nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            const cv::Rect oChange(((nFrameIdx++)*8)%(oFrame.cols-32),oFrame.rows/2,32,48);
+            cv::Mat oChangedPatch = oFrame(oChange);
+            oRNG.fill(oChangedPatch,cv::RNG::UNIFORM,cv::Scalar::all(0),cv::Scalar::all(256));
+            if(bUseTemporal) {
+                oChangeMask.setTo(0);
+                oChangeMask(oChange).setTo(255);
+                pLSS->compute2Temporal(oFrame,oChangeMask,oDescMap);
+            }
+            else
+                pLSS->compute2(oFrame,oDescMap);
+            benchmark::DoNotOptimize(oDescMap.data);
+        }
+        st.SetLabel(bUseTemporal?"temporal":"full");
+    }
+
+}
+
+BENCHMARK(lss_dense_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(lss_temporal_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
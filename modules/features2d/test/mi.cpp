@@ -56,4 +56,53 @@ TEST(mi,regression_compute) {
     }
     else
         lv::write(TEST_CURR_INPUT_DATA_ROOT "/test_mi.bin",oOutputScoresMat);
-}
\ No newline at end of file
+}
+TEST(mi,regression_dense_compute) {
+    const cv::Mat oInput1 = cv::imread(SAMPLES_DATA_ROOT "/multispectral_stereo_ex/img2.png",cv::IMREAD_GRAYSCALE);
+    ASSERT_TRUE(!oInput1.empty());
+    const cv::Mat oInput2 = cv::imread(SAMPLES_DATA_ROOT "/multispectral_stereo_ex/img1_corr_h0v8.png",cv::IMREAD_GRAYSCALE);
+    ASSERT_TRUE(!oInput2.empty() && oInput1.size()==oInput2.size());
+    const cv::Rect oCropZone(520,60,140,120);
+    const cv::Mat oInputCrop1 = oInput1(oCropZone), oInputCrop2 = oInput2(oCropZone);
+    for(bool bNormalize : {false,true}) {
+        for(const cv::Size& oWinSize : {cv::Size(41,41),cv::Size(9,15)}) {
+            std::unique_ptr<MutualInfo> pMI = std::make_unique<MutualInfo>(oWinSize,bNormalize);
+            cv::Mat_<double> oScoreMap;
+            pMI->compute2(oInputCrop1,oInputCrop2,oScoreMap);
+            ASSERT_EQ(oScoreMap.size(),oCropZone.size());
+            std::vector<cv::KeyPoint> vKeyPoints;
+            for(int nRowIdx=0; nRowIdx<oCropZone.height; ++nRowIdx)
+                for(int nColIdx=0; nColIdx<oCropZone.width; ++nColIdx)
+                    vKeyPoints.emplace_back(cv::Point2f(float(nColIdx),float(nRowIdx)),float(std::max(oWinSize.height,oWinSize.width)));
+            pMI->validateKeyPoints(vKeyPoints,oCropZone.size());
+            const std::vector<double> vScores = pMI->compute(oInputCrop1,oInputCrop2,vKeyPoints);
+            for(size_t nKPIdx=0; nKPIdx<vKeyPoints.size(); ++nKPIdx)
+                ASSERT_NEAR(oScoreMap(cv::Point(vKeyPoints[nKPIdx].pt)),vScores[nKPIdx],1e-5) << "bNormalize=" << bNormalize << ", oWinSize=" << oWinSize << ", pt=" << vKeyPoints[nKPIdx].pt;
+            ASSERT_EQ(oScoreMap(0,0),0.0);
+            ASSERT_EQ(oScoreMap(oCropZone.height-1,oCropZone.width-1),0.0);
+        }
+    }
+    std::unique_ptr<MutualInfo> pMI = std::make_unique<MutualInfo>();
+    const cv::Mat oInputColor = cv::imread(SAMPLES_DATA_ROOT "/multispectral_stereo_ex/img2.png");
+    cv::Mat_<double> oScoreMap;
+    ASSERT_THROW_LV_QUIET(pMI->compute2(oInputColor,oInput2,oScoreMap));
+    ASSERT_THROW_LV_QUIET(pMI->compute2(oInputCrop1(cv::Rect(0,0,20,20)),oInputCrop2(cv::Rect(0,0,20,20)),oScoreMap));
+}
+
+namespace {
+
+    void mi_dense_perftest(benchmark::State& st) {
+        const cv::Mat oInput1 = cv::imread(SAMPLES_DATA_ROOT "/multispectral_stereo_ex/img2.png",cv::IMREAD_GRAYSCALE);
+        const cv::Mat oInput2 = cv::imread(SAMPLES_DATA_ROOT "/multispectral_stereo_ex/img1_corr_h0v8.png",cv::IMREAD_GRAYSCALE);
+        lvAssert(!oInput1.empty() && !oInput2.empty());
+        std::unique_ptr<MutualInfo> pMI = std::make_unique<MutualInfo>(cv::Size(int(st.range(0)),int(st.range(0))),true);
+        cv::Mat_<double> oScoreMap;
+        while(st.KeepRunning()) {
+            pMI->compute2(oInput1,oInput2,oScoreMap);
+            benchmark::DoNotOptimize(oScoreMap.data);
+        }
+    }
+
+}
+
+BENCHMARK(mi_dense_perftest)->Arg(15)->Arg(41)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
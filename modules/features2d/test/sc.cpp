@@ -481,6 +481,59 @@ TEST(sc,regression_full_compute_rel) {
     ASSERT_EQ(oOutputDescs.cols,oOutputDescMap.size[2]);
 }
 
+TEST(sc,regression_dense_abs_vs_keypoints) {
+    std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(size_t(2),size_t(20),12,5,false,false);
+#if HAVE_CUDA
+    pShapeContext->enableCUDA(false);
+#endif //HAVE_CUDA
+    cv::Mat oInput(97,131,CV_8UC1);
+    oInput = 0;
+    cv::circle(oInput,cv::Point(40,50),9,cv::Scalar_<uchar>(255),-1);
+    cv::rectangle(oInput,cv::Point(80,10),cv::Point(125,30),cv::Scalar_<uchar>(255),-1);
+    cv::line(oInput,cv::Point(0,96),cv::Point(130,60),cv::Scalar_<uchar>(255));
+    oInput = oInput>0;
+    std::vector<cv::KeyPoint> vKeyPoints;
+    for(int nRowIdx=0; nRowIdx<oInput.rows; ++nRowIdx)
+        for(int nColIdx=0; nColIdx<oInput.cols; ++nColIdx)
+            vKeyPoints.emplace_back(cv::Point2f(float(nColIdx),float(nRowIdx)),1.0f);
+    cv::Mat_<float> oOutputDescMap, oOutputDescs;
+    pShapeContext->compute2(oInput,oOutputDescMap);
+    pShapeContext->compute(oInput,vKeyPoints,oOutputDescs);
+    ASSERT_EQ(oOutputDescs.rows,oInput.rows*oInput.cols);
+    ASSERT_EQ(oOutputDescMap.total(),oOutputDescs.total());
+    ASSERT_TRUE(cv::countNonZero(oOutputDescs>1.0f)>0);
+    for(size_t nIdx=0; nIdx<oOutputDescs.total(); ++nIdx)
+        ASSERT_FLOAT_EQ(((float*)oOutputDescMap.data)[nIdx],((float*)oOutputDescs.data)[nIdx]) << "nIdx=" << nIdx;
+}
+
+TEST(sc,regression_instr_set_rel_rotinv) {
+    cv::Mat oInput(97,131,CV_8UC1);
+    oInput = 0;
+    cv::circle(oInput,cv::Point(40,50),9,cv::Scalar_<uchar>(255),-1);
+    cv::rectangle(oInput,cv::Point(80,10),cv::Point(125,30),cv::Scalar_<uchar>(255),-1);
+    oInput = oInput>0;
+    std::vector<std::unique_ptr<ShapeContext>> vpShapeContexts;
+    vpShapeContexts.push_back(std::make_unique<ShapeContext>(0.1,1.0,12,5));
+    vpShapeContexts.push_back(std::make_unique<ShapeContext>(0.1,1.0,12,5,true));
+    vpShapeContexts.push_back(std::make_unique<ShapeContext>(size_t(2),size_t(20),12,5,true));
+    for(const auto& pShapeContext : vpShapeContexts) {
+        pShapeContext->setInstrSet(lv::SIMD_None);
+        ASSERT_EQ(pShapeContext->getInstrSet(),lv::SIMD_None);
+        cv::Mat_<float> oOutputDescMap_scalar, oOutputDescMap_best;
+        pShapeContext->compute2(oInput,oOutputDescMap_scalar);
+        pShapeContext->setInstrSet(lv::getBestSIMDInstrSet());
+        pShapeContext->compute2(oInput,oOutputDescMap_best);
+        ASSERT_TRUE(lv::isEqual<float>(oOutputDescMap_scalar,oOutputDescMap_best));
+        const std::vector<cv::KeyPoint> vTargetPts = {cv::KeyPoint(cv::Point2f(40,50),1.0f),cv::KeyPoint(cv::Point2f(100.4f,40.7f),1.0f)};
+        std::vector<cv::KeyPoint> vTargetPts_scalar = vTargetPts, vTargetPts_best = vTargetPts;
+        cv::Mat_<float> oOutputDescs_scalar, oOutputDescs_best;
+        pShapeContext->compute(oInput,vTargetPts_best,oOutputDescs_best);
+        pShapeContext->setInstrSet(lv::SIMD_None);
+        pShapeContext->compute(oInput,vTargetPts_scalar,oOutputDescs_scalar);
+        ASSERT_TRUE(lv::isEqual<float>(oOutputDescs_scalar,oOutputDescs_best));
+    }
+}
+
 TEST(sc,regression_emd_check) {
     std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(0.1,1.0);
     cv::Mat oInput(257,257,CV_8UC1);
@@ -512,6 +565,113 @@ TEST(sc,regression_emd_check) {
     }
 }
 
+TEST(sc,regression_batch_compute) {
+    std::vector<cv::Mat> voImages;
+    for(int nImageIdx=0; nImageIdx<6; ++nImageIdx) {
+        cv::Mat oInput(80+nImageIdx*7,100-nImageIdx*5,CV_8UC1);
+        oInput = 0;
+        cv::circle(oInput,cv::Point(30+nImageIdx*3,40),5+nImageIdx,cv::Scalar_<uchar>(255),-1);
+        cv::rectangle(oInput,cv::Point(50,10+nImageIdx*4),cv::Point(70+nImageIdx,30+nImageIdx*4),cv::Scalar_<uchar>(255),-1);
+        voImages.push_back(oInput>0);
+    }
+    std::vector<std::unique_ptr<ShapeContext>> vpShapeContexts;
+    vpShapeContexts.push_back(std::make_unique<ShapeContext>(size_t(2),size_t(20),12,5));
+    vpShapeContexts.push_back(std::make_unique<ShapeContext>(0.1,1.0,12,5,true));
+    for(const auto& pShapeContext : vpShapeContexts) {
+#if HAVE_CUDA
+        pShapeContext->enableCUDA(false);
+#endif //HAVE_CUDA
+        std::vector<cv::Mat_<float>> voRefDescMaps(voImages.size()), voRefDescs(voImages.size());
+        std::vector<std::vector<cv::KeyPoint>> vvRefKeyPoints(voImages.size());
+        for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx) {
+            pShapeContext->compute2(voImages[nImageIdx],voRefDescMaps[nImageIdx]);
+            pShapeContext->compute2(voImages[nImageIdx],vvRefKeyPoints[nImageIdx],voRefDescs[nImageIdx]);
+        }
+        for(size_t nWorkers : {1,2,0}) {
+            pShapeContext->setBatchWorkerCount(nWorkers);
+            pShapeContext->setInstrSet((nWorkers==2)?lv::SIMD_None:lv::getBestSIMDInstrSet());
+            std::vector<cv::Mat_<float>> voDescMaps, voDescs;
+            std::vector<std::vector<cv::KeyPoint>> vvKeyPoints(voImages.size());
+            pShapeContext->compute2(voImages,voDescMaps);
+            pShapeContext->compute2(voImages,vvKeyPoints,voDescs);
+            ASSERT_EQ(voDescMaps.size(),voImages.size());
+            ASSERT_EQ(voDescs.size(),voImages.size());
+            for(size_t nImageIdx=0; nImageIdx<voImages.size(); ++nImageIdx) {
+                ASSERT_TRUE(lv::isEqual<float>(voDescMaps[nImageIdx],voRefDescMaps[nImageIdx])) << "nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+                ASSERT_EQ(vvKeyPoints[nImageIdx].size(),vvRefKeyPoints[nImageIdx].size());
+                ASSERT_TRUE(lv::isEqual<float>(voDescs[nImageIdx],voRefDescs[nImageIdx])) << "nWorkers=" << nWorkers << ", nImageIdx=" << nImageIdx;
+            }
+        }
+        std::vector<std::vector<cv::KeyPoint>> vvKeyPoints(voImages.size()+1);
+        std::vector<cv::Mat_<float>> voDescs;
+        ASSERT_THROW_LV_QUIET(pShapeContext->compute2(voImages,vvKeyPoints,voDescs));
+    }
+}
+
+namespace {
+
+    /// fills a matrix with (non-null) relative shape context descriptors taken around a few simple shapes, for emd tests
+    void getEMDTestDescs(ShapeContext& oShapeContext, cv::Mat_<float>& oDescs) {
+        cv::Mat oInput(97,131,CV_8UC1);
+        oInput = 0;
+        cv::circle(oInput,cv::Point(40,50),9,cv::Scalar_<uchar>(255),-1);
+        cv::rectangle(oInput,cv::Point(80,10),cv::Point(125,30),cv::Scalar_<uchar>(255),-1);
+        cv::line(oInput,cv::Point(0,96),cv::Point(130,60),cv::Scalar_<uchar>(255));
+        oInput = oInput>0;
+        std::vector<cv::KeyPoint> vKeyPoints;
+        for(int nRowIdx=4; nRowIdx<oInput.rows; nRowIdx+=6)
+            for(int nColIdx=3; nColIdx<oInput.cols; nColIdx+=7)
+                vKeyPoints.emplace_back(cv::Point2f(float(nColIdx),float(nRowIdx)),1.0f);
+        cv::Mat_<float> oAllDescs;
+        oShapeContext.compute(oInput,vKeyPoints,oAllDescs);
+        oDescs.release();
+        for(int nDescIdx=0; nDescIdx<oAllDescs.rows; ++nDescIdx)
+            if(cv::countNonZero(oAllDescs.row(nDescIdx))>0)
+                oDescs.push_back(oAllDescs.row(nDescIdx));
+    }
+
+}
+
+TEST(sc,regression_emd_approx) {
+    std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(0.1,1.0,12,5);
+    cv::Mat_<float> oDescs;
+    getEMDTestDescs(*pShapeContext,oDescs);
+    ASSERT_GT(oDescs.rows,50);
+    // second set of histograms is shuffled, and has one third of its rows scaled down (for partial matching)
+    cv::Mat_<float> oOffsetDescs(oDescs.size());
+    for(int nDescIdx=0; nDescIdx<oDescs.rows; ++nDescIdx)
+        oOffsetDescs.row(nDescIdx) = oDescs.row((nDescIdx*7+3)%oDescs.rows)*((nDescIdx%3)?1.0:0.6);
+    const SinkhornEMD& oApproxEMD = pShapeContext->getApproxEMD();
+    ASSERT_EQ(oApproxEMD.getBinCount(),oDescs.cols);
+    std::vector<double> vdDists;
+    pShapeContext->calcDistances_EMDApprox(oDescs,oOffsetDescs,vdDists);
+    ASSERT_EQ(vdDists.size(),size_t(oDescs.rows));
+    double dErrorSum = 0.0;
+    for(int nDescIdx=0; nDescIdx<oDescs.rows; ++nDescIdx) {
+        const float* aDesc1 = oDescs.ptr<float>(nDescIdx);
+        const float* aDesc2 = oOffsetDescs.ptr<float>(nDescIdx);
+        double dErrorBound;
+        const double dDist = oApproxEMD.compute(aDesc1,aDesc2,&dErrorBound);
+        ASSERT_EQ(dDist,vdDists[nDescIdx]) << "nDescIdx=" << nDescIdx; // batching must not change results
+        ASSERT_DOUBLE_EQ(dDist,pShapeContext->calcDistance_EMDApprox(aDesc1,aDesc2));
+        const double dExactDist = pShapeContext->calcDistance_EMD(aDesc1,aDesc2);
+        ASSERT_GE(dDist,dExactDist-1e-4) << "nDescIdx=" << nDescIdx; // rounded plans are feasible (cv::EMD is solved in float)
+        ASSERT_LE(dDist,dExactDist+dErrorBound+1e-4) << "nDescIdx=" << nDescIdx;
+        dErrorSum += dDist-dExactDist;
+    }
+    ASSERT_LT(dErrorSum/oDescs.rows,oApproxEMD.getMaxError()/2);
+    SinkhornEMD oApproxEMD_scalar(pShapeContext->getEMDCostMap());
+    oApproxEMD_scalar.setInstrSet(lv::SIMD_None);
+    ASSERT_EQ(oApproxEMD_scalar.getInstrSet(),lv::SIMD_None);
+    std::vector<double> vdDists_scalar;
+    oApproxEMD_scalar.compute(oDescs,oOffsetDescs,vdDists_scalar);
+    for(size_t nDescIdx=0; nDescIdx<vdDists.size(); ++nDescIdx)
+        ASSERT_NEAR(vdDists_scalar[nDescIdx],vdDists[nDescIdx],1e-6) << "nDescIdx=" << nDescIdx;
+    ASSERT_THROW_LV_QUIET(SinkhornEMD(cv::Mat_<float>(3,4,1.0f)));
+    ASSERT_THROW_LV_QUIET(SinkhornEMD(cv::Mat_<float>(4,4,0.0f)));
+    ASSERT_THROW_LV_QUIET(SinkhornEMD(pShapeContext->getEMDCostMap(),0.0));
+}
+
 namespace {
 
     void sc_abs_perftest(benchmark::State& state) {
@@ -531,4 +691,78 @@ namespace {
     }
 }
 
-BENCHMARK(sc_abs_perftest)->Args({2,20})->Args({2,30})->Args({2,40})->Args({5,40})->Args({5,80})->Repetitions(15)->ReportAggregatesOnly(true);
\ No newline at end of file
+BENCHMARK(sc_abs_perftest)->Args({2,20})->Args({2,30})->Args({2,40})->Args({5,40})->Args({5,80})->Repetitions(15)->ReportAggregatesOnly(true);
+
+namespace {
+
+    void sc_rel_perftest(benchmark::State& st) {
+        std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(0.1,1.0,12,5,bool(st.range(1)));
+        pShapeContext->setInstrSet(st.range(0)?lv::getBestSIMDInstrSet():lv::SIMD_None);
+        cv::Mat oInput(257,257,CV_8UC1);
+        oInput = 0;
+        cv::circle(oInput,cv::Point(128,128),7,cv::Scalar_<uchar>(255),-1);
+        cv::rectangle(oInput,cv::Point(180,180),cv::Point(190,190),cv::Scalar_<uchar>(255),-1);
+        oInput = oInput>0;
+        cv::Mat_<float> oOutputDescMap;
+        while(st.KeepRunning()) {
+            pShapeContext->compute2(oInput,oOutputDescMap);
+            benchmark::DoNotOptimize(oOutputDescMap.data);
+        }
+        st.SetLabel(st.range(0)?"best simd":"scalar");
+    }
+
+}
+
+BENCHMARK(sc_rel_perftest)->Args({0,0})->Args({1,0})->Args({0,1})->Args({1,1})->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+
+namespace {
+
+    void sc_batch_perftest(benchmark::State& st) {
+        std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(0.1,1.0,12,5);
+#if HAVE_CUDA
+        pShapeContext->enableCUDA(false);
+#endif //HAVE_CUDA
+        pShapeContext->setBatchWorkerCount(size_t(st.range(0)));
+        cv::Mat oInput(257,257,CV_8UC1);
+        oInput = 0;
+        cv::circle(oInput,cv::Point(128,128),7,cv::Scalar_<uchar>(255),-1);
+        cv::rectangle(oInput,cv::Point(180,180),cv::Point(190,190),cv::Scalar_<uchar>(255),-1);
+        const std::vector<cv::Mat> voImages(16,oInput>0);
+        std::vector<cv::Mat_<float>> voDescMaps;
+        while(st.KeepRunning()) {
+            pShapeContext->compute2(voImages,voDescMaps);
+            benchmark::DoNotOptimize(voDescMaps.back().data);
+        }
+    }
+
+}
+
+BENCHMARK(sc_batch_perftest)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+
+namespace {
+
+    void sc_emd_perftest(benchmark::State& st) {
+        std::unique_ptr<ShapeContext> pShapeContext = std::make_unique<ShapeContext>(0.1,1.0,12,5);
+        cv::Mat_<float> oDescs;
+        getEMDTestDescs(*pShapeContext,oDescs);
+        cv::Mat_<float> oOffsetDescs(oDescs.size());
+        for(int nDescIdx=0; nDescIdx<oDescs.rows; ++nDescIdx)
+            oDescs.row((nDescIdx*7+3)%oDescs.rows).copyTo(oOffsetDescs.row(nDescIdx));
+        SinkhornEMD oApproxEMD(pShapeContext->getEMDCostMap());
+        oApproxEMD.setInstrSet(st.range(0)==1?lv::SIMD_None:lv::getBestSIMDInstrSet());
+        std::vector<double> vdDists(oDescs.rows);
+        while(st.KeepRunning()) {
+            if(st.range(0)==0) {
+                for(int nDescIdx=0; nDescIdx<oDescs.rows; ++nDescIdx)
+                    vdDists[nDescIdx] = pShapeContext->calcDistance_EMD(oDescs.ptr<float>(nDescIdx),oOffsetDescs.ptr<float>(nDescIdx));
+            }
+            else
+                oApproxEMD.compute(oDescs,oOffsetDescs,vdDists);
+            benchmark::DoNotOptimize(vdDists.data());
+        }
+        st.SetLabel(st.range(0)==0?"cv::EMD":st.range(0)==1?"sinkhorn, scalar":"sinkhorn, best simd");
+    }
+
+}
+
+BENCHMARK(sc_emd_perftest)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -20,6 +20,7 @@
 #include "litiv/imgproc/EdgeDetectorCanny.hpp"
 #include "litiv/imgproc/EdgeDetectorLBSP.hpp"
 #include "litiv/imgproc/CosegmentationUtils.hpp"
+#include "litiv/features2d/QuantizedDescMap.hpp"
 #if HAVE_OPENGM
 #include "litiv/imgproc/SegmMatcher.hpp"
 #endif //HAVE_OPENGM
@@ -39,7 +40,8 @@ namespace lv {
         AffinityDist_L2=0,
         AffinityDist_EMD,
         AffinityDist_MI,
-        AffinityDist_SSD
+        AffinityDist_SSD,
+        AffinityDist_EMDApprox
     };
 
     /// 'thins' the provided image (currently only works on 1ch 8UC1 images, treated as binary)
@@ -72,6 +74,19 @@ namespace lv {
                                    cv::Mat_<float>& oAffinityMap, const std::vector<int>& vDispRange, AffinityDistType eDist,
                                    const cv::Mat_<uchar>& oROI1=cv::Mat(), const cv::Mat_<uchar>& oROI2=cv::Mat(),
                                    const cv::Mat_<float>& oEMDCostMap=cv::Mat(), bool bAllowCUDA=true);
+    /// computes a sparse (N)x(nWindowSize) affinity volume from two 2d descriptor maps for a list of N nodes (x=col, y=row), each matched over
+    /// its own window of disparity range offsets (i.e. [vWindowBegins[n],vWindowBegins[n]+nWindowSize)); values are the same as in the dense
+    /// map, but only the descriptor pairs required by the patches & windows of the nodes are compared (full-range windows use the dense path)
+    void computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::Mat_<float>& oDescMap2, int nPatchSize,
+                                   const std::vector<cv::Point2i>& vNodes, const std::vector<int>& vWindowBegins, int nWindowSize,
+                                   cv::Mat_<float>& oAffinity, const std::vector<int>& vDispRange, AffinityDistType eDist,
+                                   const cv::Mat_<uchar>& oROI1=cv::Mat(), const cv::Mat_<uchar>& oROI2=cv::Mat(),
+                                   const cv::Mat_<float>& oEMDCostMap=cv::Mat());
+    /// computes a 3d affinity map from two quantized 2d descriptor maps by matching them in patches across a given stereo disparity range
+    /// note: only supports L2 distances, which are computed on the compact descriptor bins directly (see lv::QuantizedDescMap)
+    void computeDescriptorAffinity(const lv::QuantizedDescMap& oDescMap1, const lv::QuantizedDescMap& oDescMap2, int nPatchSize,
+                                   cv::Mat_<float>& oAffinityMap, const std::vector<int>& vDispRange, AffinityDistType eDist,
+                                   const cv::Mat_<uchar>& oROI1=cv::Mat(), const cv::Mat_<uchar>& oROI2=cv::Mat());
 #if HAVE_CUDA
     /// computes a 3d affinity map from two 2d descriptor maps by matching them in patches across a given stereo disparity range
     /// note: expects descriptor maps to have 2d size (nxm)xd, where nxm is the map size, and d is the desc length
@@ -94,7 +94,14 @@ struct SegmMatcher : ICosegmentor<int32_t,4> { // camera count could be template
     virtual void calcFeatures(const MatArrayIn& aInputs, cv::Mat* pFeaturesPacket=nullptr);
     /// sets a previously precalculated initial features packet to be used in the next 'apply' call (do not modify its data before that!)
     virtual void setNextFeatures(const cv::Mat& oPackedFeatures);
-    /// reinitializes internal model by resetting the internal frame counter, essentially breaking future temporal links until enough new frames have been processed
+    /// queues the inputs of an upcoming 'apply' call so that all their features are computed in the background (e.g. while the current frame is being
+    /// inferred); the same input matrices (not copies) must then be passed to 'apply' in the same order, and only a few frames can be queued ahead at once
+    virtual void queueNextInputs(const MatArrayIn& aInputs);
+    /// sets the max number of stereo moves solved concurrently during inference (results are identical for any count; only used by the FGBZ stereo solver)
+    virtual void setStereoMoveThreadCount(size_t nThreads);
+    /// toggles whether per-camera feature maps are computed concurrently by internal workers (results are identical either way; on by default, always off at debug verbosity)
+    virtual void setFeatureThreading(bool bUseWorkers);
+    /// reinitializes internal model by resetting the internal frame counter & canceling queued inputs, essentially breaking future temporal links until enough new frames have been processed
     virtual void resetTemporalModel();
     /// returns the (friendly) name of the input image feature extractor that will be used internally
     virtual std::string getFeatureExtractorName() const;
@@ -17,6 +17,9 @@
 
 #include "litiv/imgproc/SegmMatcher.hpp"
 #include "litiv/3rdparty/ofdis/ofdis.hpp"
+#if USING_OPENMP
+#include <omp.h>
+#endif //USING_OPENMP
 
 // config options
 #define SEGMMATCH_CONFIG_USE_DASCGF_AFFINITY   0
@@ -25,6 +28,7 @@
 #define SEGMMATCH_CONFIG_USE_MI_AFFINITY       0
 #define SEGMMATCH_CONFIG_USE_SSQDIFF_AFFINITY  0
 #define SEGMMATCH_CONFIG_USE_SHAPE_EMD_AFFIN   0
+#define SEGMMATCH_CONFIG_USE_SHAPE_EMD_APPROX  1
 #define SEGMMATCH_CONFIG_USE_SALIENT_MAP_BORDR 1
 #define SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS   0
 #define SEGMMATCH_CONFIG_USE_DISP_BG_HRST      0
@@ -67,6 +71,8 @@
 #define SEGMMATCH_DEFAULT_BG_ZONE_SIZE         (45)
 #define SEGMMATCH_DEFAULT_GMM_3CH_COMPONENTS   (6)
 #define SEGMMATCH_DEFAULT_GMM_1CH_COMPONENTS   (3)
+#define SEGMMATCH_DEFAULT_ASYNC_QUEUE_SIZE     (size_t(2))
+#define SEGMMATCH_DEFAULT_STEREO_MOVE_THREADS  (size_t(4))
 
 // unary costs params
 #define SEGMMATCH_UNARY_COST_TEMPORAL_CST      (ValueType(200))
@@ -259,12 +265,108 @@ namespace {
 
 /// holds graph model data for both stereo and resegmentation models
 struct SegmMatcher::GraphModelData {
+    /// worker pool type used to run per-camera image & shape feature tasks concurrently
+    using FeatureWorkerPool = lv::WorkerPool<getCameraCount()*2>;
+    /// holds the feature extractors of one feature computation stream (one per camera head, so that heads can be described concurrently)
+    struct FeatureExtractors {
+        /// default constructor; creates the image & shape extractors of all camera heads
+        FeatureExtractors();
+    #if SEGMMATCH_CONFIG_USE_DASCGF_AFFINITY || SEGMMATCH_CONFIG_USE_DASCRF_AFFINITY
+        CamArray<std::unique_ptr<DASC>> apImgDescExtractors;
+    #elif SEGMMATCH_CONFIG_USE_LSS_AFFINITY
+        CamArray<std::unique_ptr<LSS>> apImgDescExtractors;
+    #elif SEGMMATCH_CONFIG_USE_MI_AFFINITY
+        CamArray<std::unique_ptr<MutualInfo>> apImgDescExtractors; // although not really 'descriptor' extractors...
+    #endif //SEGMMATCH_CONFIG_USE_..._AFFINITY
+        CamArray<std::unique_ptr<ShapeContext>> apShpDescExtractors;
+    };
+    /// holds the intermediary maps of a frame passed from the per-camera feature stages to the affinity stages
+    struct FeatureMaps {
+        /// image/shape descriptor maps
+        CamArray<cv::Mat_<float>> aImgDescs,aShpDescs;
+        /// enlarged input images & ROIs (for non-desc-based affinities only)
+        CamArray<cv::Mat> aEnlargedImgInputs;
+        CamArray<cv::Mat_<uchar>> aEnlargedImgROIs;
+    };
+    /// holds a frame queued for async feature computation along with its features (valid once the result is ready)
+    struct AsyncFeaturePacket {
+        /// sequence number of the packet, i.e. the index of the frame (since the last reset) it was queued for
+        size_t nFrameIdx;
+        /// deep copy of the queued inputs (used as the next packet's previous images)
+        MatArrayIn aInputs;
+        /// data pointers of the caller's queued inputs (used to check 'apply' calls without comparing contents)
+        std::array<const uchar*,s_nInputArraySize> apInputData;
+        /// feature maps vector (all slots, including affinities & saliency, are filled in the background)
+        std::vector<cv::Mat> vFeatures;
+        /// result of the background computation (holds its exception, if any)
+        std::future<void> oResult;
+    };
+    /// holds the async feature pipeline state; frames are handled one at a time by the frame worker, which spreads their per-camera tasks
+    struct AsyncFeatureData {
+        /// default constructor; creates the background extractors & workers
+        AsyncFeatureData() : bCanceled(false) {
+        #if USING_OPENMP
+            nThreadBudget = size_t(std::max(omp_get_max_threads()/2,1));
+        #else //!USING_OPENMP
+            nThreadBudget = size_t(1);
+        #endif //!USING_OPENMP
+        }
+        /// sets the cancellation flag before the frame worker is joined, so that pending frames are skipped
+        ~AsyncFeatureData() {bCanceled = true;}
+        /// omp thread budget of the frame worker (half of the caller's, as frames are computed while the caller runs inference with the rest)
+        size_t nThreadBudget;
+        /// background feature extractors (frames are described one at a time, so one set is enough)
+        FeatureExtractors oExtractors;
+        /// background per-camera task workers
+        FeatureWorkerPool oTaskWorkers;
+        /// queued packets, in 'apply' order
+        std::deque<std::unique_ptr<AsyncFeaturePacket>> qpPackets;
+        /// cancellation flag checked before each per-camera task and before the affinity stages
+        std::atomic_bool bCanceled;
+        /// frame worker (declared last so that it is joined first on destruction)
+        lv::WorkerPool<1> oFrameWorker;
+    };
+
+#if SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+    /// holds the solver instances & result of a single (possibly speculative) stereo alpha-expansion move
+    struct StereoMoveData {
+        /// default constructor; preallocates the move minimizer & unary costs for the given graph
+        StereoMoveData(size_t nGraphNodes, size_t nMaxEdgesPerNode, const lv::MatSize& oGridSize) :
+                nAlphaLabel(0),oMinimizer((int)nGraphNodes,(int)(nGraphNodes*nMaxEdgesPerNode)) {
+            oUnaryCosts.create(oGridSize);
+            vMovedGraphNodeIdxs.reserve(nGraphNodes);
+        }
+        /// alpha label evaluated by this move
+        InternalLabelType nAlphaLabel;
+        /// higher-order energy reducer used to build this move's binary problem
+        HigherOrderEnergy<ValueType,s_nMaxOrder> oReducer;
+        /// binary minimizer used to solve this move
+        kolmogorov::qpbo::QPBO<ValueType> oMinimizer;
+        /// unary move costs of all stereo graph nodes (same layout as m_oStereoUnaryCosts)
+        cv::Mat_<ValueType> oUnaryCosts;
+        /// graph node indices which should be switched to the alpha label
+        std::vector<size_t> vMovedGraphNodeIdxs;
+    };
+#endif //SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+
     /// default constructor; receives model construction data from algo constructor
     GraphModelData(const CamArray<cv::Mat>& aROIs, const std::vector<OutputLabelType>& vRealStereoLabels, size_t nStereoLabelStep, size_t nPrimaryCamIdx);
+    /// default destructor; cancels queued async feature computations before any model data is released
+    ~GraphModelData();
     /// (pre)calculates features required for model updates, and optionally returns them in packet format
     void calcFeatures(const MatArrayIn& aInputs, cv::Mat* pFeaturesPacket=nullptr);
     /// sets a previously precalculated features packet to be used in the next model updates (do not modify it before that!)
     void setNextFeatures(const cv::Mat& oPackedFeatures);
+    /// queues inputs for async feature computation (per-camera maps, then affinities & saliency); they must then be passed to 'apply' in the same order
+    void queueNextInputs(const MatArrayIn& aInputs);
+    /// pops the oldest queued packet (if any) after checking its sequence number & inputs, and waits for its features (rethrows failures)
+    std::unique_ptr<AsyncFeaturePacket> popAsyncFeatures(const MatArrayIn& aInputs);
+    /// cancels all queued async feature computations and waits for the running one to stop
+    void cancelAsyncFeatures();
+    /// calculates the affinity stages (requires the image & shape feature maps of all camera heads); can run in the background
+    void calcAffinityFeatures(const FeatureMaps& oMaps, const FeatureExtractors& oExtractors, std::vector<cv::Mat>& vFeatures) const;
+    /// checks the features stored in the temp vector, and optionally returns them in packet format
+    void checkFeatures(cv::Mat* pFeaturesPacket=nullptr);
     /// performs the actual bi-model, bi-spectral inference
     opengm::InferenceTermination infer();
     /// translate an internal graph label to a real disparity offset label
@@ -294,6 +396,14 @@ struct SegmMatcher::GraphModelData {
     size_t m_nFramesProcessed;
     /// max move making iteration count allowed during stereo/resegm inference
     size_t m_nMaxStereoMoveCount,m_nMaxResegmMoveCount;
+    /// max number of stereo moves solved concurrently (speculatively) during inference
+    size_t m_nStereoMoveThreads;
+#if SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+    /// stereo move solver instances (one per concurrent move), kept across frames so that reducers & minimizers are only reallocated on demand
+    std::vector<std::unique_ptr<StereoMoveData>> m_vpStereoMoves;
+#endif //SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+    /// defines whether per-camera feature tasks run on worker threads (or serially, on the caller's thread)
+    bool m_bUseFeatureWorkers;
     /// random seeds to use to initialize labeling/label-order arrays
     size_t m_nStereoLabelOrderRandomSeed,m_nStereoLabelingRandomSeed;
     /// contains the (internal) stereo label ordering to use for each iteration
@@ -348,6 +458,8 @@ struct SegmMatcher::GraphModelData {
     CamArray<cv::Mat_<uchar>> m_aStackedROIs; // note: these mats point to the super-stacked version above
     /// indices of valid nodes in the stereo/resegm graphs (based on primary ROI)
     std::vector<size_t> m_vStereoGraphIdxToMapIdxLUT,m_vResegmGraphIdxToMapIdxLUT;
+    /// 2d map coordinates (x=col, y=row) of valid nodes in the stereo graph (used for sparse affinity computations)
+    std::vector<cv::Point2i> m_vStereoGraphNodeCoords;
     /// number of valid nodes/cliques in the stereo/resegm graphs (based on primary ROI)
     size_t m_nValidStereoGraphNodes,m_nValidResegmGraphNodes,m_nStereoCliqueCount,m_nResegmCliqueCount;
     /// stereo model info lookup array
@@ -389,16 +501,14 @@ struct SegmMatcher::GraphModelData {
     /// inter-cam vote map used for parallel ops (large prealloc)
     cv::Mat_<int> m_oStereoVoteMap;
 
-    /// holds the feature extractor to use on input images
-#if SEGMMATCH_CONFIG_USE_DASCGF_AFFINITY || SEGMMATCH_CONFIG_USE_DASCRF_AFFINITY
-    std::unique_ptr<DASC> m_pImgDescExtractor;
-#elif SEGMMATCH_CONFIG_USE_LSS_AFFINITY
-    std::unique_ptr<LSS> m_pImgDescExtractor;
-#elif SEGMMATCH_CONFIG_USE_MI_AFFINITY
-    std::unique_ptr<MutualInfo> m_pImgDescExtractor; // although not really a 'descriptor' extractor...
-#endif //SEGMMATCH_CONFIG_USE_..._AFFINITY
-    /// holds the feature extractor to use on input shapes
-    std::unique_ptr<ShapeContext> m_pShpDescExtractor;
+    /// holds the feature extractors used in the foreground (i.e. by the calling thread's feature computations)
+    FeatureExtractors m_oFeatExtractors;
+    /// holds the foreground intermediary feature maps (kept here to avoid reallocs)
+    FeatureMaps m_oFeatMaps;
+    /// worker threads used to run per-camera image & shape feature tasks concurrently (native threads, each extractor omp team gets a share of the cores)
+    FeatureWorkerPool m_oFeatureWorkers;
+    /// holds the async feature pipeline state (only allocated once inputs are queued)
+    std::unique_ptr<AsyncFeatureData> m_pAsyncFeatData;
     /// defines the minimum grid border size based on the feature extractors used
     size_t m_nGridBorderSize;
     /// holds the last/next features packet info vector
@@ -434,12 +544,21 @@ protected:
     void buildResegmModel();
     /// updates a shape graph model using new features data
     void updateResegmModel(bool bInit);
-    /// calculates image features required for model updates using the provided input image array
-    void calcImageFeatures(const CamArray<cv::Mat>& aInputImages, std::vector<cv::Mat>& vFeatures);
+    /// runs 'lTask(nTaskIdx)' for all tasks in [0,nTaskCount) concurrently on the given worker pool, and waits for all of them (rethrows the first failure);
+    /// the last 'nLightTaskCount' tasks are given a single omp thread each, and the other (heavy) tasks split the rest of the caller's thread budget
+    void runFeatureTasks(FeatureWorkerPool& oWorkers, size_t nTaskCount, const std::function<void(size_t)>& lTask, size_t nLightTaskCount=0u) const;
+    /// calculates the per-camera image features (descriptors, gradients, flow) of one camera head; can run concurrently for different heads/extractors
+    void calcImageFeatureMaps(const cv::Mat& oInputImage, const cv::Mat& oPrevInputImage, size_t nCamIdx, FeatureExtractors& oExtractors, FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const;
+    /// calculates the image affinity/saliency features (requires the image feature maps of all camera heads)
+    void calcImageAffinityFeatures(const FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const;
     /// calculates shape features required for model updates using the provided input mask array
     void calcShapeFeatures(const CamArray<cv::Mat_<InternalLabelType>>& aInputMasks, std::vector<cv::Mat>& vFeatures);
+    /// calculates the per-camera shape features (descriptors, distance fields) of one camera head; can run concurrently for different heads/extractors
+    void calcShapeFeatureMaps(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, FeatureExtractors& oExtractors, FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const;
+    /// calculates the shape affinity/saliency features (requires the shape feature maps of all camera heads)
+    void calcShapeAffinityFeatures(const FeatureMaps& oMaps, const FeatureExtractors& oExtractors, std::vector<cv::Mat>& vFeatures) const;
     /// calculates shape mask distance features required for model updates using the provided input mask & camera index
-    void calcShapeDistFeatures(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, std::vector<cv::Mat>& vFeatures);
+    void calcShapeDistFeatures(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, std::vector<cv::Mat>& vFeatures) const;
     /// initializes foreground and background GMM parameters via KNN using the given image and mask (where all values >0 are considered foreground)
     void initGaussianMixtureParams(const cv::Mat& oInput, const cv::Mat& oMask, const cv::Mat& oROI, size_t nCamIdx);
     /// assigns each input image pixel its most likely GMM component in the output map, using the BG or FG model as dictated by the input mask
@@ -452,8 +571,16 @@ protected:
     double getGMMBGProb(const cv::Mat& oInput, size_t nElemIdx, size_t nCamIdx) const;
     /// calculates a stereo unary move cost for a single graph node
     ValueType calcStereoUnaryMoveCost(size_t nGraphNodeIdx, InternalLabelType nOldLabel, InternalLabelType nNewLabel) const;
-    /// fill internal temporary energy cost mats for the given stereo move operation
-    void calcStereoMoveCosts(InternalLabelType nNewLabel) const;
+    /// fill the given energy cost mat for the given stereo move operation
+    void calcStereoMoveCosts(InternalLabelType nNewLabel, cv::Mat_<ValueType>& oUnaryCosts) const;
+#if SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+    /// solves the stereo move for the given label against the current labeling without applying it (can run concurrently for different moves)
+    void calcStereoMove(InternalLabelType nAlphaLabel, StereoMoveData& oMove) const;
+    /// applies a solved stereo move to the current labeling & association maps, and returns the number of relabeled nodes
+    size_t applyStereoMove(const StereoMoveData& oMove) const;
+    /// returns the max number of stereo moves that can be solved concurrently right now (i.e. the omp budget left by background features in flight)
+    size_t getStereoMoveThreadBudget() const;
+#endif //SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
     /// fill internal temporary energy cost mats for the given resegm move operation
     void calcResegmMoveCosts(InternalLabelType nNewLabel) const;
 #if (SEGMMATCH_CONFIG_USE_SOSPD_STEREO_INF || SEGMMATCH_CONFIG_USE_SOSPD_RESEGM_INF)
@@ -758,6 +885,7 @@ void SegmMatcher::apply(const MatArrayIn& aInputs, MatArrayOut& aOutputs) {
         }
     }
     lvAssert_(!m_pModelData->m_bUsePrecalcFeaturesNext || m_pModelData->m_vExpectedFeatPackInfo.size()==FeatPackSize,"unexpected precalculated features vec size");
+    const std::unique_ptr<GraphModelData::AsyncFeaturePacket> pAsyncPacket = m_pModelData->popAsyncFeatures(aInputs); // null if no inputs were queued
     for(size_t nLayerIdx=getTemporalLayerCount()-1u; nLayerIdx>0; --nLayerIdx) {
         // copy over all 'old' inputs by sliding one layer at a time
         for(size_t nInputIdx=0u; nInputIdx<aInputs.size(); ++nInputIdx)
@@ -776,7 +904,12 @@ void SegmMatcher::apply(const MatArrayIn& aInputs, MatArrayOut& aOutputs) {
         std::swap(m_pModelData->m_vLoadedFeatures,m_pModelData->m_avFeatures[0]);
     }
     else {
-        m_pModelData->calcFeatures(m_pModelData->m_aaInputs[0]);
+        if(pAsyncPacket) { // all features were computed in the background; they only need to be checked
+            std::swap(m_pModelData->m_vTempFeatures,pAsyncPacket->vFeatures);
+            m_pModelData->checkFeatures();
+        }
+        else
+            m_pModelData->calcFeatures(m_pModelData->m_aaInputs[0]);
         lvDbgAssert(m_pModelData->m_vTempFeatures.size()==FeatPackSize);
         std::swap(m_pModelData->m_vTempFeatures,m_pModelData->m_avFeatures[0]);
     }
@@ -824,8 +957,28 @@ void SegmMatcher::setNextFeatures(const cv::Mat& oPackedFeatures) {
     m_pModelData->setNextFeatures(oPackedFeatures);
 }
 
+void SegmMatcher::queueNextInputs(const MatArrayIn& aInputs) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_pModelData,"model must be initialized first");
+    m_pModelData->queueNextInputs(aInputs);
+}
+
+void SegmMatcher::setStereoMoveThreadCount(size_t nThreads) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_pModelData,"model must be initialized first");
+    lvAssert_(nThreads>0u,"stereo move thread count must be strictly positive");
+    m_pModelData->m_nStereoMoveThreads = nThreads;
+}
+
+void SegmMatcher::setFeatureThreading(bool bUseWorkers) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_pModelData,"model must be initialized first");
+    m_pModelData->m_bUseFeatureWorkers = bUseWorkers;
+}
+
 void SegmMatcher::resetTemporalModel() {
     lvDbgExceptionWatch;
+    m_pModelData->cancelAsyncFeatures();
     m_pModelData->m_nFramesProcessed = 0u;
 }
 
@@ -877,10 +1030,34 @@ cv::Mat SegmMatcher::getAssocCountsMapDisplay() const {
 
 constexpr size_t SegmMatcher::GraphModelData::s_nResegmLabels;
 
+SegmMatcher::GraphModelData::FeatureExtractors::FeatureExtractors() {
+    for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx) {
+    #if SEGMMATCH_CONFIG_USE_DASCGF_AFFINITY
+        apImgDescExtractors[nCamIdx] = std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS,DASC_DEFAULT_GF_SUBSPL,DASC_DEFAULT_PREPROCESS);
+    #elif SEGMMATCH_CONFIG_USE_DASCRF_AFFINITY
+        apImgDescExtractors[nCamIdx] = std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR,DASC_DEFAULT_RF_ITERS,DASC_DEFAULT_PREPROCESS);
+    #elif SEGMMATCH_CONFIG_USE_LSS_AFFINITY
+        const int nLSSInnerRadius = 0;
+        const int nLSSOuterRadius = (int)SEGMMATCH_DEFAULT_LSSDESC_RAD;
+        const int nLSSPatchSize = (int)SEGMMATCH_DEFAULT_LSSDESC_PATCH;
+        const int nLSSAngBins = (int)SEGMMATCH_DEFAULT_LSSDESC_ANG_BINS;
+        const int nLSSRadBins = (int)SEGMMATCH_DEFAULT_LSSDESC_RAD_BINS;
+        apImgDescExtractors[nCamIdx] = std::make_unique<LSS>(nLSSInnerRadius,nLSSOuterRadius,nLSSPatchSize,nLSSAngBins,nLSSRadBins);
+    #endif //SEGMMATCH_CONFIG_USE_..._AFFINITY
+        const size_t nShapeContextInnerRadius = 2;
+        const size_t nShapeContextOuterRadius = SEGMMATCH_DEFAULT_SCDESC_WIN_RAD;
+        const size_t nShapeContextAngBins = SEGMMATCH_DEFAULT_SCDESC_ANG_BINS;
+        const size_t nShapeContextRadBins = SEGMMATCH_DEFAULT_SCDESC_RAD_BINS;
+        apShpDescExtractors[nCamIdx] = std::make_unique<ShapeContext>(nShapeContextInnerRadius,nShapeContextOuterRadius,nShapeContextAngBins,nShapeContextRadBins);
+    }
+}
+
 SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, const std::vector<OutputLabelType>& vRealStereoLabels, size_t nStereoLabelStep, size_t nPrimaryCamIdx) :
         m_nFramesProcessed(0u),
         m_nMaxStereoMoveCount(SEGMMATCH_DEFAULT_MAX_STEREO_ITER),
         m_nMaxResegmMoveCount(SEGMMATCH_DEFAULT_MAX_RESEGM_ITER),
+        m_nStereoMoveThreads(SEGMMATCH_DEFAULT_STEREO_MOVE_THREADS),
+        m_bUseFeatureWorkers(true),
         m_nStereoLabelOrderRandomSeed(0u),
         m_nStereoLabelingRandomSeed(0u),
         m_aROIs(CamArray<cv::Mat_<uchar>>{aROIs[0]>0,aROIs[1]>0}),
@@ -898,6 +1075,7 @@ SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, cons
     static_assert(getCameraCount()==2,"bad static array size, hardcoded stuff in constr init list and below will break");
     lvDbgExceptionWatch;
     lvAssert_(m_nMaxStereoMoveCount>0u && m_nMaxResegmMoveCount>0u,"max iter counts must be strictly positive");
+    lvAssert_(m_nStereoMoveThreads>0u,"stereo move thread count must be strictly positive");
     for(size_t nCamIdx=0u; nCamIdx<getCameraCount(); ++nCamIdx) {
         lvAssert_(lv::MatInfo(m_aROIs[0])==lv::MatInfo(m_aROIs[nCamIdx]),"ROIs info must match");
         lvAssert_(cv::countNonZero(m_aROIs[nCamIdx]>0)>1,"ROIs must have at least two nodes");
@@ -914,23 +1092,9 @@ SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, cons
     lvAssert_(m_nMinDispOffset<m_nMaxDispOffset,"min/max disp offsets mismatch");
     lvAssert_(m_nPrimaryCamIdx<getCameraCount(),"bad primary camera index");
     lvDbgAssert_(std::numeric_limits<AssocCountType>::max()>m_oGridSize[1],"grid width is too large for association counter type");
-#if SEGMMATCH_CONFIG_USE_DASCGF_AFFINITY
-    m_pImgDescExtractor = std::make_unique<DASC>(DASC_DEFAULT_GF_RADIUS,DASC_DEFAULT_GF_EPS,DASC_DEFAULT_GF_SUBSPL,DASC_DEFAULT_PREPROCESS);
-    const cv::Size oDescWinSize = m_pImgDescExtractor->windowSize();
-    m_nGridBorderSize = (size_t)std::max(m_pImgDescExtractor->borderSize(0),m_pImgDescExtractor->borderSize(1));
-#elif SEGMMATCH_CONFIG_USE_DASCRF_AFFINITY
-    m_pImgDescExtractor = std::make_unique<DASC>(DASC_DEFAULT_RF_SIGMAS,DASC_DEFAULT_RF_SIGMAR,DASC_DEFAULT_RF_ITERS,DASC_DEFAULT_PREPROCESS);
-    const cv::Size oDescWinSize = m_pImgDescExtractor->windowSize();
-    m_nGridBorderSize = (size_t)std::max(m_pImgDescExtractor->borderSize(0),m_pImgDescExtractor->borderSize(1));
-#elif SEGMMATCH_CONFIG_USE_LSS_AFFINITY
-    const int nLSSInnerRadius = 0;
-    const int nLSSOuterRadius = (int)SEGMMATCH_DEFAULT_LSSDESC_RAD;
-    const int nLSSPatchSize = (int)SEGMMATCH_DEFAULT_LSSDESC_PATCH;
-    const int nLSSAngBins = (int)SEGMMATCH_DEFAULT_LSSDESC_ANG_BINS;
-    const int nLSSRadBins = (int)SEGMMATCH_DEFAULT_LSSDESC_RAD_BINS;
-    m_pImgDescExtractor = std::make_unique<LSS>(nLSSInnerRadius,nLSSOuterRadius,nLSSPatchSize,nLSSAngBins,nLSSRadBins);
-    const cv::Size oDescWinSize = m_pImgDescExtractor->windowSize();
-    m_nGridBorderSize = (size_t)std::max(m_pImgDescExtractor->borderSize(0),m_pImgDescExtractor->borderSize(1));
+#if SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
+    const cv::Size oDescWinSize = m_oFeatExtractors.apImgDescExtractors[0]->windowSize();
+    m_nGridBorderSize = (size_t)std::max(m_oFeatExtractors.apImgDescExtractors[0]->borderSize(0),m_oFeatExtractors.apImgDescExtractors[0]->borderSize(1));
 #elif SEGMMATCH_CONFIG_USE_MI_AFFINITY
     const int nWindowSize = int(SEGMMATCH_DEFAULT_MI_WINDOW_RAD*2+1);
     const cv::Size oDescWinSize = cv::Size(nWindowSize,nWindowSize);
@@ -940,15 +1104,10 @@ SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, cons
     const cv::Size oDescWinSize(nSSqrDiffKernelSize,nSSqrDiffKernelSize);
     m_nGridBorderSize = size_t(nSSqrDiffKernelSize/2);
 #endif //SEGMMATCH_CONFIG_USE_..._AFFINITY
-    const size_t nShapeContextInnerRadius = 2;
-    const size_t nShapeContextOuterRadius = SEGMMATCH_DEFAULT_SCDESC_WIN_RAD;
-    const size_t nShapeContextAngBins = SEGMMATCH_DEFAULT_SCDESC_ANG_BINS;
-    const size_t nShapeContextRadBins = SEGMMATCH_DEFAULT_SCDESC_RAD_BINS;
-    m_pShpDescExtractor = std::make_unique<ShapeContext>(nShapeContextInnerRadius,nShapeContextOuterRadius,nShapeContextAngBins,nShapeContextRadBins);
     lvAssert__(oDescWinSize.width<=(int)m_oGridSize[1] && oDescWinSize.height<=(int)m_oGridSize[0],"image is too small to compute descriptors with current pattern size -- need at least (%d,%d) and got (%d,%d)",oDescWinSize.width,oDescWinSize.height,(int)m_oGridSize[1],(int)m_oGridSize[0]);
     lvDbgAssert(m_nGridBorderSize<m_oGridSize[0] && m_nGridBorderSize<m_oGridSize[1]);
     lvDbgAssert(m_nGridBorderSize<(size_t)oDescWinSize.width && m_nGridBorderSize<(size_t)oDescWinSize.height);
-    lvDbgAssert((size_t)std::max(m_pShpDescExtractor->borderSize(0),m_pShpDescExtractor->borderSize(1))<=m_nGridBorderSize);
+    lvDbgAssert((size_t)std::max(m_oFeatExtractors.apShpDescExtractors[0]->borderSize(0),m_oFeatExtractors.apShpDescExtractors[0]->borderSize(1))<=m_nGridBorderSize);
     m_aAssocCostRealAddLUT.resize_static();
     m_aAssocCostRealRemLUT.resize_static();
     m_aAssocCostRealSumLUT.resize_static();
@@ -1036,6 +1195,7 @@ SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, cons
 #endif //SEGMMATCH_CONFIG_USE_..._STEREO_INF
     m_oResegmUnaryCosts.create(int(m_oGridSize[0]*nTemporalLayerCount*nCameraCount),int(m_oGridSize[1]));
     m_vStereoGraphIdxToMapIdxLUT.reserve(anValidGraphNodes[m_nPrimaryCamIdx]);
+    m_vStereoGraphNodeCoords.reserve(anValidGraphNodes[m_nPrimaryCamIdx]);
     m_vResegmGraphIdxToMapIdxLUT.reserve(nTotValidNodes*nTemporalLayerCount);
     m_vStereoNodeMap.resize(nLayerSize);
     m_vResegmNodeMap.resize(nLayerSize*nCameraCount*nTemporalLayerCount);
@@ -1091,6 +1251,7 @@ SegmMatcher::GraphModelData::GraphModelData(const CamArray<cv::Mat>& aROIs, cons
                         if(oStereoNode.bValidGraphNode) {
                             oStereoNode.nGraphNodeIdx = m_nValidStereoGraphNodes++;
                             m_vStereoGraphIdxToMapIdxLUT.push_back(nMapIdx);
+                            m_vStereoGraphNodeCoords.push_back(cv::Point2i(nColIdx,nRowIdx));
                         }
                     }
                     const size_t nStackedMapIdx = nMapIdx+nLayerIdxOffset;
@@ -1274,8 +1435,8 @@ void SegmMatcher::GraphModelData::updateStereoModel(bool bInit) {
     const cv::Mat_<float> oShpAffinity = vFeatures[FeatPack_ShpAffinity];
     const cv::Mat_<float> oImgSaliency = vFeatures[FeatPack_ImgSaliency];
     const cv::Mat_<float> oShpSaliency = vFeatures[FeatPack_ShpSaliency];
-    lvDbgAssert(oImgAffinity.dims==3 && oImgAffinity.size[0]==nRows && oImgAffinity.size[1]==nCols && oImgAffinity.size[2]==(int)m_nRealStereoLabels);
-    lvDbgAssert(oShpAffinity.dims==3 && oShpAffinity.size[0]==nRows && oShpAffinity.size[1]==nCols && oShpAffinity.size[2]==(int)m_nRealStereoLabels);
+    lvDbgAssert(oImgAffinity.dims==2 && oImgAffinity.rows==(int)m_nValidStereoGraphNodes && oImgAffinity.cols==(int)m_nRealStereoLabels);
+    lvDbgAssert(oShpAffinity.dims==2 && oShpAffinity.rows==(int)m_nValidStereoGraphNodes && oShpAffinity.cols==(int)m_nRealStereoLabels);
     lvDbgAssert(oImgSaliency.dims==2 && oImgSaliency.size[0]==nRows && oImgSaliency.size[1]==nCols);
     lvDbgAssert(oShpSaliency.dims==2 && oShpSaliency.size[0]==nRows && oShpSaliency.size[1]==nCols);
     const cv::Mat_<uchar> oGradY = vFeatures[FeatPackOffset*m_nPrimaryCamIdx+FeatPackOffset_GradY];
@@ -1334,8 +1495,8 @@ void SegmMatcher::GraphModelData::updateStereoModel(bool bInit) {
         #endif //SEGMMATCH_CONFIG_USE_MEDIAN_DIST_COST
             const int nOffsetColIdx = getOffsetColIdx(m_nPrimaryCamIdx,nColIdx,nLabelIdx);
             if(nOffsetColIdx>=0 && nOffsetColIdx<nCols && m_aROIs[m_nPrimaryCamIdx^1](nRowIdx,nOffsetColIdx)) {
-                const float fImgAffinity = oImgAffinity(nRowIdx,nColIdx,nLabelIdx);
-                const float fShpAffinity = oShpAffinity(nRowIdx,nColIdx,nLabelIdx);
+                const float fImgAffinity = oImgAffinity((int)nGraphNodeIdx,(int)nLabelIdx);
+                const float fShpAffinity = oShpAffinity((int)nGraphNodeIdx,(int)nLabelIdx);
                 lvDbgAssert__(fImgAffinity>=0.0f,"fImgAffinity = %1.10f @ [%d,%d]",fImgAffinity,nRowIdx,nColIdx);
                 lvDbgAssert__(fShpAffinity>=0.0f,"fShpAffinity = %1.10f @ [%d,%d]",fShpAffinity,nRowIdx,nColIdx);
                 vUnaryStereoLUT(nLabelIdx) += cost_cast(fImgAffinity*fImgSaliency*SEGMMATCH_IMGSIM_COST_DESC_SCALE);
@@ -2208,6 +2369,10 @@ void SegmMatcher::GraphModelData::updateResegmModel(bool bInit) {
     lvLog_(4,"Resegm graph model energy terms update completed in %f second(s).",oLocalTimer.tock());
 }
 
+SegmMatcher::GraphModelData::~GraphModelData() {
+    cancelAsyncFeatures();
+}
+
 void SegmMatcher::GraphModelData::calcFeatures(const MatArrayIn& aInputs, cv::Mat* pFeaturesPacket) {
     static_assert(s_nInputArraySize==4 && getCameraCount()==2,"lots of hardcoded indices below");
     lvDbgExceptionWatch;
@@ -2220,8 +2385,43 @@ void SegmMatcher::GraphModelData::calcFeatures(const MatArrayIn& aInputs, cv::Ma
         lvAssert_(oInputMask.type()==CV_8UC1,"unexpected input mask type");
     }
     m_vTempFeatures.resize(FeatPackSize); // if this function was not called externally, features will be swapped from this temporary to the internal array
-    calcImageFeatures(CamArray<cv::Mat>{aInputs[InputPack_LeftImg],aInputs[InputPack_RightImg]},m_vTempFeatures);
-    calcShapeFeatures(CamArray<cv::Mat_<InternalLabelType>>{aInputs[InputPack_LeftMask],aInputs[InputPack_RightMask]},m_vTempFeatures);
+    CamArray<cv::Mat> aPrevInputImages; // left empty (i.e. no temporal features) until a frame has been processed
+    if(getTemporalLayerCount()>1u && m_nFramesProcessed>0u) {
+        for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx) {
+            if(aInputs[nCamIdx*InputPackOffset+InputPackOffset_Img].data==m_aaInputs[0][nCamIdx*InputPackOffset+InputPackOffset_Img].data)
+                aPrevInputImages[nCamIdx] = m_aaInputs[1][nCamIdx*InputPackOffset+InputPackOffset_Img];
+            else
+                aPrevInputImages[nCamIdx] = m_aaInputs[0][nCamIdx*InputPackOffset+InputPackOffset_Img];
+        }
+    }
+    // feature computation is split in two stages: first, the image & shape feature maps of each camera head are independent tasks that
+    // only write to their own camera's slots (and use their own extractors), so they all run concurrently; then, the affinity stages
+    // need the maps of both heads, so they run in order after the join, each being internally parallel already
+    lvLog(3,"Calculating image & shape features maps...");
+    lv::StopWatch oLocalTimer;
+    runFeatureTasks(m_oFeatureWorkers,getCameraCount()*2,[&](size_t nTaskIdx) {
+        const size_t nCamIdx = nTaskIdx%getCameraCount();
+        if(nTaskIdx<getCameraCount())
+            calcImageFeatureMaps(aInputs[nCamIdx*InputPackOffset+InputPackOffset_Img],aPrevInputImages[nCamIdx],nCamIdx,m_oFeatExtractors,m_oFeatMaps,m_vTempFeatures);
+        else
+            calcShapeFeatureMaps(aInputs[nCamIdx*InputPackOffset+InputPackOffset_Mask],nCamIdx,m_oFeatExtractors,m_oFeatMaps,m_vTempFeatures);
+    },getCameraCount()/*shape tasks are light*/);
+    lvLog_(3,"Image & shape features maps computed in %f second(s).",oLocalTimer.tock());
+    calcAffinityFeatures(m_oFeatMaps,m_oFeatExtractors,m_vTempFeatures);
+    checkFeatures(pFeaturesPacket);
+}
+
+void SegmMatcher::GraphModelData::calcAffinityFeatures(const FeatureMaps& oMaps, const FeatureExtractors& oExtractors, std::vector<cv::Mat>& vFeatures) const {
+    lvDbgExceptionWatch;
+    lvDbgAssert_(vFeatures.size()==FeatPackSize,"unexpected feat vec size");
+    // note: this stage only reads the (constant) graph & ROI data of the model, so it does not depend on the previous frame's inference
+    calcImageAffinityFeatures(oMaps,vFeatures);
+    calcShapeAffinityFeatures(oMaps,oExtractors,vFeatures);
+}
+
+void SegmMatcher::GraphModelData::checkFeatures(cv::Mat* pFeaturesPacket) {
+    lvDbgExceptionWatch;
+    lvDbgAssert_(m_vTempFeatures.size()==FeatPackSize,"unexpected feat vec size");
     for(cv::Mat& oFeatMap : m_vTempFeatures)
         lvAssert_(oFeatMap.isContinuous(),"internal func used non-continuous data block for feature maps");
     if(pFeaturesPacket)
@@ -2236,136 +2436,252 @@ void SegmMatcher::GraphModelData::calcFeatures(const MatArrayIn& aInputs, cv::Ma
     lvAssert_(m_vLatestFeatPackInfo==m_vExpectedFeatPackInfo,"packed features info mismatch (should stay constant for all inputs)");
 }
 
-void SegmMatcher::GraphModelData::calcImageFeatures(const CamArray<cv::Mat>& aInputImages, std::vector<cv::Mat>& vFeatures) {
-    static_assert(getCameraCount()==2,"bad input image array size");
+void SegmMatcher::GraphModelData::queueNextInputs(const MatArrayIn& aInputs) {
+    static_assert(s_nInputArraySize==4 && getCameraCount()==2,"lots of hardcoded indices below");
+    lvDbgExceptionWatch;
+    for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx) {
+        const cv::Mat& oInputImg = aInputs[nCamIdx*InputPackOffset+InputPackOffset_Img];
+        lvAssert__(oInputImg.dims==2 && m_oGridSize==oInputImg.size(),"input image in array at index=%d had the wrong size",(int)nCamIdx);
+        lvAssert_(oInputImg.type()==CV_8UC1 || oInputImg.type()==CV_8UC3,"unexpected input image type");
+        const cv::Mat& oInputMask = aInputs[nCamIdx*InputPackOffset+InputPackOffset_Mask];
+        lvAssert__(oInputMask.dims==2 && m_oGridSize==oInputMask.size(),"input mask in array at index=%d had the wrong size",(int)nCamIdx);
+        lvAssert_(oInputMask.type()==CV_8UC1,"unexpected input mask type");
+    }
+    lvAssert_(!m_bUsePrecalcFeaturesNext,"cannot queue inputs while a precalculated features packet is pending");
+    if(!m_pAsyncFeatData)
+        m_pAsyncFeatData = std::make_unique<AsyncFeatureData>();
+    std::deque<std::unique_ptr<AsyncFeaturePacket>>& qpPackets = m_pAsyncFeatData->qpPackets;
+    lvAssert__(qpPackets.size()<SEGMMATCH_DEFAULT_ASYNC_QUEUE_SIZE,"async feature queue is full (max = %d packets); 'apply' must be called first",(int)SEGMMATCH_DEFAULT_ASYNC_QUEUE_SIZE);
+    // previous images for temporal features come from the last queued frame, or from the last processed frame if nothing is queued
+    CamArray<cv::Mat> aPrevInputImages;
+    if(getTemporalLayerCount()>1u && (!qpPackets.empty() || m_nFramesProcessed>0u)) {
+        const MatArrayIn& aPrevInputs = qpPackets.empty()?m_aaInputs[0]:qpPackets.back()->aInputs;
+        for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx)
+            aPrevInputImages[nCamIdx] = aPrevInputs[nCamIdx*InputPackOffset+InputPackOffset_Img].clone(); // deep copy, as 'apply' overwrites the temporal layers
+    }
+    qpPackets.push_back(std::make_unique<AsyncFeaturePacket>());
+    AsyncFeaturePacket* pPacket = qpPackets.back().get(); // stays valid until popped, which always waits for the result first
+    pPacket->nFrameIdx = m_nFramesProcessed+qpPackets.size()-1u;
+    for(size_t nInputIdx=0; nInputIdx<aInputs.size(); ++nInputIdx) {
+        pPacket->aInputs[nInputIdx] = aInputs[nInputIdx].clone();
+        pPacket->apInputData[nInputIdx] = aInputs[nInputIdx].data;
+    }
+    pPacket->vFeatures.resize(FeatPackSize);
+    AsyncFeatureData* pAsyncData = m_pAsyncFeatData.get();
+    const bool bRunInBackground = lv::getVerbosity()<4; // debug displays are not thread-safe, compute everything right away on the caller's thread instead
+    std::packaged_task<void()> oFrameTask([this,pAsyncData,pPacket,aPrevInputImages,bRunInBackground]() {
+    #if USING_OPENMP
+        if(bRunInBackground) // split among per-camera tasks, and used as-is by the affinity stages (the setting only affects the frame worker)
+            omp_set_num_threads(int(pAsyncData->nThreadBudget));
+    #else //!USING_OPENMP
+        lvIgnore(bRunInBackground);
+    #endif //!USING_OPENMP
+        FeatureMaps oMaps; // only needed until the affinity stages are done
+        runFeatureTasks(pAsyncData->oTaskWorkers,getCameraCount()*2,[&](size_t nTaskIdx) {
+            if(pAsyncData->bCanceled)
+                return;
+            const size_t nCamIdx = nTaskIdx%getCameraCount();
+            if(nTaskIdx<getCameraCount())
+                calcImageFeatureMaps(pPacket->aInputs[nCamIdx*InputPackOffset+InputPackOffset_Img],aPrevInputImages[nCamIdx],nCamIdx,pAsyncData->oExtractors,oMaps,pPacket->vFeatures);
+            else
+                calcShapeFeatureMaps(pPacket->aInputs[nCamIdx*InputPackOffset+InputPackOffset_Mask],nCamIdx,pAsyncData->oExtractors,oMaps,pPacket->vFeatures);
+        },getCameraCount()/*shape tasks are light*/);
+        if(!pAsyncData->bCanceled)
+            calcAffinityFeatures(oMaps,pAsyncData->oExtractors,pPacket->vFeatures);
+    });
+    pPacket->oResult = oFrameTask.get_future();
+    if(bRunInBackground)
+        pAsyncData->oFrameWorker.queueTask(std::move(oFrameTask));
+    else
+        oFrameTask();
+}
+
+std::unique_ptr<SegmMatcher::GraphModelData::AsyncFeaturePacket> SegmMatcher::GraphModelData::popAsyncFeatures(const MatArrayIn& aInputs) {
+    lvDbgExceptionWatch;
+    if(!m_pAsyncFeatData || m_pAsyncFeatData->qpPackets.empty())
+        return nullptr;
+    std::unique_ptr<AsyncFeaturePacket> pPacket = std::move(m_pAsyncFeatData->qpPackets.front());
+    m_pAsyncFeatData->qpPackets.pop_front();
+    pPacket->oResult.wait(); // packet must be done before it can be released, even if it does not match
+    lvAssert__(pPacket->nFrameIdx==m_nFramesProcessed,"oldest queued inputs were meant for frame #%d, but frame #%d is being applied",(int)pPacket->nFrameIdx,(int)m_nFramesProcessed);
+    for(size_t nInputIdx=0; nInputIdx<aInputs.size(); ++nInputIdx) // queued inputs are identified by their buffers; their contents are not compared
+        lvAssert__(lv::MatInfo(aInputs[nInputIdx])==lv::MatInfo(pPacket->aInputs[nInputIdx]) && aInputs[nInputIdx].data==pPacket->apInputData[nInputIdx],
+                   "input at index=%d does not match the oldest queued inputs (queued inputs must be applied in order)",(int)nInputIdx);
+    pPacket->oResult.get();
+    return pPacket;
+}
+
+void SegmMatcher::GraphModelData::cancelAsyncFeatures() {
     lvDbgExceptionWatch;
-    for(size_t nInputIdx=0; nInputIdx<aInputImages.size(); ++nInputIdx) {
-        lvDbgAssert__(aInputImages[nInputIdx].dims==2 && m_oGridSize==aInputImages[nInputIdx].size(),"input at index=%d had the wrong size",(int)nInputIdx);
-        lvDbgAssert_(aInputImages[nInputIdx].type()==CV_8UC1 || aInputImages[nInputIdx].type()==CV_8UC3,"unexpected input image type");
+    if(!m_pAsyncFeatData)
+        return;
+    m_pAsyncFeatData->bCanceled = true;
+    for(std::unique_ptr<AsyncFeaturePacket>& pPacket : m_pAsyncFeatData->qpPackets)
+        pPacket->oResult.wait(); // canceled packets return right away, and failures are dropped with them
+    m_pAsyncFeatData->qpPackets.clear();
+    m_pAsyncFeatData->bCanceled = false;
+}
+
+void SegmMatcher::GraphModelData::runFeatureTasks(FeatureWorkerPool& oWorkers, size_t nTaskCount, const std::function<void(size_t)>& lTask, size_t nLightTaskCount) const {
+    lvDbgAssert(nLightTaskCount<=nTaskCount);
+    if(!m_bUseFeatureWorkers || lv::getVerbosity()>=4) { // debug displays are not thread-safe, run everything on the caller's thread instead
+        for(size_t nTaskIdx=0; nTaskIdx<nTaskCount; ++nTaskIdx)
+            lTask(nTaskIdx);
+        return;
     }
+#if USING_OPENMP
+    // extractors open their own omp parallel regions; with a full team per task, cores would be oversubscribed ~nTaskCount-fold, so the
+    // caller's thread budget is split among tasks instead (the team size setting is per-thread, so only the pool's workers are affected)
+    // tasks are not equally expensive: image tasks (dense descriptors + optical flow) dominate, while shape context tasks on binary masks
+    // finish much sooner, so light tasks keep one thread each and heavy tasks share the rest (an equal split would leave the image tasks on
+    // the critical path with as few threads as the shape ones)
+    // note: queued (async) features overlap with the caller's inference, so they only get half of the caller's budget (see AsyncFeatureData)
+    const size_t nHeavyTaskCount = nTaskCount-nLightTaskCount;
+    const int nHeavyTaskThreads = nHeavyTaskCount?std::max((omp_get_max_threads()-int(nLightTaskCount))/int(nHeavyTaskCount),1):1;
+    const std::function<void(size_t)> lTeamTask = [&lTask,nHeavyTaskCount,nHeavyTaskThreads](size_t nTaskIdx) {
+        omp_set_num_threads(nTaskIdx<nHeavyTaskCount?nHeavyTaskThreads:1);
+        lTask(nTaskIdx);
+    };
+#else //!USING_OPENMP
+    const std::function<void(size_t)>& lTeamTask = lTask;
+#endif //!USING_OPENMP
+    std::vector<std::future<void>> vTaskResults;
+    for(size_t nTaskIdx=0; nTaskIdx<nTaskCount; ++nTaskIdx)
+        vTaskResults.push_back(oWorkers.queueTask(lTeamTask,nTaskIdx));
+    for(std::future<void>& oTaskResult : vTaskResults)
+        oTaskResult.wait(); // all tasks must be done before rethrowing, as they reference the caller's data
+    for(std::future<void>& oTaskResult : vTaskResults)
+        oTaskResult.get();
+}
+
+void SegmMatcher::GraphModelData::calcImageFeatureMaps(const cv::Mat& oInputImage, const cv::Mat& oPrevInputImage, size_t nCamIdx, FeatureExtractors& oExtractors, FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const {
+    lvDbgExceptionWatch;
+    lvDbgAssert_(nCamIdx<getCameraCount(),"bad input cam index");
+    lvDbgAssert_(oInputImage.dims==2 && m_oGridSize==oInputImage.size(),"input had the wrong size");
+    lvDbgAssert_(oInputImage.type()==CV_8UC1 || oInputImage.type()==CV_8UC3,"unexpected input image type");
+    lvDbgAssert_(vFeatures.size()==FeatPackSize,"unexpected feat vec size");
+    lvIgnore(oExtractors);
+    const int nWinRadius = (int)m_nGridBorderSize;
+    cv::Mat& oEnlargedInput = oMaps.aEnlargedImgInputs[nCamIdx];
+    cv::copyMakeBorder(oInputImage,oEnlargedInput,nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_DEFAULT);
+#if SEGMMATCH_CONFIG_USE_MI_AFFINITY
+    if(oEnlargedInput.channels()==3)
+        cv::cvtColor(oEnlargedInput,oEnlargedInput,cv::COLOR_BGR2GRAY);
+    cv::copyMakeBorder(m_aROIs[nCamIdx],oMaps.aEnlargedImgROIs[nCamIdx],nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_CONSTANT,cv::Scalar(0));
+#elif SEGMMATCH_CONFIG_USE_SSQDIFF_AFFINITY
+    if(oEnlargedInput.channels()==3)
+        cv::cvtColor(oEnlargedInput,oEnlargedInput,cv::COLOR_BGR2GRAY);
+    oEnlargedInput.convertTo(oEnlargedInput,CV_64F,(1.0/UCHAR_MAX)/(nWinRadius*2+1));
+    oEnlargedInput -= cv::mean(oEnlargedInput)[0];
+    cv::copyMakeBorder(m_aROIs[nCamIdx],oMaps.aEnlargedImgROIs[nCamIdx],nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_CONSTANT,cv::Scalar(0));
+#elif SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
+    const int nRows=(int)m_oGridSize(0),nCols=(int)m_oGridSize(1);
+    lvIgnore(nRows); lvIgnore(nCols);
+    lvLog_(3,"\tcam[%d] image descriptors...",(int)nCamIdx);
+    cv::Mat_<float> oEnlargedDescs;
+    oExtractors.apImgDescExtractors[nCamIdx]->compute2(oEnlargedInput,oEnlargedDescs);
+    lvDbgAssert(oEnlargedDescs.dims==3 && oEnlargedDescs.size[0]==nRows+nWinRadius*2 && oEnlargedDescs.size[1]==nCols+nWinRadius*2);
+    std::vector<cv::Range> vRanges(size_t(3),cv::Range::all());
+    vRanges[0] = cv::Range(nWinRadius,nRows+nWinRadius);
+    vRanges[1] = cv::Range(nWinRadius,nCols+nWinRadius);
+    oEnlargedDescs(vRanges.data()).copyTo(oMaps.aImgDescs[nCamIdx]); // copy to avoid bugs when reshaping non-continuous data
+    lvDbgAssert(oMaps.aImgDescs[nCamIdx].dims==3 && oMaps.aImgDescs[nCamIdx].size[0]==nRows && oMaps.aImgDescs[nCamIdx].size[1]==nCols);
+    lvDbgAssert(std::equal(oMaps.aImgDescs[nCamIdx].ptr<float>(0,0),oMaps.aImgDescs[nCamIdx].ptr<float>(0,0)+oMaps.aImgDescs[nCamIdx].size[2],oEnlargedDescs.ptr<float>(nWinRadius,nWinRadius)));
+#if SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
+    const size_t nDescSize = size_t(oMaps.aImgDescs[nCamIdx].size[2]);
+    for(size_t nDescIdx=0; nDescIdx<oMaps.aImgDescs[nCamIdx].total(); nDescIdx+=nDescSize)
+        lv::rootSIFT(((float*)oMaps.aImgDescs[nCamIdx].data)+nDescIdx,nDescSize);
+#endif //SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
+#endif //SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
+    lvLog_(3,"\tcam[%d] image gradient magnitudes...",(int)nCamIdx);
+    cv::Mat oBlurredInput,oGrayInput;
+    cv::GaussianBlur(oInputImage,oBlurredInput,cv::Size(3,3),0);
+    cv::Mat oBlurredGrayInput;
+    if(oBlurredInput.channels()==3) {
+        cv::cvtColor(oBlurredInput,oBlurredGrayInput,cv::COLOR_BGR2GRAY);
+        cv::cvtColor(oInputImage,oGrayInput,cv::COLOR_BGR2GRAY);
+    }
+    else {
+        oBlurredGrayInput = oBlurredInput;
+        oGrayInput = oInputImage;
+    }
+    cv::Mat oGradInput_X,oGradInput_Y;
+    cv::Sobel(oBlurredGrayInput,oGradInput_Y,CV_16S,0,1,SEGMMATCH_DEFAULT_GRAD_KERNEL_SIZE);
+    cv::Mat& oGradY = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradY];
+    cv::normalize(cv::abs(oGradInput_Y),oGradY,255,0,cv::NORM_MINMAX,CV_8U);
+    cv::Sobel(oBlurredGrayInput,oGradInput_X,CV_16S,1,0,SEGMMATCH_DEFAULT_GRAD_KERNEL_SIZE);
+    cv::Mat& oGradX = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradX];
+    cv::normalize(cv::abs(oGradInput_X),oGradX,255,0,cv::NORM_MINMAX,CV_8U);
+    cv::Mat& oGradMag = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradMag];
+    cv::addWeighted(oGradY,0.5,oGradX,0.5,0,oGradMag);
+    /*cv::imshow("gradm_full",oGradMag);
+    cv::imshow("gradm_0.5piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST/2);
+    cv::imshow("gradm_1.0piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST);
+    cv::imshow("gradm_2.0piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST*2);
+    cv::imshow("gradm_100",oGradMag>100);
+    cv::imshow("gradm_150",oGradMag>150);
+    cv::waitKey(0);*/
+    cv::Mat& oOptFlow = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_OptFlow];
+    cv::Mat& oTempDiff = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_TempDiff];
+    oOptFlow.create(m_oGridSize,CV_32FC2);
+    oTempDiff.create(m_oGridSize,CV_8UC1);
+    if(!oPrevInputImage.empty()) {
+        const cv::Mat& oPreviousInput = oPrevInputImage;
+        lvDbgAssert(lv::MatInfo(oInputImage)==lv::MatInfo(oPreviousInput));
+        ofdis::computeFlow(oPreviousInput,oInputImage,oOptFlow);
+        lvDbgAssert(m_oGridSize==oOptFlow.size && oOptFlow.type()==CV_32FC2);
+        lvDbgAssert(oOptFlow.data==vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_OptFlow].data);
+        cv::Mat oPreviousGrayInput;
+        if(oPreviousInput.channels()==3)
+            cv::cvtColor(oPreviousInput,oPreviousGrayInput,cv::COLOR_BGR2GRAY);
+        else
+            oPreviousGrayInput = oPreviousInput;
+        cv::Mat oTempDiff_32f;
+        lv::computeTemporalAbsDiff(oPreviousGrayInput,oGrayInput,oOptFlow,oTempDiff_32f);
+        oTempDiff_32f.convertTo(oTempDiff,CV_8U);
+        lvDbgAssert(m_oGridSize==oTempDiff.size && oTempDiff.data==vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_TempDiff].data);
+        if(lv::getVerbosity()>=4) {
+            cv::imshow(std::string("oOptFlow-")+std::to_string(nCamIdx),lv::getFlowColorMap(oOptFlow));
+            cv::imshow(std::string("oTempDiff-")+std::to_string(nCamIdx),oTempDiff);
+            cv::Mat oInputRemap;
+            lv::remap_offset(oPreviousGrayInput,oInputRemap,oOptFlow,cv::INTER_LINEAR,cv::BORDER_REPLICATE);
+            cv::imshow(std::string("oInputRemap-")+std::to_string(nCamIdx),oInputRemap);
+            cv::waitKey(1);
+        }
+    }
+    else {
+        oOptFlow = cv::Vec2f(0.0f,0.0f);
+        oTempDiff = 0u;
+    }
+}
+
+void SegmMatcher::GraphModelData::calcImageAffinityFeatures(const FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const {
+    lvDbgExceptionWatch;
     lvDbgAssert_(vFeatures.size()==FeatPackSize,"unexpected feat vec size");
     const int nRows=(int)m_oGridSize(0),nCols=(int)m_oGridSize(1);
-    lvLog(3,"Calculating image features maps...");
     const int nWinRadius = (int)m_nGridBorderSize;
     const int nWinSize = nWinRadius*2+1;
-    CamArray<cv::Mat> aEnlargedInput;
 #if SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
     lvIgnore(nWinSize);
-    CamArray<cv::Mat_<float>> aEnlargedDescs,aDescs;
+    const CamArray<cv::Mat_<float>>& aDescs = oMaps.aImgDescs;
     const int nPatchSize = SEGMMATCH_DEFAULT_DESC_PATCH_SIZE;
 #else //!SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
-    CamArray<cv::Mat_<uchar>> aEnlargedROIs;
+    const CamArray<cv::Mat>& aEnlargedInput = oMaps.aEnlargedImgInputs;
+    const CamArray<cv::Mat_<uchar>>& aEnlargedROIs = oMaps.aEnlargedImgROIs;
     const int nPatchSize = nWinSize;
 #endif //SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
     lvAssert_((nPatchSize%2)==1,"patch sizes must be odd");
     lv::StopWatch oLocalTimer;
-#if USING_OPENMP
-    //#pragma omp parallel for num_threads(getCameraCount())
-#endif //USING_OPENMP
-    for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx) {
-        cv::copyMakeBorder(aInputImages[nCamIdx],aEnlargedInput[nCamIdx],nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_DEFAULT);
-    #if SEGMMATCH_CONFIG_USE_MI_AFFINITY
-        if(aEnlargedInput[nCamIdx].channels()==3)
-            cv::cvtColor(aEnlargedInput[nCamIdx],aEnlargedInput[nCamIdx],cv::COLOR_BGR2GRAY);
-        cv::copyMakeBorder(m_aROIs[nCamIdx],aEnlargedROIs[nCamIdx],nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_CONSTANT,cv::Scalar(0));
-    #elif SEGMMATCH_CONFIG_USE_SSQDIFF_AFFINITY
-        if(aEnlargedInput[nCamIdx].channels()==3)
-            cv::cvtColor(aEnlargedInput[nCamIdx],aEnlargedInput[nCamIdx],cv::COLOR_BGR2GRAY);
-        aEnlargedInput[nCamIdx].convertTo(aEnlargedInput[nCamIdx],CV_64F,(1.0/UCHAR_MAX)/nWinSize);
-        aEnlargedInput[nCamIdx] -= cv::mean(aEnlargedInput[nCamIdx])[0];
-        cv::copyMakeBorder(m_aROIs[nCamIdx],aEnlargedROIs[nCamIdx],nWinRadius,nWinRadius,nWinRadius,nWinRadius,cv::BORDER_CONSTANT,cv::Scalar(0));
-    #elif SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
-        lvLog_(3,"\tcam[%d] image descriptors...",(int)nCamIdx);
-        m_pImgDescExtractor->compute2(aEnlargedInput[nCamIdx],aEnlargedDescs[nCamIdx]);
-        lvDbgAssert(aEnlargedDescs[nCamIdx].dims==3 && aEnlargedDescs[nCamIdx].size[0]==nRows+nWinRadius*2 && aEnlargedDescs[nCamIdx].size[1]==nCols+nWinRadius*2);
-        std::vector<cv::Range> vRanges(size_t(3),cv::Range::all());
-        vRanges[0] = cv::Range(nWinRadius,nRows+nWinRadius);
-        vRanges[1] = cv::Range(nWinRadius,nCols+nWinRadius);
-        aEnlargedDescs[nCamIdx](vRanges.data()).copyTo(aDescs[nCamIdx]); // copy to avoid bugs when reshaping non-continuous data
-        lvDbgAssert(aDescs[nCamIdx].dims==3 && aDescs[nCamIdx].size[0]==nRows && aDescs[nCamIdx].size[1]==nCols);
-        lvDbgAssert(std::equal(aDescs[nCamIdx].ptr<float>(0,0),aDescs[nCamIdx].ptr<float>(0,0)+aDescs[nCamIdx].size[2],aEnlargedDescs[nCamIdx].ptr<float>(nWinRadius,nWinRadius)));
-    #if SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
-        const size_t nDescSize = size_t(aDescs[nCamIdx].size[2]);
-        for(size_t nDescIdx=0; nDescIdx<aDescs[nCamIdx].total(); nDescIdx+=nDescSize)
-            lv::rootSIFT(((float*)aDescs[nCamIdx].data)+nDescIdx,nDescSize);
-    #endif //SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
-    #endif //SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
-        lvLog_(3,"\tcam[%d] image gradient magnitudes...",(int)nCamIdx);
-        cv::Mat oBlurredInput,oGrayInput;
-        cv::GaussianBlur(aInputImages[nCamIdx],oBlurredInput,cv::Size(3,3),0);
-        cv::Mat oBlurredGrayInput;
-        if(oBlurredInput.channels()==3) {
-            cv::cvtColor(oBlurredInput,oBlurredGrayInput,cv::COLOR_BGR2GRAY);
-            cv::cvtColor(aInputImages[nCamIdx],oGrayInput,cv::COLOR_BGR2GRAY);
-        }
-        else {
-            oBlurredGrayInput = oBlurredInput;
-            oGrayInput = aInputImages[nCamIdx];
-        }
-        cv::Mat oGradInput_X,oGradInput_Y;
-        cv::Sobel(oBlurredGrayInput,oGradInput_Y,CV_16S,0,1,SEGMMATCH_DEFAULT_GRAD_KERNEL_SIZE);
-        cv::Mat& oGradY = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradY];
-        cv::normalize(cv::abs(oGradInput_Y),oGradY,255,0,cv::NORM_MINMAX,CV_8U);
-        cv::Sobel(oBlurredGrayInput,oGradInput_X,CV_16S,1,0,SEGMMATCH_DEFAULT_GRAD_KERNEL_SIZE);
-        cv::Mat& oGradX = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradX];
-        cv::normalize(cv::abs(oGradInput_X),oGradX,255,0,cv::NORM_MINMAX,CV_8U);
-        cv::Mat& oGradMag = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_GradMag];
-        cv::addWeighted(oGradY,0.5,oGradX,0.5,0,oGradMag);
-        /*cv::imshow("gradm_full",oGradMag);
-        cv::imshow("gradm_0.5piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST/2);
-        cv::imshow("gradm_1.0piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST);
-        cv::imshow("gradm_2.0piv",oGradMag>SEGMMATCH_LBLSIM_COST_GRADPIVOT_CST*2);
-        cv::imshow("gradm_100",oGradMag>100);
-        cv::imshow("gradm_150",oGradMag>150);
-        cv::waitKey(0);*/
-        cv::Mat& oOptFlow = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_OptFlow];
-        cv::Mat& oTempDiff = vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_TempDiff];
-        oOptFlow.create(m_oGridSize,CV_32FC2);
-        oTempDiff.create(m_oGridSize,CV_8UC1);
-        if(getTemporalLayerCount()>1u && m_nFramesProcessed>0u) {
-            cv::Mat oPreviousInput;
-            if(aInputImages[nCamIdx].data==m_aaInputs[0][nCamIdx*InputPackOffset+InputPackOffset_Img].data)
-                oPreviousInput = m_aaInputs[1][nCamIdx*InputPackOffset+InputPackOffset_Img];
-            else
-                oPreviousInput = m_aaInputs[0][nCamIdx*InputPackOffset+InputPackOffset_Img];
-            lvDbgAssert(lv::MatInfo(aInputImages[nCamIdx])==lv::MatInfo(oPreviousInput));
-            ofdis::computeFlow(oPreviousInput,aInputImages[nCamIdx],oOptFlow);
-            lvDbgAssert(m_oGridSize==oOptFlow.size && oOptFlow.type()==CV_32FC2);
-            lvDbgAssert(oOptFlow.data==vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_OptFlow].data);
-            cv::Mat oPreviousGrayInput;
-            if(oPreviousInput.channels()==3)
-                cv::cvtColor(oPreviousInput,oPreviousGrayInput,cv::COLOR_BGR2GRAY);
-            else
-                oPreviousGrayInput = oPreviousInput;
-            cv::Mat oTempDiff_32f;
-            lv::computeTemporalAbsDiff(oPreviousGrayInput,oGrayInput,oOptFlow,oTempDiff_32f);
-            oTempDiff_32f.convertTo(oTempDiff,CV_8U);
-            lvDbgAssert(m_oGridSize==oTempDiff.size && oTempDiff.data==vFeatures[nCamIdx*FeatPackOffset+FeatPackOffset_TempDiff].data);
-            if(lv::getVerbosity()>=4) {
-                cv::imshow(std::string("oOptFlow-")+std::to_string(nCamIdx),lv::getFlowColorMap(oOptFlow));
-                cv::imshow(std::string("oTempDiff-")+std::to_string(nCamIdx),oTempDiff);
-                cv::Mat oInputRemap;
-                lv::remap_offset(oPreviousGrayInput,oInputRemap,oOptFlow,cv::INTER_LINEAR,cv::BORDER_REPLICATE);
-                cv::imshow(std::string("oInputRemap-")+std::to_string(nCamIdx),oInputRemap);
-                cv::waitKey(1);
-            }
-        }
-        else {
-            oOptFlow = cv::Vec2f(0.0f,0.0f);
-            oTempDiff = 0u;
-        }
-    }
-    lvLog_(3,"Image features maps computed in %f second(s).",oLocalTimer.tock());
     lvLog(3,"Calculating image affinity map...");
-    const std::array<int,3> anAffinityMapDims = {nRows,nCols,(int)m_nRealStereoLabels};
-    vFeatures[FeatPack_ImgAffinity].create(3,anAffinityMapDims.data(),CV_32FC1);
+    const std::array<int,2> anAffinityMapDims = {(int)m_nValidStereoGraphNodes,(int)m_nRealStereoLabels};
+    vFeatures[FeatPack_ImgAffinity].create(2,anAffinityMapDims.data(),CV_32FC1);
     cv::Mat_<float> oAffinity = vFeatures[FeatPack_ImgAffinity];
     std::vector<int> vDisparityOffsets;
     for(InternalLabelType nLabelIdx = 0; nLabelIdx<m_nRealStereoLabels; ++nLabelIdx)
         vDisparityOffsets.push_back(getOffsetValue(0,nLabelIdx));
-    // note: we only create the dense affinity map for 1st cam here; affinity for 2nd cam will be deduced from it
+    // note: we only keep the affinities of 1st cam graph nodes here (over the full disparity range); affinity for 2nd cam will be deduced from it
 #if SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
-    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,oAffinity,vDisparityOffsets,lv::AffinityDist_L2,m_aROIs[0],m_aROIs[1]);
+    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,m_vStereoGraphNodeCoords,std::vector<int>(m_nValidStereoGraphNodes,0),(int)m_nRealStereoLabels,oAffinity,vDisparityOffsets,lv::AffinityDist_L2,m_aROIs[0],m_aROIs[1]);
     /*cv::Mat_<float> tmp;
     lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,tmp,vDisparityOffsets,lv::AffinityDist_L2,m_aROIs[0],m_aROIs[1],cv::Mat_<float>(),false);
     lvAssert(lv::MatInfo(tmp)==lv::MatInfo(oAffinity));
@@ -2373,16 +2689,25 @@ void SegmMatcher::GraphModelData::calcImageFeatures(const CamArray<cv::Mat>& aIn
         for(int j=0; j<nCols; ++j)
             for(int k=0; k<anAffinityMapDims[2]; ++k)
                     lvAssert__(std::abs(tmp(i,j,k)-oAffinity(i,j,k))<0.0001f," %d,%d,%d =  %f vs %f,   w/ roi0 = %d",i,j,k,tmp(i,j,k),oAffinity(i,j,k),(int)m_aROIs[0](i,j));*/
-#elif SEGMMATCH_CONFIG_USE_MI_AFFINITY
-    lv::computeImageAffinity(aEnlargedInput[0],aEnlargedInput[1],nWinSize,oAffinity,vDisparityOffsets,lv::AffinityDist_MI,aEnlargedROIs[0],aEnlargedROIs[1]);
+#else //!SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
+    // image-based affinities are computed densely, and only the graph node rows are kept
+    cv::Mat_<float> oDenseAffinity;
+#if SEGMMATCH_CONFIG_USE_MI_AFFINITY
+    lv::computeImageAffinity(aEnlargedInput[0],aEnlargedInput[1],nWinSize,oDenseAffinity,vDisparityOffsets,lv::AffinityDist_MI,aEnlargedROIs[0],aEnlargedROIs[1]);
 #elif SEGMMATCH_CONFIG_USE_SSQDIFF_AFFINITY
-    lv::computeImageAffinity(aEnlargedInput[0],aEnlargedInput[1],nWinSize,oAffinity,vDisparityOffsets,lv::AffinityDist_SSD,aEnlargedROIs[0],aEnlargedROIs[1]);
+    lv::computeImageAffinity(aEnlargedInput[0],aEnlargedInput[1],nWinSize,oDenseAffinity,vDisparityOffsets,lv::AffinityDist_SSD,aEnlargedROIs[0],aEnlargedROIs[1]);
 #endif //SEGMMATCH_CONFIG_USE_..._AFFINITY
-    lvDbgAssert(lv::MatInfo(oAffinity)==lv::MatInfo(lv::MatSize(3,anAffinityMapDims.data()),CV_32FC1));
+    lvDbgAssert(oDenseAffinity.dims==3 && oDenseAffinity.size[0]==nRows && oDenseAffinity.size[1]==nCols && oDenseAffinity.size[2]==(int)m_nRealStereoLabels);
+    for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
+        const cv::Point2i& oNodeCoord = m_vStereoGraphNodeCoords[nGraphNodeIdx];
+        std::copy_n(oDenseAffinity.ptr<float>(oNodeCoord.y,oNodeCoord.x),m_nRealStereoLabels,oAffinity.ptr<float>((int)nGraphNodeIdx));
+    }
+#endif //!SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
+    lvDbgAssert(lv::MatInfo(oAffinity)==lv::MatInfo(lv::MatSize(2,anAffinityMapDims.data()),CV_32FC1));
     lvDbgAssert(vFeatures[FeatPack_ImgAffinity].data==oAffinity.data);
     lvLog_(3,"Image affinity map computed in %f second(s).",oLocalTimer.tock());
     lvLog(3,"Calculating image saliency map...");
-    vFeatures[FeatPack_ImgSaliency].create(2,anAffinityMapDims.data(),CV_32FC1);
+    vFeatures[FeatPack_ImgSaliency].create(nRows,nCols,CV_32FC1);
     cv::Mat_<float> oSaliency = vFeatures[FeatPack_ImgSaliency];
     oSaliency = 0.0f; // default value for OOB pixels
     std::vector<float> vValidAffinityVals;
@@ -2394,7 +2719,7 @@ void SegmMatcher::GraphModelData::calcImageFeatures(const CamArray<cv::Mat>& aIn
         const int nColIdx = oNode.nColIdx;
         lvDbgAssert(oNode.bValidGraphNode && m_aROIs[m_nPrimaryCamIdx](nRowIdx,nColIdx)>0);
         vValidAffinityVals.resize(0);
-        const float* pAffinityPtr = oAffinity.ptr<float>(nRowIdx,nColIdx);
+        const float* pAffinityPtr = oAffinity.ptr<float>((int)nGraphNodeIdx);
         std::copy_if(pAffinityPtr,pAffinityPtr+m_nRealStereoLabels,std::back_inserter(vValidAffinityVals),[](float v){return v>=0.0f;});
         const float fCurrDistSparseness = vValidAffinityVals.size()>1?(float)lv::sparseness(vValidAffinityVals.data(),vValidAffinityVals.size()):0.0f;
 #if SEGMMATCH_CONFIG_USE_DESC_BASED_AFFINITY
@@ -2429,51 +2754,62 @@ void SegmMatcher::GraphModelData::calcImageFeatures(const CamArray<cv::Mat>& aIn
 void SegmMatcher::GraphModelData::calcShapeFeatures(const CamArray<cv::Mat_<InternalLabelType>>& aInputMasks, std::vector<cv::Mat>& vFeatures) {
     static_assert(getCameraCount()==2,"bad input mask array size");
     lvDbgExceptionWatch;
-    for(size_t nInputIdx=0; nInputIdx<aInputMasks.size(); ++nInputIdx) {
-        lvDbgAssert__(aInputMasks[nInputIdx].dims==2 && m_oGridSize==aInputMasks[nInputIdx].size(),"input at index=%d had the wrong size",(int)nInputIdx);
-        lvDbgAssert_(aInputMasks[nInputIdx].type()==CV_8UC1,"unexpected input mask type");
-    }
+    lvLog(3,"Calculating shape features maps...");
+    lv::StopWatch oLocalTimer;
+    runFeatureTasks(m_oFeatureWorkers,getCameraCount(),[&](size_t nCamIdx) {
+        calcShapeFeatureMaps(aInputMasks[nCamIdx],nCamIdx,m_oFeatExtractors,m_oFeatMaps,vFeatures);
+    });
+    lvLog_(3,"Shape features maps computed in %f second(s).",oLocalTimer.tock());
+    calcShapeAffinityFeatures(m_oFeatMaps,m_oFeatExtractors,vFeatures);
+}
+
+void SegmMatcher::GraphModelData::calcShapeFeatureMaps(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, FeatureExtractors& oExtractors, FeatureMaps& oMaps, std::vector<cv::Mat>& vFeatures) const {
+    lvDbgExceptionWatch;
+    lvDbgAssert_(nCamIdx<getCameraCount(),"bad input cam index");
+    lvDbgAssert_(oInputMask.dims==2 && m_oGridSize==oInputMask.size(),"input had the wrong size");
+    lvDbgAssert_(oInputMask.type()==CV_8UC1,"unexpected input mask type");
     lvDbgAssert_(vFeatures.size()==FeatPackSize,"unexpected feat vec size");
     const int nRows=(int)m_oGridSize(0),nCols=(int)m_oGridSize(1);
-    lvLog(3,"Calculating shape features maps...");
-    CamArray<cv::Mat_<float>> aDescs;
+    lvIgnore(nRows); lvIgnore(nCols);
+    cv::Mat_<float>& oDescs = oMaps.aShpDescs[nCamIdx];
+    lvLog_(3,"\tcam[%d] shape descriptors...",(int)nCamIdx);
+    oExtractors.apShpDescExtractors[nCamIdx]->compute2(oInputMask,oDescs);
+    lvDbgAssert(oDescs.dims==3 && oDescs.size[0]==nRows && oDescs.size[1]==nCols);
+#if SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
+    const size_t nDescSize = size_t(oDescs.size[2]);
+    for(size_t nDescIdx=0; nDescIdx<oDescs.total(); nDescIdx+=nDescSize)
+        lv::rootSIFT(((float*)oDescs.data)+nDescIdx,nDescSize);
+#endif //SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
+    lvLog_(3,"\tcam[%d] shape distance fields...",(int)nCamIdx);
+    calcShapeDistFeatures(oInputMask,nCamIdx,vFeatures);
+}
+
+void SegmMatcher::GraphModelData::calcShapeAffinityFeatures(const FeatureMaps& oMaps, const FeatureExtractors& oExtractors, std::vector<cv::Mat>& vFeatures) const {
+    lvDbgExceptionWatch;
+    lvDbgAssert_(vFeatures.size()==FeatPackSize,"unexpected feat vec size");
+    const int nRows=(int)m_oGridSize(0),nCols=(int)m_oGridSize(1);
+    const CamArray<cv::Mat_<float>>& aDescs = oMaps.aShpDescs;
     const int nPatchSize = SEGMMATCH_DEFAULT_DESC_PATCH_SIZE;
     lvAssert_((nPatchSize%2)==1,"patch sizes must be odd");
     lv::StopWatch oLocalTimer;
-#if USING_OPENMP
-    //#pragma omp parallel for num_threads(getCameraCount())
-#endif //USING_OPENMP
-    for(size_t nCamIdx=0; nCamIdx<getCameraCount(); ++nCamIdx) {
-        const cv::Mat& oInputMask = aInputMasks[nCamIdx];
-        lvLog_(3,"\tcam[%d] shape descriptors...",(int)nCamIdx);
-        m_pShpDescExtractor->compute2(oInputMask,aDescs[nCamIdx]);
-        lvDbgAssert(aDescs[nCamIdx].dims==3 && aDescs[nCamIdx].size[0]==nRows && aDescs[nCamIdx].size[1]==nCols);
-    #if SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
-        const size_t nDescSize = size_t(aDescs[nCamIdx].size[2]);
-        for(size_t nDescIdx=0; nDescIdx<aDescs[nCamIdx].total(); nDescIdx+=nDescSize)
-            lv::rootSIFT(((float*)aDescs[nCamIdx].data)+nDescIdx,nDescSize);
-    #endif //SEGMMATCH_CONFIG_USE_ROOT_SIFT_DESCS
-        lvLog_(3,"\tcam[%d] shape distance fields...",(int)nCamIdx);
-        calcShapeDistFeatures(aInputMasks[nCamIdx],nCamIdx,vFeatures);
-    }
-    lvLog_(3,"Shape features maps computed in %f second(s).",oLocalTimer.tock());
     lvLog(3,"Calculating shape affinity map...");
-    const std::array<int,3> anAffinityMapDims = {nRows,nCols,(int)m_nRealStereoLabels};
-    vFeatures[FeatPack_ShpAffinity].create(3,anAffinityMapDims.data(),CV_32FC1);
+    const std::array<int,2> anAffinityMapDims = {(int)m_nValidStereoGraphNodes,(int)m_nRealStereoLabels};
+    vFeatures[FeatPack_ShpAffinity].create(2,anAffinityMapDims.data(),CV_32FC1);
     cv::Mat_<float> oAffinity = vFeatures[FeatPack_ShpAffinity];
+    const std::vector<int> vAffinityWindows(m_nValidStereoGraphNodes,0); // all windows cover the full disparity range
     std::vector<int> vDisparityOffsets;
     for(InternalLabelType nLabelIdx = 0; nLabelIdx<m_nRealStereoLabels; ++nLabelIdx)
         vDisparityOffsets.push_back(getOffsetValue(0,nLabelIdx));
 #if SEGMMATCH_CONFIG_USE_SHAPE_EMD_AFFIN
-    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,oAffinity,vDisparityOffsets,lv::AffinityDist_EMD,m_aROIs[0],m_aROIs[1],m_pShpDescExtractor->getEMDCostMap());
+    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,m_vStereoGraphNodeCoords,vAffinityWindows,(int)m_nRealStereoLabels,oAffinity,vDisparityOffsets,SEGMMATCH_CONFIG_USE_SHAPE_EMD_APPROX?lv::AffinityDist_EMDApprox:lv::AffinityDist_EMD,m_aROIs[0],m_aROIs[1],oExtractors.apShpDescExtractors[0]->getEMDCostMap());
 #else //!SEGMMATCH_CONFIG_USE_SHAPE_EMD_AFFIN
-    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,oAffinity,vDisparityOffsets,lv::AffinityDist_L2,m_aROIs[0],m_aROIs[1]);
+    lv::computeDescriptorAffinity(aDescs[0],aDescs[1],nPatchSize,m_vStereoGraphNodeCoords,vAffinityWindows,(int)m_nRealStereoLabels,oAffinity,vDisparityOffsets,lv::AffinityDist_L2,m_aROIs[0],m_aROIs[1]);
 #endif //!SEGMMATCH_CONFIG_USE_SHAPE_EMD_AFFIN
-    lvDbgAssert(lv::MatInfo(oAffinity)==lv::MatInfo(lv::MatSize(3,anAffinityMapDims.data()),CV_32FC1));
+    lvDbgAssert(lv::MatInfo(oAffinity)==lv::MatInfo(lv::MatSize(2,anAffinityMapDims.data()),CV_32FC1));
     lvDbgAssert(vFeatures[FeatPack_ShpAffinity].data==oAffinity.data);
     lvLog_(3,"Shape affinity map computed in %f second(s).",oLocalTimer.tock());
     lvLog(3,"Calculating shape saliency map...");
-    vFeatures[FeatPack_ShpSaliency].create(2,anAffinityMapDims.data(),CV_32FC1);
+    vFeatures[FeatPack_ShpSaliency].create(nRows,nCols,CV_32FC1);
     cv::Mat_<float> oSaliency = vFeatures[FeatPack_ShpSaliency];
     oSaliency = 0.0f; // default value for OOB pixels
     std::vector<float> vValidAffinityVals;
@@ -2485,7 +2821,7 @@ void SegmMatcher::GraphModelData::calcShapeFeatures(const CamArray<cv::Mat_<Inte
         const int nRowIdx = oNode.nRowIdx;
         const int nColIdx = oNode.nColIdx;
         vValidAffinityVals.resize(0);
-        const float* pAffinityPtr = oAffinity.ptr<float>(nRowIdx,nColIdx);
+        const float* pAffinityPtr = oAffinity.ptr<float>((int)nGraphNodeIdx);
         std::copy_if(pAffinityPtr,pAffinityPtr+m_nRealStereoLabels,std::back_inserter(vValidAffinityVals),[](float v){return v>=0.0f;});
         const float fCurrDistSparseness = vValidAffinityVals.size()>1?(float)lv::sparseness(vValidAffinityVals.data(),vValidAffinityVals.size()):0.0f;
         const float fCurrDescSparseness = (float)lv::sparseness(aDescs[m_nPrimaryCamIdx].ptr<float>(nRowIdx,nColIdx),size_t(aDescs[m_nPrimaryCamIdx].size[2]));
@@ -2518,7 +2854,7 @@ void SegmMatcher::GraphModelData::calcShapeFeatures(const CamArray<cv::Mat_<Inte
     }*/
 }
 
-void SegmMatcher::GraphModelData::calcShapeDistFeatures(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, std::vector<cv::Mat>& vFeatures) {
+void SegmMatcher::GraphModelData::calcShapeDistFeatures(const cv::Mat_<InternalLabelType>& oInputMask, size_t nCamIdx, std::vector<cv::Mat>& vFeatures) const {
     lvDbgExceptionWatch;
     lvDbgAssert_(nCamIdx<getCameraCount(),"bad input cam index");
     lvDbgAssert_(oInputMask.dims==2 && m_oGridSize==oInputMask.size(),"input had the wrong size");
@@ -2580,6 +2916,7 @@ double SegmMatcher::GraphModelData::getGMMBGProb(const cv::Mat& oInput, size_t n
 void SegmMatcher::GraphModelData::setNextFeatures(const cv::Mat& oPackedFeatures) {
     lvDbgExceptionWatch;
     lvAssert_(!oPackedFeatures.empty() && oPackedFeatures.isContinuous(),"features packet must be non-empty and continuous");
+    lvAssert_(!m_pAsyncFeatData || m_pAsyncFeatData->qpPackets.empty(),"cannot set precalculated features while queued inputs are pending");
     if(m_vExpectedFeatPackInfo.empty()) {
         m_vExpectedFeatPackInfo.resize(FeatPackSize);
         // hard-coded fill for matinfo types; if features change internally, this list may also need to be updated
@@ -2594,8 +2931,8 @@ void SegmMatcher::GraphModelData::setNextFeatures(const cv::Mat& oPackedFeatures
         }
         m_vExpectedFeatPackInfo[FeatPack_ImgSaliency] = lv::MatInfo(m_oGridSize,CV_32FC1);
         m_vExpectedFeatPackInfo[FeatPack_ShpSaliency] = lv::MatInfo(m_oGridSize,CV_32FC1);
-        m_vExpectedFeatPackInfo[FeatPack_ImgAffinity] = lv::MatInfo(std::array<int,3>{(int)m_oGridSize(0),(int)m_oGridSize(1),(int)m_nRealStereoLabels},CV_32FC1);
-        m_vExpectedFeatPackInfo[FeatPack_ShpAffinity] = lv::MatInfo(std::array<int,3>{(int)m_oGridSize(0),(int)m_oGridSize(1),(int)m_nRealStereoLabels},CV_32FC1);
+        m_vExpectedFeatPackInfo[FeatPack_ImgAffinity] = lv::MatInfo(std::array<int,2>{(int)m_nValidStereoGraphNodes,(int)m_nRealStereoLabels},CV_32FC1);
+        m_vExpectedFeatPackInfo[FeatPack_ShpAffinity] = lv::MatInfo(std::array<int,2>{(int)m_nValidStereoGraphNodes,(int)m_nRealStereoLabels},CV_32FC1);
     }
     const std::vector<cv::Mat> vLatestUnpackedFeatures = lv::unpackData(oPackedFeatures,m_vExpectedFeatPackInfo);
     m_vLoadedFeatures.resize(FeatPackSize);
@@ -2752,9 +3089,9 @@ inline SegmMatcher::ValueType SegmMatcher::GraphModelData::calcStereoUnaryMoveCo
         return cost_cast(0);
 }
 
-void SegmMatcher::GraphModelData::calcStereoMoveCosts(InternalLabelType nNewLabel) const {
+void SegmMatcher::GraphModelData::calcStereoMoveCosts(InternalLabelType nNewLabel, cv::Mat_<ValueType>& oUnaryCosts) const {
     lvDbgExceptionWatch;
-    lvDbgAssert(m_oGridSize.total()==m_vStereoNodeMap.size() && m_oGridSize.total()>1 && m_oGridSize==m_oStereoUnaryCosts.size);
+    lvDbgAssert(m_oGridSize.total()==m_vStereoNodeMap.size() && m_oGridSize.total()>1 && m_oGridSize==oUnaryCosts.size);
     const InternalLabelType* pCurrLabeling = ((InternalLabelType*)m_aaStereoLabelings[0][m_nPrimaryCamIdx].data);
     // #### openmp here?
     for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
@@ -2763,12 +3100,86 @@ void SegmMatcher::GraphModelData::calcStereoMoveCosts(InternalLabelType nNewLabe
         const InternalLabelType& nCurrLabel = pCurrLabeling[nLUTNodeIdx];
         lvIgnore(oNode); lvDbgAssert(oNode.bValidGraphNode);
         lvDbgAssert(&nCurrLabel==&m_aaStereoLabelings[0][m_nPrimaryCamIdx](oNode.nRowIdx,oNode.nColIdx));
-        ValueType& tUnaryCost = ((ValueType*)m_oStereoUnaryCosts.data)[nLUTNodeIdx];
-        lvDbgAssert(&tUnaryCost==&m_oStereoUnaryCosts(oNode.nRowIdx,oNode.nColIdx));
+        ValueType& tUnaryCost = ((ValueType*)oUnaryCosts.data)[nLUTNodeIdx];
+        lvDbgAssert(&tUnaryCost==&oUnaryCosts(oNode.nRowIdx,oNode.nColIdx));
         tUnaryCost = calcStereoUnaryMoveCost(nGraphNodeIdx,nCurrLabel,nNewLabel);
     }
 }
 
+#if SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+
+void SegmMatcher::GraphModelData::calcStereoMove(InternalLabelType nAlphaLabel, StereoMoveData& oMove) const {
+    lvDbgExceptionWatch;
+    // each move is a fusion move based on A. Fix's energy minimization method for higher-order MRFs
+    // see "A Graph Cut Algorithm for Higher-order Markov Random Fields" in ICCV2011 for more info (doi = 10.1109/ICCV.2011.6126347)
+    // (note: this approach is very generic, and not very well adapted to a dynamic MRF problem!)
+    // note: only reads the current labeling & association maps, so different moves can be solved concurrently with their own data
+    const InternalLabelType* pCurrLabeling = ((InternalLabelType*)m_aaStereoLabelings[0][m_nPrimaryCamIdx].data);
+    oMove.nAlphaLabel = nAlphaLabel;
+    calcStereoMoveCosts(nAlphaLabel,oMove.oUnaryCosts);
+    oMove.oReducer.Clear();
+    oMove.oReducer.AddVars((int)m_nValidStereoGraphNodes);
+    for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
+        const size_t nLUTNodeIdx = m_vStereoGraphIdxToMapIdxLUT[nGraphNodeIdx];
+        const StereoNodeInfo& oNode = m_vStereoNodeMap[nLUTNodeIdx];
+        if(oNode.nUnaryFactID!=SIZE_MAX) {
+            const ValueType& tUnaryCost = ((ValueType*)oMove.oUnaryCosts.data)[nLUTNodeIdx];
+            lvDbgAssert(&tUnaryCost==&oMove.oUnaryCosts(oNode.nRowIdx,oNode.nColIdx));
+            oMove.oReducer.AddUnaryTerm((int)nGraphNodeIdx,tUnaryCost);
+        }
+        for(size_t nOrientIdx=0; nOrientIdx<s_nPairwOrients; ++nOrientIdx)
+            lv::gm::factorReducer<ExplicitScaledFunction>(oNode.aPairwCliques[nOrientIdx],oMove.oReducer,nAlphaLabel,pCurrLabeling);
+    #if SEGMMATCH_CONFIG_USE_EPIPOLAR_CONN
+        lv::gm::factorReducer<ExplicitScaledFunction>(oNode.oEpipolarClique,oMove.oReducer,nAlphaLabel,pCurrLabeling);
+    #endif //SEGMMATCH_CONFIG_USE_EPIPOLAR_CONN
+    }
+    oMove.oMinimizer.Reset();
+    oMove.oReducer.ToQuadratic(oMove.oMinimizer);
+    oMove.oMinimizer.Solve();
+    oMove.oMinimizer.ComputeWeakPersistencies();
+    oMove.vMovedGraphNodeIdxs.clear();
+    for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
+        const int nMoveLabel = oMove.oMinimizer.GetLabel((int)nGraphNodeIdx);
+        lvDbgAssert(nMoveLabel==0 || nMoveLabel==1 || nMoveLabel<0);
+        if(nMoveLabel==1) // node label changed to alpha
+            oMove.vMovedGraphNodeIdxs.push_back(nGraphNodeIdx);
+    }
+}
+
+size_t SegmMatcher::GraphModelData::getStereoMoveThreadBudget() const {
+#if USING_OPENMP
+    // queued frames are computed by the frame worker with its own share of the cores (see AsyncFeatureData); while one is in flight,
+    // moves only use what is left, so that both sides together never exceed the caller's thread budget (once the queue is idle, all
+    // threads are available again); note: other (short) omp loops of the model updates still use full teams in the meantime
+    size_t nThreadBudget = size_t(omp_get_max_threads());
+    if(m_pAsyncFeatData && !m_pAsyncFeatData->qpPackets.empty() && m_pAsyncFeatData->qpPackets.back()->oResult.wait_for(std::chrono::seconds(0))!=std::future_status::ready)
+        nThreadBudget = (nThreadBudget>m_pAsyncFeatData->nThreadBudget)?(nThreadBudget-m_pAsyncFeatData->nThreadBudget):size_t(1);
+    return std::max(nThreadBudget,size_t(1));
+#else //!USING_OPENMP
+    return size_t(1);
+#endif //!USING_OPENMP
+}
+
+size_t SegmMatcher::GraphModelData::applyStereoMove(const StereoMoveData& oMove) const {
+    lvDbgExceptionWatch;
+    cv::Mat_<InternalLabelType>& oCurrStereoLabeling = m_aaStereoLabelings[0][m_nPrimaryCamIdx];
+    for(size_t nGraphNodeIdx : oMove.vMovedGraphNodeIdxs) {
+        lvDbgAssert(nGraphNodeIdx<m_nValidStereoGraphNodes);
+        const size_t nLUTNodeIdx = m_vStereoGraphIdxToMapIdxLUT[nGraphNodeIdx];
+        const int nRowIdx = m_vStereoNodeMap[nLUTNodeIdx].nRowIdx;
+        const int nColIdx = m_vStereoNodeMap[nLUTNodeIdx].nColIdx;
+        const InternalLabelType nOldLabel = oCurrStereoLabeling(nRowIdx,nColIdx);
+        if(nOldLabel<m_nDontCareLabelIdx)
+            removeAssoc(nRowIdx,nColIdx,nOldLabel);
+        oCurrStereoLabeling(nRowIdx,nColIdx) = oMove.nAlphaLabel;
+        if(oMove.nAlphaLabel<m_nDontCareLabelIdx)
+            addAssoc(nRowIdx,nColIdx,oMove.nAlphaLabel);
+    }
+    return oMove.vMovedGraphNodeIdxs.size();
+}
+
+#endif //SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
+
 void SegmMatcher::GraphModelData::calcResegmMoveCosts(InternalLabelType nNewLabel) const {
     lvDbgExceptionWatch;
     lvDbgAssert(m_oResegmUnaryCosts.rows==int(m_oGridSize[0]*getTemporalLayerCount()*getCameraCount()) && m_oResegmUnaryCosts.cols==int(m_oGridSize[1]));
@@ -3131,9 +3542,17 @@ opengm::InferenceTermination SegmMatcher::GraphModelData::infer() {
     // see if maxflow used in fastpd can be replaced by https://github.com/gerddie/maxflow?
 #elif SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
     constexpr int nMaxStereoEdgesPerNode = (s_nPairwOrients+s_nEpipolarCliqueEdges);
-    kolmogorov::qpbo::QPBO<ValueType> oStereoMinimizer((int)m_nValidStereoGraphNodes,(int)m_nValidStereoGraphNodes*nMaxStereoEdgesPerNode);
-    HOEReducer oStereoReducer;
-    size_t nStereoLabelOrderingIdx = 0;
+#if USING_OPENMP
+    const size_t nMaxStereoMoveBatchSize = m_nStereoMoveThreads;
+#else //!USING_OPENMP
+    const size_t nMaxStereoMoveBatchSize = size_t(1); // speculative moves would only waste time if solved sequentially
+#endif //!USING_OPENMP
+    m_vpStereoMoves.resize(nMaxStereoMoveBatchSize); // graph size is fixed for the model lifetime, so instances from previous frames are reused as-is
+    for(std::unique_ptr<StereoMoveData>& pStereoMove : m_vpStereoMoves)
+        if(!pStereoMove)
+            pStereoMove = std::make_unique<StereoMoveData>(m_nValidStereoGraphNodes,nMaxStereoEdgesPerNode,m_oGridSize);
+    size_t nStereoLabelOrderingIdx=0, nStereoMoveBatchSize=0, nStereoMoveBatchIdx=0, nStereoMoveSpecWidth=1;
+    lvIgnore(oCurrStereoLabeling); // moves read & update it through calcStereoMove/applyStereoMove
 #elif SEGMMATCH_CONFIG_USE_SOSPD_STEREO_INF
     static_assert(std::is_integral<SegmMatcher::ValueType>::value,"sospd height weight redistr requires integer type");
     constexpr bool bUseHeightAlphaExp = SEGMMATCH_CONFIG_USE_SOSPD_ALPHA_HEIGHTS_LABEL_ORDERING;
@@ -3200,60 +3619,45 @@ opengm::InferenceTermination SegmMatcher::GraphModelData::infer() {
         nConsecUnchangedStereoLabels = (nChangedStereoLabels>0)?0:nConsecUnchangedStereoLabels+m_nRealStereoLabels;
         const bool bResegmNext = true;
     #elif SEGMMATCH_CONFIG_USE_FGBZ_STEREO_INF
-        // each iter below is a fusion move based on A. Fix's energy minimization method for higher-order MRFs
-        // see "A Graph Cut Algorithm for Higher-order Markov Random Fields" in ICCV2011 for more info (doi = 10.1109/ICCV.2011.6126347)
-        // (note: this approach is very generic, and not very well adapted to a dynamic MRF problem!)
-        const InternalLabelType nStereoAlphaLabel = m_vStereoLabelOrdering[nStereoLabelOrderingIdx];
-        calcStereoMoveCosts(nStereoAlphaLabel);
-        oStereoReducer.Clear();
-        oStereoReducer.AddVars((int)m_nValidStereoGraphNodes);
+        // moves are solved in speculative batches: the next few labels of the ordering are all solved concurrently against the current
+        // labeling, and their results are then applied in order; once a move changes the labeling (or once resegm updates the model), the
+        // remaining results are stale and dropped, so the sequence of labelings (and energies) is exactly the same as with sequential moves
+        // (batches grow while moves leave the labeling untouched, which is the case for most moves near convergence)
+        if(nStereoMoveBatchIdx>=nStereoMoveBatchSize) {
+            const size_t nStereoMovesPerResegm = SEGMMATCH_DEFAULT_ITER_PER_RESEGM;
+            const size_t nStereoMovesToResegm = (nStereoMoveIter%nStereoMovesPerResegm)?(nStereoMovesPerResegm-nStereoMoveIter%nStereoMovesPerResegm+1):size_t(1);
+            nStereoMoveBatchSize = std::min({nStereoMoveSpecWidth,getStereoMoveThreadBudget(),nStereoMovesToResegm,m_nMaxStereoMoveCount-nStereoMoveIter,m_nStereoLabels-nConsecUnchangedStereoLabels});
+            nStereoMoveBatchIdx = 0;
+            lvDbgAssert(nStereoMoveBatchSize>0u && nStereoMoveBatchSize<=m_vpStereoMoves.size());
+        #if USING_OPENMP
+            #pragma omp parallel for schedule(static,1) num_threads(int(nStereoMoveBatchSize)) if(nStereoMoveBatchSize>1)
+        #endif //USING_OPENMP
+            for(size_t nMoveIdx=0; nMoveIdx<nStereoMoveBatchSize; ++nMoveIdx)
+                calcStereoMove(m_vStereoLabelOrdering[(nStereoLabelOrderingIdx+nMoveIdx)%m_vStereoLabelOrdering.size()],*m_vpStereoMoves[nMoveIdx]);
+        }
+        const StereoMoveData& oStereoMove = *m_vpStereoMoves[nStereoMoveBatchIdx++];
+        const InternalLabelType nStereoAlphaLabel = oStereoMove.nAlphaLabel;
+        lvDbgAssert(nStereoAlphaLabel==m_vStereoLabelOrdering[nStereoLabelOrderingIdx]);
         if(lv::getVerbosity()>=5) {
             cv::Mat oStereoUnaryCostsDisplay;
-            cv::normalize(m_oStereoUnaryCosts,oStereoUnaryCostsDisplay,255,0,cv::NORM_MINMAX,CV_8U,m_aROIs[m_nPrimaryCamIdx]);
+            cv::normalize(oStereoMove.oUnaryCosts,oStereoUnaryCostsDisplay,255,0,cv::NORM_MINMAX,CV_8U,m_aROIs[m_nPrimaryCamIdx]);
             cv::imshow("oStereoUnaryCostsDisplay",oStereoUnaryCostsDisplay);
             cv::waitKey(1);
         }
-        for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
-            const size_t nLUTNodeIdx = m_vStereoGraphIdxToMapIdxLUT[nGraphNodeIdx];
-            const StereoNodeInfo& oNode = m_vStereoNodeMap[nLUTNodeIdx];
-            if(oNode.nUnaryFactID!=SIZE_MAX) {
-                const ValueType& tUnaryCost = ((ValueType*)m_oStereoUnaryCosts.data)[nLUTNodeIdx];
-                lvDbgAssert(&tUnaryCost==&m_oStereoUnaryCosts(oNode.nRowIdx,oNode.nColIdx));
-                oStereoReducer.AddUnaryTerm((int)nGraphNodeIdx,tUnaryCost);
-            }
-            for(size_t nOrientIdx=0; nOrientIdx<s_nPairwOrients; ++nOrientIdx)
-                lv::gm::factorReducer<ExplicitScaledFunction>(oNode.aPairwCliques[nOrientIdx],oStereoReducer,nStereoAlphaLabel,(InternalLabelType*)oCurrStereoLabeling.data);
-        #if SEGMMATCH_CONFIG_USE_EPIPOLAR_CONN
-            lv::gm::factorReducer<ExplicitScaledFunction>(oNode.oEpipolarClique,oStereoReducer,nStereoAlphaLabel,(InternalLabelType*)oCurrStereoLabeling.data);
-        #endif //SEGMMATCH_CONFIG_USE_EPIPOLAR_CONN
-        }
-        oStereoMinimizer.Reset();
-        oStereoReducer.ToQuadratic(oStereoMinimizer);
-        oStereoMinimizer.Solve();
-        oStereoMinimizer.ComputeWeakPersistencies();
-        size_t nChangedStereoLabels = 0;
-        for(size_t nGraphNodeIdx=0; nGraphNodeIdx<m_nValidStereoGraphNodes; ++nGraphNodeIdx) {
-            const size_t nLUTNodeIdx = m_vStereoGraphIdxToMapIdxLUT[nGraphNodeIdx];
-            const int nRowIdx = m_vStereoNodeMap[nLUTNodeIdx].nRowIdx;
-            const int nColIdx = m_vStereoNodeMap[nLUTNodeIdx].nColIdx;
-            const int nMoveLabel = oStereoMinimizer.GetLabel((int)nGraphNodeIdx);
-            lvDbgAssert(nMoveLabel==0 || nMoveLabel==1 || nMoveLabel<0);
-            if(nMoveLabel==1) { // node label changed to alpha
-                const InternalLabelType nOldLabel = oCurrStereoLabeling(nRowIdx,nColIdx);
-                if(nOldLabel<m_nDontCareLabelIdx)
-                    removeAssoc(nRowIdx,nColIdx,nOldLabel);
-                oCurrStereoLabeling(nRowIdx,nColIdx) = nStereoAlphaLabel;
-                if(nStereoAlphaLabel<m_nDontCareLabelIdx)
-                    addAssoc(nRowIdx,nColIdx,nStereoAlphaLabel);
-                ++nChangedStereoLabels;
-            }
-        }
+        const size_t nChangedStereoLabels = applyStereoMove(oStereoMove);
         ++nStereoLabelOrderingIdx %= m_vStereoLabelOrdering.size();
         nConsecUnchangedStereoLabels = (nChangedStereoLabels>0)?0:nConsecUnchangedStereoLabels+1;
         const bool bResegmNext = (nStereoMoveIter++%SEGMMATCH_DEFAULT_ITER_PER_RESEGM)==0;
+        if(nChangedStereoLabels>0) {
+            nStereoMoveBatchSize = 0; // remaining speculative moves are stale, drop them
+            nStereoMoveSpecWidth = 1;
+        }
+        else if(nStereoMoveBatchIdx>=nStereoMoveBatchSize)
+            nStereoMoveSpecWidth = std::min(nStereoMoveSpecWidth*2,nMaxStereoMoveBatchSize);
+        lvDbgAssert(!bResegmNext || nStereoMoveBatchIdx>=nStereoMoveBatchSize); // batches never span resegm passes (model might change)
     #elif SEGMMATCH_CONFIG_USE_SOSPD_STEREO_INF
         const InternalLabelType nStereoAlphaLabel = m_vStereoLabelOrdering[nStereoLabelOrderingIdx];
-        calcStereoMoveCosts(nStereoAlphaLabel);
+        calcStereoMoveCosts(nStereoAlphaLabel,m_oStereoUnaryCosts);
         const bool bStereoMoveCanFlipLabels = std::any_of(StereoGraphNodeIter(this,0),StereoGraphNodeIter(this,m_nValidStereoGraphNodes),[&](const StereoNodeInfo& oNode) {
             return (((InternalLabelType*)oCurrStereoLabeling.data)[oNode.nMapIdx])!=nStereoAlphaLabel;
         });
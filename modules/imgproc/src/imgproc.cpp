@@ -358,6 +358,188 @@ void lv::binaryConsensus(const cv::Mat& oInput, cv::Mat& oOutput, const cv::Mat_
     }
 }
 
+namespace {
+
+    /// number of rows per work item in box-filtered affinity computations (each item primes its own running column sums)
+    constexpr int s_nAffinityBandRows = 32;
+
+    /// adds (or removes) the valid raw affinities of an array to running sums & counts; invalid (e.g. OOB) pairs hold the -1 sentinel value,
+    /// and are skipped via an exact comparison with it (i.e. other negative values would still be accumulated)
+    template<bool bAdd>
+    inline void accumValidAffinities(const float* afRawAffinities, double* adSums, int* anCounts, int nElems) {
+    #if USING_OPENMP
+        #pragma omp simd
+    #endif //USING_OPENMP
+        for(int nElemIdx=0; nElemIdx<nElems; ++nElemIdx) {
+            const bool bValid = afRawAffinities[nElemIdx]!=-1.0f;
+            const double dValue = bValid?double(afRawAffinities[nElemIdx]):0.0;
+            adSums[nElemIdx] += bAdd?dValue:-dValue;
+            anCounts[nElemIdx] += bAdd?int(bValid):-int(bValid);
+        }
+    }
+
+    /// adds (or removes) an array of partial sums & counts to running sums & counts
+    template<bool bAdd>
+    inline void accumPartialAffinities(const double* adPartialSums, const int* anPartialCounts, double* adSums, int* anCounts, int nElems) {
+    #if USING_OPENMP
+        #pragma omp simd
+    #endif //USING_OPENMP
+        for(int nElemIdx=0; nElemIdx<nElems; ++nElemIdx) {
+            adSums[nElemIdx] += bAdd?adPartialSums[nElemIdx]:-adPartialSums[nElemIdx];
+            anCounts[nElemIdx] += bAdd?anPartialCounts[nElemIdx]:-anPartialCounts[nElemIdx];
+        }
+    }
+
+    /// averages the valid raw affinities (i.e. not equal to the -1 sentinel) of each (nPatchSize)x(nPatchSize) patch into the final affinity
+    /// map; patches are box-filtered via separable running sums (vertical sums are kept per column/offset, then slid horizontally), so the
+    /// cost per output element does not depend on the patch size
+    void aggregateAffinityPatches(const cv::Mat_<float>& oRawAffinity, int nPatchSize, cv::Mat_<float>& oAffinityMap) {
+        lvDbgAssert(oRawAffinity.dims==3 && oAffinityMap.dims==3 && oRawAffinity.size==oAffinityMap.size);
+        lvDbgAssert(oRawAffinity.isContinuous() && oAffinityMap.isContinuous());
+        const int nRows = oRawAffinity.size[0];
+        const int nCols = oRawAffinity.size[1];
+        const int nOffsets = oRawAffinity.size[2];
+        const int nPatchRadius = nPatchSize/2;
+        const int nRowElems = nCols*nOffsets;
+        const int nBands = (nRows+s_nAffinityBandRows-1)/s_nAffinityBandRows;
+    #if USING_OPENMP
+        #pragma omp parallel for schedule(dynamic)
+    #endif //USING_OPENMP
+        for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+            const int nBandRowBegin = nBandIdx*s_nAffinityBandRows;
+            const int nBandRowEnd = std::min(nBandRowBegin+s_nAffinityBandRows,nRows);
+            static thread_local lv::AutoBuffer<double> s_adColSums,s_adPatchSums;
+            static thread_local lv::AutoBuffer<int> s_anColCounts,s_anPatchCounts;
+            s_adColSums.resize(size_t(nRowElems));
+            s_anColCounts.resize(size_t(nRowElems));
+            s_adPatchSums.resize(size_t(nOffsets));
+            s_anPatchCounts.resize(size_t(nOffsets));
+            double* const adColSums = s_adColSums.data();
+            int* const anColCounts = s_anColCounts.data();
+            double* const adPatchSums = s_adPatchSums.data();
+            int* const anPatchCounts = s_anPatchCounts.data();
+            std::fill_n(adColSums,nRowElems,0.0);
+            std::fill_n(anColCounts,nRowElems,0);
+            for(int nPatchRowIdx=std::max(nBandRowBegin-nPatchRadius,0); nPatchRowIdx<std::min(nBandRowBegin+nPatchRadius,nRows); ++nPatchRowIdx)
+                accumValidAffinities<true>(oRawAffinity.ptr<float>(nPatchRowIdx),adColSums,anColCounts,nRowElems);
+            for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+                if(nRowIdx+nPatchRadius<nRows)
+                    accumValidAffinities<true>(oRawAffinity.ptr<float>(nRowIdx+nPatchRadius),adColSums,anColCounts,nRowElems);
+                if(nRowIdx>nBandRowBegin && nRowIdx-nPatchRadius-1>=0)
+                    accumValidAffinities<false>(oRawAffinity.ptr<float>(nRowIdx-nPatchRadius-1),adColSums,anColCounts,nRowElems);
+                std::fill_n(adPatchSums,nOffsets,0.0);
+                std::fill_n(anPatchCounts,nOffsets,0);
+                for(int nPatchColIdx=0; nPatchColIdx<std::min(nPatchRadius,nCols); ++nPatchColIdx)
+                    accumPartialAffinities<true>(adColSums+nPatchColIdx*nOffsets,anColCounts+nPatchColIdx*nOffsets,adPatchSums,anPatchCounts,nOffsets);
+                float* const afAffinityRow = oAffinityMap.ptr<float>(nRowIdx);
+                for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+                    if(nColIdx+nPatchRadius<nCols)
+                        accumPartialAffinities<true>(adColSums+(nColIdx+nPatchRadius)*nOffsets,anColCounts+(nColIdx+nPatchRadius)*nOffsets,adPatchSums,anPatchCounts,nOffsets);
+                    if(nColIdx-nPatchRadius-1>=0)
+                        accumPartialAffinities<false>(adColSums+(nColIdx-nPatchRadius-1)*nOffsets,anColCounts+(nColIdx-nPatchRadius-1)*nOffsets,adPatchSums,anPatchCounts,nOffsets);
+                    float* const afAffinity = afAffinityRow+nColIdx*nOffsets;
+                    for(int nOffsetIdx=0; nOffsetIdx<nOffsets; ++nOffsetIdx)
+                        if(anPatchCounts[nOffsetIdx]>0)
+                            afAffinity[nOffsetIdx] = float(adPatchSums[nOffsetIdx]/anPatchCounts[nOffsetIdx]);
+                }
+            }
+        }
+    }
+
+    /// returns the L2 distance between two float descriptors (accumulated in double precision, vectorized over the descriptor bins)
+    inline double calcDescDistance_L2(const float* afDesc1, const float* afDesc2, int nDescSize) {
+        double dSqrDist = 0.0;
+    #if USING_OPENMP
+        #pragma omp simd reduction(+:dSqrDist)
+    #endif //USING_OPENMP
+        for(int nBinIdx=0; nBinIdx<nDescSize; ++nBinIdx) {
+            const double dDiff = double(afDesc1[nBinIdx])-double(afDesc2[nBinIdx]);
+            dSqrDist += dDiff*dDiff;
+        }
+        return std::sqrt(dSqrDist);
+    }
+
+    /// returns an approximate EMD solver for the given ground cost map; the last solver built by the calling thread is kept along
+    /// with a copy of its cost map, and reused as long as the map contents do not change (avoids repeating the kernel precomputation)
+    const SinkhornEMD& getApproxEMDSolver(const cv::Mat_<float>& oEMDCostMap) {
+        static thread_local cv::Mat_<float> s_oCachedCostMap;
+        static thread_local std::unique_ptr<SinkhornEMD> s_pCachedSolver;
+        if(!s_pCachedSolver || !lv::isEqual<float>(s_oCachedCostMap,oEMDCostMap)) {
+            s_pCachedSolver = std::make_unique<SinkhornEMD>(oEMDCostMap);
+            oEMDCostMap.copyTo(s_oCachedCostMap);
+        }
+        return *s_pCachedSolver;
+    }
+
+    /// computes the raw (pixel-wise) descriptor affinities of a map pixel for the disparity offsets in [nOffsetBegin,nOffsetEnd); values are
+    /// written starting at the first output array element, and entries of OOB offsets are left untouched
+    void calcRawDescAffinities(const cv::Mat_<float>& oDescMap1, const cv::Mat_<float>& oDescMap2, int nRowIdx, int nColIdx,
+                               int nOffsetBegin, int nOffsetEnd, const std::vector<int>& vDispRange, lv::AffinityDistType eDist,
+                               const cv::Mat_<uchar>& oROI2, const cv::Mat_<float>& oEMDCostMap, const SinkhornEMD* pApproxEMD,
+                               float* pRawAffinityPtr) {
+        lvDbgAssert(nOffsetBegin>=0 && nOffsetBegin<=nOffsetEnd && nOffsetEnd<=int(vDispRange.size()) && pRawAffinityPtr);
+        const int nCols = oDescMap1.size[1];
+        const int nDescSize = oDescMap1.size[2];
+        const bool bValidROI2 = !oROI2.empty();
+        if(eDist==lv::AffinityDist_EMDApprox) {
+            lvDbgAssert(pApproxEMD);
+            // all valid offsets of a pixel are solved as one batch (the solver interleaves pairs internally)
+            static thread_local lv::AutoBuffer<const float*> s_apDescs,s_apOffsetDescs;
+            static thread_local lv::AutoBuffer<int> s_anOffsetIdxs;
+            static thread_local lv::AutoBuffer<double> s_adOffsetDists;
+            const size_t nMaxOffsets = size_t(nOffsetEnd-nOffsetBegin);
+            s_apDescs.resize(nMaxOffsets);
+            s_apOffsetDescs.resize(nMaxOffsets);
+            s_anOffsetIdxs.resize(nMaxOffsets);
+            s_adOffsetDists.resize(nMaxOffsets);
+            size_t nValidOffsets = 0;
+            for(int nOffsetIdx=nOffsetBegin; nOffsetIdx<nOffsetEnd; ++nOffsetIdx) {
+                const int nOffsetColIdx = nColIdx+vDispRange[nOffsetIdx];
+                if(nOffsetColIdx<0 || nOffsetColIdx>=nCols || (bValidROI2 && !oROI2(nRowIdx,nOffsetColIdx)))
+                    continue;
+                s_apOffsetDescs[nValidOffsets] = oDescMap2.ptr<float>(nRowIdx,nOffsetColIdx);
+                s_anOffsetIdxs[nValidOffsets++] = nOffsetIdx-nOffsetBegin;
+            }
+            if(nValidOffsets==0)
+                return;
+            std::fill_n(s_apDescs.data(),nValidOffsets,oDescMap1.ptr<float>(nRowIdx,nColIdx));
+            pApproxEMD->compute(s_apDescs.data(),s_apOffsetDescs.data(),nValidOffsets,s_adOffsetDists.data());
+            for(size_t nValidOffsetIdx=0; nValidOffsetIdx<nValidOffsets; ++nValidOffsetIdx) {
+                pRawAffinityPtr[s_anOffsetIdxs[nValidOffsetIdx]] = (float)s_adOffsetDists[nValidOffsetIdx];
+                lvDbgAssert(pRawAffinityPtr[s_anOffsetIdxs[nValidOffsetIdx]]>=0.0f);
+            }
+            return;
+        }
+        for(int nOffsetIdx=nOffsetBegin; nOffsetIdx<nOffsetEnd; ++nOffsetIdx) {
+            const int nOffsetColIdx = nColIdx+vDispRange[nOffsetIdx];
+            if(nOffsetColIdx<0 || nOffsetColIdx>=nCols || (bValidROI2 && !oROI2(nRowIdx,nOffsetColIdx)))
+                continue;
+            float& fRawAffinity = pRawAffinityPtr[nOffsetIdx-nOffsetBegin];
+            if(eDist==lv::AffinityDist_L2) {
+                fRawAffinity = float(calcDescDistance_L2(oDescMap1.ptr<float>(nRowIdx,nColIdx),oDescMap2.ptr<float>(nRowIdx,nOffsetColIdx),nDescSize));
+                lvDbgAssert(fRawAffinity>=0.0f && fRawAffinity<=(float)M_SQRT2);
+            }
+            else /*if(eDist==lv::AffinityDist_EMD)*/ {
+                const float* pDesc = oDescMap1.ptr<float>(nRowIdx,nColIdx);
+                const float* pOffsetDesc = oDescMap2.ptr<float>(nRowIdx,nOffsetColIdx);
+                const cv::Mat_<float> oDesc(nDescSize,1,const_cast<float*>(pDesc));
+                const cv::Mat_<float> oOffsetDesc(nDescSize,1,const_cast<float*>(pOffsetDesc));
+                lvDbgAssert_(!std::all_of(pDesc,pDesc+nDescSize,[](float v){
+                    lvDbgAssert(v>=0.0f);
+                    return v==0.0f;
+                }),"opencv emd cannot handle null descriptors");
+                lvDbgAssert_(!std::all_of(pOffsetDesc,pOffsetDesc+nDescSize,[](float v){
+                    lvDbgAssert(v>=0.0f);
+                    return v==0.0f;
+                }),"opencv emd cannot handle null descriptors");
+                fRawAffinity = cv::EMD(oDesc,oOffsetDesc,-1,oEMDCostMap);
+                lvDbgAssert(fRawAffinity>=0.0f);
+            }
+        }
+    }
+
+} // anonymous namespace
+
 void lv::computeImageAffinity(const cv::Mat& oImage1, const cv::Mat& oImage2, int nPatchSize,
                               cv::Mat_<float>& oAffinityMap, const std::vector<int>& vDispRange, AffinityDistType eDist,
                               const cv::Mat_<uchar>& oROI1, const cv::Mat_<uchar>& oROI2) {
@@ -385,31 +567,81 @@ void lv::computeImageAffinity(const cv::Mat& oImage1, const cv::Mat& oImage2, in
     const std::array<int,3> anAffinityMapDims = {nRows-nPatchRadius*2,nCols-nPatchRadius*2,nOffsets};
     oAffinityMap.create(3,anAffinityMapDims.data());
     oAffinityMap = -1.0f; // default value for OOB pixels
-    thread_local lv::JointSparseHistData<uchar,uchar> oSparseHistData;
+    if(eDist==lv::AffinityDist_MI) {
+        // mutual info scores are computed densely (w/ sliding histograms) over the overlapping image strips of each offset
+        MutualInfo oMutualInfo(cv::Size(nPatchSize,nPatchSize),true);
+        cv::Mat_<double> oScoreMap;
+        for(int nOffsetIdx=0; nOffsetIdx<nOffsets; ++nOffsetIdx) {
+            const int nColOffset = vDispRange[nOffsetIdx];
+            const int nOverlapCols = nCols-std::abs(nColOffset);
+            if(nOverlapCols<nPatchSize)
+                continue;
+            const int nOverlapColIdx1 = std::max(-nColOffset,0);
+            oMutualInfo.compute2(oImage1_uchar(cv::Rect(nOverlapColIdx1,0,nOverlapCols,nRows)),oImage2_uchar(cv::Rect(nOverlapColIdx1+nColOffset,0,nOverlapCols,nRows)),oScoreMap);
+        #if USING_OPENMP
+            #pragma omp parallel for
+        #endif //USING_OPENMP
+            for(int nRowIdx=nPatchRadius; nRowIdx<nRows-nPatchRadius; ++nRowIdx) {
+                for(int nOverlapColIdx=nPatchRadius; nOverlapColIdx<nOverlapCols-nPatchRadius; ++nOverlapColIdx) {
+                    const int nColIdx = nOverlapColIdx+nOverlapColIdx1;
+                    if((bValidROI1 && !oROI1(nRowIdx,nColIdx)) || (bValidROI2 && !oROI2(nRowIdx,nColIdx+nColOffset)))
+                        continue;
+                    oAffinityMap.at<float>(nRowIdx-nPatchRadius,nColIdx-nPatchRadius,nOffsetIdx) = std::max(float(1.0-oScoreMap(nRowIdx,nOverlapColIdx)),0.0f);
+                }
+            }
+        }
+        return;
+    }
+    // window SSDs are box-filtered via separable running sums over squared differences (vertical sums are kept per column, then slid
+    // horizontally), so the cost per output element does not depend on the patch size; work is split in (offset,row band) items
+    cv::Mat_<double> oImage1_double,oImage2_double;
+    oImage1.convertTo(oImage1_double,CV_64F);
+    oImage2.convertTo(oImage2_double,CV_64F);
+    const int nValidRows = nRows-nPatchRadius*2;
+    const int nBands = (nValidRows+s_nAffinityBandRows-1)/s_nAffinityBandRows;
 #if USING_OPENMP
-#ifdef _MSC_VER
-    #pragma omp parallel for // msvc only supports openmp 2.0
-#else //ndef(_MSC_VER)
-    #pragma omp parallel for collapse(3)
-#endif //ndef(_MSC_VER)
+    #pragma omp parallel for schedule(dynamic)
 #endif //USING_OPENMP
-    for(int nRowIdx=nPatchRadius; nRowIdx<nRows-nPatchRadius; ++nRowIdx) {
-        for(int nColIdx=nPatchRadius; nColIdx<nCols-nPatchRadius; ++nColIdx) {
-            for(int nOffsetIdx=0; nOffsetIdx<nOffsets; ++nOffsetIdx) {
-                const int nColOffset = vDispRange[nOffsetIdx];
-                const int nOffsetColIdx = nColIdx+nColOffset;
-                if((bValidROI1 && !oROI1(nRowIdx,nColIdx)) || nOffsetColIdx<nPatchRadius || nOffsetColIdx>=nCols-nPatchRadius || (bValidROI2 && !oROI2(nRowIdx,nOffsetColIdx)))
-                    continue;
-                const cv::Rect oWindow(nColIdx-nPatchRadius,nRowIdx-nPatchRadius,nPatchSize,nPatchSize);
-                const cv::Rect oOffsetWindow(nOffsetColIdx-nPatchRadius,nRowIdx-nPatchRadius,nPatchSize,nPatchSize);
-                if(eDist==lv::AffinityDist_MI) {
-                    const double dMutualInfoScore = lv::calcMutualInfo<1,true,true,false,false>(oImage1_uchar(oWindow),oImage2_uchar(oOffsetWindow),&oSparseHistData);
-                    oAffinityMap.at<float>(nRowIdx-nPatchRadius,nColIdx-nPatchRadius,nOffsetIdx) = std::max(float(1.0-dMutualInfoScore),0.0f);
-                }
-                else /*if(eDist==lv::AffinityDist_SSD)*/ {
-                    oAffinityMap.at<float>(nRowIdx-nPatchRadius,nColIdx-nPatchRadius,nOffsetIdx) = (float)cv::norm(oImage1(oWindow),oImage2(oOffsetWindow),cv::NORM_L2);
-                }
+    for(int nItemIdx=0; nItemIdx<nOffsets*nBands; ++nItemIdx) {
+        const int nOffsetIdx = nItemIdx/nBands;
+        const int nBandIdx = nItemIdx%nBands;
+        const int nColOffset = vDispRange[nOffsetIdx];
+        // valid window centers must keep both windows inside their image
+        const int nColBegin = std::max(nPatchRadius,nPatchRadius-nColOffset);
+        const int nColEnd = std::min(nCols-nPatchRadius,nCols-nPatchRadius-nColOffset);
+        if(nColBegin>=nColEnd)
+            continue;
+        const int nBandRowBegin = nPatchRadius+nBandIdx*s_nAffinityBandRows;
+        const int nBandRowEnd = std::min(nBandRowBegin+s_nAffinityBandRows,nRows-nPatchRadius);
+        const int nWinColBegin = nColBegin-nPatchRadius;
+        const int nWinCols = nColEnd-nColBegin+nPatchRadius*2;
+        static thread_local lv::AutoBuffer<double> s_adColSSDs;
+        s_adColSSDs.resize(size_t(nWinCols));
+        double* const adColSSDs = s_adColSSDs.data();
+        std::fill_n(adColSSDs,nWinCols,0.0);
+        const auto lAccumRowSSDs = [&](int nRowIdx, double dSign) {
+            const double* const adRow1 = oImage1_double.ptr<double>(nRowIdx)+nWinColBegin;
+            const double* const adRow2 = oImage2_double.ptr<double>(nRowIdx)+nWinColBegin+nColOffset;
+        #if USING_OPENMP
+            #pragma omp simd
+        #endif //USING_OPENMP
+            for(int nWinColIdx=0; nWinColIdx<nWinCols; ++nWinColIdx) {
+                const double dDiff = adRow1[nWinColIdx]-adRow2[nWinColIdx];
+                adColSSDs[nWinColIdx] += dSign*dDiff*dDiff;
             }
+        };
+        for(int nRowIdx=nBandRowBegin-nPatchRadius; nRowIdx<nBandRowBegin+nPatchRadius; ++nRowIdx)
+            lAccumRowSSDs(nRowIdx,1.0);
+        for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+            lAccumRowSSDs(nRowIdx+nPatchRadius,1.0);
+            double dWinSSD = std::accumulate(adColSSDs,adColSSDs+nPatchSize-1,0.0);
+            for(int nColIdx=nColBegin; nColIdx<nColEnd; ++nColIdx) {
+                dWinSSD += adColSSDs[nColIdx-nWinColBegin+nPatchRadius];
+                if((!bValidROI1 || oROI1(nRowIdx,nColIdx)) && (!bValidROI2 || oROI2(nRowIdx,nColIdx+nColOffset)))
+                    oAffinityMap.at<float>(nRowIdx-nPatchRadius,nColIdx-nPatchRadius,nOffsetIdx) = (float)std::sqrt(std::max(dWinSSD,0.0));
+                dWinSSD -= adColSSDs[nColIdx-nWinColBegin-nPatchRadius];
+            }
+            lAccumRowSSDs(nRowIdx-nPatchRadius,-1.0);
         }
     }
 }
@@ -422,10 +654,10 @@ void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::M
     lvAssert_(!oDescMap1.empty() && oDescMap1.size==oDescMap2.size && oDescMap1.dims==3 && oDescMap1.size[2]>1,"bad input desc map sizes");
     lvAssert_(oROI1.empty() || (oROI1.dims==2 && oROI1.rows==oDescMap1.size[0] && oROI1.cols==oDescMap1.size[1]),"bad ROI1 map size");
     lvAssert_(oROI2.empty() || (oROI2.dims==2 && oROI2.rows==oDescMap2.size[0] && oROI2.cols==oDescMap2.size[1]),"bad ROI2 map size");
-    lvAssert_(eDist==lv::AffinityDist_L2 || eDist==lv::AffinityDist_EMD,"unsupported distance type");
+    lvAssert_(eDist==lv::AffinityDist_L2 || eDist==lv::AffinityDist_EMD || eDist==lv::AffinityDist_EMDApprox,"unsupported distance type");
     lvAssert_(nPatchSize>=1 && (nPatchSize%2)==1,"bad patch size");
     lvAssert_(!vDispRange.empty(),"bad disparity range");
-    if(eDist==lv::AffinityDist_EMD) {
+    if(eDist==lv::AffinityDist_EMD || eDist==lv::AffinityDist_EMDApprox) {
         lvAssert_(!oEMDCostMap.empty() && oEMDCostMap.dims==2 && oEMDCostMap.rows==oEMDCostMap.cols,"bad emd cost map size");
         lvAssert_(oEMDCostMap.rows==oDescMap1.size[2],"bad emd cost map size for given desc size");
     }
@@ -434,7 +666,7 @@ void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::M
     const int nDescSize = oDescMap1.size[2];
     const int nOffsets = int(vDispRange.size());
     const std::array<int,3> anAffinityMapDims = {nRows,nCols,nOffsets};
-    lvIgnore(bAllowCUDA);
+    lvIgnore(bAllowCUDA); lvIgnore(nDescSize);
 #if HAVE_CUDA
     static thread_local cv::cuda::GpuMat s_oDescMap1_dev,s_oDescMap2_dev,s_oAffinityMap_dev,s_oROI1_dev,s_oROI2_dev;
     if(bAllowCUDA && eDist==lv::AffinityDist_L2 && oROI1.empty()==oROI2.empty() && (nRows*nCols>64 || nOffsets>16 || nDescSize>32)) {
@@ -462,8 +694,6 @@ void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::M
     }
 #endif //HAVE_CUDA
     const bool bValidROI1 = !oROI1.empty();
-    const bool bValidROI2 = !oROI2.empty();
-    const int nPatchRadius = nPatchSize/2;
     oAffinityMap.create(3,anAffinityMapDims.data());
     oAffinityMap = -1.0f; // default value for OOB pixels
     cv::Mat_<float> oRawAffinity; // used to cache pixel-wise descriptor distances
@@ -475,6 +705,7 @@ void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::M
     }
     else
         oRawAffinity = oAffinityMap;
+    const SinkhornEMD* pApproxEMD = (eDist==lv::AffinityDist_EMDApprox)?&getApproxEMDSolver(oEMDCostMap):nullptr;
     lvDbgExceptionWatch;
 #if USING_OPENMP
 #ifdef _MSC_VER
@@ -487,65 +718,247 @@ void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::M
         for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
             if(bValidROI1 && !oROI1(nRowIdx,nColIdx))
                 continue;
-            float* pRawAffinityPtr = oRawAffinity.ptr<float>(nRowIdx,nColIdx);
-            for(int nOffsetIdx=0; nOffsetIdx<nOffsets; ++nOffsetIdx) {
-                const int nOffsetColIdx = nColIdx+vDispRange[nOffsetIdx];
-                if(nOffsetColIdx<0 || nOffsetColIdx>=nCols || (bValidROI2 && !oROI2(nRowIdx,nOffsetColIdx)))
-                    continue;
-                if(eDist==lv::AffinityDist_L2) {
-                    const cv::Mat_<float> oDesc(1,nDescSize,const_cast<float*>(oDescMap1.ptr<float>(nRowIdx,nColIdx)));
-                    const cv::Mat_<float> oOffsetDesc(1,nDescSize,const_cast<float*>(oDescMap2.ptr<float>(nRowIdx,nOffsetColIdx)));
-                    pRawAffinityPtr[nOffsetIdx] = float(cv::norm(oDesc,oOffsetDesc,cv::NORM_L2));
-                    lvDbgAssert(pRawAffinityPtr[nOffsetIdx]>=0.0f && pRawAffinityPtr[nOffsetIdx]<=(float)M_SQRT2);
-                }
-                else /*if(eDist==lv::AffinityDist_EMD)*/ {
-                    const float* pDesc = oDescMap1.ptr<float>(nRowIdx,nColIdx);
-                    const float* pOffsetDesc = oDescMap2.ptr<float>(nRowIdx,nOffsetColIdx);
-                    const cv::Mat_<float> oDesc(nDescSize,1,const_cast<float*>(pDesc));
-                    const cv::Mat_<float> oOffsetDesc(nDescSize,1,const_cast<float*>(pOffsetDesc));
-                    lvDbgAssert_(!std::all_of(pDesc,pDesc+nDescSize,[](float v){
-                        lvDbgAssert(v>=0.0f);
-                        return v==0.0f;
-                    }),"opencv emd cannot handle null descriptors");
-                    lvDbgAssert_(!std::all_of(pOffsetDesc,pOffsetDesc+nDescSize,[](float v){
-                        lvDbgAssert(v>=0.0f);
-                        return v==0.0f;
-                    }),"opencv emd cannot handle null descriptors");
-                    pRawAffinityPtr[nOffsetIdx] = cv::EMD(oDesc,oOffsetDesc,-1,oEMDCostMap);
-                    lvDbgAssert(pRawAffinityPtr[nOffsetIdx]>=0.0f);
-                }
-            }
+            calcRawDescAffinities(oDescMap1,oDescMap2,nRowIdx,nColIdx,0,nOffsets,vDispRange,eDist,oROI2,oEMDCostMap,pApproxEMD,oRawAffinity.ptr<float>(nRowIdx,nColIdx));
         }
     }
     if(nPatchSize==1)
         return;
     lvDbgExceptionWatch;
+    aggregateAffinityPatches(oRawAffinity,nPatchSize,oAffinityMap);
+}
+
+void lv::computeDescriptorAffinity(const cv::Mat_<float>& oDescMap1, const cv::Mat_<float>& oDescMap2, int nPatchSize,
+                                   const std::vector<cv::Point2i>& vNodes, const std::vector<int>& vWindowBegins, int nWindowSize,
+                                   cv::Mat_<float>& oAffinity, const std::vector<int>& vDispRange, AffinityDistType eDist,
+                                   const cv::Mat_<uchar>& oROI1, const cv::Mat_<uchar>& oROI2, const cv::Mat_<float>& oEMDCostMap) {
+    lvDbgExceptionWatch;
+    lvAssert_(!oDescMap1.empty() && oDescMap1.size==oDescMap2.size && oDescMap1.dims==3 && oDescMap1.size[2]>1,"bad input desc map sizes");
+    lvAssert_(oROI1.empty() || (oROI1.dims==2 && oROI1.rows==oDescMap1.size[0] && oROI1.cols==oDescMap1.size[1]),"bad ROI1 map size");
+    lvAssert_(oROI2.empty() || (oROI2.dims==2 && oROI2.rows==oDescMap2.size[0] && oROI2.cols==oDescMap2.size[1]),"bad ROI2 map size");
+    lvAssert_(eDist==lv::AffinityDist_L2 || eDist==lv::AffinityDist_EMD || eDist==lv::AffinityDist_EMDApprox,"unsupported distance type");
+    lvAssert_(nPatchSize>=1 && (nPatchSize%2)==1,"bad patch size");
+    lvAssert_(!vDispRange.empty(),"bad disparity range");
+    lvAssert_(nWindowSize>=1 && nWindowSize<=int(vDispRange.size()),"bad disparity window size");
+    lvAssert_(vNodes.size()==vWindowBegins.size(),"node and disparity window array sizes mismatch");
+    if(eDist==lv::AffinityDist_EMD || eDist==lv::AffinityDist_EMDApprox) {
+        lvAssert_(!oEMDCostMap.empty() && oEMDCostMap.dims==2 && oEMDCostMap.rows==oEMDCostMap.cols,"bad emd cost map size");
+        lvAssert_(oEMDCostMap.rows==oDescMap1.size[2],"bad emd cost map size for given desc size");
+    }
+    const int nRows = oDescMap1.size[0];
+    const int nCols = oDescMap1.size[1];
+    const int nOffsets = int(vDispRange.size());
+    const int nNodes = int(vNodes.size());
+    const int nPatchRadius = nPatchSize/2;
+    const bool bValidROI1 = !oROI1.empty();
+    oAffinity.create(nNodes,nWindowSize);
+    oAffinity = -1.0f; // default value for OOB pixels
+    if(nNodes==0)
+        return;
+    for(int nNodeIdx=0; nNodeIdx<nNodes; ++nNodeIdx) {
+        lvAssert_(vNodes[nNodeIdx].y>=0 && vNodes[nNodeIdx].y<nRows && vNodes[nNodeIdx].x>=0 && vNodes[nNodeIdx].x<nCols,"node coordinates out of map bounds");
+        lvAssert_(vWindowBegins[nNodeIdx]>=0 && vWindowBegins[nNodeIdx]<=nOffsets-nWindowSize,"node disparity window out of range bounds");
+    }
+    if(nWindowSize==nOffsets) {
+        // nothing is pruned, so the dense map (and its box-filtered aggregation) is used directly, and only node values are kept
+        cv::Mat_<float> oAffinityMap;
+        lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,oAffinityMap,vDispRange,eDist,oROI1,oROI2,oEMDCostMap,false);
+        for(int nNodeIdx=0; nNodeIdx<nNodes; ++nNodeIdx)
+            std::copy_n(oAffinityMap.ptr<float>(vNodes[nNodeIdx].y,vNodes[nNodeIdx].x),nOffsets,oAffinity.ptr<float>(nNodeIdx));
+        return;
+    }
+    // the offsets needed at each pixel are the union of the windows of all nodes that reach it, i.e. [min begin,max begin+window size);
+    // min/max window begins are spread horizontally for the vertical partial sums, and then vertically for the raw affinities
+    cv::Mat_<float> oMinBegins(nRows,nCols,float(nOffsets)),oMaxBegins(nRows,nCols,-1.0f);
+    for(int nNodeIdx=0; nNodeIdx<nNodes; ++nNodeIdx) {
+        const cv::Point2i& oNode = vNodes[nNodeIdx];
+        oMinBegins(oNode) = std::min(oMinBegins(oNode),float(vWindowBegins[nNodeIdx]));
+        oMaxBegins(oNode) = std::max(oMaxBegins(oNode),float(vWindowBegins[nNodeIdx]));
+    }
+    cv::Mat_<float> oColMinBegins,oColMaxBegins,oRawMinBegins,oRawMaxBegins;
+    const cv::Mat oRowKernel = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(nPatchSize,1));
+    const cv::Mat oColKernel = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(1,nPatchSize));
+    cv::erode(oMinBegins,oColMinBegins,oRowKernel);
+    cv::dilate(oMaxBegins,oColMaxBegins,oRowKernel);
+    cv::erode(oColMinBegins,oRawMinBegins,oColKernel);
+    cv::dilate(oColMaxBegins,oRawMaxBegins,oColKernel);
+    // raw affinities are stored in a ragged array (released on return), with per-pixel windows located via prefix sums of their sizes
+    const int nPixels = nRows*nCols;
+    lv::AutoBuffer<size_t> aRawWindowIdxs(size_t(nPixels+1));
+    size_t* const anRawWindowIdxs = aRawWindowIdxs.data();
+    anRawWindowIdxs[0] = size_t(0);
+    for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            const int nPxIdx = nRowIdx*nCols+nColIdx;
+            const bool bRawNeeded = oRawMaxBegins(nRowIdx,nColIdx)>=0.0f && (!bValidROI1 || oROI1(nRowIdx,nColIdx));
+            anRawWindowIdxs[nPxIdx+1] = anRawWindowIdxs[nPxIdx]+(bRawNeeded?size_t(int(oRawMaxBegins(nRowIdx,nColIdx))+nWindowSize-int(oRawMinBegins(nRowIdx,nColIdx))):size_t(0));
+        }
+    }
+    lv::AutoBuffer<float> aRawAffinityData(anRawWindowIdxs[nPixels]);
+    float* const afRawAffinities = aRawAffinityData.data();
+    std::fill_n(afRawAffinities,anRawWindowIdxs[nPixels],-1.0f); // default value for OOB pixels
+    const SinkhornEMD* pApproxEMD = (eDist==lv::AffinityDist_EMDApprox)?&getApproxEMDSolver(oEMDCostMap):nullptr;
+    lvDbgExceptionWatch;
+#if USING_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif //USING_OPENMP
+    for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
+        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            const int nPxIdx = nRowIdx*nCols+nColIdx;
+            if(anRawWindowIdxs[nPxIdx+1]==anRawWindowIdxs[nPxIdx])
+                continue;
+            const int nOffsetBegin = int(oRawMinBegins(nRowIdx,nColIdx));
+            const int nOffsetEnd = nOffsetBegin+int(anRawWindowIdxs[nPxIdx+1]-anRawWindowIdxs[nPxIdx]);
+            calcRawDescAffinities(oDescMap1,oDescMap2,nRowIdx,nColIdx,nOffsetBegin,nOffsetEnd,vDispRange,eDist,oROI2,oEMDCostMap,pApproxEMD,afRawAffinities+anRawWindowIdxs[nPxIdx]);
+        }
+    }
+    // patches are then box-filtered with running sums along both axes: nodes are visited in row-major order, vertical sums of the rows
+    // of the current node row are slid down (and reset after gaps), and horizontal sums are slid across each node row; sums of a pixel
+    // are only updated over its own window, which always covers the windows of the sums it contributes to (as spread above)
+    std::vector<int> vSortedNodeIdxs((size_t)nNodes);
+    std::iota(vSortedNodeIdxs.begin(),vSortedNodeIdxs.end(),0);
+    std::sort(vSortedNodeIdxs.begin(),vSortedNodeIdxs.end(),[&](int nNodeIdx1, int nNodeIdx2) {
+        return vNodes[nNodeIdx1].y<vNodes[nNodeIdx2].y || (vNodes[nNodeIdx1].y==vNodes[nNodeIdx2].y && vNodes[nNodeIdx1].x<vNodes[nNodeIdx2].x);
+    });
+    const int nBands = (nRows+s_nAffinityBandRows-1)/s_nAffinityBandRows;
+    std::vector<int> vBandNodeBegins(size_t(nBands+1),nNodes);
+    for(int nSortedIdx=nNodes-1; nSortedIdx>=0; --nSortedIdx)
+        vBandNodeBegins[vNodes[vSortedNodeIdxs[nSortedIdx]].y/s_nAffinityBandRows] = nSortedIdx;
+    for(int nBandIdx=nBands-1; nBandIdx>=0; --nBandIdx)
+        vBandNodeBegins[nBandIdx] = std::min(vBandNodeBegins[nBandIdx],vBandNodeBegins[nBandIdx+1]);
+    lvDbgExceptionWatch;
+#if USING_OPENMP
+    #pragma omp parallel for schedule(dynamic)
+#endif //USING_OPENMP
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        if(vBandNodeBegins[nBandIdx]==vBandNodeBegins[nBandIdx+1])
+            continue;
+        static thread_local lv::AutoBuffer<double> s_adColSums,s_adPatchSums;
+        static thread_local lv::AutoBuffer<int> s_anColCounts,s_anPatchCounts;
+        s_adColSums.resize(size_t(nCols*nOffsets));
+        s_anColCounts.resize(size_t(nCols*nOffsets));
+        s_adPatchSums.resize(size_t(nOffsets));
+        s_anPatchCounts.resize(size_t(nOffsets));
+        double* const adColSums = s_adColSums.data();
+        int* const anColCounts = s_anColCounts.data();
+        double* const adPatchSums = s_adPatchSums.data();
+        int* const anPatchCounts = s_anPatchCounts.data();
+        const auto lAccumRawRow = [&](int nRowIdx, bool bAdd) {
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+                const int nPxIdx = nRowIdx*nCols+nColIdx;
+                const int nRawWindowSize = int(anRawWindowIdxs[nPxIdx+1]-anRawWindowIdxs[nPxIdx]);
+                if(nRawWindowSize==0)
+                    continue; // pixel outside ROI1 or unused, all its raw affinities are invalid
+                const int nSumIdx = nColIdx*nOffsets+int(oRawMinBegins(nRowIdx,nColIdx));
+                if(bAdd)
+                    accumValidAffinities<true>(afRawAffinities+anRawWindowIdxs[nPxIdx],adColSums+nSumIdx,anColCounts+nSumIdx,nRawWindowSize);
+                else
+                    accumValidAffinities<false>(afRawAffinities+anRawWindowIdxs[nPxIdx],adColSums+nSumIdx,anColCounts+nSumIdx,nRawWindowSize);
+            }
+        };
+        const auto lAccumColSums = [&](int nRowIdx, int nColIdx, bool bAdd) {
+            lvDbgAssert(oColMaxBegins(nRowIdx,nColIdx)>=0.0f);
+            const int nColWindowBegin = int(oColMinBegins(nRowIdx,nColIdx));
+            const int nColWindowSize = int(oColMaxBegins(nRowIdx,nColIdx))+nWindowSize-nColWindowBegin;
+            const int nSumIdx = nColIdx*nOffsets+nColWindowBegin;
+            if(bAdd)
+                accumPartialAffinities<true>(adColSums+nSumIdx,anColCounts+nSumIdx,adPatchSums+nColWindowBegin,anPatchCounts+nColWindowBegin,nColWindowSize);
+            else
+                accumPartialAffinities<false>(adColSums+nSumIdx,anColCounts+nSumIdx,adPatchSums+nColWindowBegin,anPatchCounts+nColWindowBegin,nColWindowSize);
+        };
+        int nSumRowBegin = 0, nSumRowEnd = 0; // rows currently accumulated in the vertical sums are [begin,end)
+        for(int nSortedIdx=vBandNodeBegins[nBandIdx]; nSortedIdx<vBandNodeBegins[nBandIdx+1];) {
+            const int nRowIdx = vNodes[vSortedNodeIdxs[nSortedIdx]].y;
+            const int nPatchRowBegin = std::max(nRowIdx-nPatchRadius,0), nPatchRowEnd = std::min(nRowIdx+nPatchRadius+1,nRows);
+            if(nSortedIdx==vBandNodeBegins[nBandIdx] || nPatchRowBegin>=nSumRowEnd) {
+                std::fill_n(adColSums,nCols*nOffsets,0.0);
+                std::fill_n(anColCounts,nCols*nOffsets,0);
+                nSumRowBegin = nSumRowEnd = nPatchRowBegin;
+            }
+            for(; nSumRowBegin<nPatchRowBegin; ++nSumRowBegin)
+                lAccumRawRow(nSumRowBegin,false);
+            for(; nSumRowEnd<nPatchRowEnd; ++nSumRowEnd)
+                lAccumRawRow(nSumRowEnd,true);
+            int nSumColBegin = 0, nSumColEnd = 0; // cols currently accumulated in the horizontal sums are [begin,end)
+            for(; nSortedIdx<vBandNodeBegins[nBandIdx+1] && vNodes[vSortedNodeIdxs[nSortedIdx]].y==nRowIdx; ++nSortedIdx) {
+                const int nNodeIdx = vSortedNodeIdxs[nSortedIdx];
+                const int nColIdx = vNodes[nNodeIdx].x;
+                const int nPatchColBegin = std::max(nColIdx-nPatchRadius,0), nPatchColEnd = std::min(nColIdx+nPatchRadius+1,nCols);
+                if(nSumColBegin==nSumColEnd || nPatchColBegin>=nSumColEnd) {
+                    std::fill_n(adPatchSums,nOffsets,0.0);
+                    std::fill_n(anPatchCounts,nOffsets,0);
+                    nSumColBegin = nSumColEnd = nPatchColBegin;
+                }
+                for(; nSumColBegin<nPatchColBegin; ++nSumColBegin)
+                    lAccumColSums(nRowIdx,nSumColBegin,false);
+                for(; nSumColEnd<nPatchColEnd; ++nSumColEnd)
+                    lAccumColSums(nRowIdx,nSumColEnd,true);
+                const int nWindowBegin = vWindowBegins[nNodeIdx];
+                float* const afAffinity = oAffinity.ptr<float>(nNodeIdx);
+                for(int nOffsetIdx=0; nOffsetIdx<nWindowSize; ++nOffsetIdx)
+                    if(anPatchCounts[nWindowBegin+nOffsetIdx]>0)
+                        afAffinity[nOffsetIdx] = float(adPatchSums[nWindowBegin+nOffsetIdx]/anPatchCounts[nWindowBegin+nOffsetIdx]);
+            }
+        }
+    }
+}
+
+void lv::computeDescriptorAffinity(const lv::QuantizedDescMap& oDescMap1, const lv::QuantizedDescMap& oDescMap2,
+                                   int nPatchSize, cv::Mat_<float>& oAffinityMap, const std::vector<int>& vDispRange,
+                                   AffinityDistType eDist, const cv::Mat_<uchar>& oROI1, const cv::Mat_<uchar>& oROI2) {
+    lvDbgExceptionWatch;
+    lvAssert_(!oDescMap1.empty() && oDescMap1.oBins.size==oDescMap2.oBins.size && oDescMap1.oBins.dims==3 && oDescMap1.descSize()>1,"bad input desc map sizes");
+    lvAssert_(oDescMap1.oScales.size==oDescMap2.oScales.size,"bad input desc scale map sizes");
+    lvAssert_(oROI1.empty() || (oROI1.dims==2 && oROI1.rows==oDescMap1.oBins.size[0] && oROI1.cols==oDescMap1.oBins.size[1]),"bad ROI1 map size");
+    lvAssert_(oROI2.empty() || (oROI2.dims==2 && oROI2.rows==oDescMap2.oBins.size[0] && oROI2.cols==oDescMap2.oBins.size[1]),"bad ROI2 map size");
+    lvAssert_(eDist==lv::AffinityDist_L2,"unsupported distance type"); // other distances need decoded descriptors (see lv::QuantizedDescMap::decode)
+    lvAssert_(nPatchSize>=1 && (nPatchSize%2)==1,"bad patch size");
+    lvAssert_(!vDispRange.empty(),"bad disparity range");
+    const int nRows = oDescMap1.oBins.size[0];
+    const int nCols = oDescMap1.oBins.size[1];
+    const int nDescSize = oDescMap1.descSize();
+    const int nOffsets = int(vDispRange.size());
+    const std::array<int,3> anAffinityMapDims = {nRows,nCols,nOffsets};
+    const bool bValidROI1 = !oROI1.empty();
+    const bool bValidROI2 = !oROI2.empty();
+    oAffinityMap.create(3,anAffinityMapDims.data());
+    oAffinityMap = -1.0f; // default value for OOB pixels
+    cv::Mat_<float> oRawAffinity; // used to cache pixel-wise descriptor distances
+    static thread_local lv::AutoBuffer<float> s_aRawAffinityData;
+    if(nPatchSize>1) {
+        s_aRawAffinityData.resize(oAffinityMap.total());
+        oRawAffinity = cv::Mat_<float>(3,anAffinityMapDims.data(),s_aRawAffinityData.data());
+        oRawAffinity = -1.0f; // default value for OOB pixels
+    }
+    else
+        oRawAffinity = oAffinityMap;
+    lvDbgExceptionWatch;
 #if USING_OPENMP
 #ifdef _MSC_VER
     #pragma omp parallel for // msvc only supports openmp 2.0
 #else //ndef(_MSC_VER)
-    #pragma omp parallel for collapse(3)
+    #pragma omp parallel for collapse(2)
 #endif //ndef(_MSC_VER)
 #endif //USING_OPENMP
     for(int nRowIdx=0; nRowIdx<nRows; ++nRowIdx) {
         for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            if(bValidROI1 && !oROI1(nRowIdx,nColIdx))
+                continue;
+            float* pRawAffinityPtr = oRawAffinity.ptr<float>(nRowIdx,nColIdx);
+            const uchar* aBins = oDescMap1.bins(nRowIdx,nColIdx);
+            const float fScale = oDescMap1.scale(nRowIdx,nColIdx);
             for(int nOffsetIdx=0; nOffsetIdx<nOffsets; ++nOffsetIdx) {
-                size_t nValidCount = size_t(0);
-                double afAccumAff = 0.0f;
-                for(int nPatchRowIdx=std::max(nRowIdx-nPatchRadius,0); nPatchRowIdx<=std::min(nRowIdx+nPatchRadius,nRows-1); ++nPatchRowIdx) {
-                    for(int nPatchColIdx=std::max(nColIdx-nPatchRadius,0); nPatchColIdx<=std::min(nColIdx+nPatchRadius,nCols-1); ++nPatchColIdx) {
-                        const float* pRawAffinityPtr = oRawAffinity.ptr<float>(nPatchRowIdx,nPatchColIdx);
-                        if(pRawAffinityPtr[nOffsetIdx]!=-1.0f) {
-                            afAccumAff += pRawAffinityPtr[nOffsetIdx];
-                            ++nValidCount;
-                        }
-                    }
-                }
-                if(nValidCount)
-                    oAffinityMap.at<float>(nRowIdx,nColIdx,nOffsetIdx) = float(afAccumAff/nValidCount);
+                const int nOffsetColIdx = nColIdx+vDispRange[nOffsetIdx];
+                if(nOffsetColIdx<0 || nOffsetColIdx>=nCols || (bValidROI2 && !oROI2(nRowIdx,nOffsetColIdx)))
+                    continue;
+                pRawAffinityPtr[nOffsetIdx] = float(lv::QuantizedDescMap::calcDistance_L2(aBins,fScale,oDescMap2.bins(nRowIdx,nOffsetColIdx),oDescMap2.scale(nRowIdx,nOffsetColIdx),nDescSize));
+                lvDbgAssert(pRawAffinityPtr[nOffsetIdx]>=0.0f);
             }
         }
     }
+    if(nPatchSize==1)
+        return;
+    lvDbgExceptionWatch;
+    aggregateAffinityPatches(oRawAffinity,nPatchSize,oAffinityMap);
 }
 
 #if HAVE_CUDA
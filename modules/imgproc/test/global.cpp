@@ -554,8 +554,161 @@ TEST(descriptor_affinity,regression_L2_dasc) {
         lv::write(sAffMapBinPath_p7,oAffMap);
 }
 
+TEST(descriptor_affinity,regression_L2_dasc_quantized) {
+    std::unique_ptr<DASC> pDASC = std::make_unique<DASC>(size_t(2),0.09f);
+    const cv::Mat oInput = cv::imread(SAMPLES_DATA_ROOT "/108073.jpg");
+    ASSERT_TRUE(!oInput.empty());
+    cv::Mat oInput1=oInput.clone(),oInput2=oInput.clone();
+    lv::shift(oInput2,oInput2,cv::Point2f(-1.5f,4.5f),cv::BORDER_REFLECT101);
+    cv::GaussianBlur(oInput2,oInput2,cv::Size(5,5),0);
+    oInput2.convertTo(oInput2,CV_8U);
+    cv::Mat_<float> oDescMap1,oDescMap2;
+    pDASC->compute2(oInput1,oDescMap1);
+    pDASC->compute2(oInput2,oDescMap2);
+    lv::QuantizedDescMap oQuantMap1,oQuantMap2;
+    pDASC->compute2(oInput1,oQuantMap1);
+    pDASC->compute2(oInput2,oQuantMap2);
+    ASSERT_EQ(lv::MatInfo(oQuantMap1.oBins),lv::MatInfo(oQuantMap2.oBins));
+    ASSERT_EQ(oQuantMap1.oBins.dims,oDescMap1.dims);
+    ASSERT_EQ(oQuantMap1.oBins.size,oDescMap1.size);
+    ASSERT_LT(oQuantMap1.byteCount()*3,oDescMap1.total()*sizeof(float));
+    const std::vector<int> vDispRange = lv::make_range(-3,0);
+    cv::Mat_<uchar> oROI1(oInput2.size(),uchar(0)),oROI2(oInput2.size(),uchar(0));
+    const int nBorderSize = pDASC->borderSize();
+    oROI1(cv::Rect(nBorderSize,nBorderSize,oInput.cols-nBorderSize*2,oInput.rows-nBorderSize*2)) = uchar(255);
+    oROI2(cv::Rect(nBorderSize,nBorderSize,oInput.cols-nBorderSize*2,oInput.rows-nBorderSize*2)) = uchar(255);
+    for(int nPatchSize : {1,7}) {
+        cv::Mat_<float> oAffMap,oAffMap_quant;
+        lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,oAffMap,vDispRange,lv::AffinityDist_L2,oROI1,oROI2,cv::Mat(),false);
+        lv::computeDescriptorAffinity(oQuantMap1,oQuantMap2,nPatchSize,oAffMap_quant,vDispRange,lv::AffinityDist_L2,oROI1,oROI2);
+        ASSERT_EQ(lv::MatInfo(oAffMap_quant),lv::MatInfo(oAffMap));
+        for(int i=0; i<oAffMap.size[0]; ++i) {
+            for(int j=0; j<oAffMap.size[1]; ++j) {
+                for(int k=0; k<oAffMap.size[2]; ++k) {
+                    if(oAffMap(i,j,k)<0.0f)
+                        ASSERT_FLOAT_EQ(oAffMap_quant(i,j,k),oAffMap(i,j,k)) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                    else
+                        ASSERT_NEAR(oAffMap_quant(i,j,k),oAffMap(i,j,k),0.05f) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                }
+            }
+        }
+    }
+    cv::Mat_<float> oAffMap;
+    ASSERT_THROW_LV_QUIET(lv::computeDescriptorAffinity(oQuantMap1,oQuantMap2,1,oAffMap,vDispRange,lv::AffinityDist_EMD,oROI1,oROI2));
+}
+
 #endif //ndef(_MSC_VER)
 
+TEST(descriptor_affinity,regression_box_filter) {
+    // patch aggregation & window SSDs use running sums; compare them with brute-force sums for a few patch sizes
+    cv::RNG oRNG(42);
+    const int nRows = 41, nCols = 57, nDescSize = 16;
+    const std::array<int,3> anDescMapDims = {nRows,nCols,nDescSize};
+    cv::Mat_<float> oDescMap1(3,anDescMapDims.data()),oDescMap2(3,anDescMapDims.data());
+    oRNG.fill(oDescMap1,cv::RNG::UNIFORM,0.0f,1.0f);
+    oRNG.fill(oDescMap2,cv::RNG::UNIFORM,0.0f,1.0f);
+    cv::Mat_<uchar> oImage1(nRows,nCols),oImage2(nRows,nCols),oROI1(nRows,nCols),oROI2(nRows,nCols);
+    oRNG.fill(oImage1,cv::RNG::UNIFORM,0,256);
+    oRNG.fill(oImage2,cv::RNG::UNIFORM,0,256);
+    oRNG.fill(oROI1,cv::RNG::UNIFORM,0,2);
+    oRNG.fill(oROI2,cv::RNG::UNIFORM,0,2);
+    const std::vector<int> vDispRange = {-30,-4,0,1,7,60};
+    for(int nPatchSize : {3,7,15}) {
+        const int nPatchRadius = nPatchSize/2;
+        cv::Mat_<float> oRawAffMap,oAffMap;
+        lv::computeDescriptorAffinity(oDescMap1,oDescMap2,1,oRawAffMap,vDispRange,lv::AffinityDist_L2,oROI1,oROI2,cv::Mat(),false);
+        lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,oAffMap,vDispRange,lv::AffinityDist_L2,oROI1,oROI2,cv::Mat(),false);
+        ASSERT_EQ(lv::MatInfo(oAffMap),lv::MatInfo(oRawAffMap));
+        for(int i=0; i<nRows; ++i) {
+            for(int j=0; j<nCols; ++j) {
+                for(int k=0; k<int(vDispRange.size()); ++k) {
+                    const int nOffsetColIdx = j+vDispRange[k];
+                    if(!oROI1(i,j) || nOffsetColIdx<0 || nOffsetColIdx>=nCols || !oROI2(i,nOffsetColIdx))
+                        ASSERT_EQ(oRawAffMap(i,j,k),-1.0f) << "ijk=[" << i << "," << j << "," << k << "]";
+                    else {
+                        const cv::Mat_<float> oDesc(1,nDescSize,oDescMap1.ptr<float>(i,j)),oOffsetDesc(1,nDescSize,oDescMap2.ptr<float>(i,nOffsetColIdx));
+                        ASSERT_FLOAT_EQ(oRawAffMap(i,j,k),(float)cv::norm(oDesc,oOffsetDesc,cv::NORM_L2)) << "ijk=[" << i << "," << j << "," << k << "]";
+                    }
+                    double dAccumAff = 0.0;
+                    int nValidCount = 0;
+                    for(int ii=std::max(i-nPatchRadius,0); ii<=std::min(i+nPatchRadius,nRows-1); ++ii)
+                        for(int jj=std::max(j-nPatchRadius,0); jj<=std::min(j+nPatchRadius,nCols-1); ++jj)
+                            if(oRawAffMap(ii,jj,k)!=-1.0f)
+                                dAccumAff += oRawAffMap(ii,jj,k), ++nValidCount;
+                    if(nValidCount==0)
+                        ASSERT_EQ(oAffMap(i,j,k),-1.0f) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                    else
+                        ASSERT_FLOAT_EQ(oAffMap(i,j,k),float(dAccumAff/nValidCount)) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                }
+            }
+        }
+        cv::Mat_<float> oImgAffMap;
+        lv::computeImageAffinity(oImage1,oImage2,nPatchSize,oImgAffMap,vDispRange,lv::AffinityDist_SSD,oROI1,oROI2);
+        ASSERT_EQ(oImgAffMap.size[0],nRows-nPatchRadius*2);
+        ASSERT_EQ(oImgAffMap.size[1],nCols-nPatchRadius*2);
+        for(int i=nPatchRadius; i<nRows-nPatchRadius; ++i) {
+            for(int j=nPatchRadius; j<nCols-nPatchRadius; ++j) {
+                for(int k=0; k<int(vDispRange.size()); ++k) {
+                    const int nOffsetColIdx = j+vDispRange[k];
+                    const float fAff = oImgAffMap(i-nPatchRadius,j-nPatchRadius,k);
+                    if(!oROI1(i,j) || nOffsetColIdx<nPatchRadius || nOffsetColIdx>=nCols-nPatchRadius || !oROI2(i,nOffsetColIdx))
+                        ASSERT_EQ(fAff,-1.0f) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                    else {
+                        const cv::Rect oWindow(j-nPatchRadius,i-nPatchRadius,nPatchSize,nPatchSize);
+                        const cv::Rect oOffsetWindow(nOffsetColIdx-nPatchRadius,i-nPatchRadius,nPatchSize,nPatchSize);
+                        ASSERT_EQ(fAff,(float)cv::norm(oImage1(oWindow),oImage2(oOffsetWindow),cv::NORM_L2)) << "nPatchSize=" << nPatchSize << ", ijk=[" << i << "," << j << "," << k << "]";
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(descriptor_affinity,regression_sparse) {
+    // sparse node/window volumes must hold the same values as the dense maps (at node coords, for in-window offsets)
+    cv::RNG oRNG(42);
+    const int nRows = 41, nCols = 57, nDescSize = 16;
+    const std::array<int,3> anDescMapDims = {nRows,nCols,nDescSize};
+    cv::Mat_<float> oDescMap1(3,anDescMapDims.data()),oDescMap2(3,anDescMapDims.data());
+    oRNG.fill(oDescMap1,cv::RNG::UNIFORM,0.0f,1.0f);
+    oRNG.fill(oDescMap2,cv::RNG::UNIFORM,0.0f,1.0f);
+    cv::Mat_<uchar> oROI1(nRows,nCols),oROI2(nRows,nCols);
+    oRNG.fill(oROI1,cv::RNG::UNIFORM,0,4);
+    oRNG.fill(oROI2,cv::RNG::UNIFORM,0,4);
+    const std::vector<int> vDispRange = lv::make_range(-20,0);
+    const int nOffsets = int(vDispRange.size());
+    std::vector<cv::Point2i> vNodes;
+    for(int i=0; i<nRows; ++i)
+        for(int j=0; j<nCols; ++j)
+            if(oROI1(i,j) && oRNG.uniform(0,5)==0)
+                vNodes.push_back(cv::Point2i(j,i));
+    ASSERT_FALSE(vNodes.empty());
+    for(int nPatchSize : {1,3,7,15}) {
+        cv::Mat_<float> oAffMap;
+        lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,oAffMap,vDispRange,lv::AffinityDist_L2,oROI1,oROI2,cv::Mat(),false);
+        for(int nWindowSize : {1,5,nOffsets}) {
+            std::vector<int> vWindowBegins(vNodes.size());
+            for(size_t n=0; n<vNodes.size(); ++n)
+                vWindowBegins[n] = oRNG.uniform(0,nOffsets-nWindowSize+1);
+            cv::Mat_<float> oSparseAffMap;
+            lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,vNodes,vWindowBegins,nWindowSize,oSparseAffMap,vDispRange,lv::AffinityDist_L2,oROI1,oROI2);
+            ASSERT_EQ(oSparseAffMap.rows,int(vNodes.size()));
+            ASSERT_EQ(oSparseAffMap.cols,nWindowSize);
+            for(size_t n=0; n<vNodes.size(); ++n) {
+                for(int k=0; k<nWindowSize; ++k) {
+                    const float fDenseAff = oAffMap(vNodes[n].y,vNodes[n].x,vWindowBegins[n]+k);
+                    if(fDenseAff==-1.0f)
+                        ASSERT_EQ(oSparseAffMap(int(n),k),-1.0f) << "nPatchSize=" << nPatchSize << ", n=" << n << ", k=" << k;
+                    else
+                        ASSERT_FLOAT_EQ(oSparseAffMap(int(n),k),fDenseAff) << "nPatchSize=" << nPatchSize << ", n=" << n << ", k=" << k;
+                }
+            }
+        }
+    }
+    cv::Mat_<float> oBadAffMap; // out-of-range windows must be rejected
+    ASSERT_THROW_LV_QUIET(lv::computeDescriptorAffinity(oDescMap1,oDescMap2,3,vNodes,std::vector<int>(vNodes.size(),nOffsets),1,oBadAffMap,vDispRange,lv::AffinityDist_L2));
+}
+
 TEST(integral,regression) {
     for(size_t i=0u; i<200u; ++i) {
         cv::Mat oTestMat((rand()%500)+1,(rand()%500)+1,CV_8UC((rand()%4)+1));
@@ -567,6 +720,99 @@ TEST(integral,regression) {
     }
 }
 
+#if HAVE_OPENGM
+
+namespace {
+
+    SegmMatcher::MatArrayIn genSegmMatcherInputs(const cv::Size& oSize, int nFGDisp) {
+        // textured foreground block over a shared background, seen at the given disparity in the right image
+        cv::RNG oRNG(42);
+        cv::Mat oLeftImg(oSize,CV_8UC3),oRightImg;
+        oRNG.fill(oLeftImg,cv::RNG::UNIFORM,0,256);
+        cv::GaussianBlur(oLeftImg,oLeftImg,cv::Size(5,5),0);
+        oLeftImg.copyTo(oRightImg);
+        const cv::Rect oLeftFGRect(oSize.width/3,oSize.height/4,oSize.width/4,oSize.height/2);
+        const cv::Rect oRightFGRect = oLeftFGRect-cv::Point(nFGDisp,0);
+        cv::Mat oFGTexture(oLeftFGRect.size(),CV_8UC3);
+        oRNG.fill(oFGTexture,cv::RNG::UNIFORM,0,256);
+        oFGTexture.copyTo(oLeftImg(oLeftFGRect));
+        oFGTexture.copyTo(oRightImg(oRightFGRect));
+        cv::Mat oLeftMask(oSize,CV_8UC1,cv::Scalar_<uchar>(0)),oRightMask(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+        oLeftMask(oLeftFGRect) = cv::Scalar_<uchar>(255);
+        oRightMask(oRightFGRect) = cv::Scalar_<uchar>(255);
+        return SegmMatcher::MatArrayIn{oLeftImg,oLeftMask,oRightImg,oRightMask};
+    }
+
+}
+
+TEST(segmMatcher,regression_parallel_stereo_moves) {
+    const SegmMatcher::MatArrayIn aInputs = genSegmMatcherInputs(cv::Size(120,90),10);
+    const cv::Mat oROI(aInputs[0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+    const std::array<size_t,2> anThreadCounts = {1u,4u};
+    std::array<SegmMatcher::MatArrayOut,2> aaOutputs;
+    for(size_t nTestIdx=0u; nTestIdx<anThreadCounts.size(); ++nTestIdx) {
+        SegmMatcher oMatcher(0,20);
+        oMatcher.initialize(std::array<cv::Mat,2>{oROI,oROI});
+        oMatcher.setStereoMoveThreadCount(anThreadCounts[nTestIdx]);
+        oMatcher.apply(aInputs,aaOutputs[nTestIdx]);
+    }
+    for(size_t nOutputIdx=0u; nOutputIdx<aaOutputs[0].size(); ++nOutputIdx)
+        ASSERT_TRUE(lv::isEqual<SegmMatcher::OutputLabelType>(aaOutputs[0][nOutputIdx],aaOutputs[1][nOutputIdx]));
+}
+
+TEST(segmMatcher,regression_async_features) {
+    const std::array<SegmMatcher::MatArrayIn,3> aaInputs = {genSegmMatcherInputs(cv::Size(120,90),10),genSegmMatcherInputs(cv::Size(120,90),11),genSegmMatcherInputs(cv::Size(120,90),12)};
+    const cv::Mat oROI(aaInputs[0][0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+    SegmMatcher oMatcher_sync(0,20),oMatcher_async(0,20);
+    oMatcher_sync.initialize(std::array<cv::Mat,2>{oROI,oROI});
+    oMatcher_async.initialize(std::array<cv::Mat,2>{oROI,oROI});
+    oMatcher_async.queueNextInputs(aaInputs[0]);
+    oMatcher_async.queueNextInputs(aaInputs[1]);
+    for(size_t nFrameIdx=0u; nFrameIdx<aaInputs.size(); ++nFrameIdx) {
+        SegmMatcher::MatArrayOut aOutputs_sync,aOutputs_async;
+        oMatcher_sync.apply(aaInputs[nFrameIdx],aOutputs_sync);
+        oMatcher_async.apply(aaInputs[nFrameIdx],aOutputs_async);
+        if(nFrameIdx+2u<aaInputs.size())
+            oMatcher_async.queueNextInputs(aaInputs[nFrameIdx+2u]);
+        for(size_t nOutputIdx=0u; nOutputIdx<aOutputs_sync.size(); ++nOutputIdx)
+            ASSERT_TRUE(lv::isEqual<SegmMatcher::OutputLabelType>(aOutputs_sync[nOutputIdx],aOutputs_async[nOutputIdx])) << "nFrameIdx=" << nFrameIdx << ", nOutputIdx=" << nOutputIdx;
+    }
+}
+
+TEST(segmMatcher,regression_async_features_misuse) {
+    const std::array<SegmMatcher::MatArrayIn,3> aaInputs = {genSegmMatcherInputs(cv::Size(120,90),10),genSegmMatcherInputs(cv::Size(120,90),11),genSegmMatcherInputs(cv::Size(120,90),12)};
+    const cv::Mat oROI(aaInputs[0][0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+    SegmMatcher oMatcher(0,20);
+    oMatcher.initialize(std::array<cv::Mat,2>{oROI,oROI});
+    SegmMatcher::MatArrayOut aOutputs;
+    oMatcher.queueNextInputs(aaInputs[0]);
+    oMatcher.queueNextInputs(aaInputs[1]);
+    ASSERT_THROW_LV_QUIET(oMatcher.queueNextInputs(aaInputs[2])); // queue is full
+    ASSERT_NO_THROW(oMatcher.resetTemporalModel()); // drops pending packets
+    ASSERT_NO_THROW(oMatcher.apply(aaInputs[2],aOutputs)); // nothing left in queue, features computed synchronously
+    oMatcher.queueNextInputs(aaInputs[0]);
+    ASSERT_THROW_LV_QUIET(oMatcher.apply(aaInputs[1],aOutputs)); // inputs were not the ones queued
+    oMatcher.queueNextInputs(aaInputs[1]);
+    ASSERT_NO_THROW(oMatcher.apply(aaInputs[1],aOutputs));
+}
+
+TEST(segmMatcher,regression_parallel_features) {
+    const SegmMatcher::MatArrayIn aInputs = genSegmMatcherInputs(cv::Size(120,90),10);
+    const cv::Mat oROI(aInputs[0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+    std::array<cv::Mat,2> aFeaturesPackets;
+    for(size_t nTestIdx=0u; nTestIdx<aFeaturesPackets.size(); ++nTestIdx) {
+        SegmMatcher oMatcher(0,20);
+        oMatcher.initialize(std::array<cv::Mat,2>{oROI,oROI});
+        oMatcher.setFeatureThreading(nTestIdx>0u); // serial first, then on worker threads with capped omp teams
+        oMatcher.calcFeatures(aInputs,&aFeaturesPackets[nTestIdx]);
+    }
+    ASSERT_TRUE(lv::MatInfo(aFeaturesPackets[0])==lv::MatInfo(aFeaturesPackets[1]));
+    ASSERT_TRUE(aFeaturesPackets[0].isContinuous() && aFeaturesPackets[1].isContinuous());
+    ASSERT_EQ(std::memcmp(aFeaturesPackets[0].data,aFeaturesPackets[1].data,aFeaturesPackets[0].total()*aFeaturesPackets[0].elemSize()),0);
+}
+
+#endif //HAVE_OPENGM
+
 namespace {
 
     void medianBlur_perftest(benchmark::State& st) {
@@ -624,6 +870,76 @@ namespace {
         }
     }
 
+    void descriptorAffinity_perftest(benchmark::State& st) {
+        const int nPatchSize = int(st.range(0));
+        const std::array<int,3> anDescMapDims = {240,320,36};
+        cv::Mat_<float> oDescMap1(3,anDescMapDims.data()),oDescMap2(3,anDescMapDims.data());
+        cv::RNG oRNG(42);
+        oRNG.fill(oDescMap1,cv::RNG::UNIFORM,0.0f,1.0f);
+        oRNG.fill(oDescMap2,cv::RNG::UNIFORM,0.0f,1.0f);
+        const std::vector<int> vDispRange = lv::make_range(-40,0);
+        cv::Mat_<float> oAffMap;
+        while(st.KeepRunning()) {
+            lv::computeDescriptorAffinity(oDescMap1,oDescMap2,nPatchSize,oAffMap,vDispRange,lv::AffinityDist_L2,cv::Mat(),cv::Mat(),cv::Mat(),false);
+            benchmark::DoNotOptimize(oAffMap.data);
+        }
+    }
+
+    void sparseDescriptorAffinity_perftest(benchmark::State& st) {
+        const int nWindowSize = int(st.range(0));
+        const std::array<int,3> anDescMapDims = {240,320,36};
+        cv::Mat_<float> oDescMap1(3,anDescMapDims.data()),oDescMap2(3,anDescMapDims.data());
+        cv::RNG oRNG(42);
+        oRNG.fill(oDescMap1,cv::RNG::UNIFORM,0.0f,1.0f);
+        oRNG.fill(oDescMap2,cv::RNG::UNIFORM,0.0f,1.0f);
+        const std::vector<int> vDispRange = lv::make_range(-40,0);
+        std::vector<cv::Point2i> vNodes; // narrow foreground blob, as seen in most stereo segmentation sequences
+        for(int i=60; i<180; ++i)
+            for(int j=140; j<180; ++j)
+                vNodes.push_back(cv::Point2i(j,i));
+        const std::vector<int> vWindowBegins(vNodes.size(),(int(vDispRange.size())-nWindowSize)/2);
+        cv::Mat_<float> oAffinity;
+        while(st.KeepRunning()) {
+            lv::computeDescriptorAffinity(oDescMap1,oDescMap2,15,vNodes,vWindowBegins,nWindowSize,oAffinity,vDispRange,lv::AffinityDist_L2);
+            benchmark::DoNotOptimize(oAffinity.data);
+        }
+    }
+
+#if HAVE_OPENGM
+    void segmMatcherStereoMoves_perftest(benchmark::State& st) {
+        const size_t nStereoMoveThreads = size_t(st.range(0));
+        const SegmMatcher::MatArrayIn aInputs = genSegmMatcherInputs(cv::Size(160,120),12);
+        const cv::Mat oROI(aInputs[0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+        SegmMatcher oMatcher(0,24);
+        oMatcher.initialize(std::array<cv::Mat,2>{oROI,oROI});
+        oMatcher.setStereoMoveThreadCount(nStereoMoveThreads);
+        cv::Mat oFeaturesPacket;
+        oMatcher.calcFeatures(aInputs,&oFeaturesPacket); // features are only computed once, so that inference (i.e. time to convergence) dominates
+        SegmMatcher::MatArrayOut aOutputs;
+        while(st.KeepRunning()) {
+            oMatcher.resetTemporalModel();
+            oMatcher.setNextFeatures(oFeaturesPacket);
+            oMatcher.apply(aInputs,aOutputs);
+            benchmark::DoNotOptimize(aOutputs[0].data);
+        }
+    }
+
+    void segmMatcherFeatures_perftest(benchmark::State& st) {
+        const bool bUseFeatureWorkers = st.range(0)>0;
+        const std::array<SegmMatcher::MatArrayIn,2> aaInputs = {genSegmMatcherInputs(cv::Size(320,240),20),genSegmMatcherInputs(cv::Size(320,240),22)};
+        const cv::Mat oROI(aaInputs[0][0].size(),CV_8UC1,cv::Scalar_<uchar>(255));
+        SegmMatcher oMatcher(0,32);
+        oMatcher.initialize(std::array<cv::Mat,2>{oROI,oROI});
+        oMatcher.setFeatureThreading(bUseFeatureWorkers);
+        cv::Mat oFeaturesPacket;
+        size_t nFrameIdx = 0u;
+        while(st.KeepRunning()) { // one iteration = all features of one frame (i.e. per-camera maps, then affinities & saliency)
+            oMatcher.calcFeatures(aaInputs[(nFrameIdx++)%aaInputs.size()],&oFeaturesPacket);
+            benchmark::DoNotOptimize(oFeaturesPacket.data);
+        }
+    }
+#endif //HAVE_OPENGM
+
 }
 
 BENCHMARK(medianBlur_perftest)->Args({50,3})->Unit(benchmark::kMicrosecond)->Repetitions(10)->ReportAggregatesOnly(true);
@@ -645,3 +961,10 @@ BENCHMARK(medianBlur_perftest)->Args({800,11})->Unit(benchmark::kMicrosecond)->R
 BENCHMARK(binaryMedianBlur_conv_perftest)->Args({800,11})->Unit(benchmark::kMicrosecond)->Repetitions(10)->ReportAggregatesOnly(true);
 BENCHMARK(binaryMedianBlur_raw_perftest)->Args({800,11})->Unit(benchmark::kMicrosecond)->Repetitions(10)->ReportAggregatesOnly(true);
 BENCHMARK(binaryConsensus_perftest)->Args({800,11})->Unit(benchmark::kMicrosecond)->Repetitions(10)->ReportAggregatesOnly(true);
+
+BENCHMARK(descriptorAffinity_perftest)->Arg(1)->Arg(7)->Arg(15)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(sparseDescriptorAffinity_perftest)->Arg(8)->Arg(41)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+#if HAVE_OPENGM
+BENCHMARK(segmMatcherStereoMoves_perftest)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(segmMatcherFeatures_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+#endif //HAVE_OPENGM
@@ -62,6 +62,23 @@ namespace lv {
         return (nSeed>>16)&0x7FFF;
     }
 
+    /// returns a (cheap) 30-bit random number by combining two draws of Intel's fastrand LCG algorithm
+    inline size_t fastrand30(int& nSeed) {
+        const size_t nHighBits = size_t(fastrand(nSeed));
+        return (nHighBits<<15)|size_t(fastrand(nSeed));
+    }
+
+    /// returns a random number to be used modulo the given value; relies on a single fastrand draw when 15 bits are enough, and on two otherwise
+    inline size_t fastrand_mod(int& nSeed, size_t nMod) {
+        return (nMod>size_t(0x8000))?fastrand30(nSeed):size_t(fastrand(nSeed));
+    }
+
+    /// returns whether an event of probability 1/nOdds occurred using fastrand draws (SIZE_MAX odds are treated as 'never', without any draw)
+    inline bool fastrand_odds(int& nSeed, size_t nOdds) {
+        lvDbgAssert(nOdds>0);
+        return nOdds!=SIZE_MAX && (fastrand_mod(nSeed,nOdds)%nOdds)==0;
+    }
+
 #if HAVE_SSE2
     /// initializes the vectorized intel_fastrand LCG random number generator
     inline void sfastrand_vec(uint32_t nSeed, __m128i& anGenerator) {
@@ -1440,6 +1440,10 @@ namespace lv {
         lv::read(sFilePath,oData,eArchiveType);
         return oData;
     }
+    /// writes matrix data to a binary stream (only MatArchive_BINARY and MatArchive_BINARY_LZ4 are supported)
+    void write(std::ostream& ssStr, const cv::Mat& _oData, MatArchiveList eArchiveType=MatArchive_BINARY);
+    /// reads matrix data from a binary stream (only MatArchive_BINARY and MatArchive_BINARY_LZ4 are supported)
+    void read(std::istream& ssStr, cv::Mat& oData, MatArchiveList eArchiveType=MatArchive_BINARY);
 
     /// packs the data of several matrices into a bigger one (memalloc defrag helper)
     cv::Mat packData(const std::vector<cv::Mat>& vMats, std::vector<MatInfo>* pvOutputPackInfo=nullptr);
@@ -433,7 +433,7 @@ namespace lv {
             uint mat2;
             uint tmat;
             uint pad;
-            static void initTinyMT32Generators(glm::uvec3 vGeneratorLayout,lv::aligned_vector<TMT32GenParams,32>& voData);
+            static void initTinyMT32Generators(glm::uvec3 vGeneratorLayout,lv::aligned_vector<TMT32GenParams,32>& voData,int nSeed=0);
         };
 
     } // namespace gl
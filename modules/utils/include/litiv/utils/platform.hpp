@@ -21,6 +21,14 @@
 
 namespace lv {
 
+    /// x86 SIMD instruction sets which can be checked at runtime (used for kernel dispatch)
+    enum SIMDInstrSet {
+        SIMD_None,
+        SIMD_SSE2,
+        SIMD_SSE4_1,
+        SIMD_AVX2,
+    };
+
     /// returns the executable's current working directory path; relies on getcwd, and may return an empty string
     std::string getCurrentWorkDirPath();
     /// adds a forward slash to the given directory path if it ends without one, with handling for special cases (useful for path concatenation)
@@ -41,6 +49,10 @@ namespace lv {
     void registerAllConsoleSignals(void(*lHandler)(int));
     /// returns the amount of physical memory currently used on the system
     size_t getCurrentPhysMemBytesUsed();
+    /// returns whether the given SIMD instruction set was enabled at build time and is supported by the host CPU
+    bool isSIMDSupported(SIMDInstrSet eInstrSet);
+    /// returns the most recent SIMD instruction set enabled at build time and supported by the host CPU
+    SIMDInstrSet getBestSIMDInstrSet();
 
 } // namespace lv
 
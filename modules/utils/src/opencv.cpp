@@ -476,22 +476,30 @@ void lv::write(const std::string& sFilePath, const cv::Mat& _oData, lv::MatArchi
         }
         lvAssert_(ssStr,"plain text archive write failed");
     }
-#if USING_LZ4
-    else if(eArchiveType==MatArchive_BINARY_LZ4) {
+    else {
         std::ofstream ssStr(sFilePath,std::ios::binary);
         lvAssert__(ssStr.is_open(),"could not open binary file at '%s' for writing",sFilePath.c_str());
-        const int32_t nDataType = (int32_t)oData.type();
-        ssStr.write((const char*)&nDataType,sizeof(nDataType));
-        const uint64_t nElemSize = (uint64_t)oData.elemSize();
-        ssStr.write((const char*)&nElemSize,sizeof(nElemSize));
-        const uint64_t nElemCount = (uint64_t)oData.total();
-        ssStr.write((const char*)&nElemCount,sizeof(nElemCount));
-        const int32_t nDims = (int32_t)oData.dims;
-        ssStr.write((const char*)&nDims,sizeof(nDims));
-        for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx) {
-            const int32_t nDimSize = (int32_t)oData.size[nDimIdx];
-            ssStr.write((const char*)&nDimSize,sizeof(nDimSize));
-        }
+        lv::write(ssStr,oData,eArchiveType);
+    }
+}
+
+void lv::write(std::ostream& ssStr, const cv::Mat& _oData, lv::MatArchiveList eArchiveType) {
+    lvAssert_(!_oData.empty(),"output matrix must be non-empty");
+    const cv::Mat oData = _oData.isContinuous()?_oData:_oData.clone();
+    const int32_t nDataType = (int32_t)oData.type();
+    ssStr.write((const char*)&nDataType,sizeof(nDataType));
+    const uint64_t nElemSize = (uint64_t)oData.elemSize();
+    ssStr.write((const char*)&nElemSize,sizeof(nElemSize));
+    const uint64_t nElemCount = (uint64_t)oData.total();
+    ssStr.write((const char*)&nElemCount,sizeof(nElemCount));
+    const int32_t nDims = (int32_t)oData.dims;
+    ssStr.write((const char*)&nDims,sizeof(nDims));
+    for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx) {
+        const int32_t nDimSize = (int32_t)oData.size[nDimIdx];
+        ssStr.write((const char*)&nDimSize,sizeof(nDimSize));
+    }
+#if USING_LZ4
+    if(eArchiveType==MatArchive_BINARY_LZ4) {
         if(nElemSize*nElemCount>0u) {
             static thread_local lv::AutoBuffer<char> s_aDataBuffer;
             s_aDataBuffer.resize(size_t(nElemSize*nElemCount));
@@ -508,29 +516,14 @@ void lv::write(const std::string& sFilePath, const cv::Mat& _oData, lv::MatArchi
             const int32_t nComprSize = 0;
             ssStr.write((const char*)&nComprSize,sizeof(nComprSize));
         }
-        lvAssert_(ssStr,"binary archive write failed");
     }
+    else
 #endif //USING_LZ4
-    else if(eArchiveType==MatArchive_BINARY) {
-        std::ofstream ssStr(sFilePath,std::ios::binary);
-        lvAssert__(ssStr.is_open(),"could not open binary file at '%s' for writing",sFilePath.c_str());
-        const int32_t nDataType = (int32_t)oData.type();
-        ssStr.write((const char*)&nDataType,sizeof(nDataType));
-        const uint64_t nElemSize = (uint64_t)oData.elemSize();
-        ssStr.write((const char*)&nElemSize,sizeof(nElemSize));
-        const uint64_t nElemCount = (uint64_t)oData.total();
-        ssStr.write((const char*)&nElemCount,sizeof(nElemCount));
-        const int32_t nDims = (int32_t)oData.dims;
-        ssStr.write((const char*)&nDims,sizeof(nDims));
-        for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx) {
-            const int32_t nDimSize = (int32_t)oData.size[nDimIdx];
-            ssStr.write((const char*)&nDimSize,sizeof(nDimSize));
-        }
+    if(eArchiveType==MatArchive_BINARY)
         ssStr.write((const char*)(oData.data),nElemSize*nElemCount);
-        lvAssert_(ssStr,"binary archive write failed");
-    }
     else
-        lvError("unrecognized mat archive type flag");
+        lvError("unsupported mat archive type flag for stream output (only binary formats are supported)");
+    lvAssert_(ssStr,"binary archive write failed");
 }
 
 void lv::read(const std::string& sFilePath, cv::Mat& oData, lv::MatArchiveList eArchiveType) {
@@ -570,23 +563,31 @@ void lv::read(const std::string& sFilePath, cv::Mat& oData, lv::MatArchiveList e
         lvAssert_(ssStr,"plain text archive read failed");
         oDataTemp.convertTo(oData,nDataDepth);
     }
-#if USING_LZ4
-    else if(eArchiveType==MatArchive_BINARY_LZ4) {
+    else {
         std::ifstream ssStr(sFilePath,std::ios::binary);
         lvAssert__(ssStr.is_open(),"could not open binary file at '%s' for reading",sFilePath.c_str());
-        int32_t nDataType;
-        ssStr.read((char*)&nDataType,sizeof(nDataType));
-        uint64_t nElemSize;
-        ssStr.read((char*)&nElemSize,sizeof(nElemSize));
-        uint64_t nElemCount;
-        ssStr.read((char*)&nElemCount,sizeof(nElemCount));
-        int32_t nDims;
-        ssStr.read((char*)&nDims,sizeof(nDims));
-        std::vector<int32_t> anSizes(nDims);
-        for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx)
-            ssStr.read((char*)&anSizes[nDimIdx],sizeof(anSizes[nDimIdx]));
-        oData.create(nDims,anSizes.data(),nDataType);
-        lvAssert_(ssStr,"binary archive read failed");
+        lv::read(ssStr,oData,eArchiveType);
+    }
+}
+
+void lv::read(std::istream& ssStr, cv::Mat& oData, lv::MatArchiveList eArchiveType) {
+    int32_t nDataType;
+    ssStr.read((char*)&nDataType,sizeof(nDataType));
+    uint64_t nElemSize;
+    ssStr.read((char*)&nElemSize,sizeof(nElemSize));
+    uint64_t nElemCount;
+    ssStr.read((char*)&nElemCount,sizeof(nElemCount));
+    int32_t nDims;
+    ssStr.read((char*)&nDims,sizeof(nDims));
+    lvAssert_(ssStr && nDims>0 && nDims<=CV_MAX_DIM,"binary archive read failed (bad header)");
+    std::vector<int32_t> anSizes(nDims);
+    for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx)
+        ssStr.read((char*)&anSizes[nDimIdx],sizeof(anSizes[nDimIdx]));
+    lvAssert_(ssStr,"binary archive read failed");
+    oData.create(nDims,anSizes.data(),nDataType);
+    lvAssert_(uint64_t(oData.elemSize())==nElemSize && uint64_t(oData.total())==nElemCount,"binary archive read failed (bad header)");
+#if USING_LZ4
+    if(eArchiveType==MatArchive_BINARY_LZ4) {
         if(oData.total()>0u) {
             int32_t nComprSize;
             ssStr.read((char*)&nComprSize,sizeof(nComprSize));
@@ -604,27 +605,13 @@ void lv::read(const std::string& sFilePath, cv::Mat& oData, lv::MatArchiveList e
             }
         }
     }
+    else
 #endif //USING_LZ4
-    else if(eArchiveType==MatArchive_BINARY) {
-        std::ifstream ssStr(sFilePath,std::ios::binary);
-        lvAssert__(ssStr.is_open(),"could not open binary file at '%s' for reading",sFilePath.c_str());
-        int32_t nDataType;
-        ssStr.read((char*)&nDataType,sizeof(nDataType));
-        uint64_t nElemSize;
-        ssStr.read((char*)&nElemSize,sizeof(nElemSize));
-        uint64_t nElemCount;
-        ssStr.read((char*)&nElemCount,sizeof(nElemCount));
-        int32_t nDims;
-        ssStr.read((char*)&nDims,sizeof(nDims));
-        std::vector<int32_t> anSizes(nDims);
-        for(int32_t nDimIdx=0; nDimIdx<nDims; ++nDimIdx)
-            ssStr.read((char*)&anSizes[nDimIdx],sizeof(anSizes[nDimIdx]));
-        oData.create(nDims,anSizes.data(),nDataType);
+    if(eArchiveType==MatArchive_BINARY)
         ssStr.read((char*)(oData.data),nElemSize*nElemCount);
-        lvAssert_(ssStr,"binary archive read failed");
-    }
     else
-        lvError("unrecognized mat archive type flag");
+        lvError("unsupported mat archive type flag for stream input (only binary formats are supported)");
+    lvAssert_(ssStr,"binary archive read failed");
 }
 
 cv::Mat lv::packData(const std::vector<cv::Mat>& vMats, std::vector<lv::MatInfo>* pvOutputPackInfo) {
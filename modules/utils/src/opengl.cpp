@@ -16,6 +16,7 @@
 // limitations under the License.
 
 #include "litiv/utils/opengl.hpp"
+#include "litiv/utils/math.hpp"
 
 #if HAVE_GLFW
 std::mutex lv::gl::Context::s_oGLFWErrorMessageMutex;
@@ -197,7 +198,7 @@ std::string lv::gl::addLineNumbersToString(const std::string& sSrc, bool bPrefix
     return ssRes.str();
 }
 
-void lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3 vGeneratorLayout,lv::aligned_vector<lv::gl::TMT32GenParams,32>& voData) {
+void lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3 vGeneratorLayout,lv::aligned_vector<lv::gl::TMT32GenParams,32>& voData,int nSeed) {
     static_assert(sizeof(TMT32GenParams)==sizeof(uint)*8,"Hmmm...?");
     lvAssert(vGeneratorLayout.x>0 && vGeneratorLayout.y>0 && vGeneratorLayout.z>0);
     voData.resize(vGeneratorLayout.x*vGeneratorLayout.y*vGeneratorLayout.z);
@@ -210,7 +211,7 @@ void lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3 vGeneratorLayout,
             for(size_t x=0; x<vGeneratorLayout.x; ++x) {
                 const size_t nStepSize_X = x + nStepSize_Y; // NOLINT
                 TMT32GenParams* pCurrGenParams = pData+nStepSize_X;
-                pCurrGenParams->status[0] = (uint)rand();
+                pCurrGenParams->status[0] = ((uint)lv::fastrand(nSeed)<<16)^(uint)lv::fastrand(nSeed);
                 pCurrGenParams->status[1] = pCurrGenParams->mat1 = 0xF20D1B78;
                 pCurrGenParams->status[2] = pCurrGenParams->mat2 = 0xFF90FFE5;
                 pCurrGenParams->status[3] = pCurrGenParams->tmat = 0x30FBDFFF;
@@ -252,4 +252,35 @@ size_t lv::getCurrentPhysMemBytesUsed() {
     fclose(fp);
     return size_t(nMemUsed*sysconf(_SC_PAGESIZE));
 #endif //ndef(_MSC_VER)
-}
\ No newline at end of file
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__amd64__))
+#define LV_CPU_SUPPORTS(feature) (__builtin_cpu_init(),__builtin_cpu_supports(feature))
+#else //!((defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__amd64__)))
+// no portable runtime check available here; rely on build-time flags only
+#define LV_CPU_SUPPORTS(feature) (true)
+#endif //!((defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__amd64__)))
+
+bool lv::isSIMDSupported(SIMDInstrSet eInstrSet) {
+    switch(eInstrSet) {
+        case SIMD_None:
+            return true;
+        case SIMD_SSE2:
+            return HAVE_SSE2 && LV_CPU_SUPPORTS("sse2");
+        case SIMD_SSE4_1:
+            return HAVE_SSE4_1 && LV_CPU_SUPPORTS("sse4.1");
+        case SIMD_AVX2:
+            return HAVE_AVX2 && LV_CPU_SUPPORTS("avx2");
+        default:
+            lvError("unknown SIMD instruction set");
+    }
+}
+
+lv::SIMDInstrSet lv::getBestSIMDInstrSet() {
+    static const SIMDInstrSet s_eBestInstrSet =
+        isSIMDSupported(SIMD_AVX2)?SIMD_AVX2:
+        isSIMDSupported(SIMD_SSE4_1)?SIMD_SSE4_1:
+        isSIMDSupported(SIMD_SSE2)?SIMD_SSE2:
+        SIMD_None;
+    return s_eBestInstrSet;
+}
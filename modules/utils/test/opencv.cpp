@@ -677,6 +677,24 @@ TYPED_TEST(readwrite_fixture,regression) {
         ASSERT_EQ(cv::countNonZero(oNewMat!=oNewMat),0);
     }
 #endif //USING_LZ4
+    for(lv::MatArchiveList eArchiveType : std::vector<lv::MatArchiveList>{lv::MatArchive_BINARY,
+#if USING_LZ4
+                                                                          lv::MatArchive_BINARY_LZ4,
+#endif //USING_LZ4
+    }) {
+        std::vector<cv::Mat_<TypeParam>> voMats(10);
+        std::stringstream ssStream;
+        for(cv::Mat_<TypeParam>& oMat : voMats) {
+            oMat.create(rng.uniform(10,50),rng.uniform(10,50));
+            rng.fill(oMat,cv::RNG::UNIFORM,-200,200,true);
+            lv::write(ssStream,oMat,eArchiveType);
+        }
+        for(const cv::Mat_<TypeParam>& oMat : voMats) {
+            cv::Mat oNewMat;
+            lv::read(ssStream,oNewMat,eArchiveType);
+            ASSERT_TRUE(lv::isEqual<TypeParam>(oMat,oNewMat));
+        }
+    }
     const std::string sYMLPath = TEST_OUTPUT_DATA_ROOT "/test_readwrite.yml";
     for(size_t i=0; i<100; ++i) {
         cv::Mat_<TypeParam> oMat(rng.uniform(10,20),rng.uniform(10,20));
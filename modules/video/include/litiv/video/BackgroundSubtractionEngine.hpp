@@ -0,0 +1,116 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/video/BackgroundSubtractionUtils.hpp"
+
+/// defines the default value for BackgroundSubtractionEngine::m_nMaxQueuedFrames
+#define BGSENGINE_DEFAULT_MAX_QUEUED_FRAMES (4)
+
+/**
+    Multi-stream background subtraction engine, which runs many (CPU-based) subtractors on a shared pool of workers.
+
+    Each stream owns its subtractor state and a bounded frame queue; pushing to a full queue blocks the caller
+    (or fails, with 'tryPush'), so a slow stream cannot accumulate an unbounded backlog. Since the frames of a
+    stream must be processed in order, the unit of work is a single 'apply' call: streams with pending frames
+    wait in a round-robin ready queue, and a stream goes back to the end of that queue after each processed
+    frame, so that busy streams cannot starve others. Using a fixed number of workers (instead of one thread
+    per stream) avoids oversubscription; internal parallelism of subtractors (e.g. SuBSENSE bands) should thus
+    be limited to one thread.
+
+    Foreground masks are handed to the per-stream callback (called from worker threads) as soon as they are
+    ready, along with their frame index. Worker exceptions are kept per stream, and rethrown by 'push' or 'wait'.
+*/
+struct BackgroundSubtractionEngine {
+    /// callback type used to hand out foreground masks; receives the stream index, frame index & mask (only valid during the call)
+    using ResultCallback = std::function<void(size_t /*nStreamIdx*/, size_t /*nFrameIdx*/, const cv::Mat& /*oFGMask*/)>;
+    /// processing statistics of a single stream
+    struct StreamStats {
+        /// number of frames pushed/processed so far
+        size_t nPushedFrames, nProcessedFrames;
+        /// latencies (in seconds) between the push and the end of processing of frames (last, mean & max)
+        double dLastLatency, dMeanLatency, dMaxLatency;
+    };
+    /// full constructor; creates 'nWorkers' threads (0 = use all hardware threads) shared by all streams
+    BackgroundSubtractionEngine(size_t nWorkers=0, size_t nMaxQueuedFrames=BGSENGINE_DEFAULT_MAX_QUEUED_FRAMES);
+    /// default destructor; will block until all queued frames have been processed
+    ~BackgroundSubtractionEngine();
+    /// adds a new stream processed by the given subtractor (initialized here with the given image & ROI), and returns its index
+    size_t addStream(std::shared_ptr<IIBackgroundSubtractor> pAlgo, const cv::Mat& oInitImg, const cv::Mat& oROI=cv::Mat(), ResultCallback lCallback=ResultCallback());
+    /// queues a frame (copied internally) for a stream, blocking while its queue is full; returns the frame index (negative learning rate = algo default)
+    size_t push(size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate=-1);
+    /// queues a frame (copied internally) for a stream if its queue is not full; returns the frame index, or SIZE_MAX if the frame was refused
+    size_t tryPush(size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate=-1);
+    /// blocks until all queued frames of all streams have been processed
+    void wait();
+    /// returns the number of streams handled by the engine
+    size_t getStreamCount() const;
+    /// returns the number of worker threads used by the engine
+    inline size_t getWorkerCount() const {return m_vhWorkers.size();}
+    /// returns the processing statistics of a stream
+    StreamStats getStreamStats(size_t nStreamIdx) const;
+    /// returns the aggregate throughput of all streams (in frames per second) since construction or the last call to 'resetStats'
+    double getAggregateFPS() const;
+    /// resets the aggregate throughput counter along with all per-stream latency stats
+    void resetStats();
+
+protected:
+    /// frame waiting in a stream queue
+    struct QueuedFrame {
+        cv::Mat oImage;
+        double dLearningRate;
+        size_t nFrameIdx;
+        std::chrono::high_resolution_clock::time_point nPushTick;
+    };
+    /// stream state (owned by the engine, and only processed by one worker at a time)
+    struct StreamInfo {
+        std::shared_ptr<IIBackgroundSubtractor> pAlgo;
+        ResultCallback lCallback;
+        std::deque<QueuedFrame> qFrames;
+        cv::Mat oFGMask;
+        bool bScheduled;
+        size_t nPushedFrames, nProcessedFrames, nLatencySamples;
+        double dLastLatency, dTotLatency, dMaxLatency;
+        std::exception_ptr pException;
+    };
+    /// queues a frame for a stream (sync mutex must be locked); returns the frame index
+    size_t push_internal(StreamInfo& oStream, size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate);
+    /// worker thread entry point
+    void entry();
+    /// max number of frames waiting in each stream queue before pushes block/fail
+    const size_t m_nMaxQueuedFrames;
+    /// stream states (pointers are used so that references stay valid when new streams are added)
+    std::vector<std::unique_ptr<StreamInfo>> m_vpStreams;
+    /// round-robin queue of streams with pending frames that are not currently being processed
+    std::deque<size_t> m_qReadyStreams;
+    /// number of frames queued or being processed, over all streams
+    size_t m_nPendingFrames;
+    /// number of frames processed over all streams since the last stats reset
+    size_t m_nTotProcessedFrames;
+    /// stopwatch used to compute the aggregate throughput
+    lv::StopWatch m_oStopWatch;
+    std::vector<std::thread> m_vhWorkers;
+    mutable std::mutex m_oSyncMutex;
+    std::condition_variable m_oReadyCondVar;
+    std::condition_variable m_oSpaceCondVar;
+    std::condition_variable m_oIdleCondVar;
+    bool m_bIsActive;
+private:
+    BackgroundSubtractionEngine& operator=(const BackgroundSubtractionEngine&) = delete;
+    BackgroundSubtractionEngine(const BackgroundSubtractionEngine&) = delete;
+};
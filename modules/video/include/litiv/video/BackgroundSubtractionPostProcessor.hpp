@@ -0,0 +1,75 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/utils/opencv.hpp"
+
+/// defines the default value for BackgroundSubtractionPostProcessor::m_nWorkerCount
+#define BGSPOSTPROC_DEFAULT_WORKER_COUNT (0)
+/// defines the default value for BackgroundSubtractionPostProcessor::m_nBandRows
+#define BGSPOSTPROC_DEFAULT_BAND_ROWS (32)
+
+/**
+    Foreground mask post-processing stage used by SuBSENSE and PAWCS (and usable as-is by any other subtractor).
+
+    For a raw (binary) foreground mask, this stage updates the raw & blinking pixel masks, closes the mask (3x3),
+    fills its holes (via a flood fill from the top-left corner), merges it with its eroded (7x7) closed version,
+    applies a median blur, and finally dilates (7x7) the result to update the blinking pixel map. The output is
+    identical to the equivalent chain of full-frame OpenCV calls (morphologyEx, floodFill, erode, medianBlur,
+    dilate, bitwise_*), but only three passes are made over the frame: two fused passes over independent row
+    bands (processed in parallel, each with a small halo kept in per-thread scratch rows) around a global flood
+    fill pass. Once initialized, no memory is allocated while processing frames.
+
+    The median blur is computed as a majority vote via sliding box counts (as in lv::binaryMedianBlur), but using
+    replicated borders instead of clipped windows to stay bit-exact with cv::medianBlur.
+*/
+struct BackgroundSubtractionPostProcessor {
+    /// default constructor; 'nWorkerCount' is the number of threads used to process row bands (0 = use all hardware threads)
+    BackgroundSubtractionPostProcessor(size_t nWorkerCount=BGSPOSTPROC_DEFAULT_WORKER_COUNT, int nBandRows=BGSPOSTPROC_DEFAULT_BAND_ROWS);
+    /// (re)initializes all scratch buffers and internal mask states for the given frame size; needs to be called before processing masks
+    void initialize(const cv::Size& oFrameSize);
+    /// post-processes the given raw fg mask in-place, using the internal mask states (standalone stage version)
+    void apply(cv::Mat& oFGMask, int nMedianBlurKernelSize);
+    /// post-processes the given raw fg mask in-place, using (and updating) the provided mask states (all CV_8UC1, and of the initialization size)
+    void apply(cv::Mat& oFGMask, int nMedianBlurKernelSize,
+               cv::Mat& oLastFGMask, cv::Mat& oLastFGMask_dilated, cv::Mat& oLastFGMask_dilated_inverted,
+               cv::Mat& oLastRawFGMask, cv::Mat& oLastRawFGBlinkMask, cv::Mat& oBlinksMask);
+    /// sets the number of worker threads used to process row bands (0 = use all hardware threads); does not affect the output
+    inline void setWorkerCount(size_t nWorkers) {m_nWorkerCount = nWorkers;}
+    /// returns the number of worker threads used to process row bands (0 = use all hardware threads)
+    inline size_t getWorkerCount() const {return m_nWorkerCount;}
+    /// returns the latest post-processed fg mask (internal state, only updated by the standalone 'apply' version)
+    inline const cv::Mat& getLastFGMask() const {return m_oLastFGMask;}
+    /// returns the latest dilated post-processed fg mask (internal state, only updated by the standalone 'apply' version)
+    inline const cv::Mat& getLastFGMaskDilated() const {return m_oLastFGMask_dilated;}
+    /// returns the latest blinking pixel map (internal state, only updated by the standalone 'apply' version)
+    inline const cv::Mat& getBlinksMask() const {return m_oBlinksMask;}
+
+protected:
+    /// number of worker threads used to process row bands (0 = use all hardware threads)
+    size_t m_nWorkerCount;
+    /// number of image rows processed by a worker at once (halos excluded)
+    const int m_nBandRows;
+    /// frame size provided at the last (re)initialization
+    cv::Size m_oFrameSize;
+    /// pre-allocated CV_8UC1 matrices used for hole filling (closed raw fg mask, and its flooded copy)
+    cv::Mat m_oFGMask_PreFlood, m_oFGMask_Flooded;
+    /// internal mask states used by the standalone 'apply' version
+    cv::Mat m_oLastFGMask, m_oLastFGMask_dilated, m_oLastFGMask_dilated_inverted;
+    cv::Mat m_oLastRawFGMask, m_oLastRawFGBlinkMask, m_oBlinksMask;
+};
@@ -20,6 +20,9 @@
 #include "litiv/utils/algo.hpp"
 #include <opencv2/video/background_segm.hpp>
 
+/// defines the version number written in (and required to read) model snapshots (see IIBackgroundSubtractor::save)
+#define BGS_SNAPSHOT_VERSION (3)
+
 /// super-interface for background subtraction algos which exposes common interface functions
 struct IIBackgroundSubtractor : public cv::BackgroundSubtractor {
 
@@ -43,6 +46,12 @@ struct IIBackgroundSubtractor : public cv::BackgroundSubtractor {
     virtual void setROI(cv::Mat& oROI);
     /// returns a copy of the ROI used for input analysis
     virtual cv::Mat getROICopy() const;
+    /// sets the seed of the internal random number generator(s) (note: only applied on the next (re)initialization)
+    virtual void setSeed(int nSeed);
+    /// writes a versioned binary snapshot of the full model state to the given stream (default impl throws, as snapshots are not supported)
+    virtual void save(std::ostream& oStream, bool bUseCompression=false) const;
+    /// restores the full model state from a snapshot written by 'save' (default impl throws, as snapshots are not supported)
+    virtual void load(std::istream& oStream);
     /// required for derived class destruction from this interface
     virtual ~IIBackgroundSubtractor() = default;
 
@@ -51,6 +60,28 @@ protected:
     IIBackgroundSubtractor();
     /// common (re)initiaization method for all impl types (should be called in impl-specific initialize func)
     virtual void initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI);
+    /// common snapshot writing method for all impl types (writes header + common state, and returns the archive type to use for impl-specific mats)
+    virtual lv::MatArchiveList save_common(std::ostream& oStream, const std::string& sAlgoName, bool bUseCompression) const;
+    /// common snapshot reading method for all impl types (reinitializes the algo, restores common state, and returns the archive type used for impl-specific mats)
+    virtual lv::MatArchiveList load_common(std::istream& oStream, const std::string& sAlgoName);
+    /// writes a single trivially copyable value to a snapshot stream
+    template<typename T>
+    static void writeSnapshotValue(std::ostream& oStream, const T& tVal) {
+        static_assert(std::is_trivially_copyable<T>::value,"snapshot values must be trivially copyable");
+        oStream.write((const char*)&tVal,sizeof(T));
+        lvAssert_(oStream,"model snapshot write failed");
+    }
+    /// reads a single trivially copyable value from a snapshot stream
+    template<typename T>
+    static T readSnapshotValue(std::istream& oStream) {
+        static_assert(std::is_trivially_copyable<T>::value,"snapshot values must be trivially copyable");
+        T tVal;
+        oStream.read((char*)&tVal,sizeof(T));
+        lvAssert_(oStream,"model snapshot read failed (truncated stream?)");
+        return tVal;
+    }
+    /// reads a matrix from a snapshot stream into a pre-allocated one, making sure their size & type match
+    static void readSnapshotMat(std::istream& oStream, cv::Mat& oMat, lv::MatArchiveList eArchiveType);
 
     /// basic info struct used in px model LUTs
     struct PxInfoBase {
@@ -60,6 +91,9 @@ protected:
     };
     /// background model ROI used for input analysis (specific to the input image size)
     cv::Mat m_oROI;
+    /// ROI provided at the last (re)initialization (before border processing), and whether the previous ROI was reused instead (used to restore snapshots)
+    cv::Mat m_oInitROI;
+    bool m_bInitROIReused;
     /// input image size
     cv::Size m_oImgSize;
     /// ROI border size to be ignored, useful for descriptor-based methods
@@ -86,6 +120,10 @@ protected:
     bool m_bAutoModelResetEnabled;
     /// specifies whether the camera is considered moving or not
     bool m_bUsingMovingCamera;
+    /// seed used to initialize the internal random number generator(s) (see lv::fastrand)
+    int m_nRandSeed;
+    /// instance-wide random number generator state (reset to 'm_nRandSeed' in 'initialize_common', see lv::fastrand)
+    int m_nRandState;
     /// the foreground mask generated by the method at [t-1]
     cv::Mat m_oLastFGMask;
     /// copy of latest pixel intensities (used when refreshing model)
@@ -27,6 +27,116 @@
 /// defines the default value for BackgroundSubtractorLBSP::m_nDefaultMedianBlurKernelSize
 #define BGSLBSP_DEFAULT_MEDIAN_BLUR_KERNEL_SIZE (9)
 
+/**
+    Color + LBSP descriptor background sample store used by sample consensus-based subtractors (LOBSTER, SuBSENSE).
+
+    Samples can either be kept as one full-frame plane per sample (the original 'sample-major' layout), or packed
+    pixel by pixel ('pixel-major' layout), in which case all N descriptor+color samples of a pixel lie in a single
+    aligned memory block. The latter avoids touching N distant cache lines when matching a pixel against its model,
+    which matters a lot on high resolution streams. Both layouts are accessed via the same pixel index-based getters.
+*/
+struct LBSPSampleModel {
+    /// byte alignment of the per-pixel sample blocks in the pixel-major layout
+    static constexpr size_t s_nPxBlockAlign = 32;
+    /// default constructor; the store must still be allocated via 'create' before use
+    LBSPSampleModel();
+    /// (re)allocates the sample store for the given frame size, channel count & sample count; all samples are zeroed
+    void create(const cv::Size& oFrameSize, size_t nChannels, size_t nSamples, bool bPxMajor);
+    /// returns whether the store uses the pixel-major layout or not
+    inline bool isPxMajor() const {return m_bPxMajor;}
+    /// returns the number of samples kept per pixel
+    inline size_t samples() const {return m_nSamples;}
+    /// returns the number of channels per sample
+    inline size_t channels() const {return m_nChannels;}
+    /// returns whether the store has been allocated or not
+    inline bool empty() const {return m_nSamples==0;}
+    /// returns a pointer to the color channels of a given sample at a given pixel index
+    inline uchar* color(size_t nSampleIdx, size_t nPxIdx) {
+        lvDbgAssert(nSampleIdx<m_nSamples && nPxIdx<m_nPxCount);
+        return m_bPxMajor?(m_vnPxMajorData.data()+nPxIdx*m_nPxBlockSize+m_nPxColorOffset+nSampleIdx*m_nChannels):(m_voColorPlanes[nSampleIdx].data+nPxIdx*m_nChannels);
+    }
+    /// returns a pointer to the color channels of a given sample at a given pixel index
+    inline const uchar* color(size_t nSampleIdx, size_t nPxIdx) const {
+        return const_cast<LBSPSampleModel*>(this)->color(nSampleIdx,nPxIdx);
+    }
+    /// returns a pointer to the descriptor channels of a given sample at a given pixel index
+    inline ushort* desc(size_t nSampleIdx, size_t nPxIdx) {
+        lvDbgAssert(nSampleIdx<m_nSamples && nPxIdx<m_nPxCount);
+        return m_bPxMajor?((ushort*)(m_vnPxMajorData.data()+nPxIdx*m_nPxBlockSize)+nSampleIdx*m_nChannels):((ushort*)m_voDescPlanes[nSampleIdx].data+nPxIdx*m_nChannels);
+    }
+    /// returns a pointer to the descriptor channels of a given sample at a given pixel index
+    inline const ushort* desc(size_t nSampleIdx, size_t nPxIdx) const {
+        return const_cast<LBSPSampleModel*>(this)->desc(nSampleIdx,nPxIdx);
+    }
+    /// returns the average of all color samples as a CV_8UC(channels) image
+    void getAvgColorImage(cv::OutputArray oAvgImg) const;
+    /// returns the average of all descriptor samples as a CV_16UC(channels) image
+    void getAvgDescImage(cv::OutputArray oAvgImg) const;
+    /// writes all samples to a binary stream (using a layout-independent format, so that snapshots can be restored in either layout)
+    void write(std::ostream& oStream, lv::MatArchiveList eArchiveType) const;
+    /// reads all samples from a binary stream (the store must already be allocated with the same frame size, channel count & sample count)
+    void read(std::istream& oStream, lv::MatArchiveList eArchiveType);
+
+protected:
+    /// specifies whether samples are packed per pixel or kept in full-frame planes
+    bool m_bPxMajor;
+    /// frame size, total pixel count, channel count & sample count used for the last allocation
+    cv::Size m_oFrameSize;
+    size_t m_nPxCount, m_nChannels, m_nSamples;
+    /// size (in bytes) of a single pixel block & offset of its color samples (descriptors come first, for alignment)
+    size_t m_nPxBlockSize, m_nPxColorOffset;
+    /// sample-major layout storage (one plane per sample)
+    std::vector<cv::Mat> m_voColorPlanes, m_voDescPlanes;
+    /// pixel-major layout storage (one aligned block per pixel)
+    lv::aligned_vector<uchar,s_nPxBlockAlign> m_vnPxMajorData;
+};
+
+/**
+    Batch background sample matching kernel shared by LBSP-based subtractors (LOBSTER, SuBSENSE).
+
+    Evaluates the color L1 distances, the LBSP Hamming distances and all threshold tests of 8 (SSE4.1) or 16 (AVX2)
+    samples at once, and stops as soon as enough matching samples have been found. The good sample count and minimal
+    distances it returns are identical to those of a sequential sample-by-sample scan (the 'SIMD_None' path). Samples
+    must be packed one after the other with interleaved channels, as in the pixel-major layout of LBSPSampleModel.
+*/
+struct LBSPSampleMatcher {
+    /// distance thresholds & options used to determine whether a sample matches the current observation
+    struct Params {
+        /// number of channels in the observation & samples (1 or 3)
+        size_t nChannels;
+        /// number of matching samples after which the scan is interrupted
+        size_t nRequiredSamples;
+        /// specifies whether desc distances average intra- & inter-LBSP distances (SuBSENSE) or only use inter-LBSP ones (LOBSTER)
+        bool bUseIntraDesc;
+        /// right shift applied to desc distances before they are scaled to color units and added to color distances ('sum' distances)
+        size_t nSumDistDescShift;
+        /// max per-channel color/desc/sum distances for a sample to match
+        size_t nColorDistThreshold, nDescDistThreshold, nSumDistThreshold;
+        /// max total (summed over all channels) color/desc/sum distances for a sample to match
+        size_t nTotColorDistThreshold, nTotDescDistThreshold, nTotSumDistThreshold;
+    };
+    /// result of a single pixel model scan
+    struct Result {
+        /// number of matching samples found (never above Params::nRequiredSamples)
+        size_t nGoodSamples;
+        /// minimal total desc & sum distances among matching samples (left at their max range if none matched)
+        size_t nMinDescDist, nMinSumDist;
+    };
+    /// default constructor; uses the best instruction set supported by both the build and the host CPU
+    LBSPSampleMatcher();
+    /// full constructor; falls back to the next best supported instruction set if the requested one is not available
+    explicit LBSPSampleMatcher(lv::SIMDInstrSet eInstrSet);
+    /// returns the instruction set actually used by the kernel (SIMD_None, SIMD_SSE4_1 or SIMD_AVX2)
+    inline lv::SIMDInstrSet getInstrSet() const {return m_eInstrSet;}
+    /// scans the given samples in order and returns the number of matches found (along with min distances)
+    Result match(const Params& oParams, const uchar* anCurrColor, const ushort* anCurrIntraDesc, const uchar* aanLBSPLookupVals,
+                 const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nSamples) const;
+
+protected:
+    /// instruction set used by the kernel
+    lv::SIMDInstrSet m_eInstrSet;
+};
+
 /**
     Local Binary Similarity Pattern (LBSP) algorithm interface for FG/BG video segmentation via change detection.
 
@@ -87,6 +197,10 @@ protected:
     virtual ~IBackgroundSubtractorLBSP_() {}
     /// common (re)initiaization method for all impl types (should be called in impl-specific initialize func)
     virtual void initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
+    /// common snapshot writing method for all LBSP-based impl types (adds LBSP thresholds & last descriptors to the common state)
+    virtual lv::MatArchiveList save_common(std::ostream& oStream, const std::string& sAlgoName, bool bUseCompression) const override;
+    /// common snapshot reading method for all LBSP-based impl types (adds LBSP thresholds & last descriptors to the common state)
+    virtual lv::MatArchiveList load_common(std::istream& oStream, const std::string& sAlgoName) override;
     /// LBSP internal threshold offset value, used to reduce texture noise in dark regions
     const size_t m_nLBSPThresholdOffset;
     /// LBSP relative internal threshold (kept here since we don't keep an LBSP object)
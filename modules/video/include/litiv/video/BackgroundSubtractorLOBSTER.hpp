@@ -27,6 +27,8 @@
 #define BGSLOBSTER_DEFAULT_NB_BG_SAMPLES (35)
 /// defines the default value for IBackgroundSubtractorLOBSTER_::m_nRequiredBGSamples
 #define BGSLOBSTER_DEFAULT_REQUIRED_NB_BG_SAMPLES (2)
+/// defines the default value for BackgroundSubtractorLOBSTER::m_bUsePxMajorModel
+#define BGSLOBSTER_DEFAULT_USE_PX_MAJOR_MODEL (false)
 /// defines the default value for the learning rate passed to cv::BackgroundSubtractor::apply
 #define BGSLOBSTER_DEFAULT_LEARNING_RATE (16)
 
@@ -133,7 +135,13 @@ template<>
 struct BackgroundSubtractorLOBSTER_<lv::NonParallel> : public IBackgroundSubtractorLOBSTER {
 public:
     /// full constructor
-    using IBackgroundSubtractorLOBSTER::IBackgroundSubtractorLOBSTER;
+    BackgroundSubtractorLOBSTER_(size_t nDescDistThreshold=BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD,
+                                 size_t nColorDistThreshold=BGSLOBSTER_DEFAULT_COLOR_DIST_THRESHOLD,
+                                 size_t nBGSamples=BGSLOBSTER_DEFAULT_NB_BG_SAMPLES,
+                                 size_t nRequiredBGSamples=BGSLOBSTER_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                 size_t nLBSPThresholdOffset=BGSLBSP_DEFAULT_LBSP_OFFSET_SIMILARITY_THRESHOLD,
+                                 float fRelLBSPThreshold=BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,
+                                 bool bUsePxMajorModel=BGSLOBSTER_DEFAULT_USE_PX_MAJOR_MODEL);
     /// refreshes all samples based on the last analyzed frame
     void refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate=false);
     /// (re)initiaization method; needs to be called before starting background subtraction
@@ -144,12 +152,18 @@ public:
     virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
     /// returns a copy of the latest reconstructed background descriptors image
     virtual void getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const override;
+    /// writes a versioned binary snapshot of the full model state to the given stream (see IIBackgroundSubtractor::save)
+    virtual void save(std::ostream& oStream, bool bUseCompression=false) const override;
+    /// restores the full model state from a snapshot written by 'save' (algo parameters must match, but the sample layout may differ)
+    virtual void load(std::istream& oStream) override;
 
 protected:
-    /// background model pixel intensity samples
-    std::vector<cv::Mat> m_voBGColorSamples;
-    /// background model descriptors samples
-    std::vector<cv::Mat> m_voBGDescSamples;
+    /// specifies whether background samples are packed per pixel or kept in full-frame planes (see LBSPSampleModel)
+    const bool m_bUsePxMajorModel;
+    /// background model pixel intensity & descriptor samples
+    LBSPSampleModel m_oBGSamples;
+    /// batch sample matching kernel (only used with the pixel-major model layout, where samples are contiguous)
+    LBSPSampleMatcher m_oSampleMatcher;
 };
 
 using BackgroundSubtractorLOBSTER = BackgroundSubtractorLOBSTER_<lv::NonParallel>;
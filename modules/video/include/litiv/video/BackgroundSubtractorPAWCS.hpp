@@ -18,6 +18,7 @@
 #pragma once
 
 #include "litiv/video/BackgroundSubtractorLBSP.hpp"
+#include "litiv/video/BackgroundSubtractionPostProcessor.hpp"
 
 /// defines the default value for BackgroundSubtractorPAWCS::m_nDescDistThresholdOffset
 #define BGSPAWCS_DEFAULT_DESC_DIST_THRESHOLD_OFFSET (2)
@@ -65,6 +66,10 @@ public:
     virtual void getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const override;
     /// returns the default learning rate value used in 'apply'
     virtual double getDefaultLearningRate() const override {return 0;}
+    /// writes a versioned binary snapshot of the full model state (incl. local/global word dictionaries) to the given stream (see IIBackgroundSubtractor::save)
+    virtual void save(std::ostream& oStream, bool bUseCompression=false) const override;
+    /// restores the full model state from a snapshot written by 'save' (algo parameters must match, and words are stored raw, so platforms must match too)
+    virtual void load(std::istream& oStream) override;
 
 protected:
     template<size_t nChannels>
@@ -96,7 +101,6 @@ protected:
     typedef GlobalWord<ColorLBSPFeature<3>> GlobalWord_3ch;
     struct PxInfo_PAWCS : PxInfoBase {
         size_t nGlobalWordMapLookupIdx;
-        std::vector<GlobalWordBase*> vpGlobalDictSortLUT;
     };
     /// absolute minimal color distance threshold ('R' or 'radius' in the original ViBe paper, used as the default/initial 'R(x)' value here)
     const size_t m_nMinColorDistThreshold;
@@ -121,17 +125,21 @@ protected:
     /// current local word weight offset
     size_t m_nLocalWordWeightOffset;
 
-    /// word lists & dictionaries
-    std::vector<LocalWordBase*> m_vpLocalWordDict;
+    /// local word pools (each px owns a fixed-stride slice of 'm_nCurrLocalWords' words, starting at 'nModelIdx*m_nCurrLocalWords')
     std::vector<LocalWord_1ch> m_voLocalWordList_1ch;
     std::vector<LocalWord_3ch> m_voLocalWordList_3ch;
-    std::vector<LocalWord_1ch>::iterator m_pLocalWordListIter_1ch;
-    std::vector<LocalWord_3ch>::iterator m_pLocalWordListIter_3ch;
-    std::vector<GlobalWordBase*> m_vpGlobalWordDict;
+    /// local word dictionaries (same stride as the pools; each entry is a word index relative to the px's pool slice, sorted by weight)
+    std::vector<ushort> m_vnLocalWordDict;
+    /// cached local word weights (aligned with the dictionary entries); only re-evaluated for scanned or updated words, and used as dict sort keys
+    std::vector<float> m_vfLocalWordWeights;
+    /// global word pools & dictionary (the dictionary holds pool indices, sorted by weight)
     std::vector<GlobalWord_1ch> m_voGlobalWordList_1ch;
     std::vector<GlobalWord_3ch> m_voGlobalWordList_3ch;
-    std::vector<GlobalWord_1ch>::iterator m_pGlobalWordListIter_1ch;
-    std::vector<GlobalWord_3ch>::iterator m_pGlobalWordListIter_3ch;
+    std::vector<ushort> m_vnGlobalWordDict;
+    /// per-px global word pool indices sorted by local weight (fixed-stride slices of 'm_nCurrGlobalWords' indices, starting at 'nModelIdx*m_nCurrGlobalWords')
+    std::vector<ushort> m_vnGlobalDictSortLUT;
+    /// contiguous storage for all global word spatial occurrence maps (each word's 'oSpatioOccMap' is a row range of this matrix)
+    cv::Mat m_oGlobalWordSpatioOccMaps;
     std::vector<PxInfo_PAWCS> m_voPxInfoLUT_PAWCS;
 
     /// a lookup map used to keep track of regions where illumination recently changed
@@ -159,20 +167,22 @@ protected:
     /// the foreground mask generated by the method at t-1 (without post-proc, used for blinking px detection)
     cv::Mat m_oLastRawFGMask;
 
-    /// pre-allocated CV_8UC1 matrices used to speed up morph ops
-    cv::Mat m_oFGMask_PreFlood;
-    cv::Mat m_oFGMask_FloodedHoles;
+    /// fused fg mask post-processing stage (closing, hole filling, median blur & blink detection)
+    BackgroundSubtractionPostProcessor m_oPostProcessor;
+    /// pre-allocated CV_8UC1 matrices holding the post-processing mask states
     cv::Mat m_oLastFGMask_dilated;
     cv::Mat m_oLastFGMask_dilated_inverted;
-    cv::Mat m_oCurrRawFGBlinkMask;
     cv::Mat m_oLastRawFGBlinkMask;
     cv::Mat m_oTempGlobalWordWeightDiffFactor;
-    cv::Mat m_oMorphExStructElement;
 
     /// internal weight lookup function for local words
     static float GetLocalWordWeight(const LocalWordBase& w, size_t nCurrFrame, size_t nOffset);
     /// internal weight lookup function for global words
     static float GetGlobalWordWeight(const GlobalWordBase& w);
+    /// returns the global word at the given pool index, regardless of the current channel count
+    GlobalWordBase& getGlobalWord(size_t nGlobalWordIdx) {
+        return (m_nImgChannels==1)?(GlobalWordBase&)m_voGlobalWordList_1ch[nGlobalWordIdx]:(GlobalWordBase&)m_voGlobalWordList_3ch[nGlobalWordIdx];
+    }
 };
 
 using BackgroundSubtractorPAWCS = BackgroundSubtractorPAWCS_<lv::NonParallel>;
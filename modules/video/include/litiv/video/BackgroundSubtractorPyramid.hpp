@@ -0,0 +1,104 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "litiv/video/BackgroundSubtractionUtils.hpp"
+
+/// defines the default value for BackgroundSubtractorPyramid::m_nPyramidLevels
+#define BGSPYRAMID_DEFAULT_PYRAMID_LEVELS (1)
+/// defines the default value for BackgroundSubtractorPyramid::m_nRefineColorDistThreshold
+#define BGSPYRAMID_DEFAULT_REFINE_COLOR_DIST_THRESHOLD (30)
+/// defines the default value for BackgroundSubtractorPyramid::m_nBGRefreshRate
+#define BGSPYRAMID_DEFAULT_BG_REFRESH_RATE (16)
+
+/**
+    Coarse-to-fine ('pyramid mode') wrapper for background subtractors, aimed at wide-area streams where coarse masks suffice.
+
+    The wrapped subtractor (typically LBSP-based, i.e. LOBSTER, SuBSENSE or PAWCS) runs its full model on frames downscaled
+    by a factor of 2^L, and its masks are upsampled back to the input size. If blob refinement is enabled, the pixels that
+    lie on the (upsampled) blob contours are then re-evaluated at full resolution, inside the bounding boxes of the detected
+    blobs only, by comparing the input frame to the (upsampled) model background image. Processing time thus scales with
+    the downscaled frame area and the area of blobs, instead of the input frame area.
+
+    Note: the wrapped model only holds downscaled samples, so contour pixels cannot be re-evaluated with its own test at full
+    resolution; the refinement relies on a plain color distance to a background image that is only refreshed every few
+    frames instead. Unlike LBSP-based models, it is therefore sensitive to illumination changes & shadows along contours.
+
+    The pyramid level count can be changed at runtime to trade segmentation accuracy for speed (0 = no downscaling, in
+    which case this wrapper only forwards all calls to the wrapped subtractor).
+*/
+struct BackgroundSubtractorPyramid : public IBackgroundSubtractor {
+    /// full constructor; the wrapped subtractor is (re)initialized by this object, and should not be used elsewhere
+    BackgroundSubtractorPyramid(std::shared_ptr<IIBackgroundSubtractor> pAlgo,
+                                size_t nPyramidLevels=BGSPYRAMID_DEFAULT_PYRAMID_LEVELS,
+                                bool bUseBlobRefinement=true,
+                                size_t nRefineColorDistThreshold=BGSPYRAMID_DEFAULT_REFINE_COLOR_DIST_THRESHOLD,
+                                size_t nBGRefreshRate=BGSPYRAMID_DEFAULT_BG_REFRESH_RATE);
+    /// (re)initiaization method; needs to be called before starting background subtraction
+    virtual void initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) override;
+    /// returns the default learning rate value of the wrapped subtractor
+    virtual double getDefaultLearningRate() const override;
+    /// segments the input image into fg/bg via the downscaled model, and refines blob contours at full resolution (if enabled)
+    virtual void apply(cv::InputArray oImage, cv::OutputArray oFGMask, double dLearningRate=-1) override;
+    /// returns the (upsampled) background image of the wrapped subtractor
+    virtual void getBackgroundImage(cv::OutputArray oBGImg) const override;
+    /// turns automatic model reset on or off for the wrapped subtractor
+    virtual void setAutomaticModelReset(bool bVal) override;
+    /// sets the seed of the wrapped subtractor's random number generator(s) (note: only applied on the next (re)initialization)
+    virtual void setSeed(int nSeed) override;
+    /// sets the number of pyramid levels used to downscale input frames (note: this function will reinit the model if already initialized)
+    void setPyramidLevels(size_t nPyramidLevels);
+    /// returns the number of pyramid levels used to downscale input frames
+    inline size_t getPyramidLevels() const {return m_nPyramidLevels;}
+    /// turns full resolution blob contour refinement on or off (can be toggled at any time)
+    inline void setBlobRefinement(bool bVal) {m_bUseBlobRefinement = bVal;}
+    /// returns whether full resolution blob contour refinement is enabled or not
+    inline bool isUsingBlobRefinement() const {return m_bUseBlobRefinement;}
+    /// returns the size of the frames processed by the wrapped subtractor
+    inline cv::Size getDownSampledFrameSize() const {return m_oDownSampledFrameSize;}
+    /// returns the wrapped subtractor
+    inline const std::shared_ptr<IIBackgroundSubtractor>& getWrappedAlgo() const {return m_pAlgo;}
+
+protected:
+    /// refreshes the full resolution background image used for blob refinement from the wrapped model
+    void refreshBackgroundImage();
+    /// wrapped subtractor, processing downscaled frames
+    const std::shared_ptr<IIBackgroundSubtractor> m_pAlgo;
+    /// number of pyramid levels used to downscale input frames (each level halves the frame size)
+    size_t m_nPyramidLevels;
+    /// specifies whether blob contours should be refined at full resolution or not
+    bool m_bUseBlobRefinement;
+    /// per-channel color distance threshold above which a contour pixel is considered foreground during refinement
+    const size_t m_nRefineColorDistThreshold;
+    /// number of frames between full resolution background image refreshes (used for refinement only)
+    const size_t m_nBGRefreshRate;
+    /// frame index at which the full resolution background image was last refreshed
+    size_t m_nLastBGRefreshFrameIdx;
+    /// size of the frames processed by the wrapped subtractor
+    cv::Size m_oDownSampledFrameSize;
+    /// pre-allocated downscaled input frame & fg mask
+    cv::Mat m_oDownSampledFrame, m_oDownSampledFGMask;
+    /// pre-allocated (bilinearly) upsampled fg mask, where intermediate values mark blob contours
+    cv::Mat m_oUpSampledFGMask;
+    /// full resolution background image used for refinement (upsampled from the wrapped model)
+    cv::Mat m_oBGImg;
+    /// pre-allocated connected component buffers used to find blob bounding boxes
+    cv::Mat m_oBlobLabels, m_oBlobStats, m_oBlobCentroids;
+    /// inverted ROI used to clear output masks outside the ROI (only allocated if a ROI was provided)
+    cv::Mat m_oROI_inverted;
+};
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "litiv/video/BackgroundSubtractorLBSP.hpp"
+#include "litiv/video/BackgroundSubtractionPostProcessor.hpp"
 
 /// defines the default value for BackgroundSubtractorSuBSENSE::m_nDescDistThresholdOffset
 #define BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET (3)
@@ -29,6 +30,12 @@
 #define BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES (2)
 /// defines the default value for BackgroundSubtractorSuBSENSE::m_nSamplesForMovingAvgs
 #define BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS (100)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_bUsePxMajorModel
+#define BGSSUBSENSE_DEFAULT_USE_PX_MAJOR_MODEL (false)
+/// defines the default value for BackgroundSubtractorSuBSENSE::m_nWorkerCount
+#define BGSSUBSENSE_DEFAULT_WORKER_COUNT (1)
+/// defines the row count of the image bands processed independently in BackgroundSubtractorSuBSENSE::apply
+#define BGSSUBSENSE_PROC_BAND_ROWS (16)
 
 /**
     Self-Balanced Sensitivity segmenTER (SuBSENSE) algorithm for FG/BG video segmentation via change detection.
@@ -36,7 +43,10 @@
     Note: both grayscale and RGB/BGR images may be used with this extractor (parameters are adjusted automatically).
     For optimal grayscale results, use CV_8UC1 frames instead of CV_8UC3.
 
-    For now, only the algorithm's default CPU implementation is offered here.
+    For now, only the algorithm's default CPU implementation is offered here. Each frame is split into row bands
+    that own their random number generator; even bands are processed concurrently first, followed by odd bands,
+    so that neighbor updates spreading across band edges never race. The output thus only depends on the seed,
+    and not on the number of worker threads (see 'setWorkerCount').
 
     For more details on the different parameters or on the algorithm itself, see P.-L. St-Charles et al.,
     "Flexible Background Subtraction With Self-Balanced Local Sensitivity", in CVPRW 2014, or "SuBSENSE: A Universal
@@ -54,7 +64,8 @@ public:
                                   size_t nBGSamples=BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES,
                                   size_t nRequiredBGSamples=BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES,
                                   size_t nSamplesForMovingAvgs=BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS,
-                                  float fRelLBSPThreshold=BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD);
+                                  float fRelLBSPThreshold=BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,
+                                  bool bUsePxMajorModel=BGSSUBSENSE_DEFAULT_USE_PX_MAJOR_MODEL);
     /// refreshes all samples based on the last analyzed frame
     virtual void refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate=false);
     /// (re)initiaization method; needs to be called before starting background subtraction
@@ -67,6 +78,12 @@ public:
     void getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const override;
     /// returns the default learning rate value used in 'apply'
     virtual double getDefaultLearningRate() const override {return 0;}
+    /// sets the number of worker threads used to process image bands (and to post-process fg masks) in 'apply' (0 = use all hardware threads)
+    void setWorkerCount(size_t nWorkers);
+    /// writes a versioned binary snapshot of the full model state to the given stream (see IIBackgroundSubtractor::save)
+    virtual void save(std::ostream& oStream, bool bUseCompression=false) const override;
+    /// restores the full model state from a snapshot written by 'save' (algo parameters must match, but the sample layout may differ)
+    virtual void load(std::istream& oStream) override;
 
 protected:
     /// absolute minimal color distance threshold ('R' or 'radius' in the original ViBe paper, used as the default/initial 'R(x)' value here)
@@ -79,6 +96,8 @@ protected:
     const size_t m_nRequiredBGSamples;
     /// number of samples to use to compute the learning rate of moving averages
     const size_t m_nSamplesForMovingAvgs;
+    /// specifies whether background samples are packed per pixel or kept in full-frame planes (see LBSPSampleModel)
+    const bool m_bUsePxMajorModel;
     /// last calculated non-zero desc ratio
     float m_fLastNonZeroDescRatio;
     /// specifies whether Tmin/Tmax scaling is enabled or not
@@ -91,11 +110,23 @@ protected:
     bool m_bUse3x3Spread;
     /// specifies the downsampled frame size used for cam motion analysis
     cv::Size m_oDownSampledFrameSize;
+    /// number of worker threads used to process image bands in 'apply' (0 = use all hardware threads)
+    size_t m_nWorkerCount;
 
-    /// background model pixel color intensity samples (equivalent to 'B(x)' in PBAS)
-    std::vector<cv::Mat> m_voBGColorSamples;
-    /// background model descriptors samples
-    std::vector<cv::Mat> m_voBGDescSamples;
+    /// model LUT range & random number generator state of an image band processed independently from others
+    struct ProcBandInfo {
+        /// first & past-the-end indices of the band in the px model LUT
+        size_t nModelIdxBegin, nModelIdxEnd;
+        /// generator state of the band (see lv::fastrand)
+        int nRandSeed;
+    };
+    /// image bands processed in 'apply' and 'refreshModel' (always cover the full px model LUT)
+    std::vector<ProcBandInfo> m_voProcBands;
+
+    /// background model pixel color intensity & descriptor samples (equivalent to 'B(x)' in PBAS)
+    LBSPSampleModel m_oBGSamples;
+    /// batch sample matching kernel (only used with the pixel-major model layout, where samples are contiguous)
+    LBSPSampleMatcher m_oSampleMatcher;
 
     /// per-pixel update rates ('T(x)' in PBAS, which contains pixel-level 'sigmas', as referred to in ViBe)
     cv::Mat m_oUpdateRateFrame;
@@ -122,14 +153,12 @@ protected:
     /// the foreground mask generated by the method at [t-1] (without post-proc, used for blinking px detection)
     cv::Mat m_oLastRawFGMask;
 
-    /// pre-allocated CV_8UC1 matrices used to speed up morph ops
-    cv::Mat m_oFGMask_PreFlood;
-    cv::Mat m_oFGMask_FloodedHoles;
+    /// fused fg mask post-processing stage (closing, hole filling, median blur & blink detection)
+    BackgroundSubtractionPostProcessor m_oPostProcessor;
+    /// pre-allocated CV_8UC1 matrices holding the post-processing mask states
     cv::Mat m_oLastFGMask_dilated;
     cv::Mat m_oLastFGMask_dilated_inverted;
-    cv::Mat m_oCurrRawFGBlinkMask;
     cv::Mat m_oLastRawFGBlinkMask;
-    cv::Mat m_oMorphExStructElement;
 };
 
 using BackgroundSubtractorSuBSENSE = BackgroundSubtractorSuBSENSE_<lv::NonParallel>;
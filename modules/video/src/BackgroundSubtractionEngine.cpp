@@ -0,0 +1,183 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/video/BackgroundSubtractionEngine.hpp"
+
+BackgroundSubtractionEngine::BackgroundSubtractionEngine(size_t nWorkers, size_t nMaxQueuedFrames) :
+        m_nMaxQueuedFrames(nMaxQueuedFrames),
+        m_nPendingFrames(0),
+        m_nTotProcessedFrames(0),
+        m_bIsActive(true) {
+    lvAssert_(m_nMaxQueuedFrames>0,"stream queues must be able to hold at least one frame");
+    if(nWorkers==0)
+        nWorkers = std::max(std::thread::hardware_concurrency(),1u);
+    for(size_t n=0; n<nWorkers; ++n)
+        m_vhWorkers.emplace_back(std::bind(&BackgroundSubtractionEngine::entry,this));
+}
+
+BackgroundSubtractionEngine::~BackgroundSubtractionEngine() {
+    {
+        lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+        m_bIsActive = false;
+        m_oReadyCondVar.notify_all();
+    }
+    for(std::thread& oWorker : m_vhWorkers)
+        oWorker.join();
+}
+
+size_t BackgroundSubtractionEngine::addStream(std::shared_ptr<IIBackgroundSubtractor> pAlgo, const cv::Mat& oInitImg, const cv::Mat& oROI, ResultCallback lCallback) {
+    lvDbgExceptionWatch;
+    lvAssert_(pAlgo,"stream must be given a valid background subtractor");
+    std::unique_ptr<StreamInfo> pStream = std::make_unique<StreamInfo>();
+    pAlgo->initialize(oInitImg,oROI);
+    pStream->pAlgo = std::move(pAlgo);
+    pStream->lCallback = std::move(lCallback);
+    pStream->bScheduled = false;
+    pStream->nPushedFrames = pStream->nProcessedFrames = pStream->nLatencySamples = 0;
+    pStream->dLastLatency = pStream->dTotLatency = pStream->dMaxLatency = 0.0;
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    m_vpStreams.push_back(std::move(pStream));
+    return m_vpStreams.size()-1;
+}
+
+size_t BackgroundSubtractionEngine::push_internal(StreamInfo& oStream, size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate) {
+    const size_t nFrameIdx = oStream.nPushedFrames++;
+    oStream.qFrames.push_back(QueuedFrame{oImage.clone(),dLearningRate,nFrameIdx,std::chrono::high_resolution_clock::now()});
+    ++m_nPendingFrames;
+    if(!oStream.bScheduled) {
+        oStream.bScheduled = true;
+        m_qReadyStreams.push_back(nStreamIdx);
+        m_oReadyCondVar.notify_one();
+    }
+    return nFrameIdx;
+}
+
+size_t BackgroundSubtractionEngine::push(size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate) {
+    lvDbgExceptionWatch;
+    lv::mutex_unique_lock sync_lock(m_oSyncMutex);
+    lvAssert_(nStreamIdx<m_vpStreams.size(),"stream index out of range");
+    StreamInfo& oStream = *m_vpStreams[nStreamIdx];
+    m_oSpaceCondVar.wait(sync_lock,[&](){return oStream.qFrames.size()<m_nMaxQueuedFrames || oStream.pException;});
+    if(oStream.pException)
+        std::rethrow_exception(oStream.pException);
+    return push_internal(oStream,nStreamIdx,oImage,dLearningRate);
+}
+
+size_t BackgroundSubtractionEngine::tryPush(size_t nStreamIdx, const cv::Mat& oImage, double dLearningRate) {
+    lvDbgExceptionWatch;
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    lvAssert_(nStreamIdx<m_vpStreams.size(),"stream index out of range");
+    StreamInfo& oStream = *m_vpStreams[nStreamIdx];
+    if(oStream.pException)
+        std::rethrow_exception(oStream.pException);
+    if(oStream.qFrames.size()>=m_nMaxQueuedFrames)
+        return SIZE_MAX;
+    return push_internal(oStream,nStreamIdx,oImage,dLearningRate);
+}
+
+void BackgroundSubtractionEngine::wait() {
+    lvDbgExceptionWatch;
+    lv::mutex_unique_lock sync_lock(m_oSyncMutex);
+    m_oIdleCondVar.wait(sync_lock,[&](){return m_nPendingFrames==0;});
+    for(const auto& pStream : m_vpStreams)
+        if(pStream->pException)
+            std::rethrow_exception(pStream->pException);
+}
+
+size_t BackgroundSubtractionEngine::getStreamCount() const {
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    return m_vpStreams.size();
+}
+
+BackgroundSubtractionEngine::StreamStats BackgroundSubtractionEngine::getStreamStats(size_t nStreamIdx) const {
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    lvAssert_(nStreamIdx<m_vpStreams.size(),"stream index out of range");
+    const StreamInfo& oStream = *m_vpStreams[nStreamIdx];
+    return StreamStats{oStream.nPushedFrames,oStream.nProcessedFrames,oStream.dLastLatency,
+                       oStream.nLatencySamples?oStream.dTotLatency/oStream.nLatencySamples:0.0,oStream.dMaxLatency};
+}
+
+double BackgroundSubtractionEngine::getAggregateFPS() const {
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    const double dElapsed = m_oStopWatch.elapsed();
+    return dElapsed>0.0?m_nTotProcessedFrames/dElapsed:0.0;
+}
+
+void BackgroundSubtractionEngine::resetStats() {
+    lv::mutex_lock_guard sync_lock(m_oSyncMutex);
+    m_nTotProcessedFrames = 0;
+    m_oStopWatch.tick();
+    for(const auto& pStream : m_vpStreams) {
+        pStream->nLatencySamples = 0;
+        pStream->dLastLatency = pStream->dTotLatency = pStream->dMaxLatency = 0.0;
+    }
+}
+
+void BackgroundSubtractionEngine::entry() {
+    lvDbgExceptionWatch;
+    lv::mutex_unique_lock sync_lock(m_oSyncMutex);
+    while(m_bIsActive || !m_qReadyStreams.empty()) {
+        m_oReadyCondVar.wait(sync_lock,[&](){return !m_bIsActive || !m_qReadyStreams.empty();});
+        if(m_qReadyStreams.empty())
+            continue;
+        const size_t nStreamIdx = m_qReadyStreams.front();
+        m_qReadyStreams.pop_front();
+        StreamInfo& oStream = *m_vpStreams[nStreamIdx];
+        lvDbgAssert(oStream.bScheduled && !oStream.qFrames.empty());
+        QueuedFrame oFrame = std::move(oStream.qFrames.front());
+        oStream.qFrames.pop_front();
+        m_oSpaceCondVar.notify_all();
+        std::exception_ptr pException;
+        {
+            // only this worker can touch the stream's algo & mask until it is rescheduled below
+            lv::unlock_guard<lv::mutex_unique_lock> oUnlock(sync_lock);
+            try {
+                IIBackgroundSubtractor& oAlgo = *oStream.pAlgo;
+                oAlgo.apply(oFrame.oImage,oStream.oFGMask,oFrame.dLearningRate<0?oAlgo.getDefaultLearningRate():oFrame.dLearningRate);
+                if(oStream.lCallback)
+                    oStream.lCallback(nStreamIdx,oFrame.nFrameIdx,oStream.oFGMask);
+            }
+            catch(...) {
+                pException = std::current_exception();
+            }
+        }
+        const double dLatency = std::chrono::duration<double>(std::chrono::high_resolution_clock::now()-oFrame.nPushTick).count();
+        ++oStream.nProcessedFrames;
+        ++m_nTotProcessedFrames;
+        ++oStream.nLatencySamples;
+        oStream.dLastLatency = dLatency;
+        oStream.dTotLatency += dLatency;
+        oStream.dMaxLatency = std::max(oStream.dMaxLatency,dLatency);
+        --m_nPendingFrames;
+        if(pException) {
+            // the stream state is now undefined; drop its backlog, and let 'push'/'wait' report the error
+            lvLog_(1,"bgs engine [%" PRIxPTR "] caught exception on stream #%zu, frame #%zu; dropping %zu queued frame(s)",uintptr_t(this),nStreamIdx,oFrame.nFrameIdx,oStream.qFrames.size());
+            m_nPendingFrames -= oStream.qFrames.size();
+            oStream.qFrames.clear();
+            oStream.pException = pException;
+            m_oSpaceCondVar.notify_all();
+        }
+        if(!oStream.qFrames.empty()) {
+            m_qReadyStreams.push_back(nStreamIdx); // back of the queue, so that other ready streams get their turn first
+            m_oReadyCondVar.notify_one();
+        }
+        else
+            oStream.bScheduled = false;
+        if(m_nPendingFrames==0)
+            m_oIdleCondVar.notify_all();
+    }
+}
@@ -0,0 +1,187 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/video/BackgroundSubtractionPostProcessor.hpp"
+
+namespace {
+
+    /// half size of the 3x3 closing kernel applied before hole filling
+    constexpr int s_nCloseRadius = 1;
+    /// half size of the 7x7 kernels used to erode the closed mask & to dilate the final mask (equiv. to three 3x3 iterations)
+    constexpr int s_nMorphRadius = 3;
+
+    /// computes the element-wise min or max of 'nRowCount' consecutive rows (i.e. the vertical pass of a separable erosion/dilation)
+    template<bool bMax>
+    inline void reduceRows(const uchar* pFirstRow, size_t nRowStep, int nRowCount, int nCols, uchar* anOutput) {
+        lvDbgAssert(nRowCount>0);
+        std::copy(pFirstRow,pFirstRow+nCols,anOutput);
+        for(int nRowOffset=1; nRowOffset<nRowCount; ++nRowOffset) {
+            const uchar* const anRow = pFirstRow+nRowOffset*nRowStep;
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx)
+                anOutput[nColIdx] = bMax?std::max(anOutput[nColIdx],anRow[nColIdx]):std::min(anOutput[nColIdx],anRow[nColIdx]);
+        }
+    }
+
+    /// computes the min or max of all row elements in a (border-clipped) window of size 2*nRadius+1 (i.e. the horizontal pass of a separable erosion/dilation)
+    template<bool bMax>
+    inline void reduceCols(const uchar* anInput, int nCols, int nRadius, uchar* anOutput) {
+        std::copy(anInput,anInput+nCols,anOutput);
+        for(int nColOffset=1; nColOffset<=nRadius; ++nColOffset) {
+            for(int nColIdx=0; nColIdx<nCols-nColOffset; ++nColIdx)
+                anOutput[nColIdx] = bMax?std::max(anOutput[nColIdx],anInput[nColIdx+nColOffset]):std::min(anOutput[nColIdx],anInput[nColIdx+nColOffset]);
+            for(int nColIdx=nColOffset; nColIdx<nCols; ++nColIdx)
+                anOutput[nColIdx] = bMax?std::max(anOutput[nColIdx],anInput[nColIdx-nColOffset]):std::min(anOutput[nColIdx],anInput[nColIdx-nColOffset]);
+        }
+    }
+
+    /// thresholds the (replicated-border) horizontal box sums of vertical positive counts, giving the binary median of each window
+    inline void majorityCols(const ushort* anCounts, int nCols, int nRadius, int nMinPositiveCount, uchar* anOutput) {
+        const int nLastColIdx = nCols-1;
+        int nPositiveCount = anCounts[0]*(nRadius+1);
+        for(int nColOffset=1; nColOffset<=nRadius; ++nColOffset)
+            nPositiveCount += anCounts[std::min(nColOffset,nLastColIdx)];
+        for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+            anOutput[nColIdx] = (nPositiveCount>=nMinPositiveCount)?UCHAR_MAX:0;
+            nPositiveCount += anCounts[std::min(nColIdx+nRadius+1,nLastColIdx)]-anCounts[std::max(nColIdx-nRadius,0)];
+        }
+    }
+
+} // anonymous namespace
+
+BackgroundSubtractionPostProcessor::BackgroundSubtractionPostProcessor(size_t nWorkerCount, int nBandRows) :
+        m_nWorkerCount(nWorkerCount),
+        m_nBandRows(nBandRows) {
+    lvAssert_(m_nBandRows>0,"row band size must be positive");
+}
+
+void BackgroundSubtractionPostProcessor::initialize(const cv::Size& oFrameSize) {
+    lvAssert_(oFrameSize.area()>0,"frame size must be non-null");
+    m_oFrameSize = oFrameSize;
+    for(cv::Mat* pMat : {&m_oFGMask_PreFlood,&m_oFGMask_Flooded,&m_oLastFGMask,&m_oLastFGMask_dilated,&m_oLastFGMask_dilated_inverted,
+                         &m_oLastRawFGMask,&m_oLastRawFGBlinkMask,&m_oBlinksMask}) {
+        pMat->create(m_oFrameSize,CV_8UC1);
+        *pMat = cv::Scalar_<uchar>(0);
+    }
+}
+
+void BackgroundSubtractionPostProcessor::apply(cv::Mat& oFGMask, int nMedianBlurKernelSize) {
+    apply(oFGMask,nMedianBlurKernelSize,m_oLastFGMask,m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted,m_oLastRawFGMask,m_oLastRawFGBlinkMask,m_oBlinksMask);
+}
+
+void BackgroundSubtractionPostProcessor::apply(cv::Mat& oFGMask, int nMedianBlurKernelSize,
+                                               cv::Mat& oLastFGMask, cv::Mat& oLastFGMask_dilated, cv::Mat& oLastFGMask_dilated_inverted,
+                                               cv::Mat& oLastRawFGMask, cv::Mat& oLastRawFGBlinkMask, cv::Mat& oBlinksMask) {
+    lvDbgExceptionWatch;
+    lvAssert_(!m_oFrameSize.empty(),"post-processor must be initialized first");
+    lvAssert_(oFGMask.type()==CV_8UC1 && oFGMask.size()==m_oFrameSize,"input mask type/size mismatch with initialization size");
+    lvAssert_(nMedianBlurKernelSize>0 && (nMedianBlurKernelSize%2)==1,"median blur kernel size must be odd & positive");
+    for(const cv::Mat* pMat : {&oLastFGMask,&oLastFGMask_dilated,&oLastFGMask_dilated_inverted,&oLastRawFGMask,&oLastRawFGBlinkMask,&oBlinksMask})
+        lvAssert_(pMat->type()==CV_8UC1 && pMat->size()==m_oFrameSize,"mask state type/size mismatch with initialization size");
+    const int nRows = m_oFrameSize.height, nCols = m_oFrameSize.width;
+    const int nBands = (nRows+m_nBandRows-1)/m_nBandRows;
+    const int nWorkers = (int)(m_nWorkerCount?m_nWorkerCount:std::max(std::thread::hardware_concurrency(),1u));
+    const size_t nStep = (size_t)nCols;
+    // == pass #1: blinking px updates & 3x3 closing (bands only read the raw mask outside their own rows)
+    #pragma omp parallel for schedule(dynamic) num_threads(nWorkers)
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        static thread_local lv::AutoBuffer<uchar> aDilatedRowsBuffer, aTempRowBuffer;
+        const int nBandRowBegin = nBandIdx*m_nBandRows, nBandRowEnd = std::min(nBandRowBegin+m_nBandRows,nRows);
+        const int nDilatedRowBegin = std::max(nBandRowBegin-s_nCloseRadius,0), nDilatedRowEnd = std::min(nBandRowEnd+s_nCloseRadius,nRows);
+        aDilatedRowsBuffer.resize(size_t(nDilatedRowEnd-nDilatedRowBegin)*nStep);
+        aTempRowBuffer.resize(nStep);
+        for(int nRowIdx=nDilatedRowBegin; nRowIdx<nDilatedRowEnd; ++nRowIdx) {
+            const int nFirstRowIdx = std::max(nRowIdx-s_nCloseRadius,0), nLastRowIdx = std::min(nRowIdx+s_nCloseRadius,nRows-1);
+            reduceRows<true>(oFGMask.ptr<uchar>(nFirstRowIdx),oFGMask.step.p[0],nLastRowIdx-nFirstRowIdx+1,nCols,aTempRowBuffer.data());
+            reduceCols<true>(aTempRowBuffer.data(),nCols,s_nCloseRadius,aDilatedRowsBuffer.data()+(nRowIdx-nDilatedRowBegin)*nStep);
+        }
+        for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+            const int nFirstRowIdx = std::max(nRowIdx-s_nCloseRadius,0), nLastRowIdx = std::min(nRowIdx+s_nCloseRadius,nRows-1);
+            reduceRows<false>(aDilatedRowsBuffer.data()+(nFirstRowIdx-nDilatedRowBegin)*nStep,nStep,nLastRowIdx-nFirstRowIdx+1,nCols,aTempRowBuffer.data());
+            uchar* const anPreFloodRow = m_oFGMask_PreFlood.ptr<uchar>(nRowIdx);
+            reduceCols<false>(aTempRowBuffer.data(),nCols,s_nCloseRadius,anPreFloodRow);
+            std::copy(anPreFloodRow,anPreFloodRow+nCols,m_oFGMask_Flooded.ptr<uchar>(nRowIdx));
+            const uchar* const anFGMaskRow = oFGMask.ptr<uchar>(nRowIdx);
+            uchar* const anLastRawFGMaskRow = oLastRawFGMask.ptr<uchar>(nRowIdx);
+            uchar* const anLastRawFGBlinkMaskRow = oLastRawFGBlinkMask.ptr<uchar>(nRowIdx);
+            uchar* const anBlinksMaskRow = oBlinksMask.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+                const uchar nCurrRawFGBlink = anFGMaskRow[nColIdx]^anLastRawFGMaskRow[nColIdx];
+                anBlinksMaskRow[nColIdx] = nCurrRawFGBlink|anLastRawFGBlinkMaskRow[nColIdx];
+                anLastRawFGBlinkMaskRow[nColIdx] = nCurrRawFGBlink;
+                anLastRawFGMaskRow[nColIdx] = anFGMaskRow[nColIdx];
+            }
+        }
+    }
+    // == pass #2: hole detection (global, cannot be split into bands)
+    cv::floodFill(m_oFGMask_Flooded,cv::Point(0,0),UCHAR_MAX);
+    // == pass #3: hole filling, median blur & 7x7 dilation (band halos are recomputed locally, as the raw mask is read-only here)
+    const int nMedianBlurRadius = nMedianBlurKernelSize/2;
+    const int nMinPositiveCount = (nMedianBlurKernelSize*nMedianBlurKernelSize)/2+1;
+    #pragma omp parallel for schedule(dynamic) num_threads(nWorkers)
+    for(int nBandIdx=0; nBandIdx<nBands; ++nBandIdx) {
+        static thread_local lv::AutoBuffer<uchar> aMergedRowsBuffer, aBlurredRowsBuffer, aTempRowBuffer;
+        static thread_local lv::AutoBuffer<ushort> aCountRowBuffer;
+        const int nBandRowBegin = nBandIdx*m_nBandRows, nBandRowEnd = std::min(nBandRowBegin+m_nBandRows,nRows);
+        const int nBlurredRowBegin = std::max(nBandRowBegin-s_nMorphRadius,0), nBlurredRowEnd = std::min(nBandRowEnd+s_nMorphRadius,nRows);
+        const int nMergedRowBegin = std::max(nBlurredRowBegin-nMedianBlurRadius,0), nMergedRowEnd = std::min(nBlurredRowEnd+nMedianBlurRadius,nRows);
+        aMergedRowsBuffer.resize(size_t(nMergedRowEnd-nMergedRowBegin)*nStep);
+        aBlurredRowsBuffer.resize(size_t(nBlurredRowEnd-nBlurredRowBegin)*nStep);
+        aTempRowBuffer.resize(nStep);
+        aCountRowBuffer.resize(nStep);
+        for(int nRowIdx=nMergedRowBegin; nRowIdx<nMergedRowEnd; ++nRowIdx) {
+            // merged = raw | holes | erode7x7(closed), stored as 0/1 for counting
+            const int nFirstRowIdx = std::max(nRowIdx-s_nMorphRadius,0), nLastRowIdx = std::min(nRowIdx+s_nMorphRadius,nRows-1);
+            reduceRows<false>(m_oFGMask_PreFlood.ptr<uchar>(nFirstRowIdx),m_oFGMask_PreFlood.step.p[0],nLastRowIdx-nFirstRowIdx+1,nCols,aTempRowBuffer.data());
+            uchar* const anMergedRow = aMergedRowsBuffer.data()+(nRowIdx-nMergedRowBegin)*nStep;
+            reduceCols<false>(aTempRowBuffer.data(),nCols,s_nMorphRadius,anMergedRow);
+            const uchar* const anFGMaskRow = oFGMask.ptr<uchar>(nRowIdx);
+            const uchar* const anFloodedRow = m_oFGMask_Flooded.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx)
+                anMergedRow[nColIdx] = uchar((anMergedRow[nColIdx]|anFGMaskRow[nColIdx]|uchar(~anFloodedRow[nColIdx]))!=0);
+        }
+        for(int nRowIdx=nBlurredRowBegin; nRowIdx<nBlurredRowEnd; ++nRowIdx) {
+            // median blur with replicated borders (same as cv::medianBlur), via a majority vote over the kernel window
+            ushort* const anCounts = aCountRowBuffer.data();
+            std::fill_n(anCounts,nCols,ushort(0));
+            for(int nRowOffset=-nMedianBlurRadius; nRowOffset<=nMedianBlurRadius; ++nRowOffset) {
+                const int nOffsetRowIdx = std::min(std::max(nRowIdx+nRowOffset,0),nRows-1);
+                const uchar* const anMergedRow = aMergedRowsBuffer.data()+(nOffsetRowIdx-nMergedRowBegin)*nStep;
+                for(int nColIdx=0; nColIdx<nCols; ++nColIdx)
+                    anCounts[nColIdx] += anMergedRow[nColIdx];
+            }
+            uchar* const anBlurredRow = aBlurredRowsBuffer.data()+(nRowIdx-nBlurredRowBegin)*nStep;
+            majorityCols(anCounts,nCols,nMedianBlurRadius,nMinPositiveCount,anBlurredRow);
+            if(nRowIdx>=nBandRowBegin && nRowIdx<nBandRowEnd)
+                std::copy(anBlurredRow,anBlurredRow+nCols,oLastFGMask.ptr<uchar>(nRowIdx));
+        }
+        for(int nRowIdx=nBandRowBegin; nRowIdx<nBandRowEnd; ++nRowIdx) {
+            const int nFirstRowIdx = std::max(nRowIdx-s_nMorphRadius,0), nLastRowIdx = std::min(nRowIdx+s_nMorphRadius,nRows-1);
+            reduceRows<true>(aBlurredRowsBuffer.data()+(nFirstRowIdx-nBlurredRowBegin)*nStep,nStep,nLastRowIdx-nFirstRowIdx+1,nCols,aTempRowBuffer.data());
+            uchar* const anDilatedRow = oLastFGMask_dilated.ptr<uchar>(nRowIdx);
+            reduceCols<true>(aTempRowBuffer.data(),nCols,s_nMorphRadius,anDilatedRow);
+            uchar* const anDilatedInvertedRow = oLastFGMask_dilated_inverted.ptr<uchar>(nRowIdx);
+            uchar* const anBlinksMaskRow = oBlinksMask.ptr<uchar>(nRowIdx);
+            for(int nColIdx=0; nColIdx<nCols; ++nColIdx) {
+                // blinks are masked by both the previous & the current dilated fg masks
+                const uchar nDilatedInverted = uchar(~anDilatedRow[nColIdx]);
+                anBlinksMaskRow[nColIdx] &= anDilatedInvertedRow[nColIdx]&nDilatedInverted;
+                anDilatedInvertedRow[nColIdx] = nDilatedInverted;
+            }
+        }
+    }
+    oLastFGMask.copyTo(oFGMask);
+}
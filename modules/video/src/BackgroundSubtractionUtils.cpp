@@ -17,6 +17,13 @@
 
 #include "litiv/video/BackgroundSubtractionUtils.hpp"
 
+namespace {
+
+    /// magic number found at the beginning of all model snapshots ('LBGS')
+    constexpr uint32_t s_nSnapshotMagic = 0x5347424Cu;
+
+} // anonymous namespace
+
 void IIBackgroundSubtractor::initialize(const cv::Mat& oInitImg) {
     initialize(oInitImg,cv::Mat());
 }
@@ -51,7 +58,20 @@ cv::Mat IIBackgroundSubtractor::getROICopy() const {
     return m_oROI.clone();
 }
 
+void IIBackgroundSubtractor::setSeed(int nSeed) {
+    m_nRandSeed = nSeed;
+}
+
+void IIBackgroundSubtractor::save(std::ostream&, bool) const {
+    lvError("model snapshots are not supported by this algorithm");
+}
+
+void IIBackgroundSubtractor::load(std::istream&) {
+    lvError("model snapshots are not supported by this algorithm");
+}
+
 IIBackgroundSubtractor::IIBackgroundSubtractor() :
+        m_bInitROIReused(false),
         m_nROIBorderSize(0),
         m_nImgChannels(0),
         m_nImgType(0),
@@ -65,7 +85,9 @@ IIBackgroundSubtractor::IIBackgroundSubtractor() :
         m_bInitialized(false),
         m_bModelInitialized(false),
         m_bAutoModelResetEnabled(true),
-        m_bUsingMovingCamera(false) {}
+        m_bUsingMovingCamera(false),
+        m_nRandSeed(0),
+        m_nRandState(0) {}
 
 void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI) {
     lvAssert_(!oInitImg.empty() && oInitImg.isContinuous() && (oInitImg.type()==CV_8UC1 || oInitImg.type()==CV_8UC3 || oInitImg.type()==CV_8UC4),"provided image for initialization must be non-empty, continuous, and of type 8UC1/3/4");
@@ -80,13 +102,19 @@ void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv
             lvWarn("IIBackgroundSubtractor : Warning, grayscale images should always be passed in CV_8UC1 format for optimal performance.");
     }
     cv::Mat oNewBGROI;
+    m_bInitROIReused = false;
     if(oROI.empty() && m_oROI.size()!=oInitImg.size()) {
         oNewBGROI.create(oInitImg.size(),CV_8UC1);
         oNewBGROI = cv::Scalar_<uchar>(UCHAR_MAX);
+        m_oInitROI = cv::Mat();
     }
-    else if(oROI.empty())
+    else if(oROI.empty()) {
         oNewBGROI = m_oROI; // reuse last ROI if sizes match, and no new ROI is provided
+        m_oInitROI = m_oROI.clone();
+        m_bInitROIReused = true;
+    }
     else {
+        m_oInitROI = oROI.clone();
         lvAssert_(oROI.size()==oInitImg.size() && oROI.type()==CV_8UC1,"provided ROI mat size must be equal to the init frame size, and its type must be 8UC1");
         lvAssert_(cv::countNonZero((oROI<UCHAR_MAX)&(oROI>0))==0,"provided ROI mat values must be 0 or 255 only");
         oNewBGROI = oROI.clone();
@@ -110,6 +138,7 @@ void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv
     m_nFrameIdx = 0;
     m_nFramesSinceLastReset = 0;
     m_nModelResetCooldown = 0;
+    m_nRandState = m_nRandSeed;
     m_oLastFGMask.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask = cv::Scalar_<uchar>(0);
     m_oLastColorFrame.create(m_oImgSize,CV_8UC((int)m_nImgChannels));
@@ -154,6 +183,98 @@ void IIBackgroundSubtractor::initialize_common(const cv::Mat& oInitImg, const cv
     }
 }
 
+lv::MatArchiveList IIBackgroundSubtractor::save_common(std::ostream& oStream, const std::string& sAlgoName, bool bUseCompression) const {
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+#if USING_LZ4
+    const lv::MatArchiveList eArchiveType = bUseCompression?lv::MatArchive_BINARY_LZ4:lv::MatArchive_BINARY;
+#else //!USING_LZ4
+    if(bUseCompression)
+        lvWarn("IIBackgroundSubtractor : Warning, framework built without lz4 support, model snapshot will not be compressed.");
+    bUseCompression = false;
+    const lv::MatArchiveList eArchiveType = lv::MatArchive_BINARY;
+#endif //!USING_LZ4
+    writeSnapshotValue(oStream,s_nSnapshotMagic);
+    writeSnapshotValue(oStream,(uint32_t)BGS_SNAPSHOT_VERSION);
+    writeSnapshotValue(oStream,(uint32_t)sAlgoName.size());
+    oStream.write(sAlgoName.data(),sAlgoName.size());
+    writeSnapshotValue(oStream,(uint8_t)bUseCompression);
+    writeSnapshotValue(oStream,(int32_t)m_nImgType);
+    writeSnapshotValue(oStream,(int32_t)m_oImgSize.width);
+    writeSnapshotValue(oStream,(int32_t)m_oImgSize.height);
+    writeSnapshotValue(oStream,(uint8_t)m_bInitROIReused);
+    writeSnapshotValue(oStream,(uint8_t)!m_oInitROI.empty());
+    if(!m_oInitROI.empty())
+        lv::write(oStream,m_oInitROI,eArchiveType);
+    lv::write(oStream,m_oLastColorFrame,eArchiveType);
+    lv::write(oStream,m_oLastFGMask,eArchiveType);
+    writeSnapshotValue(oStream,(uint64_t)m_nFrameIdx);
+    writeSnapshotValue(oStream,(uint64_t)m_nFramesSinceLastReset);
+    writeSnapshotValue(oStream,(uint64_t)m_nModelResetCooldown);
+    writeSnapshotValue(oStream,(uint8_t)m_bAutoModelResetEnabled);
+    writeSnapshotValue(oStream,(uint8_t)m_bUsingMovingCamera);
+    writeSnapshotValue(oStream,(int32_t)m_nRandSeed);
+    writeSnapshotValue(oStream,(int32_t)m_nRandState);
+    return eArchiveType;
+}
+
+lv::MatArchiveList IIBackgroundSubtractor::load_common(std::istream& oStream, const std::string& sAlgoName) {
+    lvAssert_(readSnapshotValue<uint32_t>(oStream)==s_nSnapshotMagic,"stream does not contain a valid model snapshot");
+    const uint32_t nVersion = readSnapshotValue<uint32_t>(oStream);
+    lvAssert__(nVersion==BGS_SNAPSHOT_VERSION,"unsupported model snapshot version (got %d, expected %d)",(int)nVersion,(int)BGS_SNAPSHOT_VERSION);
+    const uint32_t nAlgoNameLength = readSnapshotValue<uint32_t>(oStream);
+    lvAssert_(nAlgoNameLength<=UCHAR_MAX,"bad model snapshot algo name length");
+    std::string sSnapshotAlgoName(nAlgoNameLength,'\0');
+    oStream.read(&sSnapshotAlgoName[0],nAlgoNameLength);
+    lvAssert__(sSnapshotAlgoName==sAlgoName,"model snapshot was written by another algorithm ('%s')",sSnapshotAlgoName.c_str());
+    const bool bUseCompression = readSnapshotValue<uint8_t>(oStream)!=0;
+#if USING_LZ4
+    const lv::MatArchiveList eArchiveType = bUseCompression?lv::MatArchive_BINARY_LZ4:lv::MatArchive_BINARY;
+#else //!USING_LZ4
+    lvAssert_(!bUseCompression,"model snapshot is compressed, but framework was built without lz4 support");
+    const lv::MatArchiveList eArchiveType = lv::MatArchive_BINARY;
+#endif //!USING_LZ4
+    const int nImgType = (int)readSnapshotValue<int32_t>(oStream);
+    const int nImgWidth = (int)readSnapshotValue<int32_t>(oStream);
+    const int nImgHeight = (int)readSnapshotValue<int32_t>(oStream);
+    const bool bInitROIReused = readSnapshotValue<uint8_t>(oStream)!=0;
+    cv::Mat oInitROI,oLastColorFrame,oLastFGMask;
+    if(readSnapshotValue<uint8_t>(oStream)!=0)
+        lv::read(oStream,oInitROI,eArchiveType);
+    lv::read(oStream,oLastColorFrame,eArchiveType);
+    lv::read(oStream,oLastFGMask,eArchiveType);
+    lvAssert_(oLastColorFrame.type()==nImgType && oLastColorFrame.size()==cv::Size(nImgWidth,nImgHeight),"bad model snapshot image type/size");
+    lvAssert_(oLastFGMask.type()==CV_8UC1 && oLastFGMask.size()==oLastColorFrame.size(),"bad model snapshot foreground mask type/size");
+    lvAssert_(oInitROI.empty() || oInitROI.size()==oLastColorFrame.size(),"bad model snapshot ROI size");
+    const size_t nFrameIdx = (size_t)readSnapshotValue<uint64_t>(oStream);
+    const size_t nFramesSinceLastReset = (size_t)readSnapshotValue<uint64_t>(oStream);
+    const size_t nModelResetCooldown = (size_t)readSnapshotValue<uint64_t>(oStream);
+    const bool bAutoModelResetEnabled = readSnapshotValue<uint8_t>(oStream)!=0;
+    const bool bUsingMovingCamera = readSnapshotValue<uint8_t>(oStream)!=0;
+    const int nRandSeed = (int)readSnapshotValue<int32_t>(oStream);
+    const int nRandState = (int)readSnapshotValue<int32_t>(oStream);
+    // rebuild all LUTs & buffers exactly as they were when the snapshot model was last initialized; impl state is overwritten afterwards
+    m_nRandSeed = nRandSeed;
+    m_oROI = bInitROIReused?oInitROI:cv::Mat();
+    initialize(oLastColorFrame,bInitROIReused?cv::Mat():oInitROI);
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model initialization failed during snapshot restore");
+    oLastColorFrame.copyTo(m_oLastColorFrame);
+    oLastFGMask.copyTo(m_oLastFGMask);
+    m_nFrameIdx = nFrameIdx;
+    m_nFramesSinceLastReset = nFramesSinceLastReset;
+    m_nModelResetCooldown = nModelResetCooldown;
+    m_bAutoModelResetEnabled = bAutoModelResetEnabled;
+    m_bUsingMovingCamera = bUsingMovingCamera;
+    m_nRandState = nRandState;
+    return eArchiveType;
+}
+
+void IIBackgroundSubtractor::readSnapshotMat(std::istream& oStream, cv::Mat& oMat, lv::MatArchiveList eArchiveType) {
+    cv::Mat oSnapshotMat;
+    lv::read(oStream,oSnapshotMat,eArchiveType);
+    lvAssert_(lv::MatInfo(oSnapshotMat)==lv::MatInfo(oMat),"model snapshot matrix size/type mismatch with current model");
+    oSnapshotMat.copyTo(oMat);
+}
+
 #if HAVE_GLSL
 
 IBackgroundSubtractor_GLSL::IBackgroundSubtractor_(size_t nLevels, size_t nComputeStages, size_t nExtraSSBOs, size_t nExtraACBOs,
@@ -17,6 +17,372 @@
 
 #include "litiv/video/BackgroundSubtractorLBSP.hpp"
 
+LBSPSampleModel::LBSPSampleModel() :
+        m_bPxMajor(false),
+        m_nPxCount(0),
+        m_nChannels(0),
+        m_nSamples(0),
+        m_nPxBlockSize(0),
+        m_nPxColorOffset(0) {}
+
+void LBSPSampleModel::create(const cv::Size& oFrameSize, size_t nChannels, size_t nSamples, bool bPxMajor) {
+    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
+    lvAssert_(oFrameSize.area()>0 && nChannels>0 && nSamples>0,"bad sample model size");
+    m_bPxMajor = bPxMajor;
+    m_oFrameSize = oFrameSize;
+    m_nPxCount = (size_t)oFrameSize.area();
+    m_nChannels = nChannels;
+    m_nSamples = nSamples;
+    if(m_bPxMajor) {
+        m_voColorPlanes.clear();
+        m_voDescPlanes.clear();
+        m_nPxColorOffset = m_nSamples*m_nChannels*LBSP::DESC_SIZE;
+        m_nPxBlockSize = ((m_nPxColorOffset+m_nSamples*m_nChannels+s_nPxBlockAlign-1)/s_nPxBlockAlign)*s_nPxBlockAlign;
+        m_vnPxMajorData.assign(m_nPxCount*m_nPxBlockSize,uchar(0));
+        lvDbgAssert(lv::isAligned<s_nPxBlockAlign>(m_vnPxMajorData.data()));
+    }
+    else {
+        m_vnPxMajorData = lv::aligned_vector<uchar,s_nPxBlockAlign>();
+        m_nPxColorOffset = m_nPxBlockSize = 0;
+        m_voColorPlanes.resize(m_nSamples);
+        m_voDescPlanes.resize(m_nSamples);
+        for(size_t s=0; s<m_nSamples; ++s) {
+            m_voColorPlanes[s].create(m_oFrameSize,CV_8UC((int)m_nChannels));
+            m_voColorPlanes[s] = cv::Scalar_<uchar>::all(0);
+            m_voDescPlanes[s].create(m_oFrameSize,CV_16UC((int)m_nChannels));
+            m_voDescPlanes[s] = cv::Scalar_<ushort>::all(0);
+            lvAssert(m_voColorPlanes[s].isContinuous() && m_voDescPlanes[s].isContinuous());
+        }
+    }
+}
+
+void LBSPSampleModel::getAvgColorImage(cv::OutputArray oAvgImg) const {
+    lvAssert_(!empty(),"sample model must be allocated first");
+    cv::Mat oAvgBGImg = cv::Mat::zeros(m_oFrameSize,CV_32FC((int)m_nChannels));
+    for(size_t s=0; s<m_nSamples; ++s) {
+        for(size_t nPxIter=0; nPxIter<m_nPxCount; ++nPxIter) {
+            float* const oAvgBgImgPtr = ((float*)oAvgBGImg.data)+nPxIter*m_nChannels;
+            const uchar* const oBGImgPtr = color(s,nPxIter);
+            for(size_t c=0; c<m_nChannels; ++c)
+                oAvgBgImgPtr[c] += ((float)oBGImgPtr[c])/m_nSamples;
+        }
+    }
+    oAvgBGImg.convertTo(oAvgImg,CV_8U);
+}
+
+void LBSPSampleModel::getAvgDescImage(cv::OutputArray oAvgImg) const {
+    lvAssert_(!empty(),"sample model must be allocated first");
+    cv::Mat oAvgBGDesc = cv::Mat::zeros(m_oFrameSize,CV_32FC((int)m_nChannels));
+    for(size_t s=0; s<m_nSamples; ++s) {
+        for(size_t nPxIter=0; nPxIter<m_nPxCount; ++nPxIter) {
+            float* const oAvgBgDescPtr = ((float*)oAvgBGDesc.data)+nPxIter*m_nChannels;
+            const ushort* const oBGDescPtr = desc(s,nPxIter);
+            for(size_t c=0; c<m_nChannels; ++c)
+                oAvgBgDescPtr[c] += ((float)oBGDescPtr[c])/m_nSamples;
+        }
+    }
+    oAvgBGDesc.convertTo(oAvgImg,CV_16U);
+}
+
+void LBSPSampleModel::write(std::ostream& oStream, lv::MatArchiveList eArchiveType) const {
+    lvAssert_(!empty(),"sample model must be allocated first");
+    // samples are always written as full-frame planes, whatever the current layout
+    cv::Mat oColorPlane,oDescPlane;
+    for(size_t s=0; s<m_nSamples; ++s) {
+        if(m_bPxMajor) {
+            oColorPlane.create(m_oFrameSize,CV_8UC((int)m_nChannels));
+            oDescPlane.create(m_oFrameSize,CV_16UC((int)m_nChannels));
+            for(size_t nPxIter=0; nPxIter<m_nPxCount; ++nPxIter) {
+                std::copy_n(color(s,nPxIter),m_nChannels,oColorPlane.data+nPxIter*m_nChannels);
+                std::copy_n(desc(s,nPxIter),m_nChannels,((ushort*)oDescPlane.data)+nPxIter*m_nChannels);
+            }
+        }
+        else {
+            oColorPlane = m_voColorPlanes[s];
+            oDescPlane = m_voDescPlanes[s];
+        }
+        lv::write(oStream,oColorPlane,eArchiveType);
+        lv::write(oStream,oDescPlane,eArchiveType);
+    }
+}
+
+void LBSPSampleModel::read(std::istream& oStream, lv::MatArchiveList eArchiveType) {
+    lvAssert_(!empty(),"sample model must be allocated first");
+    cv::Mat oColorPlane,oDescPlane;
+    for(size_t s=0; s<m_nSamples; ++s) {
+        lv::read(oStream,oColorPlane,eArchiveType);
+        lv::read(oStream,oDescPlane,eArchiveType);
+        lvAssert_(oColorPlane.size()==m_oFrameSize && oColorPlane.type()==CV_8UC((int)m_nChannels),"bad sample color plane size/type in stream");
+        lvAssert_(oDescPlane.size()==m_oFrameSize && oDescPlane.type()==CV_16UC((int)m_nChannels),"bad sample descriptor plane size/type in stream");
+        if(m_bPxMajor) {
+            for(size_t nPxIter=0; nPxIter<m_nPxCount; ++nPxIter) {
+                std::copy_n(oColorPlane.data+nPxIter*m_nChannels,m_nChannels,color(s,nPxIter));
+                std::copy_n(((const ushort*)oDescPlane.data)+nPxIter*m_nChannels,m_nChannels,desc(s,nPxIter));
+            }
+        }
+        else {
+            oColorPlane.copyTo(m_voColorPlanes[s]);
+            oDescPlane.copyTo(m_voDescPlanes[s]);
+        }
+    }
+}
+
+namespace {
+
+    /// max value of distance thresholds in vectorized impls (distances are kept in signed 16-bit lanes)
+    constexpr size_t s_nMaxSIMDDistThreshold = SHRT_MAX;
+
+    /// returns an empty scan result (no match, min distances at their max range)
+    inline LBSPSampleMatcher::Result initMatchResult(const LBSPSampleMatcher::Params& oParams) {
+        return LBSPSampleMatcher::Result{0,LBSP::DESC_SIZE_BITS*oParams.nChannels,UCHAR_MAX*oParams.nChannels};
+    }
+
+    /// sequential sample-by-sample scan (reference impl, used when no SIMD instruction set is available)
+    LBSPSampleMatcher::Result match_scalar(const LBSPSampleMatcher::Params& oParams, const uchar* anCurrColor, const ushort* anCurrIntraDesc, const uchar* aanLBSPLookupVals,
+                                           const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nSamples) {
+        LBSPSampleMatcher::Result oRes = initMatchResult(oParams);
+        const size_t nChannels = oParams.nChannels;
+        size_t nSampleIdx = 0;
+        while(oRes.nGoodSamples<oParams.nRequiredSamples && nSampleIdx<nSamples) {
+            const uchar* const anBGColor = anBGColors+nSampleIdx*nChannels;
+            const ushort* const anBGDesc = anBGDescs+nSampleIdx*nChannels;
+            size_t nTotColorDist = 0;
+            size_t nTotDescDist = 0;
+            size_t nTotSumDist = 0;
+            for(size_t c=0; c<nChannels; ++c) {
+                const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
+                if(nColorDist>oParams.nColorDistThreshold)
+                    goto failedcheck;
+                const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals+c*LBSP::DESC_SIZE_BITS,anBGColor[c],anLBSPThresholdLUT[anBGColor[c]]);
+                const size_t nInterDescDist = lv::hdist(nCurrInterDesc,anBGDesc[c]);
+                const size_t nDescDist = oParams.bUseIntraDesc?(lv::hdist(anCurrIntraDesc[c],anBGDesc[c])+nInterDescDist)/2:nInterDescDist;
+                if(nDescDist>oParams.nDescDistThreshold)
+                    goto failedcheck;
+                const size_t nSumDist = std::min((nDescDist>>oParams.nSumDistDescShift)*(UCHAR_MAX/LBSP::DESC_SIZE_BITS)+nColorDist,(size_t)UCHAR_MAX);
+                if(nSumDist>oParams.nSumDistThreshold)
+                    goto failedcheck;
+                nTotColorDist += nColorDist;
+                nTotDescDist += nDescDist;
+                nTotSumDist += nSumDist;
+            }
+            if(nTotColorDist>oParams.nTotColorDistThreshold || nTotDescDist>oParams.nTotDescDistThreshold || nTotSumDist>oParams.nTotSumDistThreshold)
+                goto failedcheck;
+            if(oRes.nMinDescDist>nTotDescDist)
+                oRes.nMinDescDist = nTotDescDist;
+            if(oRes.nMinSumDist>nTotSumDist)
+                oRes.nMinSumDist = nTotSumDist;
+            ++oRes.nGoodSamples;
+            failedcheck:
+            ++nSampleIdx;
+        }
+        return oRes;
+    }
+
+#if (HAVE_SSE4_1 || HAVE_AVX2)
+
+    /// deinterleaves (up to) 'nLanes' consecutive samples in per-channel 16-bit lanes, and zero-pads the lanes past the last sample
+    template<size_t nLanes>
+    inline void gatherSampleBatch(size_t nChannels, const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nBatchSize,
+                                  ushort (&aanColors)[3][nLanes], ushort (&aanThresholds)[3][nLanes], ushort (&aanDescs)[3][nLanes]) {
+        for(size_t c=0; c<nChannels; ++c) {
+            for(size_t s=0; s<nBatchSize; ++s) {
+                const uchar nBGColor = anBGColors[s*nChannels+c];
+                aanColors[c][s] = nBGColor;
+                aanThresholds[c][s] = anLBSPThresholdLUT[nBGColor];
+                aanDescs[c][s] = anBGDescs[s*nChannels+c];
+            }
+            for(size_t s=nBatchSize; s<nLanes; ++s)
+                aanColors[c][s] = aanThresholds[c][s] = aanDescs[c][s] = 0;
+        }
+    }
+
+    /// counts the matches of a batch (given as a lane bitmask) in sample order, and stops as soon as enough were found
+    template<size_t nLanes>
+    inline void accumulateBatch(const LBSPSampleMatcher::Params& oParams, uint32_t nMatchMask, const ushort (&anTotDescDists)[nLanes],
+                                const ushort (&anTotSumDists)[nLanes], LBSPSampleMatcher::Result& oRes) {
+        for(size_t s=0; s<nLanes && nMatchMask && oRes.nGoodSamples<oParams.nRequiredSamples; ++s, nMatchMask>>=1) {
+            if(nMatchMask&1) {
+                if(oRes.nMinDescDist>anTotDescDists[s])
+                    oRes.nMinDescDist = anTotDescDists[s];
+                if(oRes.nMinSumDist>anTotSumDists[s])
+                    oRes.nMinSumDist = anTotSumDists[s];
+                ++oRes.nGoodSamples;
+            }
+        }
+    }
+
+#endif //(HAVE_SSE4_1 || HAVE_AVX2)
+
+#if HAVE_SSE4_1
+
+    /// returns the number of set bits in each 16-bit lane of the given register
+    inline __m128i popcount_16ui(const __m128i& anVals) {
+        const __m128i anNibbleLUT = _mm_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m128i anLowNibbleMask = _mm_set1_epi8(0x0F);
+        const __m128i anByteCounts = _mm_add_epi8(_mm_shuffle_epi8(anNibbleLUT,_mm_and_si128(anVals,anLowNibbleMask)),
+                                                  _mm_shuffle_epi8(anNibbleLUT,_mm_and_si128(_mm_srli_epi16(anVals,4),anLowNibbleMask)));
+        return _mm_add_epi16(_mm_and_si128(anByteCounts,_mm_set1_epi16(0x00FF)),_mm_srli_epi16(anByteCounts,8));
+    }
+
+    /// batch scan impl evaluating 8 samples at once in 16-bit lanes
+    LBSPSampleMatcher::Result match_sse41(const LBSPSampleMatcher::Params& oParams, const uchar* anCurrColor, const ushort* anCurrIntraDesc, const uchar* aanLBSPLookupVals,
+                                          const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nSamples) {
+        constexpr size_t nLanes = 8;
+        LBSPSampleMatcher::Result oRes = initMatchResult(oParams);
+        const size_t nChannels = oParams.nChannels;
+        const __m128i vnColorDistThreshold = _mm_set1_epi16((short)std::min(oParams.nColorDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnDescDistThreshold = _mm_set1_epi16((short)std::min(oParams.nDescDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnSumDistThreshold = _mm_set1_epi16((short)std::min(oParams.nSumDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnTotColorDistThreshold = _mm_set1_epi16((short)std::min(oParams.nTotColorDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnTotDescDistThreshold = _mm_set1_epi16((short)std::min(oParams.nTotDescDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnTotSumDistThreshold = _mm_set1_epi16((short)std::min(oParams.nTotSumDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnSumDistDescShift = _mm_cvtsi32_si128((int)oParams.nSumDistDescShift);
+        const __m128i vnDescToColorScale = _mm_set1_epi16((short)(UCHAR_MAX/LBSP::DESC_SIZE_BITS));
+        const __m128i vnMaxColorDist = _mm_set1_epi16((short)UCHAR_MAX);
+        alignas(16) ushort aanColors[3][nLanes], aanThresholds[3][nLanes], aanDescs[3][nLanes];
+        alignas(16) ushort anTotDescDists[nLanes], anTotSumDists[nLanes];
+        for(size_t nBatchIdx=0; nBatchIdx<nSamples && oRes.nGoodSamples<oParams.nRequiredSamples; nBatchIdx+=nLanes) {
+            const size_t nBatchSize = std::min(nLanes,nSamples-nBatchIdx);
+            gatherSampleBatch(nChannels,anLBSPThresholdLUT,anBGColors+nBatchIdx*nChannels,anBGDescs+nBatchIdx*nChannels,nBatchSize,aanColors,aanThresholds,aanDescs);
+            __m128i vbFailed = _mm_setzero_si128();
+            __m128i vnTotColorDist = _mm_setzero_si128(), vnTotDescDist = _mm_setzero_si128(), vnTotSumDist = _mm_setzero_si128();
+            for(size_t c=0; c<nChannels; ++c) {
+                const __m128i vnBGColor = _mm_load_si128((__m128i*)aanColors[c]);
+                const __m128i vnBGThreshold = _mm_load_si128((__m128i*)aanThresholds[c]);
+                const __m128i vnBGDesc = _mm_load_si128((__m128i*)aanDescs[c]);
+                const __m128i vnColorDist = _mm_abs_epi16(_mm_sub_epi16(vnBGColor,_mm_set1_epi16((short)anCurrColor[c])));
+                // inter-LBSP bits are obtained by thresholding the current lookup values with each sample as reference, and are compared on the fly
+                const uchar* const anLookupVals = aanLBSPLookupVals+c*LBSP::DESC_SIZE_BITS;
+                __m128i vnDescDist = _mm_setzero_si128();
+                for(size_t nBitIdx=0; nBitIdx<LBSP::DESC_SIZE_BITS; ++nBitIdx) {
+                    const __m128i vnBitMask = _mm_set1_epi16((short)(1<<nBitIdx));
+                    const __m128i vbCurrBit = _mm_cmpgt_epi16(_mm_abs_epi16(_mm_sub_epi16(_mm_set1_epi16((short)anLookupVals[nBitIdx]),vnBGColor)),vnBGThreshold);
+                    const __m128i vbBGBit = _mm_cmpeq_epi16(_mm_and_si128(vnBGDesc,vnBitMask),vnBitMask);
+                    vnDescDist = _mm_sub_epi16(vnDescDist,_mm_xor_si128(vbCurrBit,vbBGBit));
+                }
+                if(oParams.bUseIntraDesc)
+                    vnDescDist = _mm_srli_epi16(_mm_add_epi16(vnDescDist,popcount_16ui(_mm_xor_si128(vnBGDesc,_mm_set1_epi16((short)anCurrIntraDesc[c])))),1);
+                const __m128i vnSumDist = _mm_min_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_srl_epi16(vnDescDist,vnSumDistDescShift),vnDescToColorScale),vnColorDist),vnMaxColorDist);
+                vbFailed = _mm_or_si128(vbFailed,_mm_or_si128(_mm_cmpgt_epi16(vnColorDist,vnColorDistThreshold),
+                                                              _mm_or_si128(_mm_cmpgt_epi16(vnDescDist,vnDescDistThreshold),_mm_cmpgt_epi16(vnSumDist,vnSumDistThreshold))));
+                vnTotColorDist = _mm_add_epi16(vnTotColorDist,vnColorDist);
+                vnTotDescDist = _mm_add_epi16(vnTotDescDist,vnDescDist);
+                vnTotSumDist = _mm_add_epi16(vnTotSumDist,vnSumDist);
+            }
+            vbFailed = _mm_or_si128(vbFailed,_mm_or_si128(_mm_cmpgt_epi16(vnTotColorDist,vnTotColorDistThreshold),
+                                                          _mm_or_si128(_mm_cmpgt_epi16(vnTotDescDist,vnTotDescDistThreshold),_mm_cmpgt_epi16(vnTotSumDist,vnTotSumDistThreshold))));
+            const uint32_t nMatchMask = ~(uint32_t)_mm_movemask_epi8(_mm_packs_epi16(vbFailed,_mm_setzero_si128()))&((1u<<nBatchSize)-1);
+            if(nMatchMask) {
+                _mm_store_si128((__m128i*)anTotDescDists,vnTotDescDist);
+                _mm_store_si128((__m128i*)anTotSumDists,vnTotSumDist);
+                accumulateBatch(oParams,nMatchMask,anTotDescDists,anTotSumDists,oRes);
+            }
+        }
+        return oRes;
+    }
+
+#endif //HAVE_SSE4_1
+
+#if HAVE_AVX2
+
+    /// returns the number of set bits in each 16-bit lane of the given register
+    inline __m256i popcount_16ui(const __m256i& anVals) {
+        const __m256i anNibbleLUT = _mm256_setr_epi8(0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4);
+        const __m256i anLowNibbleMask = _mm256_set1_epi8(0x0F);
+        const __m256i anByteCounts = _mm256_add_epi8(_mm256_shuffle_epi8(anNibbleLUT,_mm256_and_si256(anVals,anLowNibbleMask)),
+                                                     _mm256_shuffle_epi8(anNibbleLUT,_mm256_and_si256(_mm256_srli_epi16(anVals,4),anLowNibbleMask)));
+        return _mm256_add_epi16(_mm256_and_si256(anByteCounts,_mm256_set1_epi16(0x00FF)),_mm256_srli_epi16(anByteCounts,8));
+    }
+
+    /// batch scan impl evaluating 16 samples at once in 16-bit lanes
+    LBSPSampleMatcher::Result match_avx2(const LBSPSampleMatcher::Params& oParams, const uchar* anCurrColor, const ushort* anCurrIntraDesc, const uchar* aanLBSPLookupVals,
+                                         const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nSamples) {
+        constexpr size_t nLanes = 16;
+        LBSPSampleMatcher::Result oRes = initMatchResult(oParams);
+        const size_t nChannels = oParams.nChannels;
+        const __m256i vnColorDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nColorDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m256i vnDescDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nDescDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m256i vnSumDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nSumDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m256i vnTotColorDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nTotColorDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m256i vnTotDescDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nTotDescDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m256i vnTotSumDistThreshold = _mm256_set1_epi16((short)std::min(oParams.nTotSumDistThreshold,s_nMaxSIMDDistThreshold));
+        const __m128i vnSumDistDescShift = _mm_cvtsi32_si128((int)oParams.nSumDistDescShift);
+        const __m256i vnDescToColorScale = _mm256_set1_epi16((short)(UCHAR_MAX/LBSP::DESC_SIZE_BITS));
+        const __m256i vnMaxColorDist = _mm256_set1_epi16((short)UCHAR_MAX);
+        alignas(32) ushort aanColors[3][nLanes], aanThresholds[3][nLanes], aanDescs[3][nLanes];
+        alignas(32) ushort anTotDescDists[nLanes], anTotSumDists[nLanes];
+        for(size_t nBatchIdx=0; nBatchIdx<nSamples && oRes.nGoodSamples<oParams.nRequiredSamples; nBatchIdx+=nLanes) {
+            const size_t nBatchSize = std::min(nLanes,nSamples-nBatchIdx);
+            gatherSampleBatch(nChannels,anLBSPThresholdLUT,anBGColors+nBatchIdx*nChannels,anBGDescs+nBatchIdx*nChannels,nBatchSize,aanColors,aanThresholds,aanDescs);
+            __m256i vbFailed = _mm256_setzero_si256();
+            __m256i vnTotColorDist = _mm256_setzero_si256(), vnTotDescDist = _mm256_setzero_si256(), vnTotSumDist = _mm256_setzero_si256();
+            for(size_t c=0; c<nChannels; ++c) {
+                const __m256i vnBGColor = _mm256_load_si256((__m256i*)aanColors[c]);
+                const __m256i vnBGThreshold = _mm256_load_si256((__m256i*)aanThresholds[c]);
+                const __m256i vnBGDesc = _mm256_load_si256((__m256i*)aanDescs[c]);
+                const __m256i vnColorDist = _mm256_abs_epi16(_mm256_sub_epi16(vnBGColor,_mm256_set1_epi16((short)anCurrColor[c])));
+                // inter-LBSP bits are obtained by thresholding the current lookup values with each sample as reference, and are compared on the fly
+                const uchar* const anLookupVals = aanLBSPLookupVals+c*LBSP::DESC_SIZE_BITS;
+                __m256i vnDescDist = _mm256_setzero_si256();
+                for(size_t nBitIdx=0; nBitIdx<LBSP::DESC_SIZE_BITS; ++nBitIdx) {
+                    const __m256i vnBitMask = _mm256_set1_epi16((short)(1<<nBitIdx));
+                    const __m256i vbCurrBit = _mm256_cmpgt_epi16(_mm256_abs_epi16(_mm256_sub_epi16(_mm256_set1_epi16((short)anLookupVals[nBitIdx]),vnBGColor)),vnBGThreshold);
+                    const __m256i vbBGBit = _mm256_cmpeq_epi16(_mm256_and_si256(vnBGDesc,vnBitMask),vnBitMask);
+                    vnDescDist = _mm256_sub_epi16(vnDescDist,_mm256_xor_si256(vbCurrBit,vbBGBit));
+                }
+                if(oParams.bUseIntraDesc)
+                    vnDescDist = _mm256_srli_epi16(_mm256_add_epi16(vnDescDist,popcount_16ui(_mm256_xor_si256(vnBGDesc,_mm256_set1_epi16((short)anCurrIntraDesc[c])))),1);
+                const __m256i vnSumDist = _mm256_min_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_srl_epi16(vnDescDist,vnSumDistDescShift),vnDescToColorScale),vnColorDist),vnMaxColorDist);
+                vbFailed = _mm256_or_si256(vbFailed,_mm256_or_si256(_mm256_cmpgt_epi16(vnColorDist,vnColorDistThreshold),
+                                                                    _mm256_or_si256(_mm256_cmpgt_epi16(vnDescDist,vnDescDistThreshold),_mm256_cmpgt_epi16(vnSumDist,vnSumDistThreshold))));
+                vnTotColorDist = _mm256_add_epi16(vnTotColorDist,vnColorDist);
+                vnTotDescDist = _mm256_add_epi16(vnTotDescDist,vnDescDist);
+                vnTotSumDist = _mm256_add_epi16(vnTotSumDist,vnSumDist);
+            }
+            vbFailed = _mm256_or_si256(vbFailed,_mm256_or_si256(_mm256_cmpgt_epi16(vnTotColorDist,vnTotColorDistThreshold),
+                                                                _mm256_or_si256(_mm256_cmpgt_epi16(vnTotDescDist,vnTotDescDistThreshold),_mm256_cmpgt_epi16(vnTotSumDist,vnTotSumDistThreshold))));
+            // 256-bit packs work per 128-bit lane, so halves are packed via SSE to keep the sample order in the final bitmask
+            const __m128i vbFailedPacked = _mm_packs_epi16(_mm256_castsi256_si128(vbFailed),_mm256_extracti128_si256(vbFailed,1));
+            const uint32_t nMatchMask = ~(uint32_t)_mm_movemask_epi8(vbFailedPacked)&((1u<<nBatchSize)-1);
+            if(nMatchMask) {
+                _mm256_store_si256((__m256i*)anTotDescDists,vnTotDescDist);
+                _mm256_store_si256((__m256i*)anTotSumDists,vnTotSumDist);
+                accumulateBatch(oParams,nMatchMask,anTotDescDists,anTotSumDists,oRes);
+            }
+        }
+        return oRes;
+    }
+
+#endif //HAVE_AVX2
+
+} // anonymous namespace
+
+LBSPSampleMatcher::LBSPSampleMatcher() :
+        LBSPSampleMatcher(lv::getBestSIMDInstrSet()) {}
+
+LBSPSampleMatcher::LBSPSampleMatcher(lv::SIMDInstrSet eInstrSet) :
+        m_eInstrSet((eInstrSet>=lv::SIMD_AVX2 && lv::isSIMDSupported(lv::SIMD_AVX2))?lv::SIMD_AVX2:
+                    (eInstrSet>=lv::SIMD_SSE4_1 && lv::isSIMDSupported(lv::SIMD_SSE4_1))?lv::SIMD_SSE4_1:
+                    lv::SIMD_None) {}
+
+LBSPSampleMatcher::Result LBSPSampleMatcher::match(const Params& oParams, const uchar* anCurrColor, const ushort* anCurrIntraDesc, const uchar* aanLBSPLookupVals,
+                                                   const uchar* anLBSPThresholdLUT, const uchar* anBGColors, const ushort* anBGDescs, size_t nSamples) const {
+    static_assert(LBSP::DESC_SIZE_BITS==16,"vectorized impls assume 16-bit descriptors");
+    lvDbgAssert_(oParams.nChannels==1 || oParams.nChannels==3,"sample matcher only supports 1- and 3-channel samples");
+    lvDbgAssert_(anCurrColor && aanLBSPLookupVals && anLBSPThresholdLUT && anBGColors && anBGDescs,"need to provide valid data pointers");
+    lvDbgAssert_(anCurrIntraDesc || !oParams.bUseIntraDesc,"need to provide current intra-LBSP descriptors if they are used for matching");
+    lvDbgAssert_(((uintptr_t)aanLBSPLookupVals&15)==0,"lookup values must be 16-byte aligned");
+#if HAVE_AVX2
+    if(m_eInstrSet==lv::SIMD_AVX2)
+        return match_avx2(oParams,anCurrColor,anCurrIntraDesc,aanLBSPLookupVals,anLBSPThresholdLUT,anBGColors,anBGDescs,nSamples);
+#endif //HAVE_AVX2
+#if HAVE_SSE4_1
+    if(m_eInstrSet==lv::SIMD_SSE4_1)
+        return match_sse41(oParams,anCurrColor,anCurrIntraDesc,aanLBSPLookupVals,anLBSPThresholdLUT,anBGColors,anBGDescs,nSamples);
+#endif //HAVE_SSE4_1
+    return match_scalar(oParams,anCurrColor,anCurrIntraDesc,aanLBSPLookupVals,anLBSPThresholdLUT,anBGColors,anBGDescs,nSamples);
+}
+
 template<lv::ParallelAlgoType eImpl>
 void IBackgroundSubtractorLBSP_<eImpl>::initialize_common(const cv::Mat& oInitImg, const cv::Mat& oROI) {
     lvDbgExceptionWatch;
@@ -64,6 +430,26 @@ void IBackgroundSubtractorLBSP_<eImpl>::initialize_common(const cv::Mat& oInitIm
     }
 }
 
+template<lv::ParallelAlgoType eImpl>
+lv::MatArchiveList IBackgroundSubtractorLBSP_<eImpl>::save_common(std::ostream& oStream, const std::string& sAlgoName, bool bUseCompression) const {
+    const lv::MatArchiveList eArchiveType = IIBackgroundSubtractor::save_common(oStream,sAlgoName,bUseCompression);
+    IIBackgroundSubtractor::writeSnapshotValue(oStream,(uint64_t)m_nLBSPThresholdOffset);
+    IIBackgroundSubtractor::writeSnapshotValue(oStream,m_fRelLBSPThreshold);
+    IIBackgroundSubtractor::writeSnapshotValue(oStream,m_anLBSPThreshold_8bitLUT); // adjusted over time by some impls
+    lv::write(oStream,m_oLastDescFrame,eArchiveType);
+    return eArchiveType;
+}
+
+template<lv::ParallelAlgoType eImpl>
+lv::MatArchiveList IBackgroundSubtractorLBSP_<eImpl>::load_common(std::istream& oStream, const std::string& sAlgoName) {
+    const lv::MatArchiveList eArchiveType = IIBackgroundSubtractor::load_common(oStream,sAlgoName);
+    lvAssert_(IIBackgroundSubtractor::readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nLBSPThresholdOffset,"model snapshot LBSP threshold offset mismatch");
+    lvAssert_(IIBackgroundSubtractor::readSnapshotValue<float>(oStream)==m_fRelLBSPThreshold,"model snapshot LBSP relative threshold mismatch");
+    m_anLBSPThreshold_8bitLUT = IIBackgroundSubtractor::readSnapshotValue<std::array<uchar,UCHAR_MAX+1>>(oStream);
+    IIBackgroundSubtractor::readSnapshotMat(oStream,m_oLastDescFrame,eArchiveType);
+    return eArchiveType;
+}
+
 #if HAVE_GLSL
 
 template<>
@@ -49,7 +49,7 @@ void BackgroundSubtractorLOBSTER_GLSL::refreshModel(float fSamplesRefreshFrac, b
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?lv::fastrand(m_nRandState)%m_nBGSamples:0;
     if(!bForceFGUpdate)
         getLatestForegroundMask(m_oLastFGMask);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_BGModelBinding));
@@ -62,7 +62,7 @@ void BackgroundSubtractorLOBSTER_GLSL::refreshModel(float fSamplesRefreshFrac, b
             if(bForceFGUpdate || !m_oLastFGMask.data[nColOffset]) {
                 for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
                     int nSampleRowIdx, nSampleColIdx;
-                    lv::getSamplePosition_7x7_std2(rand(),nSampleColIdx,nSampleRowIdx,(int)nColIdx,(int)nRowIdx,(int)LBSP::PATCH_SIZE/2,m_oFrameSize);
+                    lv::getSamplePosition_7x7_std2(lv::fastrand(m_nRandState),nSampleColIdx,nSampleRowIdx,(int)nColIdx,(int)nRowIdx,(int)LBSP::PATCH_SIZE/2,m_oFrameSize);
                     const size_t nSamplePxIdx = nSampleColIdx + nSampleRowIdx*m_oFrameSize.width;
                     if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
                         const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
@@ -110,7 +110,7 @@ void BackgroundSubtractorLOBSTER_GLSL::initialize_gl(const cv::Mat& oInitImg, co
     const int nMaxSSBOBlockSize = lv::gl::getIntegerVal<1>(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
     lvAssert_(nMaxSSBOBlockSize>(int)(m_nBGModelSize*sizeof(uint)) && nMaxSSBOBlockSize>(int)(m_nTMT32ModelSize*sizeof(lv::gl::TMT32GenParams)),"max ssbo block size is tool small for the predicted model size");
     m_vnBGModelData.resize(m_nBGModelSize,0);
-    lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData);
+    lv::gl::TMT32GenParams::initTinyMT32Generators(glm::uvec3(uint(m_oROI.cols),uint(m_oROI.rows),1),m_voTMT32ModelData,m_nRandSeed);
     m_bInitialized = true;
     GLImageProcAlgo::initialize_gl(oInitImg,m_oROI);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER,getSSBOId(BackgroundSubtractorLOBSTER_::LOBSTERStorageBuffer_TMT32ModelBinding));
@@ -407,31 +407,39 @@ template struct BackgroundSubtractorLOBSTER_<lv::GLSL>;
 //template struct BackgroundSubtractorLOBSTER_<lv::OpenCL>;
 #endif //HAVE_OPENCL
 
+BackgroundSubtractorLOBSTER::BackgroundSubtractorLOBSTER_(size_t nDescDistThreshold, size_t nColorDistThreshold, size_t nBGSamples,
+                                                          size_t nRequiredBGSamples, size_t nLBSPThresholdOffset, float fRelLBSPThreshold,
+                                                          bool bUsePxMajorModel) :
+        IBackgroundSubtractorLOBSTER(nDescDistThreshold,nColorDistThreshold,nBGSamples,nRequiredBGSamples,nLBSPThresholdOffset,fRelLBSPThreshold),
+        m_bUsePxMajorModel(bUsePxMajorModel) {}
+
 void BackgroundSubtractorLOBSTER::refreshModel(float fSamplesRefreshFrac, bool bForceFGUpdate) {
     lvDbgExceptionWatch;
     // == refresh
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?lv::fastrand(m_nRandState)%m_nBGSamples:0;
     for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
         const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
         if(bForceFGUpdate || !m_oLastFGMask.data[nPxIter]) {
             for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
                 int nSampleImgCoord_Y, nSampleImgCoord_X;
-                lv::getSamplePosition_7x7_std2(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                lv::getSamplePosition_7x7_std2(lv::fastrand(m_nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                 const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
                 if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
                     const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
+                    uchar* const anBGColor = m_oBGSamples.color(nCurrRealModelSampleIdx,nPxIter);
+                    ushort* const anBGDesc = m_oBGSamples.desc(nCurrRealModelSampleIdx,nPxIter);
                     for(size_t c=0; c<m_nImgChannels; ++c) {
-                        m_voBGColorSamples[nCurrRealModelSampleIdx].data[nPxIter*m_nImgChannels+c] = m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c];
+                        anBGColor[c] = m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c];
                         if(m_nImgChannels==1)
                             LBSP::computeDescriptor<1>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,0,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
                         else if(m_nImgChannels==3)
                             LBSP::computeDescriptor<3>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,c,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
                         else //m_nImgChannels==4
                             LBSP::computeDescriptor<4>(m_oLastColorFrame,m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c],nSampleImgCoord_X,nSampleImgCoord_Y,c,m_anLBSPThreshold_8bitLUT[m_oLastColorFrame.data[nSamplePxIdx*m_nImgChannels+c]],*((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2)));
-                        *((ushort*)(m_voBGDescSamples[nCurrRealModelSampleIdx].data+(nPxIter*m_nImgChannels+c)*2)) = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2));
+                        anBGDesc[c] = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*m_nImgChannels+c)*2));
                     }
                 }
             }
@@ -443,14 +451,7 @@ void BackgroundSubtractorLOBSTER::initialize(const cv::Mat& oInitImg, const cv::
     lvDbgExceptionWatch;
     // == init
     IBackgroundSubtractorLBSP::initialize_common(oInitImg,oROI);
-    m_voBGColorSamples.resize(m_nBGSamples);
-    m_voBGDescSamples.resize(m_nBGSamples);
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        m_voBGColorSamples[s].create(m_oImgSize,CV_8UC((int)m_nImgChannels));
-        m_voBGColorSamples[s] = cv::Scalar_<uchar>::all(0);
-        m_voBGDescSamples[s].create(m_oImgSize,CV_16UC((int)m_nImgChannels));
-        m_voBGDescSamples[s] = cv::Scalar_<ushort>::all(0);
-    }
+    m_oBGSamples.create(m_oImgSize,m_nImgChannels,m_nBGSamples,m_bUsePxMajorModel);
     m_bInitialized = true;
     refreshModel(1.0f,true);
     m_bModelInitialized = true;
@@ -468,47 +469,58 @@ void BackgroundSubtractorLOBSTER::apply(cv::InputArray _oInputImg, cv::OutputArr
     cv::Mat oCurrFGMask = _oFGMask.getMat();
     oCurrFGMask = cv::Scalar_<uchar>(0);
     const size_t nLearningRate = std::isinf(dLearningRate)?SIZE_MAX:(size_t)ceil(dLearningRate);
+    int nRandState = m_nRandState;
     if(m_nImgChannels==1) {
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nDescIter = nPxIter*2;
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
             const uchar nCurrColor = oInputImg.data[nPxIter];
             alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
             LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
-            size_t nGoodSamplesCount=0, nModelIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
-                const uchar nBGColor = m_voBGColorSamples[nModelIdx].data[nPxIter];
-                {
-                    const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
-                    if(nColorDist>m_nColorDistThreshold/2)
-                        goto failedcheck1ch;
-                    const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
-                    const size_t nDescDist = lv::hdist(nCurrInputDesc,*((ushort*)(m_voBGDescSamples[nModelIdx].data+nDescIter)));
-                    if(nDescDist>m_nDescDistThreshold)
-                        goto failedcheck1ch;
-                    nGoodSamplesCount++;
+            size_t nGoodSamplesCount=0;
+            if(m_oBGSamples.isPxMajor()) {
+                const LBSPSampleMatcher::Params oMatchParams = {1,m_nRequiredBGSamples,false,0,
+                                                                m_nColorDistThreshold/2,m_nDescDistThreshold,SIZE_MAX,
+                                                                SIZE_MAX,SIZE_MAX,SIZE_MAX};
+                nGoodSamplesCount = m_oSampleMatcher.match(oMatchParams,&nCurrColor,nullptr,anLBSPLookupVals.data(),m_anLBSPThreshold_8bitLUT.data(),
+                                                           m_oBGSamples.color(0,nPxIter),m_oBGSamples.desc(0,nPxIter),m_nBGSamples).nGoodSamples;
+            }
+            else {
+                size_t nModelIdx=0;
+                while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
+                    const uchar nBGColor = *m_oBGSamples.color(nModelIdx,nPxIter);
+                    {
+                        const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
+                        if(nColorDist>m_nColorDistThreshold/2)
+                            goto failedcheck1ch;
+                        const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
+                        const size_t nDescDist = lv::hdist(nCurrInputDesc,*m_oBGSamples.desc(nModelIdx,nPxIter));
+                        if(nDescDist>m_nDescDistThreshold)
+                            goto failedcheck1ch;
+                        nGoodSamplesCount++;
+                    }
+                    failedcheck1ch:
+                    nModelIdx++;
                 }
-                failedcheck1ch:
-                nModelIdx++;
             }
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
             else {
-                if((rand()%nLearningRate)==0) {
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort& nRandInputDesc = *((ushort*)(m_voBGDescSamples[nSampleModelIdx].data+nDescIter));
+                if(lv::fastrand_odds(nRandState,nLearningRate)) {
+                    const size_t nSampleModelIdx = lv::fastrand(nRandState)%m_nBGSamples;
+                    ushort& nRandInputDesc = *m_oBGSamples.desc(nSampleModelIdx,nPxIter);
                     nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-                    m_voBGColorSamples[nSampleModelIdx].data[nPxIter] = nCurrColor;
+                    *m_oBGSamples.color(nSampleModelIdx,nPxIter) = nCurrColor;
                 }
-                if((rand()%nLearningRate)==0) {
+                if(lv::fastrand_odds(nRandState,nLearningRate)) {
                     int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort& nRandInputDesc = m_voBGDescSamples[nSampleModelIdx].at<ushort>(nSampleImgCoord_Y,nSampleImgCoord_X);
+                    lv::getNeighborPosition_3x3(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    const size_t nSampleModelIdx = lv::fastrand(nRandState)%m_nBGSamples;
+                    const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    ushort& nRandInputDesc = *m_oBGSamples.desc(nSampleModelIdx,nSamplePxIdx);
                     nRandInputDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-                    m_voBGColorSamples[nSampleModelIdx].at<uchar>(nSampleImgCoord_Y,nSampleImgCoord_X) = nCurrColor;
+                    *m_oBGSamples.color(nSampleModelIdx,nSamplePxIdx) = nCurrColor;
                 }
             }
         }
@@ -518,63 +530,74 @@ void BackgroundSubtractorLOBSTER::apply(cv::InputArray _oInputImg, cv::OutputArr
         const size_t nCurrColorDistThreshold = m_nColorDistThreshold*3;
         const size_t nCurrSCDescDistThreshold = nCurrDescDistThreshold/2;
         const size_t nCurrSCColorDistThreshold = nCurrColorDistThreshold/2;
-        const size_t desc_row_step = m_voBGDescSamples[0].step.p[0];
-        const size_t img_row_step = m_voBGColorSamples[0].step.p[0];
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
             const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
             const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
             const size_t nPxIterRGB = nPxIter*3;
-            const size_t nDescIterRGB = nPxIterRGB*2;
             const uchar* const anCurrColor = oInputImg.data+nPxIterRGB;
             alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
             LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
-            size_t nGoodSamplesCount=0, nModelIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
-                const ushort* const anBGDesc = (ushort*)(m_voBGDescSamples[nModelIdx].data+nDescIterRGB);
-                const uchar* const anBGColor = m_voBGColorSamples[nModelIdx].data+nPxIterRGB;
-                size_t nTotColorDist = 0;
-                size_t nTotDescDist = 0;
-                for(size_t c=0;c<3; ++c) {
-                    const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
-                    if(nColorDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
-                    const size_t nDescDist = lv::hdist(nCurrInputDesc,anBGDesc[c]);
-                    if(nDescDist>nCurrSCDescDistThreshold)
-                        goto failedcheck3ch;
-                    nTotColorDist += nColorDist;
-                    nTotDescDist += nDescDist;
+            size_t nGoodSamplesCount=0;
+            if(m_oBGSamples.isPxMajor()) {
+                const LBSPSampleMatcher::Params oMatchParams = {3,m_nRequiredBGSamples,false,0,
+                                                                nCurrSCColorDistThreshold,nCurrSCDescDistThreshold,SIZE_MAX,
+                                                                nCurrColorDistThreshold,nCurrDescDistThreshold,SIZE_MAX};
+                nGoodSamplesCount = m_oSampleMatcher.match(oMatchParams,anCurrColor,nullptr,aanLBSPLookupVals[0].data(),m_anLBSPThreshold_8bitLUT.data(),
+                                                           m_oBGSamples.color(0,nPxIter),m_oBGSamples.desc(0,nPxIter),m_nBGSamples).nGoodSamples;
+            }
+            else {
+                size_t nModelIdx=0;
+                while(nGoodSamplesCount<m_nRequiredBGSamples && nModelIdx<m_nBGSamples) {
+                    const ushort* const anBGDesc = m_oBGSamples.desc(nModelIdx,nPxIter);
+                    const uchar* const anBGColor = m_oBGSamples.color(nModelIdx,nPxIter);
+                    size_t nTotColorDist = 0;
+                    size_t nTotDescDist = 0;
+                    for(size_t c=0;c<3; ++c) {
+                        const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
+                        if(nColorDist>nCurrSCColorDistThreshold)
+                            goto failedcheck3ch;
+                        const ushort nCurrInputDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
+                        const size_t nDescDist = lv::hdist(nCurrInputDesc,anBGDesc[c]);
+                        if(nDescDist>nCurrSCDescDistThreshold)
+                            goto failedcheck3ch;
+                        nTotColorDist += nColorDist;
+                        nTotDescDist += nDescDist;
+                    }
+                    if(nTotDescDist<=nCurrDescDistThreshold && nTotColorDist<=nCurrColorDistThreshold)
+                        nGoodSamplesCount++;
+                    failedcheck3ch:
+                    nModelIdx++;
                 }
-                if(nTotDescDist<=nCurrDescDistThreshold && nTotColorDist<=nCurrColorDistThreshold)
-                    nGoodSamplesCount++;
-                failedcheck3ch:
-                nModelIdx++;
             }
             if(nGoodSamplesCount<m_nRequiredBGSamples)
                 oCurrFGMask.data[nPxIter] = UCHAR_MAX;
             else {
-                if((rand()%nLearningRate)==0) {
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort* anRandInputDesc = ((ushort*)(m_voBGDescSamples[nSampleModelIdx].data+nDescIterRGB));
+                if(lv::fastrand_odds(nRandState,nLearningRate)) {
+                    const size_t nSampleModelIdx = lv::fastrand(nRandState)%m_nBGSamples;
+                    ushort* anRandInputDesc = m_oBGSamples.desc(nSampleModelIdx,nPxIter);
+                    uchar* anRandInputColor = m_oBGSamples.color(nSampleModelIdx,nPxIter);
                     for(size_t c=0; c<3; ++c) {
-                        *(m_voBGColorSamples[nSampleModelIdx].data+nPxIterRGB+c) = anCurrColor[c];
+                        anRandInputColor[c] = anCurrColor[c];
                         anRandInputDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
                     }
                 }
-                if((rand()%nLearningRate)==0) {
+                if(lv::fastrand_odds(nRandState,nLearningRate)) {
                     int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                    const size_t nSampleModelIdx = rand()%m_nBGSamples;
-                    ushort* anRandInputDesc = ((ushort*)(m_voBGDescSamples[nSampleModelIdx].data + desc_row_step*nSampleImgCoord_Y + 6*nSampleImgCoord_X));
+                    lv::getNeighborPosition_3x3(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    const size_t nSampleModelIdx = lv::fastrand(nRandState)%m_nBGSamples;
+                    const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    ushort* anRandInputDesc = m_oBGSamples.desc(nSampleModelIdx,nSamplePxIdx);
+                    uchar* anRandInputColor = m_oBGSamples.color(nSampleModelIdx,nSamplePxIdx);
                     for(size_t c=0; c<3; ++c) {
-                        *(m_voBGColorSamples[nSampleModelIdx].data+img_row_step*nSampleImgCoord_Y+3*nSampleImgCoord_X+c) = anCurrColor[c];
+                        anRandInputColor[c] = anCurrColor[c];
                         anRandInputDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
                     }
                 }
             }
         }
     }
+    m_nRandState = nRandState;
     cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nDefaultMedianBlurKernelSize);
     m_oLastFGMask.copyTo(oCurrFGMask);
     oInputImg.copyTo(m_oLastColorFrame);
@@ -583,40 +606,33 @@ void BackgroundSubtractorLOBSTER::apply(cv::InputArray _oInputImg, cv::OutputArr
 void BackgroundSubtractorLOBSTER::getBackgroundImage(cv::OutputArray oBGImg) const {
     lvDbgExceptionWatch;
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_nimg = m_voBGColorSamples[s].step.p[0]*y + m_voBGColorSamples[s].step.p[1]*x;
-                const size_t idx_flt32 = idx_nimg*4;
-                float* oAvgBgImgPtr = (float*)(oAvgBGImg.data+idx_flt32);
-                const uchar* const oBGImgPtr = m_voBGColorSamples[s].data+idx_nimg;
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgImgPtr[c] += ((float)oBGImgPtr[c])/m_nBGSamples;
-            }
-        }
-    }
-    oAvgBGImg.convertTo(oBGImg,CV_8U);
+    m_oBGSamples.getAvgColorImage(oBGImg);
 }
 
 void BackgroundSubtractorLOBSTER::getBackgroundDescriptorsImage(cv::OutputArray oBGDescImg) const {
-    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
     lvDbgExceptionWatch;
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGDesc = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t n=0; n<m_voBGDescSamples.size(); ++n) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_ndesc = m_voBGDescSamples[n].step.p[0]*y + m_voBGDescSamples[n].step.p[1]*x;
-                const size_t idx_flt32 = idx_ndesc*2;
-                float* oAvgBgDescPtr = (float*)(oAvgBGDesc.data+idx_flt32);
-                const ushort* const oBGDescPtr = (ushort*)(m_voBGDescSamples[n].data+idx_ndesc);
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgDescPtr[c] += ((float)oBGDescPtr[c])/m_voBGDescSamples.size();
-            }
-        }
-    }
-    oAvgBGDesc.convertTo(oBGDescImg,CV_16U);
+    m_oBGSamples.getAvgDescImage(oBGDescImg);
+}
+
+void BackgroundSubtractorLOBSTER::save(std::ostream& oStream, bool bUseCompression) const {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::save_common(oStream,"LOBSTER",bUseCompression);
+    writeSnapshotValue(oStream,(uint64_t)m_nColorDistThreshold);
+    writeSnapshotValue(oStream,(uint64_t)m_nDescDistThreshold);
+    writeSnapshotValue(oStream,(uint64_t)m_nBGSamples);
+    writeSnapshotValue(oStream,(uint64_t)m_nRequiredBGSamples);
+    m_oBGSamples.write(oStream,eArchiveType);
+}
+
+void BackgroundSubtractorLOBSTER::load(std::istream& oStream) {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::load_common(oStream,"LOBSTER");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nColorDistThreshold,"model snapshot color dist threshold mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nDescDistThreshold,"model snapshot desc dist threshold mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nBGSamples,"model snapshot sample count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nRequiredBGSamples,"model snapshot required sample count mismatch");
+    m_oBGSamples.read(oStream,eArchiveType);
 }
 
 template struct BackgroundSubtractorLOBSTER_<lv::NonParallel>;
@@ -83,6 +83,52 @@ static const size_t s_nDescMaxDataRange_1ch = LBSP::DESC_SIZE_BITS;
 static const size_t s_nColorMaxDataRange_3ch = s_nColorMaxDataRange_1ch*3;
 static const size_t s_nDescMaxDataRange_3ch = s_nDescMaxDataRange_1ch*3;
 
+static const ushort s_nEmptyWordIdx = USHRT_MAX;
+
+namespace {
+
+    /// restores the weight-descending order of a local word dictionary slice based on its cached weights (which are permuted along, as are the
+    /// optional debug strings); only the first 'nDirtyWords' weights and the last one may have changed since the last sort, so only these are bubbled
+    void sortLocalWordDict(ushort* anLocalWordDict, float* afLocalWordWeights, size_t nLocalWords, size_t nDirtyWords, std::string* asWordModList=nullptr) {
+        for(size_t nLocalWordIdx=1; nLocalWordIdx<nLocalWords; ++nLocalWordIdx) {
+            // past the dirty entries, once an entry is in place, all others up to the last one are as well (they are still sorted between them)
+            if(nLocalWordIdx>=nDirtyWords && nLocalWordIdx<nLocalWords-1 && afLocalWordWeights[nLocalWordIdx]<=afLocalWordWeights[nLocalWordIdx-1])
+                nLocalWordIdx = nLocalWords-1;
+            for(size_t nSortedLocalWordIdx=nLocalWordIdx; nSortedLocalWordIdx>0 && afLocalWordWeights[nSortedLocalWordIdx]>afLocalWordWeights[nSortedLocalWordIdx-1]; --nSortedLocalWordIdx) {
+                std::swap(afLocalWordWeights[nSortedLocalWordIdx],afLocalWordWeights[nSortedLocalWordIdx-1]);
+                std::swap(anLocalWordDict[nSortedLocalWordIdx],anLocalWordDict[nSortedLocalWordIdx-1]);
+                if(asWordModList)
+                    std::swap(asWordModList[nSortedLocalWordIdx],asWordModList[nSortedLocalWordIdx-1]);
+            }
+        }
+    }
+
+    /// writes a word dictionary (or sort LUT) to a model snapshot as a single-row matrix
+    void writeWordIndices(std::ostream& oStream, const std::vector<ushort>& vnDict, lv::MatArchiveList eArchiveType) {
+        lv::write(oStream,cv::Mat(1,(int)vnDict.size(),CV_16UC1,(void*)vnDict.data()),eArchiveType);
+    }
+
+    /// reads a word dictionary (or sort LUT) from a model snapshot, making sure each of its 'nWordCount'-sized slices is a full permutation of pool indices
+    void readWordIndices(std::istream& oStream, std::vector<ushort>& vnDict, size_t nWordCount, lv::MatArchiveList eArchiveType) {
+        cv::Mat oIndices;
+        lv::read(oStream,oIndices,eArchiveType);
+        lvAssert_(oIndices.type()==CV_16UC1 && oIndices.total()==vnDict.size(),"bad model snapshot word dictionary size");
+        lvAssert_(nWordCount>0 && (vnDict.size()%nWordCount)==0,"bad model snapshot word dictionary stride");
+        std::vector<bool> vbWordSeen(nWordCount);
+        for(size_t nSliceIdx=0; nSliceIdx<vnDict.size(); nSliceIdx+=nWordCount) {
+            std::fill(vbWordSeen.begin(),vbWordSeen.end(),false);
+            for(size_t nDictIdx=nSliceIdx; nDictIdx<nSliceIdx+nWordCount; ++nDictIdx) {
+                // empty or duplicated slots are never produced by a (refreshed) model, and would be dereferenced as-is by 'apply'
+                const ushort nWordIdx = ((const ushort*)oIndices.data)[nDictIdx];
+                lvAssert_(nWordIdx<nWordCount && !vbWordSeen[nWordIdx],"bad model snapshot word index");
+                vbWordSeen[nWordIdx] = true;
+                vnDict[nDictIdx] = nWordIdx;
+            }
+        }
+    }
+
+} // anonymous namespace
+
 BackgroundSubtractorPAWCS::BackgroundSubtractorPAWCS_(size_t nDescDistThresholdOffset, size_t nMinColorDistThreshold,
                                                       size_t nMaxNbWords, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold) :
         IBackgroundSubtractorLBSP(fRelLBSPThreshold),
@@ -96,12 +142,9 @@ BackgroundSubtractorPAWCS::BackgroundSubtractorPAWCS_(size_t nDescDistThresholdO
         m_fLastNonFlatRegionRatio(0.0f),
         m_nMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize),
         m_nDownSampledROIPxCount(0),
-        m_nLocalWordWeightOffset(DEFAULT_LWORD_WEIGHT_OFFSET),
-        m_pLocalWordListIter_1ch(m_voLocalWordList_1ch.end()),
-        m_pLocalWordListIter_3ch(m_voLocalWordList_3ch.end()),
-        m_pGlobalWordListIter_1ch(m_voGlobalWordList_1ch.end()),
-        m_pGlobalWordListIter_3ch(m_voGlobalWordList_3ch.end()) {
+        m_nLocalWordWeightOffset(DEFAULT_LWORD_WEIGHT_OFFSET) {
     lvAssert_(m_nMaxLocalWords>0 && m_nMaxGlobalWords>0,"max local/global word counts must be positive");
+    lvAssert_(m_nMaxLocalWords<s_nEmptyWordIdx,"max local word count must fit in 16-bit dictionary indices");
 }
 
 void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDecrFrac, bool bForceFGUpdate) {
@@ -113,6 +156,9 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
             if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nPxIter]) {
                 const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+                ushort* const anLocalWordDict = m_vnLocalWordDict.data()+nLocalDictIdx;
+                float* const afLocalWordWeights = m_vfLocalWordWeights.data()+nLocalDictIdx;
+                LocalWord_1ch* const aLocalWords = m_voLocalWordList_1ch.data()+nLocalDictIdx;
                 const size_t nFloatIter = nPxIter*4;
                 uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
                 const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
@@ -121,17 +167,23 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                 // == refresh: local decr
                 if(fOccDecrFrac>0.0f) {
                     for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                        LocalWord_1ch* pCurrLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                        if(pCurrLocalWord)
-                            pCurrLocalWord->nOccurrences -= (size_t)(fOccDecrFrac*pCurrLocalWord->nOccurrences);
+                        if(anLocalWordDict[nLocalWordIdx]!=s_nEmptyWordIdx) {
+                            LocalWord_1ch& oCurrLocalWord = aLocalWords[anLocalWordDict[nLocalWordIdx]];
+                            oCurrLocalWord.nOccurrences -= (size_t)(fOccDecrFrac*oCurrLocalWord.nOccurrences);
+                        }
                     }
                 }
+                // == refresh: local weight caching (empty entries get a negative weight so they always sort last)
+                for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx)
+                    afLocalWordWeights[nLocalWordIdx] = (anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx)?-1.0f:GetLocalWordWeight(aLocalWords[anLocalWordDict[nLocalWordIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
+                // occurrence decrements & neighbor updates may have shuffled the dict since its last sort, and the binary searches below need a sorted prefix
+                sortLocalWordDict(anLocalWordDict,afLocalWordWeights,m_nCurrLocalWords,m_nCurrLocalWords);
                 const size_t nCurrWordOccIncr = DEFAULT_LWORD_OCC_INCR;
                 const size_t nTotLocalSamplingIterCount = 7*7*2;
                 for(size_t nLocalSamplingIter=0; nLocalSamplingIter<nTotLocalSamplingIterCount; ++nLocalSamplingIter) {
                     // == refresh: local resampling
                     int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    lv::getSamplePosition_7x7_std2(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getSamplePosition_7x7_std2(lv::fastrand(m_nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                     const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
                     if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nSamplePxIdx]) {
                         const uchar nSampleColor = m_oLastColorFrame.data[nSamplePxIdx];
@@ -140,7 +192,7 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         bool bFoundUninitd = false;
                         size_t nLocalWordIdx;
                         for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                            LocalWord_1ch* pCurrLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                            LocalWord_1ch* pCurrLocalWord = (anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx)?nullptr:&aLocalWords[anLocalWordDict[nLocalWordIdx]];
                             if(pCurrLocalWord
                                && lv::L1dist(nSampleColor,pCurrLocalWord->oFeature.anColor[0])<=nCurrColorDistThreshold
                                && lv::hdist(nSampleIntraDesc,pCurrLocalWord->oFeature.anDesc[0])<=nCurrDescDistThreshold) {
@@ -153,39 +205,44 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         }
                         if(nLocalWordIdx==m_nCurrLocalWords) {
                             nLocalWordIdx = m_nCurrLocalWords-1;
-                            LocalWord_1ch& oCurrLocalWord = bFoundUninitd?*m_pLocalWordListIter_1ch++:*(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                            if(bFoundUninitd) // empty entries are always at the end of the dict, and slice words are allocated in order
+                                anLocalWordDict[nLocalWordIdx] = (ushort)(std::find(anLocalWordDict,anLocalWordDict+m_nCurrLocalWords,s_nEmptyWordIdx)-anLocalWordDict);
+                            LocalWord_1ch& oCurrLocalWord = aLocalWords[anLocalWordDict[nLocalWordIdx]];
                             oCurrLocalWord.oFeature.anColor[0] = nSampleColor;
                             oCurrLocalWord.oFeature.anDesc[0] = nSampleIntraDesc;
                             oCurrLocalWord.nOccurrences = nBaseOccCount;
                             oCurrLocalWord.nFirstOcc = m_nFrameIdx;
                             oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                            m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrLocalWord;
-                        }
-                        while(nLocalWordIdx>0 && (!m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1] || GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1],m_nFrameIdx,m_nLocalWordWeightOffset))) {
-                            std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-                            --nLocalWordIdx;
                         }
+                        // entries before the current one are kept in weight-descending order, so we can binary-search its new position
+                        afLocalWordWeights[nLocalWordIdx] = GetLocalWordWeight(aLocalWords[anLocalWordDict[nLocalWordIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        const size_t nSortedLocalWordIdx = std::upper_bound(afLocalWordWeights,afLocalWordWeights+nLocalWordIdx,afLocalWordWeights[nLocalWordIdx],std::greater<float>())-afLocalWordWeights;
+                        std::rotate(anLocalWordDict+nSortedLocalWordIdx,anLocalWordDict+nLocalWordIdx,anLocalWordDict+nLocalWordIdx+1);
+                        std::rotate(afLocalWordWeights+nSortedLocalWordIdx,afLocalWordWeights+nLocalWordIdx,afLocalWordWeights+nLocalWordIdx+1);
                     }
                 }
-                lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
+                lvDbgAssert(anLocalWordDict[0]!=s_nEmptyWordIdx);
                 for(size_t nLocalWordIdx=1; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
                     // == refresh: local random resampling
-                    if(!(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx]) {
-                        const size_t nRandLocalWordIdx = (rand()%nLocalWordIdx);
-                        const LocalWord_1ch& oRefLocalWord = *(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx+nRandLocalWordIdx];
-                        const int nRandColorOffset = (rand()%(nCurrColorDistThreshold+1))-(int)nCurrColorDistThreshold/2;
-                        LocalWord_1ch& oCurrNewLocalWord = *m_pLocalWordListIter_1ch++;
+                    if(anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx) {
+                        const size_t nRandLocalWordIdx = (lv::fastrand(m_nRandState)%nLocalWordIdx);
+                        const LocalWord_1ch& oRefLocalWord = aLocalWords[anLocalWordDict[nRandLocalWordIdx]];
+                        const int nRandColorOffset = (lv::fastrand(m_nRandState)%(nCurrColorDistThreshold+1))-(int)nCurrColorDistThreshold/2;
+                        anLocalWordDict[nLocalWordIdx] = (ushort)nLocalWordIdx; // all previous entries are filled, so this is the next free slice word
+                        LocalWord_1ch& oCurrNewLocalWord = aLocalWords[nLocalWordIdx];
                         oCurrNewLocalWord.oFeature.anColor[0] = cv::saturate_cast<uchar>((int)oRefLocalWord.oFeature.anColor[0]+nRandColorOffset);
                         oCurrNewLocalWord.oFeature.anDesc[0] = oRefLocalWord.oFeature.anDesc[0];
                         oCurrNewLocalWord.nOccurrences = std::max((size_t)(oRefLocalWord.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
                         oCurrNewLocalWord.nFirstOcc = m_nFrameIdx;
                         oCurrNewLocalWord.nLastOcc = m_nFrameIdx;
-                        m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrNewLocalWord;
+                        afLocalWordWeights[nLocalWordIdx] = GetLocalWordWeight(oCurrNewLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                     }
                 }
+                // resampled words do not follow their reference's weight exactly, so the dict might need a final touch-up
+                sortLocalWordDict(anLocalWordDict,afLocalWordWeights,m_nCurrLocalWords,m_nCurrLocalWords);
             }
         }
-        lvDbgAssert(m_voLocalWordList_1ch.end()==m_pLocalWordListIter_1ch);
+        lvDbgAssert(std::find(m_vnLocalWordDict.begin(),m_vnLocalWordDict.end(),s_nEmptyWordIdx)==m_vnLocalWordDict.end());
         cv::Mat oGlobalDictPresenceLookupMap(m_oImgSize,CV_8UC1,cv::Scalar_<uchar>(0));
         size_t nPxIterIncr = std::max(m_nTotPxCount/m_nCurrGlobalWords,(size_t)1);
         for(size_t nSamplingPasses=0; nSamplingPasses<GWORD_DEFAULT_NB_INIT_SAMPL_PASSES; ++nSamplingPasses) {
@@ -201,14 +258,14 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
                         const size_t nCurrColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)/2;
                         const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET);
-                        lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
-                        const LocalWord_1ch& oRefBestLocalWord = *(LocalWord_1ch*)m_vpLocalWordDict[nLocalDictIdx];
+                        lvDbgAssert(m_vnLocalWordDict[nLocalDictIdx]!=s_nEmptyWordIdx);
+                        const LocalWord_1ch& oRefBestLocalWord = m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx]];
                         const float fRefBestLocalWordWeight = GetLocalWordWeight(oRefBestLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                         const uchar nRefBestLocalWordDescBITS = lv::popcount(oRefBestLocalWord.oFeature.anDesc[0]);
                         bool bFoundUninitd = false;
                         size_t nGlobalWordIdx;
                         for(nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
-                            GlobalWord_1ch* pCurrGlobalWord = (GlobalWord_1ch*)m_vpGlobalWordDict[nGlobalWordIdx];
+                            GlobalWord_1ch* pCurrGlobalWord = (m_vnGlobalWordDict[nGlobalWordIdx]==s_nEmptyWordIdx)?nullptr:&m_voGlobalWordList_1ch[m_vnGlobalWordDict[nGlobalWordIdx]];
                             if(pCurrGlobalWord
                                && lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],oRefBestLocalWord.oFeature.anColor[0])<=nCurrColorDistThreshold
                                && lv::L1dist(nRefBestLocalWordDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
@@ -218,23 +275,24 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         }
                         if(nGlobalWordIdx==m_nCurrGlobalWords) {
                             nGlobalWordIdx = m_nCurrGlobalWords-1;
-                            GlobalWord_1ch& oCurrGlobalWord = bFoundUninitd?*m_pGlobalWordListIter_1ch++:*(GlobalWord_1ch*)m_vpGlobalWordDict[nGlobalWordIdx];
+                            if(bFoundUninitd) // empty entries are always at the end of the dict, and pool words are allocated in order
+                                m_vnGlobalWordDict[nGlobalWordIdx] = (ushort)(std::find(m_vnGlobalWordDict.begin(),m_vnGlobalWordDict.end(),s_nEmptyWordIdx)-m_vnGlobalWordDict.begin());
+                            GlobalWord_1ch& oCurrGlobalWord = m_voGlobalWordList_1ch[m_vnGlobalWordDict[nGlobalWordIdx]];
                             oCurrGlobalWord.oFeature.anColor[0] = oRefBestLocalWord.oFeature.anColor[0];
                             oCurrGlobalWord.oFeature.anDesc[0] = oRefBestLocalWord.oFeature.anDesc[0];
                             oCurrGlobalWord.nDescBITS = nRefBestLocalWordDescBITS;
-                            oCurrGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                             oCurrGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                             oCurrGlobalWord.fLatestWeight = 0.0f;
-                            m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrGlobalWord;
                         }
-                        float& fCurrGlobalWordLocalWeight = *(float*)(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+                        GlobalWordBase& oCurrGlobalWord = getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx]);
+                        float& fCurrGlobalWordLocalWeight = *(float*)(oCurrGlobalWord.oSpatioOccMap.data+nGlobalWordMapLookupIdx);
                         if(fCurrGlobalWordLocalWeight<fRefBestLocalWordWeight) {
-                            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight += fRefBestLocalWordWeight;
+                            oCurrGlobalWord.fLatestWeight += fRefBestLocalWordWeight;
                             fCurrGlobalWordLocalWeight += fRefBestLocalWordWeight;
                         }
                         oGlobalDictPresenceLookupMap.data[nPxIter] = UCHAR_MAX;
-                        while(nGlobalWordIdx>0 && (!m_vpGlobalWordDict[nGlobalWordIdx-1] || m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>m_vpGlobalWordDict[nGlobalWordIdx-1]->fLatestWeight)) {
-                            std::swap(m_vpGlobalWordDict[nGlobalWordIdx],m_vpGlobalWordDict[nGlobalWordIdx-1]);
+                        while(nGlobalWordIdx>0 && (m_vnGlobalWordDict[nGlobalWordIdx-1]==s_nEmptyWordIdx || getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx]).fLatestWeight>getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx-1]).fLatestWeight)) {
+                            std::swap(m_vnGlobalWordDict[nGlobalWordIdx],m_vnGlobalWordDict[nGlobalWordIdx-1]);
                             --nGlobalWordIdx;
                         }
                     }
@@ -243,24 +301,26 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
             nPxIterIncr = std::max(nPxIterIncr/3,(size_t)1);
         }
         for(size_t nGlobalWordIdx=0;nGlobalWordIdx<m_nCurrGlobalWords;++nGlobalWordIdx) {
-            if(!(GlobalWord_1ch*)m_vpGlobalWordDict[nGlobalWordIdx]) {
-                GlobalWord_1ch& oCurrNewGlobalWord = *m_pGlobalWordListIter_1ch++;
+            if(m_vnGlobalWordDict[nGlobalWordIdx]==s_nEmptyWordIdx) {
+                m_vnGlobalWordDict[nGlobalWordIdx] = (ushort)nGlobalWordIdx; // all previous entries are filled, so this is the next free pool word
+                GlobalWord_1ch& oCurrNewGlobalWord = m_voGlobalWordList_1ch[nGlobalWordIdx];
                 oCurrNewGlobalWord.oFeature.anColor[0] = 0;
                 oCurrNewGlobalWord.oFeature.anDesc[0] = 0;
                 oCurrNewGlobalWord.nDescBITS = 0;
-                oCurrNewGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                 oCurrNewGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                 oCurrNewGlobalWord.fLatestWeight = 0.0f;
-                m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrNewGlobalWord;
             }
         }
-        lvDbgAssert(m_voGlobalWordList_1ch.end()==m_pGlobalWordListIter_1ch);
+        lvDbgAssert(std::find(m_vnGlobalWordDict.begin(),m_vnGlobalWordDict.end(),s_nEmptyWordIdx)==m_vnGlobalWordDict.end());
     }
     else { //m_nImgChannels==3
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
             if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nPxIter]) {
                 const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+                ushort* const anLocalWordDict = m_vnLocalWordDict.data()+nLocalDictIdx;
+                float* const afLocalWordWeights = m_vfLocalWordWeights.data()+nLocalDictIdx;
+                LocalWord_3ch* const aLocalWords = m_voLocalWordList_3ch.data()+nLocalDictIdx;
                 const size_t nFloatIter = nPxIter*4;
                 uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
                 const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
@@ -269,17 +329,23 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                 // == refresh: local decr
                 if(fOccDecrFrac>0.0f) {
                     for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                        LocalWord_3ch* pCurrLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
-                        if(pCurrLocalWord)
-                            pCurrLocalWord->nOccurrences -= (size_t)(fOccDecrFrac*pCurrLocalWord->nOccurrences);
+                        if(anLocalWordDict[nLocalWordIdx]!=s_nEmptyWordIdx) {
+                            LocalWord_3ch& oCurrLocalWord = aLocalWords[anLocalWordDict[nLocalWordIdx]];
+                            oCurrLocalWord.nOccurrences -= (size_t)(fOccDecrFrac*oCurrLocalWord.nOccurrences);
+                        }
                     }
                 }
+                // == refresh: local weight caching (empty entries get a negative weight so they always sort last)
+                for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx)
+                    afLocalWordWeights[nLocalWordIdx] = (anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx)?-1.0f:GetLocalWordWeight(aLocalWords[anLocalWordDict[nLocalWordIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
+                // occurrence decrements & neighbor updates may have shuffled the dict since its last sort, and the binary searches below need a sorted prefix
+                sortLocalWordDict(anLocalWordDict,afLocalWordWeights,m_nCurrLocalWords,m_nCurrLocalWords);
                 const size_t nCurrWordOccIncr = DEFAULT_LWORD_OCC_INCR;
                 const size_t nTotLocalSamplingIterCount = 7*7*2;
                 for(size_t nLocalSamplingIter=0; nLocalSamplingIter<nTotLocalSamplingIterCount; ++nLocalSamplingIter) {
                     // == refresh: local resampling
                     int nSampleImgCoord_Y, nSampleImgCoord_X;
-                    lv::getSamplePosition_7x7_std2(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getSamplePosition_7x7_std2(lv::fastrand(m_nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X,m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                     const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
                     if(bForceFGUpdate || !m_oLastFGMask_dilated.data[nSamplePxIdx]) {
                         const size_t nSamplePxRGBIdx = nSamplePxIdx*3;
@@ -289,7 +355,7 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         bool bFoundUninitd = false;
                         size_t nLocalWordIdx;
                         for(nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                            LocalWord_3ch* pCurrLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                            LocalWord_3ch* pCurrLocalWord = (anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx)?nullptr:&aLocalWords[anLocalWordDict[nLocalWordIdx]];
                             if(pCurrLocalWord
                                && lv::cmixdist(anSampleColor,pCurrLocalWord->oFeature.anColor)<=nCurrTotColorDistThreshold
                                && lv::hdist(anSampleIntraDesc,pCurrLocalWord->oFeature.anDesc)<=nCurrTotDescDistThreshold) {
@@ -302,7 +368,9 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         }
                         if(nLocalWordIdx==m_nCurrLocalWords) {
                             nLocalWordIdx = m_nCurrLocalWords-1;
-                            LocalWord_3ch& oCurrLocalWord = bFoundUninitd?*m_pLocalWordListIter_3ch++:*(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                            if(bFoundUninitd) // empty entries are always at the end of the dict, and slice words are allocated in order
+                                anLocalWordDict[nLocalWordIdx] = (ushort)(std::find(anLocalWordDict,anLocalWordDict+m_nCurrLocalWords,s_nEmptyWordIdx)-anLocalWordDict);
+                            LocalWord_3ch& oCurrLocalWord = aLocalWords[anLocalWordDict[nLocalWordIdx]];
                             for(size_t c=0; c<3; ++c) {
                                 oCurrLocalWord.oFeature.anColor[c] = anSampleColor[c];
                                 oCurrLocalWord.oFeature.anDesc[c] = anSampleIntraDesc[c];
@@ -310,22 +378,23 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                             oCurrLocalWord.nOccurrences = nBaseOccCount;
                             oCurrLocalWord.nFirstOcc = m_nFrameIdx;
                             oCurrLocalWord.nLastOcc = m_nFrameIdx;
-                            m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrLocalWord;
-                        }
-                        while(nLocalWordIdx>0 && (!m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1] || GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset)>GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1],m_nFrameIdx,m_nLocalWordWeightOffset))) {
-                            std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-                            --nLocalWordIdx;
                         }
+                        // entries before the current one are kept in weight-descending order, so we can binary-search its new position
+                        afLocalWordWeights[nLocalWordIdx] = GetLocalWordWeight(aLocalWords[anLocalWordDict[nLocalWordIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
+                        const size_t nSortedLocalWordIdx = std::upper_bound(afLocalWordWeights,afLocalWordWeights+nLocalWordIdx,afLocalWordWeights[nLocalWordIdx],std::greater<float>())-afLocalWordWeights;
+                        std::rotate(anLocalWordDict+nSortedLocalWordIdx,anLocalWordDict+nLocalWordIdx,anLocalWordDict+nLocalWordIdx+1);
+                        std::rotate(afLocalWordWeights+nSortedLocalWordIdx,afLocalWordWeights+nLocalWordIdx,afLocalWordWeights+nLocalWordIdx+1);
                     }
                 }
-                lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
+                lvDbgAssert(anLocalWordDict[0]!=s_nEmptyWordIdx);
                 for(size_t nLocalWordIdx=1; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
                     // == refresh: local random resampling
-                    if(!(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx]) {
-                        const size_t nRandLocalWordIdx = (rand()%nLocalWordIdx);
-                        const LocalWord_3ch& oRefLocalWord = *(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nRandLocalWordIdx];
-                        const int nRandColorOffset = (rand()%(nCurrTotColorDistThreshold/3+1))-(int)(nCurrTotColorDistThreshold/6);
-                        LocalWord_3ch& oCurrNewLocalWord = *m_pLocalWordListIter_3ch++;
+                    if(anLocalWordDict[nLocalWordIdx]==s_nEmptyWordIdx) {
+                        const size_t nRandLocalWordIdx = (lv::fastrand(m_nRandState)%nLocalWordIdx);
+                        const LocalWord_3ch& oRefLocalWord = aLocalWords[anLocalWordDict[nRandLocalWordIdx]];
+                        const int nRandColorOffset = (lv::fastrand(m_nRandState)%(nCurrTotColorDistThreshold/3+1))-(int)(nCurrTotColorDistThreshold/6);
+                        anLocalWordDict[nLocalWordIdx] = (ushort)nLocalWordIdx; // all previous entries are filled, so this is the next free slice word
+                        LocalWord_3ch& oCurrNewLocalWord = aLocalWords[nLocalWordIdx];
                         for(size_t c=0; c<3; ++c) {
                             oCurrNewLocalWord.oFeature.anColor[c] = cv::saturate_cast<uchar>((int)oRefLocalWord.oFeature.anColor[c]+nRandColorOffset);
                             oCurrNewLocalWord.oFeature.anDesc[c] = oRefLocalWord.oFeature.anDesc[c];
@@ -333,12 +402,14 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         oCurrNewLocalWord.nOccurrences = std::max((size_t)(oRefLocalWord.nOccurrences*((float)(m_nCurrLocalWords-nLocalWordIdx)/m_nCurrLocalWords)),(size_t)1);
                         oCurrNewLocalWord.nFirstOcc = m_nFrameIdx;
                         oCurrNewLocalWord.nLastOcc = m_nFrameIdx;
-                        m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx] = &oCurrNewLocalWord;
+                        afLocalWordWeights[nLocalWordIdx] = GetLocalWordWeight(oCurrNewLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                     }
                 }
+                // resampled words do not follow their reference's weight exactly, so the dict might need a final touch-up
+                sortLocalWordDict(anLocalWordDict,afLocalWordWeights,m_nCurrLocalWords,m_nCurrLocalWords);
             }
         }
-        lvDbgAssert(m_voLocalWordList_3ch.end()==m_pLocalWordListIter_3ch);
+        lvDbgAssert(std::find(m_vnLocalWordDict.begin(),m_vnLocalWordDict.end(),s_nEmptyWordIdx)==m_vnLocalWordDict.end());
         cv::Mat oGlobalDictPresenceLookupMap(m_oImgSize,CV_8UC1,cv::Scalar_<uchar>(0));
         size_t nPxIterIncr = std::max(m_nTotPxCount/m_nCurrGlobalWords,(size_t)1);
         for(size_t nSamplingPasses=0; nSamplingPasses<GWORD_DEFAULT_NB_INIT_SAMPL_PASSES; ++nSamplingPasses) {
@@ -354,14 +425,14 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         const float fCurrDistThresholdFactor = *(float*)(m_oDistThresholdFrame.data+nFloatIter);
                         const size_t nCurrTotColorDistThreshold = (size_t)(sqrt(fCurrDistThresholdFactor)*m_nMinColorDistThreshold)*3;
                         const size_t nCurrTotDescDistThreshold = (((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET))*3;
-                        lvDbgAssert(m_vpLocalWordDict[nLocalDictIdx]);
-                        const LocalWord_3ch& oRefBestLocalWord = *(LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx];
+                        lvDbgAssert(m_vnLocalWordDict[nLocalDictIdx]!=s_nEmptyWordIdx);
+                        const LocalWord_3ch& oRefBestLocalWord = m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx]];
                         const float fRefBestLocalWordWeight = GetLocalWordWeight(oRefBestLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                         const uchar nRefBestLocalWordDescBITS = lv::popcount(oRefBestLocalWord.oFeature.anDesc);
                         bool bFoundUninitd = false;
                         size_t nGlobalWordIdx;
                         for(nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
-                            GlobalWord_3ch* pCurrGlobalWord = (GlobalWord_3ch*)m_vpGlobalWordDict[nGlobalWordIdx];
+                            GlobalWord_3ch* pCurrGlobalWord = (m_vnGlobalWordDict[nGlobalWordIdx]==s_nEmptyWordIdx)?nullptr:&m_voGlobalWordList_3ch[m_vnGlobalWordDict[nGlobalWordIdx]];
                             if(pCurrGlobalWord
                                && lv::L1dist(nRefBestLocalWordDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR
                                && lv::cmixdist(oRefBestLocalWord.oFeature.anColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
@@ -371,25 +442,26 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
                         }
                         if(nGlobalWordIdx==m_nCurrGlobalWords) {
                             nGlobalWordIdx = m_nCurrGlobalWords-1;
-                            GlobalWord_3ch& oCurrGlobalWord = bFoundUninitd?*m_pGlobalWordListIter_3ch++:*(GlobalWord_3ch*)m_vpGlobalWordDict[nGlobalWordIdx];
+                            if(bFoundUninitd) // empty entries are always at the end of the dict, and pool words are allocated in order
+                                m_vnGlobalWordDict[nGlobalWordIdx] = (ushort)(std::find(m_vnGlobalWordDict.begin(),m_vnGlobalWordDict.end(),s_nEmptyWordIdx)-m_vnGlobalWordDict.begin());
+                            GlobalWord_3ch& oCurrGlobalWord = m_voGlobalWordList_3ch[m_vnGlobalWordDict[nGlobalWordIdx]];
                             for(size_t c=0; c<3; ++c) {
                                 oCurrGlobalWord.oFeature.anColor[c] = oRefBestLocalWord.oFeature.anColor[c];
                                 oCurrGlobalWord.oFeature.anDesc[c] = oRefBestLocalWord.oFeature.anDesc[c];
                             }
                             oCurrGlobalWord.nDescBITS = nRefBestLocalWordDescBITS;
-                            oCurrGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                             oCurrGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                             oCurrGlobalWord.fLatestWeight = 0.0f;
-                            m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrGlobalWord;
                         }
-                        float& fCurrGlobalWordLocalWeight = *(float*)(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+                        GlobalWordBase& oCurrGlobalWord = getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx]);
+                        float& fCurrGlobalWordLocalWeight = *(float*)(oCurrGlobalWord.oSpatioOccMap.data+nGlobalWordMapLookupIdx);
                         if(fCurrGlobalWordLocalWeight<fRefBestLocalWordWeight) {
-                            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight += fRefBestLocalWordWeight;
+                            oCurrGlobalWord.fLatestWeight += fRefBestLocalWordWeight;
                             fCurrGlobalWordLocalWeight += fRefBestLocalWordWeight;
                         }
                         oGlobalDictPresenceLookupMap.data[nPxIter] = UCHAR_MAX;
-                        while(nGlobalWordIdx>0 && (!m_vpGlobalWordDict[nGlobalWordIdx-1] || m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>m_vpGlobalWordDict[nGlobalWordIdx-1]->fLatestWeight)) {
-                            std::swap(m_vpGlobalWordDict[nGlobalWordIdx],m_vpGlobalWordDict[nGlobalWordIdx-1]);
+                        while(nGlobalWordIdx>0 && (m_vnGlobalWordDict[nGlobalWordIdx-1]==s_nEmptyWordIdx || getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx]).fLatestWeight>getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx-1]).fLatestWeight)) {
+                            std::swap(m_vnGlobalWordDict[nGlobalWordIdx],m_vnGlobalWordDict[nGlobalWordIdx-1]);
                             --nGlobalWordIdx;
                         }
                     }
@@ -398,30 +470,32 @@ void BackgroundSubtractorPAWCS::refreshModel(size_t nBaseOccCount, float fOccDec
             nPxIterIncr = std::max(nPxIterIncr/3,(size_t)1);
         }
         for(size_t nGlobalWordIdx=0;nGlobalWordIdx<m_nCurrGlobalWords;++nGlobalWordIdx) {
-            if(!(GlobalWord_3ch*)m_vpGlobalWordDict[nGlobalWordIdx]) {
-                GlobalWord_3ch& oCurrNewGlobalWord = *m_pGlobalWordListIter_3ch++;
+            if(m_vnGlobalWordDict[nGlobalWordIdx]==s_nEmptyWordIdx) {
+                m_vnGlobalWordDict[nGlobalWordIdx] = (ushort)nGlobalWordIdx; // all previous entries are filled, so this is the next free pool word
+                GlobalWord_3ch& oCurrNewGlobalWord = m_voGlobalWordList_3ch[nGlobalWordIdx];
                 for(size_t c=0; c<3; ++c) {
                     oCurrNewGlobalWord.oFeature.anColor[c] = 0;
                     oCurrNewGlobalWord.oFeature.anDesc[c] = 0;
                 }
                 oCurrNewGlobalWord.nDescBITS = 0;
-                oCurrNewGlobalWord.oSpatioOccMap.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
                 oCurrNewGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
                 oCurrNewGlobalWord.fLatestWeight = 0.0f;
-                m_vpGlobalWordDict[nGlobalWordIdx] = &oCurrNewGlobalWord;
             }
         }
-        lvDbgAssert(m_voGlobalWordList_3ch.end()==m_pGlobalWordListIter_3ch);
+        lvDbgAssert(std::find(m_vnGlobalWordDict.begin(),m_vnGlobalWordDict.end(),s_nEmptyWordIdx)==m_vnGlobalWordDict.end());
     }
+    const size_t nGlobalWordMapStride = m_oGlobalWordSpatioOccMaps.step.p[0]*m_oDownSampledFrameSize_GlobalWordLookup.height;
     for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
         // == refresh: per-px global word sort
+        // all gword maps share the same buffer, so local weights can be fetched directly from the sorted pool indices
         const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-        const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-        float fLastGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[0]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+        const uchar* const pGlobalWordMapsLookup = m_oGlobalWordSpatioOccMaps.data+m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
+        ushort* const anGlobalDictSortLUT = m_vnGlobalDictSortLUT.data()+nModelIter*m_nCurrGlobalWords;
+        float fLastGlobalWordLocalWeight = *(const float*)(pGlobalWordMapsLookup+anGlobalDictSortLUT[0]*nGlobalWordMapStride);
         for(size_t nGlobalWordLUTIdx=1; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-            const float fCurrGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+            const float fCurrGlobalWordLocalWeight = *(const float*)(pGlobalWordMapsLookup+anGlobalDictSortLUT[nGlobalWordLUTIdx]*nGlobalWordMapStride);
             if(fCurrGlobalWordLocalWeight>fLastGlobalWordLocalWeight)
-                std::swap(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx],m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
+                std::swap(anGlobalDictSortLUT[nGlobalWordLUTIdx],anGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
             else
                 fLastGlobalWordLocalWeight = fCurrGlobalWordLocalWeight;
         }
@@ -433,13 +507,9 @@ void BackgroundSubtractorPAWCS::initialize(const cv::Mat& oInitImg, const cv::Ma
     IBackgroundSubtractorLBSP::initialize_common(oInitImg,oROI);
     m_bModelInitialized = false;
     m_voLocalWordList_1ch.clear();
-    m_pLocalWordListIter_1ch = m_voLocalWordList_1ch.end();
     m_voLocalWordList_3ch.clear();
-    m_pLocalWordListIter_3ch = m_voLocalWordList_3ch.end();
     m_voGlobalWordList_1ch.clear();
-    m_pGlobalWordListIter_1ch = m_voGlobalWordList_1ch.end();
     m_voGlobalWordList_3ch.clear();
-    m_pGlobalWordListIter_3ch = m_voGlobalWordList_3ch.end();
     m_bUsingMovingCamera = false;
     m_oDownSampledFrameSize_MotionAnalysis = cv::Size(m_oImgSize.width/FRAMELEVEL_DOWNSAMPLE_RATIO,m_oImgSize.height/FRAMELEVEL_DOWNSAMPLE_RATIO);
     m_oDownSampledFrameSize_GlobalWordLookup = cv::Size(m_oImgSize.width/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO,m_oImgSize.height/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO);
@@ -501,52 +571,48 @@ void BackgroundSubtractorPAWCS::initialize(const cv::Mat& oInitImg, const cv::Ma
     m_oLastFGMask_dilated = cv::Scalar_<uchar>(0);
     m_oLastFGMask_dilated_inverted.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask_dilated_inverted = cv::Scalar_<uchar>(0);
-    m_oFGMask_FloodedHoles.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_FloodedHoles = cv::Scalar_<uchar>(0);
-    m_oFGMask_PreFlood.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_PreFlood = cv::Scalar_<uchar>(0);
-    m_oCurrRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
-    m_oCurrRawFGBlinkMask = cv::Scalar_<uchar>(0);
     m_oLastRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
     m_oLastRawFGBlinkMask = cv::Scalar_<uchar>(0);
     m_oTempGlobalWordWeightDiffFactor.create(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1);
     m_oTempGlobalWordWeightDiffFactor = cv::Scalar(-0.1f);
-    m_oMorphExStructElement = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(3,3));
+    m_oPostProcessor.initialize(m_oImgSize);
     m_voPxInfoLUT_PAWCS.resize(m_nTotPxCount);
-    m_vpLocalWordDict.resize(m_nTotRelevantPxCount*m_nCurrLocalWords,nullptr);
-    m_vpGlobalWordDict.resize(m_nCurrGlobalWords,nullptr);
+    m_vnLocalWordDict.assign(m_nTotRelevantPxCount*m_nCurrLocalWords,s_nEmptyWordIdx);
+    m_vfLocalWordWeights.assign(m_nTotRelevantPxCount*m_nCurrLocalWords,0.0f);
+    m_vnGlobalWordDict.assign(m_nCurrGlobalWords,s_nEmptyWordIdx);
+    m_vnGlobalDictSortLUT.resize(m_nTotRelevantPxCount*m_nCurrGlobalWords);
+    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter)
+        std::iota(m_vnGlobalDictSortLUT.begin()+nModelIter*m_nCurrGlobalWords,m_vnGlobalDictSortLUT.begin()+(nModelIter+1)*m_nCurrGlobalWords,(ushort)0);
+    m_oGlobalWordSpatioOccMaps.create(m_oDownSampledFrameSize_GlobalWordLookup.height*(int)m_nCurrGlobalWords,m_oDownSampledFrameSize_GlobalWordLookup.width,CV_32FC1);
+    m_oGlobalWordSpatioOccMaps = cv::Scalar(0.0f);
+    const auto lInitGlobalWordMaps = [&](auto& voGlobalWordList) {
+        for(size_t nGlobalWordIdx=0; nGlobalWordIdx<voGlobalWordList.size(); ++nGlobalWordIdx)
+            voGlobalWordList[nGlobalWordIdx].oSpatioOccMap = m_oGlobalWordSpatioOccMaps.rowRange(int(nGlobalWordIdx*m_oDownSampledFrameSize_GlobalWordLookup.height),int((nGlobalWordIdx+1)*m_oDownSampledFrameSize_GlobalWordLookup.height));
+    };
     if(m_nImgChannels==1) {
         m_voLocalWordList_1ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
-        m_pLocalWordListIter_1ch = m_voLocalWordList_1ch.begin();
         m_voGlobalWordList_1ch.resize(m_nCurrGlobalWords);
-        m_pGlobalWordListIter_1ch = m_voGlobalWordList_1ch.begin();
+        lInitGlobalWordMaps(m_voGlobalWordList_1ch);
         for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
             if(m_oROI.data[nPxIter]) {
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx = nModelIter;
                 m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx = (size_t)((m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))*4;
-                m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT.resize(m_nCurrGlobalWords);
-                for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
-                    m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordIdxIter] = &m_voGlobalWordList_1ch[nGlobalWordIdxIter];
                 ++nModelIter;
             }
         }
     }
     else { //m_nImgChannels==3
         m_voLocalWordList_3ch.resize(m_nTotRelevantPxCount*m_nCurrLocalWords);
-        m_pLocalWordListIter_3ch = m_voLocalWordList_3ch.begin();
         m_voGlobalWordList_3ch.resize(m_nCurrGlobalWords);
-        m_pGlobalWordListIter_3ch = m_voGlobalWordList_3ch.begin();
+        lInitGlobalWordMaps(m_voGlobalWordList_3ch);
         for(size_t nPxIter=0, nModelIter=0; nPxIter<m_nTotPxCount; ++nPxIter) {
             if(m_oROI.data[nPxIter]) {
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y = (int)nPxIter/m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X = (int)nPxIter%m_oImgSize.width;
                 m_voPxInfoLUT_PAWCS[nPxIter].nModelIdx = nModelIter;
                 m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx = (size_t)((m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_Y/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO)*m_oDownSampledFrameSize_GlobalWordLookup.width+(m_voPxInfoLUT_PAWCS[nPxIter].nImgCoord_X/GWORD_LOOKUP_MAPS_DOWNSAMPLE_RATIO))*4;
-                m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT.resize(m_nCurrGlobalWords);
-                for(size_t nGlobalWordIdxIter=0; nGlobalWordIdxIter<m_nCurrGlobalWords; ++nGlobalWordIdxIter)
-                    m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordIdxIter] = &m_voGlobalWordList_3ch[nGlobalWordIdxIter];
                 ++nModelIter;
             }
         }
@@ -571,6 +637,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
     const float fRollAvgFactor_LT = 1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_LT);
     const float fRollAvgFactor_ST = 1.0f/std::min(m_nFrameIdx,nCurrSamplesForMovingAvg_ST);
     const size_t nCurrGlobalWordUpdateRate = bBootstrapping?DEFAULT_RESAMPLING_RATE/2:DEFAULT_RESAMPLING_RATE;
+    int nRandState = m_nRandState;
     size_t nFlatRegionCount = 0;
 #if DISPLAY_PAWCS_DEBUG_INFO
     std::vector<std::string> vsWordModList(m_nTotRelevantPxCount*m_nCurrLocalWords);
@@ -605,6 +672,14 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
     std::chrono::high_resolution_clock::time_point post_lastKP = std::chrono::high_resolution_clock::now();
     std::chrono::high_resolution_clock::time_point pre_gword_calcs;
 #endif //USE_INTERNAL_HRCS
+    // local dicts are kept sorted by their cached word weights, which are only re-evaluated for the words scanned or updated below
+    const auto lSortLocalWordDict = [&](size_t nLocalDictIdx, size_t nDirtyWords) {
+#if DISPLAY_PAWCS_DEBUG_INFO
+        sortLocalWordDict(m_vnLocalWordDict.data()+nLocalDictIdx,m_vfLocalWordWeights.data()+nLocalDictIdx,m_nCurrLocalWords,nDirtyWords,vsWordModList.data()+nLocalDictIdx);
+#else //(!DISPLAY_PAWCS_DEBUG_INFO)
+        sortLocalWordDict(m_vnLocalWordDict.data()+nLocalDictIdx,m_vfLocalWordWeights.data()+nLocalDictIdx,m_nCurrLocalWords,nDirtyWords);
+#endif //(!DISPLAY_PAWCS_DEBUG_INFO)
+    };
     if(m_nImgChannels==1) {
 #if USE_INTERNAL_HRCS
         std::chrono::high_resolution_clock::time_point pre_loop = std::chrono::high_resolution_clock::now();
@@ -636,7 +711,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
             float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
             float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            const float fBestLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
+            const float fBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
             const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
             uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
             uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
@@ -664,14 +739,15 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
             const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET);
             size_t nLocalWordIdx = 0;
             float fPotentialLocalWordsWeightSum = 0.0f;
-            float fLastLocalWordWeight = FLT_MAX;
 #if USE_INTERNAL_HRCS
             std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
             fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
             while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                LocalWord_1ch& oCurrLocalWord = m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                float& fCachedLocalWordWeight = m_vfLocalWordWeights[nLocalDictIdx+nLocalWordIdx];
+                fCachedLocalWordWeight = fCurrLocalWordWeight;
                 {
                     const size_t nColorDist = lv::L1dist(nCurrColor,oCurrLocalWord.oFeature.anColor[0]);
                     const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,oCurrLocalWord.oFeature.anDesc[0]);
@@ -682,7 +758,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                             && nColorDist<=nCurrColorDistThreshold
                             && nColorDist>=nCurrColorDistThreshold/2
                             && nIntraDescDist<=nCurrDescDistThreshold/2
-                            && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
+                            && lv::fastrand_odds(nRandState,(nCurrRegionIllumUpdtVal&&nCurrLocalWordUpdateRate!=SIZE_MAX)?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate)) {
                         // == illum updt
                         oCurrLocalWord.oFeature.anColor[0] = nCurrColor;
                         oCurrLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
@@ -698,6 +774,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                         oCurrLocalWord.nLastOcc = m_nFrameIdx;
                         if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
                             oCurrLocalWord.nOccurrences += nCurrWordOccIncr;
+                        fCachedLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                         nMinColorDist = std::min(nMinColorDist,nColorDist);
                         nMinDescDist = std::min(nMinDescDist,nDescDist);
 #if DISPLAY_PAWCS_DEBUG_INFO
@@ -705,26 +782,6 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                     }
                 }
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-#if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
-#endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
-            while(nLocalWordIdx<m_nCurrLocalWords) {
-                const float fCurrLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-#if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
-#endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
                 ++nLocalWordIdx;
             }
 #if USE_INTERNAL_HRCS
@@ -740,18 +797,18 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //USE_FEEDBACK_ADJUSTMENTS
                 fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
                 fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
-                if((rand()%nCurrLocalWordUpdateRate)==0) {
+                if(lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) {
                     size_t nGlobalWordLUTIdx;
                     GlobalWord_1ch* pCurrGlobalWord = nullptr;
                     for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_1ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
+                        pCurrGlobalWord = &m_voGlobalWordList_1ch[m_vnGlobalDictSortLUT[nModelIter*m_nCurrGlobalWords+nGlobalWordLUTIdx]];
                         if(lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],nCurrColor)<=nCurrColorDistThreshold &&
                            lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
                             break;
                     }
-                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || (rand()%(nCurrLocalWordUpdateRate*2))==0) {
+                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || lv::fastrand_odds(nRandState,(nCurrLocalWordUpdateRate<=SIZE_MAX/2)?nCurrLocalWordUpdateRate*2:SIZE_MAX)) {
                         if(nGlobalWordLUTIdx==m_nCurrGlobalWords) {
-                            pCurrGlobalWord = (GlobalWord_1ch*)m_vpGlobalWordDict[m_nCurrGlobalWords-1];
+                            pCurrGlobalWord = &m_voGlobalWordList_1ch[m_vnGlobalWordDict[m_nCurrGlobalWords-1]];
                             pCurrGlobalWord->oFeature.anColor[0] = nCurrColor;
                             pCurrGlobalWord->oFeature.anDesc[0] = nCurrIntraDesc;
                             pCurrGlobalWord->nDescBITS = nCurrIntraDescBITS;
@@ -775,11 +832,11 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //USE_FEEDBACK_ADJUSTMENTS
                 fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
                 fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                if(bCurrRegionIsFlat || (rand()%nCurrLocalWordUpdateRate)==0) {
+                if(bCurrRegionIsFlat || lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) {
                     size_t nGlobalWordLUTIdx;
                     GlobalWord_1ch* pCurrGlobalWord = nullptr;
                     for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_1ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
+                        pCurrGlobalWord = &m_voGlobalWordList_1ch[m_vnGlobalDictSortLUT[nModelIter*m_nCurrGlobalWords+nGlobalWordLUTIdx]];
                         if(lv::L1dist(pCurrGlobalWord->oFeature.anColor[0],nCurrColor)<=nCurrColorDistThreshold &&
                            lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR)
                             break;
@@ -803,17 +860,20 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                     nCurrRegionSegmVal = UCHAR_MAX;
                 if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
                     const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
-                    LocalWord_1ch& oNewLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nNewLocalWordIdx];
+                    LocalWord_1ch& oNewLocalWord = m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordIdx]];
                     oNewLocalWord.oFeature.anColor[0] = nCurrColor;
                     oNewLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
                     oNewLocalWord.nOccurrences = nCurrWordOccIncr;
                     oNewLocalWord.nFirstOcc = m_nFrameIdx;
                     oNewLocalWord.nLastOcc = m_nFrameIdx;
+                    m_vfLocalWordWeights[nLocalDictIdx+nNewLocalWordIdx] = GetLocalWordWeight(oNewLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
 #if DISPLAY_PAWCS_DEBUG_INFO
                     vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                 }
             }
+            // == local dict sort (only the scanned words & the lightest one might have moved)
+            lSortLocalWordDict(nLocalDictIdx,nLocalWordIdx);
 #if USE_INTERNAL_HRCS
             std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
             if(nCurrRegionSegmVal)
@@ -822,20 +882,20 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                 fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
 #endif //USE_INTERNAL_HRCS
             // == neighb updt
-            if((!nCurrRegionSegmVal && (rand()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
+            if((!nCurrRegionSegmVal && lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
             //if((!nCurrRegionSegmVal && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
                 int nSampleImgCoord_Y, nSampleImgCoord_X;
                 if(bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)
-                    lv::getNeighborPosition_5x5(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getNeighborPosition_5x5(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                 else
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getNeighborPosition_3x3(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                 const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
                 if(m_oROI.data[nSamplePxIdx]) {
                     const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
                     size_t nNeighborLocalWordIdx = 0;
                     float fNeighborPotentialLocalWordsWeightSum = 0.0f;
                     while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                        LocalWord_1ch oNeighborLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
+                        LocalWord_1ch oNeighborLocalWord = m_voLocalWordList_1ch[nNeighborLocalDictIdx+m_vnLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx]];
                         const size_t nNeighborColorDist = lv::L1dist(nCurrColor,oNeighborLocalWord.oFeature.anColor[0]);
                         const size_t nNeighborIntraDescDist = lv::hdist(nCurrIntraDesc,oNeighborLocalWord.oFeature.anDesc[0]);
                         const bool bNeighborRegionIsFlat = lv::popcount(oNeighborLocalWord.oFeature.anDesc[0])<FLAT_REGION_BIT_COUNT;
@@ -850,7 +910,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                             vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                         }
-                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (rand()%nCurrLocalWordUpdateRate)==0)) {
+                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate))) {
                             const size_t nSampleDescIdx = nSamplePxIdx*2;
                             ushort& nNeighborLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nSampleDescIdx));
                             const size_t nNeighborLastIntraDescDist = lv::hdist(nCurrIntraDesc,nNeighborLastIntraDesc);
@@ -870,16 +930,19 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                     }
                     if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
                         nNeighborLocalWordIdx = m_nCurrLocalWords-1;
-                        LocalWord_1ch& oNeighborLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
+                        LocalWord_1ch& oNeighborLocalWord = m_voLocalWordList_1ch[nNeighborLocalDictIdx+m_vnLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx]];
                         oNeighborLocalWord.oFeature.anColor[0] = nCurrColor;
                         oNeighborLocalWord.oFeature.anDesc[0] = nCurrIntraDesc;
                         oNeighborLocalWord.nOccurrences = nCurrWordOccIncr;
                         oNeighborLocalWord.nFirstOcc = m_nFrameIdx;
                         oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                        m_vfLocalWordWeights[nNeighborLocalDictIdx+nNeighborLocalWordIdx] = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
 #if DISPLAY_PAWCS_DEBUG_INFO
                         vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                     }
+                    // matched neighbor words are only updated on a copy here, so only the lightest word might have moved (if it was replaced)
+                    lSortLocalWordDict(nNeighborLocalDictIdx,0);
                 }
             }
 #if USE_INTERNAL_HRCS
@@ -964,7 +1027,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
             float& fCurrMeanMinDist_LT = *(float*)(m_oMeanMinDistFrame_LT.data+nFloatIter);
             float& fCurrMeanMinDist_ST = *(float*)(m_oMeanMinDistFrame_ST.data+nFloatIter);
 #endif //USE_FEEDBACK_ADJUSTMENTS
-            const float fBestLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
+            const float fBestLocalWordWeight = GetLocalWordWeight(m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx]],m_nFrameIdx,m_nLocalWordWeightOffset);
             const float fLocalWordsWeightSumThreshold = fBestLocalWordWeight/(fCurrDistThresholdFactor*2);
             uchar& bCurrRegionIsUnstable = m_oUnstableRegionMask.data[nPxIter];
             uchar& nCurrRegionIllumUpdtVal = m_oIllumUpdtRegionMask.data[nPxIter];
@@ -994,14 +1057,15 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
             const size_t nCurrTotDescDistThreshold = (((size_t)1<<((size_t)floor(fCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(bCurrRegionIsUnstable*UNSTAB_DESC_DIST_OFFSET))*3;
             size_t nLocalWordIdx = 0;
             float fPotentialLocalWordsWeightSum = 0.0f;
-            float fLastLocalWordWeight = FLT_MAX;
 #if USE_INTERNAL_HRCS
             std::chrono::high_resolution_clock::time_point post_prep = std::chrono::high_resolution_clock::now();
             fPrepTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_prep-pre_prep).count())/1000000;
 #endif //USE_INTERNAL_HRCS
             while(nLocalWordIdx<m_nCurrLocalWords && fPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                LocalWord_3ch& oCurrLocalWord = m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 const float fCurrLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+                float& fCachedLocalWordWeight = m_vfLocalWordWeights[nLocalDictIdx+nLocalWordIdx];
+                fCachedLocalWordWeight = fCurrLocalWordWeight;
                 {
                     const size_t nTotColorL1Dist = lv::L1dist(anCurrColor,oCurrLocalWord.oFeature.anColor);
                     const size_t nColorDistortion = lv::cdist(anCurrColor,oCurrLocalWord.oFeature.anColor);
@@ -1016,7 +1080,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                             && nTotColorMixDist<=nCurrTotColorDistThreshold
                             && nTotColorL1Dist>=nCurrTotColorDistThreshold/2
                             && nTotIntraDescDist<=nCurrTotDescDistThreshold/2
-                            && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) {
+                            && lv::fastrand_odds(nRandState,(nCurrRegionIllumUpdtVal&&nCurrLocalWordUpdateRate!=SIZE_MAX)?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate)) {
                         // == illum updt
                         for(size_t c=0; c<3; ++c) {
                             oCurrLocalWord.oFeature.anColor[c] = anCurrColor[c];
@@ -1034,6 +1098,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                         oCurrLocalWord.nLastOcc = m_nFrameIdx;
                         if((!m_oLastFGMask.data[nPxIter] || m_bUsingMovingCamera) && fCurrLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
                             oCurrLocalWord.nOccurrences += nCurrWordOccIncr;
+                        fCachedLocalWordWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                         nMinTotColorDist = std::min(nMinTotColorDist,nTotColorMixDist);
                         nMinTotDescDist = std::min(nMinTotDescDist,nTotDescDist);
 #if DISPLAY_PAWCS_DEBUG_INFO
@@ -1041,26 +1106,6 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                     }
                 }
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-#if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
-#endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
-                ++nLocalWordIdx;
-            }
-            while(nLocalWordIdx<m_nCurrLocalWords) {
-                const float fCurrLocalWordWeight = GetLocalWordWeight(*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_nFrameIdx,m_nLocalWordWeightOffset);
-                if(fCurrLocalWordWeight>fLastLocalWordWeight) {
-                    std::swap(m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx],m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx-1]);
-#if DISPLAY_PAWCS_DEBUG_INFO
-                    std::swap(vsWordModList[nLocalDictIdx+nLocalWordIdx],vsWordModList[nLocalDictIdx+nLocalWordIdx-1]);
-#endif //DISPLAY_PAWCS_DEBUG_INFO
-                }
-                else
-                    fLastLocalWordWeight = fCurrLocalWordWeight;
                 ++nLocalWordIdx;
             }
 #if USE_INTERNAL_HRCS
@@ -1076,18 +1121,18 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //USE_FEEDBACK_ADJUSTMENTS
                 fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT);
                 fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST);
-                if((rand()%nCurrLocalWordUpdateRate)==0) {
+                if(lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) {
                     size_t nGlobalWordLUTIdx;
                     GlobalWord_3ch* pCurrGlobalWord = nullptr;
                     for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_3ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
+                        pCurrGlobalWord = &m_voGlobalWordList_3ch[m_vnGlobalDictSortLUT[nModelIter*m_nCurrGlobalWords+nGlobalWordLUTIdx]];
                         if(lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR &&
                            lv::cmixdist(anCurrColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
                             break;
                     }
-                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || (rand()%(nCurrLocalWordUpdateRate*2))==0) {
+                    if(nGlobalWordLUTIdx!=m_nCurrGlobalWords || lv::fastrand_odds(nRandState,(nCurrLocalWordUpdateRate<=SIZE_MAX/2)?nCurrLocalWordUpdateRate*2:SIZE_MAX)) {
                         if(nGlobalWordLUTIdx==m_nCurrGlobalWords) {
-                            pCurrGlobalWord = (GlobalWord_3ch*)m_vpGlobalWordDict[m_nCurrGlobalWords-1];
+                            pCurrGlobalWord = &m_voGlobalWordList_3ch[m_vnGlobalWordDict[m_nCurrGlobalWords-1]];
                             for(size_t c=0; c<3; ++c) {
                                 pCurrGlobalWord->oFeature.anColor[c] = anCurrColor[c];
                                 pCurrGlobalWord->oFeature.anDesc[c] = anCurrIntraDesc[c];
@@ -1113,11 +1158,11 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
 #endif //USE_FEEDBACK_ADJUSTMENTS
                 fCurrMeanRawSegmRes_LT = fCurrMeanRawSegmRes_LT*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
                 fCurrMeanRawSegmRes_ST = fCurrMeanRawSegmRes_ST*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                if(bCurrRegionIsFlat || (rand()%nCurrLocalWordUpdateRate)==0) {
+                if(bCurrRegionIsFlat || lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) {
                     size_t nGlobalWordLUTIdx;
                     GlobalWord_3ch* pCurrGlobalWord = nullptr;
                     for(nGlobalWordLUTIdx=0; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                        pCurrGlobalWord = (GlobalWord_3ch*)m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx];
+                        pCurrGlobalWord = &m_voGlobalWordList_3ch[m_vnGlobalDictSortLUT[nModelIter*m_nCurrGlobalWords+nGlobalWordLUTIdx]];
                         if(lv::L1dist(nCurrIntraDescBITS,pCurrGlobalWord->nDescBITS)<=nCurrTotDescDistThreshold/GWORD_DESC_THRES_BITS_MATCH_FACTOR &&
                            lv::cmixdist(anCurrColor,pCurrGlobalWord->oFeature.anColor)<=nCurrTotColorDistThreshold)
                             break;
@@ -1141,7 +1186,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                     nCurrRegionSegmVal = UCHAR_MAX;
                 if(fPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
                     const size_t nNewLocalWordIdx = m_nCurrLocalWords-1;
-                    LocalWord_3ch* pNewLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictIdx+nNewLocalWordIdx];
+                    LocalWord_3ch* pNewLocalWord = &m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nNewLocalWordIdx]];
                     for(size_t c=0; c<3; ++c) {
                         pNewLocalWord->oFeature.anColor[c] = anCurrColor[c];
                         pNewLocalWord->oFeature.anDesc[c] = anCurrIntraDesc[c];
@@ -1149,11 +1194,14 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                     pNewLocalWord->nOccurrences = nCurrWordOccIncr;
                     pNewLocalWord->nFirstOcc = m_nFrameIdx;
                     pNewLocalWord->nLastOcc = m_nFrameIdx;
+                    m_vfLocalWordWeights[nLocalDictIdx+nNewLocalWordIdx] = GetLocalWordWeight(*pNewLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
 #if DISPLAY_PAWCS_DEBUG_INFO
                     vsWordModList[nLocalDictIdx+nNewLocalWordIdx] += "NEW ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                 }
             }
+            // == local dict sort (only the scanned words & the lightest one might have moved)
+            lSortLocalWordDict(nLocalDictIdx,nLocalWordIdx);
 #if USE_INTERNAL_HRCS
             std::chrono::high_resolution_clock::time_point post_rawdecision = std::chrono::high_resolution_clock::now();
             if(nCurrRegionSegmVal)
@@ -1162,20 +1210,20 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                 fBGRawTimeSum_MS += (float)(std::chrono::duration_cast<std::chrono::nanoseconds>(post_rawdecision-post_ldictscan).count())/1000000;
 #endif //USE_INTERNAL_HRCS
             // == neighb updt
-            if((!nCurrRegionSegmVal && (rand()%nCurrLocalWordUpdateRate)==0) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
+            if((!nCurrRegionSegmVal && lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate)) || bCurrRegionIsROIBorder || m_bUsingMovingCamera) {
             //if((!nCurrRegionSegmVal && (rand()%(nCurrRegionIllumUpdtVal?(nCurrLocalWordUpdateRate/2+1):nCurrLocalWordUpdateRate))==0) || bCurrRegionIsROIBorder) {
                 int nSampleImgCoord_Y, nSampleImgCoord_X;
                 if(bCurrRegionIsFlat || bCurrRegionIsROIBorder || m_bUsingMovingCamera)
-                    lv::getNeighborPosition_5x5(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getNeighborPosition_5x5(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                 else
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    lv::getNeighborPosition_3x3(lv::fastrand(nRandState),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
                 const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
                 if(m_oROI.data[nSamplePxIdx]) {
                     const size_t nNeighborLocalDictIdx = m_voPxInfoLUT_PAWCS[nSamplePxIdx].nModelIdx*m_nCurrLocalWords;
                     size_t nNeighborLocalWordIdx = 0;
                     float fNeighborPotentialLocalWordsWeightSum = 0.0f;
                     while(nNeighborLocalWordIdx<m_nCurrLocalWords && fNeighborPotentialLocalWordsWeightSum<fLocalWordsWeightSumThreshold) {
-                        LocalWord_3ch& oNeighborLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
+                        LocalWord_3ch& oNeighborLocalWord = m_voLocalWordList_3ch[nNeighborLocalDictIdx+m_vnLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx]];
                         const size_t nNeighborTotColorL1Dist = lv::L1dist(anCurrColor,oNeighborLocalWord.oFeature.anColor);
                         const size_t nNeighborColorDistortion = lv::cdist(anCurrColor,oNeighborLocalWord.oFeature.anColor);
                         const size_t nNeighborTotColorMixDist = lv::cmixdist(nNeighborTotColorL1Dist,nNeighborColorDistortion);
@@ -1188,11 +1236,12 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                             oNeighborLocalWord.nLastOcc = m_nFrameIdx;
                             if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
                                 oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
+                            m_vfLocalWordWeights[nNeighborLocalDictIdx+nNeighborLocalWordIdx] = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
 #if DISPLAY_PAWCS_DEBUG_INFO
                             vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "MATCHED(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                         }
-                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || (rand()%nCurrLocalWordUpdateRate)==0)) {
+                        else if(!oCurrFGMask.data[nSamplePxIdx] && bCurrRegionIsFlat && (bBootstrapping || lv::fastrand_odds(nRandState,nCurrLocalWordUpdateRate))) {
                             const size_t nSamplePxRGBIdx = nSamplePxIdx*3;
                             const size_t nSampleDescRGBIdx = nSamplePxRGBIdx*2;
                             ushort* anNeighborLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nSampleDescRGBIdx));
@@ -1203,6 +1252,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                                 oNeighborLocalWord.nLastOcc = m_nFrameIdx;
                                 if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
                                     oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
+                                m_vfLocalWordWeights[nNeighborLocalDictIdx+nNeighborLocalWordIdx] = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                                 for(size_t c=0; c<3; ++c)
                                     oNeighborLocalWord.oFeature.anDesc[c] = anCurrIntraDesc[c];
 #if DISPLAY_PAWCS_DEBUG_INFO
@@ -1219,6 +1269,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                                         oNeighborLocalWord.nLastOcc = m_nFrameIdx;
                                         if(fNeighborLocalWordWeight<DEFAULT_LWORD_MAX_WEIGHT)
                                             oNeighborLocalWord.nOccurrences += nNeighborWordOccIncr;
+                                        m_vfLocalWordWeights[nNeighborLocalDictIdx+nNeighborLocalWordIdx] = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                                         for(size_t c=0; c<3; ++c)
                                             oNeighborLocalWord.oFeature.anColor[c] = anCurrColor[c];
 #if DISPLAY_PAWCS_DEBUG_INFO
@@ -1229,9 +1280,10 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                         }
                         ++nNeighborLocalWordIdx;
                     }
+                    const size_t nNeighborScannedLocalWords = nNeighborLocalWordIdx;
                     if(fNeighborPotentialLocalWordsWeightSum<DEFAULT_LWORD_INIT_WEIGHT) {
                         nNeighborLocalWordIdx = m_nCurrLocalWords-1;
-                        LocalWord_3ch& oNeighborLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx];
+                        LocalWord_3ch& oNeighborLocalWord = m_voLocalWordList_3ch[nNeighborLocalDictIdx+m_vnLocalWordDict[nNeighborLocalDictIdx+nNeighborLocalWordIdx]];
                         for(size_t c=0; c<3; ++c) {
                             oNeighborLocalWord.oFeature.anColor[c] = anCurrColor[c];
                             oNeighborLocalWord.oFeature.anDesc[c] = anCurrIntraDesc[c];
@@ -1239,10 +1291,12 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
                         oNeighborLocalWord.nOccurrences = nCurrWordOccIncr;
                         oNeighborLocalWord.nFirstOcc = m_nFrameIdx;
                         oNeighborLocalWord.nLastOcc = m_nFrameIdx;
+                        m_vfLocalWordWeights[nNeighborLocalDictIdx+nNeighborLocalWordIdx] = GetLocalWordWeight(oNeighborLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
 #if DISPLAY_PAWCS_DEBUG_INFO
                         vsWordModList[nNeighborLocalDictIdx+nNeighborLocalWordIdx] += "NEW(NEIGHBOR) ";
 #endif //DISPLAY_PAWCS_DEBUG_INFO
                     }
+                    lSortLocalWordDict(nNeighborLocalDictIdx,nNeighborScannedLocalWords);
                 }
             }
 #if USE_INTERNAL_HRCS
@@ -1297,36 +1351,41 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         pre_gword_calcs = std::chrono::high_resolution_clock::now();
 #endif //USE_INTERNAL_HRCS
     }
+    m_nRandState = nRandState;
     const bool bRecalcGlobalWords = !(m_nFrameIdx%(nCurrGlobalWordUpdateRate<<5));
     const bool bUpdateGlobalWords = !(m_nFrameIdx%(nCurrGlobalWordUpdateRate));
     cv::Mat oLastFGMask_dilated_inverted_downscaled;
     if(bUpdateGlobalWords)
         cv::resize(m_oLastFGMask_dilated_inverted,oLastFGMask_dilated_inverted_downscaled,m_oDownSampledFrameSize_GlobalWordLookup,0,0,cv::INTER_NEAREST);
     for(size_t nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
-        if(bRecalcGlobalWords && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>0.0f) {
-            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight = GetGlobalWordWeight(*m_vpGlobalWordDict[nGlobalWordIdx]);
-            if(m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight<1.0f) {
-                m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight = 0.0f;
-                m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap = cv::Scalar(0.0f);
+        GlobalWordBase& oCurrGlobalWord = getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx]);
+        if(bRecalcGlobalWords && oCurrGlobalWord.fLatestWeight>0.0f) {
+            oCurrGlobalWord.fLatestWeight = GetGlobalWordWeight(oCurrGlobalWord);
+            if(oCurrGlobalWord.fLatestWeight<1.0f) {
+                oCurrGlobalWord.fLatestWeight = 0.0f;
+                oCurrGlobalWord.oSpatioOccMap = cv::Scalar(0.0f);
             }
         }
-        if(bUpdateGlobalWords && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>0.0f) {
-            cv::accumulateProduct(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,m_oTempGlobalWordWeightDiffFactor,m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,oLastFGMask_dilated_inverted_downscaled);
-            m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight *= 0.9f;
-            cv::blur(m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,m_vpGlobalWordDict[nGlobalWordIdx]->oSpatioOccMap,cv::Size(3,3),cv::Point(-1,-1),cv::BORDER_REPLICATE);
+        if(bUpdateGlobalWords && oCurrGlobalWord.fLatestWeight>0.0f) {
+            cv::accumulateProduct(oCurrGlobalWord.oSpatioOccMap,m_oTempGlobalWordWeightDiffFactor,oCurrGlobalWord.oSpatioOccMap,oLastFGMask_dilated_inverted_downscaled);
+            oCurrGlobalWord.fLatestWeight *= 0.9f;
+            // maps are row ranges of a shared buffer, so borders must be isolated to avoid blurring with neighboring words
+            cv::blur(oCurrGlobalWord.oSpatioOccMap,oCurrGlobalWord.oSpatioOccMap,cv::Size(3,3),cv::Point(-1,-1),cv::BORDER_REPLICATE|cv::BORDER_ISOLATED);
         }
-        if(nGlobalWordIdx>0 && m_vpGlobalWordDict[nGlobalWordIdx]->fLatestWeight>m_vpGlobalWordDict[nGlobalWordIdx-1]->fLatestWeight)
-            std::swap(m_vpGlobalWordDict[nGlobalWordIdx],m_vpGlobalWordDict[nGlobalWordIdx-1]);
+        if(nGlobalWordIdx>0 && oCurrGlobalWord.fLatestWeight>getGlobalWord(m_vnGlobalWordDict[nGlobalWordIdx-1]).fLatestWeight)
+            std::swap(m_vnGlobalWordDict[nGlobalWordIdx],m_vnGlobalWordDict[nGlobalWordIdx-1]);
     }
     if(bUpdateGlobalWords) {
+        const size_t nGlobalWordMapStride = m_oGlobalWordSpatioOccMaps.step.p[0]*m_oDownSampledFrameSize_GlobalWordLookup.height;
         for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
             const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nGlobalWordMapLookupIdx = m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
-            float fLastGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[0]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+            const uchar* const pGlobalWordMapsLookup = m_oGlobalWordSpatioOccMaps.data+m_voPxInfoLUT_PAWCS[nPxIter].nGlobalWordMapLookupIdx;
+            ushort* const anGlobalDictSortLUT = m_vnGlobalDictSortLUT.data()+nModelIter*m_nCurrGlobalWords;
+            float fLastGlobalWordLocalWeight = *(const float*)(pGlobalWordMapsLookup+anGlobalDictSortLUT[0]*nGlobalWordMapStride);
             for(size_t nGlobalWordLUTIdx=1; nGlobalWordLUTIdx<m_nCurrGlobalWords; ++nGlobalWordLUTIdx) {
-                const float fCurrGlobalWordLocalWeight = *(float*)(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx]->oSpatioOccMap.data+nGlobalWordMapLookupIdx);
+                const float fCurrGlobalWordLocalWeight = *(const float*)(pGlobalWordMapsLookup+anGlobalDictSortLUT[nGlobalWordLUTIdx]*nGlobalWordMapStride);
                 if(fCurrGlobalWordLocalWeight>fLastGlobalWordLocalWeight)
-                    std::swap(m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx],m_voPxInfoLUT_PAWCS[nPxIter].vpGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
+                    std::swap(anGlobalDictSortLUT[nGlobalWordLUTIdx],anGlobalDictSortLUT[nGlobalWordLUTIdx-1]);
                 else
                     fLastGlobalWordLocalWeight = fCurrGlobalWordLocalWeight;
             }
@@ -1351,7 +1410,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         cv::Point dbgpt(oDbgPt.x,oDbgPt.y);
         cv::Mat oGlobalWordsCoverageMap(m_oDownSampledFrameSize_GlobalWordLookup,CV_32FC1,cv::Scalar(0.0f));
         for(size_t nDBGWordIdx=0; nDBGWordIdx<m_nCurrGlobalWords; ++nDBGWordIdx)
-            cv::max(oGlobalWordsCoverageMap,m_vpGlobalWordDict[nDBGWordIdx]->oSpatioOccMap,oGlobalWordsCoverageMap);
+            cv::max(oGlobalWordsCoverageMap,getGlobalWord(m_vnGlobalWordDict[nDBGWordIdx]).oSpatioOccMap,oGlobalWordsCoverageMap);
         cv::resize(oGlobalWordsCoverageMap,oGlobalWordsCoverageMap,DEFAULT_FRAME_SIZE,0,0,cv::INTER_NEAREST);
         cv::imshow("oGlobalWordsCoverageMap",oGlobalWordsCoverageMap);
         printf("\nDBG[%2d,%2d] : \n",oDbgPt.x,oDbgPt.y);
@@ -1373,11 +1432,11 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         printf("DBG_LDICT : (%lu occincr per match)\n",nDBGWordOccIncr);
         for(size_t nDBGWordIdx=0; nDBGWordIdx<m_nCurrLocalWords; ++nDBGWordIdx) {
             if(m_nImgChannels==1) {
-                LocalWord_1ch* pDBGLocalWord = (LocalWord_1ch*)m_vpLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx];
+                LocalWord_1ch* pDBGLocalWord = &m_voLocalWordList_1ch[nLocalDictDBGIdx+m_vnLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx]];
                 printf("\t [%02lu] : weight=[%02.03f], nColor=[%03d], nDescBITS=[%02lu]  %s\n",nDBGWordIdx,GetLocalWordWeight(*pDBGLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset),(int)pDBGLocalWord->oFeature.anColor[0],(size_t)lv::popcount(pDBGLocalWord->oFeature.anDesc[0]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
             }
             else { //m_nImgChannels==3
-                LocalWord_3ch* pDBGLocalWord = (LocalWord_3ch*)m_vpLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx];
+                LocalWord_3ch* pDBGLocalWord = &m_voLocalWordList_3ch[nLocalDictDBGIdx+m_vnLocalWordDict[nLocalDictDBGIdx+nDBGWordIdx]];
                 printf("\t [%02lu] : weight=[%02.03f], anColor=[%03d,%03d,%03d], anDescBITS=[%02lu,%02lu,%02lu]  %s\n",nDBGWordIdx,GetLocalWordWeight(*pDBGLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset),(int)pDBGLocalWord->oFeature.anColor[0],(int)pDBGLocalWord->oFeature.anColor[1],(int)pDBGLocalWord->oFeature.anColor[2],(size_t)lv::popcount(pDBGLocalWord->oFeature.anDesc[0]),(size_t)lv::popcount(pDBGLocalWord->oFeature.anDesc[1]),(size_t)lv::popcount(pDBGLocalWord->oFeature.anDesc[2]),vsWordModList[nLocalDictDBGIdx+nDBGWordIdx].c_str());
             }
         }
@@ -1440,23 +1499,7 @@ void BackgroundSubtractorPAWCS::apply(cv::InputArray _image, cv::OutputArray _fg
         cv::imshow("m_oIllumUpdtRegionMask",oIllumUpdtRegionMaskNormalized);
     }
 #endif //DISPLAY_PAWCS_DEBUG_INFO
-    cv::bitwise_xor(oCurrFGMask,m_oLastRawFGMask,m_oCurrRawFGBlinkMask);
-    cv::bitwise_or(m_oCurrRawFGBlinkMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
-    m_oCurrRawFGBlinkMask.copyTo(m_oLastRawFGBlinkMask);
-    oCurrFGMask.copyTo(m_oLastRawFGMask);
-    cv::morphologyEx(oCurrFGMask,m_oFGMask_PreFlood,cv::MORPH_CLOSE,m_oMorphExStructElement);
-    m_oFGMask_PreFlood.copyTo(m_oFGMask_FloodedHoles);
-    cv::floodFill(m_oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
-    cv::bitwise_not(m_oFGMask_FloodedHoles,m_oFGMask_FloodedHoles);
-    cv::erode(m_oFGMask_PreFlood,m_oFGMask_PreFlood,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_FloodedHoles,oCurrFGMask);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_PreFlood,oCurrFGMask);
-    cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nMedianBlurKernelSize);
-    cv::dilate(m_oLastFGMask,m_oLastFGMask_dilated,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    m_oLastFGMask.copyTo(oCurrFGMask);
+    m_oPostProcessor.apply(oCurrFGMask,m_nMedianBlurKernelSize,m_oLastFGMask,m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted,m_oLastRawFGMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
     cv::addWeighted(m_oMeanFinalSegmResFrame_LT,(1.0f-fRollAvgFactor_LT),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_LT,0,m_oMeanFinalSegmResFrame_LT,CV_32F);
     cv::addWeighted(m_oMeanFinalSegmResFrame_ST,(1.0f-fRollAvgFactor_ST),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_ST,0,m_oMeanFinalSegmResFrame_ST,CV_32F);
     const float fCurrNonFlatRegionRatio = (float)(m_nTotRelevantPxCount-nFlatRegionCount)/m_nTotRelevantPxCount;
@@ -1534,7 +1577,7 @@ void BackgroundSubtractorPAWCS::getBackgroundImage(cv::OutputArray backgroundIma
             float fTotWeight = 0.0f;
             float fTotColor = 0.0f;
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                const LocalWord_1ch& oCurrLocalWord = m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                 fTotColor += (float)oCurrLocalWord.oFeature.anColor[0]*fCurrWeight;
                 fTotWeight += fCurrWeight;
@@ -1545,7 +1588,7 @@ void BackgroundSubtractorPAWCS::getBackgroundImage(cv::OutputArray backgroundIma
             float fTotWeight = 0.0f;
             std::array<float,3> fTotColor = {0.0f,0.0f,0.0f};
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                const LocalWord_3ch& oCurrLocalWord = m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                 for(size_t c=0; c<3; ++c)
                     fTotColor[c] += (float)oCurrLocalWord.oFeature.anColor[c]*fCurrWeight;
@@ -1570,7 +1613,7 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
             float fTotWeight = 0.0f;
             float fTotDesc = 0.0f;
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_1ch& oCurrLocalWord = (LocalWord_1ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                const LocalWord_1ch& oCurrLocalWord = m_voLocalWordList_1ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                 fTotDesc += (float)oCurrLocalWord.oFeature.anDesc[0]*fCurrWeight;
                 fTotWeight += fCurrWeight;
@@ -1581,7 +1624,7 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
             float fTotWeight = 0.0f;
             std::array<float,3> fTotDesc = {0.0f,0.0f,0.0f};
             for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
-                const LocalWord_3ch& oCurrLocalWord = (LocalWord_3ch&)*m_vpLocalWordDict[nLocalDictIdx+nLocalWordIdx];
+                const LocalWord_3ch& oCurrLocalWord = m_voLocalWordList_3ch[nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]];
                 float fCurrWeight = GetLocalWordWeight(oCurrLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
                 for(size_t c=0; c<3; ++c)
                     fTotDesc[c] += (float)oCurrLocalWord.oFeature.anDesc[c]*fCurrWeight;
@@ -1593,6 +1636,90 @@ void BackgroundSubtractorPAWCS::getBackgroundDescriptorsImage(cv::OutputArray ba
     oAvgBGDescImg.convertTo(backgroundDescImage,CV_16U);
 }
 
+void BackgroundSubtractorPAWCS::save(std::ostream& oStream, bool bUseCompression) const {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::save_common(oStream,"PAWCS",bUseCompression);
+    writeSnapshotValue(oStream,(uint64_t)m_nMinColorDistThreshold);
+    writeSnapshotValue(oStream,(uint64_t)m_nDescDistThresholdOffset);
+    writeSnapshotValue(oStream,(uint64_t)m_nMaxLocalWords);
+    writeSnapshotValue(oStream,(uint64_t)m_nSamplesForMovingAvgs);
+    writeSnapshotValue(oStream,(uint64_t)m_nCurrLocalWords);
+    writeSnapshotValue(oStream,(uint64_t)m_nCurrGlobalWords);
+    writeSnapshotValue(oStream,m_fLastNonFlatRegionRatio);
+    writeSnapshotValue(oStream,(int32_t)m_nMedianBlurKernelSize);
+    writeSnapshotValue(oStream,(uint64_t)m_nLocalWordWeightOffset);
+    const auto lSaveWords = [&](const auto& voLocalWordList, const auto& voGlobalWordList) {
+        using LocalWordType = typename std::decay_t<decltype(voLocalWordList)>::value_type;
+        static_assert(std::is_trivially_copyable<LocalWordType>::value,"local words must be trivially copyable to be stored raw");
+        writeSnapshotValue(oStream,(uint64_t)sizeof(LocalWordType));
+        lv::write(oStream,cv::Mat(1,int(voLocalWordList.size()*sizeof(LocalWordType)),CV_8UC1,(void*)voLocalWordList.data()),eArchiveType);
+        for(const auto& oGlobalWord : voGlobalWordList) {
+            writeSnapshotValue(oStream,oGlobalWord.fLatestWeight);
+            writeSnapshotValue(oStream,oGlobalWord.nDescBITS);
+            writeSnapshotValue(oStream,oGlobalWord.oFeature);
+        }
+    };
+    if(m_nImgChannels==1)
+        lSaveWords(m_voLocalWordList_1ch,m_voGlobalWordList_1ch);
+    else //m_nImgChannels==3
+        lSaveWords(m_voLocalWordList_3ch,m_voGlobalWordList_3ch);
+    // dictionaries & sort LUTs only hold pool indices, and all gword maps share the same buffer
+    writeWordIndices(oStream,m_vnLocalWordDict,eArchiveType);
+    lv::write(oStream,cv::Mat(1,(int)m_vfLocalWordWeights.size(),CV_32FC1,(void*)m_vfLocalWordWeights.data()),eArchiveType);
+    writeWordIndices(oStream,m_vnGlobalWordDict,eArchiveType);
+    writeWordIndices(oStream,m_vnGlobalDictSortLUT,eArchiveType);
+    lv::write(oStream,m_oGlobalWordSpatioOccMaps,eArchiveType);
+    // note: must be kept in sync with the list in 'load'
+    for(const cv::Mat* pMat : {&m_oIllumUpdtRegionMask,&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oDistThresholdVariationFrame,
+                               &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                               &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                               &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask})
+        lv::write(oStream,*pMat,eArchiveType);
+}
+
+void BackgroundSubtractorPAWCS::load(std::istream& oStream) {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::load_common(oStream,"PAWCS");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nMinColorDistThreshold,"model snapshot min color dist threshold mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nDescDistThresholdOffset,"model snapshot desc dist threshold offset mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nMaxLocalWords,"model snapshot max word count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nSamplesForMovingAvgs,"model snapshot moving avg sample count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nCurrLocalWords,"model snapshot local word count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nCurrGlobalWords,"model snapshot global word count mismatch");
+    m_fLastNonFlatRegionRatio = readSnapshotValue<float>(oStream);
+    m_nMedianBlurKernelSize = (int)readSnapshotValue<int32_t>(oStream);
+    m_nLocalWordWeightOffset = (size_t)readSnapshotValue<uint64_t>(oStream);
+    const auto lLoadWords = [&](auto& voLocalWordList, auto& voGlobalWordList) {
+        using LocalWordType = typename std::decay_t<decltype(voLocalWordList)>::value_type;
+        using GlobalWordType = typename std::decay_t<decltype(voGlobalWordList)>::value_type;
+        lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)sizeof(LocalWordType),"model snapshot local word size mismatch (snapshots cannot be shared across platforms)");
+        cv::Mat oLocalWordData;
+        lv::read(oStream,oLocalWordData,eArchiveType);
+        lvAssert_(oLocalWordData.total()*oLocalWordData.elemSize()==voLocalWordList.size()*sizeof(LocalWordType),"bad model snapshot local word list size");
+        std::memcpy((void*)voLocalWordList.data(),oLocalWordData.data,voLocalWordList.size()*sizeof(LocalWordType));
+        for(GlobalWordType& oGlobalWord : voGlobalWordList) {
+            oGlobalWord.fLatestWeight = readSnapshotValue<float>(oStream);
+            oGlobalWord.nDescBITS = readSnapshotValue<uchar>(oStream);
+            oGlobalWord.oFeature = readSnapshotValue<decltype(oGlobalWord.oFeature)>(oStream);
+        }
+    };
+    if(m_nImgChannels==1)
+        lLoadWords(m_voLocalWordList_1ch,m_voGlobalWordList_1ch);
+    else //m_nImgChannels==3
+        lLoadWords(m_voLocalWordList_3ch,m_voGlobalWordList_3ch);
+    readWordIndices(oStream,m_vnLocalWordDict,m_nCurrLocalWords,eArchiveType);
+    cv::Mat oLocalWordWeights(1,(int)m_vfLocalWordWeights.size(),CV_32FC1,(void*)m_vfLocalWordWeights.data());
+    readSnapshotMat(oStream,oLocalWordWeights,eArchiveType); // copied in place, and only used as dict sort keys
+    readWordIndices(oStream,m_vnGlobalWordDict,m_nCurrGlobalWords,eArchiveType);
+    readWordIndices(oStream,m_vnGlobalDictSortLUT,m_nCurrGlobalWords,eArchiveType);
+    readSnapshotMat(oStream,m_oGlobalWordSpatioOccMaps,eArchiveType); // copied in place, so word map headers stay valid
+    for(cv::Mat* pMat : {&m_oIllumUpdtRegionMask,&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oDistThresholdVariationFrame,
+                         &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                         &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                         &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask})
+        readSnapshotMat(oStream,*pMat,eArchiveType);
+}
+
 float BackgroundSubtractorPAWCS::GetLocalWordWeight(const LocalWordBase& w, size_t nCurrFrame, size_t nOffset) {
     return (float)(w.nOccurrences)/((w.nLastOcc-w.nFirstOcc)+(nCurrFrame-w.nLastOcc)*2+nOffset);
 }
@@ -0,0 +1,162 @@
+
+// This file is part of the LITIV framework; visit the original repository at
+// https://github.com/plstcharles/litiv for more information.
+//
+// Copyright 2015 Pierre-Luc St-Charles; pierre-luc.st-charles<at>polymtl.ca
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "litiv/video/BackgroundSubtractorPyramid.hpp"
+
+BackgroundSubtractorPyramid::BackgroundSubtractorPyramid(std::shared_ptr<IIBackgroundSubtractor> pAlgo, size_t nPyramidLevels, bool bUseBlobRefinement,
+                                                         size_t nRefineColorDistThreshold, size_t nBGRefreshRate) :
+        m_pAlgo(std::move(pAlgo)),
+        m_nPyramidLevels(nPyramidLevels),
+        m_bUseBlobRefinement(bUseBlobRefinement),
+        m_nRefineColorDistThreshold(nRefineColorDistThreshold),
+        m_nBGRefreshRate(nBGRefreshRate),
+        m_nLastBGRefreshFrameIdx(SIZE_MAX) {
+    lvAssert_(m_pAlgo,"pyramid mode must be given a valid background subtractor to wrap");
+    lvAssert_(m_nPyramidLevels<16,"pyramid level count is too large");
+    lvAssert_(m_nBGRefreshRate>0,"background image refresh rate must be positive");
+}
+
+void BackgroundSubtractorPyramid::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
+    lvDbgExceptionWatch;
+    IIBackgroundSubtractor::initialize_common(oInitImg,oROI);
+    if(!m_oInitROI.empty())
+        cv::compare(m_oROI,0,m_oROI_inverted,cv::CMP_EQ);
+    else
+        m_oROI_inverted.release();
+    const int nScale = 1<<m_nPyramidLevels;
+    m_oDownSampledFrameSize = cv::Size(m_oImgSize.width/nScale,m_oImgSize.height/nScale);
+    lvAssert_(m_oDownSampledFrameSize.area()>0,"pyramid level count is too large for the input frame size");
+    if(m_nPyramidLevels==0)
+        m_pAlgo->initialize(oInitImg,m_oInitROI);
+    else {
+        cv::resize(oInitImg,m_oDownSampledFrame,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
+        cv::Mat oDownSampledROI;
+        if(!m_oInitROI.empty())
+            cv::resize(m_oInitROI,oDownSampledROI,m_oDownSampledFrameSize,0,0,cv::INTER_NEAREST);
+        m_pAlgo->initialize(m_oDownSampledFrame,oDownSampledROI);
+        m_oDownSampledFGMask.create(m_oDownSampledFrameSize,CV_8UC1);
+        m_oDownSampledFGMask = cv::Scalar_<uchar>(0);
+        m_oUpSampledFGMask.create(m_oImgSize,CV_8UC1);
+        m_oUpSampledFGMask = cv::Scalar_<uchar>(0);
+        m_oBGImg = oInitImg.clone();
+        m_nLastBGRefreshFrameIdx = 0;
+    }
+    m_bInitialized = true;
+    m_bModelInitialized = true;
+}
+
+double BackgroundSubtractorPyramid::getDefaultLearningRate() const {
+    return m_pAlgo->getDefaultLearningRate();
+}
+
+void BackgroundSubtractorPyramid::apply(cv::InputArray _oInputImg, cv::OutputArray _oFGMask, double dLearningRate) {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized && m_bModelInitialized,"algo & model must be initialized first");
+    const cv::Mat oInputImg = _oInputImg.getMat();
+    lvAssert_(oInputImg.type()==m_nImgType && oInputImg.size()==m_oImgSize,"input image type/size mismatch with initialization type/size");
+    if(dLearningRate<0)
+        dLearningRate = m_pAlgo->getDefaultLearningRate();
+    _oFGMask.create(m_oImgSize,CV_8UC1);
+    cv::Mat oCurrFGMask = _oFGMask.getMat();
+    ++m_nFrameIdx;
+    if(m_nPyramidLevels==0) {
+        m_pAlgo->apply(oInputImg,oCurrFGMask,dLearningRate);
+        oCurrFGMask.copyTo(m_oLastFGMask);
+        return;
+    }
+    cv::resize(oInputImg,m_oDownSampledFrame,m_oDownSampledFrameSize,0,0,cv::INTER_AREA);
+    m_pAlgo->apply(m_oDownSampledFrame,m_oDownSampledFGMask,dLearningRate);
+    if(!m_bUseBlobRefinement)
+        cv::resize(m_oDownSampledFGMask,oCurrFGMask,m_oImgSize,0,0,cv::INTER_NEAREST);
+    else {
+        // bilinear upsampling keeps blob interiors/exteriors saturated, and only leaves intermediate values along contours
+        cv::resize(m_oDownSampledFGMask,m_oUpSampledFGMask,m_oImgSize,0,0,cv::INTER_LINEAR);
+        cv::threshold(m_oUpSampledFGMask,oCurrFGMask,UCHAR_MAX/2,UCHAR_MAX,cv::THRESH_BINARY);
+        const int nBlobCount = cv::connectedComponentsWithStats(m_oDownSampledFGMask,m_oBlobLabels,m_oBlobStats,m_oBlobCentroids,8,CV_32S);
+        if(nBlobCount>1 && m_nFrameIdx-m_nLastBGRefreshFrameIdx>=m_nBGRefreshRate)
+            refreshBackgroundImage();
+        const int nScale = 1<<m_nPyramidLevels;
+        const cv::Rect oImgRect(cv::Point(0,0),m_oImgSize);
+        const size_t nTotRefineColorDistThreshold = m_nRefineColorDistThreshold*m_nImgChannels;
+        for(int nBlobIdx=1; nBlobIdx<nBlobCount; ++nBlobIdx) {
+            // == refine: full resolution contour analysis inside the (padded) blob bounding box
+            const int* const anBlobStats = m_oBlobStats.ptr<int>(nBlobIdx);
+            const cv::Rect oBlobBBox = cv::Rect((anBlobStats[cv::CC_STAT_LEFT]-1)*nScale,(anBlobStats[cv::CC_STAT_TOP]-1)*nScale,
+                                                (anBlobStats[cv::CC_STAT_WIDTH]+2)*nScale,(anBlobStats[cv::CC_STAT_HEIGHT]+2)*nScale)&oImgRect;
+            for(int nRowIdx=oBlobBBox.y; nRowIdx<oBlobBBox.y+oBlobBBox.height; ++nRowIdx) {
+                const uchar* const anUpSampledFGMaskRow = m_oUpSampledFGMask.ptr<uchar>(nRowIdx);
+                const uchar* const anInputRow = oInputImg.ptr<uchar>(nRowIdx);
+                const uchar* const anBGRow = m_oBGImg.ptr<uchar>(nRowIdx);
+                uchar* const anFGMaskRow = oCurrFGMask.ptr<uchar>(nRowIdx);
+                for(int nColIdx=oBlobBBox.x; nColIdx<oBlobBBox.x+oBlobBBox.width; ++nColIdx) {
+                    if(anUpSampledFGMaskRow[nColIdx]==0 || anUpSampledFGMaskRow[nColIdx]==UCHAR_MAX)
+                        continue;
+                    const size_t nPxRGBIter = nColIdx*m_nImgChannels;
+                    size_t nTotColorDist = 0;
+                    for(size_t c=0; c<m_nImgChannels; ++c)
+                        nTotColorDist += lv::L1dist(anInputRow[nPxRGBIter+c],anBGRow[nPxRGBIter+c]);
+                    anFGMaskRow[nColIdx] = (nTotColorDist>nTotRefineColorDistThreshold)?UCHAR_MAX:0;
+                }
+            }
+        }
+    }
+    if(!m_oROI_inverted.empty())
+        oCurrFGMask.setTo(cv::Scalar_<uchar>(0),m_oROI_inverted);
+    oCurrFGMask.copyTo(m_oLastFGMask);
+}
+
+void BackgroundSubtractorPyramid::getBackgroundImage(cv::OutputArray oBGImg) const {
+    lvDbgExceptionWatch;
+    lvAssert_(m_bInitialized,"algo must be initialized first");
+    if(m_nPyramidLevels==0)
+        m_pAlgo->getBackgroundImage(oBGImg);
+    else {
+        cv::Mat oDownSampledBGImg;
+        m_pAlgo->getBackgroundImage(oDownSampledBGImg);
+        cv::resize(oDownSampledBGImg,oBGImg,m_oImgSize,0,0,cv::INTER_LINEAR);
+    }
+}
+
+void BackgroundSubtractorPyramid::setAutomaticModelReset(bool bVal) {
+    IIBackgroundSubtractor::setAutomaticModelReset(bVal);
+    m_pAlgo->setAutomaticModelReset(bVal);
+}
+
+void BackgroundSubtractorPyramid::setSeed(int nSeed) {
+    IIBackgroundSubtractor::setSeed(nSeed);
+    m_pAlgo->setSeed(nSeed);
+}
+
+void BackgroundSubtractorPyramid::setPyramidLevels(size_t nPyramidLevels) {
+    lvAssert_(nPyramidLevels<16,"pyramid level count is too large");
+    if(nPyramidLevels==m_nPyramidLevels)
+        return;
+    if(m_bInitialized) {
+        cv::Mat oLatestBackgroundImage;
+        getBackgroundImage(oLatestBackgroundImage);
+        m_nPyramidLevels = nPyramidLevels;
+        initialize(oLatestBackgroundImage,m_oInitROI);
+    }
+    else
+        m_nPyramidLevels = nPyramidLevels;
+}
+
+void BackgroundSubtractorPyramid::refreshBackgroundImage() {
+    lvDbgAssert(m_nPyramidLevels>0);
+    getBackgroundImage(m_oBGImg);
+    m_nLastBGRefreshFrameIdx = m_nFrameIdx;
+}
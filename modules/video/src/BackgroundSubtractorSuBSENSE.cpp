@@ -59,20 +59,43 @@ static const size_t s_nDescMaxDataRange_1ch = LBSP::DESC_SIZE_BITS;
 static const size_t s_nColorMaxDataRange_3ch = s_nColorMaxDataRange_1ch*3;
 static const size_t s_nDescMaxDataRange_3ch = s_nDescMaxDataRange_1ch*3;
 
+namespace {
+
+    /// processes all even bands concurrently, and then all odd bands; returns the sum of the values returned by the band processor
+    template<typename TBand, typename TBandProcessor>
+    size_t processBands(std::vector<TBand>& voBands, int nWorkers, TBandProcessor&& lBandProcessor) {
+        // bands are at least BGSSUBSENSE_PROC_BAND_ROWS tall, so updates spreading from one band can only reach its direct neighbors
+        static_assert(BGSSUBSENSE_PROC_BAND_ROWS>=4,"band height must allow 5x5 neighbor spread without touching bands of the same parity");
+        const int nBands = (int)voBands.size();
+        size_t nTotal = 0;
+        for(int nParity=0; nParity<2; ++nParity) {
+            #pragma omp parallel for schedule(dynamic) num_threads(nWorkers) reduction(+:nTotal)
+            for(int nBandIdx=nParity; nBandIdx<nBands; nBandIdx+=2)
+                nTotal += lBandProcessor(voBands[nBandIdx]);
+        }
+        return nTotal;
+    }
+
+} // anonymous namespace
+
 BackgroundSubtractorSuBSENSE::BackgroundSubtractorSuBSENSE_(size_t nDescDistThresholdOffset, size_t nMinColorDistThreshold, size_t nBGSamples,
-                                                            size_t nRequiredBGSamples, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold) :
+                                                            size_t nRequiredBGSamples, size_t nSamplesForMovingAvgs, float fRelLBSPThreshold,
+                                                            bool bUsePxMajorModel) :
         IBackgroundSubtractorLBSP(fRelLBSPThreshold),
         m_nMinColorDistThreshold(nMinColorDistThreshold),
         m_nDescDistThresholdOffset(nDescDistThresholdOffset),
         m_nBGSamples(nBGSamples),
         m_nRequiredBGSamples(nRequiredBGSamples),
         m_nSamplesForMovingAvgs(nSamplesForMovingAvgs),
+        m_bUsePxMajorModel(bUsePxMajorModel),
         m_fLastNonZeroDescRatio(0.0f),
         m_bLearningRateScalingEnabled(true),
         m_fCurrLearningRateLowerCap(FEEDBACK_T_LOWER),
         m_fCurrLearningRateUpperCap(FEEDBACK_T_UPPER),
         m_nMedianBlurKernelSize(m_nDefaultMedianBlurKernelSize),
-        m_bUse3x3Spread(true) {
+        m_bUse3x3Spread(true),
+        m_nWorkerCount(BGSSUBSENSE_DEFAULT_WORKER_COUNT),
+        m_oPostProcessor(BGSSUBSENSE_DEFAULT_WORKER_COUNT) {
     lvAssert_(m_nBGSamples>0 && m_nRequiredBGSamples<=m_nBGSamples,"algo cannot require more sample matches than sample count in model");
     lvAssert_(m_nMinColorDistThreshold>0 || m_nDescDistThresholdOffset>0,"distance thresholds must be positive values");
 }
@@ -81,27 +104,40 @@ void BackgroundSubtractorSuBSENSE::refreshModel(float fSamplesRefreshFrac, bool
     // == refresh
     lvAssert_(m_bInitialized,"algo must be initialized first");
     lvAssert_(fSamplesRefreshFrac>0.0f && fSamplesRefreshFrac<=1.0f,"model refresh must be given as a non-null fraction");
-    lvDbgAssert(!m_voBGColorSamples.empty() && !m_voBGColorSamples[0].empty());
+    lvDbgAssert(!m_oBGSamples.empty());
     const size_t nModelSamplesToRefresh = fSamplesRefreshFrac<1.0f?(size_t)(fSamplesRefreshFrac*m_nBGSamples):m_nBGSamples;
-    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?rand()%m_nBGSamples:0;
-    const size_t nChannels = m_voBGColorSamples[0].channels();
-    for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
-        const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-        if(bForceFGUpdate || !m_oLastFGMask.data[nPxIter]) {
-            for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                lv::getSamplePosition_7x7_std2(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
-                    const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
-                    for(size_t c=0; c<nChannels; ++c) {
-                        m_voBGColorSamples[nCurrRealModelSampleIdx].data[nPxIter*nChannels+c] = m_oLastColorFrame.data[nSamplePxIdx*nChannels+c];
-                        *((ushort*)(m_voBGDescSamples[nCurrRealModelSampleIdx].data+(nPxIter*nChannels+c)*2)) = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*nChannels+c)*2));
+    const size_t nRefreshSampleStartPos = fSamplesRefreshFrac<1.0f?lv::fastrand(m_voProcBands[0].nRandSeed)%m_nBGSamples:0;
+    const size_t nChannels = m_oBGSamples.channels();
+    const int nWorkers = (int)(m_nWorkerCount?m_nWorkerCount:std::max(std::thread::hardware_concurrency(),1u));
+    processBands(m_voProcBands,nWorkers,[&](ProcBandInfo& oBand) {
+        int nRandSeed = oBand.nRandSeed;
+        for(size_t nModelIter=oBand.nModelIdxBegin; nModelIter<oBand.nModelIdxEnd; ++nModelIter) {
+            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+            if(bForceFGUpdate || !m_oLastFGMask.data[nPxIter]) {
+                for(size_t nCurrModelSampleIdx=nRefreshSampleStartPos; nCurrModelSampleIdx<nRefreshSampleStartPos+nModelSamplesToRefresh; ++nCurrModelSampleIdx) {
+                    int nSampleImgCoord_Y, nSampleImgCoord_X;
+                    lv::getSamplePosition_7x7_std2(lv::fastrand(nRandSeed),nSampleImgCoord_X,nSampleImgCoord_Y,m_voPxInfoLUT[nPxIter].nImgCoord_X,m_voPxInfoLUT[nPxIter].nImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    const size_t nSamplePxIdx = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    if(bForceFGUpdate || !m_oLastFGMask.data[nSamplePxIdx]) {
+                        const size_t nCurrRealModelSampleIdx = nCurrModelSampleIdx%m_nBGSamples;
+                        uchar* const anBGColor = m_oBGSamples.color(nCurrRealModelSampleIdx,nPxIter);
+                        ushort* const anBGDesc = m_oBGSamples.desc(nCurrRealModelSampleIdx,nPxIter);
+                        for(size_t c=0; c<nChannels; ++c) {
+                            anBGColor[c] = m_oLastColorFrame.data[nSamplePxIdx*nChannels+c];
+                            anBGDesc[c] = *((ushort*)(m_oLastDescFrame.data+(nSamplePxIdx*nChannels+c)*2));
+                        }
                     }
                 }
             }
         }
-    }
+        oBand.nRandSeed = nRandSeed;
+        return size_t(0);
+    });
+}
+
+void BackgroundSubtractorSuBSENSE::setWorkerCount(size_t nWorkers) {
+    m_nWorkerCount = nWorkers;
+    m_oPostProcessor.setWorkerCount(nWorkers);
 }
 
 void BackgroundSubtractorSuBSENSE::initialize(const cv::Mat& oInitImg, const cv::Mat& oROI) {
@@ -163,23 +199,20 @@ void BackgroundSubtractorSuBSENSE::initialize(const cv::Mat& oInitImg, const cv:
     m_oLastFGMask_dilated = cv::Scalar_<uchar>(0);
     m_oLastFGMask_dilated_inverted.create(m_oImgSize,CV_8UC1);
     m_oLastFGMask_dilated_inverted = cv::Scalar_<uchar>(0);
-    m_oFGMask_FloodedHoles.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_FloodedHoles = cv::Scalar_<uchar>(0);
-    m_oFGMask_PreFlood.create(m_oImgSize,CV_8UC1);
-    m_oFGMask_PreFlood = cv::Scalar_<uchar>(0);
-    m_oCurrRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
-    m_oCurrRawFGBlinkMask = cv::Scalar_<uchar>(0);
     m_oLastRawFGBlinkMask.create(m_oImgSize,CV_8UC1);
     m_oLastRawFGBlinkMask = cv::Scalar_<uchar>(0);
-    m_oMorphExStructElement = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(3,3));
-    m_voBGColorSamples.resize(m_nBGSamples);
-    m_voBGDescSamples.resize(m_nBGSamples);
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        m_voBGColorSamples[s].create(m_oImgSize,CV_8UC((int)m_nImgChannels));
-        m_voBGColorSamples[s] = cv::Scalar_<uchar>::all(0);
-        m_voBGDescSamples[s].create(m_oImgSize,CV_16UC((int)m_nImgChannels));
-        m_voBGDescSamples[s] = cv::Scalar_<ushort>::all(0);
+    m_oPostProcessor.initialize(m_oImgSize);
+    const int nProcBands = std::max(m_oImgSize.height/BGSSUBSENSE_PROC_BAND_ROWS,1);
+    m_voProcBands.resize((size_t)nProcBands);
+    for(int nBandIdx=0; nBandIdx<nProcBands; ++nBandIdx) {
+        // last band absorbs leftover rows; model LUT is sorted by px index, so each band maps to a contiguous LUT range
+        const size_t nBandFirstPxIdx = size_t(nBandIdx*BGSSUBSENSE_PROC_BAND_ROWS)*m_oImgSize.width;
+        const size_t nBandLastPxIdx = (nBandIdx==nProcBands-1)?m_nTotPxCount:size_t((nBandIdx+1)*BGSSUBSENSE_PROC_BAND_ROWS)*m_oImgSize.width;
+        m_voProcBands[nBandIdx].nModelIdxBegin = size_t(std::lower_bound(m_vnPxIdxLUT.begin(),m_vnPxIdxLUT.end(),nBandFirstPxIdx)-m_vnPxIdxLUT.begin());
+        m_voProcBands[nBandIdx].nModelIdxEnd = size_t(std::lower_bound(m_vnPxIdxLUT.begin(),m_vnPxIdxLUT.end(),nBandLastPxIdx)-m_vnPxIdxLUT.begin());
+        m_voProcBands[nBandIdx].nRandSeed = (int)((uint32_t)(nBandIdx+1)*2654435761u^(uint32_t)m_nRandSeed);
     }
+    m_oBGSamples.create(m_oImgSize,m_nImgChannels,m_nBGSamples,m_bUsePxMajorModel);
     m_bInitialized = true;
     refreshModel(1.0f);
     m_bModelInitialized = true;
@@ -197,288 +230,332 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
     size_t nNonZeroDescCount = 0;
     const float fRollAvgFactor_LT = 1.0f/std::min(++m_nFrameIdx,m_nSamplesForMovingAvgs);
     const float fRollAvgFactor_ST = 1.0f/std::min(m_nFrameIdx,m_nSamplesForMovingAvgs/4);
+    const int nWorkers = (int)(m_nWorkerCount?m_nWorkerCount:std::max(std::thread::hardware_concurrency(),1u));
     if(m_nImgChannels==1) {
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
-            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const size_t nDescIter = nPxIter*2;
-            const size_t nFloatIter = nPxIter*4;
-            const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
-            const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const uchar nCurrColor = oInputImg.data[nPxIter];
-            size_t nMinDescDist = s_nDescMaxDataRange_1ch;
-            size_t nMinSumDist = s_nColorMaxDataRange_1ch;
-            float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
-            float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
-            float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
-            float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
-            float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
-            float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
-            ushort& nLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nDescIter));
-            uchar& nLastColor = m_oLastColorFrame.data[nPxIter];
-            const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET))/2;
-            const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
-            alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
-            LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
-            const ushort nCurrIntraDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
-            m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
-            size_t nGoodSamplesCount=0, nSampleIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
-                const uchar& nBGColor = m_voBGColorSamples[nSampleIdx].data[nPxIter];
-                {
-                    const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
-                    if(nColorDist>nCurrColorDistThreshold)
-                        goto failedcheck1ch;
-                    const ushort& nBGIntraDesc = *((ushort*)(m_voBGDescSamples[nSampleIdx].data+nDescIter));
-                    const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,nBGIntraDesc);
-                    const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
-                    const size_t nInterDescDist = lv::hdist(nCurrInterDesc,nBGIntraDesc);
-                    const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
-                    if(nDescDist>nCurrDescDistThreshold)
-                        goto failedcheck1ch;
-                    const size_t nSumDist = std::min((nDescDist/4)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
-                    if(nSumDist>nCurrColorDistThreshold)
-                        goto failedcheck1ch;
-                    if(nMinDescDist>nDescDist)
-                        nMinDescDist = nDescDist;
-                    if(nMinSumDist>nSumDist)
-                        nMinSumDist = nSumDist;
-                    nGoodSamplesCount++;
+        const auto lBandProcessor = [&](ProcBandInfo& oBand) {
+            size_t nBandNonZeroDescCount = 0;
+            int nRandSeed = oBand.nRandSeed; // local copy avoids false sharing between bands
+            for(size_t nModelIter=oBand.nModelIdxBegin; nModelIter<oBand.nModelIdxEnd; ++nModelIter) {
+                const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+                const size_t nDescIter = nPxIter*2;
+                const size_t nFloatIter = nPxIter*4;
+                const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
+                const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
+                const uchar nCurrColor = oInputImg.data[nPxIter];
+                size_t nMinDescDist = s_nDescMaxDataRange_1ch;
+                size_t nMinSumDist = s_nColorMaxDataRange_1ch;
+                float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
+                float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
+                float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
+                float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
+                float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
+                float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
+                float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
+                float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
+                float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
+                float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
+                ushort& nLastIntraDesc = *((ushort*)(m_oLastDescFrame.data+nDescIter));
+                uchar& nLastColor = m_oLastColorFrame.data[nPxIter];
+                const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET))/2;
+                const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
+                alignas(16) std::array<uchar,LBSP::DESC_SIZE_BITS> anLBSPLookupVals;
+                LBSP::computeDescriptor_lookup<1>(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,0,anLBSPLookupVals);
+                const ushort nCurrIntraDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nCurrColor,m_anLBSPThreshold_8bitLUT[nCurrColor]);
+                m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
+                size_t nGoodSamplesCount=0;
+                if(m_oBGSamples.isPxMajor()) {
+                    const LBSPSampleMatcher::Params oMatchParams = {1,m_nRequiredBGSamples,true,2,
+                                                                    nCurrColorDistThreshold,nCurrDescDistThreshold,nCurrColorDistThreshold,
+                                                                    SIZE_MAX,SIZE_MAX,SIZE_MAX};
+                    const LBSPSampleMatcher::Result oMatchRes = m_oSampleMatcher.match(oMatchParams,&nCurrColor,&nCurrIntraDesc,anLBSPLookupVals.data(),m_anLBSPThreshold_8bitLUT.data(),
+                                                                                       m_oBGSamples.color(0,nPxIter),m_oBGSamples.desc(0,nPxIter),m_nBGSamples);
+                    nGoodSamplesCount = oMatchRes.nGoodSamples;
+                    nMinDescDist = oMatchRes.nMinDescDist;
+                    nMinSumDist = oMatchRes.nMinSumDist;
                 }
-                failedcheck1ch:
-                nSampleIdx++;
-            }
-            const float fNormalizedLastDist = ((float)lv::L1dist(nLastColor,nCurrColor)/s_nColorMaxDataRange_1ch+(float)lv::hdist(nLastIntraDesc,nCurrIntraDesc)/s_nDescMaxDataRange_1ch)/2;
-            *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
-            if(nGoodSamplesCount<m_nRequiredBGSamples) {
-                // == foreground
-                const float fNormalizedMinDist = std::min(1.0f,((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
-                *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
-                *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
-                *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-                if(m_nModelResetCooldown && (rand()%(size_t)FEEDBACK_T_LOWER)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIter)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[nPxIter] = nCurrColor;
+                else {
+                    size_t nSampleIdx=0;
+                    while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
+                        const uchar& nBGColor = *m_oBGSamples.color(nSampleIdx,nPxIter);
+                        {
+                            const size_t nColorDist = lv::L1dist(nCurrColor,nBGColor);
+                            if(nColorDist>nCurrColorDistThreshold)
+                                goto failedcheck1ch;
+                            const ushort& nBGIntraDesc = *m_oBGSamples.desc(nSampleIdx,nPxIter);
+                            const size_t nIntraDescDist = lv::hdist(nCurrIntraDesc,nBGIntraDesc);
+                            const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(anLBSPLookupVals,nBGColor,m_anLBSPThreshold_8bitLUT[nBGColor]);
+                            const size_t nInterDescDist = lv::hdist(nCurrInterDesc,nBGIntraDesc);
+                            const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
+                            if(nDescDist>nCurrDescDistThreshold)
+                                goto failedcheck1ch;
+                            const size_t nSumDist = std::min((nDescDist/4)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
+                            if(nSumDist>nCurrColorDistThreshold)
+                                goto failedcheck1ch;
+                            if(nMinDescDist>nDescDist)
+                                nMinDescDist = nDescDist;
+                            if(nMinSumDist>nSumDist)
+                                nMinSumDist = nSumDist;
+                            nGoodSamplesCount++;
+                        }
+                        failedcheck1ch:
+                        nSampleIdx++;
+                    }
                 }
-            }
-            else {
-                // == background
-                const float fNormalizedMinDist = ((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2;
-                *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
-                *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
-                *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
-                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIter)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[nPxIter] = nCurrColor;
+                const float fNormalizedLastDist = ((float)lv::L1dist(nLastColor,nCurrColor)/s_nColorMaxDataRange_1ch+(float)lv::hdist(nLastIntraDesc,nCurrIntraDesc)/s_nDescMaxDataRange_1ch)/2;
+                *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
+                if(nGoodSamplesCount<m_nRequiredBGSamples) {
+                    // == foreground
+                    const float fNormalizedMinDist = std::min(1.0f,((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
+                    *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
+                    *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
+                    oCurrFGMask.data[nPxIter] = UCHAR_MAX;
+                    if(m_nModelResetCooldown && (lv::fastrand(nRandSeed)%(size_t)FEEDBACK_T_LOWER)==0) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        *m_oBGSamples.desc(s_rand,nPxIter) = nCurrIntraDesc;
+                        *m_oBGSamples.color(s_rand,nPxIter) = nCurrColor;
+                    }
                 }
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
-                if(bCurrUsing3x3Spread)
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                else
-                    lv::getNeighborPosition_5x5(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t n_rand = rand();
-                const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                const size_t idx_rand_flt32 = idx_rand_uchar*4;
-                const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
-                const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
-                if((n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0
-                    || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
-                    const size_t idx_rand_ushrt = idx_rand_uchar*2;
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    *((ushort*)(m_voBGDescSamples[s_rand].data+idx_rand_ushrt)) = nCurrIntraDesc;
-                    m_voBGColorSamples[s_rand].data[idx_rand_uchar] = nCurrColor;
+                else {
+                    // == background
+                    const float fNormalizedMinDist = ((float)nMinSumDist/s_nColorMaxDataRange_1ch+(float)nMinDescDist/s_nDescMaxDataRange_1ch)/2;
+                    *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
+                    *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
+                    const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
+                    if(lv::fastrand_odds(nRandSeed,nLearningRate)) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        *m_oBGSamples.desc(s_rand,nPxIter) = nCurrIntraDesc;
+                        *m_oBGSamples.color(s_rand,nPxIter) = nCurrColor;
+                    }
+                    int nSampleImgCoord_Y, nSampleImgCoord_X;
+                    const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
+                    if(bCurrUsing3x3Spread)
+                        lv::getNeighborPosition_3x3(lv::fastrand(nRandSeed),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    else
+                        lv::getNeighborPosition_5x5(lv::fastrand(nRandSeed),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    const size_t n_rand = lv::fastrand_mod(nRandSeed,nLearningRate);
+                    const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    const size_t idx_rand_flt32 = idx_rand_uchar*4;
+                    const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
+                    const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
+                    if((nLearningRate!=SIZE_MAX && (n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0)
+                        || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        *m_oBGSamples.desc(s_rand,idx_rand_uchar) = nCurrIntraDesc;
+                        *m_oBGSamples.color(s_rand,idx_rand_uchar) = nCurrColor;
+                    }
                 }
+                if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
+                    if((*pfCurrLearningRate)<m_fCurrLearningRateUpperCap)
+                        *pfCurrLearningRate += FEEDBACK_T_INCR/(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*(*pfCurrVariationFactor));
+                }
+                else if((*pfCurrLearningRate)>m_fCurrLearningRateLowerCap)
+                    *pfCurrLearningRate -= FEEDBACK_T_DECR*(*pfCurrVariationFactor)/std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST);
+                if((*pfCurrLearningRate)<m_fCurrLearningRateLowerCap)
+                    *pfCurrLearningRate = m_fCurrLearningRateLowerCap;
+                else if((*pfCurrLearningRate)>m_fCurrLearningRateUpperCap)
+                    *pfCurrLearningRate = m_fCurrLearningRateUpperCap;
+                if(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
+                    (*pfCurrVariationFactor) += FEEDBACK_V_INCR;
+                else if((*pfCurrVariationFactor)>FEEDBACK_V_DECR) {
+                    (*pfCurrVariationFactor) -= m_oLastFGMask.data[nPxIter]?FEEDBACK_V_DECR/4:m_oUnstableRegionMask.data[nPxIter]?FEEDBACK_V_DECR/2:FEEDBACK_V_DECR;
+                    if((*pfCurrVariationFactor)<FEEDBACK_V_DECR)
+                        (*pfCurrVariationFactor) = FEEDBACK_V_DECR;
+                }
+                if((*pfCurrDistThresholdFactor)<std::pow(1.0f+std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*2,2))
+                    (*pfCurrDistThresholdFactor) += FEEDBACK_R_VAR*(*pfCurrVariationFactor-FEEDBACK_V_DECR);
+                else {
+                    (*pfCurrDistThresholdFactor) -= FEEDBACK_R_VAR/(*pfCurrVariationFactor);
+                    if((*pfCurrDistThresholdFactor)<1.0f)
+                        (*pfCurrDistThresholdFactor) = 1.0f;
+                }
+                if(lv::popcount(nCurrIntraDesc)>=2)
+                    ++nBandNonZeroDescCount;
+                nLastIntraDesc = nCurrIntraDesc;
+                nLastColor = nCurrColor;
             }
-            if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
-                if((*pfCurrLearningRate)<m_fCurrLearningRateUpperCap)
-                    *pfCurrLearningRate += FEEDBACK_T_INCR/(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*(*pfCurrVariationFactor));
-            }
-            else if((*pfCurrLearningRate)>m_fCurrLearningRateLowerCap)
-                *pfCurrLearningRate -= FEEDBACK_T_DECR*(*pfCurrVariationFactor)/std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST);
-            if((*pfCurrLearningRate)<m_fCurrLearningRateLowerCap)
-                *pfCurrLearningRate = m_fCurrLearningRateLowerCap;
-            else if((*pfCurrLearningRate)>m_fCurrLearningRateUpperCap)
-                *pfCurrLearningRate = m_fCurrLearningRateUpperCap;
-            if(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
-                (*pfCurrVariationFactor) += FEEDBACK_V_INCR;
-            else if((*pfCurrVariationFactor)>FEEDBACK_V_DECR) {
-                (*pfCurrVariationFactor) -= m_oLastFGMask.data[nPxIter]?FEEDBACK_V_DECR/4:m_oUnstableRegionMask.data[nPxIter]?FEEDBACK_V_DECR/2:FEEDBACK_V_DECR;
-                if((*pfCurrVariationFactor)<FEEDBACK_V_DECR)
-                    (*pfCurrVariationFactor) = FEEDBACK_V_DECR;
-            }
-            if((*pfCurrDistThresholdFactor)<std::pow(1.0f+std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*2,2))
-                (*pfCurrDistThresholdFactor) += FEEDBACK_R_VAR*(*pfCurrVariationFactor-FEEDBACK_V_DECR);
-            else {
-                (*pfCurrDistThresholdFactor) -= FEEDBACK_R_VAR/(*pfCurrVariationFactor);
-                if((*pfCurrDistThresholdFactor)<1.0f)
-                    (*pfCurrDistThresholdFactor) = 1.0f;
-            }
-            if(lv::popcount(nCurrIntraDesc)>=2)
-                ++nNonZeroDescCount;
-            nLastIntraDesc = nCurrIntraDesc;
-            nLastColor = nCurrColor;
-        }
+            oBand.nRandSeed = nRandSeed;
+            return nBandNonZeroDescCount;
+        };
+        nNonZeroDescCount = processBands(m_voProcBands,nWorkers,lBandProcessor);
     }
     else { //m_nImgChannels==3
-        for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
-            const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
-            const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
-            const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
-            const size_t nPxIterRGB = nPxIter*3;
-            const size_t nDescIterRGB = nPxIterRGB*2;
-            const size_t nFloatIter = nPxIter*4;
-            const uchar* const anCurrColor = oInputImg.data+nPxIterRGB;
-            size_t nMinTotDescDist=s_nDescMaxDataRange_3ch;
-            size_t nMinTotSumDist=s_nColorMaxDataRange_3ch;
-            float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
-            float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
-            float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
-            float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
-            float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
-            float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
-            float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
-            ushort* anLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nDescIterRGB));
-            uchar* anLastColor = m_oLastColorFrame.data+nPxIterRGB;
-            const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET));
-            const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
-            const size_t nCurrTotColorDistThreshold = nCurrColorDistThreshold*3;
-            const size_t nCurrTotDescDistThreshold = nCurrDescDistThreshold*3;
-            const size_t nCurrSCColorDistThreshold = nCurrTotColorDistThreshold/2;
-            alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
-            LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
-            std::array<ushort,3> anCurrIntraDesc;
-            for(size_t c=0; c<3; ++c)
-                anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
-            m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
-            size_t nGoodSamplesCount=0, nSampleIdx=0;
-            while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
-                const ushort* const anBGIntraDesc = (ushort*)(m_voBGDescSamples[nSampleIdx].data+nDescIterRGB);
-                const uchar* const anBGColor = m_voBGColorSamples[nSampleIdx].data+nPxIterRGB;
-                size_t nTotDescDist = 0;
-                size_t nTotSumDist = 0;
-                for(size_t c=0;c<3; ++c) {
-                    const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
-                    if(nColorDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    const size_t nIntraDescDist = lv::hdist(anCurrIntraDesc[c],anBGIntraDesc[c]);
-                    const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
-                    const size_t nInterDescDist = lv::hdist(nCurrInterDesc,anBGIntraDesc[c]);
-                    const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
-                    const size_t nSumDist = std::min((nDescDist/2)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
-                    if(nSumDist>nCurrSCColorDistThreshold)
-                        goto failedcheck3ch;
-                    nTotDescDist += nDescDist;
-                    nTotSumDist += nSumDist;
+        const auto lBandProcessor = [&](ProcBandInfo& oBand) {
+            size_t nBandNonZeroDescCount = 0;
+            int nRandSeed = oBand.nRandSeed; // local copy avoids false sharing between bands
+            for(size_t nModelIter=oBand.nModelIdxBegin; nModelIter<oBand.nModelIdxEnd; ++nModelIter) {
+                const size_t nPxIter = m_vnPxIdxLUT[nModelIter];
+                const int nCurrImgCoord_X = m_voPxInfoLUT[nPxIter].nImgCoord_X;
+                const int nCurrImgCoord_Y = m_voPxInfoLUT[nPxIter].nImgCoord_Y;
+                const size_t nPxIterRGB = nPxIter*3;
+                const size_t nDescIterRGB = nPxIterRGB*2;
+                const size_t nFloatIter = nPxIter*4;
+                const uchar* const anCurrColor = oInputImg.data+nPxIterRGB;
+                size_t nMinTotDescDist=s_nDescMaxDataRange_3ch;
+                size_t nMinTotSumDist=s_nColorMaxDataRange_3ch;
+                float* pfCurrDistThresholdFactor = (float*)(m_oDistThresholdFrame.data+nFloatIter);
+                float* pfCurrVariationFactor = (float*)(m_oVariationModulatorFrame.data+nFloatIter);
+                float* pfCurrLearningRate = ((float*)(m_oUpdateRateFrame.data+nFloatIter));
+                float* pfCurrMeanLastDist = ((float*)(m_oMeanLastDistFrame.data+nFloatIter));
+                float* pfCurrMeanMinDist_LT = ((float*)(m_oMeanMinDistFrame_LT.data+nFloatIter));
+                float* pfCurrMeanMinDist_ST = ((float*)(m_oMeanMinDistFrame_ST.data+nFloatIter));
+                float* pfCurrMeanRawSegmRes_LT = ((float*)(m_oMeanRawSegmResFrame_LT.data+nFloatIter));
+                float* pfCurrMeanRawSegmRes_ST = ((float*)(m_oMeanRawSegmResFrame_ST.data+nFloatIter));
+                float* pfCurrMeanFinalSegmRes_LT = ((float*)(m_oMeanFinalSegmResFrame_LT.data+nFloatIter));
+                float* pfCurrMeanFinalSegmRes_ST = ((float*)(m_oMeanFinalSegmResFrame_ST.data+nFloatIter));
+                ushort* anLastIntraDesc = ((ushort*)(m_oLastDescFrame.data+nDescIterRGB));
+                uchar* anLastColor = m_oLastColorFrame.data+nPxIterRGB;
+                const size_t nCurrColorDistThreshold = (size_t)(((*pfCurrDistThresholdFactor)*m_nMinColorDistThreshold)-((!m_oUnstableRegionMask.data[nPxIter])*STAB_COLOR_DIST_OFFSET));
+                const size_t nCurrDescDistThreshold = ((size_t)1<<((size_t)floor(*pfCurrDistThresholdFactor+0.5f)))+m_nDescDistThresholdOffset+(m_oUnstableRegionMask.data[nPxIter]*UNSTAB_DESC_DIST_OFFSET);
+                const size_t nCurrTotColorDistThreshold = nCurrColorDistThreshold*3;
+                const size_t nCurrTotDescDistThreshold = nCurrDescDistThreshold*3;
+                const size_t nCurrSCColorDistThreshold = nCurrTotColorDistThreshold/2;
+                alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
+                LBSP::computeDescriptor_lookup(oInputImg,nCurrImgCoord_X,nCurrImgCoord_Y,aanLBSPLookupVals);
+                std::array<ushort,3> anCurrIntraDesc;
+                for(size_t c=0; c<3; ++c)
+                    anCurrIntraDesc[c] = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anCurrColor[c],m_anLBSPThreshold_8bitLUT[anCurrColor[c]]);
+                m_oUnstableRegionMask.data[nPxIter] = ((*pfCurrDistThresholdFactor)>UNSTABLE_REG_RDIST_MIN || (*pfCurrMeanRawSegmRes_LT-*pfCurrMeanFinalSegmRes_LT)>UNSTABLE_REG_RATIO_MIN || (*pfCurrMeanRawSegmRes_ST-*pfCurrMeanFinalSegmRes_ST)>UNSTABLE_REG_RATIO_MIN)?1:0;
+                size_t nGoodSamplesCount=0;
+                if(m_oBGSamples.isPxMajor()) {
+                    const LBSPSampleMatcher::Params oMatchParams = {3,m_nRequiredBGSamples,true,1,
+                                                                    nCurrSCColorDistThreshold,SIZE_MAX,nCurrSCColorDistThreshold,
+                                                                    SIZE_MAX,nCurrTotDescDistThreshold,nCurrTotColorDistThreshold};
+                    const LBSPSampleMatcher::Result oMatchRes = m_oSampleMatcher.match(oMatchParams,anCurrColor,anCurrIntraDesc.data(),aanLBSPLookupVals[0].data(),m_anLBSPThreshold_8bitLUT.data(),
+                                                                                       m_oBGSamples.color(0,nPxIter),m_oBGSamples.desc(0,nPxIter),m_nBGSamples);
+                    nGoodSamplesCount = oMatchRes.nGoodSamples;
+                    nMinTotDescDist = oMatchRes.nMinDescDist;
+                    nMinTotSumDist = oMatchRes.nMinSumDist;
                 }
-                if(nTotDescDist>nCurrTotDescDistThreshold || nTotSumDist>nCurrTotColorDistThreshold)
-                    goto failedcheck3ch;
-                if(nMinTotDescDist>nTotDescDist)
-                    nMinTotDescDist = nTotDescDist;
-                if(nMinTotSumDist>nTotSumDist)
-                    nMinTotSumDist = nTotSumDist;
-                nGoodSamplesCount++;
-                failedcheck3ch:
-                nSampleIdx++;
-            }
-            const float fNormalizedLastDist = ((float)lv::L1dist<3>(anLastColor,anCurrColor)/s_nColorMaxDataRange_3ch+(float)lv::hdist<3>(anLastIntraDesc,anCurrIntraDesc)/s_nDescMaxDataRange_3ch)/2;
-            *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
-            if(nGoodSamplesCount<m_nRequiredBGSamples) {
-                // == foreground
-                const float fNormalizedMinDist = std::min(1.0f,((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
-                *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
-                *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
-                *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
-                oCurrFGMask.data[nPxIter] = UCHAR_MAX;
-                if(m_nModelResetCooldown && (rand()%(size_t)FEEDBACK_T_LOWER)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIterRGB+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+nPxIterRGB+c) = anCurrColor[c];
+                else {
+                    size_t nSampleIdx=0;
+                    while(nGoodSamplesCount<m_nRequiredBGSamples && nSampleIdx<m_nBGSamples) {
+                        const ushort* const anBGIntraDesc = m_oBGSamples.desc(nSampleIdx,nPxIter);
+                        const uchar* const anBGColor = m_oBGSamples.color(nSampleIdx,nPxIter);
+                        size_t nTotDescDist = 0;
+                        size_t nTotSumDist = 0;
+                        for(size_t c=0;c<3; ++c) {
+                            const size_t nColorDist = lv::L1dist(anCurrColor[c],anBGColor[c]);
+                            if(nColorDist>nCurrSCColorDistThreshold)
+                                goto failedcheck3ch;
+                            const size_t nIntraDescDist = lv::hdist(anCurrIntraDesc[c],anBGIntraDesc[c]);
+                            const ushort nCurrInterDesc = LBSP::computeDescriptor_threshold(aanLBSPLookupVals[c],anBGColor[c],m_anLBSPThreshold_8bitLUT[anBGColor[c]]);
+                            const size_t nInterDescDist = lv::hdist(nCurrInterDesc,anBGIntraDesc[c]);
+                            const size_t nDescDist = (nIntraDescDist+nInterDescDist)/2;
+                            const size_t nSumDist = std::min((nDescDist/2)*(s_nColorMaxDataRange_1ch/s_nDescMaxDataRange_1ch)+nColorDist,s_nColorMaxDataRange_1ch);
+                            if(nSumDist>nCurrSCColorDistThreshold)
+                                goto failedcheck3ch;
+                            nTotDescDist += nDescDist;
+                            nTotSumDist += nSumDist;
+                        }
+                        if(nTotDescDist>nCurrTotDescDistThreshold || nTotSumDist>nCurrTotColorDistThreshold)
+                            goto failedcheck3ch;
+                        if(nMinTotDescDist>nTotDescDist)
+                            nMinTotDescDist = nTotDescDist;
+                        if(nMinTotSumDist>nTotSumDist)
+                            nMinTotSumDist = nTotSumDist;
+                        nGoodSamplesCount++;
+                        failedcheck3ch:
+                        nSampleIdx++;
                     }
                 }
-            }
-            else {
-                // == background
-                const float fNormalizedMinDist = ((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2;
-                *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
-                *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
-                *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
-                *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
-                const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
-                if((rand()%nLearningRate)==0) {
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+nDescIterRGB+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+nPxIterRGB+c) = anCurrColor[c];
+                const float fNormalizedLastDist = ((float)lv::L1dist<3>(anLastColor,anCurrColor)/s_nColorMaxDataRange_3ch+(float)lv::hdist<3>(anLastIntraDesc,anCurrIntraDesc)/s_nDescMaxDataRange_3ch)/2;
+                *pfCurrMeanLastDist = (*pfCurrMeanLastDist)*(1.0f-fRollAvgFactor_ST) + fNormalizedLastDist*fRollAvgFactor_ST;
+                if(nGoodSamplesCount<m_nRequiredBGSamples) {
+                    // == foreground
+                    const float fNormalizedMinDist = std::min(1.0f,((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2 + (float)(m_nRequiredBGSamples-nGoodSamplesCount)/m_nRequiredBGSamples);
+                    *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT) + fRollAvgFactor_LT;
+                    *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST) + fRollAvgFactor_ST;
+                    oCurrFGMask.data[nPxIter] = UCHAR_MAX;
+                    if(m_nModelResetCooldown && (lv::fastrand(nRandSeed)%(size_t)FEEDBACK_T_LOWER)==0) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        ushort* const anBGIntraDesc = m_oBGSamples.desc(s_rand,nPxIter);
+                        uchar* const anBGColor = m_oBGSamples.color(s_rand,nPxIter);
+                        for(size_t c=0; c<3; ++c) {
+                            anBGIntraDesc[c] = anCurrIntraDesc[c];
+                            anBGColor[c] = anCurrColor[c];
+                        }
                     }
                 }
-                int nSampleImgCoord_Y, nSampleImgCoord_X;
-                const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
-                if(bCurrUsing3x3Spread)
-                    lv::getNeighborPosition_3x3(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                else
-                    lv::getNeighborPosition_5x5(rand(),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
-                const size_t n_rand = rand();
-                const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
-                const size_t idx_rand_flt32 = idx_rand_uchar*4;
-                const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
-                const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
-                if((n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0
-                    || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
-                    const size_t idx_rand_uchar_rgb = idx_rand_uchar*3;
-                    const size_t idx_rand_ushrt_rgb = idx_rand_uchar_rgb*2;
-                    const size_t s_rand = rand()%m_nBGSamples;
-                    for(size_t c=0; c<3; ++c) {
-                        *((ushort*)(m_voBGDescSamples[s_rand].data+idx_rand_ushrt_rgb+2*c)) = anCurrIntraDesc[c];
-                        *(m_voBGColorSamples[s_rand].data+idx_rand_uchar_rgb+c) = anCurrColor[c];
+                else {
+                    // == background
+                    const float fNormalizedMinDist = ((float)nMinTotSumDist/s_nColorMaxDataRange_3ch+(float)nMinTotDescDist/s_nDescMaxDataRange_3ch)/2;
+                    *pfCurrMeanMinDist_LT = (*pfCurrMeanMinDist_LT)*(1.0f-fRollAvgFactor_LT) + fNormalizedMinDist*fRollAvgFactor_LT;
+                    *pfCurrMeanMinDist_ST = (*pfCurrMeanMinDist_ST)*(1.0f-fRollAvgFactor_ST) + fNormalizedMinDist*fRollAvgFactor_ST;
+                    *pfCurrMeanRawSegmRes_LT = (*pfCurrMeanRawSegmRes_LT)*(1.0f-fRollAvgFactor_LT);
+                    *pfCurrMeanRawSegmRes_ST = (*pfCurrMeanRawSegmRes_ST)*(1.0f-fRollAvgFactor_ST);
+                    const size_t nLearningRate = std::isinf(learningRateOverride)?SIZE_MAX:(learningRateOverride>0?(size_t)ceil(learningRateOverride):(size_t)ceil(*pfCurrLearningRate));
+                    if(lv::fastrand_odds(nRandSeed,nLearningRate)) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        ushort* const anBGIntraDesc = m_oBGSamples.desc(s_rand,nPxIter);
+                        uchar* const anBGColor = m_oBGSamples.color(s_rand,nPxIter);
+                        for(size_t c=0; c<3; ++c) {
+                            anBGIntraDesc[c] = anCurrIntraDesc[c];
+                            anBGColor[c] = anCurrColor[c];
+                        }
+                    }
+                    int nSampleImgCoord_Y, nSampleImgCoord_X;
+                    const bool bCurrUsing3x3Spread = m_bUse3x3Spread && !m_oUnstableRegionMask.data[nPxIter];
+                    if(bCurrUsing3x3Spread)
+                        lv::getNeighborPosition_3x3(lv::fastrand(nRandSeed),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    else
+                        lv::getNeighborPosition_5x5(lv::fastrand(nRandSeed),nSampleImgCoord_X,nSampleImgCoord_Y,nCurrImgCoord_X,nCurrImgCoord_Y,LBSP::PATCH_SIZE/2,m_oImgSize);
+                    const size_t n_rand = lv::fastrand_mod(nRandSeed,nLearningRate);
+                    const size_t idx_rand_uchar = m_oImgSize.width*nSampleImgCoord_Y + nSampleImgCoord_X;
+                    const size_t idx_rand_flt32 = idx_rand_uchar*4;
+                    const float fRandMeanLastDist = *((float*)(m_oMeanLastDistFrame.data+idx_rand_flt32));
+                    const float fRandMeanRawSegmRes = *((float*)(m_oMeanRawSegmResFrame_ST.data+idx_rand_flt32));
+                    if((nLearningRate!=SIZE_MAX && (n_rand%(bCurrUsing3x3Spread?nLearningRate:(nLearningRate/2+1)))==0)
+                        || (fRandMeanRawSegmRes>GHOSTDET_S_MIN && fRandMeanLastDist<GHOSTDET_D_MAX && (n_rand%((size_t)m_fCurrLearningRateLowerCap))==0)) {
+                        const size_t s_rand = lv::fastrand(nRandSeed)%m_nBGSamples;
+                        ushort* const anBGIntraDesc = m_oBGSamples.desc(s_rand,idx_rand_uchar);
+                        uchar* const anBGColor = m_oBGSamples.color(s_rand,idx_rand_uchar);
+                        for(size_t c=0; c<3; ++c) {
+                            anBGIntraDesc[c] = anCurrIntraDesc[c];
+                            anBGColor[c] = anCurrColor[c];
+                        }
                     }
                 }
+                if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
+                    if((*pfCurrLearningRate)<m_fCurrLearningRateUpperCap)
+                        *pfCurrLearningRate += FEEDBACK_T_INCR/(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*(*pfCurrVariationFactor));
+                }
+                else if((*pfCurrLearningRate)>m_fCurrLearningRateLowerCap)
+                    *pfCurrLearningRate -= FEEDBACK_T_DECR*(*pfCurrVariationFactor)/std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST);
+                if((*pfCurrLearningRate)<m_fCurrLearningRateLowerCap)
+                    *pfCurrLearningRate = m_fCurrLearningRateLowerCap;
+                else if((*pfCurrLearningRate)>m_fCurrLearningRateUpperCap)
+                    *pfCurrLearningRate = m_fCurrLearningRateUpperCap;
+                if(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
+                    (*pfCurrVariationFactor) += FEEDBACK_V_INCR;
+                else if((*pfCurrVariationFactor)>FEEDBACK_V_DECR) {
+                    (*pfCurrVariationFactor) -= m_oLastFGMask.data[nPxIter]?FEEDBACK_V_DECR/4:m_oUnstableRegionMask.data[nPxIter]?FEEDBACK_V_DECR/2:FEEDBACK_V_DECR;
+                    if((*pfCurrVariationFactor)<FEEDBACK_V_DECR)
+                        (*pfCurrVariationFactor) = FEEDBACK_V_DECR;
+                }
+                if((*pfCurrDistThresholdFactor)<std::pow(1.0f+std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*2,2))
+                    (*pfCurrDistThresholdFactor) += FEEDBACK_R_VAR*(*pfCurrVariationFactor-FEEDBACK_V_DECR);
+                else {
+                    (*pfCurrDistThresholdFactor) -= FEEDBACK_R_VAR/(*pfCurrVariationFactor);
+                    if((*pfCurrDistThresholdFactor)<1.0f)
+                        (*pfCurrDistThresholdFactor) = 1.0f;
+                }
+                if(lv::popcount<3>(anCurrIntraDesc)>=4)
+                    ++nBandNonZeroDescCount;
+                for(size_t c=0; c<3; ++c) {
+                    anLastIntraDesc[c] = anCurrIntraDesc[c];
+                    anLastColor[c] = anCurrColor[c];
+                }
             }
-            if(m_oLastFGMask.data[nPxIter] || (std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)<UNSTABLE_REG_RATIO_MIN && oCurrFGMask.data[nPxIter])) {
-                if((*pfCurrLearningRate)<m_fCurrLearningRateUpperCap)
-                    *pfCurrLearningRate += FEEDBACK_T_INCR/(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*(*pfCurrVariationFactor));
-            }
-            else if((*pfCurrLearningRate)>m_fCurrLearningRateLowerCap)
-                *pfCurrLearningRate -= FEEDBACK_T_DECR*(*pfCurrVariationFactor)/std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST);
-            if((*pfCurrLearningRate)<m_fCurrLearningRateLowerCap)
-                *pfCurrLearningRate = m_fCurrLearningRateLowerCap;
-            else if((*pfCurrLearningRate)>m_fCurrLearningRateUpperCap)
-                *pfCurrLearningRate = m_fCurrLearningRateUpperCap;
-            if(std::max(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)>UNSTABLE_REG_RATIO_MIN && m_oBlinksFrame.data[nPxIter])
-                (*pfCurrVariationFactor) += FEEDBACK_V_INCR;
-            else if((*pfCurrVariationFactor)>FEEDBACK_V_DECR) {
-                (*pfCurrVariationFactor) -= m_oLastFGMask.data[nPxIter]?FEEDBACK_V_DECR/4:m_oUnstableRegionMask.data[nPxIter]?FEEDBACK_V_DECR/2:FEEDBACK_V_DECR;
-                if((*pfCurrVariationFactor)<FEEDBACK_V_DECR)
-                    (*pfCurrVariationFactor) = FEEDBACK_V_DECR;
-            }
-            if((*pfCurrDistThresholdFactor)<std::pow(1.0f+std::min(*pfCurrMeanMinDist_LT,*pfCurrMeanMinDist_ST)*2,2))
-                (*pfCurrDistThresholdFactor) += FEEDBACK_R_VAR*(*pfCurrVariationFactor-FEEDBACK_V_DECR);
-            else {
-                (*pfCurrDistThresholdFactor) -= FEEDBACK_R_VAR/(*pfCurrVariationFactor);
-                if((*pfCurrDistThresholdFactor)<1.0f)
-                    (*pfCurrDistThresholdFactor) = 1.0f;
-            }
-            if(lv::popcount<3>(anCurrIntraDesc)>=4)
-                ++nNonZeroDescCount;
-            for(size_t c=0; c<3; ++c) {
-                anLastIntraDesc[c] = anCurrIntraDesc[c];
-                anLastColor[c] = anCurrColor[c];
-            }
-        }
+            oBand.nRandSeed = nRandSeed;
+            return nBandNonZeroDescCount;
+        };
+        nNonZeroDescCount = processBands(m_voProcBands,nWorkers,lBandProcessor);
     }
 #if DISPLAY_SUBSENSE_DEBUG_INFO
     cv::Point2i oDbgPt(-1,-1);
@@ -533,23 +610,7 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
         std::cout << std::fixed << std::setprecision(5) << "      t(" << oDbgPt << ") = " << m_oUpdateRateFrame.at<float>(oDbgPt) << std::endl;
     }
 #endif //DISPLAY_SUBSENSE_DEBUG_INFO
-    cv::bitwise_xor(oCurrFGMask,m_oLastRawFGMask,m_oCurrRawFGBlinkMask);
-    cv::bitwise_or(m_oCurrRawFGBlinkMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
-    m_oCurrRawFGBlinkMask.copyTo(m_oLastRawFGBlinkMask);
-    oCurrFGMask.copyTo(m_oLastRawFGMask);
-    cv::morphologyEx(oCurrFGMask,m_oFGMask_PreFlood,cv::MORPH_CLOSE,m_oMorphExStructElement);
-    m_oFGMask_PreFlood.copyTo(m_oFGMask_FloodedHoles);
-    cv::floodFill(m_oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
-    cv::bitwise_not(m_oFGMask_FloodedHoles,m_oFGMask_FloodedHoles);
-    cv::erode(m_oFGMask_PreFlood,m_oFGMask_PreFlood,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_FloodedHoles,oCurrFGMask);
-    cv::bitwise_or(oCurrFGMask,m_oFGMask_PreFlood,oCurrFGMask);
-    cv::medianBlur(oCurrFGMask,m_oLastFGMask,m_nMedianBlurKernelSize);
-    cv::dilate(m_oLastFGMask,m_oLastFGMask_dilated,cv::Mat(),cv::Point(-1,-1),3);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
-    cv::bitwise_and(m_oBlinksFrame,m_oLastFGMask_dilated_inverted,m_oBlinksFrame);
-    m_oLastFGMask.copyTo(oCurrFGMask);
+    m_oPostProcessor.apply(oCurrFGMask,m_nMedianBlurKernelSize,m_oLastFGMask,m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted,m_oLastRawFGMask,m_oLastRawFGBlinkMask,m_oBlinksFrame);
     cv::addWeighted(m_oMeanFinalSegmResFrame_LT,(1.0f-fRollAvgFactor_LT),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_LT,0,m_oMeanFinalSegmResFrame_LT,CV_32F);
     cv::addWeighted(m_oMeanFinalSegmResFrame_ST,(1.0f-fRollAvgFactor_ST),m_oLastFGMask,(1.0/UCHAR_MAX)*fRollAvgFactor_ST,0,m_oMeanFinalSegmResFrame_ST,CV_32F);
     const float fCurrNonZeroDescRatio = (float)nNonZeroDescCount/m_nTotRelevantPxCount;
@@ -611,39 +672,63 @@ void BackgroundSubtractorSuBSENSE::apply(cv::InputArray _image, cv::OutputArray
     }
 }
 
+void BackgroundSubtractorSuBSENSE::save(std::ostream& oStream, bool bUseCompression) const {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::save_common(oStream,"SuBSENSE",bUseCompression);
+    writeSnapshotValue(oStream,(uint64_t)m_nMinColorDistThreshold);
+    writeSnapshotValue(oStream,(uint64_t)m_nDescDistThresholdOffset);
+    writeSnapshotValue(oStream,(uint64_t)m_nBGSamples);
+    writeSnapshotValue(oStream,(uint64_t)m_nRequiredBGSamples);
+    writeSnapshotValue(oStream,(uint64_t)m_nSamplesForMovingAvgs);
+    writeSnapshotValue(oStream,m_fLastNonZeroDescRatio);
+    writeSnapshotValue(oStream,(uint8_t)m_bLearningRateScalingEnabled);
+    writeSnapshotValue(oStream,m_fCurrLearningRateLowerCap);
+    writeSnapshotValue(oStream,m_fCurrLearningRateUpperCap);
+    writeSnapshotValue(oStream,(int32_t)m_nMedianBlurKernelSize);
+    writeSnapshotValue(oStream,(uint8_t)m_bUse3x3Spread);
+    writeSnapshotValue(oStream,(uint64_t)m_voProcBands.size());
+    for(const ProcBandInfo& oBand : m_voProcBands)
+        writeSnapshotValue(oStream,(int32_t)oBand.nRandSeed);
+    m_oBGSamples.write(oStream,eArchiveType);
+    // note: must be kept in sync with the list in 'load'
+    for(const cv::Mat* pMat : {&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oVariationModulatorFrame,&m_oMeanLastDistFrame,
+                               &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                               &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                               &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask})
+        lv::write(oStream,*pMat,eArchiveType);
+}
+
+void BackgroundSubtractorSuBSENSE::load(std::istream& oStream) {
+    lvDbgExceptionWatch;
+    const lv::MatArchiveList eArchiveType = IBackgroundSubtractorLBSP::load_common(oStream,"SuBSENSE");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nMinColorDistThreshold,"model snapshot min color dist threshold mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nDescDistThresholdOffset,"model snapshot desc dist threshold offset mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nBGSamples,"model snapshot sample count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nRequiredBGSamples,"model snapshot required sample count mismatch");
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_nSamplesForMovingAvgs,"model snapshot moving avg sample count mismatch");
+    m_fLastNonZeroDescRatio = readSnapshotValue<float>(oStream);
+    m_bLearningRateScalingEnabled = readSnapshotValue<uint8_t>(oStream)!=0;
+    m_fCurrLearningRateLowerCap = readSnapshotValue<float>(oStream);
+    m_fCurrLearningRateUpperCap = readSnapshotValue<float>(oStream);
+    m_nMedianBlurKernelSize = (int)readSnapshotValue<int32_t>(oStream);
+    m_bUse3x3Spread = readSnapshotValue<uint8_t>(oStream)!=0;
+    lvAssert_(readSnapshotValue<uint64_t>(oStream)==(uint64_t)m_voProcBands.size(),"model snapshot processing band count mismatch");
+    for(ProcBandInfo& oBand : m_voProcBands)
+        oBand.nRandSeed = (int)readSnapshotValue<int32_t>(oStream);
+    m_oBGSamples.read(oStream,eArchiveType);
+    for(cv::Mat* pMat : {&m_oUpdateRateFrame,&m_oDistThresholdFrame,&m_oVariationModulatorFrame,&m_oMeanLastDistFrame,
+                         &m_oMeanMinDistFrame_LT,&m_oMeanMinDistFrame_ST,&m_oMeanDownSampledLastDistFrame_LT,&m_oMeanDownSampledLastDistFrame_ST,
+                         &m_oMeanRawSegmResFrame_LT,&m_oMeanRawSegmResFrame_ST,&m_oMeanFinalSegmResFrame_LT,&m_oMeanFinalSegmResFrame_ST,
+                         &m_oUnstableRegionMask,&m_oBlinksFrame,&m_oLastRawFGMask,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGBlinkMask})
+        readSnapshotMat(oStream,*pMat,eArchiveType);
+}
+
 void BackgroundSubtractorSuBSENSE::getBackgroundImage(cv::OutputArray backgroundImage) const {
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGImg = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t s=0; s<m_nBGSamples; ++s) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_nimg = m_voBGColorSamples[s].step.p[0]*y + m_voBGColorSamples[s].step.p[1]*x;
-                const size_t nFloatIter = idx_nimg*4;
-                float* oAvgBgImgPtr = (float*)(oAvgBGImg.data+nFloatIter);
-                const uchar* const oBGImgPtr = m_voBGColorSamples[s].data+idx_nimg;
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgImgPtr[c] += ((float)oBGImgPtr[c])/m_nBGSamples;
-            }
-        }
-    }
-    oAvgBGImg.convertTo(backgroundImage,CV_8U);
+    m_oBGSamples.getAvgColorImage(backgroundImage);
 }
 
 void BackgroundSubtractorSuBSENSE::getBackgroundDescriptorsImage(cv::OutputArray backgroundDescImage) const {
-    static_assert(LBSP::DESC_SIZE==2,"bad assumptions in impl below");
     lvAssert_(m_bInitialized,"algo must be initialized first");
-    cv::Mat oAvgBGDesc = cv::Mat::zeros(m_oImgSize,CV_32FC((int)m_nImgChannels));
-    for(size_t n=0; n<m_voBGDescSamples.size(); ++n) {
-        for(int y=0; y<m_oImgSize.height; ++y) {
-            for(int x=0; x<m_oImgSize.width; ++x) {
-                const size_t idx_ndesc = m_voBGDescSamples[n].step.p[0]*y + m_voBGDescSamples[n].step.p[1]*x;
-                const size_t nFloatIter = idx_ndesc*2;
-                float* oAvgBgDescPtr = (float*)(oAvgBGDesc.data+nFloatIter);
-                const ushort* const oBGDescPtr = (ushort*)(m_voBGDescSamples[n].data+idx_ndesc);
-                for(size_t c=0; c<m_nImgChannels; ++c)
-                    oAvgBgDescPtr[c] += ((float)oBGDescPtr[c])/m_voBGDescSamples.size();
-            }
-        }
-    }
-    oAvgBGDesc.convertTo(backgroundDescImage,CV_16U);
+    m_oBGSamples.getAvgDescImage(backgroundDescImage);
 }
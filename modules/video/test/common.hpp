@@ -0,0 +1,21 @@
+
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+    /// generates a noisy synthetic frame with a moving square, which is identical for all calls with the same frame index
+    cv::Mat genFrame(const cv::Size& oSize, int nChannels, int nFrameIdx) {
+        cv::Mat oFrame(oSize,CV_8UC(nChannels));
+        cv::RNG oRNG((uint64)(nFrameIdx+1));
+        oRNG.fill(oFrame,cv::RNG::UNIFORM,cv::Scalar::all(100),cv::Scalar::all(116));
+        const int nSquareSize = std::max(oSize.height/6,4);
+        const cv::Point oTopLeft((nFrameIdx*7)%std::max(oSize.width-nSquareSize,1),(nFrameIdx*3)%std::max(oSize.height-nSquareSize,1));
+        cv::rectangle(oFrame,cv::Rect(oTopLeft,cv::Size(nSquareSize,nSquareSize)),cv::Scalar::all(230),-1);
+        return oFrame;
+    }
+
+}
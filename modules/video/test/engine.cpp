@@ -0,0 +1,121 @@
+
+#include "litiv/video/BackgroundSubtractionEngine.hpp"
+#include "litiv/video/BackgroundSubtractorLOBSTER.hpp"
+#include "litiv/test.hpp"
+
+namespace {
+
+    /// generates a noisy synthetic frame with a moving square, which is identical for all calls with the same stream & frame index
+    cv::Mat genFrame(const cv::Size& oSize, int nStreamIdx, int nFrameIdx) {
+        cv::Mat oFrame(oSize,CV_8UC3);
+        cv::RNG oRNG((uint64)(nStreamIdx*1000+nFrameIdx+1));
+        oRNG.fill(oFrame,cv::RNG::UNIFORM,cv::Scalar::all(100),cv::Scalar::all(116));
+        const int nSquareSize = std::max(oSize.height/6,4);
+        const cv::Point oTopLeft(((nFrameIdx+nStreamIdx)*7)%std::max(oSize.width-nSquareSize,1),((nFrameIdx+nStreamIdx)*3)%std::max(oSize.height-nSquareSize,1));
+        cv::rectangle(oFrame,cv::Rect(oTopLeft,cv::Size(nSquareSize,nSquareSize)),cv::Scalar::all(230),-1);
+        return oFrame;
+    }
+
+}
+
+TEST(bgs_engine,regression_vs_serial) {
+    const cv::Size oSize(160,120);
+    const int nStreams = 6, nFrames = 20;
+    std::vector<std::vector<cv::Mat>> vvoFGMasks_serial(nStreams);
+    for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx) {
+        BackgroundSubtractorLOBSTER oAlgo;
+        oAlgo.setSeed(nStreamIdx);
+        oAlgo.initialize(genFrame(oSize,nStreamIdx,0));
+        for(int nFrameIdx=1; nFrameIdx<=nFrames; ++nFrameIdx) {
+            cv::Mat oFGMask;
+            oAlgo.apply(genFrame(oSize,nStreamIdx,nFrameIdx),oFGMask,oAlgo.getDefaultLearningRate());
+            vvoFGMasks_serial[nStreamIdx].push_back(oFGMask.clone());
+        }
+    }
+    std::vector<std::vector<cv::Mat>> vvoFGMasks_engine(nStreams,std::vector<cv::Mat>(nFrames));
+    {
+        BackgroundSubtractionEngine oEngine(3,2);
+        for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx) {
+            auto pAlgo = std::make_shared<BackgroundSubtractorLOBSTER>();
+            pAlgo->setSeed(nStreamIdx);
+            const size_t nEngineStreamIdx = oEngine.addStream(pAlgo,genFrame(oSize,nStreamIdx,0),cv::Mat(),[&](size_t nCurrStreamIdx, size_t nFrameIdx, const cv::Mat& oFGMask) {
+                vvoFGMasks_engine[nCurrStreamIdx][nFrameIdx] = oFGMask.clone();
+            });
+            ASSERT_EQ(nEngineStreamIdx,(size_t)nStreamIdx);
+        }
+        ASSERT_EQ(oEngine.getStreamCount(),(size_t)nStreams);
+        for(int nFrameIdx=1; nFrameIdx<=nFrames; ++nFrameIdx)
+            for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx)
+                ASSERT_EQ(oEngine.push(nStreamIdx,genFrame(oSize,nStreamIdx,nFrameIdx)),(size_t)nFrameIdx-1);
+        oEngine.wait();
+        for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx) {
+            const BackgroundSubtractionEngine::StreamStats oStats = oEngine.getStreamStats(nStreamIdx);
+            ASSERT_EQ(oStats.nPushedFrames,(size_t)nFrames);
+            ASSERT_EQ(oStats.nProcessedFrames,(size_t)nFrames);
+            ASSERT_GT(oStats.dMaxLatency,0.0);
+            ASSERT_LE(oStats.dMeanLatency,oStats.dMaxLatency);
+        }
+        ASSERT_GT(oEngine.getAggregateFPS(),0.0);
+    }
+    for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx)
+        for(int nFrameIdx=0; nFrameIdx<nFrames; ++nFrameIdx)
+            ASSERT_TRUE(lv::isEqual<uchar>(vvoFGMasks_serial[nStreamIdx][nFrameIdx],vvoFGMasks_engine[nStreamIdx][nFrameIdx])) << "stream=" << nStreamIdx << ", frame=" << nFrameIdx;
+}
+
+TEST(bgs_engine,regression_backpressure) {
+    const cv::Size oSize(64,48);
+    const size_t nMaxQueuedFrames = 2;
+    std::promise<void> oReleasePromise;
+    std::shared_future<void> oRelease = oReleasePromise.get_future().share();
+    BackgroundSubtractionEngine oEngine(1,nMaxQueuedFrames);
+    oEngine.addStream(std::make_shared<BackgroundSubtractorLOBSTER>(),genFrame(oSize,0,0),cv::Mat(),[&](size_t,size_t,const cv::Mat&) {
+        oRelease.wait(); // keeps the only worker busy until the queue has been filled
+    });
+    size_t nAcceptedFrames = 0;
+    for(int nFrameIdx=1; nFrameIdx<=10; ++nFrameIdx)
+        if(oEngine.tryPush(0,genFrame(oSize,0,nFrameIdx))!=SIZE_MAX)
+            ++nAcceptedFrames;
+    // at most one frame can be taken out of the queue by the blocked worker
+    ASSERT_GE(nAcceptedFrames,nMaxQueuedFrames);
+    ASSERT_LE(nAcceptedFrames,nMaxQueuedFrames+1);
+    oReleasePromise.set_value();
+    oEngine.wait();
+    const BackgroundSubtractionEngine::StreamStats oStats = oEngine.getStreamStats(0);
+    ASSERT_EQ(oStats.nPushedFrames,nAcceptedFrames);
+    ASSERT_EQ(oStats.nProcessedFrames,nAcceptedFrames);
+}
+
+TEST(bgs_engine,regression_exception) {
+    const cv::Size oSize(64,48);
+    BackgroundSubtractionEngine oEngine(2);
+    oEngine.addStream(std::make_shared<BackgroundSubtractorLOBSTER>(),genFrame(oSize,0,0));
+    oEngine.push(0,cv::Mat(oSize*2,CV_8UC3,cv::Scalar::all(0))); // size mismatch with initialization size
+    ASSERT_ANY_THROW(oEngine.wait());
+    ASSERT_ANY_THROW(oEngine.push(0,genFrame(oSize,0,1)));
+}
+
+namespace {
+
+    void bgs_engine_perftest(benchmark::State& st) {
+        const cv::Size oSize(320,240);
+        const int nStreams = (int)st.range(0);
+        BackgroundSubtractionEngine oEngine;
+        std::vector<std::vector<cv::Mat>> vvoFrames(nStreams);
+        for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx) {
+            oEngine.addStream(std::make_shared<BackgroundSubtractorLOBSTER>(),genFrame(oSize,nStreamIdx,0));
+            for(int nFrameIdx=1; nFrameIdx<=4; ++nFrameIdx)
+                vvoFrames[nStreamIdx].push_back(genFrame(oSize,nStreamIdx,nFrameIdx));
+        }
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            for(int nStreamIdx=0; nStreamIdx<nStreams; ++nStreamIdx)
+                oEngine.push(nStreamIdx,vvoFrames[nStreamIdx][nFrameIdx%vvoFrames[nStreamIdx].size()]);
+            ++nFrameIdx;
+        }
+        oEngine.wait();
+        st.SetItemsProcessed(st.iterations()*nStreams);
+    }
+
+}
+
+BENCHMARK(bgs_engine_perftest)->Arg(8)->Arg(64)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
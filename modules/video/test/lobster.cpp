@@ -0,0 +1,96 @@
+
+#include "litiv/video/BackgroundSubtractorLOBSTER.hpp"
+#include "litiv/test.hpp"
+#include "common.hpp"
+
+namespace {
+
+    std::unique_ptr<BackgroundSubtractorLOBSTER> createAlgo(bool bUsePxMajorModel) {
+        return std::make_unique<BackgroundSubtractorLOBSTER>(BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD,BGSLOBSTER_DEFAULT_COLOR_DIST_THRESHOLD,
+                                                             BGSLOBSTER_DEFAULT_NB_BG_SAMPLES,BGSLOBSTER_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                                             BGSLBSP_DEFAULT_LBSP_OFFSET_SIMILARITY_THRESHOLD,BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,
+                                                             bUsePxMajorModel);
+    }
+
+}
+
+TEST(lobster,regression_px_major_model) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        std::unique_ptr<BackgroundSubtractorLOBSTER> pAlgo_planar = createAlgo(false), pAlgo_pxmajor = createAlgo(true);
+        const cv::Mat oInitFrame = genFrame(oSize,nChannels,0);
+        pAlgo_planar->initialize(oInitFrame);
+        pAlgo_pxmajor->initialize(oInitFrame);
+        cv::Mat oFGMask_planar, oFGMask_pxmajor;
+        for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx) {
+            const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+            pAlgo_planar->apply(oFrame,oFGMask_planar);
+            pAlgo_pxmajor->apply(oFrame,oFGMask_pxmajor);
+            ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_planar,oFGMask_pxmajor)) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+        pAlgo_planar->refreshModel(0.5f);
+        pAlgo_pxmajor->refreshModel(0.5f);
+        cv::Mat oBGImg_planar, oBGImg_pxmajor;
+        pAlgo_planar->getBackgroundImage(oBGImg_planar);
+        pAlgo_pxmajor->getBackgroundImage(oBGImg_pxmajor);
+        ASSERT_TRUE(lv::isEqual<uchar>(oBGImg_planar,oBGImg_pxmajor));
+        cv::Mat oBGDesc_planar, oBGDesc_pxmajor;
+        pAlgo_planar->getBackgroundDescriptorsImage(oBGDesc_planar);
+        pAlgo_pxmajor->getBackgroundDescriptorsImage(oBGDesc_pxmajor);
+        ASSERT_TRUE(lv::isEqual<ushort>(oBGDesc_planar,oBGDesc_pxmajor));
+    }
+}
+
+namespace {
+
+    /// exposes the background samples of a (default-constructed) LOBSTER instance for model state checks
+    struct BackgroundSubtractorLOBSTER_SamplesAccess : public BackgroundSubtractorLOBSTER {
+        std::string getSamplesDump() const {
+            std::stringstream ssSamples;
+            m_oBGSamples.write(ssSamples,lv::MatArchive_BINARY);
+            return ssSamples.str();
+        }
+    };
+
+}
+
+TEST(lobster,regression_infinite_learning_rate) {
+    for(int nChannels : {1,3}) {
+        for(bool bUseInfLearningRate : {false,true}) {
+            const cv::Size oSize(160,120);
+            BackgroundSubtractorLOBSTER_SamplesAccess oAlgo;
+            oAlgo.initialize(genFrame(oSize,nChannels,0));
+            const std::string sInitSamples = oAlgo.getSamplesDump();
+            const double dLearningRate = bUseInfLearningRate?std::numeric_limits<double>::infinity():oAlgo.getDefaultLearningRate();
+            cv::Mat oFGMask;
+            for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx)
+                oAlgo.apply(genFrame(oSize,nChannels,nFrameIdx),oFGMask,dLearningRate);
+            // with an infinite learning rate, the model must never be updated (the default rate is only checked to make sure samples can change here)
+            if(bUseInfLearningRate)
+                ASSERT_TRUE(oAlgo.getSamplesDump()==sInitSamples) << "nChannels=" << nChannels;
+            else
+                ASSERT_FALSE(oAlgo.getSamplesDump()==sInitSamples) << "nChannels=" << nChannels;
+        }
+    }
+}
+
+namespace {
+
+    void lobster_1080p_model_layout_perftest(benchmark::State& st) {
+        const cv::Size oSize(1920,1080);
+        std::unique_ptr<BackgroundSubtractorLOBSTER> pAlgo = createAlgo(st.range(0)!=0);
+        pAlgo->initialize(genFrame(oSize,3,0));
+        std::vector<cv::Mat> voFrames;
+        for(int nFrameIdx=1; nFrameIdx<=8; ++nFrameIdx)
+            voFrames.push_back(genFrame(oSize,3,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            pAlgo->apply(voFrames[(nFrameIdx++)%voFrames.size()],oFGMask);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+    }
+
+}
+
+BENCHMARK(lobster_1080p_model_layout_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -0,0 +1,120 @@
+
+#include "litiv/video/BackgroundSubtractorSuBSENSE.hpp"
+#include "litiv/test.hpp"
+
+namespace {
+
+    /// single pixel observation + model, packed as in the pixel-major layout of LBSPSampleModel
+    struct PxModelData {
+        size_t nChannels, nSamples;
+        std::array<uchar,3> anCurrColor;
+        std::array<ushort,3> anCurrIntraDesc;
+        alignas(16) std::array<std::array<uchar,LBSP::DESC_SIZE_BITS>,3> aanLBSPLookupVals;
+        std::vector<uchar> vnBGColors;
+        std::vector<ushort> vnBGDescs;
+    };
+
+    /// generates a random pixel observation & model, with values spread around a random base intensity
+    PxModelData genPxModel(cv::RNG& oRNG, size_t nChannels, size_t nSamples) {
+        PxModelData oData;
+        oData.nChannels = nChannels;
+        oData.nSamples = nSamples;
+        const int nBase = oRNG.uniform(0,256), nSpread = oRNG.uniform(1,64);
+        const auto lGenColor = [&]() {return cv::saturate_cast<uchar>(nBase+oRNG.uniform(-nSpread,nSpread));};
+        for(size_t c=0; c<nChannels; ++c) {
+            oData.anCurrColor[c] = lGenColor();
+            oData.anCurrIntraDesc[c] = (ushort)oRNG.uniform(0,USHRT_MAX+1);
+            for(size_t n=0; n<LBSP::DESC_SIZE_BITS; ++n)
+                oData.aanLBSPLookupVals[c][n] = lGenColor();
+        }
+        oData.vnBGColors.resize(nSamples*nChannels);
+        oData.vnBGDescs.resize(nSamples*nChannels);
+        for(size_t n=0; n<nSamples*nChannels; ++n) {
+            oData.vnBGColors[n] = lGenColor();
+            oData.vnBGDescs[n] = (ushort)(oRNG.uniform(0,USHRT_MAX+1)&oRNG.uniform(0,USHRT_MAX+1));
+        }
+        return oData;
+    }
+
+    /// default LUT used to threshold LBSP descriptors (same as in IBackgroundSubtractorLBSP with default params)
+    std::array<uchar,UCHAR_MAX+1> genThresholdLUT() {
+        std::array<uchar,UCHAR_MAX+1> anLUT;
+        for(size_t t=0; t<=UCHAR_MAX; ++t)
+            anLUT[t] = cv::saturate_cast<uchar>(t*BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD);
+        return anLUT;
+    }
+
+    LBSPSampleMatcher::Result match(const LBSPSampleMatcher& oMatcher, const LBSPSampleMatcher::Params& oParams, const PxModelData& oData, const std::array<uchar,UCHAR_MAX+1>& anLUT) {
+        return oMatcher.match(oParams,oData.anCurrColor.data(),oData.anCurrIntraDesc.data(),oData.aanLBSPLookupVals[0].data(),anLUT.data(),
+                              oData.vnBGColors.data(),oData.vnBGDescs.data(),oData.nSamples);
+    }
+
+}
+
+TEST(lbsp_matcher,regression_simd_vs_scalar) {
+    const std::array<uchar,UCHAR_MAX+1> anLUT = genThresholdLUT();
+    const LBSPSampleMatcher oMatcher_scalar(lv::SIMD_None);
+    std::vector<LBSPSampleMatcher> voMatchers;
+    for(lv::SIMDInstrSet eInstrSet : {lv::SIMD_SSE4_1,lv::SIMD_AVX2})
+        if(lv::isSIMDSupported(eInstrSet))
+            voMatchers.emplace_back(eInstrSet);
+    cv::RNG oRNG(0);
+    const auto lGenThreshold = [&](int nMax) {return oRNG.uniform(0,4)==0?SIZE_MAX:(size_t)oRNG.uniform(0,nMax);};
+    for(size_t nIter=0; nIter<50000; ++nIter) {
+        const size_t nChannels = oRNG.uniform(0,2)?3:1;
+        const PxModelData oData = genPxModel(oRNG,nChannels,(size_t)oRNG.uniform(1,51));
+        LBSPSampleMatcher::Params oParams;
+        oParams.nChannels = nChannels;
+        oParams.nRequiredSamples = (size_t)oRNG.uniform(1,5);
+        oParams.bUseIntraDesc = oRNG.uniform(0,2)!=0;
+        oParams.nSumDistDescShift = (size_t)oRNG.uniform(0,3);
+        oParams.nColorDistThreshold = lGenThreshold(UCHAR_MAX/2);
+        oParams.nDescDistThreshold = lGenThreshold(LBSP::DESC_SIZE_BITS+1);
+        oParams.nSumDistThreshold = lGenThreshold(UCHAR_MAX+1);
+        oParams.nTotColorDistThreshold = lGenThreshold(UCHAR_MAX*3/2);
+        oParams.nTotDescDistThreshold = lGenThreshold(LBSP::DESC_SIZE_BITS*3+1);
+        oParams.nTotSumDistThreshold = lGenThreshold(UCHAR_MAX*3+1);
+        const LBSPSampleMatcher::Result oRes_scalar = match(oMatcher_scalar,oParams,oData,anLUT);
+        ASSERT_LE(oRes_scalar.nGoodSamples,oParams.nRequiredSamples);
+        for(const LBSPSampleMatcher& oMatcher : voMatchers) {
+            const LBSPSampleMatcher::Result oRes = match(oMatcher,oParams,oData,anLUT);
+            ASSERT_EQ(oRes_scalar.nGoodSamples,oRes.nGoodSamples) << "instr set = " << (int)oMatcher.getInstrSet() << ", iter = " << nIter;
+            ASSERT_EQ(oRes_scalar.nMinDescDist,oRes.nMinDescDist) << "instr set = " << (int)oMatcher.getInstrSet() << ", iter = " << nIter;
+            ASSERT_EQ(oRes_scalar.nMinSumDist,oRes.nMinSumDist) << "instr set = " << (int)oMatcher.getInstrSet() << ", iter = " << nIter;
+        }
+    }
+}
+
+TEST(lbsp_matcher,regression_instr_set_fallback) {
+    ASSERT_EQ(LBSPSampleMatcher(lv::SIMD_None).getInstrSet(),lv::SIMD_None);
+    ASSERT_EQ(LBSPSampleMatcher(lv::SIMD_SSE2).getInstrSet(),lv::SIMD_None);
+    const lv::SIMDInstrSet eBestInstrSet = LBSPSampleMatcher().getInstrSet();
+    ASSERT_TRUE(eBestInstrSet==lv::SIMD_None || lv::isSIMDSupported(eBestInstrSet));
+    ASSERT_EQ(LBSPSampleMatcher(lv::SIMD_AVX2).getInstrSet(),eBestInstrSet);
+}
+
+namespace {
+
+    void lbsp_matcher_perftest(benchmark::State& st) {
+        // args: instruction set (falls back to the next best one if unsupported), channel count; thresholds mimic SuBSENSE's initial ones
+        const LBSPSampleMatcher oMatcher((lv::SIMDInstrSet)st.range(0));
+        const size_t nChannels = (size_t)st.range(1);
+        const std::array<uchar,UCHAR_MAX+1> anLUT = genThresholdLUT();
+        cv::RNG oRNG(0);
+        std::vector<PxModelData> voData;
+        for(size_t n=0; n<1024; ++n)
+            voData.push_back(genPxModel(oRNG,nChannels,BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES));
+        const LBSPSampleMatcher::Params oParams = {nChannels,2,true,nChannels==1?2u:1u,
+                                                   nChannels==1?15u:45u,nChannels==1?6u:SIZE_MAX,nChannels==1?15u:45u,
+                                                   SIZE_MAX,nChannels==1?SIZE_MAX:18u,nChannels==1?SIZE_MAX:90u};
+        size_t nIter = 0;
+        while(st.KeepRunning()) {
+            const LBSPSampleMatcher::Result oRes = match(oMatcher,oParams,voData[(nIter++)%voData.size()],anLUT);
+            benchmark::DoNotOptimize(oRes);
+        }
+    }
+
+}
+
+BENCHMARK(lbsp_matcher_perftest)->Args({lv::SIMD_None,1})->Args({lv::SIMD_SSE4_1,1})->Args({lv::SIMD_AVX2,1})->Unit(benchmark::kNanosecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(lbsp_matcher_perftest)->Args({lv::SIMD_None,3})->Args({lv::SIMD_SSE4_1,3})->Args({lv::SIMD_AVX2,3})->Unit(benchmark::kNanosecond)->Repetitions(5)->ReportAggregatesOnly(true);
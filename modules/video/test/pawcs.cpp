@@ -0,0 +1,142 @@
+
+#include "litiv/video/BackgroundSubtractorPAWCS.hpp"
+#include "litiv/test.hpp"
+#include "common.hpp"
+
+namespace {
+
+    /// exposes the internal word arenas of PAWCS for layout checks & memory footprint reports
+    struct BackgroundSubtractorPAWCS_Inspector : BackgroundSubtractorPAWCS {
+        /// returns whether all dictionaries are valid permutations of their word pool (slices)
+        bool isWordArenaValid() {
+            const auto lIsPermutation = [](const ushort* anIndices, size_t nCount) {
+                std::vector<bool> vbFound(nCount,false);
+                for(size_t nIdx=0; nIdx<nCount; ++nIdx) {
+                    if(anIndices[nIdx]>=nCount || vbFound[anIndices[nIdx]])
+                        return false;
+                    vbFound[anIndices[nIdx]] = true;
+                }
+                return true;
+            };
+            for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter)
+                if(!lIsPermutation(m_vnLocalWordDict.data()+nModelIter*m_nCurrLocalWords,m_nCurrLocalWords) ||
+                   !lIsPermutation(m_vnGlobalDictSortLUT.data()+nModelIter*m_nCurrGlobalWords,m_nCurrGlobalWords))
+                    return false;
+            if(!lIsPermutation(m_vnGlobalWordDict.data(),m_nCurrGlobalWords))
+                return false;
+            for(size_t nGlobalWordIdx=0; nGlobalWordIdx<m_nCurrGlobalWords; ++nGlobalWordIdx) {
+                const cv::Mat& oSpatioOccMap = getGlobalWord(nGlobalWordIdx).oSpatioOccMap;
+                if(oSpatioOccMap.size()!=m_oDownSampledFrameSize_GlobalWordLookup || oSpatioOccMap.data!=m_oGlobalWordSpatioOccMaps.data+nGlobalWordIdx*oSpatioOccMap.total()*sizeof(float))
+                    return false;
+            }
+            return true;
+        }
+        /// returns the current weight of a local word, given its index in the local word pool
+        float getLocalWordWeight(size_t nWordIdx) const {
+            const LocalWordBase& oLocalWord = (m_nImgChannels==1)?(const LocalWordBase&)m_voLocalWordList_1ch[nWordIdx]:(const LocalWordBase&)m_voLocalWordList_3ch[nWordIdx];
+            return GetLocalWordWeight(oLocalWord,m_nFrameIdx,m_nLocalWordWeightOffset);
+        }
+        /// returns whether all local dictionaries are in descending order of cached weights, and whether these weights are all up-to-date or stale
+        /// (i.e. never lower than the current word weights, as these only decay over time until the word is scanned or updated again)
+        bool areLocalDictsSorted() const {
+            for(size_t nModelIter=0; nModelIter<m_nTotRelevantPxCount; ++nModelIter) {
+                const size_t nLocalDictIdx = nModelIter*m_nCurrLocalWords;
+                float fLastLocalWordWeight = FLT_MAX;
+                for(size_t nLocalWordIdx=0; nLocalWordIdx<m_nCurrLocalWords; ++nLocalWordIdx) {
+                    const float fCachedLocalWordWeight = m_vfLocalWordWeights[nLocalDictIdx+nLocalWordIdx];
+                    if(fCachedLocalWordWeight>fLastLocalWordWeight || fCachedLocalWordWeight<getLocalWordWeight(nLocalDictIdx+m_vnLocalWordDict[nLocalDictIdx+nLocalWordIdx]))
+                        return false;
+                    fLastLocalWordWeight = fCachedLocalWordWeight;
+                }
+            }
+            return true;
+        }
+        /// returns whether any px of the latest frame went through an illumination update (these are only drawn at the local word update rate)
+        bool hasIllumUpdates() const {
+            return cv::countNonZero(m_oIllumUpdtRegionMask)>0;
+        }
+        /// returns the memory used by word dictionaries & px info LUTs
+        size_t getDictFootprint() const {
+            return (m_vnLocalWordDict.size()+m_vnGlobalWordDict.size()+m_vnGlobalDictSortLUT.size())*sizeof(ushort)+m_voPxInfoLUT_PAWCS.size()*sizeof(PxInfo_PAWCS);
+        }
+        /// returns the memory that the same dictionaries & LUTs would use with word pointers and per-px sort LUT vectors
+        size_t getPointerDictFootprint() const {
+            return (m_vnLocalWordDict.size()+m_vnGlobalWordDict.size()+m_vnGlobalDictSortLUT.size())*sizeof(void*)+
+                   m_voPxInfoLUT_PAWCS.size()*(sizeof(PxInfo_PAWCS)+sizeof(std::vector<void*>));
+        }
+    };
+
+}
+
+TEST(pawcs,regression_word_arena) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        BackgroundSubtractorPAWCS_Inspector oAlgo;
+        oAlgo.initialize(genFrame(oSize,nChannels,0));
+        ASSERT_TRUE(oAlgo.isWordArenaValid()) << "nChannels=" << nChannels;
+        ASSERT_TRUE(oAlgo.areLocalDictsSorted()) << "nChannels=" << nChannels;
+        cv::Mat oFGMask;
+        for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx)
+            oAlgo.apply(genFrame(oSize,nChannels,nFrameIdx),oFGMask);
+        ASSERT_TRUE(oAlgo.isWordArenaValid()) << "nChannels=" << nChannels;
+        ASSERT_LT(oAlgo.getDictFootprint(),oAlgo.getPointerDictFootprint());
+    }
+}
+
+TEST(pawcs,regression_sorted_local_dicts) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        BackgroundSubtractorPAWCS_Inspector oAlgo;
+        oAlgo.initialize(genFrame(oSize,nChannels,0));
+        ASSERT_TRUE(oAlgo.areLocalDictsSorted()) << "nChannels=" << nChannels;
+        cv::Mat oFGMask;
+        for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx) {
+            oAlgo.apply(genFrame(oSize,nChannels,nFrameIdx),oFGMask);
+            ASSERT_TRUE(oAlgo.areLocalDictsSorted()) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+    }
+}
+
+TEST(pawcs,regression_infinite_learning_rate) {
+    for(int nChannels : {1,3}) {
+        for(bool bUseInfLearningRate : {false,true}) {
+            const cv::Size oSize(160,120);
+            BackgroundSubtractorPAWCS_Inspector oAlgo;
+            oAlgo.initialize(genFrame(oSize,nChannels,0));
+            const double dLearningRate = bUseInfLearningRate?std::numeric_limits<double>::infinity():oAlgo.getDefaultLearningRate();
+            bool bFoundIllumUpdates = false;
+            cv::Mat oFGMask;
+            for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx) {
+                oAlgo.apply(genFrame(oSize,nChannels,nFrameIdx),oFGMask,dLearningRate);
+                bFoundIllumUpdates |= oAlgo.hasIllumUpdates();
+            }
+            // with an infinite learning rate, randomized word updates must never be drawn (the default rate is only checked to make sure they can happen here)
+            ASSERT_EQ(!bUseInfLearningRate,bFoundIllumUpdates) << "nChannels=" << nChannels;
+        }
+    }
+}
+
+namespace {
+
+    void pawcs_vga_perftest(benchmark::State& st) {
+        const cv::Size oSize(640,480);
+        const int nChannels = (int)st.range(0);
+        BackgroundSubtractorPAWCS_Inspector oAlgo;
+        oAlgo.initialize(genFrame(oSize,nChannels,0));
+        std::vector<cv::Mat> voFrames;
+        for(int nFrameIdx=1; nFrameIdx<=8; ++nFrameIdx)
+            voFrames.push_back(genFrame(oSize,nChannels,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            oAlgo.apply(voFrames[(nFrameIdx++)%voFrames.size()],oFGMask);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+        std::stringstream ssLabel;
+        ssLabel << "dicts=" << oAlgo.getDictFootprint()/1024 << "KB (vs " << oAlgo.getPointerDictFootprint()/1024 << "KB w/ pointers)";
+        st.SetLabel(ssLabel.str());
+    }
+
+}
+
+BENCHMARK(pawcs_vga_perftest)->Arg(1)->Arg(3)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -0,0 +1,152 @@
+
+#include "litiv/video/BackgroundSubtractionPostProcessor.hpp"
+#include "litiv/test.hpp"
+
+namespace {
+
+    /// generates a binary fg mask with random (hollow & filled) blobs and salt noise, which is identical for all calls with the same frame index
+    cv::Mat genMask(const cv::Size& oSize, int nFrameIdx) {
+        cv::Mat oMask(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+        cv::RNG oRNG((uint64)(nFrameIdx+1));
+        const int nMaxRadius = std::max(std::min(oSize.width,oSize.height)/6,2);
+        for(int nBlobIdx=0; nBlobIdx<8; ++nBlobIdx) {
+            const cv::Point oCenter(oRNG.uniform(0,oSize.width),oRNG.uniform(0,oSize.height));
+            const int nRadius = oRNG.uniform(1,nMaxRadius+1);
+            cv::circle(oMask,oCenter,nRadius,cv::Scalar_<uchar>(UCHAR_MAX),(nBlobIdx%2)?-1:std::max(nRadius/4,1));
+        }
+        cv::Mat oNoise(oSize,CV_8UC1);
+        oRNG.fill(oNoise,cv::RNG::UNIFORM,0,100);
+        oMask.setTo(cv::Scalar_<uchar>(UCHAR_MAX),oNoise<4);
+        oMask.setTo(cv::Scalar_<uchar>(0),oNoise>96);
+        if(nFrameIdx%5==0)
+            oMask.at<uchar>(0,0) = UCHAR_MAX; // flood fill seed lands on fg (whole frame becomes a 'hole')
+        return oMask;
+    }
+
+    /// original (unfused) SuBSENSE/PAWCS post-processing chain, used as reference
+    struct ReferencePostProcessor {
+        explicit ReferencePostProcessor(const cv::Size& oSize) {
+            for(cv::Mat* pMat : {&m_oLastFGMask,&m_oLastFGMask_dilated,&m_oLastFGMask_dilated_inverted,&m_oLastRawFGMask,&m_oLastRawFGBlinkMask,&m_oBlinksMask})
+                *pMat = cv::Mat(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+            m_oMorphExStructElement = cv::getStructuringElement(cv::MORPH_RECT,cv::Size(3,3));
+        }
+        void apply(cv::Mat& oFGMask, int nMedianBlurKernelSize) {
+            cv::bitwise_xor(oFGMask,m_oLastRawFGMask,m_oCurrRawFGBlinkMask);
+            cv::bitwise_or(m_oCurrRawFGBlinkMask,m_oLastRawFGBlinkMask,m_oBlinksMask);
+            m_oCurrRawFGBlinkMask.copyTo(m_oLastRawFGBlinkMask);
+            oFGMask.copyTo(m_oLastRawFGMask);
+            cv::morphologyEx(oFGMask,m_oFGMask_PreFlood,cv::MORPH_CLOSE,m_oMorphExStructElement);
+            m_oFGMask_PreFlood.copyTo(m_oFGMask_FloodedHoles);
+            cv::floodFill(m_oFGMask_FloodedHoles,cv::Point(0,0),UCHAR_MAX);
+            cv::bitwise_not(m_oFGMask_FloodedHoles,m_oFGMask_FloodedHoles);
+            cv::erode(m_oFGMask_PreFlood,m_oFGMask_PreFlood,cv::Mat(),cv::Point(-1,-1),3);
+            cv::bitwise_or(oFGMask,m_oFGMask_FloodedHoles,oFGMask);
+            cv::bitwise_or(oFGMask,m_oFGMask_PreFlood,oFGMask);
+            cv::medianBlur(oFGMask,m_oLastFGMask,nMedianBlurKernelSize);
+            cv::dilate(m_oLastFGMask,m_oLastFGMask_dilated,cv::Mat(),cv::Point(-1,-1),3);
+            cv::bitwise_and(m_oBlinksMask,m_oLastFGMask_dilated_inverted,m_oBlinksMask);
+            cv::bitwise_not(m_oLastFGMask_dilated,m_oLastFGMask_dilated_inverted);
+            cv::bitwise_and(m_oBlinksMask,m_oLastFGMask_dilated_inverted,m_oBlinksMask);
+            m_oLastFGMask.copyTo(oFGMask);
+        }
+        cv::Mat m_oLastFGMask, m_oLastFGMask_dilated, m_oLastFGMask_dilated_inverted;
+        cv::Mat m_oLastRawFGMask, m_oLastRawFGBlinkMask, m_oBlinksMask;
+        cv::Mat m_oFGMask_PreFlood, m_oFGMask_FloodedHoles, m_oCurrRawFGBlinkMask, m_oMorphExStructElement;
+    };
+
+}
+
+TEST(bgs_postproc,regression_reference) {
+    for(const cv::Size& oSize : {cv::Size(160,120),cv::Size(37,23),cv::Size(5,3),cv::Size(321,243)}) {
+        for(int nMedianBlurKernelSize : {1,3,5,9,13}) {
+            for(size_t nWorkers : {1,4}) {
+                BackgroundSubtractionPostProcessor oPostProc(nWorkers,8);
+                oPostProc.initialize(oSize);
+                ReferencePostProcessor oRefPostProc(oSize);
+                for(int nFrameIdx=0; nFrameIdx<12; ++nFrameIdx) {
+                    cv::Mat oFGMask = genMask(oSize,nFrameIdx), oFGMask_ref = oFGMask.clone();
+                    oPostProc.apply(oFGMask,nMedianBlurKernelSize);
+                    oRefPostProc.apply(oFGMask_ref,nMedianBlurKernelSize);
+                    std::stringstream ssInfo;
+                    ssInfo << "size=" << oSize << ", ksize=" << nMedianBlurKernelSize << ", workers=" << nWorkers << ", nFrameIdx=" << nFrameIdx;
+                    ASSERT_TRUE(lv::isEqual<uchar>(oFGMask,oFGMask_ref)) << ssInfo.str();
+                    ASSERT_TRUE(lv::isEqual<uchar>(oPostProc.getLastFGMask(),oRefPostProc.m_oLastFGMask)) << ssInfo.str();
+                    ASSERT_TRUE(lv::isEqual<uchar>(oPostProc.getLastFGMaskDilated(),oRefPostProc.m_oLastFGMask_dilated)) << ssInfo.str();
+                    ASSERT_TRUE(lv::isEqual<uchar>(oPostProc.getBlinksMask(),oRefPostProc.m_oBlinksMask)) << ssInfo.str();
+                }
+            }
+        }
+    }
+}
+
+TEST(bgs_postproc,regression_external_state) {
+    const cv::Size oSize(160,120);
+    BackgroundSubtractionPostProcessor oPostProc_internal, oPostProc_external;
+    oPostProc_internal.initialize(oSize);
+    oPostProc_external.initialize(oSize);
+    std::array<cv::Mat,6> aoStates;
+    for(cv::Mat& oState : aoStates)
+        oState = cv::Mat(oSize,CV_8UC1,cv::Scalar_<uchar>(0));
+    for(int nFrameIdx=0; nFrameIdx<10; ++nFrameIdx) {
+        cv::Mat oFGMask_internal = genMask(oSize,nFrameIdx), oFGMask_external = oFGMask_internal.clone();
+        oPostProc_internal.apply(oFGMask_internal,9);
+        oPostProc_external.apply(oFGMask_external,9,aoStates[0],aoStates[1],aoStates[2],aoStates[3],aoStates[4],aoStates[5]);
+        ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_internal,oFGMask_external));
+        ASSERT_TRUE(lv::isEqual<uchar>(oPostProc_internal.getBlinksMask(),aoStates[5]));
+    }
+    cv::Mat oBadMask(cv::Size(80,60),CV_8UC1,cv::Scalar_<uchar>(0));
+    ASSERT_THROW_LV_QUIET(oPostProc_internal.apply(oBadMask,9));
+    cv::Mat oFGMask = genMask(oSize,0);
+    ASSERT_THROW_LV_QUIET(oPostProc_internal.apply(oFGMask,4));
+}
+
+namespace {
+
+    /// frame sizes used in post-processing benchmarks (720p, 1080p & 4K)
+    const std::array<cv::Size,3> s_aoPerfTestSizes = {cv::Size(1280,720),cv::Size(1920,1080),cv::Size(3840,2160)};
+
+    void postproc_fused_perftest(benchmark::State& st) {
+        const cv::Size oSize = s_aoPerfTestSizes[st.range(0)];
+        BackgroundSubtractionPostProcessor oPostProc;
+        oPostProc.initialize(oSize);
+        std::vector<cv::Mat> voMasks;
+        for(int nFrameIdx=0; nFrameIdx<4; ++nFrameIdx)
+            voMasks.push_back(genMask(oSize,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            st.PauseTiming();
+            voMasks[(nFrameIdx++)%voMasks.size()].copyTo(oFGMask);
+            st.ResumeTiming();
+            oPostProc.apply(oFGMask,9);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+        std::stringstream ssLabel;
+        ssLabel << oSize;
+        st.SetLabel(ssLabel.str());
+    }
+
+    void postproc_reference_perftest(benchmark::State& st) {
+        const cv::Size oSize = s_aoPerfTestSizes[st.range(0)];
+        ReferencePostProcessor oRefPostProc(oSize);
+        std::vector<cv::Mat> voMasks;
+        for(int nFrameIdx=0; nFrameIdx<4; ++nFrameIdx)
+            voMasks.push_back(genMask(oSize,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            st.PauseTiming();
+            voMasks[(nFrameIdx++)%voMasks.size()].copyTo(oFGMask);
+            st.ResumeTiming();
+            oRefPostProc.apply(oFGMask,9);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+        std::stringstream ssLabel;
+        ssLabel << oSize;
+        st.SetLabel(ssLabel.str());
+    }
+
+}
+
+BENCHMARK(postproc_fused_perftest)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(postproc_reference_perftest)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -0,0 +1,129 @@
+
+#include "litiv/video/BackgroundSubtractorPyramid.hpp"
+#include "litiv/video/BackgroundSubtractorLOBSTER.hpp"
+#include "litiv/test.hpp"
+
+namespace {
+
+    /// generates a noisy synthetic frame with a moving square (or without it, for index 0), and returns the square's location
+    cv::Mat genFrame(const cv::Size& oSize, int nChannels, int nFrameIdx, cv::Rect* pSquareRect=nullptr) {
+        cv::Mat oFrame(oSize,CV_8UC(nChannels));
+        cv::RNG oRNG((uint64)(nFrameIdx+1));
+        oRNG.fill(oFrame,cv::RNG::UNIFORM,cv::Scalar::all(100),cv::Scalar::all(116));
+        const int nSquareSize = std::max(oSize.height/6,4);
+        const cv::Point oTopLeft((nFrameIdx*7)%std::max(oSize.width-nSquareSize,1),(nFrameIdx*3)%std::max(oSize.height-nSquareSize,1));
+        const cv::Rect oSquareRect = (nFrameIdx>0)?cv::Rect(oTopLeft,cv::Size(nSquareSize,nSquareSize)):cv::Rect();
+        if(nFrameIdx>0)
+            cv::rectangle(oFrame,oSquareRect,cv::Scalar::all(230),-1);
+        if(pSquareRect)
+            *pSquareRect = oSquareRect;
+        return oFrame;
+    }
+
+    /// returns the F-measure of a foreground mask w.r.t. a single rectangular foreground object
+    double getFMeasure(const cv::Mat& oFGMask, const cv::Rect& oGTRect) {
+        cv::Mat oGTMask(oFGMask.size(),CV_8UC1,cv::Scalar_<uchar>(0));
+        oGTMask(oGTRect) = cv::Scalar_<uchar>(UCHAR_MAX);
+        const double dTP = cv::countNonZero(oFGMask&oGTMask);
+        const double dFP = cv::countNonZero(oFGMask&~oGTMask);
+        const double dFN = cv::countNonZero(~oFGMask&oGTMask);
+        return (2*dTP)/std::max(2*dTP+dFP+dFN,1.0);
+    }
+
+}
+
+TEST(bgs_pyramid,regression_no_downscaling) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        auto pAlgo_wrapped = std::make_shared<BackgroundSubtractorLOBSTER>();
+        BackgroundSubtractorPyramid oAlgo_pyramid(pAlgo_wrapped,0);
+        BackgroundSubtractorLOBSTER oAlgo_direct;
+        oAlgo_pyramid.setSeed(42);
+        oAlgo_direct.setSeed(42);
+        oAlgo_pyramid.initialize(genFrame(oSize,nChannels,0));
+        oAlgo_direct.initialize(genFrame(oSize,nChannels,0));
+        ASSERT_EQ(oAlgo_pyramid.getDownSampledFrameSize(),oSize);
+        cv::Mat oFGMask_pyramid, oFGMask_direct;
+        for(int nFrameIdx=1; nFrameIdx<=20; ++nFrameIdx) {
+            const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+            oAlgo_pyramid.apply(oFrame,oFGMask_pyramid);
+            oAlgo_direct.apply(oFrame,oFGMask_direct,oAlgo_direct.getDefaultLearningRate());
+            ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_pyramid,oFGMask_direct)) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+    }
+}
+
+TEST(bgs_pyramid,regression_detection) {
+    for(int nChannels : {1,3}) {
+        for(size_t nPyramidLevels : {1,2}) {
+            for(bool bUseBlobRefinement : {false,true}) {
+                const cv::Size oSize(320,240);
+                BackgroundSubtractorPyramid oAlgo(std::make_shared<BackgroundSubtractorLOBSTER>(),nPyramidLevels,bUseBlobRefinement);
+                oAlgo.initialize(genFrame(oSize,nChannels,0));
+                ASSERT_EQ(oAlgo.getDownSampledFrameSize(),cv::Size(oSize.width>>nPyramidLevels,oSize.height>>nPyramidLevels));
+                cv::Mat oFGMask;
+                cv::Rect oSquareRect;
+                double dFMeasureSum = 0.0;
+                for(int nFrameIdx=1; nFrameIdx<=30; ++nFrameIdx) {
+                    oAlgo.apply(genFrame(oSize,nChannels,nFrameIdx,&oSquareRect),oFGMask);
+                    ASSERT_EQ(oFGMask.size(),oSize);
+                    ASSERT_EQ(oFGMask.type(),CV_8UC1);
+                    ASSERT_EQ(cv::countNonZero((oFGMask>0)&(oFGMask<UCHAR_MAX)),0);
+                    if(nFrameIdx>10)
+                        dFMeasureSum += getFMeasure(oFGMask,oSquareRect);
+                }
+                ASSERT_GT(dFMeasureSum/20,0.5) << "nChannels=" << nChannels << ", nPyramidLevels=" << nPyramidLevels << ", bUseBlobRefinement=" << bUseBlobRefinement;
+            }
+        }
+    }
+}
+
+TEST(bgs_pyramid,regression_runtime_levels) {
+    const cv::Size oSize(320,240);
+    BackgroundSubtractorPyramid oAlgo(std::make_shared<BackgroundSubtractorLOBSTER>(),1);
+    oAlgo.initialize(genFrame(oSize,3,0));
+    cv::Mat oFGMask;
+    for(int nFrameIdx=1; nFrameIdx<=5; ++nFrameIdx)
+        oAlgo.apply(genFrame(oSize,3,nFrameIdx),oFGMask);
+    oAlgo.setPyramidLevels(2);
+    ASSERT_EQ(oAlgo.getPyramidLevels(),size_t(2));
+    ASSERT_EQ(oAlgo.getDownSampledFrameSize(),cv::Size(80,60));
+    for(int nFrameIdx=6; nFrameIdx<=10; ++nFrameIdx)
+        oAlgo.apply(genFrame(oSize,3,nFrameIdx),oFGMask);
+    ASSERT_EQ(oFGMask.size(),oSize);
+    cv::Mat oBGImg;
+    oAlgo.getBackgroundImage(oBGImg);
+    ASSERT_EQ(oBGImg.size(),oSize);
+    ASSERT_EQ(oBGImg.type(),CV_8UC3);
+    ASSERT_ANY_THROW(oAlgo.setPyramidLevels(16));
+}
+
+namespace {
+
+    void pyramid_vga_perftest(benchmark::State& st) {
+        const cv::Size oSize(640,480);
+        const size_t nPyramidLevels = (size_t)st.range(0);
+        BackgroundSubtractorPyramid oAlgo(std::make_shared<BackgroundSubtractorLOBSTER>(),nPyramidLevels);
+        oAlgo.initialize(genFrame(oSize,3,0));
+        std::vector<cv::Mat> voFrames;
+        std::vector<cv::Rect> voSquareRects(8);
+        for(int nFrameIdx=1; nFrameIdx<=8; ++nFrameIdx)
+            voFrames.push_back(genFrame(oSize,3,nFrameIdx,&voSquareRects[nFrameIdx-1]));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        double dFMeasureSum = 0.0;
+        while(st.KeepRunning()) {
+            oAlgo.apply(voFrames[nFrameIdx%voFrames.size()],oFGMask);
+            st.PauseTiming();
+            dFMeasureSum += getFMeasure(oFGMask,voSquareRects[nFrameIdx%voFrames.size()]);
+            st.ResumeTiming();
+            ++nFrameIdx;
+        }
+        std::stringstream ssLabel;
+        ssLabel << "levels=" << nPyramidLevels << ", F=" << std::fixed << std::setprecision(3) << dFMeasureSum/std::max(nFrameIdx,size_t(1));
+        st.SetLabel(ssLabel.str());
+    }
+
+}
+
+BENCHMARK(pyramid_vga_perftest)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
@@ -0,0 +1,53 @@
+
+#include "litiv/video/BackgroundSubtractorLOBSTER.hpp"
+#include "litiv/video/BackgroundSubtractorSuBSENSE.hpp"
+#include "litiv/video/BackgroundSubtractorPAWCS.hpp"
+#include "litiv/test.hpp"
+#include "common.hpp"
+
+namespace {
+
+    /// runs two instances seeded identically side-by-side (while messing with the global rand state) and checks that their outputs match
+    template<typename TAlgo>
+    void testSeedReproducibility(int nSeed) {
+        for(int nChannels : {1,3}) {
+            const cv::Size oSize(160,120);
+            TAlgo oAlgo_a, oAlgo_b;
+            oAlgo_a.setSeed(nSeed);
+            oAlgo_b.setSeed(nSeed);
+            const cv::Mat oInitFrame = genFrame(oSize,nChannels,0);
+            srand(1);
+            oAlgo_a.initialize(oInitFrame);
+            srand(2);
+            oAlgo_b.initialize(oInitFrame);
+            cv::Mat oFGMask_a, oFGMask_b;
+            for(int nFrameIdx=1; nFrameIdx<=30; ++nFrameIdx) {
+                const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+                srand((unsigned)nFrameIdx);
+                oAlgo_a.apply(oFrame,oFGMask_a);
+                oAlgo_b.apply(oFrame,oFGMask_b);
+                ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_a,oFGMask_b)) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+            }
+            cv::Mat oBGImg_a, oBGImg_b;
+            oAlgo_a.getBackgroundImage(oBGImg_a);
+            oAlgo_b.getBackgroundImage(oBGImg_b);
+            ASSERT_TRUE(lv::isEqual<uchar>(oBGImg_a,oBGImg_b));
+        }
+    }
+
+}
+
+TEST(bgs_seed,regression_lobster) {
+    testSeedReproducibility<BackgroundSubtractorLOBSTER>(0);
+    testSeedReproducibility<BackgroundSubtractorLOBSTER>(1337);
+}
+
+TEST(bgs_seed,regression_subsense) {
+    testSeedReproducibility<BackgroundSubtractorSuBSENSE>(0);
+    testSeedReproducibility<BackgroundSubtractorSuBSENSE>(1337);
+}
+
+TEST(bgs_seed,regression_pawcs) {
+    testSeedReproducibility<BackgroundSubtractorPAWCS>(0);
+    testSeedReproducibility<BackgroundSubtractorPAWCS>(1337);
+}
@@ -0,0 +1,126 @@
+
+#include "litiv/video/BackgroundSubtractorLOBSTER.hpp"
+#include "litiv/video/BackgroundSubtractorSuBSENSE.hpp"
+#include "litiv/video/BackgroundSubtractorPAWCS.hpp"
+#include "litiv/test.hpp"
+#include "common.hpp"
+
+namespace {
+
+    /// exposes the word dictionaries of PAWCS so that they can be corrupted before writing a snapshot
+    struct BackgroundSubtractorPAWCS_Corruptor : BackgroundSubtractorPAWCS {
+        /// empties a local dict slot (0), duplicates a global dict entry (1), or duplicates a global sort LUT entry (2)
+        void corruptDict(int nDictType) {
+            if(nDictType==0)
+                m_vnLocalWordDict[m_nCurrLocalWords/2] = USHRT_MAX;
+            else if(nDictType==1)
+                m_vnGlobalWordDict[1] = m_vnGlobalWordDict[0];
+            else //nDictType==2
+                m_vnGlobalDictSortLUT[m_nCurrGlobalWords] = m_vnGlobalDictSortLUT[m_nCurrGlobalWords+1];
+        }
+    };
+
+    /// runs an instance for a while, restores its snapshot in a fresh one, and checks that both produce the same output afterwards
+    template<typename TAlgo>
+    void testSnapshotRestore(const std::function<std::unique_ptr<TAlgo>()>& lCreator_src, const std::function<std::unique_ptr<TAlgo>()>& lCreator_dst) {
+        for(bool bUseROI : {false,true}) {
+            for(bool bUseCompression : {false,true}) {
+                for(int nChannels : {1,3}) {
+                    const cv::Size oSize(160,120);
+                    cv::Mat oROI;
+                    if(bUseROI) {
+                        oROI.create(oSize,CV_8UC1);
+                        oROI = cv::Scalar_<uchar>(UCHAR_MAX);
+                        cv::rectangle(oROI,cv::Rect(0,0,40,30),cv::Scalar_<uchar>(0),-1);
+                    }
+                    std::unique_ptr<TAlgo> pAlgo_src = lCreator_src(), pAlgo_dst = lCreator_dst();
+                    pAlgo_src->setSeed(42);
+                    pAlgo_src->initialize(genFrame(oSize,nChannels,0),oROI);
+                    cv::Mat oFGMask_src, oFGMask_dst;
+                    int nFrameIdx = 1;
+                    for(; nFrameIdx<=20; ++nFrameIdx)
+                        pAlgo_src->apply(genFrame(oSize,nChannels,nFrameIdx),oFGMask_src,pAlgo_src->getDefaultLearningRate());
+                    std::stringstream ssSnapshot;
+                    pAlgo_src->save(ssSnapshot,bUseCompression);
+                    pAlgo_dst->load(ssSnapshot);
+                    cv::Mat oBGImg_src, oBGImg_dst;
+                    pAlgo_src->getBackgroundImage(oBGImg_src);
+                    pAlgo_dst->getBackgroundImage(oBGImg_dst);
+                    ASSERT_TRUE(lv::isEqual<uchar>(oBGImg_src,oBGImg_dst)) << "nChannels=" << nChannels << ", bUseROI=" << bUseROI;
+                    ASSERT_TRUE(lv::isEqual<uchar>(pAlgo_src->getROICopy(),pAlgo_dst->getROICopy())) << "nChannels=" << nChannels << ", bUseROI=" << bUseROI;
+                    for(; nFrameIdx<=40; ++nFrameIdx) {
+                        const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+                        pAlgo_src->apply(oFrame,oFGMask_src,pAlgo_src->getDefaultLearningRate());
+                        pAlgo_dst->apply(oFrame,oFGMask_dst,pAlgo_dst->getDefaultLearningRate());
+                        ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_src,oFGMask_dst)) << "nChannels=" << nChannels << ", bUseROI=" << bUseROI << ", nFrameIdx=" << nFrameIdx;
+                    }
+                }
+            }
+        }
+    }
+
+}
+
+TEST(bgs_snapshot,regression_lobster) {
+    const auto lCreator_planar = [](){return std::make_unique<BackgroundSubtractorLOBSTER>();};
+    const auto lCreator_pxmajor = [](){
+        return std::make_unique<BackgroundSubtractorLOBSTER>(BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD,BGSLOBSTER_DEFAULT_COLOR_DIST_THRESHOLD,BGSLOBSTER_DEFAULT_NB_BG_SAMPLES,
+                                                             BGSLOBSTER_DEFAULT_REQUIRED_NB_BG_SAMPLES,BGSLBSP_DEFAULT_LBSP_OFFSET_SIMILARITY_THRESHOLD,
+                                                             BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,true);
+    };
+    testSnapshotRestore<BackgroundSubtractorLOBSTER>(lCreator_planar,lCreator_planar);
+    testSnapshotRestore<BackgroundSubtractorLOBSTER>(lCreator_planar,lCreator_pxmajor);
+}
+
+TEST(bgs_snapshot,regression_subsense) {
+    const auto lCreator_planar = [](){return std::make_unique<BackgroundSubtractorSuBSENSE>();};
+    const auto lCreator_pxmajor = [](){
+        return std::make_unique<BackgroundSubtractorSuBSENSE>(BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET,BGSSUBSENSE_DEFAULT_MIN_COLOR_DIST_THRESHOLD,
+                                                              BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES,BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                                              BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS,BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,true);
+    };
+    testSnapshotRestore<BackgroundSubtractorSuBSENSE>(lCreator_planar,lCreator_planar);
+    testSnapshotRestore<BackgroundSubtractorSuBSENSE>(lCreator_pxmajor,lCreator_planar);
+}
+
+TEST(bgs_snapshot,regression_pawcs) {
+    const auto lCreator = [](){return std::make_unique<BackgroundSubtractorPAWCS>();};
+    testSnapshotRestore<BackgroundSubtractorPAWCS>(lCreator,lCreator);
+}
+
+TEST(bgs_snapshot,regression_mismatch) {
+    const cv::Size oSize(64,48);
+    BackgroundSubtractorLOBSTER oAlgo_lobster;
+    oAlgo_lobster.initialize(genFrame(oSize,3,0));
+    std::stringstream ssSnapshot;
+    oAlgo_lobster.save(ssSnapshot);
+    BackgroundSubtractorSuBSENSE oAlgo_subsense;
+    ASSERT_ANY_THROW(oAlgo_subsense.load(ssSnapshot)); // algo type mismatch
+    ssSnapshot.clear();
+    ssSnapshot.seekg(0);
+    BackgroundSubtractorLOBSTER oAlgo_lobster_other(BGSLOBSTER_DEFAULT_DESC_DIST_THRESHOLD+1);
+    ASSERT_ANY_THROW(oAlgo_lobster_other.load(ssSnapshot)); // algo parameters mismatch
+    std::stringstream ssTruncatedSnapshot(ssSnapshot.str().substr(0,ssSnapshot.str().size()/2));
+    BackgroundSubtractorLOBSTER oAlgo_lobster_new;
+    ASSERT_ANY_THROW(oAlgo_lobster_new.load(ssTruncatedSnapshot));
+}
+
+TEST(bgs_snapshot,regression_pawcs_corrupt_dicts) {
+    const cv::Size oSize(64,48);
+    for(int nDictType=0; nDictType<3; ++nDictType) {
+        BackgroundSubtractorPAWCS_Corruptor oAlgo_corrupt;
+        oAlgo_corrupt.initialize(genFrame(oSize,3,0));
+        cv::Mat oFGMask;
+        oAlgo_corrupt.apply(genFrame(oSize,3,1),oFGMask);
+        std::stringstream ssSnapshot;
+        oAlgo_corrupt.save(ssSnapshot);
+        BackgroundSubtractorPAWCS oAlgo_valid;
+        ASSERT_NO_THROW(oAlgo_valid.load(ssSnapshot)) << "nDictType=" << nDictType;
+        oAlgo_corrupt.corruptDict(nDictType);
+        ssSnapshot.str("");
+        ssSnapshot.clear();
+        oAlgo_corrupt.save(ssSnapshot);
+        BackgroundSubtractorPAWCS oAlgo_new;
+        ASSERT_ANY_THROW(oAlgo_new.load(ssSnapshot)) << "nDictType=" << nDictType;
+    }
+}
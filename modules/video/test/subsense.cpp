@@ -0,0 +1,94 @@
+
+#include "litiv/video/BackgroundSubtractorSuBSENSE.hpp"
+#include "litiv/test.hpp"
+#include "common.hpp"
+
+TEST(subsense,regression_parallel_bands) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        BackgroundSubtractorSuBSENSE oAlgo_serial, oAlgo_parallel;
+        oAlgo_serial.setWorkerCount(1);
+        oAlgo_parallel.setWorkerCount(4);
+        const cv::Mat oInitFrame = genFrame(oSize,nChannels,0);
+        oAlgo_serial.initialize(oInitFrame);
+        oAlgo_parallel.initialize(oInitFrame);
+        cv::Mat oFGMask_serial, oFGMask_parallel;
+        for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx) {
+            const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+            oAlgo_serial.apply(oFrame,oFGMask_serial);
+            oAlgo_parallel.apply(oFrame,oFGMask_parallel);
+            ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_serial,oFGMask_parallel)) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+        cv::Mat oBGImg_serial, oBGImg_parallel;
+        oAlgo_serial.getBackgroundImage(oBGImg_serial);
+        oAlgo_parallel.getBackgroundImage(oBGImg_parallel);
+        ASSERT_TRUE(lv::isEqual<uchar>(oBGImg_serial,oBGImg_parallel));
+    }
+}
+
+TEST(subsense,regression_px_major_model) {
+    for(int nChannels : {1,3}) {
+        const cv::Size oSize(160,120);
+        BackgroundSubtractorSuBSENSE oAlgo_planar, oAlgo_pxmajor(BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET,BGSSUBSENSE_DEFAULT_MIN_COLOR_DIST_THRESHOLD,
+                                                                 BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES,BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                                                 BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS,BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,true);
+        const cv::Mat oInitFrame = genFrame(oSize,nChannels,0);
+        oAlgo_planar.initialize(oInitFrame);
+        oAlgo_pxmajor.initialize(oInitFrame);
+        cv::Mat oFGMask_planar, oFGMask_pxmajor;
+        for(int nFrameIdx=1; nFrameIdx<=40; ++nFrameIdx) {
+            const cv::Mat oFrame = genFrame(oSize,nChannels,nFrameIdx);
+            oAlgo_planar.apply(oFrame,oFGMask_planar);
+            oAlgo_pxmajor.apply(oFrame,oFGMask_pxmajor);
+            ASSERT_TRUE(lv::isEqual<uchar>(oFGMask_planar,oFGMask_pxmajor)) << "nChannels=" << nChannels << ", nFrameIdx=" << nFrameIdx;
+        }
+        cv::Mat oBGImg_planar, oBGImg_pxmajor;
+        oAlgo_planar.getBackgroundImage(oBGImg_planar);
+        oAlgo_pxmajor.getBackgroundImage(oBGImg_pxmajor);
+        ASSERT_TRUE(lv::isEqual<uchar>(oBGImg_planar,oBGImg_pxmajor));
+        cv::Mat oBGDesc_planar, oBGDesc_pxmajor;
+        oAlgo_planar.getBackgroundDescriptorsImage(oBGDesc_planar);
+        oAlgo_pxmajor.getBackgroundDescriptorsImage(oBGDesc_pxmajor);
+        ASSERT_TRUE(lv::isEqual<ushort>(oBGDesc_planar,oBGDesc_pxmajor));
+    }
+}
+
+namespace {
+
+    void subsense_1080p_perftest(benchmark::State& st) {
+        const cv::Size oSize(1920,1080);
+        BackgroundSubtractorSuBSENSE oAlgo;
+        oAlgo.setWorkerCount((size_t)st.range(0));
+        oAlgo.initialize(genFrame(oSize,3,0));
+        std::vector<cv::Mat> voFrames;
+        for(int nFrameIdx=1; nFrameIdx<=8; ++nFrameIdx)
+            voFrames.push_back(genFrame(oSize,3,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            oAlgo.apply(voFrames[(nFrameIdx++)%voFrames.size()],oFGMask);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+    }
+
+    void subsense_1080p_model_layout_perftest(benchmark::State& st) {
+        const cv::Size oSize(1920,1080);
+        BackgroundSubtractorSuBSENSE oAlgo(BGSSUBSENSE_DEFAULT_DESC_DIST_THRESHOLD_OFFSET,BGSSUBSENSE_DEFAULT_MIN_COLOR_DIST_THRESHOLD,
+                                           BGSSUBSENSE_DEFAULT_NB_BG_SAMPLES,BGSSUBSENSE_DEFAULT_REQUIRED_NB_BG_SAMPLES,
+                                           BGSSUBSENSE_DEFAULT_N_SAMPLES_FOR_MV_AVGS,BGSLBSP_DEFAULT_LBSP_REL_SIMILARITY_THRESHOLD,st.range(0)!=0);
+        oAlgo.initialize(genFrame(oSize,3,0));
+        std::vector<cv::Mat> voFrames;
+        for(int nFrameIdx=1; nFrameIdx<=8; ++nFrameIdx)
+            voFrames.push_back(genFrame(oSize,3,nFrameIdx));
+        cv::Mat oFGMask;
+        size_t nFrameIdx = 0;
+        while(st.KeepRunning()) {
+            oAlgo.apply(voFrames[(nFrameIdx++)%voFrames.size()],oFGMask);
+            benchmark::DoNotOptimize(oFGMask.data);
+        }
+    }
+
+}
+
+BENCHMARK(subsense_1080p_perftest)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);
+BENCHMARK(subsense_1080p_model_layout_perftest)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->Repetitions(5)->ReportAggregatesOnly(true);